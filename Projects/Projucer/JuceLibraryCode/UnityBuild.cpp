@@ -11,17 +11,41 @@
 #include "../../Source/Core/Audio/BuiltIn/BuiltInSynthAudioPlugin.cpp"
 #include "../../Source/Core/Audio/BuiltIn/BuiltInSynthFormat.cpp"
 #include "../../Source/Core/Audio/BuiltIn/BuiltInSynthPiano.cpp"
+#include "../../Source/Core/Audio/BuiltIn/BuiltInSynthSampler.cpp"
 #include "../../Source/Core/Audio/BuiltIn/InternalPluginFormat.cpp"
+#include "../../Source/Core/Audio/Instruments/FrozenAudio.cpp"
+#include "../../Source/Core/Audio/Instruments/HardwareMidiOutput.cpp"
 #include "../../Source/Core/Audio/Instruments/Instrument.cpp"
 #include "../../Source/Core/Audio/Instruments/OrchestraPit.cpp"
+#include "../../Source/Core/Audio/Instruments/PluginPrograms.cpp"
+#include "../../Source/Core/Audio/Instruments/PluginSandbox.cpp"
 #include "../../Source/Core/Audio/Instruments/PluginScanner.cpp"
+#include "../../Source/Core/Audio/Instruments/SandboxedPlugin.cpp"
+#include "../../Source/Core/Audio/Instruments/SandboxedPluginFormat.cpp"
 #include "../../Source/Core/Audio/Instruments/SerializablePluginDescription.cpp"
 #include "../../Source/Core/Audio/Monitoring/AudioMonitor.cpp"
+#include "../../Source/Core/Audio/Monitoring/BufferSizeAdvisor.cpp"
+#include "../../Source/Core/Audio/Monitoring/LoudnessMeter.cpp"
+#include "../../Source/Core/Audio/Monitoring/MobileAudioProfile.cpp"
+#include "../../Source/Core/Audio/Monitoring/SchedulingTelemetry.cpp"
 #include "../../Source/Core/Audio/Monitoring/SpectrumAnalyzer.cpp"
+#include "../../Source/Core/Audio/Transport/AsyncAudioWriter.cpp"
+#include "../../Source/Core/Audio/Transport/AudioPeaks.cpp"
+#include "../../Source/Core/Audio/Transport/AudioRecorder.cpp"
+#include "../../Source/Core/Audio/Transport/AuditionPlayer.cpp"
+#include "../../Source/Core/Audio/Transport/Metronome.cpp"
+#include "../../Source/Core/Audio/Transport/MidiRecorder.cpp"
+#include "../../Source/Core/Audio/Transport/MidiSyncOutput.cpp"
+#include "../../Source/Core/Audio/Transport/PlaybackSchedule.cpp"
 #include "../../Source/Core/Audio/Transport/PlayerThread.cpp"
 #include "../../Source/Core/Audio/Transport/RendererThread.cpp"
+#include "../../Source/Core/Audio/Transport/TempoMap.cpp"
 #include "../../Source/Core/Audio/Transport/Transport.cpp"
 #include "../../Source/Core/Audio/AudioCore.cpp"
+#include "../../Source/Core/Audio/AudioEngine.cpp"
+#include "../../Source/Core/Audio/AudioWorkerPool.cpp"
+#include "../../Source/Core/Audio/MixdownKernel.cpp"
+#include "../../Source/Core/Audio/RealtimeSafety.cpp"
 #include "../../Source/Core/Configuration/Models/Arpeggiator.cpp"
 #include "../../Source/Core/Configuration/Models/Chord.cpp"
 #include "../../Source/Core/Configuration/Models/ColourScheme.cpp"
@@ -50,11 +74,13 @@
 #include "../../Source/Core/Midi/Sequences/Events/AutomationEvent.cpp"
 #include "../../Source/Core/Midi/Sequences/Events/KeySignatureEvent.cpp"
 #include "../../Source/Core/Midi/Sequences/Events/MidiEvent.cpp"
+#include "../../Source/Core/Midi/Sequences/Events/MidiEventId.cpp"
 #include "../../Source/Core/Midi/Sequences/Events/Note.cpp"
 #include "../../Source/Core/Midi/Sequences/Events/TimeSignatureEvent.cpp"
 #include "../../Source/Core/Midi/Sequences/AnnotationsSequence.cpp"
 #include "../../Source/Core/Midi/Sequences/AutomationSequence.cpp"
 #include "../../Source/Core/Midi/Sequences/KeySignaturesSequence.cpp"
+#include "../../Source/Core/Midi/Sequences/MidiExportBuffer.cpp"
 #include "../../Source/Core/Midi/Sequences/MidiSequence.cpp"
 #include "../../Source/Core/Midi/Sequences/PianoSequence.cpp"
 #include "../../Source/Core/Midi/Sequences/TimeSignaturesSequence.cpp"
@@ -68,10 +94,16 @@
 #include "../../Source/Core/Network/Services/ProjectSyncService.cpp"
 #include "../../Source/Core/Network/Services/ResourceSyncService.cpp"
 #include "../../Source/Core/Network/Services/SessionService.cpp"
+#include "../../Source/Core/Network/Services/SyncQueue.cpp"
 #include "../../Source/Core/Network/Network.cpp"
+#include "../../Source/Core/Scripting/KeySignatureClass.cpp"
+#include "../../Source/Core/Scripting/ScaleClass.cpp"
+#include "../../Source/Core/Scripting/SelectionTransformExecutor.cpp"
+#include "../../Source/Core/Scripting/TimeSignatureClass.cpp"
 #include "../../Source/Core/Serialization/Autosaver.cpp"
 #include "../../Source/Core/Serialization/Document.cpp"
 #include "../../Source/Core/Serialization/DocumentHelpers.cpp"
+#include "../../Source/Core/Serialization/PackedColumn.cpp"
 #include "../../Source/Core/Serialization/SerializedData.cpp"
 #include "../../Source/Core/Serialization/BinarySerializer.cpp"
 #include "../../Source/Core/Serialization/JsonSerializer.cpp"
@@ -101,6 +133,7 @@
 #include "../../Source/Core/Undo/Actions/PatternActions.cpp"
 #include "../../Source/Core/Undo/Actions/PianoTrackActions.cpp"
 #include "../../Source/Core/Undo/Actions/TimeSignatureEventActions.cpp"
+#include "../../Source/Core/Undo/UndoJournal.cpp"
 #include "../../Source/Core/Undo/UndoStack.cpp"
 #include "../../Source/Core/VCS/DiffLogic/AutomationTrackDiffLogic.cpp"
 #include "../../Source/Core/VCS/DiffLogic/DiffLogic.cpp"
@@ -119,16 +152,26 @@
 #include "../../Source/Core/VCS/VersionControl.cpp"
 #include "../../Source/Core/Workspace/NavigationHistory.cpp"
 #include "../../Source/Core/Workspace/RecentProjectInfo.cpp"
+#include "../../Source/Core/Workspace/RecentProjectsWarmup.cpp"
 #include "../../Source/Core/Workspace/SyncedConfigurationInfo.cpp"
 #include "../../Source/Core/Workspace/UserSessionInfo.cpp"
 #include "../../Source/Core/Workspace/UserProfile.cpp"
 #include "../../Source/Core/Workspace/Workspace.cpp"
 #include "../../Source/Core/App.cpp"
+#include "../../Source/Core/Benchmarks.cpp"
+#include "../../Source/Core/HeadlessConverter.cpp"
+#include "../../Source/Core/HeadlessRenderer.cpp"
+#include "../../Source/Core/MemoryBudget.cpp"
+#include "../../Source/Core/MessageThreadWatchdog.cpp"
+#include "../../Source/Core/StartupProfiler.cpp"
+#include "../../Source/Core/TaskPool.cpp"
+#include "../../Source/Core/UiProfiler.cpp"
 #include "../../Source/UI/Common/AudioMonitors/SpectrogramAudioMonitorComponent.cpp"
 #include "../../Source/UI/Common/AudioMonitors/WaveformAudioMonitorComponent.cpp"
 #include "../../Source/UI/Common/Origami/Origami.cpp"
 #include "../../Source/UI/Common/Origami/OrigamiHorizontal.cpp"
 #include "../../Source/UI/Common/Origami/OrigamiVertical.cpp"
+#include "../../Source/UI/Common/AnimationClock.cpp"
 #include "../../Source/UI/Common/ColourButton.cpp"
 #include "../../Source/UI/Common/ColourSwatches.cpp"
 #include "../../Source/UI/Common/CommandIDs.cpp"
@@ -145,6 +188,8 @@
 #include "../../Source/UI/Common/RadioButton.cpp"
 #include "../../Source/UI/Common/ScaleEditor.cpp"
 #include "../../Source/UI/Common/SpectralLogo.cpp"
+#include "../../Source/UI/Common/TextSprites.cpp"
+#include "../../Source/UI/Common/UiProfilerOverlay.cpp"
 #include "../../Source/UI/Common/ViewportFitProxyComponent.cpp"
 #include "../../Source/UI/Dialogs/AnnotationDialog.cpp"
 #include "../../Source/UI/Dialogs/FadingDialog.cpp"
@@ -202,6 +247,7 @@
 #include "../../Source/UI/Pages/Settings/AudioSettings.cpp"
 #include "../../Source/UI/Pages/Settings/ComponentsList.cpp"
 #include "../../Source/UI/Pages/Settings/LabeledSettingsWrapper.cpp"
+#include "../../Source/UI/Pages/Settings/MemorySettings.cpp"
 #include "../../Source/UI/Pages/Settings/SimpleSettingsWrapper.cpp"
 #include "../../Source/UI/Pages/Settings/SettingsListItemHighlighter.cpp"
 #include "../../Source/UI/Pages/Settings/SettingsListItemSelection.cpp"
@@ -215,7 +261,6 @@
 #include "../../Source/UI/Pages/Settings/UserInterfaceSettings.cpp"
 #include "../../Source/UI/Pages/VCS/HistoryComponent.cpp"
 #include "../../Source/UI/Pages/VCS/RevisionComponent.cpp"
-#include "../../Source/UI/Pages/VCS/RevisionConnectorComponent.cpp"
 #include "../../Source/UI/Pages/VCS/RevisionItemComponent.cpp"
 #include "../../Source/UI/Pages/VCS/RevisionTooltipComponent.cpp"
 #include "../../Source/UI/Pages/VCS/RevisionTreeComponent.cpp"
@@ -245,13 +290,13 @@
 #include "../../Source/UI/Sequencer/Helpers/CutPointMark.cpp"
 #include "../../Source/UI/Sequencer/Helpers/HybridRollExpandMark.cpp"
 #include "../../Source/UI/Sequencer/Helpers/KnifeToolHelper.cpp"
+#include "../../Source/UI/Sequencer/Helpers/NotesOverviewCache.cpp"
 #include "../../Source/UI/Sequencer/Helpers/TimelineWarningMarker.cpp"
 #include "../../Source/UI/Sequencer/Helpers/PatternOperations.cpp"
 #include "../../Source/UI/Sequencer/Helpers/SequencerOperations.cpp"
 #include "../../Source/UI/Sequencer/PatternRoll/ClipComponents/AutomationCurveClip/AutomationCurveClipComponent.cpp"
 #include "../../Source/UI/Sequencer/PatternRoll/ClipComponents/AutomationCurveClip/AutomationCurveHelper.cpp"
 #include "../../Source/UI/Sequencer/PatternRoll/ClipComponents/AutomationCurveClip/AutomationCurveEventComponent.cpp"
-#include "../../Source/UI/Sequencer/PatternRoll/ClipComponents/AutomationCurveClip/AutomationCurveEventsConnector.cpp"
 #include "../../Source/UI/Sequencer/PatternRoll/ClipComponents/AutomationStepsClip/AutomationStepsClipComponent.cpp"
 #include "../../Source/UI/Sequencer/PatternRoll/ClipComponents/AutomationStepsClip/AutomationStepEventComponent.cpp"
 #include "../../Source/UI/Sequencer/PatternRoll/ClipComponents/AutomationStepsClip/AutomationStepEventsConnector.cpp"
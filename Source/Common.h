@@ -68,16 +68,29 @@ struct StringHash
     }
 };
 
+// Identifiers are pooled, so equal names always share the same pointer,
+// which can be hashed instead of the string; note that the hashes will differ
+// between runs, so the iteration order of such maps should never be relied on
 struct IdentifierHash
 {
     inline HashCode operator()(const juce::Identifier &key) const noexcept
     {
-        return static_cast<HashCode>(key.toString().hashCode());
+        const auto address = reinterpret_cast<pointer_sized_uint>(key.getCharPointer().getAddress());
+        // the pooled strings are aligned, so the lowest bits are mixed in from above
+        return static_cast<HashCode>(address ^ (address >> 4) ^ (address >> 12));
     }
 
     static int generateHash(const Identifier& key, int upperLimit) noexcept
     {
-        return uint32(key.toString().hashCode()) % (uint32)upperLimit;
+        return int(IdentifierHash()(key) % HashCode(upperLimit));
+    }
+};
+
+struct UuidHash
+{
+    inline HashCode operator()(const juce::Uuid &key) const noexcept
+    {
+        return static_cast<HashCode>(key.hash());
     }
 };
 
@@ -161,6 +174,9 @@ namespace juce
     {
         // declare an additional category for all our tests 
         static const String helio { "Helio" };
+
+        // run instead of the tests with --benchmarks, see Benchmark
+        static const String benchmarks { "Helio Benchmarks" };
     }
 }
 #endif
@@ -35,6 +35,17 @@
 #include "Workspace.h"
 #include "RootNode.h"
 #include "SerializablePluginDescription.h"
+#include "StartupProfiler.h"
+#include "HeadlessRenderer.h"
+#include "HeadlessConverter.h"
+#include "PluginSandbox.h"
+#include "SandboxSharedBlock.h"
+#include "Benchmarks.h"
+#include "MessageThreadWatchdog.h"
+#include "UiProfiler.h"
+#include "TaskPool.h"
+#include "MemoryBudget.h"
+#include "AnimationClock.h"
 
 //===----------------------------------------------------------------------===//
 // Window
@@ -255,6 +266,21 @@ class Network &App::Network() noexcept
     return *static_cast<App *>(getInstance())->network;
 }
 
+class TaskPool &App::Tasks() noexcept
+{
+    return *static_cast<App *>(getInstance())->tasks;
+}
+
+class MemoryBudget &App::Memory() noexcept
+{
+    return *static_cast<App *>(getInstance())->memory;
+}
+
+class AnimationClock &App::Animations() noexcept
+{
+    return *static_cast<App *>(getInstance())->animations;
+}
+
 class Clipboard &App::Clipboard() noexcept
 {
     return static_cast<App *>(getInstance())->clipboard;
@@ -323,7 +349,7 @@ String App::getDeviceId()
 String App::translate(const Identifier &singular)
 {
     return static_cast<App *>(getInstance())->config->
-        getTranslations()->translate(singular.toString());
+        getTranslations()->translate(singular);
 }
 
 String App::translate(const String &singular)
@@ -335,7 +361,7 @@ String App::translate(const String &singular)
 String App::translate(const char* singular)
 {
     return static_cast<App *>(getInstance())->config->
-        getTranslations()->translate(singular);
+        getTranslations()->translate(String(singular));
 }
 
 String App::translate(const String &plural, int64 number)
@@ -469,6 +495,11 @@ bool App::isUsingNativeTitleBar() noexcept
 #endif
 }
 
+bool App::isHeadless() noexcept
+{
+    return static_cast<App *>(getInstance())->window == nullptr;
+}
+
 void App::setTitleBarComponent(WeakReference<Component> component)
 {
     jassert(! isUsingNativeTitleBar());
@@ -482,12 +513,36 @@ void App::setTitleBarComponent(WeakReference<Component> component)
 
 void App::initialise(const String &commandLine)
 {
+    StartupProfiler::initWithCommandLine(commandLine);
+    UiProfiler::initWithCommandLine(commandLine);
+    STARTUP_PROFILER_SCOPE("App::initialise");
+
     this->runMode = App::NORMAL;
-    if (commandLine.isNotEmpty() &&
+    if (PluginSandbox::isSandboxCommandLine(commandLine))
+    {
+        this->runMode = App::PLUGIN_SANDBOX;
+    }
+    else if (commandLine.isNotEmpty() &&
         DocumentHelpers::getTempSlot(commandLine).existsAsFile())
     {
         this->runMode = App::PLUGIN_CHECK;
     }
+    else if (HeadlessRenderer::isRenderCommandLine(commandLine))
+    {
+        this->runMode = App::RENDER;
+    }
+    else if (HeadlessConverter::isConvertCommandLine(commandLine))
+    {
+        this->runMode = App::CONVERT;
+    }
+
+    // the plugin checker and the sandbox have nothing to do with it
+    if (this->runMode != App::PLUGIN_CHECK && this->runMode != App::PLUGIN_SANDBOX)
+    {
+        this->tasks = makeUnique<TaskPool>();
+        this->memory = makeUnique<MemoryBudget>();
+        this->animations = makeUnique<AnimationClock>();
+    }
 
     if (this->runMode == App::NORMAL)
     {
@@ -496,12 +551,25 @@ void App::initialise(const String &commandLine)
         const auto album = Desktop::rotatedClockwise + Desktop::rotatedAntiClockwise;
         Desktop::getInstance().setOrientationsEnabled(album);
         
-        this->config = makeUnique<class Config>();
-        this->config->initResources();
+        {
+            STARTUP_PROFILER_SCOPE("Config::initResources");
+            this->config = makeUnique<class Config>();
+            this->config->initResources();
+        }
+
+        const String budget(this->config->getProperty(Serialization::Config::memoryBudget));
+        if (budget.isNotEmpty())
+        {
+            this->memory->setBudget(budget.getLargeIntValue());
+        }
 
         auto helioTheme = makeUnique<HelioTheme>();
-        helioTheme->initResources();
-        helioTheme->initColours(this->config->getColourSchemes()->getCurrent());
+
+        {
+            STARTUP_PROFILER_SCOPE("HelioTheme::initResources");
+            helioTheme->initResources();
+            helioTheme->initColours(this->config->getColourSchemes()->getCurrent());
+        }
 
         this->theme.reset(helioTheme.release());
         LookAndFeel::setDefaultLookAndFeel(this->theme.get());
@@ -514,10 +582,31 @@ void App::initialise(const String &commandLine)
         // (we don't need a window, workspace and network services though)
         UnitTestRunner runner;
 
+        // the benchmarks need projects with transports, so they need
+        // a workspace with the instruments, but still not a window
+        const bool isBenchmarking = Benchmark::isBenchmarkCommandLine(commandLine);
+        if (isBenchmarking)
+        {
+            this->workspace = makeUnique<class Workspace>();
+            this->workspace->initHeadless();
+
+            while (this->workspace->getAudioCore().isLoadingInstruments())
+            {
+                MessageManager::getInstance()->runDispatchLoopUntil(50);
+            }
+        }
+
         // we don't want to run JUCE's unit tests, just the ones in our category:
-        runner.runTestsInCategory(UnitTestCategories::helio,
+        runner.runTestsInCategory(isBenchmarking ?
+            UnitTestCategories::benchmarks : UnitTestCategories::helio,
             Random::getSystemRandom().nextInt64());
 
+        if (isBenchmarking)
+        {
+            const auto resultsFile = Benchmark::saveResults(commandLine);
+            DBG("Saved the benchmark results into " + resultsFile.getFullPathName());
+        }
+
         for (int i = 0; i < runner.getNumResults(); ++i)
         {
             if (runner.getResult(i)->failures > 0)
@@ -558,10 +647,14 @@ void App::initialise(const String &commandLine)
             this->config->getUiFlags()->setNativeTitleBarEnabled(shouldUseNativeTitleBar);
         }
 
-        this->window = makeUnique<MainWindow>();
-        this->window->init(shouldEnableOpenGL, shouldUseNativeTitleBar);
+        {
+            STARTUP_PROFILER_SCOPE("MainWindow::init");
+            this->window = makeUnique<MainWindow>();
+            this->window->init(shouldEnableOpenGL, shouldUseNativeTitleBar);
+        }
 
         this->network = makeUnique<class Network>(*this->workspace.get());
+        this->watchdog = makeUnique<MessageThreadWatchdog>();
 
         this->config->getUiFlags()->addListener(this);
         
@@ -570,6 +663,7 @@ void App::initialise(const String &commandLine)
         // desktop versions will be initialised by InitScreen component.
         App::Workspace().init();
         App::Layout().show();
+        StartupProfiler::runOpenProjectAndQuit();
 
 #   endif
 
@@ -580,6 +674,61 @@ void App::initialise(const String &commandLine)
         this->checkPlugin(commandLine);
         this->quit();
     }
+    else if (this->runMode == App::PLUGIN_SANDBOX)
+    {
+#if JUCE_MAC
+        Process::setDockIconVisible(false);
+#endif
+
+        // the sandbox quits by itself when the host is gone
+        this->sandbox = makeUnique<PluginSandbox>();
+        if (!this->sandbox->initialiseFromCommandLine(commandLine, HELIO_SANDBOX_PROCESS_ID))
+        {
+            this->sandbox = nullptr;
+            this->setApplicationReturnValue(1);
+            this->quit();
+        }
+    }
+    else if (this->runMode == App::RENDER)
+    {
+        this->config = makeUnique<class Config>();
+        this->config->initResources();
+
+        // some instruments' editors may want the default look and feel,
+        // even though nothing is ever shown
+        auto helioTheme = makeUnique<HelioTheme>();
+        helioTheme->initResources();
+        helioTheme->initColours(this->config->getColourSchemes()->getCurrent());
+        this->theme.reset(helioTheme.release());
+        LookAndFeel::setDefaultLookAndFeel(this->theme.get());
+
+        this->workspace = makeUnique<class Workspace>();
+        this->workspace->initHeadless();
+
+        this->headlessRenderer = makeUnique<HeadlessRenderer>(commandLine);
+        if (!this->headlessRenderer->start())
+        {
+            this->setApplicationReturnValue(1);
+            this->quit();
+        }
+    }
+    else if (this->runMode == App::CONVERT)
+    {
+        // no theme, no instruments and no audio device
+        // are needed just to read and write the files
+        this->config = makeUnique<class Config>();
+        this->config->initResources();
+
+        this->workspace = makeUnique<class Workspace>();
+        this->workspace->initWithoutInstruments();
+
+        this->headlessConverter = makeUnique<HeadlessConverter>(commandLine);
+        if (!this->headlessConverter->start())
+        {
+            this->setApplicationReturnValue(1);
+            this->quit();
+        }
+    }
 }
 
 void App::shutdown()
@@ -590,7 +739,9 @@ void App::shutdown()
 
         DBG("Shutting down");
 
+        this->watchdog = nullptr;
         this->window = nullptr;
+        UiProfiler::shutdown();
         this->network = nullptr;
         
         if (this->workspace != nullptr)
@@ -614,6 +765,46 @@ void App::shutdown()
                 
         Logger::setCurrentLogger(nullptr);
     }
+    else if (this->runMode == App::RENDER)
+    {
+        this->headlessRenderer = nullptr;
+
+        if (this->workspace != nullptr)
+        {
+            this->workspace->shutdown();
+            this->workspace = nullptr;
+        }
+
+        this->theme = nullptr;
+        this->config = nullptr;
+
+        // not deleting the temporary folder here,
+        // since other instances may still be using it
+
+        Icons::clearPrerenderedCache();
+        Icons::clearBuiltInImages();
+    }
+    else if (this->runMode == App::CONVERT)
+    {
+        this->headlessConverter = nullptr;
+
+        if (this->workspace != nullptr)
+        {
+            this->workspace->shutdown();
+            this->workspace = nullptr;
+        }
+
+        this->config = nullptr;
+    }
+    else if (this->runMode == App::PLUGIN_SANDBOX)
+    {
+        this->sandbox = nullptr;
+    }
+
+    // the projects may still use these while being unloaded, so they go last
+    this->animations = nullptr;
+    this->memory = nullptr;
+    this->tasks = nullptr;
 }
 
 const String App::getApplicationName()
@@ -622,6 +813,18 @@ const String App::getApplicationName()
     {
         return "Helio Plugin Check";
     }
+    else if (this->runMode == App::PLUGIN_SANDBOX)
+    {
+        return "Helio Plugin Sandbox";
+    }
+    else if (this->runMode == App::RENDER)
+    {
+        return "Helio Render";
+    }
+    else if (this->runMode == App::CONVERT)
+    {
+        return "Helio Convert";
+    }
 
     return "Helio";
 }
@@ -661,6 +864,11 @@ void App::suspended()
         this->workspace->getAudioCore().setCanSleepAfter(0);
         this->workspace->autosave();
     }
+
+    if (this->animations != nullptr)
+    {
+        this->animations->setSuspended(true);
+    }
     
 #if JUCE_ANDROID
     this->window->detachOpenGLContextIfAny();
@@ -674,6 +882,11 @@ void App::resumed()
         this->workspace->getAudioCore().setAwake();
     }
 
+    if (this->animations != nullptr)
+    {
+        this->animations->setSuspended(false);
+    }
+
 #if JUCE_ANDROID
     this->window->attachOpenGLContext();
 #endif
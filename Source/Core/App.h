@@ -59,6 +59,9 @@ public:
     static class MainLayout &Layout() noexcept;
     static class Workspace &Workspace() noexcept;
     static class Clipboard &Clipboard() noexcept;
+    static class TaskPool &Tasks() noexcept;
+    static class MemoryBudget &Memory() noexcept;
+    static class AnimationClock &Animations() noexcept;
 
     static bool isRunningOnPhone();
     static bool isRunningOnTablet();
@@ -76,6 +79,7 @@ public:
     static void recreateLayout();
     static bool isOpenGLRendererEnabled() noexcept;
     static bool isUsingNativeTitleBar() noexcept;
+    static bool isHeadless() noexcept; // no main window, see HeadlessRenderer
     static void setTitleBarComponent(WeakReference<Component> titleComponent);
 
     static void showModalComponent(UniquePointer<Component> target);
@@ -103,11 +107,18 @@ private:
 
     class Clipboard clipboard;
 
+    UniquePointer<class TaskPool> tasks;
+    UniquePointer<class MemoryBudget> memory;
+    UniquePointer<class AnimationClock> animations;
     UniquePointer<class LookAndFeel> theme;
     UniquePointer<class Config> config;
     UniquePointer<class Workspace> workspace;
     UniquePointer<class MainWindow> window;
     UniquePointer<class Network> network;
+    UniquePointer<class HeadlessRenderer> headlessRenderer;
+    UniquePointer<class HeadlessConverter> headlessConverter;
+    UniquePointer<class PluginSandbox> sandbox;
+    UniquePointer<class MessageThreadWatchdog> watchdog;
 
 private:
 
@@ -125,7 +136,10 @@ private:
     enum RunMode
     {
         NORMAL,
-        PLUGIN_CHECK
+        PLUGIN_CHECK,
+        PLUGIN_SANDBOX,
+        RENDER,
+        CONVERT
     };
 
     App::RunMode runMode;
@@ -19,36 +19,70 @@
 #include "AudioCore.h"
 #include "InternalPluginFormat.h"
 #include "BuiltInSynthFormat.h"
+#include "SandboxedPluginFormat.h"
 #include "PluginWindow.h"
 #include "OrchestraPit.h"
 #include "Instrument.h"
 #include "SerializationKeys.h"
 #include "AudioMonitor.h"
+#include "MobileAudioProfile.h"
+#include "MainLayout.h"
+
+#define INSTRUMENTS_LOADING_PROGRESS_MIN_NODES 8
 
 void AudioCore::initAudioFormats(AudioPluginFormatManager &formatManager)
 {
     formatManager.addDefaultFormats();
     formatManager.addFormat(new InternalPluginFormat());
     formatManager.addFormat(new BuiltInSynthFormat());
+#if HELIO_DESKTOP
+    formatManager.addFormat(new SandboxedPluginFormat());
+#endif
 }
 
-AudioCore::AudioCore()
+AudioCore::AudioCore() :
+    bufferSizeAdvisor(deviceManager, audioEngine)
 {
+    // the clock should always go first, and it is never disconnected:
+    this->deviceManager.addAudioCallback(&this->audioClock);
+
     this->audioMonitor = makeUnique<AudioMonitor>();
     this->deviceManager.addAudioCallback(this->audioMonitor.get());
+
+    // all instruments are rendered and mixed by the engine:
+    this->deviceManager.addAudioCallback(&this->audioEngine);
+
+    // the clicks are generated on their own, not by any instrument:
+    this->deviceManager.addAudioCallback(&this->metronome);
+    this->deviceManager.addAudioCallback(&this->syncOutput);
+    this->deviceManager.addAudioCallback(&this->audioRecorder);
+
     AudioCore::initAudioFormats(this->formatManager);
+
+#if HELIO_MOBILE
+    this->mobileProfile = makeUnique<MobileAudioProfile>(*this, this->audioEngine);
+#endif
 }
 
 AudioCore::~AudioCore()
 {
+#if HELIO_MOBILE
+    this->mobileProfile = nullptr;
+#endif
+
+    this->deviceManager.removeAudioCallback(&this->audioRecorder);
+    this->deviceManager.removeAudioCallback(&this->syncOutput);
+    this->deviceManager.removeAudioCallback(&this->metronome);
+    this->deviceManager.removeAudioCallback(&this->audioEngine);
     this->deviceManager.removeAudioCallback(this->audioMonitor.get());
     this->audioMonitor = nullptr;
+    this->deviceManager.removeAudioCallback(&this->audioClock);
     this->deviceManager.closeAudioDevice();
 }
 
 bool AudioCore::canSleepNow() noexcept
 {
-    // SleepTimer is used to disconnect all callbacks after some delay (i.e. sleep mode),
+    // SleepTimer is used to switch to the idle mode after some delay (i.e. sleep mode),
     // but first we make sure the device is not making any sound, otherwise we'll wait more:
     return this->deviceManager.getOutputLevelGetter()->getCurrentLevel() == 0.0;
 }
@@ -56,42 +90,44 @@ bool AudioCore::canSleepNow() noexcept
 void AudioCore::sleepNow()
 {
     DBG("Audio core sleeps");
-    this->disconnectAllAudioCallbacks();
+    this->setIdleMode(true);
+
+    // the only moment when the device can be restarted unnoticed
+    this->bufferSizeAdvisor.onIdle();
 }
 
 void AudioCore::awakeNow()
 {
-    this->reconnectAllAudioCallbacks();
+    this->setIdleMode(false);
 }
 
-void AudioCore::disconnectAllAudioCallbacks()
+// Instead of disconnecting the instruments, which means re-preparing all
+// plugins on wake-up and a noticeable latency on the first note played,
+// they stay attached and just skip processing while they are silent:
+void AudioCore::setIdleMode(bool shouldBeIdle)
 {
-    if (!this->isMuted.get())
+    if (this->isIdle.get() == shouldBeIdle)
     {
-        this->isMuted = true;
+        return;
+    }
 
-        // Audio monitor is especially CPU-hungry, as it does FFT all the time:
-        this->deviceManager.removeAudioCallback(this->audioMonitor.get());
+    this->isIdle = shouldBeIdle;
 
-        for (auto *instrument : this->instruments)
-        {
-            this->removeInstrumentFromDevice(instrument);
-        }
+    // the monitor doesn't have to be pre-warmed, it's the only one detached:
+    if (shouldBeIdle)
+    {
+        this->deviceManager.removeAudioCallback(this->audioMonitor.get());
     }
-}
 
-void AudioCore::reconnectAllAudioCallbacks()
-{
-    if (this->isMuted.get())
+    for (auto *instrument : this->instruments)
     {
-        for (auto *instrument : this->instruments)
-        {
-            this->addInstrumentToDevice(instrument);
-        }
+        instrument->getProcessorPlayer().setIdleMode(shouldBeIdle,
+            shouldBeIdle ? instrument->getTailLengthSeconds() : 0.0);
+    }
 
+    if (!shouldBeIdle)
+    {
         this->deviceManager.addAudioCallback(this->audioMonitor.get());
-
-        this->isMuted = false;
     }
 }
 
@@ -110,6 +146,61 @@ AudioMonitor *AudioCore::getMonitor() const noexcept
     return this->audioMonitor.get();
 }
 
+const AudioClock &AudioCore::getClock() const noexcept
+{
+    return this->audioClock;
+}
+
+BufferSizeAdvisor &AudioCore::getBufferSizeAdvisor() noexcept
+{
+    return this->bufferSizeAdvisor;
+}
+
+Metronome &AudioCore::getMetronome() noexcept
+{
+    return this->metronome;
+}
+
+MidiSyncOutput &AudioCore::getSyncOutput() noexcept
+{
+    return this->syncOutput;
+}
+
+AudioRecorder &AudioCore::getAudioRecorder() noexcept
+{
+    return this->audioRecorder;
+}
+
+PluginPrograms &AudioCore::getPluginPrograms() noexcept
+{
+    return this->pluginPrograms;
+}
+
+AudioEngine::ProcessingLoad AudioCore::getProcessingLoad() const noexcept
+{
+    return this->audioEngine.getProcessingLoad();
+}
+
+void AudioCore::setNumProcessingThreads(int numThreads)
+{
+    this->audioEngine.setNumProcessingThreads(numThreads);
+}
+
+int AudioCore::getNumProcessingThreads() const noexcept
+{
+    return this->audioEngine.getNumProcessingThreads();
+}
+
+void AudioCore::setLatencyAlignment(bool shouldAlignOutputs)
+{
+    this->audioEngine.setLatencyAlignment(shouldAlignOutputs);
+}
+
+bool AudioCore::isLatencyAligned() const noexcept
+{
+    return this->audioEngine.isLatencyAligned();
+}
+
 //===----------------------------------------------------------------------===//
 // Instruments
 //===----------------------------------------------------------------------===//
@@ -141,13 +232,19 @@ void AudioCore::removeInstrument(Instrument *instrument)
 
 void AudioCore::addInstrumentToDevice(Instrument *instrument)
 {
-    this->deviceManager.addAudioCallback(&instrument->getProcessorPlayer());
+    instrument->getProcessorPlayer().setIdleMode(this->isIdle.get(),
+        instrument->getTailLengthSeconds());
+    this->audioEngine.addInstrument(instrument);
+    instrument->onRoutingChanged = [this]() { this->audioEngine.updateRouting(); };
     this->deviceManager.addMidiInputCallback({}, &instrument->getProcessorPlayer().getMidiMessageCollector());
+    instrument->addChangeListener(&this->pluginPrograms);
 }
 
 void AudioCore::removeInstrumentFromDevice(Instrument *instrument)
 {
-    this->deviceManager.removeAudioCallback(&instrument->getProcessorPlayer());
+    instrument->onRoutingChanged = nullptr;
+    instrument->removeChangeListener(&this->pluginPrograms);
+    this->audioEngine.removeInstrument(instrument);
     this->deviceManager.removeMidiInputCallback({}, &instrument->getProcessorPlayer().getMidiMessageCollector());
 }
 
@@ -232,6 +329,10 @@ void AudioCore::autodetectDeviceSetup()
             this->deviceManager.setAudioDeviceSetup(deviceSetup, true);
         }
     }
+
+#if HELIO_MOBILE
+    MobileAudioProfile::applyDeviceSetup(this->deviceManager);
+#endif
 }
 
 SerializedData AudioCore::serializeDeviceManager() const
@@ -252,11 +353,21 @@ SerializedData AudioCore::serializeDeviceManager() const
         tree.setProperty(Audio::audioDeviceRate,
             currentAudioDevice->getCurrentSampleRate());
 
-        if (currentAudioDevice->getDefaultBufferSize() !=
-            currentAudioDevice->getCurrentBufferSizeSamples())
+        // the adapted size is temporary, the preferred one is what the user has chosen
+        const bool isAdaptive = this->bufferSizeAdvisor.getMode() == BufferSizeAdvisor::Mode::Automatic &&
+            this->bufferSizeAdvisor.getPreferredBufferSize() > 0;
+
+        const int bufferSize = isAdaptive ? this->bufferSizeAdvisor.getPreferredBufferSize() :
+            currentAudioDevice->getCurrentBufferSizeSamples();
+
+        if (currentAudioDevice->getDefaultBufferSize() != bufferSize)
         {
-            tree.setProperty(Audio::audioDeviceBufferSize,
-                currentAudioDevice->getCurrentBufferSizeSamples());
+            tree.setProperty(Audio::audioDeviceBufferSize, bufferSize);
+        }
+
+        if (this->bufferSizeAdvisor.getMode() != BufferSizeAdvisor::Mode::Off)
+        {
+            tree.setProperty(Audio::audioBufferSizeMode, int(this->bufferSizeAdvisor.getMode()));
         }
 
         if (!currentSetup.useDefaultInputChannels)
@@ -272,6 +383,24 @@ SerializedData AudioCore::serializeDeviceManager() const
         }
     }
 
+    const int numProcessingThreads = this->audioEngine.getNumProcessingThreads();
+    if (numProcessingThreads > 1)
+    {
+        tree.setProperty(Audio::audioProcessingThreads, numProcessingThreads);
+    }
+
+    if (this->audioEngine.isLatencyAligned())
+    {
+        tree.setProperty(Audio::audioLatencyAlignment, true);
+    }
+
+    if (this->metronome.isEnabled())
+    {
+        tree.setProperty(Audio::metronomeEnabled, true);
+    }
+
+    tree.setProperty(Audio::metronomeCountInBars, this->metronome.getCountInBars());
+
     const StringArray availableMidiDevices(MidiInput::getDevices());
     for (const auto &midiInputName : availableMidiDevices)
     {
@@ -298,6 +427,18 @@ SerializedData AudioCore::serializeDeviceManager() const
         }
     }
 
+    // the sync ports are kept even if their devices are disconnected now
+    for (const auto &port : this->syncOutput.getPorts())
+    {
+        SerializedData syncNode(Audio::midiSyncOutput);
+        syncNode.setProperty(Audio::midiSyncOutputName, port.deviceName);
+        syncNode.setProperty(Audio::midiSyncSendsClock, port.sendsClock);
+        syncNode.setProperty(Audio::midiSyncSendsTimecode, port.sendsTimecode);
+        syncNode.setProperty(Audio::midiSyncTimecodeType, int(port.timecodeType));
+        syncNode.setProperty(Audio::midiSyncLatencyOffset, port.latencyOffsetMs);
+        tree.appendChild(syncNode);
+    }
+
     const String defaultMidiOutput(this->deviceManager.getDefaultMidiOutputName());
     if (defaultMidiOutput.isNotEmpty())
     {
@@ -361,6 +502,19 @@ void AudioCore::deserializeDeviceManager(const SerializedData &tree)
 
     error = this->deviceManager.setAudioDeviceSetup(setup, true);
 
+    this->audioEngine.setNumProcessingThreads(root.getProperty(Audio::audioProcessingThreads, 1));
+    this->audioEngine.setLatencyAlignment(root.getProperty(Audio::audioLatencyAlignment, false));
+    this->metronome.setEnabled(root.getProperty(Audio::metronomeEnabled, false));
+    this->metronome.setCountInBars(root.getProperty(Audio::metronomeCountInBars, 1));
+
+    if (const auto *device = this->deviceManager.getCurrentAudioDevice())
+    {
+        this->bufferSizeAdvisor.setPreferredBufferSize(device->getCurrentBufferSizeSamples());
+    }
+
+    const int bufferSizeMode = root.getProperty(Audio::audioBufferSizeMode, 0);
+    this->bufferSizeAdvisor.setMode(BufferSizeAdvisor::Mode(jlimit(0, 2, bufferSizeMode)));
+
     this->customMidiInputs.clearQuick();
     forEachChildWithType(root, c, Audio::midiInput)
     {
@@ -374,6 +528,24 @@ void AudioCore::deserializeDeviceManager(const SerializedData &tree)
             this->customMidiInputs.contains(midiIn));
     }
 
+    Array<MidiSyncOutput::PortSettings> syncPorts;
+    forEachChildWithType(root, c, Audio::midiSyncOutput)
+    {
+        MidiSyncOutput::PortSettings port;
+        port.deviceName = c.getProperty(Audio::midiSyncOutputName);
+        port.sendsClock = c.getProperty(Audio::midiSyncSendsClock, true);
+        port.sendsTimecode = c.getProperty(Audio::midiSyncSendsTimecode, false);
+        const int timecodeType = c.getProperty(Audio::midiSyncTimecodeType, int(MidiMessage::fps25));
+        port.timecodeType = MidiMessage::SmpteTimecodeType(jlimit(0, 3, timecodeType));
+        port.latencyOffsetMs = c.getProperty(Audio::midiSyncLatencyOffset, 0.0);
+        if (port.deviceName.isNotEmpty())
+        {
+            syncPorts.add(port);
+        }
+    }
+
+    this->syncOutput.setPorts(syncPorts);
+
     if (error.isNotEmpty())
     {
         error = this->deviceManager.initialise(0, 2, nullptr, false);
@@ -410,39 +582,73 @@ void AudioCore::deserialize(const SerializedData &data)
 {
     using namespace Serialization;
 
-    // re-creates deviceManager's graph each time on deserialization
-    this->reset();
-
     const auto root = data.hasType(Audio::audioCore) ?
         data : data.getChildWithName(Audio::audioCore);
 
     if (!root.isValid())
     {
+        this->reset();
         this->autodetectDeviceSetup();
         return;
     }
 
     this->deserializeDeviceManager(root);
 
+    // the instruments which are loaded already are kept and updated in place,
+    // so that their plugins are not re-created, and their states are only
+    // restored if they differ; the rest are removed, and the new ones are added
+    Array<Instrument *> instrumentsToRemove;
+    instrumentsToRemove.addArray(this->instruments);
+
+    // all new instruments load their plugins at the same time, in the background,
+    // while the rest of the workspace and projects are being loaded
+    this->numNodesToLoad = 0;
+    this->numNodesLoaded = 0;
+
     const auto orchestra = root.getChildWithName(Audio::orchestra);
-    if (orchestra.isValid())
+    forEachChildWithType(orchestra, instrumentNode, Audio::instrument)
     {
-        for (const auto &instrumentNode : orchestra)
+        const String instrumentId = instrumentNode.getProperty(Audio::instrumentId);
+
+        Instrument *existingInstrument = nullptr;
+        for (auto *instrument : instrumentsToRemove)
         {
-            UniquePointer<Instrument> instrument(new Instrument(this->formatManager, {}));
-            // it's important to add audio processor to device
-            // before actually creating nodes and connections:
-            this->addInstrumentToDevice(instrument.get());
-            instrument->deserialize(instrumentNode);
-            if (!instrument->isValid())
-            {
-                this->removeInstrumentFromDevice(instrument.get());
-            }
-            else
+            if (instrument->getInstrumentId() == instrumentId)
             {
-                this->instruments.add(instrument.release());
+                existingInstrument = instrument;
+                break;
             }
         }
+
+        if (existingInstrument != nullptr)
+        {
+            instrumentsToRemove.removeFirstMatchingValue(existingInstrument);
+            existingInstrument->onNodeLoaded = [this]() { this->onInstrumentNodeLoaded(); };
+            existingInstrument->deserialize(instrumentNode);
+            this->numNodesToLoad += existingInstrument->numNodesLoading;
+            continue;
+        }
+
+        UniquePointer<Instrument> instrument(new Instrument(this->formatManager, {}));
+        instrument->onNodeLoaded = [this]() { this->onInstrumentNodeLoaded(); };
+        // it's important to add audio processor to device
+        // before actually creating nodes and connections:
+        this->addInstrumentToDevice(instrument.get());
+        instrument->deserialize(instrumentNode);
+        if (!instrument->isValid())
+        {
+            this->removeInstrumentFromDevice(instrument.get());
+        }
+        else
+        {
+            this->numNodesToLoad += instrument->numNodesLoading;
+            this->instruments.add(instrument.release());
+        }
+    }
+
+    for (auto *instrument : instrumentsToRemove)
+    {
+        this->removeInstrument(instrument);
     }
 
     if (this->instruments.isEmpty())
@@ -451,6 +657,25 @@ void AudioCore::deserialize(const SerializedData &data)
     }
 }
 
+bool AudioCore::isLoadingInstruments() const noexcept
+{
+    return this->numNodesLoaded < this->numNodesToLoad;
+}
+
+void AudioCore::onInstrumentNodeLoaded()
+{
+    this->numNodesLoaded++;
+
+    // only bother the user when it takes a while
+    if (this->numNodesToLoad > INSTRUMENTS_LOADING_PROGRESS_MIN_NODES && !App::isHeadless())
+    {
+        App::Layout().showTooltip(TRANS(I18n::Common::loadingInstruments) + " " +
+            String(this->numNodesLoaded) + "/" + String(this->numNodesToLoad),
+            MainLayout::TooltipType::Simple,
+            this->numNodesLoaded < this->numNodesToLoad ? 15000 : 1000);
+    }
+}
+
 void AudioCore::reset()
 {
     while (this->instruments.size() > 0)
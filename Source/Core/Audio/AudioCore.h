@@ -18,9 +18,16 @@
 #pragma once
 
 class AudioMonitor;
+class MobileAudioProfile;
 
 #include "Instrument.h"
 #include "OrchestraPit.h"
+#include "AudioEngine.h"
+#include "BufferSizeAdvisor.h"
+#include "Metronome.h"
+#include "MidiSyncOutput.h"
+#include "AudioRecorder.h"
+#include "PluginPrograms.h"
 
 class SleepTimer : private Timer
 {
@@ -68,6 +75,85 @@ private:
     }
 };
 
+/*
+    A device callback which does nothing but counting samples:
+    it is connected before any other callback, so all instruments
+    will see the same block start position within each device cycle,
+    and the playback schedule can rely on it as on a master clock.
+*/
+
+class AudioClock final : public AudioIODeviceCallback
+{
+public:
+
+    AudioClock() = default;
+
+    int64 getBlockStartSample() const noexcept
+    {
+        return this->blockStartSample.get();
+    }
+
+    double getSampleRate() const noexcept
+    {
+        return this->sampleRate.get();
+    }
+
+    bool isRunning() const noexcept
+    {
+        return this->sampleRate.get() > 0.0;
+    }
+
+    // The block start only moves once per device cycle, which is too coarse
+    // for the UI, so it's extrapolated by the time passed since the callback,
+    // but never beyond that block; any thread
+    double getEstimatedSamplePosition() const noexcept
+    {
+        const auto blockStart = this->blockStartSample.get();
+        const auto msSinceBlockStart = Time::getMillisecondCounterHiRes() - this->blockStartTimeMs.get();
+        const auto samplesSinceBlockStart = jlimit(0.0, double(this->blockSize.get()),
+            msSinceBlockStart * this->sampleRate.get() / 1000.0);
+
+        return double(blockStart) + samplesSinceBlockStart;
+    }
+
+    void audioDeviceIOCallback(const float **inputChannelData, int numInputChannels,
+        float **outputChannelData, int numOutputChannels, int numSamples) override
+    {
+        this->blockStartTimeMs = Time::getMillisecondCounterHiRes();
+        this->blockSize = numSamples;
+        this->blockStartSample = this->nextBlockStartSample;
+        this->nextBlockStartSample += numSamples;
+
+        // the first callback writes directly to the device buffers, others are mixed in:
+        for (int i = 0; i < numOutputChannels; ++i)
+        {
+            FloatVectorOperations::clear(outputChannelData[i], numSamples);
+        }
+    }
+
+    void audioDeviceAboutToStart(AudioIODevice *device) override
+    {
+        this->sampleRate = device->getCurrentSampleRate();
+    }
+
+    void audioDeviceStopped() override
+    {
+        this->sampleRate = 0.0;
+    }
+
+private:
+
+    Atomic<int64> blockStartSample = 0;
+    int64 nextBlockStartSample = 0;
+
+    Atomic<double> blockStartTimeMs = 0.0;
+    Atomic<int> blockSize = 0;
+
+    Atomic<double> sampleRate = 0.0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AudioClock)
+};
+
 class AudioCore :
     public Serializable,
     public ChangeBroadcaster,
@@ -97,6 +183,9 @@ public:
     Instrument *findInstrumentById(const String &id) const override;
     void initDefaultInstrument();
 
+    // the plugins are still being loaded in the background after deserialization
+    bool isLoadingInstruments() const noexcept;
+
     //===------------------------------------------------------------------===//
     // Setup
     //===------------------------------------------------------------------===//
@@ -106,6 +195,23 @@ public:
     AudioDeviceManager &getDevice() noexcept;
     AudioPluginFormatManager &getFormatManager() noexcept;
     AudioMonitor *getMonitor() const noexcept;
+    const AudioClock &getClock() const noexcept;
+    BufferSizeAdvisor &getBufferSizeAdvisor() noexcept;
+    Metronome &getMetronome() noexcept;
+    MidiSyncOutput &getSyncOutput() noexcept;
+    AudioRecorder &getAudioRecorder() noexcept;
+    PluginPrograms &getPluginPrograms() noexcept;
+
+    // the engine's load, see the advisor
+    AudioEngine::ProcessingLoad getProcessingLoad() const noexcept;
+
+    void setNumProcessingThreads(int numThreads);
+    int getNumProcessingThreads() const noexcept;
+
+    // whether to delay the instruments' outputs to align them by latency,
+    // otherwise only the scheduled playback is compensated
+    void setLatencyAlignment(bool shouldAlignOutputs);
+    bool isLatencyAligned() const noexcept;
 
     //===------------------------------------------------------------------===//
     // Serializable
@@ -163,24 +269,41 @@ private:
     bool canSleepNow() noexcept override;
     void sleepNow() override;
     void awakeNow() override;
-    void disconnectAllAudioCallbacks();
-    void reconnectAllAudioCallbacks();
+    void setIdleMode(bool shouldBeIdle);
 
     void addInstrumentToDevice(Instrument *instrument);
     void removeInstrumentFromDevice(Instrument *instrument);
 
+    void onInstrumentNodeLoaded();
+    int numNodesToLoad = 0;
+    int numNodesLoaded = 0;
+
     SerializedData serializeDeviceManager() const;
     void deserializeDeviceManager(const SerializedData &tree);
 
+    // goes first to outlive the instruments it listens to
+    PluginPrograms pluginPrograms;
+
     OwnedArray<Instrument> instruments;
     UniquePointer<AudioMonitor> audioMonitor;
+    AudioClock audioClock;
+    AudioEngine audioEngine;
+    Metronome metronome;
+    MidiSyncOutput syncOutput;
+    AudioRecorder audioRecorder;
 
     AudioPluginFormatManager formatManager;
     AudioDeviceManager deviceManager;
 
+    BufferSizeAdvisor bufferSizeAdvisor;
+
+#if HELIO_MOBILE
+    UniquePointer<MobileAudioProfile> mobileProfile;
+#endif
+
     StringArray customMidiInputs;
 
-    Atomic<bool> isMuted = false;
+    Atomic<bool> isIdle = false;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AudioCore)
     JUCE_DECLARE_WEAK_REFERENCEABLE(AudioCore)
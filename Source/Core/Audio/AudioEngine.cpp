@@ -0,0 +1,430 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Common.h"
+#include "AudioEngine.h"
+#include "RealtimeSafety.h"
+#include "MixdownKernel.h"
+
+// the largest difference between the instruments' latencies to compensate
+#define MAX_OUTPUT_DELAY_MS 1000
+
+// the same smoothing as for the instruments' loads, but the peak
+// decays faster, so that the headroom meter recovers in a few seconds
+#define ENGINE_LOAD_AVERAGE_WEIGHT 0.05f
+#define ENGINE_LOAD_PEAK_DECAY 0.995f
+
+void AudioEngine::addInstrument(Instrument *instrument)
+{
+    auto slot = makeUnique<Slot>();
+    slot->instrument = instrument;
+    slot->callback = &instrument->getProcessorPlayer();
+
+    // like AudioDeviceManager does, prepare the callback before it is added
+    if (this->currentDevice != nullptr)
+    {
+        slot->callback->audioDeviceAboutToStart(this->currentDevice);
+        this->prepareSlot(*slot);
+    }
+
+    const ScopedLock sl(this->lock);
+    this->slots.add(slot.release());
+    this->updateRoutingUnlocked();
+}
+
+void AudioEngine::removeInstrument(Instrument *instrument)
+{
+    auto *callback = &instrument->getProcessorPlayer();
+    UniquePointer<Slot> removedSlot;
+
+    {
+        const ScopedLock sl(this->lock);
+        for (int i = 0; i < this->slots.size(); ++i)
+        {
+            if (this->slots.getUnchecked(i)->callback == callback)
+            {
+                removedSlot.reset(this->slots.removeAndReturn(i));
+                break;
+            }
+        }
+
+        this->updateRoutingUnlocked();
+    }
+
+    if (removedSlot != nullptr && this->currentDevice != nullptr)
+    {
+        callback->audioDeviceStopped();
+    }
+}
+
+void AudioEngine::updateRouting()
+{
+    const ScopedLock sl(this->lock);
+    this->updateRoutingUnlocked();
+}
+
+// called rarely, and only on the message thread, so the audio thread
+// just waits for this to finish, like it does when the slots are added
+void AudioEngine::updateRoutingUnlocked()
+{
+    this->instrumentSlots.clearQuick();
+    this->busSlots.clearQuick();
+
+    for (auto *slot : this->slots)
+    {
+        slot->isBus = slot->instrument->isEffectBus();
+        (slot->isBus ? this->busSlots : this->instrumentSlots).add(slot);
+    }
+
+    for (auto *bus : this->busSlots)
+    {
+        bus->inputs.clearQuick();
+        bus->inputLevels.clearQuick();
+        const auto busId = bus->instrument->getIdAndHash();
+
+        for (const auto *slot : this->instrumentSlots)
+        {
+            const auto level = slot->instrument->getSendLevel(busId);
+            if (level > 0.f)
+            {
+                bus->inputs.add(slot);
+                bus->inputLevels.add(level);
+            }
+        }
+    }
+
+    // the mixdown won't ever have to allocate on the audio thread
+    this->mixedSlots.clearQuick();
+    this->mixedSlots.addArray(this->slots);
+    this->mixSources.ensureStorageAllocated(this->slots.size());
+    this->mixGains.clearQuick();
+    this->mixGains.insertMultiple(0, 1.f, this->slots.size());
+}
+
+void AudioEngine::setNumProcessingThreads(int numThreads)
+{
+    const int numWorkers = jlimit(0, SystemStats::getNumCpus() - 1, numThreads - 1);
+    if (numWorkers == this->getNumProcessingThreads() - 1)
+    {
+        return;
+    }
+
+    UniquePointer<AudioWorkerPool> newPool;
+    if (numWorkers > 0)
+    {
+        newPool = makeUnique<AudioWorkerPool>(numWorkers);
+    }
+
+    {
+        const ScopedLock sl(this->lock);
+        this->workerPool.swap(newPool);
+    }
+
+    // the old workers are stopped here, outside the lock
+}
+
+int AudioEngine::getNumProcessingThreads() const noexcept
+{
+    return this->workerPool != nullptr ? this->workerPool->getNumWorkers() + 1 : 1;
+}
+
+// called rarely, and only on the message thread, like the routing updates
+void AudioEngine::setLatencyAlignment(bool shouldAlignOutputs)
+{
+    const ScopedLock sl(this->lock);
+
+    this->latencyAlignment = shouldAlignOutputs;
+
+    for (auto *slot : this->slots)
+    {
+        this->prepareDelayLine(*slot);
+    }
+}
+
+bool AudioEngine::isLatencyAligned() const noexcept
+{
+    return this->latencyAlignment;
+}
+
+AudioEngine::ProcessingLoad AudioEngine::getProcessingLoad() const noexcept
+{
+    ProcessingLoad load;
+    load.averagePercent = this->averageLoad.get();
+    load.peakPercent = this->peakLoad.get();
+    return load;
+}
+
+float AudioEngine::getAndResetMaxLoad() noexcept
+{
+    return this->maxLoad.exchange(0.f);
+}
+
+// Only the audio thread writes these, see Instrument::AudioCallback
+void AudioEngine::updateProcessingLoad(int64 startTicks, int numSamples) noexcept
+{
+    if (this->sampleRate <= 0.0 || numSamples <= 0)
+    {
+        return;
+    }
+
+    const auto elapsedSeconds = Time::highResolutionTicksToSeconds(Time::getHighResolutionTicks() - startTicks);
+    const auto load = float(elapsedSeconds * this->sampleRate / double(numSamples) * 100.0);
+
+    const auto average = this->averageLoad.get();
+    this->averageLoad = average + (load - average) * ENGINE_LOAD_AVERAGE_WEIGHT;
+    this->peakLoad = jmax(load, this->peakLoad.get() * ENGINE_LOAD_PEAK_DECAY);
+
+    if (load > this->maxLoad.get())
+    {
+        this->maxLoad = load;
+    }
+}
+
+void AudioEngine::prepareSlot(Slot &slot) const
+{
+    slot.buffer.setSize(jmax(1, this->numOutputChannels), jmax(1, this->blockSize));
+    slot.buffer.clear();
+    slot.busInput.setSize(jmax(1, this->numOutputChannels), jmax(1, this->blockSize));
+    slot.busInput.clear();
+    this->prepareDelayLine(slot);
+}
+
+void AudioEngine::prepareDelayLine(Slot &slot) const
+{
+    slot.delayLinePosition = 0;
+    slot.outputDelay = 0;
+
+    if (!this->latencyAlignment || this->currentDevice == nullptr)
+    {
+        slot.delayLine.setSize(0, 0);
+        return;
+    }
+
+    const int maxDelay = int(this->sampleRate * MAX_OUTPUT_DELAY_MS / 1000);
+    slot.delayLine.setSize(jmax(1, this->numOutputChannels), maxDelay + jmax(1, this->blockSize));
+    slot.delayLine.clear();
+}
+
+// The latencies may change at any time, e.g. when a plugin's look-ahead
+// is changed, so they are checked in each block, which is cheap enough;
+// the delays make all instruments as late as the latest one, but the buses
+// are not delayed, as their input is aligned already
+void AudioEngine::updateOutputDelays() noexcept
+{
+    if (!this->latencyAlignment)
+    {
+        for (auto *slot : this->slots)
+        {
+            slot->outputDelay = 0;
+            slot->callback->setOutputDelay(0);
+        }
+
+        return;
+    }
+
+    int maxLatency = 0;
+    for (const auto *slot : this->instrumentSlots)
+    {
+        maxLatency = jmax(maxLatency, slot->instrument->getProcessorGraph()->getLatencySamples());
+    }
+
+    for (auto *slot : this->slots)
+    {
+        const int maxDelay = jmax(0, slot->delayLine.getNumSamples() - this->currentNumSamples);
+        const int latency = slot->instrument->getProcessorGraph()->getLatencySamples();
+        slot->outputDelay = slot->isBus ? 0 : jlimit(0, maxDelay, maxLatency - latency);
+        slot->callback->setOutputDelay(slot->outputDelay);
+    }
+}
+
+// Writes the block into the ring buffer and reads it back, delayed
+void AudioEngine::applyOutputDelay(Slot &slot) noexcept
+{
+    const int capacity = slot.delayLine.getNumSamples();
+    const int numSamples = this->currentNumSamples;
+    if (capacity < numSamples)
+    {
+        return;
+    }
+
+    const int numChannels = jmin(this->currentNumOutputChannels,
+        slot.buffer.getNumChannels(), slot.delayLine.getNumChannels());
+
+    const int writePosition = slot.delayLinePosition;
+    const int readPosition = (writePosition - slot.outputDelay + capacity) % capacity;
+
+    const int numWrittenFirst = jmin(numSamples, capacity - writePosition);
+    const int numReadFirst = jmin(numSamples, capacity - readPosition);
+
+    for (int i = 0; i < numChannels; ++i)
+    {
+        slot.delayLine.copyFrom(i, writePosition, slot.buffer, i, 0, numWrittenFirst);
+        slot.delayLine.copyFrom(i, 0, slot.buffer, i, numWrittenFirst, numSamples - numWrittenFirst);
+
+        slot.buffer.copyFrom(i, 0, slot.delayLine, i, readPosition, numReadFirst);
+        slot.buffer.copyFrom(i, numReadFirst, slot.delayLine, i, 0, numSamples - numReadFirst);
+    }
+
+    slot.delayLinePosition = (writePosition + numSamples) % capacity;
+}
+
+//===----------------------------------------------------------------------===//
+// AudioIODeviceCallback
+//===----------------------------------------------------------------------===//
+
+void AudioEngine::audioDeviceIOCallback(const float **inputChannelData, int numInputChannels,
+    float **outputChannelData, int numOutputChannels, int numSamples)
+{
+    REALTIME_SCOPE("AudioEngine::audioDeviceIOCallback");
+
+    // reverb tails decaying into denormals would make the load spike
+    const ScopedNoDenormals noDenormals;
+    const auto startTicks = Time::getHighResolutionTicks();
+
+    REALTIME_SCOPED_LOCK(this->lock);
+
+    for (auto *slot : this->slots)
+    {
+        auto &buffer = slot->buffer;
+        if (buffer.getNumChannels() < numOutputChannels || buffer.getNumSamples() < numSamples)
+        {
+            // should never happen, unless the device is lying about its buffer size
+            buffer.setSize(numOutputChannels, numSamples, false, false, true);
+            slot->busInput.setSize(numOutputChannels, numSamples, false, false, true);
+        }
+    }
+
+    this->currentInputData = inputChannelData;
+    this->currentNumInputChannels = numInputChannels;
+    this->currentNumOutputChannels = numOutputChannels;
+    this->currentNumSamples = numSamples;
+
+    this->updateOutputDelays();
+    this->processStage(this->instrumentSlots);
+
+    if (!this->busSlots.isEmpty())
+    {
+        // summing the sends up is sequential as well as the mixdown below
+        for (auto *bus : this->busSlots)
+        {
+            for (int i = 0; i < numOutputChannels; ++i)
+            {
+                this->mixDown(bus->busInput.getWritePointer(i), i,
+                    bus->inputs, bus->inputLevels.getRawDataPointer(), numSamples);
+            }
+        }
+
+        this->processStage(this->busSlots);
+    }
+
+    // mixing down is sequential, so that the sum doesn't depend on
+    // which thread has finished first, and the output stays the same
+    for (int i = 0; i < numOutputChannels; ++i)
+    {
+        this->mixDown(outputChannelData[i], i, this->mixedSlots,
+            this->mixGains.getRawDataPointer(), numSamples);
+    }
+
+    this->updateProcessingLoad(startTicks, numSamples);
+}
+
+void AudioEngine::mixDown(float *destination, int channel,
+    const Array<const Slot *> &sources, const float *gains, int numSamples) noexcept
+{
+    this->mixSources.clearQuick();
+    for (const auto *source : sources)
+    {
+        this->mixSources.add(source->buffer.getReadPointer(channel));
+    }
+
+    MixdownKernel::process(destination, this->mixSources.getRawDataPointer(),
+        gains, this->mixSources.size(), numSamples);
+}
+
+void AudioEngine::processStage(const Array<Slot *> &stageSlots)
+{
+    this->currentJobs = &stageSlots;
+
+    if (this->workerPool != nullptr)
+    {
+        this->workerPool->process(*this, stageSlots.size());
+    }
+    else
+    {
+        for (int i = 0; i < stageSlots.size(); ++i)
+        {
+            this->processJob(i);
+        }
+    }
+}
+
+void AudioEngine::processJob(int index) noexcept
+{
+    // also called on the worker threads
+    REALTIME_SCOPE("AudioEngine::processJob");
+
+    auto *slot = this->currentJobs->getUnchecked(index);
+    if (slot->isBus)
+    {
+        slot->callback->audioDeviceIOCallback(slot->busInput.getArrayOfReadPointers(),
+            this->currentNumOutputChannels, slot->buffer.getArrayOfWritePointers(),
+            this->currentNumOutputChannels, this->currentNumSamples);
+    }
+    else
+    {
+        slot->callback->audioDeviceIOCallback(this->currentInputData, this->currentNumInputChannels,
+            slot->buffer.getArrayOfWritePointers(), this->currentNumOutputChannels, this->currentNumSamples);
+    }
+
+    // the delay line keeps running even with zero delay,
+    // so that it has the recent output when the delay changes
+    if (this->latencyAlignment)
+    {
+        this->applyOutputDelay(*slot);
+    }
+}
+
+void AudioEngine::audioDeviceAboutToStart(AudioIODevice *device)
+{
+    const ScopedLock sl(this->lock);
+
+    this->currentDevice = device;
+    this->numOutputChannels = device->getActiveOutputChannels().countNumberOfSetBits();
+    this->blockSize = device->getCurrentBufferSizeSamples();
+    this->sampleRate = device->getCurrentSampleRate();
+
+    for (auto *slot : this->slots)
+    {
+        slot->callback->audioDeviceAboutToStart(device);
+        this->prepareSlot(*slot);
+    }
+}
+
+void AudioEngine::audioDeviceStopped()
+{
+    const ScopedLock sl(this->lock);
+
+    for (auto *slot : this->slots)
+    {
+        slot->callback->audioDeviceStopped();
+    }
+
+    this->currentDevice = nullptr;
+    this->numOutputChannels = 0;
+    this->blockSize = 0;
+    this->sampleRate = 0.0;
+}
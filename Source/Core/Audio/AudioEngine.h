@@ -0,0 +1,153 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "Instrument.h"
+#include "AudioWorkerPool.h"
+
+/*
+    The single device callback for all instruments: instead of registering
+    each instrument's callback in the device manager, which then calls them
+    one by one with their own temp buffers, the engine owns the list,
+    renders each instrument into a pre-allocated buffer and mixes them down.
+
+    Instruments are independent of each other, so with more than one
+    processing thread they are rendered in parallel by the worker pool.
+
+    The effect buses are rendered after all other instruments, with the sum
+    of the sends into each bus as its input, and mixed down along with them;
+    the buses don't send to each other, so there are only the two stages.
+
+    The plugins' latencies are compensated by rendering the scheduled events
+    ahead of time (see Instrument::AudioCallback); optionally, the engine also
+    delays the outputs of the instruments to match the largest latency of all,
+    so that the live input and anything not scheduled is aligned as well,
+    at the cost of that latency for everything.
+*/
+
+class AudioEngine final : public AudioIODeviceCallback,
+                          private AudioWorkerPool::Job
+{
+public:
+
+    AudioEngine() = default;
+
+    void addInstrument(Instrument *instrument);
+    void removeInstrument(Instrument *instrument);
+
+    // re-reads the instruments' sends and bus flags
+    void updateRouting();
+
+    // the total number of threads to render instruments with,
+    // including the device thread, so 1 means no parallelism
+    void setNumProcessingThreads(int numThreads);
+    int getNumProcessingThreads() const noexcept;
+
+    void setLatencyAlignment(bool shouldAlignOutputs);
+    bool isLatencyAligned() const noexcept;
+
+    // How long the whole callback takes, all its threads included,
+    // of the buffer duration, i.e. 100% means a dropout; any thread
+    struct ProcessingLoad final
+    {
+        float averagePercent = 0.f;
+        float peakPercent = 0.f;
+    };
+
+    ProcessingLoad getProcessingLoad() const noexcept;
+
+    // the largest load of a single block since the previous call
+    float getAndResetMaxLoad() noexcept;
+
+    //===------------------------------------------------------------------===//
+    // AudioIODeviceCallback
+    //===------------------------------------------------------------------===//
+
+    void audioDeviceIOCallback(const float **inputChannelData, int numInputChannels,
+        float **outputChannelData, int numOutputChannels, int numSamples) override;
+    void audioDeviceAboutToStart(AudioIODevice *device) override;
+    void audioDeviceStopped() override;
+
+private:
+
+    void processJob(int index) noexcept override;
+
+    struct Slot final
+    {
+        Instrument *instrument;
+        Instrument::AudioCallback *callback;
+        AudioBuffer<float> buffer;
+
+        // for the buses, the sum of the sends
+        AudioBuffer<float> busInput;
+        bool isBus = false;
+
+        // for the buses, the instruments sending to them
+        Array<const Slot *> inputs;
+        Array<float> inputLevels;
+
+        // for the output alignment, see above
+        AudioBuffer<float> delayLine;
+        int delayLinePosition = 0;
+        int outputDelay = 0;
+    };
+
+    void prepareSlot(Slot &slot) const;
+    void prepareDelayLine(Slot &slot) const;
+    void updateOutputDelays() noexcept;
+    void applyOutputDelay(Slot &slot) noexcept;
+    void updateRoutingUnlocked();
+    void processStage(const Array<Slot *> &stageSlots);
+
+    CriticalSection lock;
+    OwnedArray<Slot> slots;
+
+    // the slots rendered at each stage, see above
+    Array<Slot *> instrumentSlots;
+    Array<Slot *> busSlots;
+    const Array<Slot *> *currentJobs = nullptr;
+
+    // the pre-allocated arrays of the mixdown sources
+    Array<const Slot *> mixedSlots;
+    Array<const float *> mixSources;
+    Array<float> mixGains;
+    void mixDown(float *destination, int channel, const Array<const Slot *> &sources,
+        const float *gains, int numSamples) noexcept;
+
+    AudioIODevice *currentDevice = nullptr;
+    int numOutputChannels = 0;
+    int blockSize = 0;
+    double sampleRate = 0.0;
+
+    bool latencyAlignment = false;
+
+    Atomic<float> averageLoad = 0.f;
+    Atomic<float> peakLoad = 0.f;
+    Atomic<float> maxLoad = 0.f;
+    void updateProcessingLoad(int64 startTicks, int numSamples) noexcept;
+
+    UniquePointer<AudioWorkerPool> workerPool;
+
+    // the current block's parameters for the worker threads
+    const float **currentInputData = nullptr;
+    int currentNumInputChannels = 0;
+    int currentNumOutputChannels = 0;
+    int currentNumSamples = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AudioEngine)
+};
@@ -0,0 +1,205 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Common.h"
+#include "AudioWorkerPool.h"
+
+// how many times a worker checks for new jobs before falling asleep
+#define AUDIO_WORKER_NUM_SPINS 4096
+
+// how long a sleeping worker waits before checking if it should exit
+#define AUDIO_WORKER_SLEEP_TIMEOUT_MS 100
+
+static inline int64 packState(uint32 generation, int numJobs, int nextJob) noexcept
+{
+    return (int64(generation) << 32) | (int64(numJobs & 0xffff) << 16) | int64(nextJob & 0xffff);
+}
+
+static inline int getNumJobs(int64 state) noexcept
+{
+    return int((state >> 16) & 0xffff);
+}
+
+static inline int getNextJob(int64 state) noexcept
+{
+    return int(state & 0xffff);
+}
+
+//===----------------------------------------------------------------------===//
+// Worker
+//===----------------------------------------------------------------------===//
+
+class AudioWorkerPool::Worker final : public Thread
+{
+public:
+
+    Worker(AudioWorkerPool &owner, int index) :
+        Thread("Audio worker " + String(index + 1)),
+        pool(owner)
+    {
+        // try to keep each worker on its own core, leaving
+        // the first one for the device thread and the UI
+        const int numCpus = SystemStats::getNumCpus();
+        if (numCpus > 1)
+        {
+            this->setAffinityMask(uint32(1) << ((index + 1) % jmin(numCpus, 32)));
+        }
+    }
+
+    ~Worker() override
+    {
+        this->signalThreadShouldExit();
+        this->notify();
+        this->stopThread(1000);
+    }
+
+    bool isSleeping() const noexcept
+    {
+        return this->sleeping.get();
+    }
+
+    void run() override
+    {
+        const ScopedNoDenormals noDenormals;
+
+        while (!this->threadShouldExit())
+        {
+            while (this->pool.processNextJob()) {}
+
+            for (int i = 0; i < AUDIO_WORKER_NUM_SPINS; ++i)
+            {
+                if (this->pool.hasPendingJobs() || this->threadShouldExit())
+                {
+                    break;
+                }
+
+                Thread::yield();
+            }
+
+            if (!this->pool.hasPendingJobs())
+            {
+                // re-check after the flag is set, so that the wake-up
+                // from the device thread cannot be missed in between
+                this->sleeping = true;
+                if (!this->pool.hasPendingJobs())
+                {
+                    this->wait(AUDIO_WORKER_SLEEP_TIMEOUT_MS);
+                }
+                this->sleeping = false;
+            }
+        }
+    }
+
+private:
+
+    AudioWorkerPool &pool;
+    Atomic<bool> sleeping = false;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Worker)
+};
+
+//===----------------------------------------------------------------------===//
+// AudioWorkerPool
+//===----------------------------------------------------------------------===//
+
+AudioWorkerPool::AudioWorkerPool(int numWorkers)
+{
+    for (int i = 0; i < numWorkers; ++i)
+    {
+        auto *worker = this->workers.add(new Worker(*this, i));
+        worker->startThread(10);
+    }
+}
+
+AudioWorkerPool::~AudioWorkerPool()
+{
+    for (auto *worker : this->workers)
+    {
+        worker->signalThreadShouldExit();
+        worker->notify();
+    }
+
+    this->workers.clear();
+}
+
+int AudioWorkerPool::getNumWorkers() const noexcept
+{
+    return this->workers.size();
+}
+
+void AudioWorkerPool::process(Job &job, int numJobs) noexcept
+{
+    jassert(numJobs <= 0xffff);
+
+    if (this->workers.isEmpty() || numJobs <= 1)
+    {
+        for (int i = 0; i < numJobs; ++i)
+        {
+            job.processJob(i);
+        }
+
+        return;
+    }
+
+    this->currentJob = &job;
+    this->numFinishedJobs = 0;
+    this->generation++;
+    this->state = packState(this->generation, numJobs, 0);
+
+    for (auto *worker : this->workers)
+    {
+        if (worker->isSleeping())
+        {
+            worker->notify();
+        }
+    }
+
+    while (this->processNextJob()) {}
+
+    // all jobs are claimed at this point, but some of them
+    // might still be in progress on the worker threads
+    while (this->numFinishedJobs.get() < numJobs) {}
+}
+
+bool AudioWorkerPool::hasPendingJobs() const noexcept
+{
+    const auto currentState = this->state.get();
+    return getNextJob(currentState) < getNumJobs(currentState);
+}
+
+bool AudioWorkerPool::processNextJob() noexcept
+{
+    for (;;)
+    {
+        const auto currentState = this->state.get();
+        const int jobIndex = getNextJob(currentState);
+        if (jobIndex >= getNumJobs(currentState))
+        {
+            return false;
+        }
+
+        // the generation bits make sure that a worker which is late
+        // for the previous block cannot claim a job of the next block
+        if (this->state.compareAndSetBool(currentState + 1, currentState))
+        {
+            // the job pointer cannot change until this one is finished
+            this->currentJob.get()->processJob(jobIndex);
+            ++this->numFinishedJobs;
+            return true;
+        }
+    }
+}
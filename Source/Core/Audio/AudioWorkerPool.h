@@ -0,0 +1,65 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+/*
+    A group of high-priority threads which help the device thread
+    to process a list of independent jobs, e.g. instruments' graphs:
+    all jobs are claimed via a single atomic state, so that the device
+    thread never locks, and it also takes jobs itself while waiting
+    for the workers to finish, which makes process() a join barrier.
+
+    The workers spin for a while after each block, because the next one
+    is most likely coming in a few milliseconds, and then fall asleep.
+*/
+
+class AudioWorkerPool final
+{
+public:
+
+    struct Job
+    {
+        virtual ~Job() = default;
+        virtual void processJob(int index) noexcept = 0;
+    };
+
+    explicit AudioWorkerPool(int numWorkers);
+    ~AudioWorkerPool();
+
+    int getNumWorkers() const noexcept;
+
+    // Called from the device thread, returns when all jobs are done
+    void process(Job &job, int numJobs) noexcept;
+
+private:
+
+    bool processNextJob() noexcept;
+    bool hasPendingJobs() const noexcept;
+
+    class Worker;
+    OwnedArray<Worker> workers;
+
+    // job generation, number of jobs and next job index, packed
+    // into one value so that they are always updated together
+    Atomic<int64> state = 0;
+    Atomic<int> numFinishedJobs = 0;
+    Atomic<Job *> currentJob = nullptr;
+    uint32 generation = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AudioWorkerPool)
+};
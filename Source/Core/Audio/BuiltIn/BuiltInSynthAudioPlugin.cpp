@@ -133,6 +133,30 @@ void BuiltInSynthAudioPlugin::changeProgramName(int index, const String &newName
 // State
 //===----------------------------------------------------------------------===//
 
-void BuiltInSynthAudioPlugin::getStateInformation(MemoryBlock &destData) {}
+void BuiltInSynthAudioPlugin::getStateInformation(MemoryBlock &destData)
+{
+    MemoryOutputStream out(destData, false);
+    out.writeInt(this->synth.getVoiceLimit());
+    out.writeInt(int(this->synth.getStealingMode()));
+}
 
-void BuiltInSynthAudioPlugin::setStateInformation(const void *data, int sizeInBytes) {}
+void BuiltInSynthAudioPlugin::setStateInformation(const void *data, int sizeInBytes)
+{
+    // the state was empty in earlier versions, so the defaults are kept
+    if (sizeInBytes < 8)
+    {
+        return;
+    }
+
+    MemoryInputStream in(data, size_t(sizeInBytes), false);
+
+    const int voiceLimit = in.readInt();
+    if (voiceLimit > 0)
+    {
+        this->synth.setVoiceLimit(voiceLimit);
+    }
+
+    const int stealingMode = in.readInt();
+    this->synth.setStealingMode(stealingMode == int(BuiltInSampler::StealingMode::Quietest) ?
+        BuiltInSampler::StealingMode::Quietest : BuiltInSampler::StealingMode::Oldest);
+}
@@ -17,6 +17,8 @@
 
 #pragma once
 
+#include "BuiltInSynthSampler.h"
+
 #define BUILTIN_SYNTH_NUM_VOICES 32
 
 class BuiltInSynthAudioPlugin : public AudioPluginInstance
@@ -71,6 +73,6 @@ protected:
     virtual void initVoices() = 0;
     virtual void initSampler() = 0;
 
-    Synthesiser synth;
+    BuiltInSampler synth;
 
 };
@@ -17,25 +17,25 @@
 
 #include "Common.h"
 #include "BuiltInSynthPiano.h"
+#include "DocumentHelpers.h"
 #include "BinaryData.h"
 
 #define ATTACK_TIME (0.0)
 #define RELEASE_TIME (0.5)
 #define MAX_PLAY_TIME (4.5)
 
+// the zones which are most likely to be played, loaded right away
+#define DEFAULT_ZONES_LOW_KEY (46)
+#define DEFAULT_ZONES_HIGH_KEY (81)
+
 struct PianoSample final
 {
-    PianoSample() = default;
-    PianoSample(const PianoSample &other) :
-        sourceData(other.sourceData),
-        sourceDataSize(other.sourceDataSize),
-        midiNoteForNormalPitch(other.midiNoteForNormalPitch),
-        midiNotes(other.midiNotes) {}
-
     PianoSample(int lowKey, int highKey, int rootKey,
         const char *sourceData, int sourceDataSize) :
         sourceData(sourceData),
         sourceDataSize(sourceDataSize),
+        lowKey(lowKey),
+        highKey(highKey),
         midiNoteForNormalPitch(rootKey)
     {
         for (int i = lowKey; i <= highKey; ++i)
@@ -44,24 +44,250 @@ struct PianoSample final
         }
     }
 
-    AudioFormatReader *createReader()
+    AudioFormatReader *createReader() const
     {
-        static FlacAudioFormat flac;
+        FlacAudioFormat flac;
         return flac.createReaderFor(new MemoryInputStream(sourceData, sourceDataSize, false), true);
     }
 
+    File getCacheFile() const
+    {
+#if HELIO_DESKTOP
+        // the data size is here to invalidate the cache if the samples change
+        return DocumentHelpers::getConfigSlot("piano-" + String(this->midiNoteForNormalPitch) +
+            "-" + String::toHexString(this->sourceDataSize) + ".wav");
+#else
+        return {};
+#endif
+    }
+
     const char *sourceData;
     int sourceDataSize;
-    String name;
+    int lowKey;
+    int highKey;
     BigInteger midiNotes;
     int midiNoteForNormalPitch;
 
-    JUCE_LEAK_DETECTOR(PianoSample)
+    Atomic<bool> isRequested = false;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PianoSample)
 };
 
+//===----------------------------------------------------------------------===//
+// SamplesLoader
+//===----------------------------------------------------------------------===//
+
+class BuiltInSynthPiano::SamplesLoader final : private Thread
+{
+public:
+
+    SamplesLoader(BuiltInSampler &targetSynth, BuiltInSynthPiano &piano) :
+        Thread("Piano samples loader"),
+        synth(targetSynth),
+        piano(piano)
+    {
+        this->samples.add(new PianoSample(26, 39, 36, BinaryData::C2v9_flac, BinaryData::C2v9_flacSize));
+        this->samples.add(new PianoSample(40, 45, 42, BinaryData::F2v9_flac, BinaryData::F2v9_flacSize));
+
+        this->samples.add(new PianoSample(46, 51, 48, BinaryData::C3v9_flac, BinaryData::C3v9_flacSize));
+        this->samples.add(new PianoSample(52, 57, 54, BinaryData::F3v9_flac, BinaryData::F3v9_flacSize));
+
+        this->samples.add(new PianoSample(58, 63, 60, BinaryData::C4v9_flac, BinaryData::C4v9_flacSize));
+        this->samples.add(new PianoSample(64, 69, 66, BinaryData::F4v9_flac, BinaryData::F4v9_flacSize));
+
+        this->samples.add(new PianoSample(70, 75, 72, BinaryData::C5v9_flac, BinaryData::C5v9_flacSize));
+        this->samples.add(new PianoSample(76, 81, 78, BinaryData::F5v9_flac, BinaryData::F5v9_flacSize));
+
+        this->samples.add(new PianoSample(82, 87, 84, BinaryData::C6v9_flac, BinaryData::C6v9_flacSize));
+        this->samples.add(new PianoSample(88, 100, 90, BinaryData::F6v9_flac, BinaryData::F6v9_flacSize));
+
+        for (auto &sampleIndex : this->sampleIndexByKey)
+        {
+            sampleIndex = -1;
+        }
+
+        for (int i = 0; i < this->samples.size(); ++i)
+        {
+            const auto *sample = this->samples.getUnchecked(i);
+            for (int key = sample->lowKey; key <= sample->highKey; ++key)
+            {
+                this->sampleIndexByKey[key] = int8(i);
+            }
+        }
+
+        for (auto *sample : this->samples)
+        {
+            if (sample->lowKey >= DEFAULT_ZONES_LOW_KEY &&
+                sample->highKey <= DEFAULT_ZONES_HIGH_KEY)
+            {
+                sample->isRequested = true;
+            }
+        }
+
+        this->startThread(3);
+    }
+
+    ~SamplesLoader() override
+    {
+        this->signalThreadShouldExit();
+        this->notify();
+        this->stopThread(2000);
+    }
+
+    // called from the audio thread, only wakes up
+    // the loader for the zones which are not requested yet
+    void requestSampleForKey(int key) noexcept
+    {
+        const int sampleIndex = this->sampleIndexByKey[key & 127];
+        if (sampleIndex >= 0 &&
+            this->samples.getUnchecked(sampleIndex)->isRequested.compareAndSetBool(true, false))
+        {
+            this->notify();
+        }
+    }
+
+private:
+
+    void run() override
+    {
+        Array<PianoSample *> loadedSamples;
+
+        while (!this->threadShouldExit())
+        {
+            for (auto *sample : this->samples)
+            {
+                if (this->threadShouldExit())
+                {
+                    return;
+                }
+
+                if (sample->isRequested.get() && !loadedSamples.contains(sample))
+                {
+                    this->loadSample(*sample);
+                    loadedSamples.add(sample);
+                }
+            }
+
+            if (loadedSamples.size() == this->samples.size())
+            {
+                return;
+            }
+
+            this->wait(-1);
+        }
+    }
+
+    void loadSample(const PianoSample &sample)
+    {
+        const auto cacheFile = sample.getCacheFile();
+
+        // try the decoded pcm data from the previous launch first
+        if (cacheFile.existsAsFile())
+        {
+            WavAudioFormat wav;
+            UniquePointer<MemoryMappedAudioFormatReader> mappedReader(wav.createMemoryMappedReader(cacheFile));
+            if (mappedReader != nullptr && mappedReader->mapEntireFile())
+            {
+                auto *sound = new BuiltInSamplerSound(*mappedReader,
+                    sample.midiNotes, sample.midiNoteForNormalPitch,
+                    ATTACK_TIME, RELEASE_TIME, MAX_PLAY_TIME);
+
+                this->synth.addSound(sound);
+                this->piano.onSoundLoaded(*sound);
+                return;
+            }
+        }
+
+        UniquePointer<AudioFormatReader> reader(sample.createReader());
+        if (reader == nullptr)
+        {
+            jassertfalse;
+            return;
+        }
+
+        auto *sound = new BuiltInSamplerSound(*reader,
+            sample.midiNotes, sample.midiNoteForNormalPitch,
+            ATTACK_TIME, RELEASE_TIME, MAX_PLAY_TIME);
+
+        // adding the sound takes the synth's lock, which is only held
+        // by the audio thread for a block, the decoding is done already
+        this->synth.addSound(sound);
+        this->piano.onSoundLoaded(*sound);
+
+        if (cacheFile != File() && sound->getLength() > 0)
+        {
+            this->writeCache(cacheFile, *sound);
+        }
+    }
+
+    static void writeCache(const File &file, const BuiltInSamplerSound &sound)
+    {
+        TemporaryFile tempFile(file);
+        UniquePointer<FileOutputStream> stream(tempFile.getFile().createOutputStream());
+        if (stream == nullptr)
+        {
+            return;
+        }
+
+        WavAudioFormat wav;
+        UniquePointer<AudioFormatWriter> writer(wav.createWriterFor(stream.get(),
+            sound.getSourceSampleRate(), unsigned(sound.getNumChannels()), 32, {}, 0));
+
+        if (writer == nullptr)
+        {
+            return;
+        }
+
+        stream.release(); // now owned by the writer
+        const float *channels[] = { sound.getSamples(0),
+            sound.getSamples(jmin(1, sound.getNumChannels() - 1)) };
+
+        const bool written = writer->writeFromFloatArrays(channels,
+            sound.getNumChannels(), sound.getLength());
+        writer = nullptr;
+
+        if (written)
+        {
+            tempFile.overwriteTargetFileWithTemporary();
+        }
+    }
+
+    BuiltInSampler &synth;
+    BuiltInSynthPiano &piano;
+    OwnedArray<PianoSample> samples;
+    int8 sampleIndexByKey[128];
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SamplesLoader)
+};
+
+//===----------------------------------------------------------------------===//
+// BuiltInSynthPiano
+//===----------------------------------------------------------------------===//
+
 BuiltInSynthPiano::BuiltInSynthPiano()
 {
     this->setPlayConfigDetails(0, 2, this->getSampleRate(), this->getBlockSize());
+
+    this->memoryAccount = makeUnique<MemoryBudget::Account>("Piano samples",
+        [this](int &numItems, int64 &numBytes)
+        {
+            numItems += this->numLoadedSounds.get();
+            numBytes += this->numLoadedBytes.get();
+        });
+}
+
+BuiltInSynthPiano::~BuiltInSynthPiano()
+{
+    // the loader adds sounds to the synth, so it has to stop first
+    this->samplesLoader = nullptr;
+    this->memoryAccount = nullptr;
+}
+
+void BuiltInSynthPiano::onSoundLoaded(const BuiltInSamplerSound &sound) noexcept
+{
+    // the decoded data is kept as floats, even when it's memory-mapped from the cache
+    this->numLoadedSounds += 1;
+    this->numLoadedBytes += int64(sound.getNumChannels()) * sound.getLength() * sizeof(float);
 }
 
 const String BuiltInSynthPiano::getName() const
@@ -71,23 +297,44 @@ const String BuiltInSynthPiano::getName() const
 
 void BuiltInSynthPiano::initVoices()
 {
-    for (int i = BUILTIN_SYNTH_NUM_VOICES; --i >= 0;)
+    // the limit might have been restored from the state already
+    if (this->synth.getVoiceLimit() == 0)
     {
-        this->synth.addVoice(new SamplerVoice());
+        this->synth.setVoiceLimit(BUILTIN_SYNTH_NUM_VOICES);
     }
 }
 
-void BuiltInSynthPiano::processBlock(AudioSampleBuffer &buffer, MidiBuffer &midiMessages)
+void BuiltInSynthPiano::prepareToPlay(double sampleRate, int estimatedSamplesPerBlock)
 {
-    if (this->synth.getNumSounds() == 0 && midiMessages.getNumEvents() > 0)
+    BuiltInSynthAudioPlugin::prepareToPlay(sampleRate, estimatedSamplesPerBlock);
+
+    // Initialization takes about 400ms and consumes a lot of RAM, and the
+    // format also creates an instance just to get the plugin description,
+    // so only start loading when the instrument is actually going to play
+    if (this->samplesLoader == nullptr)
     {
-        // Initialization takes about 400ms (i.e. slows app loading way down),
-        // and consumes a lot of RAM (though user might never use the built-in piano).
-        // So let's do a lazy initialization on first use - i.e. here in processBlock
         this->initVoices();
         this->initSampler();
     }
-    
+}
+
+void BuiltInSynthPiano::processBlock(AudioSampleBuffer &buffer, MidiBuffer &midiMessages)
+{
+    if (this->samplesLoader != nullptr)
+    {
+        MidiBuffer::Iterator it(midiMessages);
+        MidiMessage message;
+        int samplePosition;
+
+        while (it.getNextEvent(message, samplePosition))
+        {
+            if (message.isNoteOn())
+            {
+                this->samplesLoader->requestSampleForKey(message.getNoteNumber());
+            }
+        }
+    }
+
     BuiltInSynthAudioPlugin::processBlock(buffer, midiMessages);
 }
 
@@ -96,32 +343,15 @@ void BuiltInSynthPiano::reset()
     this->synth.allNotesOff(0, true);
 }
 
+void BuiltInSynthPiano::setVoiceCap(int numVoices) noexcept
+{
+    this->synth.setVoiceCap(numVoices);
+}
+
 void BuiltInSynthPiano::initSampler()
 {
     this->synth.clearSounds();
-
-    Array<PianoSample> samples;
-
-    samples.add({ 26, 39, 36, BinaryData::C2v9_flac, BinaryData::C2v9_flacSize });
-    samples.add({ 40, 45, 42, BinaryData::F2v9_flac, BinaryData::F2v9_flacSize });
-
-    samples.add({ 46, 51, 48, BinaryData::C3v9_flac, BinaryData::C3v9_flacSize });
-    samples.add({ 52, 57, 54, BinaryData::F3v9_flac, BinaryData::F3v9_flacSize });
-
-    samples.add({ 58, 63, 60, BinaryData::C4v9_flac, BinaryData::C4v9_flacSize });
-    samples.add({ 64, 69, 66, BinaryData::F4v9_flac, BinaryData::F4v9_flacSize });
-
-    samples.add({ 70, 75, 72, BinaryData::C5v9_flac, BinaryData::C5v9_flacSize });
-    samples.add({ 76, 81, 78, BinaryData::F5v9_flac, BinaryData::F5v9_flacSize });
-
-    samples.add({ 82, 87, 84, BinaryData::C6v9_flac, BinaryData::C6v9_flacSize });
-    samples.add({ 88, 100, 90, BinaryData::F6v9_flac, BinaryData::F6v9_flacSize });
-
-    for (auto &s : samples)
-    {
-        UniquePointer<AudioFormatReader> reader(s.createReader());
-        this->synth.addSound(new SamplerSound({}, *reader,
-            s.midiNotes, s.midiNoteForNormalPitch,
-            ATTACK_TIME, RELEASE_TIME, MAX_PLAY_TIME));
-    }
+    this->numLoadedSounds = 0;
+    this->numLoadedBytes = 0;
+    this->samplesLoader = makeUnique<SamplesLoader>(this->synth, *this);
 }
@@ -18,26 +18,47 @@
 #pragma once
 
 #include "BuiltInSynthAudioPlugin.h"
+#include "MemoryBudget.h"
 
 // A lightweight piano sampler with the only purpose of providing a default instrument
 // that doesn't sound too much crappy when user opens the app at the very first time,
 // and doesn't have any custom instruments added yet.
 // So it's as simple and small as possible.
 
+// The samples are decoded in the background, zone by zone: the middle ones
+// right after the instrument is prepared to play, the rest when first needed;
+// decoded zones are also cached on disk, so that the next time they are
+// just memory-mapped instead of decoding the flac data again.
+
 class BuiltInSynthPiano : public BuiltInSynthAudioPlugin
 {
 public:
 
     explicit BuiltInSynthPiano();
+    ~BuiltInSynthPiano() override;
 
     const String getName() const override;
+    void prepareToPlay(double sampleRate, int estimatedSamplesPerBlock) override;
     void processBlock(AudioSampleBuffer &buffer, MidiBuffer &midiMessages) override;
     void reset() override;
 
+    // see BuiltInSampler::setVoiceCap
+    void setVoiceCap(int numVoices) noexcept;
+
 protected:
 
     void initVoices() override;
     void initSampler() override;
 
+private:
+
+    class SamplesLoader;
+    UniquePointer<SamplesLoader> samplesLoader;
+
+    Atomic<int> numLoadedSounds = 0;
+    Atomic<int64> numLoadedBytes = 0;
+    void onSoundLoaded(const BuiltInSamplerSound &sound) noexcept;
+    UniquePointer<MemoryBudget::Account> memoryAccount;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(BuiltInSynthPiano)
 };
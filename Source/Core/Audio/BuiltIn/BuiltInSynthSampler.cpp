@@ -0,0 +1,416 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Common.h"
+#include "BuiltInSynthSampler.h"
+
+// the padding around the sample data, needed by the 4-point interpolation
+#define SAMPLE_PADDING_BEFORE (1)
+#define SAMPLE_PADDING_AFTER (3)
+
+// the fixed number of extra voices, which are only used to play release tails,
+// so that the releasing notes don't eat the voice limit of the held ones
+#define NUM_RELEASE_TAIL_VOICES (16)
+
+//===----------------------------------------------------------------------===//
+// BuiltInSamplerSound
+//===----------------------------------------------------------------------===//
+
+BuiltInSamplerSound::BuiltInSamplerSound(AudioFormatReader &source,
+    const BigInteger &notes, int midiNoteForNormalPitch,
+    double attackTimeSecs, double releaseTimeSecs, double maxSampleLengthSeconds) :
+    midiNotes(notes),
+    sourceSampleRate(source.sampleRate),
+    midiRootNote(midiNoteForNormalPitch),
+    attackTime(attackTimeSecs),
+    releaseTime(releaseTimeSecs)
+{
+    if (this->sourceSampleRate <= 0 || source.lengthInSamples <= 0)
+    {
+        return;
+    }
+
+    this->length = int(jmin(int64(source.lengthInSamples),
+        int64(maxSampleLengthSeconds * this->sourceSampleRate)));
+
+    const int numChannels = int(jmin(2u, source.numChannels));
+    this->data.setSize(numChannels,
+        SAMPLE_PADDING_BEFORE + this->length + SAMPLE_PADDING_AFTER);
+
+    this->data.clear();
+    source.read(&this->data, SAMPLE_PADDING_BEFORE, this->length, 0, true, true);
+}
+
+bool BuiltInSamplerSound::appliesToNote(int midiNoteNumber)
+{
+    return this->midiNotes[midiNoteNumber];
+}
+
+bool BuiltInSamplerSound::appliesToChannel(int midiChannel)
+{
+    return true;
+}
+
+int BuiltInSamplerSound::getNumChannels() const noexcept
+{
+    return this->data.getNumChannels();
+}
+
+int BuiltInSamplerSound::getLength() const noexcept
+{
+    return this->length;
+}
+
+double BuiltInSamplerSound::getSourceSampleRate() const noexcept
+{
+    return this->sourceSampleRate;
+}
+
+const float *BuiltInSamplerSound::getSamples(int channel) const noexcept
+{
+    return this->data.getReadPointer(channel, SAMPLE_PADDING_BEFORE);
+}
+
+//===----------------------------------------------------------------------===//
+// BuiltInSamplerVoice
+//===----------------------------------------------------------------------===//
+
+bool BuiltInSamplerVoice::canPlaySound(SynthesiserSound *sound)
+{
+    return dynamic_cast<const BuiltInSamplerSound *>(sound) != nullptr;
+}
+
+void BuiltInSamplerVoice::startNote(int midiNoteNumber, float velocity,
+    SynthesiserSound *s, int pitchWheel)
+{
+    const auto *sound = dynamic_cast<const BuiltInSamplerSound *>(s);
+    if (sound == nullptr || sound->getLength() == 0)
+    {
+        jassert(sound != nullptr);
+        this->clearCurrentNote();
+        return;
+    }
+
+    const double sampleRate = this->getSampleRate();
+
+    this->pitchRatio = std::pow(2.0, (midiNoteNumber - sound->midiRootNote) / 12.0) *
+        sound->sourceSampleRate / sampleRate;
+
+    this->sourcePosition = 0.0;
+    this->gain = velocity;
+
+    this->attackDelta = sound->attackTime > 0.0 ?
+        float(1.0 / (sound->attackTime * sampleRate)) : 1.f;
+
+    this->releaseDelta = sound->releaseTime > 0.0 ?
+        float(1.0 / (sound->releaseTime * sampleRate)) : 1.f;
+
+    if (this->attackDelta < 1.f)
+    {
+        this->level = 0.f;
+        this->stage = Stage::Attack;
+    }
+    else
+    {
+        this->level = 1.f;
+        this->stage = Stage::Sustain;
+    }
+}
+
+void BuiltInSamplerVoice::stopNote(float velocity, bool allowTailOff)
+{
+    if (!allowTailOff)
+    {
+        this->stage = Stage::Idle;
+        this->clearCurrentNote();
+        return;
+    }
+
+    // keeps the release time the same, regardless of the current level
+    this->stage = Stage::Release;
+}
+
+bool BuiltInSamplerVoice::isReleasing() const noexcept
+{
+    return this->stage == Stage::Release;
+}
+
+float BuiltInSamplerVoice::getCurrentLevel() const noexcept
+{
+    return this->gain * this->level;
+}
+
+void BuiltInSamplerVoice::renderNextBlock(AudioBuffer<float> &outputBuffer,
+    int startSample, int numSamples)
+{
+    const auto *sound =
+        static_cast<const BuiltInSamplerSound *>(this->getCurrentlyPlayingSound().get());
+
+    if (sound == nullptr || this->stage == Stage::Idle)
+    {
+        return;
+    }
+
+    const int numOutputChannels = outputBuffer.getNumChannels();
+    float *outL = outputBuffer.getWritePointer(0, startSample);
+    float *outR = numOutputChannels > 1 ? outputBuffer.getWritePointer(1, startSample) : nullptr;
+
+    while (numSamples > 0)
+    {
+        const int numRequested = jmin(numSamples, int(chunkSize));
+        const int numSamplesLeft = this->renderSamples(*sound, numRequested);
+        const int numRendered = this->renderEnvelope(numSamplesLeft);
+
+        FloatVectorOperations::multiply(this->leftChunk, this->envelopeChunk, numRendered);
+        FloatVectorOperations::multiply(this->rightChunk, this->envelopeChunk, numRendered);
+
+        if (outR != nullptr)
+        {
+            FloatVectorOperations::addWithMultiply(outL, this->leftChunk, this->gain, numRendered);
+            FloatVectorOperations::addWithMultiply(outR, this->rightChunk, this->gain, numRendered);
+            outR += numRendered;
+        }
+        else
+        {
+            FloatVectorOperations::add(this->leftChunk, this->rightChunk, numRendered);
+            FloatVectorOperations::addWithMultiply(outL, this->leftChunk, this->gain * 0.5f, numRendered);
+        }
+
+        outL += numRendered;
+        numSamples -= numRendered;
+
+        if (numRendered < numRequested)
+        {
+            // either the sample has ended or the release tail is over
+            this->stage = Stage::Idle;
+            this->clearCurrentNote();
+            return;
+        }
+    }
+}
+
+// Fills the left and the right chunks with the resampled data,
+// returns the number of samples rendered before the end of the sample;
+// the 4-point hermite interpolation is done in a branch-free loop
+// over a fixed-size chunk, which the compiler can vectorize
+int BuiltInSamplerVoice::renderSamples(const BuiltInSamplerSound &sound, int numSamples) noexcept
+{
+    const double samplesLeft = double(sound.getLength()) - this->sourcePosition;
+    if (samplesLeft <= 0.0)
+    {
+        return 0;
+    }
+
+    const int numAvailable = int(std::ceil(samplesLeft / this->pitchRatio));
+    const int numToRender = jmin(numSamples, numAvailable);
+
+    const int numSourceChannels = sound.getNumChannels();
+    const float *inL = sound.getSamples(0);
+    const float *inR = sound.getSamples(numSourceChannels > 1 ? 1 : 0);
+
+    const double startPosition = this->sourcePosition;
+    const double ratio = this->pitchRatio;
+
+    for (int i = 0; i < numToRender; ++i)
+    {
+        const double position = startPosition + i * ratio;
+        const int index = int(position);
+        const float t = float(position - index);
+
+        const float *l = inL + index;
+        const float *r = inR + index;
+
+        const float l1 = 0.5f * (l[1] - l[-1]);
+        const float l2 = l[-1] - 2.5f * l[0] + 2.f * l[1] - 0.5f * l[2];
+        const float l3 = 0.5f * (l[2] - l[-1]) + 1.5f * (l[0] - l[1]);
+        this->leftChunk[i] = ((l3 * t + l2) * t + l1) * t + l[0];
+
+        const float r1 = 0.5f * (r[1] - r[-1]);
+        const float r2 = r[-1] - 2.5f * r[0] + 2.f * r[1] - 0.5f * r[2];
+        const float r3 = 0.5f * (r[2] - r[-1]) + 1.5f * (r[0] - r[1]);
+        this->rightChunk[i] = ((r3 * t + r2) * t + r1) * t + r[0];
+    }
+
+    this->sourcePosition = startPosition + numToRender * ratio;
+    return numToRender;
+}
+
+// Fills the envelope chunk, returns the number of samples
+// rendered before the release tail is over
+int BuiltInSamplerVoice::renderEnvelope(int numSamples) noexcept
+{
+    int i = 0;
+
+    if (this->stage == Stage::Attack)
+    {
+        for (; i < numSamples && this->level < 1.f; ++i)
+        {
+            this->envelopeChunk[i] = this->level;
+            this->level += this->attackDelta;
+        }
+
+        if (this->level >= 1.f)
+        {
+            this->level = 1.f;
+            this->stage = Stage::Sustain;
+        }
+    }
+
+    if (this->stage == Stage::Sustain)
+    {
+        FloatVectorOperations::fill(this->envelopeChunk + i, 1.f, numSamples - i);
+        return numSamples;
+    }
+
+    if (this->stage == Stage::Release)
+    {
+        for (; i < numSamples && this->level > 0.f; ++i)
+        {
+            this->envelopeChunk[i] = this->level;
+            this->level -= this->releaseDelta;
+        }
+
+        if (this->level <= 0.f)
+        {
+            this->level = 0.f;
+            return i;
+        }
+    }
+
+    return i;
+}
+
+//===----------------------------------------------------------------------===//
+// BuiltInSampler
+//===----------------------------------------------------------------------===//
+
+void BuiltInSampler::setVoiceLimit(int numVoices)
+{
+    const ScopedLock sl(this->lock);
+
+    this->voiceLimit = jmax(1, numVoices);
+    const int totalNumVoices = this->voiceLimit + NUM_RELEASE_TAIL_VOICES;
+
+    while (this->voices.size() > totalNumVoices)
+    {
+        this->voices.removeLast();
+    }
+
+    while (this->voices.size() < totalNumVoices)
+    {
+        auto *voice = this->voices.add(new BuiltInSamplerVoice());
+        voice->setCurrentPlaybackSampleRate(this->getSampleRate());
+    }
+}
+
+int BuiltInSampler::getVoiceLimit() const noexcept
+{
+    return this->voiceLimit;
+}
+
+void BuiltInSampler::setVoiceCap(int numVoices) noexcept
+{
+    this->voiceCap = jmax(0, numVoices);
+}
+
+void BuiltInSampler::setStealingMode(StealingMode mode) noexcept
+{
+    this->stealingMode = mode;
+}
+
+BuiltInSampler::StealingMode BuiltInSampler::getStealingMode() const noexcept
+{
+    return this->stealingMode;
+}
+
+bool BuiltInSampler::shouldStealBefore(const BuiltInSamplerVoice *voice,
+    const BuiltInSamplerVoice *otherVoice) const noexcept
+{
+    switch (this->stealingMode)
+    {
+    case StealingMode::Quietest:
+        return voice->getCurrentLevel() < otherVoice->getCurrentLevel();
+    case StealingMode::Oldest:
+    default:
+        return voice->wasStartedBefore(*otherVoice);
+    }
+}
+
+// Called with the synth's lock held, when a note-on arrives
+SynthesiserVoice *BuiltInSampler::findFreeVoice(SynthesiserSound *sound,
+    int midiChannel, int midiNoteNumber, bool stealIfNoneAvailable) const
+{
+    int numHeldVoices = 0;
+    BuiltInSamplerVoice *freeVoice = nullptr;
+    BuiltInSamplerVoice *heldVoiceToSteal = nullptr;
+    BuiltInSamplerVoice *quietestTail = nullptr;
+
+    for (auto *v : this->voices)
+    {
+        auto *voice = static_cast<BuiltInSamplerVoice *>(v);
+
+        if (!voice->isVoiceActive())
+        {
+            if (freeVoice == nullptr && voice->canPlaySound(sound))
+            {
+                freeVoice = voice;
+            }
+        }
+        else if (voice->isReleasing())
+        {
+            if (quietestTail == nullptr ||
+                voice->getCurrentLevel() < quietestTail->getCurrentLevel())
+            {
+                quietestTail = voice;
+            }
+        }
+        else
+        {
+            numHeldVoices++;
+            if (heldVoiceToSteal == nullptr ||
+                this->shouldStealBefore(voice, heldVoiceToSteal))
+            {
+                heldVoiceToSteal = voice;
+            }
+        }
+    }
+
+    const int cap = this->voiceCap.get();
+    const int maxHeldVoices = cap > 0 ? jmin(cap, this->voiceLimit) : this->voiceLimit;
+    if (numHeldVoices >= maxHeldVoices && heldVoiceToSteal != nullptr)
+    {
+        if (!stealIfNoneAvailable)
+        {
+            return nullptr;
+        }
+
+        // the stolen voice is not cut off, but fades out as a release tail
+        heldVoiceToSteal->stopNote(0.f, true);
+        if (quietestTail == nullptr)
+        {
+            quietestTail = heldVoiceToSteal;
+        }
+    }
+
+    if (freeVoice != nullptr)
+    {
+        return freeVoice;
+    }
+
+    // all tails are busy, so the quietest one gets restarted
+    return stealIfNoneAvailable ? quietestTail : nullptr;
+}
@@ -0,0 +1,143 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+// A sampler engine for the built-in instruments: unlike the stock SamplerVoice,
+// it uses the cubic interpolation, processed in small chunks with the vector ops,
+// and it keeps the number of held voices within a limit, moving the stolen ones
+// into a separate pool of voices which only play their release tails.
+
+class BuiltInSamplerSound final : public SynthesiserSound
+{
+public:
+
+    BuiltInSamplerSound(AudioFormatReader &source, const BigInteger &midiNotes,
+        int midiNoteForNormalPitch, double attackTimeSecs,
+        double releaseTimeSecs, double maxSampleLengthSeconds);
+
+    bool appliesToNote(int midiNoteNumber) override;
+    bool appliesToChannel(int midiChannel) override;
+
+    int getNumChannels() const noexcept;
+    int getLength() const noexcept;
+    double getSourceSampleRate() const noexcept;
+
+    // the samples are padded with zeros on both sides for the interpolation,
+    // so that it can safely read one sample before and two samples after
+    const float *getSamples(int channel) const noexcept;
+
+private:
+
+    friend class BuiltInSamplerVoice;
+
+    AudioBuffer<float> data;
+    BigInteger midiNotes;
+    double sourceSampleRate;
+    int length = 0;
+    int midiRootNote;
+    double attackTime;
+    double releaseTime;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(BuiltInSamplerSound)
+};
+
+class BuiltInSamplerVoice final : public SynthesiserVoice
+{
+public:
+
+    BuiltInSamplerVoice() = default;
+
+    bool canPlaySound(SynthesiserSound *sound) override;
+
+    void startNote(int midiNoteNumber, float velocity,
+        SynthesiserSound *sound, int pitchWheel) override;
+    void stopNote(float velocity, bool allowTailOff) override;
+
+    void pitchWheelMoved(int newValue) override {}
+    void controllerMoved(int controllerNumber, int newValue) override {}
+
+    void renderNextBlock(AudioBuffer<float> &outputBuffer,
+        int startSample, int numSamples) override;
+
+    bool isReleasing() const noexcept;
+    float getCurrentLevel() const noexcept;
+
+private:
+
+    int renderSamples(const BuiltInSamplerSound &sound, int numSamples) noexcept;
+    int renderEnvelope(int numSamples) noexcept;
+
+    enum class Stage { Idle, Attack, Sustain, Release };
+    Stage stage = Stage::Idle;
+
+    double sourcePosition = 0.0;
+    double pitchRatio = 1.0;
+
+    float gain = 0.f;
+    float level = 0.f;
+    float attackDelta = 0.f;
+    float releaseDelta = 0.f;
+
+    static constexpr int chunkSize = 64;
+    float leftChunk[chunkSize];
+    float rightChunk[chunkSize];
+    float envelopeChunk[chunkSize];
+
+    JUCE_LEAK_DETECTOR(BuiltInSamplerVoice)
+};
+
+class BuiltInSampler final : public Synthesiser
+{
+public:
+
+    enum class StealingMode
+    {
+        Oldest = 0,
+        Quietest = 1
+    };
+
+    BuiltInSampler() = default;
+
+    // the max number of voices which are held by keys or the sustain pedal,
+    // not including the release tails, which have their own fixed pool
+    void setVoiceLimit(int numVoices);
+    int getVoiceLimit() const noexcept;
+
+    // a temporary cap on the voice limit, which is not saved with the state,
+    // e.g. when the device is overheating; zero means no cap
+    void setVoiceCap(int numVoices) noexcept;
+
+    void setStealingMode(StealingMode mode) noexcept;
+    StealingMode getStealingMode() const noexcept;
+
+protected:
+
+    SynthesiserVoice *findFreeVoice(SynthesiserSound *sound, int midiChannel,
+        int midiNoteNumber, bool stealIfNoneAvailable) const override;
+
+private:
+
+    bool shouldStealBefore(const BuiltInSamplerVoice *voice,
+        const BuiltInSamplerVoice *otherVoice) const noexcept;
+
+    int voiceLimit = 0;
+    Atomic<int> voiceCap = 0;
+    StealingMode stealingMode = StealingMode::Oldest;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(BuiltInSampler)
+};
@@ -0,0 +1,59 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Common.h"
+#include "FrozenAudio.h"
+
+FrozenAudio::Ptr FrozenAudio::createFrom(const File &file)
+{
+    WavAudioFormat format;
+    UniquePointer<MemoryMappedAudioFormatReader> reader(format.createMemoryMappedReader(file));
+    if (reader == nullptr || !reader->mapEntireFile())
+    {
+        return nullptr;
+    }
+
+    // touch all pages now, so that the first playback doesn't page fault
+    for (int64 i = 0; i < reader->lengthInSamples; i += 4096)
+    {
+        reader->touchSample(i);
+    }
+
+    Ptr frozenAudio(new FrozenAudio());
+    frozenAudio->file = file;
+    frozenAudio->reader = std::move(reader);
+    return frozenAudio;
+}
+
+FrozenAudio::~FrozenAudio()
+{
+    this->reader = nullptr;
+    this->file.deleteFile();
+}
+
+double FrozenAudio::getSampleRate() const noexcept
+{
+    return this->reader->sampleRate;
+}
+
+void FrozenAudio::read(AudioBuffer<float> &buffer, int startSample,
+    int numSamples, int64 position) const noexcept
+{
+    // reads the mapped data directly, and fills the rest with zeros,
+    // for stereo buffers this doesn't allocate or touch the file
+    this->reader->read(&buffer, startSample, numSamples, position, true, true);
+}
@@ -0,0 +1,59 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+class Instrument;
+
+/*
+    The pre-rendered output of a frozen instrument, streamed during
+    the playback instead of processing the instrument's graph: it is
+    rendered offline for the whole project, starting from its first beat,
+    into a float wav file, which is then memory-mapped as a whole, so
+    that reading it on the audio thread is just copying the samples.
+
+    The file is temporary and is deleted along with the last reference.
+*/
+
+class FrozenAudio final : public ReferenceCountedObject
+{
+public:
+
+    using Ptr = ReferenceCountedObjectPtr<FrozenAudio>;
+    using Map = FlatHashMap<const Instrument *, Ptr>;
+
+    // Returns nullptr, if the file cannot be mapped into memory
+    static Ptr createFrom(const File &file);
+
+    ~FrozenAudio() override;
+
+    double getSampleRate() const noexcept;
+
+    // Position is the number of samples since the project start,
+    // anything outside the rendered range is read as silence
+    void read(AudioBuffer<float> &buffer, int startSample,
+        int numSamples, int64 position) const noexcept;
+
+private:
+
+    FrozenAudio() = default;
+
+    File file;
+    UniquePointer<MemoryMappedAudioFormatReader> reader;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(FrozenAudio)
+};
@@ -0,0 +1,124 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Common.h"
+#include "HardwareMidiOutput.h"
+
+// the messages are stamped at least one device buffer ahead,
+// so polling this often is enough to hand them over in time,
+// and the audio thread never has to signal anything
+#define HARDWARE_MIDI_OUTPUT_POLL_MS 2
+
+// the sample rate for the blocks sent to the device,
+// so that their sample positions are just microseconds
+#define HARDWARE_MIDI_OUTPUT_TIME_RESOLUTION 1000000.0
+
+HardwareMidiOutput::HardwareMidiOutput(UniquePointer<MidiOutput> device) :
+    Thread("HardwareMidiOutput"),
+    device(std::move(device))
+{
+    this->device->startBackgroundThread();
+    this->startThread(9);
+}
+
+HardwareMidiOutput::~HardwareMidiOutput()
+{
+    this->stopThread(HARDWARE_MIDI_OUTPUT_POLL_MS * 100);
+    this->device->stopBackgroundThread();
+    this->device->clearAllPendingMessages();
+}
+
+StringArray HardwareMidiOutput::getAvailableDevices()
+{
+    return MidiOutput::getDevices();
+}
+
+UniquePointer<HardwareMidiOutput> HardwareMidiOutput::open(const String &deviceName)
+{
+    const auto deviceIndex = MidiOutput::getDevices().indexOf(deviceName);
+    if (deviceIndex < 0)
+    {
+        DBG("MIDI output device not found: " + deviceName);
+        return {};
+    }
+
+    UniquePointer<MidiOutput> device(MidiOutput::openDevice(deviceIndex));
+    if (device == nullptr)
+    {
+        DBG("Failed to open MIDI output device: " + deviceName);
+        return {};
+    }
+
+    return UniquePointer<HardwareMidiOutput>(new HardwareMidiOutput(std::move(device)));
+}
+
+String HardwareMidiOutput::getDeviceName() const
+{
+    return this->device->getName();
+}
+
+void HardwareMidiOutput::addBlock(const MidiBuffer &buffer,
+    double blockTimeMs, double sampleRate) noexcept
+{
+    const uint8 *data;
+    int size, samplePosition;
+    MidiBuffer::Iterator it(buffer);
+    while (it.getNextEvent(data, size, samplePosition))
+    {
+        const double timeMs = blockTimeMs + double(samplePosition) / sampleRate * 1000.0;
+        if (!this->queue.push(data, size, timeMs))
+        {
+            // either full, or it's a sysex too long for the queue;
+            // dropping it is still better than blocking the audio thread
+            jassertfalse;
+        }
+    }
+}
+
+void HardwareMidiOutput::run()
+{
+    while (!this->threadShouldExit())
+    {
+        this->wait(HARDWARE_MIDI_OUTPUT_POLL_MS);
+
+        double blockStartMs = 0.0;
+        this->pendingBlock.clear();
+        this->queue.popAll([this, &blockStartMs](const uint8 *data, int size, double timeMs)
+        {
+            if (this->pendingBlock.isEmpty())
+            {
+                blockStartMs = timeMs;
+            }
+
+            const auto position = (timeMs - blockStartMs) / 1000.0 * HARDWARE_MIDI_OUTPUT_TIME_RESOLUTION;
+            this->pendingBlock.addEvent(data, size, jmax(0, int(position)));
+        });
+
+        if (this->pendingBlock.isEmpty())
+        {
+            continue;
+        }
+
+        // the timestamps are by the high-resolution counter,
+        // but the device's thread waits by the millisecond counter
+        const double startMs = blockStartMs - Time::getMillisecondCounterHiRes() +
+            double(Time::getMillisecondCounter());
+
+        this->device->sendBlockOfMessages(this->pendingBlock,
+            startMs, HARDWARE_MIDI_OUTPUT_TIME_RESOLUTION);
+    }
+}
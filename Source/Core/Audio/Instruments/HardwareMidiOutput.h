@@ -0,0 +1,64 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "MidiEventQueue.h"
+
+/*
+    Sends whatever reaches the midi output node of an instrument's graph
+    to a hardware midi output device, so that the external synths
+    can be played directly, without any plugin in between.
+
+    The audio thread only pushes the block's messages into a lock-free queue,
+    each stamped with the system time at which that block will be heard,
+    and this thread hands them over to the device ahead of their time,
+    so the hardware timing follows the audio clock instead of the moments
+    when any of the threads happen to wake up.
+
+    JUCE doesn't expose the OS-level timestamped midi APIs, so the closest
+    thing is MidiOutput::sendBlockOfMessages, which is timed by the device's
+    own background thread, and which never runs on the audio thread here.
+*/
+
+class HardwareMidiOutput final : private Thread
+{
+public:
+
+    ~HardwareMidiOutput() override;
+
+    static StringArray getAvailableDevices();
+    static UniquePointer<HardwareMidiOutput> open(const String &deviceName);
+
+    String getDeviceName() const;
+
+    // Called from the audio thread, with the messages of a block
+    // which will be heard at the given system time
+    void addBlock(const MidiBuffer &buffer, double blockTimeMs, double sampleRate) noexcept;
+
+private:
+
+    explicit HardwareMidiOutput(UniquePointer<MidiOutput> device);
+
+    void run() override;
+
+    UniquePointer<MidiOutput> device;
+    MidiEventQueue queue;
+    MidiBuffer pendingBlock;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(HardwareMidiOutput)
+};
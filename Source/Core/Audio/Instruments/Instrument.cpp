@@ -17,11 +17,24 @@
 
 #include "Common.h"
 #include "Instrument.h"
+#include "RealtimeSafety.h"
 #include "PluginWindow.h"
 #include "InternalPluginFormat.h"
 #include "SerializablePluginDescription.h"
 #include "SerializationKeys.h"
 
+// below this level the output is considered silent
+#define INSTRUMENT_IDLE_SILENCE_LEVEL 0.00001f
+// some plugins report zero tails and still ring out a bit
+#define INSTRUMENT_IDLE_MIN_TAIL_SECONDS 0.5
+// and some report infinite tails, which we don't trust either
+#define INSTRUMENT_IDLE_MAX_TAIL_SECONDS 60.0
+
+// the rolling average's weight of the most recent block
+#define INSTRUMENT_LOAD_AVERAGE_WEIGHT 0.05f
+// the max falls off slowly, so that it shows the recent spikes only
+#define INSTRUMENT_LOAD_MAX_DECAY 0.999f
+
 const int Instrument::midiChannelNumber = 0x1000;
 
 Instrument::Instrument(AudioPluginFormatManager &formatManager, const String &name) :
@@ -36,6 +49,7 @@ Instrument::Instrument(AudioPluginFormatManager &formatManager, const String &na
 Instrument::~Instrument()
 {
     this->audioCallback.setProcessor(nullptr);
+    this->audioCallback.setHardwareMidiOutput(nullptr);
     
     PluginWindow::closeAllCurrentlyOpenWindows();
 
@@ -82,6 +96,11 @@ bool Instrument::isValid() const noexcept
     return this->instrumentName.isNotEmpty();
 }
 
+bool Instrument::isLoading() const noexcept
+{
+    return this->numNodesLoading > 0;
+}
+
 void Instrument::initializeFrom(const PluginDescription &pluginDescription, InitializationCallback initCallback)
 {
     this->processorGraph->clear();
@@ -91,6 +110,8 @@ void Instrument::initializeFrom(const PluginDescription &pluginDescription, Init
         {
             if (instrument == nullptr) { return; }
 
+            const GraphEdit edit(*this);
+
             InternalPluginFormat f;
             auto audioIn = this->addNode(*f.getDescriptionFor(InternalPluginFormat::audioInputFilter), 0.1f, 0.15f);
             auto audioOut = this->addNode(*f.getDescriptionFor(InternalPluginFormat::audioOutputFilter), 0.9f, 0.15f);
@@ -118,7 +139,7 @@ void Instrument::initializeFrom(const PluginDescription &pluginDescription, Init
             }
 
             initCallback(this);
-            this->sendChangeMessage();
+            this->sendGraphChangeMessage();
         });
 }
 
@@ -158,6 +179,118 @@ const AudioProcessorGraph::Node::Ptr Instrument::getNodeForId(AudioProcessorGrap
     return this->processorGraph->getNodeForId(uid);
 }
 
+double Instrument::getTailLengthSeconds() const
+{
+    double result = 0.0;
+    for (const auto *node : this->processorGraph->getNodes())
+    {
+        result = jmax(result, node->getProcessor()->getTailLengthSeconds());
+    }
+
+    return result;
+}
+
+String Instrument::getMidiOutputDevice() const noexcept
+{
+    return this->midiOutputDevice;
+}
+
+void Instrument::setMidiOutputDevice(const String &deviceName)
+{
+    if (this->midiOutputDevice == deviceName)
+    {
+        return;
+    }
+
+    this->midiOutputDevice = deviceName;
+    this->audioCallback.setHardwareMidiOutput(deviceName.isEmpty() ?
+        nullptr : HardwareMidiOutput::open(deviceName));
+
+    this->sendChangeMessage();
+}
+
+//===----------------------------------------------------------------------===//
+// Mixer
+//===----------------------------------------------------------------------===//
+
+bool Instrument::isEffectBus() const noexcept
+{
+    return this->effectBus;
+}
+
+void Instrument::setEffectBus(bool shouldBeBus)
+{
+    if (this->effectBus == shouldBeBus)
+    {
+        return;
+    }
+
+    this->effectBus = shouldBeBus;
+
+    // the buses don't send to each other, so that each is processed only once
+    if (shouldBeBus)
+    {
+        this->sends.clearQuick();
+    }
+
+    if (this->onRoutingChanged != nullptr)
+    {
+        this->onRoutingChanged();
+    }
+
+    this->sendChangeMessage();
+}
+
+const Array<Instrument::Send> &Instrument::getSends() const noexcept
+{
+    return this->sends;
+}
+
+float Instrument::getSendLevel(const String &busId) const noexcept
+{
+    for (const auto &send : this->sends)
+    {
+        if (send.busId == busId)
+        {
+            return send.level;
+        }
+    }
+
+    return 0.f;
+}
+
+void Instrument::setSendLevel(const String &busId, float level)
+{
+    jassert(!this->effectBus);
+
+    const auto newLevel = jlimit(0.f, 1.f, level);
+    if (this->getSendLevel(busId) == newLevel)
+    {
+        return;
+    }
+
+    for (int i = 0; i < this->sends.size(); ++i)
+    {
+        if (this->sends.getReference(i).busId == busId)
+        {
+            this->sends.remove(i);
+            break;
+        }
+    }
+
+    if (newLevel > 0.f)
+    {
+        this->sends.add({ busId, newLevel });
+    }
+
+    if (this->onRoutingChanged != nullptr)
+    {
+        this->onRoutingChanged();
+    }
+
+    this->sendChangeMessage();
+}
+
 void Instrument::addNodeAsync(const PluginDescription &desc, double x, double y, AddNodeCallback f)
 {
     const auto callback = [this, desc, x, y, f](UniquePointer<AudioPluginInstance> instance, const String &error)
@@ -188,29 +321,37 @@ void Instrument::addNodeAsync(const PluginDescription &desc, double x, double y,
 void Instrument::removeNode(AudioProcessorGraph::NodeID id)
 {
     PluginWindow::closeCurrentlyOpenWindowsFor(id);
+    this->disconnectNode(id);
     this->processorGraph->removeNode(id);
-    this->sendChangeMessage();
+    this->sendGraphChangeMessage();
 }
 
 void Instrument::disconnectNode(AudioProcessorGraph::NodeID id)
 {
+    // the queued connections of this node are discarded as well
+    this->connectionsToAdd.removeIf([id](const AudioProcessorGraph::Connection &c)
+    {
+        return c.source.nodeID == id || c.destination.nodeID == id;
+    });
+
     this->processorGraph->disconnectNode(id);
-    this->sendChangeMessage();
+    this->sendGraphChangeMessage();
 }
 
 void Instrument::removeAllConnectionsForNode(AudioProcessorGraph::Node::Ptr node)
 {
-    for (const auto &c : this->getConnections())
-    {
-        if (c.source.nodeID == node->nodeID || c.destination.nodeID == node->nodeID)
-        {
-            this->removeConnection(c);
-        }
-    }
+    // a single topology change instead of one per connection
+    this->disconnectNode(node->nodeID);
 }
 
 void Instrument::removeIllegalConnections()
 {
+    if (this->numGraphEdits > 0)
+    {
+        this->graphEditNeedsLegalityCheck = true;
+        return;
+    }
+
     this->processorGraph->removeIllegalConnections();
     this->sendChangeMessage();
 }
@@ -390,6 +531,21 @@ bool Instrument::addConnection(AudioProcessorGraph::NodeID sourceID, int sourceC
     destination.channelIndex = destinationChannel;
 
     AudioProcessorGraph::Connection c(source, destination);
+
+    if (this->numGraphEdits > 0)
+    {
+        if (this->processorGraph->getNodeForId(sourceID) == nullptr ||
+            this->processorGraph->getNodeForId(destinationID) == nullptr)
+        {
+            return false;
+        }
+
+        this->connectionsToRemove.removeFirstMatchingValue(c);
+        this->connectionsToAdd.addIfNotAlreadyThere(c);
+        this->graphEditHasChanges = true;
+        return true;
+    }
+
     if (this->processorGraph->addConnection(c))
     {
         this->sendChangeMessage();
@@ -401,12 +557,94 @@ bool Instrument::addConnection(AudioProcessorGraph::NodeID sourceID, int sourceC
 
 void Instrument::removeConnection(AudioProcessorGraph::Connection connection)
 {
+    if (this->numGraphEdits > 0)
+    {
+        if (!this->connectionsToAdd.contains(connection))
+        {
+            this->connectionsToRemove.addIfNotAlreadyThere(connection);
+        }
+
+        this->connectionsToAdd.removeFirstMatchingValue(connection);
+        this->graphEditHasChanges = true;
+        return;
+    }
+
     this->processorGraph->removeConnection(connection);
     this->sendChangeMessage();
 }
 
+//===----------------------------------------------------------------------===//
+// Graph edits
+//===----------------------------------------------------------------------===//
+
+Instrument::GraphEdit::GraphEdit(Instrument &instrument) noexcept :
+    instrument(instrument)
+{
+    this->instrument.numGraphEdits++;
+}
+
+Instrument::GraphEdit::~GraphEdit()
+{
+    jassert(this->instrument.numGraphEdits > 0);
+    if (--this->instrument.numGraphEdits == 0)
+    {
+        this->instrument.commitGraphEdit();
+    }
+}
+
+void Instrument::sendGraphChangeMessage()
+{
+    if (this->numGraphEdits > 0)
+    {
+        this->graphEditHasChanges = true;
+        return;
+    }
+
+    this->sendChangeMessage();
+}
+
+// all changes are applied within one message thread call, so the graph's
+// deferred update only rebuilds the rendering sequence once for all of them
+void Instrument::commitGraphEdit()
+{
+    for (const auto &c : this->connectionsToRemove)
+    {
+        this->processorGraph->removeConnection(c);
+    }
+
+    for (const auto &c : this->connectionsToAdd)
+    {
+        this->processorGraph->addConnection(c);
+    }
+
+    if (this->graphEditNeedsLegalityCheck)
+    {
+        this->processorGraph->removeIllegalConnections();
+    }
+
+    const bool hasChanges = this->graphEditHasChanges ||
+        this->graphEditNeedsLegalityCheck ||
+        !this->connectionsToRemove.isEmpty() ||
+        !this->connectionsToAdd.isEmpty();
+
+    this->connectionsToRemove.clearQuick();
+    this->connectionsToAdd.clearQuick();
+    this->graphEditHasChanges = false;
+    this->graphEditNeedsLegalityCheck = false;
+
+    if (hasChanges)
+    {
+        this->sendChangeMessage();
+    }
+}
+
 void Instrument::reset()
 {
+    // discard the nodes still being loaded, if any
+    this->loadingGeneration++;
+    this->numNodesLoading = 0;
+    this->nodeStateHashes.clear();
+
     PluginWindow::closeAllCurrentlyOpenWindows();
     this->processorGraph->clear();
     this->instrumentName.clear();
@@ -425,6 +663,24 @@ SerializedData Instrument::serialize() const
     tree.setProperty(Audio::instrumentId, this->instrumentId.toString());
     tree.setProperty(Audio::instrumentName, this->instrumentName);
 
+    if (this->midiOutputDevice.isNotEmpty())
+    {
+        tree.setProperty(Audio::midiOutputDevice, this->midiOutputDevice);
+    }
+
+    if (this->effectBus)
+    {
+        tree.setProperty(Audio::effectBus, true);
+    }
+
+    for (const auto &send : this->sends)
+    {
+        SerializedData e(Audio::send);
+        e.setProperty(Audio::sendBusId, send.busId);
+        e.setProperty(Audio::sendLevel, send.level);
+        tree.appendChild(e);
+    }
+
     const int numNodes = this->processorGraph->getNumNodes();
     for (int i = 0; i < numNodes; ++i)
     {
@@ -463,7 +719,9 @@ SerializedData Instrument::serializeNode(AudioProcessorGraph::Node::Ptr node) co
 
         MemoryBlock m;
         node->getProcessor()->getStateInformation(m);
-        tree.setProperty(Serialization::Audio::pluginState, m.toBase64Encoding());
+        const auto state = m.toBase64Encoding();
+        tree.setProperty(Serialization::Audio::pluginState, state);
+        this->nodeStateHashes[node->nodeID.uid] = state.hashCode64();
 
         return tree;
     }
@@ -473,12 +731,37 @@ SerializedData Instrument::serializeNode(AudioProcessorGraph::Node::Ptr node) co
 
 void Instrument::deserialize(const SerializedData &data)
 {
-    this->reset();
     using namespace Serialization;
 
     const auto root = data.hasType(Audio::instrument) ?
         data : data.getChildWithName(Audio::instrument);
 
+    this->setMidiOutputDevice(root.getProperty(Audio::midiOutputDevice).toString());
+
+    this->effectBus = root.getProperty(Audio::effectBus, false);
+    this->sends.clearQuick();
+    forEachChildWithType(root, e, Audio::send)
+    {
+        const float level = e.getProperty(Audio::sendLevel, 0.f);
+        if (!this->effectBus && level > 0.f)
+        {
+            this->sends.add({ e.getProperty(Audio::sendBusId).toString(), level });
+        }
+    }
+
+    if (this->onRoutingChanged != nullptr)
+    {
+        this->onRoutingChanged();
+    }
+
+    if (this->canDeserializeInPlace(root))
+    {
+        this->deserializeInPlace(root);
+        return;
+    }
+
+    this->reset();
+
     if (!root.isValid() || root.getNumChildren() == 0) { return; }
 
     this->instrumentId = root.getProperty(Audio::instrumentId, this->instrumentId.toString());
@@ -519,6 +802,8 @@ void Instrument::deserialize(const SerializedData &data)
 
     this->deserializeNodesAsync(nodesToDeserialize, [this, connectionDescriptions]()
     {
+        const GraphEdit edit(*this);
+
         for (const auto &connectionInfo : connectionDescriptions)
         {
             this->addConnection(AudioProcessorGraph::NodeID(connectionInfo.sourceNodeId),
@@ -527,8 +812,7 @@ void Instrument::deserialize(const SerializedData &data)
                 connectionInfo.destinationChannel);
         }
 
-        this->processorGraph->removeIllegalConnections();
-        this->sendChangeMessage();
+        this->removeIllegalConnections();
     });
 }
 
@@ -536,65 +820,224 @@ void Instrument::deserializeNodesAsync(Array<SerializedData> nodesToDeserialize,
     DeserializeNodesCallback allDoneCallback)
 {
     using namespace Serialization;
+
+    const auto generation = ++this->loadingGeneration;
+    this->numNodesLoading = nodesToDeserialize.size();
+
     if (nodesToDeserialize.isEmpty())
     {
         allDoneCallback();
         return;
     }
 
-    const auto tree = nodesToDeserialize.removeAndReturn(0);
+    const WeakReference<Instrument> weakThis(this);
+
+    const auto callback = [weakThis, generation, allDoneCallback]
+        (const SerializedData &tree, UniquePointer<AudioPluginInstance> instance)
+    {
+        if (weakThis == nullptr || weakThis->loadingGeneration != generation)
+        {
+            return; // deleted or reset while loading
+        }
+
+        if (instance != nullptr)
+        {
+            weakThis->deserializeNode(tree, std::move(instance));
+        }
+
+        weakThis->numNodesLoading--;
+
+        if (weakThis->onNodeLoaded != nullptr)
+        {
+            weakThis->onNodeLoaded();
+        }
+
+        if (weakThis->numNodesLoading == 0)
+        {
+            allDoneCallback();
+        }
+    };
+
+    // The nodes don't depend on each other, since their ids are known
+    // beforehand, and the connections are only restored when all are done;
+    // each instance is requested in a separate message, so that the message
+    // loop keeps running in between, and the formats which load their plugins
+    // asynchronously get all requests at the same time instead of one by one;
+    // the formats which need the message thread are still created on it
+    for (const auto &tree : nodesToDeserialize)
+    {
+        SerializablePluginDescription pd;
+        for (const auto &e : tree)
+        {
+            pd.deserialize(e);
+            if (pd.isValid()) { break; }
+        }
+
+        MessageManager::callAsync([weakThis, generation, pd, tree, callback]()
+        {
+            if (weakThis == nullptr || weakThis->loadingGeneration != generation)
+            {
+                return;
+            }
+
+            weakThis->formatManager.createPluginInstanceAsync(pd,
+                weakThis->processorGraph->getSampleRate(),
+                weakThis->processorGraph->getBlockSize(),
+                [tree, callback](UniquePointer<AudioPluginInstance> instance, const String &error)
+                {
+                    callback(tree, std::move(instance));
+                });
+        });
+    }
+}
+
+void Instrument::deserializeNode(const SerializedData &tree, UniquePointer<AudioPluginInstance> instance)
+{
+    using namespace Serialization;
 
-    SerializablePluginDescription pd;
-    for (const auto &e : tree)
+    MemoryBlock nodeStateBlock;
+    const String state = tree.getProperty(Audio::pluginState);
+    if (state.isNotEmpty())
     {
-        pd.deserialize(e);
-        if (pd.isValid()) { break; }
+        nodeStateBlock.fromBase64Encoding(state);
     }
-    
-    const auto callback = [this, nodesToDeserialize, tree, allDoneCallback]
-    (UniquePointer<AudioPluginInstance> instance, const String &error)
+
+    const uint32 nodeUid = int(tree.getProperty(Audio::nodeId));
+    const String nodeHash = tree.getProperty(Audio::nodeHash);
+    const double nodeX = tree.getProperty(UI::positionX);
+    const double nodeY = tree.getProperty(UI::positionY);
+
+    AudioProcessorGraph::NodeID nodeId(nodeUid);
+    AudioProcessorGraph::Node::Ptr node(this->processorGraph->addNode(std::move(instance), nodeId));
+    if (node == nullptr)
+    {
+        return;
+    }
+
+    if (nodeStateBlock.getSize() > 0)
+    {
+        node->getProcessor()->
+            setStateInformation(nodeStateBlock.getData(),
+                static_cast<int>(nodeStateBlock.getSize()));
+
+        this->nodeStateHashes[nodeUid] = state.hashCode64();
+    }
+
+    Uuid fallbackRandomHash;
+    const auto hash = nodeHash.isNotEmpty() ? nodeHash : fallbackRandomHash.toString();
+    node->properties.set(Audio::nodeHash, hash);
+    node->properties.set(UI::positionX, nodeX);
+    node->properties.set(UI::positionY, nodeY);
+}
+
+bool Instrument::canDeserializeInPlace(const SerializedData &root) const
+{
+    using namespace Serialization;
+
+    if (!root.isValid() || this->isLoading())
     {
-        if (instance == nullptr)
+        return false;
+    }
+
+    if (this->instrumentId.toString() != root.getProperty(Audio::instrumentId).toString())
+    {
+        return false;
+    }
+
+    int numNodes = 0;
+    forEachChildWithType(root, e, Audio::node)
+    {
+        numNodes++;
+
+        const AudioProcessorGraph::NodeID nodeId(uint32(int(e.getProperty(Audio::nodeId))));
+        const auto node = this->processorGraph->getNodeForId(nodeId);
+        auto *plugin = node != nullptr ? dynamic_cast<AudioPluginInstance *>(node->getProcessor()) : nullptr;
+        if (plugin == nullptr)
         {
-            this->deserializeNodesAsync(nodesToDeserialize, allDoneCallback);
-            return;
+            return false;
         }
 
-        MemoryBlock nodeStateBlock;
-        const String state = tree.getProperty(Audio::pluginState);
-        if (state.isNotEmpty())
+        SerializablePluginDescription incoming;
+        for (const auto &d : e)
         {
-            nodeStateBlock.fromBase64Encoding(state);
+            incoming.deserialize(d);
+            if (incoming.isValid()) { break; }
         }
 
-        const uint32 nodeUid = int(tree.getProperty(Audio::nodeId));
-        const String nodeHash = tree.getProperty(Audio::nodeHash);
-        const double nodeX = tree.getProperty(UI::positionX);
-        const double nodeY = tree.getProperty(UI::positionY);
+        PluginDescription live;
+        plugin->fillInPluginDescription(live);
+        if (!live.isDuplicateOf(incoming))
+        {
+            return false;
+        }
+    }
 
-        AudioProcessorGraph::NodeID nodeId(nodeUid);
-        AudioProcessorGraph::Node::Ptr node(this->processorGraph->addNode(std::move(instance), nodeId));
+    return numNodes > 0 && numNodes == this->processorGraph->getNumNodes();
+}
 
-        if (nodeStateBlock.getSize() > 0)
+void Instrument::deserializeInPlace(const SerializedData &root)
+{
+    using namespace Serialization;
+
+    this->instrumentName = root.getProperty(Audio::instrumentName, this->instrumentName);
+
+    forEachChildWithType(root, e, Audio::node)
+    {
+        const uint32 nodeUid = int(e.getProperty(Audio::nodeId));
+        const auto node = this->processorGraph->getNodeForId(AudioProcessorGraph::NodeID(nodeUid));
+        jassert(node != nullptr);
+
+        const String state = e.getProperty(Audio::pluginState);
+        if (state.isNotEmpty())
         {
-            node->getProcessor()->
-                setStateInformation(nodeStateBlock.getData(),
+            // the cached hash is checked first, so that only the nodes which are likely
+            // to be left as they are, are asked for their current state to make sure
+            const auto stateHash = state.hashCode64();
+            const auto cachedHash = this->nodeStateHashes.find(nodeUid);
+            bool isUpToDate = false;
+            if (cachedHash != this->nodeStateHashes.end() && cachedHash->second == stateHash)
+            {
+                MemoryBlock liveState;
+                node->getProcessor()->getStateInformation(liveState);
+                isUpToDate = liveState.toBase64Encoding().hashCode64() == stateHash;
+            }
+
+            if (!isUpToDate)
+            {
+                MemoryBlock nodeStateBlock;
+                nodeStateBlock.fromBase64Encoding(state);
+                node->getProcessor()->setStateInformation(nodeStateBlock.getData(),
                     static_cast<int>(nodeStateBlock.getSize()));
+
+                this->nodeStateHashes[nodeUid] = stateHash;
+            }
         }
 
-        Uuid fallbackRandomHash;
-        const auto hash = nodeHash.isNotEmpty() ? nodeHash : fallbackRandomHash.toString();
-        node->properties.set(Audio::nodeHash, hash);
-        node->properties.set(UI::positionX, nodeX);
-        node->properties.set(UI::positionY, nodeY);
+        node->properties.set(UI::positionX, double(e.getProperty(UI::positionX)));
+        node->properties.set(UI::positionY, double(e.getProperty(UI::positionY)));
+    }
 
-        this->deserializeNodesAsync(nodesToDeserialize, allDoneCallback);
-    };
+    // the connections which are there both before and after
+    // are just left untouched, so the graph would only rebuild once
+    const GraphEdit edit(*this);
 
-    formatManager.createPluginInstanceAsync(pd,
-        this->processorGraph->getSampleRate(),
-        this->processorGraph->getBlockSize(),
-        callback);
+    for (const auto &c : this->getConnections())
+    {
+        this->removeConnection(c);
+    }
+
+    forEachChildWithType(root, e, Audio::connection)
+    {
+        const uint32 sourceNodeId = static_cast<int>(e.getProperty(Audio::sourceNodeId));
+        const uint32 destinationNodeId = static_cast<int>(e.getProperty(Audio::destinationNodeId));
+        this->addConnection(AudioProcessorGraph::NodeID(sourceNodeId),
+            e.getProperty(Audio::sourceChannel),
+            AudioProcessorGraph::NodeID(destinationNodeId),
+            e.getProperty(Audio::destinationChannel));
+    }
+
+    this->removeIllegalConnections();
+    this->sendGraphChangeMessage();
 }
 
 AudioProcessorGraph::Node::Ptr Instrument::addNode(const PluginDescription &desc, double x, double y)
@@ -615,7 +1058,7 @@ AudioProcessorGraph::Node::Ptr Instrument::addNode(const PluginDescription &desc
     if (node != nullptr)
     {
         this->configureNode(node, desc, x, y);
-        this->sendChangeMessage();
+        this->sendGraphChangeMessage();
         return node;
     }
     
@@ -668,14 +1111,92 @@ void Instrument::AudioCallback::setProcessor(AudioProcessor *const newOne)
     }
 }
 
+void Instrument::AudioCallback::setIdleMode(bool shouldBeIdle, double tailLengthSeconds)
+{
+    const auto tail = jlimit(INSTRUMENT_IDLE_MIN_TAIL_SECONDS,
+        INSTRUMENT_IDLE_MAX_TAIL_SECONDS, tailLengthSeconds);
+
+    this->idleTailSamples = int64(tail * jmax(this->sampleRate, 44100.0));
+    this->idleMode = shouldBeIdle;
+}
+
+bool Instrument::AudioCallback::isSilent(const float *const *channelData,
+    int numChannels, int numSamples) const noexcept
+{
+    for (int i = 0; i < numChannels; ++i)
+    {
+        const auto range = FloatVectorOperations::findMinAndMax(channelData[i], numSamples);
+        if (jmax(-range.getStart(), range.getEnd()) > INSTRUMENT_IDLE_SILENCE_LEVEL)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+Instrument::AudioCallback::ProcessingLoad Instrument::AudioCallback::getProcessingLoad() const noexcept
+{
+    ProcessingLoad load;
+    load.averageMicroseconds = this->averageMicroseconds.get();
+    load.maxMicroseconds = this->maxMicroseconds.get();
+    load.bufferPercent = this->averageBufferPercent.get();
+    return load;
+}
+
+// Only the audio thread writes these, so there's no need for anything
+// fancier than relaxed atomic stores; the readers may see the values
+// from different blocks, which is fine for what is basically a meter
+void Instrument::AudioCallback::updateProcessingLoad(int64 startTicks, int numSamples) noexcept
+{
+    const auto elapsedTicks = Time::getHighResolutionTicks() - startTicks;
+    const auto elapsedUs = float(Time::highResolutionTicksToSeconds(elapsedTicks) * 1000000.0);
+    const auto bufferUs = float(numSamples / this->sampleRate * 1000000.0);
+
+    const auto average = this->averageMicroseconds.get();
+    const auto newAverage = average + (elapsedUs - average) * INSTRUMENT_LOAD_AVERAGE_WEIGHT;
+    this->averageMicroseconds = newAverage;
+    this->maxMicroseconds = jmax(elapsedUs, this->maxMicroseconds.get() * INSTRUMENT_LOAD_MAX_DECAY);
+    this->averageBufferPercent = bufferUs > 0.f ? (newAverage / bufferUs * 100.f) : 0.f;
+}
+
 void Instrument::AudioCallback::audioDeviceIOCallback(const float** const inputChannelData,
     const int numInputChannels, float **const outputChannelData,
     const int numOutputChannels, const int numSamples)
 {
+    REALTIME_SCOPE("Instrument::AudioCallback::audioDeviceIOCallback");
+    const ScopedNoDenormals noDenormals;
     jassert(this->sampleRate > 0 && this->blockSize > 0);
 
+    const auto blockStartTimeMs = Time::getMillisecondCounterHiRes();
+
     this->incomingMidi.clear();
     this->messageCollector.removeNextBlockOfMessages(this->incomingMidi, numSamples);
+    this->eventQueue.popNextBlock(this->incomingMidi, numSamples, this->sampleRate);
+    this->previewQueue.popNextBlock(this->incomingMidi, numSamples, this->sampleRate);
+
+    const bool isIdle = this->idleMode.get();
+    if (!isIdle)
+    {
+        this->numSilentSamples = 0;
+    }
+    else if (this->incomingMidi.isEmpty() &&
+        this->numSilentSamples > this->idleTailSamples.get() &&
+        this->isSilent(inputChannelData, numInputChannels, numSamples))
+    {
+        // the tail has decayed, nothing is going to play, and there's
+        // no audio input (e.g. the sends into an effect bus), so there's
+        // no point in waking up the whole graph:
+        for (int i = 0; i < numOutputChannels; ++i)
+        {
+            FloatVectorOperations::clear(outputChannelData[i], numSamples);
+        }
+
+        // let the meters fall off to zero
+        this->updateProcessingLoad(Time::getHighResolutionTicks(), numSamples);
+        return;
+    }
+
     int totalNumChans = 0;
 
     if (numInputChannels > numOutputChannels)
@@ -716,15 +1237,42 @@ void Instrument::AudioCallback::audioDeviceIOCallback(const float** const inputC
     AudioBuffer<float> buffer(this->channels, totalNumChans, numSamples);
 
     {
-        const ScopedLock sl(lock);
+        REALTIME_SCOPED_LOCK(this->lock);
+
+        this->renderScheduledEvents(numSamples);
+
+        if (this->scheduleLane != nullptr && this->scheduleLane->frozenAudio != nullptr &&
+            this->scheduleHasStarted && !this->scheduleHasFinished)
+        {
+            this->renderFrozenAudio(buffer, numSamples);
+            return;
+        }
 
         if (this->processor != nullptr)
         {
-            const ScopedLock sl2(this->processor->getCallbackLock());
+            REALTIME_SCOPED_LOCK(this->processor->getCallbackLock());
 
             if (!this->processor->isSuspended())
             {
+                const bool hadMidi = !this->incomingMidi.isEmpty();
+                const auto startTicks = Time::getHighResolutionTicks();
                 this->processor->processBlock(buffer, this->incomingMidi);
+                this->updateProcessingLoad(startTicks, numSamples);
+
+                // now it's whatever has reached the graph's midi output
+                if (this->hardwareMidiOutput != nullptr && !this->incomingMidi.isEmpty())
+                {
+                    this->hardwareMidiOutput->addBlock(this->incomingMidi,
+                        blockStartTimeMs + this->outputLatencyMs, this->sampleRate);
+                }
+
+                if (isIdle)
+                {
+                    const bool isSilent = !hadMidi &&
+                        this->isSilent(outputChannelData, numOutputChannels, numSamples);
+                    this->numSilentSamples = isSilent ? this->numSilentSamples + numSamples : 0;
+                }
+
                 return;
             }
         }
@@ -747,11 +1295,16 @@ void Instrument::AudioCallback::audioDeviceAboutToStart(AudioIODevice* const dev
 
     this->sampleRate = newSampleRate;
     this->blockSize = newBlockSize;
+
+    // this block will be heard after the one being played now
+    this->outputLatencyMs = double(device->getOutputLatencyInSamples() + newBlockSize) /
+        newSampleRate * 1000.0;
     this->numInputChans = numChansIn;
     this->numOutputChans = numChansOut;
 
     this->messageCollector.reset(sampleRate);
     this->channels.calloc(jmax(numChansIn, numChansOut) + 2);
+    this->incomingMidi.ensureSize(4096);
 
     if (this->processor != nullptr)
     {
@@ -785,3 +1338,343 @@ void Instrument::AudioCallback::handleIncomingMidiMessage(MidiInput *, const Mid
 {
     this->messageCollector.addMessageToQueue(message);
 }
+
+void Instrument::AudioCallback::addMessageToQueue(const MidiMessage &message)
+{
+    if (!this->eventQueue.push(message))
+    {
+        this->messageCollector.addMessageToQueue(message);
+    }
+}
+
+void Instrument::AudioCallback::setHardwareMidiOutput(UniquePointer<HardwareMidiOutput> output)
+{
+    // the old one will be released here, not on the audio thread
+    {
+        const ScopedLock sl(this->lock);
+        std::swap(this->hardwareMidiOutput, output);
+    }
+}
+
+// The previews come from the message thread, but the sound-offs on playback stop
+// come from the player thread, so only the producers' side is serialized,
+// and the audio thread still reads the queue without locking
+void Instrument::AudioCallback::addPreviewMessage(const MidiMessage &message)
+{
+    const SpinLock::ScopedLockType lock(this->previewLock);
+    if (!this->previewQueue.push(message))
+    {
+        this->messageCollector.addMessageToQueue(message);
+    }
+}
+
+//===----------------------------------------------------------------------===//
+// Sample-accurate playback
+//===----------------------------------------------------------------------===//
+
+void Instrument::AudioCallback::setPlaybackSchedule(PlaybackSchedule::Ptr newSchedule, int laneIndex)
+{
+    // the old one will be released here, not on the audio thread
+    PlaybackSchedule::Ptr oldSchedule;
+
+    {
+        const ScopedLock sl(this->lock);
+        oldSchedule = this->schedule;
+        this->schedule = newSchedule;
+        this->scheduleLane = (newSchedule != nullptr) ? newSchedule->getLane(laneIndex) : nullptr;
+        this->nextScheduledEvent = 0;
+        this->scheduleLoopIteration = 0;
+        this->scheduleHasStarted = false;
+        this->scheduleHasFinished = false;
+        this->scheduleNeedsResync = false;
+    }
+}
+
+void Instrument::AudioCallback::updatePlaybackSchedule(PlaybackSchedule::Ptr newSchedule, int laneIndex)
+{
+    PlaybackSchedule::Ptr oldSchedule;
+
+    {
+        const ScopedLock sl(this->lock);
+        oldSchedule = this->schedule;
+        this->schedule = newSchedule;
+        this->scheduleLane = (newSchedule != nullptr) ? newSchedule->getLane(laneIndex) : nullptr;
+        // the cursor position will be found in the next block:
+        this->scheduleNeedsResync = this->scheduleHasStarted;
+    }
+}
+
+void Instrument::AudioCallback::renderFrozenAudio(AudioBuffer<float> &buffer, int numSamples)
+{
+    buffer.clear();
+
+    const auto *frozenAudio = this->scheduleLane->frozenAudio.get();
+    const auto length = this->schedule->getLengthInSamples();
+    const auto isLooped = this->schedule->isLooped();
+    const auto blockPosition = this->schedule->getBlockPosition();
+    const auto startPosition = this->schedule->getStartSamplePosition();
+
+    // the count-in may end somewhere within this block
+    int processed = int(jlimit(int64(0), int64(numSamples), -blockPosition));
+    while (processed < numSamples)
+    {
+        const auto position = blockPosition + processed;
+        const auto localPosition = isLooped ? (position % length) : position;
+        if (localPosition >= length)
+        {
+            break;
+        }
+
+        // in looped mode, the segment ends at the loop end, and the next one
+        // will start reading from the beginning of the range again
+        const auto segmentLength = int(jmin(int64(numSamples - processed), length - localPosition));
+        frozenAudio->read(buffer, processed, segmentLength, startPosition + localPosition);
+        processed += segmentLength;
+    }
+}
+
+void Instrument::AudioCallback::addScheduledEvent(const MidiMessage &message, int sampleOffset)
+{
+    this->incomingMidi.addEvent(message, sampleOffset);
+
+    if (message.isNoteOn())
+    {
+        auto &counter = this->holdingNotes[message.getChannel() - 1][message.getNoteNumber()];
+        if (counter < 255)
+        {
+            counter++;
+            this->numHoldingNotes++;
+        }
+    }
+    else if (message.isNoteOff())
+    {
+        auto &counter = this->holdingNotes[message.getChannel() - 1][message.getNoteNumber()];
+        if (counter > 0)
+        {
+            counter--;
+            this->numHoldingNotes--;
+        }
+    }
+}
+
+void Instrument::AudioCallback::releaseHoldingNotes(int sampleOffset)
+{
+    for (int channel = 0; channel < 16 && this->numHoldingNotes > 0; ++channel)
+    {
+        for (int key = 0; key < 128; ++key)
+        {
+            auto &counter = this->holdingNotes[channel][key];
+            if (counter > 0)
+            {
+                this->incomingMidi.addEvent(MidiMessage::noteOff(channel + 1, key), sampleOffset);
+                this->numHoldingNotes -= counter;
+                counter = 0;
+            }
+        }
+    }
+
+    this->numHoldingNotes = 0;
+}
+
+// After the schedule has been updated, some notes being played
+// may have lost their noteOff's (e.g. when a note was shortened
+// or moved back), so here we look ahead in the new lane, and release
+// the holding notes which are not going to get their noteOff's
+void Instrument::AudioCallback::releaseOrphanedNotes(int sampleOffset)
+{
+    if (this->numHoldingNotes == 0)
+    {
+        return;
+    }
+
+    uint8 checkedNotes[16][128] = {};
+    int numNotesToCheck = this->numHoldingNotes;
+
+    const auto &events = this->scheduleLane->events;
+    for (int i = this->nextScheduledEvent; i < events.size() && numNotesToCheck > 0; ++i)
+    {
+        const auto &message = events.getReference(i).message;
+        if (!message.isNoteOnOrOff())
+        {
+            continue;
+        }
+
+        const int channel = message.getChannel() - 1;
+        const int key = message.getNoteNumber();
+        auto &counter = this->holdingNotes[channel][key];
+        auto &checked = checkedNotes[channel][key];
+        if (counter == 0 || checked == counter)
+        {
+            continue;
+        }
+
+        if (message.isNoteOff())
+        {
+            // this one is fine
+            checked++;
+            numNotesToCheck--;
+        }
+        else
+        {
+            // the next noteOn comes first, so the rest of notes with this key will hang:
+            const auto numOrphans = counter - checked;
+            this->incomingMidi.addEvent(MidiMessage::noteOff(channel + 1, key), sampleOffset);
+            counter = checked;
+            this->numHoldingNotes -= numOrphans;
+            numNotesToCheck -= numOrphans;
+        }
+    }
+
+    if (numNotesToCheck == 0)
+    {
+        return;
+    }
+
+    for (int channel = 0; channel < 16; ++channel)
+    {
+        for (int key = 0; key < 128; ++key)
+        {
+            auto &counter = this->holdingNotes[channel][key];
+            const auto checked = checkedNotes[channel][key];
+            if (counter > checked)
+            {
+                this->incomingMidi.addEvent(MidiMessage::noteOff(channel + 1, key), sampleOffset);
+                this->numHoldingNotes -= (counter - checked);
+                counter = checked;
+            }
+        }
+    }
+}
+
+// The plugins with look-ahead report their latency, and the schedule
+// knows the future, so such instruments just get their events earlier
+int Instrument::AudioCallback::getScheduleLeadSamples() const noexcept
+{
+    const int latency = (this->processor != nullptr) ? this->processor->getLatencySamples() : 0;
+    return jmax(0, latency) + this->outputDelay;
+}
+
+// Called from the audio thread under the callback lock
+void Instrument::AudioCallback::renderScheduledEvents(int numSamples)
+{
+    if (this->schedule == nullptr || this->scheduleLane == nullptr || this->scheduleHasFinished)
+    {
+        return;
+    }
+
+    if (this->schedule->isStopped())
+    {
+        if (this->scheduleHasStarted)
+        {
+            this->releaseHoldingNotes(0);
+            this->incomingMidi.addEvent(MidiMessage::midiStop(), 0);
+        }
+
+        this->scheduleHasFinished = true;
+        return;
+    }
+
+    const auto &events = this->scheduleLane->events;
+    const auto length = this->schedule->getLengthInSamples();
+    const auto isLooped = this->schedule->isLooped();
+    const auto leadSamples = this->getScheduleLeadSamples();
+    const auto blockPosition = this->schedule->getBlockPosition() + leadSamples;
+
+    // still counting in, see Metronome
+    if (blockPosition + numSamples <= 0)
+    {
+        return;
+    }
+
+    // the events which should have been sent before the playback start
+    // to compensate the latency, can only be sent late, but not skipped
+    int64 lateWindow = 0;
+
+    if (!this->scheduleHasStarted)
+    {
+        // notes left from the previous playback, if any:
+        this->releaseHoldingNotes(0);
+        this->incomingMidi.addEvent(MidiMessage::midiStart(), 0);
+        this->scheduleLoopIteration = isLooped ? (jmax(int64(0), blockPosition) / length) : 0;
+        this->scheduleHasStarted = true;
+        lateWindow = leadSamples;
+    }
+    else if (this->scheduleNeedsResync)
+    {
+        const auto localPosition = isLooped ? (blockPosition % length) : blockPosition;
+        const auto *firstEvent = std::lower_bound(events.begin(), events.end(), localPosition,
+            [](const PlaybackSchedule::Event &event, int64 position)
+            {
+                return event.samplePosition < position;
+            });
+
+        this->nextScheduledEvent = int(firstEvent - events.begin());
+        this->releaseOrphanedNotes(0);
+        this->scheduleNeedsResync = false;
+    }
+
+    int processed = int(jmax(int64(0), -blockPosition));
+    while (processed < numSamples)
+    {
+        const auto position = blockPosition + processed;
+        const auto iteration = isLooped ? (position / length) : 0;
+        const auto localPosition = isLooped ? (position % length) : position;
+
+        if (iteration != this->scheduleLoopIteration)
+        {
+            // wrapped around the loop end
+            this->releaseHoldingNotes(processed);
+            this->nextScheduledEvent = 0;
+            this->scheduleLoopIteration = iteration;
+        }
+
+        const auto samplesLeft = int64(numSamples - processed);
+        const auto segmentEnd = isLooped ?
+            jmin(localPosition + samplesLeft, length) :
+            (localPosition + samplesLeft);
+
+        while (this->nextScheduledEvent < events.size())
+        {
+            const auto &event = events.getReference(this->nextScheduledEvent);
+            if (event.samplePosition >= segmentEnd)
+            {
+                break;
+            }
+
+            // events before the current position are the ones we've missed,
+            // e.g. when the callback was connected after the playback started
+            if (event.samplePosition >= localPosition)
+            {
+                const auto sampleOffset = processed + int(event.samplePosition - localPosition);
+                this->addScheduledEvent(event.message, sampleOffset);
+                // the offset is exactly the planned one, by definition
+                this->schedulingTelemetry.addEvent(0.0);
+            }
+            else if (event.samplePosition >= localPosition - lateWindow)
+            {
+                this->addScheduledEvent(event.message, processed);
+                this->schedulingTelemetry.addEvent(double(localPosition - event.samplePosition) *
+                    1000.0 / this->sampleRate);
+            }
+            else
+            {
+                this->schedulingTelemetry.addMissedEvent();
+            }
+
+            this->nextScheduledEvent++;
+        }
+
+        if (!isLooped && segmentEnd > length &&
+            this->nextScheduledEvent >= events.size())
+        {
+            const auto endOffset = jlimit(0, numSamples - 1, processed + int(length - localPosition));
+            this->releaseHoldingNotes(endOffset);
+            this->incomingMidi.addEvent(MidiMessage::midiStop(), endOffset);
+            this->scheduleHasFinished = true;
+            return;
+        }
+
+        processed += int(segmentEnd - localPosition);
+        lateWindow = 0;
+    }
+}
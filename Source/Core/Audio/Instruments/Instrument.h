@@ -17,6 +17,11 @@
 
 #pragma once
 
+#include "PlaybackSchedule.h"
+#include "MidiEventQueue.h"
+#include "SchedulingTelemetry.h"
+#include "HardwareMidiOutput.h"
+
 class AudioCore;
 class FilterInGraph;
 class Instrument;
@@ -37,6 +42,9 @@ public:
     String getIdAndHash() const;
     bool isValid() const noexcept;
 
+    // true while the nodes are being created after deserialization
+    bool isLoading() const noexcept;
+
     using InitializationCallback = Function<void(Instrument *)>;
 
     void initializeFrom(const PluginDescription &pluginDescription, InitializationCallback initCallback);
@@ -51,6 +59,53 @@ public:
         void setProcessor(AudioProcessor *processor);
         MidiMessageCollector &getMidiMessageCollector() noexcept { return messageCollector; }
 
+        // The player thread's way to send messages: doesn't block the audio
+        // thread and keeps the order; falls back to the collector, if full
+        void addMessageToQueue(const MidiMessage &message);
+
+        // The way to audition notes while editing: the messages are played
+        // in the next block, in the order they were sent, from any thread
+        void addPreviewMessage(const MidiMessage &message);
+
+        // The midi produced by the graph will also go to this device
+        void setHardwareMidiOutput(UniquePointer<HardwareMidiOutput> output);
+
+        // Events from the schedule's lane will be rendered right into
+        // the midi buffer of each block with the sample-accurate offsets
+        void setPlaybackSchedule(PlaybackSchedule::Ptr schedule, int laneIndex);
+
+        // Swaps the schedule on the fly, keeping the playback position
+        // and the holding notes, if their noteOff's are still ahead
+        void updatePlaybackSchedule(PlaybackSchedule::Ptr schedule, int laneIndex);
+
+        // The scheduled events are rendered ahead of time by the processor's
+        // latency plus this delay, which the engine adds to the output
+        // when aligning the instruments, so that they sound right in time;
+        // only set from the audio thread, before the callback is called
+        void setOutputDelay(int numSamples) noexcept { this->outputDelay = numSamples; }
+
+        // In the idle mode the callback stays attached to the device,
+        // but skips processing as soon as there's no midi input and the
+        // output has been silent for longer than the processor's tail;
+        // any incoming message wakes it up within the same block
+        void setIdleMode(bool shouldBeIdle, double tailLengthSeconds);
+
+        // Timing of the processor's blocks, updated by the audio thread
+        // and safe to read from anywhere, e.g. the instruments page
+        struct ProcessingLoad final
+        {
+            float averageMicroseconds = 0.f;
+            float maxMicroseconds = 0.f;
+            // of the buffer duration, i.e. 100% means a dropout
+            float bufferPercent = 0.f;
+        };
+
+        ProcessingLoad getProcessingLoad() const noexcept;
+
+        // How late the playback events reach this instrument
+        SchedulingTelemetry &getSchedulingTelemetry() noexcept { return this->schedulingTelemetry; }
+        const SchedulingTelemetry &getSchedulingTelemetry() const noexcept { return this->schedulingTelemetry; }
+
         void audioDeviceIOCallback(const float **, int, float **, int, int) override;
         void audioDeviceAboutToStart(AudioIODevice *) override;
         void audioDeviceStopped() override;
@@ -71,6 +126,47 @@ public:
 
         MidiBuffer incomingMidi;
         MidiMessageCollector messageCollector;
+        MidiEventQueue eventQueue;
+        MidiEventQueue previewQueue;
+        SpinLock previewLock;
+
+        UniquePointer<HardwareMidiOutput> hardwareMidiOutput;
+        double outputLatencyMs = 0.0;
+
+        Atomic<bool> idleMode = false;
+        Atomic<int64> idleTailSamples = 0;
+        int64 numSilentSamples = 0;
+        bool isSilent(const float *const *channelData,
+            int numChannels, int numSamples) const noexcept;
+
+        Atomic<float> averageMicroseconds = 0.f;
+        Atomic<float> maxMicroseconds = 0.f;
+        Atomic<float> averageBufferPercent = 0.f;
+        void updateProcessingLoad(int64 startTicks, int numSamples) noexcept;
+
+        SchedulingTelemetry schedulingTelemetry;
+
+        int outputDelay = 0;
+        int getScheduleLeadSamples() const noexcept;
+
+        void renderScheduledEvents(int numSamples);
+        void renderFrozenAudio(AudioBuffer<float> &buffer, int numSamples);
+        void addScheduledEvent(const MidiMessage &message, int sampleOffset);
+        void releaseHoldingNotes(int sampleOffset);
+        void releaseOrphanedNotes(int sampleOffset);
+
+        PlaybackSchedule::Ptr schedule;
+        const PlaybackSchedule::Lane *scheduleLane = nullptr;
+        int nextScheduledEvent = 0;
+        int64 scheduleLoopIteration = 0;
+        bool scheduleHasStarted = false;
+        bool scheduleHasFinished = false;
+        bool scheduleNeedsResync = false;
+
+        // to be able to send noteOff's when playback interrupts,
+        // since some plugins just don't understand allNotesOff message
+        uint8 holdingNotes[16][128] = {};
+        int numHoldingNotes = 0;
 
         JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AudioCallback)
     };
@@ -82,6 +178,36 @@ public:
     AudioProcessorGraph *getProcessorGraph() const noexcept
     { return this->processorGraph.get(); }
 
+    // the longest tail of all nodes, since the graph itself always reports zero
+    double getTailLengthSeconds() const;
+
+    // the hardware device to send the graph's midi output to, if any;
+    // the name is kept even if the device is not available at the moment
+    String getMidiOutputDevice() const noexcept;
+    void setMidiOutputDevice(const String &deviceName);
+
+    //===------------------------------------------------------------------===//
+    // Mixer
+    //===------------------------------------------------------------------===//
+
+    // An effect bus isn't meant to be played by the tracks: instead, the other
+    // instruments send their output into it, as its audio input, so that
+    // a reverb shared by many of them is only processed once per block
+    bool isEffectBus() const noexcept;
+    void setEffectBus(bool shouldBeBus);
+
+    struct Send final
+    {
+        String busId; // bus instrument's id and hash
+        float level;
+    };
+
+    // the levels at which this instrument's output is sent to the buses,
+    // in addition to going to the main output; zero level means no send
+    const Array<Send> &getSends() const noexcept;
+    float getSendLevel(const String &busId) const noexcept;
+    void setSendLevel(const String &busId, float level);
+
     //===------------------------------------------------------------------===//
     // Nodes
     //===------------------------------------------------------------------===//
@@ -119,10 +245,30 @@ public:
     bool isConnected(AudioProcessorGraph::Connection connection) const noexcept;
     bool canConnect(AudioProcessorGraph::Connection connection) const noexcept;
 
+    // within a graph edit, the connection changes are only queued,
+    // so addConnection returns true, as long as both nodes exist
     void removeConnection(AudioProcessorGraph::Connection connection);
     bool addConnection(AudioProcessorGraph::NodeID sourceID, int sourceChannel,
         AudioProcessorGraph::NodeID destinationID, int destinationChannel);
 
+    // Each change of the graph's topology makes it rebuild the rendering sequence,
+    // so the connections changed within the edit's lifetime are collected and applied
+    // all together when the outermost edit ends, along with a single legality check
+    // and a single change message, which leaves the graph with one rebuild to do
+    class GraphEdit final
+    {
+    public:
+
+        explicit GraphEdit(Instrument &instrument) noexcept;
+        ~GraphEdit();
+
+    private:
+
+        Instrument &instrument;
+
+        JUCE_DECLARE_NON_COPYABLE(GraphEdit)
+    };
+
     //===------------------------------------------------------------------===//
     // Serializable
     //===------------------------------------------------------------------===//
@@ -158,12 +304,44 @@ private:
 
     AudioPluginFormatManager &formatManager;
     Instrument::AudioCallback audioCallback;
+    String midiOutputDevice;
     UniquePointer<AudioProcessorGraph> processorGraph;
 
     SerializedData serializeNode(AudioProcessorGraph::Node::Ptr node) const;
 
     using DeserializeNodesCallback = Function<void()>;
     void deserializeNodesAsync(Array<SerializedData> nodesToDeserialize, DeserializeNodesCallback f);
+    void deserializeNode(const SerializedData &tree, UniquePointer<AudioPluginInstance> instance);
+
+    // all nodes are requested at once, and the callbacks for the
+    // previous deserialization are discarded, if it's not done yet
+    int numNodesLoading = 0;
+    int loadingGeneration = 0;
+
+    // set by the audio core to track the loading progress
+    Function<void()> onNodeLoaded;
+
+    // set by the audio core to re-route the mixer
+    Function<void()> onRoutingChanged;
+
+    bool effectBus = false;
+    Array<Send> sends;
+
+    // When deserializing an instrument which has the very same nodes live,
+    // they are kept, and only the states which differ are restored:
+    // this keeps the hashes of the states as last saved or restored per node
+    mutable FlatHashMap<uint32, int64> nodeStateHashes;
+    bool canDeserializeInPlace(const SerializedData &root) const;
+    void deserializeInPlace(const SerializedData &root);
+
+    // the state of the graph edits in progress, see GraphEdit
+    int numGraphEdits = 0;
+    bool graphEditHasChanges = false;
+    bool graphEditNeedsLegalityCheck = false;
+    Array<AudioProcessorGraph::Connection> connectionsToRemove;
+    Array<AudioProcessorGraph::Connection> connectionsToAdd;
+    void sendGraphChangeMessage();
+    void commitGraphEdit();
 
 private:
 
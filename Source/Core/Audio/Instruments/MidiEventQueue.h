@@ -0,0 +1,154 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+/*
+    A fixed-capacity queue of short midi messages, sent by the player thread
+    to the audio callback of an instrument: unlike MidiMessageCollector,
+    it never locks or allocates, so the audio thread never blocks on it,
+    and it keeps the messages strictly in the order they were sent.
+
+    This is a single-producer, single-consumer queue: the only producer
+    is the player thread, and the only consumer is the audio thread.
+*/
+
+class MidiEventQueue final
+{
+public:
+
+    explicit MidiEventQueue(int capacity = 1024) :
+        fifo(capacity),
+        events(size_t(capacity), true) {}
+
+    // Called from the player thread;
+    // returns false, if the message doesn't fit, so that
+    // the caller can fall back to some other way of sending it
+    bool push(const MidiMessage &message) noexcept
+    {
+        return this->push(message.getRawData(), message.getRawDataSize(), message.getTimeStamp());
+    }
+
+    bool push(const uint8 *data, int size, double timeStamp) noexcept
+    {
+        if (size <= 0 || size > Event::maxSize)
+        {
+            return false;
+        }
+
+        int start1, size1, start2, size2;
+        this->fifo.prepareToWrite(1, start1, size1, start2, size2);
+        if (size1 == 0)
+        {
+            return false;
+        }
+
+        auto &event = this->events[start1];
+        memcpy(event.data, data, size_t(size));
+        event.size = uint8(size);
+        event.timeStamp = timeStamp;
+
+        this->fifo.finishedWrite(1);
+        return true;
+    }
+
+    // Called from the audio thread: spreads all the messages
+    // received since the last block over the new block, like
+    // MidiMessageCollector does, but keeps their order
+    void popNextBlock(MidiBuffer &destination, int numSamples, double sampleRate) noexcept
+    {
+        const double timeNow = Time::getMillisecondCounterHiRes() * 0.001;
+        const double lastBlockTime = this->lastBlockTime;
+        this->lastBlockTime = timeNow;
+
+        const int numReady = this->fifo.getNumReady();
+        if (numReady == 0)
+        {
+            return;
+        }
+
+        const double numSourceSamples = jmax(1.0, (timeNow - lastBlockTime) * sampleRate);
+        const double scale = jmin(1.0, double(numSamples) / numSourceSamples);
+
+        int start1, size1, start2, size2;
+        this->fifo.prepareToRead(numReady, start1, size1, start2, size2);
+
+        int lastOffset = 0;
+        const auto addEvents = [&](int start, int size)
+        {
+            for (int i = start; i < start + size; ++i)
+            {
+                const auto &event = this->events[i];
+                const double position = (event.timeStamp - lastBlockTime) * sampleRate * scale;
+                lastOffset = jlimit(lastOffset, numSamples - 1, int(position));
+                destination.addEvent(event.data, int(event.size), lastOffset);
+            }
+        };
+
+        addEvents(start1, size1);
+        addEvents(start2, size2);
+
+        this->fifo.finishedRead(size1 + size2);
+    }
+
+    // Takes all the messages ready, calling back with
+    // their raw data, size and timestamp, in the order they were sent
+    template <typename Callback>
+    void popAll(const Callback &callback)
+    {
+        const int numReady = this->fifo.getNumReady();
+        if (numReady == 0)
+        {
+            return;
+        }
+
+        int start1, size1, start2, size2;
+        this->fifo.prepareToRead(numReady, start1, size1, start2, size2);
+
+        for (int i = start1; i < start1 + size1; ++i)
+        {
+            const auto &event = this->events[i];
+            callback(event.data, int(event.size), event.timeStamp);
+        }
+
+        for (int i = start2; i < start2 + size2; ++i)
+        {
+            const auto &event = this->events[i];
+            callback(event.data, int(event.size), event.timeStamp);
+        }
+
+        this->fifo.finishedRead(size1 + size2);
+    }
+
+private:
+
+    struct Event final
+    {
+        static constexpr int maxSize = 13;
+        uint8 data[maxSize];
+        uint8 size;
+        double timeStamp;
+    };
+
+    AbstractFifo fifo;
+    HeapBlock<Event> events;
+
+    // only accessed by the consumer
+    double lastBlockTime = 0.0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MidiEventQueue)
+};
@@ -0,0 +1,180 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "Common.h"
+#include "PluginPrograms.h"
+#include "Instrument.h"
+
+// Shared by the worker and the message thread: the worker holds the lock
+// while talking to the plugin, and the destructor takes it to make sure
+// no plugin is used after its node is released
+class PluginPrograms::Enumeration final : public ReferenceCountedObject
+{
+public:
+
+    explicit Enumeration(AudioProcessorGraph::Node::Ptr node) :
+        node(node), processor(node->getProcessor()) {}
+
+    void run()
+    {
+        const ScopedLock sl(this->lock);
+        if (this->isCancelled)
+        {
+            return;
+        }
+
+        const auto numPrograms = this->processor->getNumPrograms();
+        for (int i = 0; i < numPrograms && !this->isCancelled; ++i)
+        {
+            this->names.add(this->processor->getProgramName(i));
+        }
+    }
+
+    void cancel()
+    {
+        this->isCancelled = true; // stops the loop early
+        const ScopedLock sl(this->lock);
+    }
+
+    // only touched on the message thread
+    AudioProcessorGraph::Node::Ptr node;
+
+    StringArray names;
+
+private:
+
+    AudioProcessor *const processor;
+
+    CriticalSection lock;
+    Atomic<bool> isCancelled = false;
+
+};
+
+PluginPrograms::PluginPrograms() {}
+
+PluginPrograms::~PluginPrograms()
+{
+    this->cancellationToken.cancel();
+
+    for (auto &it : this->pending)
+    {
+        it.second->cancel();
+        it.second->node = nullptr;
+    }
+}
+
+String PluginPrograms::getCacheKey(AudioProcessorGraph::Node::Ptr node)
+{
+    if (auto *plugin = dynamic_cast<AudioPluginInstance *>(node->getProcessor()))
+    {
+        const auto description = plugin->getPluginDescription();
+        return description.createIdentifierString() + "-" + description.version;
+    }
+
+    return {};
+}
+
+void PluginPrograms::prefetch(Instrument *instrument)
+{
+    for (int i = 0; i < instrument->getNumNodes(); ++i)
+    {
+        const auto node = instrument->getNode(i);
+        if (!instrument->isNodeStandardIOProcessor(node))
+        {
+            this->prefetch(node);
+        }
+    }
+}
+
+void PluginPrograms::prefetch(AudioProcessorGraph::Node::Ptr node)
+{
+    jassert(MessageManager::getInstance()->isThisTheMessageThread());
+
+    const auto key = PluginPrograms::getCacheKey(node);
+    if (key.isNotEmpty() && this->cache.find(key) == this->cache.end())
+    {
+        this->enumerate(node, key);
+    }
+}
+
+void PluginPrograms::enumerate(AudioProcessorGraph::Node::Ptr node, const String &key)
+{
+    if (this->pending.find(key) != this->pending.end())
+    {
+        return;
+    }
+
+    ReferenceCountedObjectPtr<Enumeration> enumeration(new Enumeration(node));
+    this->pending[key] = enumeration;
+
+    const WeakReference<PluginPrograms> weakThis(this);
+    App::Tasks().run([enumeration]()
+    {
+        enumeration->run();
+    },
+    TaskPool::Priority::Background,
+    this->cancellationToken,
+    [weakThis, enumeration, key]()
+    {
+        if (weakThis == nullptr)
+        {
+            return;
+        }
+
+        weakThis->cache[key] = enumeration->names;
+        weakThis->pending.erase(key);
+        enumeration->node = nullptr;
+
+        weakThis->sendChangeMessage();
+    });
+}
+
+bool PluginPrograms::getProgramNames(AudioProcessorGraph::Node::Ptr node, StringArray &outNames)
+{
+    const auto key = PluginPrograms::getCacheKey(node);
+    const auto found = this->cache.find(key);
+    if (found == this->cache.end())
+    {
+        if (key.isNotEmpty())
+        {
+            this->enumerate(node, key);
+        }
+
+        return false;
+    }
+
+    outNames = found->second;
+
+    // the count is cheap to ask for, unlike the names, and it
+    // changes when the plugin loads another bank, for example
+    if (node->getProcessor()->getNumPrograms() != outNames.size())
+    {
+        this->enumerate(node, key);
+        return false;
+    }
+
+    return true;
+}
+
+void PluginPrograms::changeListenerCallback(ChangeBroadcaster *source)
+{
+    if (auto *instrument = dynamic_cast<Instrument *>(source))
+    {
+        this->prefetch(instrument);
+    }
+}
@@ -0,0 +1,72 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#include "TaskPool.h"
+
+class Instrument;
+
+/*
+    Some plugins take a while to answer getProgramName, and some have
+    hundreds of programs, so the names are enumerated only once per plugin,
+    right after it is loaded, on the app's worker threads, all plugins
+    in parallel, and then cached by the plugin's identifier and version;
+    the menus just read the cache and listen to it for the updates.
+
+    The plugin nodes are held here until their enumeration is done,
+    so that the last reference is never released on a worker thread.
+*/
+
+class PluginPrograms final : public ChangeBroadcaster, public ChangeListener
+{
+public:
+
+    PluginPrograms();
+    ~PluginPrograms() override;
+
+    // Enumerates the programs of the instrument's plugins which
+    // are not in the cache yet; the instruments call this when
+    // their graph changes, since this listens to all of them
+    void prefetch(Instrument *instrument);
+    void prefetch(AudioProcessorGraph::Node::Ptr node);
+
+    // Returns false, if the node's programs are not enumerated yet,
+    // or if the plugin seems to have changed them since the last time,
+    // in which case they are enumerated again, and the listeners
+    // will be notified when done; the stale names are returned anyway
+    bool getProgramNames(AudioProcessorGraph::Node::Ptr node, StringArray &outNames);
+
+    static String getCacheKey(AudioProcessorGraph::Node::Ptr node);
+
+private:
+
+    void enumerate(AudioProcessorGraph::Node::Ptr node, const String &key);
+
+    void changeListenerCallback(ChangeBroadcaster *source) override;
+
+    FlatHashMap<String, StringArray, StringHash> cache;
+
+    class Enumeration;
+    FlatHashMap<String, ReferenceCountedObjectPtr<Enumeration>, StringHash> pending;
+
+    TaskPool::CancellationToken cancellationToken;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PluginPrograms)
+    JUCE_DECLARE_WEAK_REFERENCEABLE(PluginPrograms)
+};
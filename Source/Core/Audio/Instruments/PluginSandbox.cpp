@@ -0,0 +1,247 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "Common.h"
+#include "PluginSandbox.h"
+#include "SandboxSharedBlock.h"
+#include "SerializablePluginDescription.h"
+#include "SerializationKeys.h"
+#include "DocumentHelpers.h"
+#include "XmlSerializer.h"
+#include "AudioCore.h"
+
+// how long to keep spinning after a block, before falling back to sleeping:
+// the host requests the blocks at the audio device's rate, so while playing,
+// the next one is always expected within a few milliseconds
+#define SANDBOX_SPIN_TIME_MS 50.0
+
+PluginSandbox::PluginSandbox() :
+    Thread("Plugin sandbox")
+{
+    AudioCore::initAudioFormats(this->formatManager);
+}
+
+PluginSandbox::~PluginSandbox()
+{
+    this->stopThread(1000);
+
+    const ScopedLock lock(this->pluginLock);
+    if (this->plugin != nullptr)
+    {
+        this->plugin->releaseResources();
+        this->plugin = nullptr;
+    }
+}
+
+bool PluginSandbox::isSandboxCommandLine(const String &commandLine)
+{
+    return commandLine.contains("--" HELIO_SANDBOX_PROCESS_ID ":");
+}
+
+//===----------------------------------------------------------------------===//
+// ChildProcessSlave
+//===----------------------------------------------------------------------===//
+
+void PluginSandbox::handleMessageFromMaster(const MemoryBlock &data)
+{
+    const auto request = DocumentHelpers::read<XmlSerializer>(data.toString());
+    MessageManager::callAsync([this, request]()
+    {
+        this->handleRequest(request);
+    });
+}
+
+void PluginSandbox::handleConnectionLost()
+{
+    this->signalThreadShouldExit();
+    MessageManager::callAsync([]()
+    {
+        JUCEApplication::quit();
+    });
+}
+
+void PluginSandbox::sendReply(const SerializedData &reply)
+{
+    String message;
+    XmlSerializer().saveToString(message, reply);
+    this->sendMessageToMaster({ message.toRawUTF8(), message.getNumBytesAsUTF8() });
+}
+
+void PluginSandbox::handleRequest(const SerializedData &request)
+{
+    using namespace Serialization::Audio;
+    SerializedData reply(Sandbox::reply);
+
+    if (request.hasType(Sandbox::load))
+    {
+        reply = this->load(request);
+    }
+    else if (request.hasType(Sandbox::prepare))
+    {
+        const ScopedLock lock(this->pluginLock);
+        if (this->plugin != nullptr)
+        {
+            this->plugin->prepareToPlay(request.getProperty(Sandbox::sampleRate),
+                request.getProperty(Sandbox::blockSize));
+            reply.setProperty(Sandbox::latency, this->plugin->getLatencySamples());
+        }
+    }
+    else if (request.hasType(Sandbox::release))
+    {
+        const ScopedLock lock(this->pluginLock);
+        if (this->plugin != nullptr)
+        {
+            this->plugin->releaseResources();
+        }
+    }
+    else if (request.hasType(Sandbox::getState))
+    {
+        const ScopedLock lock(this->pluginLock);
+        if (this->plugin != nullptr)
+        {
+            MemoryBlock state;
+            this->plugin->getStateInformation(state);
+            reply.setProperty(pluginState, state.toBase64Encoding());
+        }
+    }
+    else if (request.hasType(Sandbox::setState))
+    {
+        const ScopedLock lock(this->pluginLock);
+        if (this->plugin != nullptr)
+        {
+            MemoryBlock state;
+            state.fromBase64Encoding(request.getProperty(pluginState).toString());
+            this->plugin->setStateInformation(state.getData(), int(state.getSize()));
+        }
+    }
+
+    // any request gets a reply, since the host waits for it
+    this->sendReply(reply);
+}
+
+SerializedData PluginSandbox::load(const SerializedData &request)
+{
+    using namespace Serialization::Audio;
+    SerializedData reply(Sandbox::reply);
+
+    if (this->plugin != nullptr)
+    {
+        reply.setProperty(Sandbox::error, "The sandbox is taken");
+        return reply;
+    }
+
+    const File sharedFile(request.getProperty(Sandbox::sharedFile).toString());
+    this->sharedMemory = makeUnique<MemoryMappedFile>(sharedFile, MemoryMappedFile::readWrite);
+    if (this->sharedMemory->getData() == nullptr ||
+        this->sharedMemory->getSize() < sizeof(SandboxSharedBlock))
+    {
+        reply.setProperty(Sandbox::error, "Failed to map the shared memory file");
+        return reply;
+    }
+
+    SerializablePluginDescription description;
+    description.deserialize(request.getChild(0));
+
+    String error;
+    const double sampleRate = request.getProperty(Sandbox::sampleRate);
+    const int blockSize = request.getProperty(Sandbox::blockSize);
+    auto instance = this->formatManager.createPluginInstance(description, sampleRate, blockSize, error);
+    if (instance == nullptr)
+    {
+        reply.setProperty(Sandbox::error, error.isNotEmpty() ? error : "Failed to load the plugin");
+        return reply;
+    }
+
+    instance->enableAllBuses();
+    instance->prepareToPlay(sampleRate, blockSize);
+
+    reply.setProperty(pluginNumInputs, instance->getTotalNumInputChannels());
+    reply.setProperty(pluginNumOutputs, instance->getTotalNumOutputChannels());
+    reply.setProperty(Sandbox::acceptsMidi, instance->acceptsMidi());
+    reply.setProperty(Sandbox::producesMidi, instance->producesMidi());
+    reply.setProperty(Sandbox::tailLength, instance->getTailLengthSeconds());
+    reply.setProperty(Sandbox::latency, instance->getLatencySamples());
+
+    {
+        const ScopedLock lock(this->pluginLock);
+        this->plugin = std::move(instance);
+        this->sharedBlock = static_cast<SandboxSharedBlock *>(this->sharedMemory->getData());
+    }
+
+    this->startThread(9);
+    return reply;
+}
+
+//===----------------------------------------------------------------------===//
+// Thread
+//===----------------------------------------------------------------------===//
+
+void PluginSandbox::run()
+{
+    auto *shared = this->sharedBlock;
+    uint32 lastBlock = shared->completedBlock.load(std::memory_order_acquire);
+    auto lastBlockTimeMs = Time::getMillisecondCounterHiRes();
+
+    float *channels[SandboxSharedBlock::maxChannels];
+    for (int i = 0; i < SandboxSharedBlock::maxChannels; ++i)
+    {
+        channels[i] = shared->audio[i];
+    }
+
+    while (!this->threadShouldExit() &&
+        shared->shouldExit.load(std::memory_order_acquire) == 0)
+    {
+        const auto requested = shared->requestedBlock.load(std::memory_order_acquire);
+        if (requested == lastBlock)
+        {
+            // there's no cross-platform way to wait for the other process,
+            // so this spins while playing, and then only checks once in a while
+            if (Time::getMillisecondCounterHiRes() - lastBlockTimeMs < SANDBOX_SPIN_TIME_MS)
+            {
+                Thread::yield();
+            }
+            else
+            {
+                Thread::sleep(1);
+            }
+
+            continue;
+        }
+
+        const auto startTicks = Time::getHighResolutionTicks();
+        const int numSamples = jlimit(0, SandboxSharedBlock::maxBlockSize, int(shared->numSamples));
+        const int numChannels = jlimit(0, SandboxSharedBlock::maxChannels, int(shared->numChannels));
+
+        SandboxSharedBlock::readMidi(shared->midiIn, shared->numMidiInBytes, this->midiBuffer);
+
+        {
+            const ScopedLock lock(this->pluginLock);
+            AudioBuffer<float> audio(channels, numChannels, numSamples);
+            this->plugin->processBlock(audio, this->midiBuffer);
+        }
+
+        shared->numMidiOutBytes = SandboxSharedBlock::writeMidi(this->midiBuffer, shared->midiOut);
+
+        const auto elapsedTicks = Time::getHighResolutionTicks() - startTicks;
+        shared->processingMicroseconds = float(Time::highResolutionTicksToSeconds(elapsedTicks) * 1000000.0);
+        shared->completedBlock.store(requested, std::memory_order_release);
+
+        lastBlock = requested;
+        lastBlockTimeMs = Time::getMillisecondCounterHiRes();
+    }
+}
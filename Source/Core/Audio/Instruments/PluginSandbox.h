@@ -0,0 +1,67 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+struct SandboxSharedBlock;
+
+/*
+    The child process' side of SandboxedPlugin: loads a single plugin
+    and processes the audio blocks requested by the host through the
+    shared memory, in its own thread, polling for the next block;
+    quits as soon as the host has gone.
+*/
+
+class PluginSandbox final : public ChildProcessSlave, private Thread
+{
+public:
+
+    PluginSandbox();
+    ~PluginSandbox() override;
+
+    static bool isSandboxCommandLine(const String &commandLine);
+
+    //===------------------------------------------------------------------===//
+    // ChildProcessSlave
+    //===------------------------------------------------------------------===//
+
+    void handleMessageFromMaster(const MemoryBlock &data) override;
+    void handleConnectionLost() override;
+
+private:
+
+    void run() override;
+
+    // the requests are handled on the message thread, one by one,
+    // since some plugins can only be created and set up there
+    void handleRequest(const SerializedData &request);
+    void sendReply(const SerializedData &reply);
+
+    SerializedData load(const SerializedData &request);
+
+    AudioPluginFormatManager formatManager;
+    UniquePointer<AudioPluginInstance> plugin;
+    CriticalSection pluginLock;
+
+    UniquePointer<MemoryMappedFile> sharedMemory;
+    SandboxSharedBlock *sharedBlock = nullptr;
+
+    MidiBuffer midiBuffer;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PluginSandbox)
+};
@@ -33,6 +33,9 @@
 #   define SAFE_SCAN 0
 #endif
 
+#define PLUGIN_SCANNER_MAX_PROCESSES 8
+#define PLUGIN_SCANNER_TIMEOUT_MS 10000
+
 PluginScanner::PluginScanner() :
     Thread("Plugin Scanner")
 {
@@ -117,14 +120,17 @@ void PluginScanner::runInitialScan()
     // built-in synths to be add at the first place:
     this->filesToScan.addIfNotAlreadyThere(BuiltInSynth::pianoId);
 
-    // known synths to be re-checked first as well:
+    // known synths are only re-checked if their files have changed,
+    // the rest are kept as they were restored from the config:
     for (const auto &it : this->getPlugins())
     {
-        this->filesToScan.addIfNotAlreadyThere(it.fileOrIdentifier);
+        if (!this->isCachedAndUpToDate(it.fileOrIdentifier))
+        {
+            this->pluginsList.removeType(it);
+            this->filesToScan.addIfNotAlreadyThere(it.fileOrIdentifier);
+        }
     }
 
-    this->pluginsList.clear();
-
     AudioPluginFormatManager formatManager;
     AudioCore::initAudioFormats(formatManager);
 
@@ -157,6 +163,23 @@ void PluginScanner::scanFolderAndAddResults(const File &dir)
     this->filesToScan.clearQuick();
     this->searchPath = dir.getFullPathName();
 
+    // the folder is scanned explicitly, so all of its plugins are re-checked,
+    // including the ones which have failed before
+    {
+        const ScopedLock lock(this->scanCacheLock);
+        for (auto it = this->scanCache.begin(); it != this->scanCache.end();)
+        {
+            if (File(it->first).isAChildOf(dir))
+            {
+                it = this->scanCache.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+    }
+
     Array<File> subPaths;
     this->searchPath.findChildFiles(subPaths, File::findDirectories, false);
 
@@ -199,106 +222,223 @@ void PluginScanner::run()
             }
         }
 
-        try
+        // the known-good plugins are in the list already:
+        StringArray changedFiles;
+        for (const auto &pluginPath : this->filesToScan)
         {
-            const auto myPath(File::getSpecialLocation(File::currentExecutableFile).getFullPathName());
-
-            for (const auto &pluginPath : this->filesToScan)
+            if (!this->isCachedAndUpToDate(pluginPath))
             {
-                if (this->cancelled.get())
-                {
-                    DBG("Plugin scanning canceled");
-                    break;
-                }
+                changedFiles.addIfNotAlreadyThere(pluginPath);
+            }
+        }
+
+        DBG("Plugins to check: " + String(changedFiles.size()) +
+            " of " + String(this->filesToScan.size()));
 
+        try
+        {
 #if SAFE_SCAN
-                DBG("Safe scanning: " + pluginPath);
+            this->checkPluginsInChildProcesses(changedFiles);
+#else
+            this->checkPluginsInProcess(changedFiles, formatManager);
+#endif
+        }
+        catch (...) {}
 
-                const Uuid tempFileName;
-                const File tempFile(DocumentHelpers::getTempSlot(tempFileName.toString()));
-                tempFile.appendText(pluginPath, false, false);
+        {
+            this->cancelled = false;
+            this->working = false;
+            
+            DBG("Done scanning for audio plugins");
+            this->sendChangeMessage();
+        }
+        
+        WaitableEvent::wait();
+    }
+}
 
-                Thread::sleep(50);
+struct PluginCheck final
+{
+    String pluginPath;
+    File tempFile;
+    ChildProcess process;
+    uint32 startTime = 0;
+};
+
+// Runs several checker processes at once, each of them gets a temp file
+// with the plugin path, and writes the found descriptions back into it
+void PluginScanner::checkPluginsInChildProcesses(const StringArray &files)
+{
+    const auto myPath(File::getSpecialLocation(File::currentExecutableFile).getFullPathName());
+    const int maxNumProcesses = jlimit(1, PLUGIN_SCANNER_MAX_PROCESSES, SystemStats::getNumCpus());
 
-                ChildProcess checkerProcess;
-                const String commandLine(myPath + " " + tempFileName.toString());
-                checkerProcess.start(commandLine);
-                    
-                // FIXME! (#60): skips some valid plugins sometimes
-                if (!checkerProcess.waitForProcessToFinish(5000))
-                {
-                    checkerProcess.kill();
-                }
-                else
-                {
-                    Thread::sleep(50);
+    OwnedArray<PluginCheck> runningChecks;
+    int nextFileIndex = 0;
 
-                    if (tempFile.existsAsFile())
-                    {
-                        try
-                        {
-                            const auto tree(DocumentHelpers::load<XmlSerializer>(tempFile));
-                            if (tree.isValid())
-                            {
-                                forEachChildWithType(tree, e, Serialization::Audio::plugin)
-                                {
-                                    SerializablePluginDescription pluginDescription;
-                                    pluginDescription.deserialize(e);
-                                    this->pluginsList.addType(pluginDescription);
-                                }
-                                    
-                                this->sendChangeMessage();
-                            }
-                        }
-                        catch (...) {}
-                    }
+    while (nextFileIndex < files.size() || !runningChecks.isEmpty())
+    {
+        if (this->cancelled.get() || this->threadShouldExit())
+        {
+            DBG("Plugin scanning canceled");
+            break;
+        }
+
+        while (runningChecks.size() < maxNumProcesses && nextFileIndex < files.size())
+        {
+            const auto &pluginPath = files[nextFileIndex++];
+            DBG("Safe scanning: " + pluginPath);
+
+            const Uuid tempFileName;
+            auto *check = runningChecks.add(new PluginCheck());
+            check->pluginPath = pluginPath;
+            check->tempFile = DocumentHelpers::getTempSlot(tempFileName.toString());
+            check->tempFile.appendText(pluginPath, false, false);
+            check->startTime = Time::getMillisecondCounter();
+
+            if (!check->process.start(myPath + " " + tempFileName.toString()))
+            {
+                check->tempFile.deleteFile();
+                runningChecks.removeObject(check);
+            }
+        }
+
+        for (int i = runningChecks.size(); --i >= 0;)
+        {
+            auto *check = runningChecks.getUnchecked(i);
+
+            if (check->process.isRunning())
+            {
+                // FIXME! (#60): skips some valid plugins sometimes;
+                // timed out plugins are not cached, so they'll be re-checked next time
+                if (Time::getMillisecondCounter() - check->startTime > PLUGIN_SCANNER_TIMEOUT_MS)
+                {
+                    DBG("Plugin check timed out: " + check->pluginPath);
+                    check->process.kill();
+                    check->tempFile.deleteFile();
+                    runningChecks.remove(i);
                 }
 
-                tempFile.deleteFile();
-#else
-                DBG("Unsafe scanning: " + pluginPath);
+                continue;
+            }
 
-                KnownPluginList knownPluginList;
-                OwnedArray<PluginDescription> typesFound;
-                    
+            // the checker deletes the temp file when it starts, and then only
+            // writes it back if it hasn't crashed while loading the plugin
+            if (check->tempFile.existsAsFile())
+            {
                 try
                 {
-                    for (int j = 0; j < formatManager.getNumFormats(); ++j)
+                    const auto tree(DocumentHelpers::load<XmlSerializer>(check->tempFile));
+                    if (tree.isValid())
                     {
-                        AudioPluginFormat *format = formatManager.getFormat(j);
-                        knownPluginList.scanAndAddFile(pluginPath, false, typesFound, *format);
+                        forEachChildWithType(tree, e, Serialization::Audio::plugin)
+                        {
+                            SerializablePluginDescription pluginDescription;
+                            pluginDescription.deserialize(e);
+                            this->pluginsList.addType(pluginDescription);
+                        }
+
+                        this->sendChangeMessage();
                     }
                 }
                 catch (...) {}
-                    
-                // at this point we are still alive and plugin haven't crashed the app
-                if (typesFound.size() != 0)
-                {
-                    for (auto *type : typesFound)
-                    {
-                        this->pluginsList.addType(*type);
-                    }
-                }
-                    
-                this->sendChangeMessage();
-                Thread::sleep(150);
-#endif
             }
+
+            this->updateScanCache(check->pluginPath);
+            check->tempFile.deleteFile();
+            runningChecks.remove(i);
         }
-        catch (...) {}
 
+        Thread::sleep(20);
+    }
+
+    for (auto *check : runningChecks)
+    {
+        check->process.kill();
+        check->tempFile.deleteFile();
+    }
+}
+
+void PluginScanner::checkPluginsInProcess(const StringArray &files,
+    AudioPluginFormatManager &formatManager)
+{
+    for (const auto &pluginPath : files)
+    {
+        if (this->cancelled.get() || this->threadShouldExit())
         {
-            this->cancelled = false;
-            this->working = false;
+            DBG("Plugin scanning canceled");
+            break;
+        }
+
+        DBG("Unsafe scanning: " + pluginPath);
+
+        KnownPluginList knownPluginList;
+        OwnedArray<PluginDescription> typesFound;
             
-            DBG("Done scanning for audio plugins");
-            this->sendChangeMessage();
+        try
+        {
+            for (int j = 0; j < formatManager.getNumFormats(); ++j)
+            {
+                AudioPluginFormat *format = formatManager.getFormat(j);
+                knownPluginList.scanAndAddFile(pluginPath, false, typesFound, *format);
+            }
         }
-        
-        WaitableEvent::wait();
+        catch (...) {}
+            
+        // at this point we are still alive and plugin haven't crashed the app
+        if (typesFound.size() != 0)
+        {
+            for (auto *type : typesFound)
+            {
+                this->pluginsList.addType(*type);
+            }
+        }
+
+        this->updateScanCache(pluginPath);
+        this->sendChangeMessage();
+        Thread::sleep(150);
     }
 }
 
+//===----------------------------------------------------------------------===//
+// Scan cache
+//===----------------------------------------------------------------------===//
+
+bool PluginScanner::isCachedAndUpToDate(const String &fileOrIdentifier) const
+{
+    const ScopedLock lock(this->scanCacheLock);
+
+    const auto found = this->scanCache.find(fileOrIdentifier);
+    if (found == this->scanCache.end())
+    {
+        return false;
+    }
+
+    const File file(fileOrIdentifier);
+    return file.exists() &&
+        found->second.size == file.getSize() &&
+        found->second.modificationTime == file.getLastModificationTime().toMilliseconds();
+}
+
+void PluginScanner::updateScanCache(const String &fileOrIdentifier)
+{
+    // built-in instruments have identifiers instead of file paths
+    if (!File::isAbsolutePath(fileOrIdentifier))
+    {
+        return;
+    }
+
+    const File file(fileOrIdentifier);
+    if (!file.exists())
+    {
+        return;
+    }
+
+    const ScopedLock lock(this->scanCacheLock);
+    auto &entry = this->scanCache[fileOrIdentifier];
+    entry.size = file.getSize();
+    entry.modificationTime = file.getLastModificationTime().toMilliseconds();
+}
+
 FileSearchPath PluginScanner::getTypicalFolders()
 {
     FileSearchPath folders;
@@ -376,6 +516,22 @@ SerializedData PluginScanner::serialize() const
         tree.appendChild(pd.serialize());
     }
 
+    SerializedData cacheNode(Serialization::Audio::pluginsScanCache);
+
+    {
+        const ScopedLock lock(this->scanCacheLock);
+        for (const auto &it : this->scanCache)
+        {
+            SerializedData entryNode(Serialization::Audio::pluginsScanCacheEntry);
+            entryNode.setProperty(Serialization::Audio::pluginsScanCacheFile, it.first);
+            entryNode.setProperty(Serialization::Audio::pluginsScanCacheFileSize, String::toHexString(it.second.size));
+            entryNode.setProperty(Serialization::Audio::pluginsScanCacheFileTime, String::toHexString(it.second.modificationTime));
+            cacheNode.appendChild(entryNode);
+        }
+    }
+
+    tree.appendChild(cacheNode);
+
     return tree;
 }
 
@@ -388,7 +544,7 @@ void PluginScanner::deserialize(const SerializedData &data)
 
     if (!root.isValid()) { return; }
     
-    for (const auto &child : root)
+    forEachChildWithType(root, child, Serialization::Audio::plugin)
     {
         SerializablePluginDescription pluginDescription;
         pluginDescription.deserialize(child);
@@ -398,11 +554,31 @@ void PluginScanner::deserialize(const SerializedData &data)
         }
     }
 
+    {
+        const ScopedLock lock(this->scanCacheLock);
+        const auto cacheNode = root.getChildWithName(Serialization::Audio::pluginsScanCache);
+        forEachChildWithType(cacheNode, entryNode, Serialization::Audio::pluginsScanCacheEntry)
+        {
+            const String file = entryNode.getProperty(Serialization::Audio::pluginsScanCacheFile);
+            if (file.isNotEmpty())
+            {
+                auto &entry = this->scanCache[file];
+                entry.size = entryNode.getProperty(Serialization::Audio::pluginsScanCacheFileSize).toString().getHexValue64();
+                entry.modificationTime = entryNode.getProperty(Serialization::Audio::pluginsScanCacheFileTime).toString().getHexValue64();
+            }
+        }
+    }
+
     this->sendChangeMessage();
 }
 
 void PluginScanner::reset()
 {
+    {
+        const ScopedLock lock(this->scanCacheLock);
+        this->scanCache.clear();
+    }
+
     this->pluginsList.clear();
     this->sendChangeMessage();
 }
@@ -66,6 +66,21 @@ private:
     void run() override;
 
     KnownPluginList pluginsList;
+
+    // the files which have been checked already, with their sizes and
+    // modification times, so that only the changed ones are re-checked;
+    // includes the files which contain no plugins or failed to load
+    struct CachedFile final
+    {
+        int64 size = 0;
+        int64 modificationTime = 0;
+    };
+
+    FlatHashMap<String, CachedFile, StringHash> scanCache;
+    CriticalSection scanCacheLock;
+
+    bool isCachedAndUpToDate(const String &fileOrIdentifier) const;
+    void updateScanCache(const String &fileOrIdentifier);
     
     Atomic<bool> working = false;
     Atomic<bool> cancelled = false;
@@ -74,6 +89,10 @@ private:
     FileSearchPath searchPath;
     StringArray filesToScan;
 
+    void checkPluginsInChildProcesses(const StringArray &files);
+    void checkPluginsInProcess(const StringArray &files,
+        AudioPluginFormatManager &formatManager);
+
     FileSearchPath getTypicalFolders();
     void scanPossibleSubfolders(const StringArray &possibleSubfolders,
         const File &currentSystemFolder, FileSearchPath &foldersOut);
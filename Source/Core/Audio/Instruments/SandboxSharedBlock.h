@@ -0,0 +1,114 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#include <atomic>
+
+// The process which hosts the sandboxed plugins, see PluginSandbox
+#define HELIO_SANDBOX_PROCESS_ID "helio-plugin-sandbox"
+
+/*
+    The memory shared between the host and the sandbox process, mapped
+    from the same temp file by both of them; it is a single-slot ring:
+    the host writes the block's input and bumps the requested counter,
+    the sandbox processes it in place and bumps the completed counter,
+    so there's nothing to lock, and each side only writes its own counter.
+
+    The atomics used here are lock-free for 32-bit values on all supported
+    platforms, which also makes them address-free, i.e. safe to share
+    between the processes.
+*/
+
+struct SandboxSharedBlock final
+{
+    static constexpr int maxChannels = 32;
+    static constexpr int maxBlockSize = 8192;
+    static constexpr int maxMidiBytes = 64 * 1024;
+
+    std::atomic<uint32> requestedBlock;
+    std::atomic<uint32> completedBlock;
+    std::atomic<uint32> shouldExit;
+
+    // written by the host before requesting a block
+    int32 numSamples;
+    int32 numChannels;
+    int32 numMidiInBytes;
+
+    // written by the sandbox before completing a block
+    int32 numMidiOutBytes;
+    float processingMicroseconds;
+
+    float audio[maxChannels][maxBlockSize];
+    uint8 midiIn[maxMidiBytes];
+    uint8 midiOut[maxMidiBytes];
+
+    // the events are packed as the sample offset, the size and the data;
+    // returns the number of bytes written, the ones which don't fit are dropped
+    static int writeMidi(const MidiBuffer &midi, uint8 *target) noexcept
+    {
+        int numBytes = 0;
+        MidiBuffer::Iterator it(midi);
+        const uint8 *data = nullptr;
+        int size = 0;
+        int position = 0;
+
+        while (it.getNextEvent(data, size, position))
+        {
+            const int eventBytes = int(sizeof(int32) + sizeof(uint16)) + size;
+            if (numBytes + eventBytes > maxMidiBytes || size > 0xffff)
+            {
+                break;
+            }
+
+            const auto offset = int32(position);
+            const auto length = uint16(size);
+            memcpy(target + numBytes, &offset, sizeof(int32));
+            memcpy(target + numBytes + sizeof(int32), &length, sizeof(uint16));
+            memcpy(target + numBytes + sizeof(int32) + sizeof(uint16), data, size_t(size));
+            numBytes += eventBytes;
+        }
+
+        return numBytes;
+    }
+
+    static void readMidi(const uint8 *source, int numBytes, MidiBuffer &target) noexcept
+    {
+        target.clear();
+
+        int i = 0;
+        const int headerSize = int(sizeof(int32) + sizeof(uint16));
+        while (i + headerSize <= jmin(numBytes, maxMidiBytes))
+        {
+            int32 offset = 0;
+            uint16 length = 0;
+            memcpy(&offset, source + i, sizeof(int32));
+            memcpy(&length, source + i + sizeof(int32), sizeof(uint16));
+            i += headerSize;
+
+            if (i + length > numBytes)
+            {
+                jassertfalse;
+                return;
+            }
+
+            target.addEvent(source + i, int(length), int(offset));
+            i += length;
+        }
+    }
+};
@@ -0,0 +1,334 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "Common.h"
+#include "SandboxedPlugin.h"
+#include "SandboxedPluginFormat.h"
+#include "SandboxSharedBlock.h"
+#include "SerializablePluginDescription.h"
+#include "SerializationKeys.h"
+#include "DocumentHelpers.h"
+#include "XmlSerializer.h"
+
+#define SANDBOX_LAUNCH_TIMEOUT_MS (20 * 1000)
+#define SANDBOX_REQUEST_TIMEOUT_MS (5 * 1000)
+#define SANDBOX_LOAD_AVERAGE_WEIGHT 0.05f
+#define SANDBOX_LOAD_MAX_DECAY 0.999f
+
+class SandboxedPlugin::Connection final : public ChildProcessMaster
+{
+public:
+
+    explicit Connection(SandboxedPlugin &owner) : owner(owner) {}
+
+    ~Connection() override
+    {
+        this->killSlaveProcess();
+    }
+
+    // both are called on the connection's thread
+    void handleMessageFromSlave(const MemoryBlock &data) override
+    {
+        this->owner.onReply(DocumentHelpers::read<XmlSerializer>(data.toString()));
+    }
+
+    void handleConnectionLost() override
+    {
+        this->owner.onConnectionLost();
+    }
+
+private:
+
+    SandboxedPlugin &owner;
+
+    JUCE_DECLARE_NON_COPYABLE(Connection)
+};
+
+SandboxedPlugin::SandboxedPlugin(const PluginDescription &sandboxedDescription) :
+    description(sandboxedDescription) {}
+
+SandboxedPlugin::~SandboxedPlugin()
+{
+    if (this->sharedBlock != nullptr)
+    {
+        this->sharedBlock->shouldExit.store(1, std::memory_order_release);
+    }
+
+    this->connection = nullptr;
+    this->sharedBlock = nullptr;
+    this->sharedMemory = nullptr;
+    this->sharedFile.deleteFile();
+}
+
+String SandboxedPlugin::launch(double sampleRate, int blockSize)
+{
+    this->sharedFile = DocumentHelpers::getTempSlot(Uuid().toString() + ".sandbox");
+    MemoryBlock emptyBlock(sizeof(SandboxSharedBlock), true);
+    if (!this->sharedFile.replaceWithData(emptyBlock.getData(), emptyBlock.getSize()))
+    {
+        return "Failed to create the shared memory file";
+    }
+
+    this->sharedMemory = makeUnique<MemoryMappedFile>(this->sharedFile, MemoryMappedFile::readWrite);
+    if (this->sharedMemory->getData() == nullptr ||
+        this->sharedMemory->getSize() < sizeof(SandboxSharedBlock))
+    {
+        return "Failed to map the shared memory file";
+    }
+
+    this->sharedBlock = static_cast<SandboxSharedBlock *>(this->sharedMemory->getData());
+
+    const auto myPath(File::getSpecialLocation(File::currentExecutableFile));
+    this->connection = makeUnique<Connection>(*this);
+    if (!this->connection->launchSlaveProcess(myPath, HELIO_SANDBOX_PROCESS_ID, 0, 0))
+    {
+        this->crashed = true;
+        return "Failed to start the sandbox process";
+    }
+
+    using namespace Serialization::Audio;
+    SerializedData request(Sandbox::load);
+    request.setProperty(Sandbox::sharedFile, this->sharedFile.getFullPathName());
+    request.setProperty(Sandbox::sampleRate, sampleRate);
+    request.setProperty(Sandbox::blockSize, blockSize);
+    const SerializablePluginDescription plugin(SandboxedPluginFormat::unwrap(this->description));
+    request.appendChild(plugin.serialize());
+
+    const auto loaded = this->sendRequest(request, SANDBOX_LAUNCH_TIMEOUT_MS);
+    if (!loaded.isValid())
+    {
+        return "The sandbox process has failed to respond";
+    }
+
+    const String error = loaded.getProperty(Sandbox::error);
+    if (error.isNotEmpty())
+    {
+        return error;
+    }
+
+    this->pluginAcceptsMidi = loaded.getProperty(Sandbox::acceptsMidi, false);
+    this->pluginProducesMidi = loaded.getProperty(Sandbox::producesMidi, false);
+    this->tailLengthSeconds = loaded.getProperty(Sandbox::tailLength, 0.0);
+    this->setLatencySamples(loaded.getProperty(Sandbox::latency, 0));
+
+    const int numInputs = jlimit(0, SandboxSharedBlock::maxChannels,
+        int(loaded.getProperty(pluginNumInputs, 0)));
+    const int numOutputs = jlimit(0, SandboxSharedBlock::maxChannels,
+        int(loaded.getProperty(pluginNumOutputs, 2)));
+    this->setPlayConfigDetails(numInputs, numOutputs, sampleRate, blockSize);
+
+    return {};
+}
+
+SandboxedPlugin::SandboxLoad SandboxedPlugin::getSandboxLoad() const noexcept
+{
+    SandboxLoad load;
+    load.averageRoundTripMicroseconds = this->averageRoundTrip.get();
+    load.maxRoundTripMicroseconds = this->maxRoundTrip.get();
+    load.averagePluginMicroseconds = this->averagePluginTime.get();
+    load.numDropouts = this->numDropouts.get();
+    load.hasCrashed = this->crashed.get();
+    return load;
+}
+
+//===----------------------------------------------------------------------===//
+// Control messages
+//===----------------------------------------------------------------------===//
+
+SerializedData SandboxedPlugin::sendRequest(const SerializedData &request, int timeoutMs)
+{
+    const ScopedLock lock(this->requestLock);
+
+    if (this->connection == nullptr || this->crashed.get())
+    {
+        return {};
+    }
+
+    String message;
+    XmlSerializer().saveToString(message, request);
+
+    this->replyEvent.reset();
+    this->reply = {};
+
+    if (!this->connection->sendMessageToSlave({ message.toRawUTF8(), message.getNumBytesAsUTF8() }) ||
+        !this->replyEvent.wait(timeoutMs))
+    {
+        DBG("Sandbox request has failed: " + request.getType().toString());
+        return {};
+    }
+
+    return this->reply;
+}
+
+void SandboxedPlugin::onReply(const SerializedData &message)
+{
+    jassert(message.hasType(Serialization::Audio::Sandbox::reply));
+    this->reply = message;
+    this->replyEvent.signal();
+}
+
+void SandboxedPlugin::onConnectionLost()
+{
+    DBG("Sandbox process is lost: " + this->description.name);
+    this->crashed = true;
+    this->replyEvent.signal();
+}
+
+//===----------------------------------------------------------------------===//
+// AudioPluginInstance
+//===----------------------------------------------------------------------===//
+
+void SandboxedPlugin::fillInPluginDescription(PluginDescription &result) const
+{
+    result = this->description;
+}
+
+//===----------------------------------------------------------------------===//
+// AudioProcessor
+//===----------------------------------------------------------------------===//
+
+const String SandboxedPlugin::getName() const
+{
+    return this->description.name;
+}
+
+void SandboxedPlugin::prepareToPlay(double sampleRate, int estimatedSamplesPerBlock)
+{
+    using namespace Serialization::Audio;
+    SerializedData request(Sandbox::prepare);
+    request.setProperty(Sandbox::sampleRate, sampleRate);
+    request.setProperty(Sandbox::blockSize, estimatedSamplesPerBlock);
+
+    const auto prepared = this->sendRequest(request, SANDBOX_REQUEST_TIMEOUT_MS);
+    if (prepared.isValid())
+    {
+        this->setLatencySamples(prepared.getProperty(Sandbox::latency, 0));
+    }
+}
+
+void SandboxedPlugin::releaseResources()
+{
+    this->sendRequest(SerializedData(Serialization::Audio::Sandbox::release),
+        SANDBOX_REQUEST_TIMEOUT_MS);
+}
+
+void SandboxedPlugin::processBlock(AudioBuffer<float> &buffer, MidiBuffer &midiMessages)
+{
+    auto *shared = this->sharedBlock;
+    const auto requested = shared != nullptr ?
+        shared->requestedBlock.load(std::memory_order_acquire) : 0;
+
+    // the sandbox might still be busy with the block it was late for,
+    // the input can't be overwritten until it's done with it
+    if (shared == nullptr || this->crashed.get() || this->getSampleRate() <= 0.0 ||
+        shared->completedBlock.load(std::memory_order_acquire) != requested)
+    {
+        buffer.clear();
+        midiMessages.clear();
+        return;
+    }
+
+    const int numSamples = jmin(buffer.getNumSamples(), SandboxSharedBlock::maxBlockSize);
+    const int numChannels = jmin(buffer.getNumChannels(), SandboxSharedBlock::maxChannels);
+    jassert(numSamples == buffer.getNumSamples());
+
+    for (int i = 0; i < numChannels; ++i)
+    {
+        memcpy(shared->audio[i], buffer.getReadPointer(i), sizeof(float) * size_t(numSamples));
+    }
+
+    shared->numSamples = numSamples;
+    shared->numChannels = numChannels;
+    shared->numMidiInBytes = SandboxSharedBlock::writeMidi(midiMessages, shared->midiIn);
+
+    const auto startTicks = Time::getHighResolutionTicks();
+    const auto timeoutTicks = Time::secondsToHighResolutionTicks(numSamples / this->getSampleRate());
+    shared->requestedBlock.store(requested + 1, std::memory_order_release);
+
+    // the whole point is not to block for longer than the block lasts:
+    // on a timeout this block is lost, the next one will wait for it to finish
+    while (shared->completedBlock.load(std::memory_order_acquire) != requested + 1)
+    {
+        if (Time::getHighResolutionTicks() - startTicks > timeoutTicks || this->crashed.get())
+        {
+            this->numDropouts += 1;
+            buffer.clear();
+            midiMessages.clear();
+            return;
+        }
+
+        Thread::yield();
+    }
+
+    for (int i = 0; i < numChannels; ++i)
+    {
+        memcpy(buffer.getWritePointer(i), shared->audio[i], sizeof(float) * size_t(numSamples));
+    }
+
+    SandboxSharedBlock::readMidi(shared->midiOut, shared->numMidiOutBytes, midiMessages);
+    this->updateSandboxLoad(startTicks, shared->processingMicroseconds);
+}
+
+void SandboxedPlugin::updateSandboxLoad(int64 startTicks, float pluginMicroseconds) noexcept
+{
+    const auto elapsedTicks = Time::getHighResolutionTicks() - startTicks;
+    const auto elapsedUs = float(Time::highResolutionTicksToSeconds(elapsedTicks) * 1000000.0);
+
+    const auto average = this->averageRoundTrip.get();
+    this->averageRoundTrip = average + (elapsedUs - average) * SANDBOX_LOAD_AVERAGE_WEIGHT;
+    this->maxRoundTrip = jmax(elapsedUs, this->maxRoundTrip.get() * SANDBOX_LOAD_MAX_DECAY);
+
+    const auto pluginAverage = this->averagePluginTime.get();
+    this->averagePluginTime = pluginAverage +
+        (pluginMicroseconds - pluginAverage) * SANDBOX_LOAD_AVERAGE_WEIGHT;
+}
+
+double SandboxedPlugin::getTailLengthSeconds() const
+{
+    return this->tailLengthSeconds;
+}
+
+bool SandboxedPlugin::acceptsMidi() const
+{
+    return this->pluginAcceptsMidi;
+}
+
+bool SandboxedPlugin::producesMidi() const
+{
+    return this->pluginProducesMidi;
+}
+
+void SandboxedPlugin::getStateInformation(MemoryBlock &destData)
+{
+    using namespace Serialization::Audio;
+    const auto state = this->sendRequest(SerializedData(Sandbox::getState),
+        SANDBOX_REQUEST_TIMEOUT_MS);
+
+    if (state.isValid())
+    {
+        destData.fromBase64Encoding(state.getProperty(pluginState).toString());
+    }
+}
+
+void SandboxedPlugin::setStateInformation(const void *data, int sizeInBytes)
+{
+    using namespace Serialization::Audio;
+    SerializedData request(Sandbox::setState);
+    request.setProperty(pluginState, MemoryBlock(data, size_t(sizeInBytes)).toBase64Encoding());
+    this->sendRequest(request, SANDBOX_REQUEST_TIMEOUT_MS);
+}
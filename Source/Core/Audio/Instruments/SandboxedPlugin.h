@@ -0,0 +1,122 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+struct SandboxSharedBlock;
+
+/*
+    A proxy for a plugin which runs in a separate process, see PluginSandbox:
+    if the plugin crashes or hangs, only the sandbox dies, and this instance
+    just keeps outputting silence.
+
+    The control messages, like loading the plugin or getting its state,
+    go through the child process' pipe, and each audio block is exchanged
+    through the shared memory, while the audio thread waits for the sandbox
+    to process it, at most for the block's duration; this round trip is
+    the cost of the sandboxing, as measured in getSandboxLoad.
+
+    The plugin's editor and parameters are not available in the sandbox.
+*/
+
+class SandboxedPlugin final : public AudioPluginInstance
+{
+public:
+
+    explicit SandboxedPlugin(const PluginDescription &sandboxedDescription);
+    ~SandboxedPlugin() override;
+
+    // starts the sandbox process and loads the plugin in it,
+    // blocks until it's done, returns the error message, if any
+    String launch(double sampleRate, int blockSize);
+
+    struct SandboxLoad final
+    {
+        // the time the host waits for each block, on average and at most
+        float averageRoundTripMicroseconds = 0.f;
+        float maxRoundTripMicroseconds = 0.f;
+        // the difference is the overhead of the sandboxing itself
+        float averagePluginMicroseconds = 0.f;
+        int numDropouts = 0;
+        bool hasCrashed = false;
+    };
+
+    SandboxLoad getSandboxLoad() const noexcept;
+
+    //===------------------------------------------------------------------===//
+    // AudioPluginInstance
+    //===------------------------------------------------------------------===//
+
+    void fillInPluginDescription(PluginDescription &description) const override;
+
+    //===------------------------------------------------------------------===//
+    // AudioProcessor
+    //===------------------------------------------------------------------===//
+
+    const String getName() const override;
+    void prepareToPlay(double sampleRate, int estimatedSamplesPerBlock) override;
+    void releaseResources() override;
+    void processBlock(AudioBuffer<float> &buffer, MidiBuffer &midiMessages) override;
+    double getTailLengthSeconds() const override;
+    bool acceptsMidi() const override;
+    bool producesMidi() const override;
+
+    AudioProcessorEditor *createEditor() override { return nullptr; }
+    bool hasEditor() const override { return false; }
+
+    int getNumPrograms() override { return 1; }
+    int getCurrentProgram() override { return 0; }
+    void setCurrentProgram(int index) override {}
+    const String getProgramName(int index) override { return {}; }
+    void changeProgramName(int index, const String &newName) override {}
+
+    void getStateInformation(MemoryBlock &destData) override;
+    void setStateInformation(const void *data, int sizeInBytes) override;
+
+private:
+
+    class Connection;
+    UniquePointer<Connection> connection;
+
+    // one request at a time, the sandbox replies to each of them in order
+    SerializedData sendRequest(const SerializedData &request, int timeoutMs);
+    CriticalSection requestLock;
+    WaitableEvent replyEvent;
+    SerializedData reply;
+    void onReply(const SerializedData &message);
+    void onConnectionLost();
+
+    const PluginDescription description;
+
+    File sharedFile;
+    UniquePointer<MemoryMappedFile> sharedMemory;
+    SandboxSharedBlock *sharedBlock = nullptr;
+
+    bool pluginAcceptsMidi = false;
+    bool pluginProducesMidi = false;
+    double tailLengthSeconds = 0.0;
+
+    Atomic<bool> crashed = false;
+    Atomic<int> numDropouts = 0;
+    Atomic<float> averageRoundTrip = 0.f;
+    Atomic<float> maxRoundTrip = 0.f;
+    Atomic<float> averagePluginTime = 0.f;
+    void updateSandboxLoad(int64 startTicks, float pluginMicroseconds) noexcept;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SandboxedPlugin)
+};
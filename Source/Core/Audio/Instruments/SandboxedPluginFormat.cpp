@@ -0,0 +1,107 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "Common.h"
+#include "SandboxedPluginFormat.h"
+#include "SandboxedPlugin.h"
+#include "BuiltInSynthFormat.h"
+#include "TaskPool.h"
+
+bool SandboxedPluginFormat::isSandboxed(const PluginDescription &description) noexcept
+{
+    return description.pluginFormatName == HELIO_SANDBOXED_PLUGIN_FORMAT_NAME;
+}
+
+bool SandboxedPluginFormat::canBeSandboxed(const PluginDescription &description) noexcept
+{
+#if HELIO_DESKTOP
+    // the built-in stuff is safe enough, and can't be used without the host anyway
+    return !SandboxedPluginFormat::isSandboxed(description) &&
+        description.pluginFormatName != HELIO_BUILT_IN_PLUGIN_FORMAT_NAME;
+#else
+    return false;
+#endif
+}
+
+PluginDescription SandboxedPluginFormat::wrap(const PluginDescription &description)
+{
+    jassert(SandboxedPluginFormat::canBeSandboxed(description));
+    PluginDescription result(description);
+    result.pluginFormatName = HELIO_SANDBOXED_PLUGIN_FORMAT_NAME;
+    result.fileOrIdentifier = description.pluginFormatName + "|" + description.fileOrIdentifier;
+    return result;
+}
+
+PluginDescription SandboxedPluginFormat::unwrap(const PluginDescription &description)
+{
+    if (!SandboxedPluginFormat::isSandboxed(description))
+    {
+        return description;
+    }
+
+    PluginDescription result(description);
+    result.pluginFormatName = description.fileOrIdentifier.upToFirstOccurrenceOf("|", false, false);
+    result.fileOrIdentifier = description.fileOrIdentifier.fromFirstOccurrenceOf("|", false, false);
+    return result;
+}
+
+String SandboxedPluginFormat::getName() const
+{
+    return HELIO_SANDBOXED_PLUGIN_FORMAT_NAME;
+}
+
+bool SandboxedPluginFormat::fileMightContainThisPluginType(const String &fileOrIdentifier)
+{
+    return fileOrIdentifier.containsChar('|');
+}
+
+bool SandboxedPluginFormat::doesPluginStillExist(const PluginDescription &description)
+{
+    const auto original = SandboxedPluginFormat::unwrap(description);
+    return File::isAbsolutePath(original.fileOrIdentifier) ?
+        File(original.fileOrIdentifier).exists() : true;
+}
+
+void SandboxedPluginFormat::createPluginInstance(const PluginDescription &description,
+    double initialSampleRate, int initialBufferSize, PluginCreationCallback callback)
+{
+    struct Launch final : ReferenceCountedObject
+    {
+        UniquePointer<SandboxedPlugin> plugin;
+        String error;
+    };
+
+    ReferenceCountedObjectPtr<Launch> launch(new Launch());
+    launch->plugin = makeUnique<SandboxedPlugin>(description);
+
+    App::Tasks().run([launch, initialSampleRate, initialBufferSize]()
+    {
+        launch->error = launch->plugin->launch(initialSampleRate, initialBufferSize);
+    },
+    TaskPool::Priority::Normal, {}, [launch, callback]()
+    {
+        if (launch->error.isNotEmpty())
+        {
+            DBG("Failed to sandbox the plugin: " + launch->error);
+            callback(nullptr, launch->error);
+            return;
+        }
+
+        callback(UniquePointer<AudioPluginInstance>(launch->plugin.release()), {});
+    });
+}
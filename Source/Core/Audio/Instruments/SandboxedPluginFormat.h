@@ -0,0 +1,85 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#define HELIO_SANDBOXED_PLUGIN_FORMAT_NAME "Sandboxed"
+
+// Any plugin's description can be wrapped into this format's one,
+// which keeps all its fields, except for the format name, and the id,
+// which also keeps the original format name; the instances are then
+// created in a separate process, see SandboxedPlugin
+
+class SandboxedPluginFormat final : public AudioPluginFormat
+{
+public:
+
+    SandboxedPluginFormat() = default;
+
+    static bool isSandboxed(const PluginDescription &description) noexcept;
+    static bool canBeSandboxed(const PluginDescription &description) noexcept;
+    static PluginDescription wrap(const PluginDescription &description);
+    static PluginDescription unwrap(const PluginDescription &description);
+
+    String getName() const override;
+
+    bool fileMightContainThisPluginType(const String &fileOrIdentifier) override;
+
+    FileSearchPath getDefaultLocationsToSearch() override
+    {
+        return FileSearchPath();
+    }
+
+    bool canScanForPlugins() const override
+    {
+        return false;
+    }
+
+    void findAllTypesForFile(OwnedArray<PluginDescription> &, const String &) override {}
+
+    bool doesPluginStillExist(const PluginDescription &description) override;
+
+    String getNameOfPluginFromIdentifier(const String &fileOrIdentifier) override
+    {
+        return fileOrIdentifier.fromFirstOccurrenceOf("|", false, false);
+    }
+
+    bool pluginNeedsRescanning(const PluginDescription &) override
+    {
+        return false;
+    }
+
+    StringArray searchPathsForPlugins(const FileSearchPath &, bool, bool) override
+    {
+        return StringArray();
+    }
+
+    // the sandbox process is started and the plugin is loaded there
+    // in a background thread, the callback is called on the message thread
+    void createPluginInstance(const PluginDescription &, double initialSampleRate,
+        int initialBufferSize, PluginCreationCallback) override;
+
+    bool requiresUnblockedMessageThreadDuringCreation(const PluginDescription &) const noexcept override
+    {
+        return false;
+    }
+
+private:
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SandboxedPluginFormat)
+};
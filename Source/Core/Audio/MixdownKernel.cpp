@@ -0,0 +1,59 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Common.h"
+#include "MixdownKernel.h"
+
+// 1024 bytes of floats, so that a tile of the destination, and the tiles
+// of the sources being read, comfortably fit into the L1 cache together
+#define MIXDOWN_KERNEL_TILE_SIZE 256
+
+template <typename T>
+static void mixTiles(T *destination, const T *const *sources,
+    const T *gains, int numSources, int numSamples) noexcept
+{
+    if (numSources == 0)
+    {
+        FloatVectorOperations::clear(destination, numSamples);
+        return;
+    }
+
+    for (int start = 0; start < numSamples; start += MIXDOWN_KERNEL_TILE_SIZE)
+    {
+        const int tileSize = jmin(MIXDOWN_KERNEL_TILE_SIZE, numSamples - start);
+        T *tile = destination + start;
+
+        FloatVectorOperations::copyWithMultiply(tile, sources[0] + start, gains[0], tileSize);
+
+        for (int i = 1; i < numSources; ++i)
+        {
+            FloatVectorOperations::addWithMultiply(tile, sources[i] + start, gains[i], tileSize);
+        }
+    }
+}
+
+void MixdownKernel::process(float *destination, const float *const *sources,
+    const float *gains, int numSources, int numSamples) noexcept
+{
+    mixTiles(destination, sources, gains, numSources, numSamples);
+}
+
+void MixdownKernel::process(double *destination, const double *const *sources,
+    const double *gains, int numSources, int numSamples) noexcept
+{
+    mixTiles(destination, sources, gains, numSources, numSamples);
+}
@@ -0,0 +1,36 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+/*
+    Sums any number of sources into one destination, each with its own gain,
+    in a single pass over the destination: it goes tile by tile, and each tile
+    stays in the cache while all the sources are added into it with the
+    vectorized operations, instead of sweeping the whole destination once
+    per source; the first source overwrites the tile, so the destination
+    doesn't need to be cleared, unless there are no sources at all.
+*/
+
+struct MixdownKernel final
+{
+    static void process(float *destination, const float *const *sources,
+        const float *gains, int numSources, int numSamples) noexcept;
+
+    static void process(double *destination, const double *const *sources,
+        const double *gains, int numSources, int numSamples) noexcept;
+};
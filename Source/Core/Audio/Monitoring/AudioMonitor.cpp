@@ -18,6 +18,7 @@
 #include "Common.h"
 #include "AudioMonitor.h"
 #include "AudioCore.h"
+#include "RealtimeSafety.h"
 
 class ClippingWarningAsyncCallback final : public AsyncUpdater
 {
@@ -59,13 +60,62 @@ private:
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(OversaturationWarningAsyncCallback)
 };
 
+//===----------------------------------------------------------------------===//
+// Metering kernels
+//===----------------------------------------------------------------------===//
+
+static inline float getAbsolutePeak(const float *samples, int numSamples) noexcept
+{
+    // vectorized, and takes the negative peaks into account
+    const auto range = FloatVectorOperations::findMinAndMax(samples, numSamples);
+    return jmax(-range.getStart(), range.getEnd());
+}
+
+static inline float getSquaresSum(const float *samples, int numSamples) noexcept
+{
+    // four independent accumulators let the compiler
+    // keep them in a single vector register
+    float sums[4] = { 0.f, 0.f, 0.f, 0.f };
+
+    int i = 0;
+    for (; i + 4 <= numSamples; i += 4)
+    {
+        sums[0] += samples[i] * samples[i];
+        sums[1] += samples[i + 1] * samples[i + 1];
+        sums[2] += samples[i + 2] * samples[i + 2];
+        sums[3] += samples[i + 3] * samples[i + 3];
+    }
+
+    for (; i < numSamples; ++i)
+    {
+        sums[0] += samples[i] * samples[i];
+    }
+
+    return (sums[0] + sums[1]) + (sums[2] + sums[3]);
+}
+
 AudioMonitor::AudioMonitor() :
+    Thread("Spectrum analysis"),
     fft(),
+    fifo(AUDIO_MONITOR_FIFO_SIZE),
+    fifoBuffer(AUDIO_MONITOR_NUM_CHANNELS, AUDIO_MONITOR_FIFO_SIZE),
+    analysisBuffer(AUDIO_MONITOR_NUM_CHANNELS, AUDIO_MONITOR_FFT_SIZE),
     spectrumSize(AUDIO_MONITOR_SPECTRUM_SIZE),
-    sampleRate(AUDIO_MONITOR_NUM_CHANNELS)
+    sampleRate(AUDIO_MONITOR_SAMPLE_RATE)
 {
+    this->fifoBuffer.clear();
+    this->analysisBuffer.clear();
+    zerostruct(this->spectrum);
+
     this->asyncClippingWarning = makeUnique<ClippingWarningAsyncCallback>(*this);
     this->asyncOversaturationWarning = makeUnique<OversaturationWarningAsyncCallback>(*this);
+
+    this->startThread(4);
+}
+
+AudioMonitor::~AudioMonitor()
+{
+    this->stopThread(1000);
 }
 
 //===----------------------------------------------------------------------===//
@@ -75,6 +125,12 @@ AudioMonitor::AudioMonitor() :
 void AudioMonitor::audioDeviceAboutToStart(AudioIODevice *device)
 {
     this->sampleRate = device->getCurrentSampleRate();
+    this->loudnessMeter.prepare(device->getCurrentSampleRate());
+
+    for (auto &truePeakDetector : this->truePeakDetectors)
+    {
+        truePeakDetector.reset();
+    }
 }
 
 void AudioMonitor::audioDeviceIOCallback(const float **inputChannelData,
@@ -83,30 +139,50 @@ void AudioMonitor::audioDeviceIOCallback(const float **inputChannelData,
                                          int numOutputChannels,
                                          int numSamples)
 {
+    REALTIME_SCOPE("AudioMonitor::audioDeviceIOCallback");
+    const ScopedNoDenormals noDenormals;
+
     const int numChannels = jmin(AUDIO_MONITOR_NUM_CHANNELS, numOutputChannels);
-    
-    for (int channel = 0; channel < numChannels; ++channel)
+
+    if (numChannels > 0)
     {
-        this->fft.computeSpectrum(outputChannelData[channel], 0, numSamples,
-            this->spectrum[channel], this->spectrumSize.get(),
-            channel, numOutputChannels);
+        // if the analysis thread lags behind, the samples which don't fit are dropped,
+        // it only needs the last window of them anyway
+        int start1, size1, start2, size2;
+        this->fifo.prepareToWrite(numSamples, start1, size1, start2, size2);
+
+        for (int channel = 0; channel < AUDIO_MONITOR_NUM_CHANNELS; ++channel)
+        {
+            const float *source = outputChannelData[jmin(channel, numChannels - 1)];
+            this->fifoBuffer.copyFrom(channel, start1, source, size1);
+            this->fifoBuffer.copyFrom(channel, start2, source + size1, size2);
+        }
+
+        this->fifo.finishedWrite(size1 + size2);
     }
-    
+
+
+    if (this->loudnessResetRequested.compareAndSetBool(false, true))
+    {
+        this->loudnessMeter.reset();
+    }
+
+    this->loudnessMeter.process(const_cast<const float **>(outputChannelData), numChannels, numSamples);
+
+    Levels newLevels;
+    newLevels.momentaryLoudness = this->loudnessMeter.getMomentaryLoudness();
+    newLevels.integratedLoudness = this->loudnessMeter.getIntegratedLoudness();
+
     for (int channel = 0; channel < numChannels; ++channel)
     {
-        float pcmSquaresSum = 0.f;
-        float pcmPeak = 0.f;
-        for (int samplePosition = 0; samplePosition < numSamples; ++samplePosition)
-        {
-            const float &pcmData = outputChannelData[channel][samplePosition];
-            pcmSquaresSum += (pcmData * pcmData);
-            pcmPeak = jmax(pcmPeak, pcmData);
-        }
-        
-        const float rootMeanSquare = sqrtf(pcmSquaresSum / numSamples);
-        this->rms[channel] = rootMeanSquare;
-        this->peak[channel] = pcmPeak;
-        
+        const float *pcmData = outputChannelData[channel];
+        const float pcmPeak = getAbsolutePeak(pcmData, numSamples);
+        const float rootMeanSquare = sqrtf(getSquaresSum(pcmData, numSamples) / numSamples);
+
+        newLevels.peak[channel] = pcmPeak;
+        newLevels.rms[channel] = rootMeanSquare;
+        newLevels.truePeak[channel] = this->truePeakDetectors[channel].process(pcmData, numSamples);
+
         if (pcmPeak > AUDIO_MONITOR_CLIP_THRESHOLD)
         {
             this->asyncClippingWarning->triggerAsyncUpdate();
@@ -119,6 +195,12 @@ void AudioMonitor::audioDeviceIOCallback(const float **inputChannelData,
         }
     }
 
+    this->levelsVersion += 1;
+    std::atomic_thread_fence(std::memory_order_release);
+    this->levels = newLevels;
+    std::atomic_thread_fence(std::memory_order_release);
+    this->levelsVersion += 1;
+
     for (int i = 0; i < numOutputChannels; ++i)
     {
         FloatVectorOperations::clear(outputChannelData[i], numSamples);
@@ -127,6 +209,59 @@ void AudioMonitor::audioDeviceIOCallback(const float **inputChannelData,
 
 void AudioMonitor::audioDeviceStopped() {}
 
+//===----------------------------------------------------------------------===//
+// Thread
+//===----------------------------------------------------------------------===//
+
+void AudioMonitor::run()
+{
+    const ScopedNoDenormals noDenormals;
+    const int fftSize = AUDIO_MONITOR_FFT_SIZE;
+
+    while (!this->threadShouldExit())
+    {
+        // the monitor components poll the spectrum at about the same rate
+        this->wait(30);
+
+        const int numReady = this->fifo.getNumReady();
+        if (numReady == 0)
+        {
+            continue;
+        }
+
+        // skip whatever doesn't fit into the window
+        const int numNewSamples = jmin(numReady, fftSize);
+        int start1, size1, start2, size2;
+        this->fifo.prepareToRead(numReady - numNewSamples, start1, size1, start2, size2);
+        this->fifo.finishedRead(size1 + size2);
+
+        this->fifo.prepareToRead(numNewSamples, start1, size1, start2, size2);
+        for (int channel = 0; channel < AUDIO_MONITOR_NUM_CHANNELS; ++channel)
+        {
+            float *window = this->analysisBuffer.getWritePointer(channel);
+            const int numOldSamples = fftSize - (size1 + size2);
+            memmove(window, window + (fftSize - numOldSamples), numOldSamples * sizeof(float));
+
+            this->analysisBuffer.copyFrom(channel, numOldSamples,
+                this->fifoBuffer, channel, start1, size1);
+
+            this->analysisBuffer.copyFrom(channel, numOldSamples + size1,
+                this->fifoBuffer, channel, start2, size2);
+        }
+        this->fifo.finishedRead(size1 + size2);
+
+        const int nextFrame = 1 - this->spectrumFrame.get();
+        for (int channel = 0; channel < AUDIO_MONITOR_NUM_CHANNELS; ++channel)
+        {
+            this->fft.computeSpectrum(this->analysisBuffer.getReadPointer(channel),
+                0, fftSize, this->spectrum[nextFrame][channel], fftSize,
+                channel, AUDIO_MONITOR_NUM_CHANNELS);
+        }
+
+        this->spectrumFrame = nextFrame;
+    }
+}
+
 //===----------------------------------------------------------------------===//
 // Spectrum data
 //===----------------------------------------------------------------------===//
@@ -135,18 +270,18 @@ float AudioMonitor::getInterpolatedSpectrumAtFrequency(float frequency) const
 {
     const float resolution = 
         float(this->sampleRate.get() / 2.f) / float(this->spectrumSize.get());
+
+    const auto &frame = this->spectrum[this->spectrumFrame.get()];
     
     const int index1 = roundToInt(frequency / resolution);
-    const int safeIndex1 = jlimit(0, this->spectrumSize.get(), index1);
+    const int safeIndex1 = jlimit(0, this->spectrumSize.get() - 1, index1);
     const float f1 = index1 * resolution;
-    const float y1 = (this->spectrum[0][safeIndex1].get() +
-                      this->spectrum[1][safeIndex1].get()) / 2.f;
+    const float y1 = (frame[0][safeIndex1] + frame[1][safeIndex1]) / 2.f;
     
     const int index2 = index1 + 1;
-    const int safeIndex2 = jlimit(0, this->spectrumSize.get(), index2);
+    const int safeIndex2 = jlimit(0, this->spectrumSize.get() - 1, index2);
     const float f2 = index2 * resolution;
-    const float y2 = (this->spectrum[0][safeIndex2].get() +
-                      this->spectrum[1][safeIndex2].get()) / 2.f;
+    const float y2 = (frame[0][safeIndex2] + frame[1][safeIndex2]) / 2.f;
     
     return y1 + ((AudioCore::fastLog10(frequency) - AudioCore::fastLog10(f1)) /
                  (AudioCore::fastLog10(f2) - AudioCore::fastLog10(f1))) * (y2 - y1);
@@ -175,12 +310,26 @@ ListenerList<AudioMonitor::ClippingListener> &AudioMonitor::getListeners() noexc
 // Volume data
 //===----------------------------------------------------------------------===//
 
-float AudioMonitor::getPeak(int channel) const
+AudioMonitor::Levels AudioMonitor::getLevels() const noexcept
 {
-    return this->peak[channel].get();
+    for (;;)
+    {
+        const auto version = this->levelsVersion.get();
+        if ((version & 1) == 0)
+        {
+            const Levels result = this->levels;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (this->levelsVersion.get() == version)
+            {
+                return result;
+            }
+        }
+
+        Thread::yield();
+    }
 }
 
-float AudioMonitor::getRootMeanSquare(int channel) const
+void AudioMonitor::resetLoudness() noexcept
 {
-    return this->rms[channel].get();
+    this->loudnessResetRequested = true;
 }
@@ -18,20 +18,25 @@
 #pragma once
 
 #include "SpectrumAnalyzer.h"
+#include "LoudnessMeter.h"
 
-// 256 == we don't need that high resolution on a spectrum
-#define AUDIO_MONITOR_SPECTRUM_SIZE                 256
+// the spectrum is computed on the analysis thread, so the FFT
+// size isn't limited by the audio callback's time budget anymore
+#define AUDIO_MONITOR_FFT_SIZE                      2048
+#define AUDIO_MONITOR_SPECTRUM_SIZE                 (AUDIO_MONITOR_FFT_SIZE / 2)
+#define AUDIO_MONITOR_FIFO_SIZE                     (AUDIO_MONITOR_FFT_SIZE * 4)
 #define AUDIO_MONITOR_NUM_CHANNELS                  2
 #define AUDIO_MONITOR_SAMPLE_RATE                   44100
 #define AUDIO_MONITOR_CLIP_THRESHOLD                0.995f
 #define AUDIO_MONITOR_OVERSATURATION_THRESHOLD      0.5f
 #define AUDIO_MONITOR_OVERSATURATION_RATE           4.f
 
-class AudioMonitor final : public AudioIODeviceCallback
+class AudioMonitor final : public AudioIODeviceCallback, private Thread
 {
 public:
     
     AudioMonitor();
+    ~AudioMonitor() override;
 
     //===------------------------------------------------------------------===//
     // AudioIODeviceCallback
@@ -61,9 +66,25 @@ public:
     //===------------------------------------------------------------------===//
     // Volume data
     //===------------------------------------------------------------------===//
-    
-    float getPeak(int channel) const;
-    float getRootMeanSquare(int channel) const;
+
+    struct Levels final
+    {
+        float peak[AUDIO_MONITOR_NUM_CHANNELS] = {};
+        float rms[AUDIO_MONITOR_NUM_CHANNELS] = {};
+        float truePeak[AUDIO_MONITOR_NUM_CHANNELS] = {};
+
+        // in LUFS
+        float momentaryLoudness = LOUDNESS_METER_MIN_LOUDNESS;
+        float integratedLoudness = LOUDNESS_METER_MIN_LOUDNESS;
+    };
+
+    // a consistent snapshot of the levels of the last processed block,
+    // lock-free, so it can be polled from any thread at any rate
+    Levels getLevels() const noexcept;
+
+    // the integrated loudness is measured since the last reset,
+    // which is applied by the audio thread at the next block
+    void resetLoudness() noexcept;
     
     //===------------------------------------------------------------------===//
     // Spectrum data
@@ -73,11 +94,29 @@ public:
     
 private:
 
+    // the analysis thread
+    void run() override;
+
     SpectrumFFT fft;
 
-    Atomic<float> spectrum[AUDIO_MONITOR_NUM_CHANNELS][AUDIO_MONITOR_SPECTRUM_SIZE];
-    Atomic<float> peak[AUDIO_MONITOR_NUM_CHANNELS];
-    Atomic<float> rms[AUDIO_MONITOR_NUM_CHANNELS];
+    // the audio thread only copies the samples into the fifo,
+    // the analysis thread keeps the last FFT-sized window of them
+    AbstractFifo fifo;
+    AudioBuffer<float> fifoBuffer;
+    AudioBuffer<float> analysisBuffer;
+
+    // double-buffered: the analysis thread fills the frame
+    // which is not current, and then makes it current
+    float spectrum[2][AUDIO_MONITOR_NUM_CHANNELS][AUDIO_MONITOR_SPECTRUM_SIZE];
+    Atomic<int> spectrumFrame = 0;
+    TruePeakDetector truePeakDetectors[AUDIO_MONITOR_NUM_CHANNELS];
+    LoudnessMeter loudnessMeter;
+    Atomic<bool> loudnessResetRequested = false;
+
+    // a seqlock: the audio thread makes the counter odd while writing
+    // the snapshot, and the readers retry if it was odd or has changed
+    Levels levels;
+    Atomic<uint32> levelsVersion = 0;
 
     Atomic<int> spectrumSize;
     Atomic<double> sampleRate;
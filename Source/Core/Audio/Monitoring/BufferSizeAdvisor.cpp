@@ -0,0 +1,154 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Common.h"
+#include "BufferSizeAdvisor.h"
+#include "AudioEngine.h"
+
+#define BUFFER_SIZE_ADVISOR_POLL_MS 500
+
+// the loads, in percents of the block duration, which make it switch
+// to a larger size, and back to a smaller one, and the load to fit into
+#define BUFFER_SIZE_ADVISOR_OVERLOAD 85.f
+#define BUFFER_SIZE_ADVISOR_UNDERLOAD 30.f
+#define BUFFER_SIZE_ADVISOR_TARGET_LOAD 60.f
+
+BufferSizeAdvisor::BufferSizeAdvisor(AudioDeviceManager &deviceManager, AudioEngine &engine) :
+    deviceManager(deviceManager),
+    engine(engine) {}
+
+void BufferSizeAdvisor::setMode(Mode newMode)
+{
+    this->mode = newMode;
+    this->suggestedBufferSize = 0;
+    this->sessionMaxLoad = 0.f;
+    this->engine.getAndResetMaxLoad();
+
+    auto *device = this->deviceManager.getCurrentAudioDevice();
+    if (this->preferredBufferSize == 0 && device != nullptr)
+    {
+        this->preferredBufferSize = device->getCurrentBufferSizeSamples();
+    }
+
+    if (newMode == Mode::Off)
+    {
+        this->stopTimer();
+    }
+    else
+    {
+        this->startTimer(BUFFER_SIZE_ADVISOR_POLL_MS);
+    }
+}
+
+BufferSizeAdvisor::Mode BufferSizeAdvisor::getMode() const noexcept
+{
+    return this->mode;
+}
+
+void BufferSizeAdvisor::setPreferredBufferSize(int bufferSize)
+{
+    this->preferredBufferSize = bufferSize;
+    this->suggestedBufferSize = 0;
+    this->sessionMaxLoad = 0.f;
+}
+
+int BufferSizeAdvisor::getPreferredBufferSize() const noexcept
+{
+    return this->preferredBufferSize;
+}
+
+int BufferSizeAdvisor::getSuggestedBufferSize() const noexcept
+{
+    return this->suggestedBufferSize;
+}
+
+void BufferSizeAdvisor::timerCallback()
+{
+    this->sessionMaxLoad = jmax(this->sessionMaxLoad, this->engine.getAndResetMaxLoad());
+}
+
+void BufferSizeAdvisor::onIdle()
+{
+    if (this->mode == Mode::Off)
+    {
+        return;
+    }
+
+    auto *device = this->deviceManager.getCurrentAudioDevice();
+    if (device == nullptr)
+    {
+        return;
+    }
+
+    this->timerCallback();
+    const auto maxLoad = this->sessionMaxLoad;
+    this->sessionMaxLoad = 0.f;
+
+    const int currentBufferSize = device->getCurrentBufferSizeSamples();
+    const bool isAbovePreferred = currentBufferSize > this->preferredBufferSize;
+    if (maxLoad < BUFFER_SIZE_ADVISOR_OVERLOAD &&
+        (maxLoad > BUFFER_SIZE_ADVISOR_UNDERLOAD || !isAbovePreferred))
+    {
+        this->suggestedBufferSize = 0;
+        return;
+    }
+
+    const int newBufferSize = this->findBufferSizeFor(maxLoad, currentBufferSize);
+    this->suggestedBufferSize = (newBufferSize != currentBufferSize) ? newBufferSize : 0;
+
+    if (this->mode == Mode::Automatic && this->suggestedBufferSize > 0)
+    {
+        DBG("Switching the buffer size to " + String(this->suggestedBufferSize));
+
+        AudioDeviceManager::AudioDeviceSetup deviceSetup;
+        this->deviceManager.getAudioDeviceSetup(deviceSetup);
+        deviceSetup.bufferSize = this->suggestedBufferSize;
+        this->deviceManager.setAudioDeviceSetup(deviceSetup, true);
+
+        // the first blocks after the restart are not representative
+        this->suggestedBufferSize = 0;
+        this->engine.getAndResetMaxLoad();
+    }
+}
+
+// Assuming that processing costs the same per sample, whatever the block size,
+// which is a bit optimistic for the smaller sizes, hence the margins above
+int BufferSizeAdvisor::findBufferSizeFor(float maxLoad, int currentBufferSize) const
+{
+    auto *device = this->deviceManager.getCurrentAudioDevice();
+    auto bufferSizes = device->getAvailableBufferSizes();
+    bufferSizes.sort();
+
+    int lastFitting = currentBufferSize;
+    for (const auto bufferSize : bufferSizes)
+    {
+        if (bufferSize < this->preferredBufferSize)
+        {
+            continue;
+        }
+
+        lastFitting = bufferSize;
+        const auto estimatedLoad = maxLoad * float(currentBufferSize) / float(bufferSize);
+        if (estimatedLoad < BUFFER_SIZE_ADVISOR_TARGET_LOAD)
+        {
+            return bufferSize;
+        }
+    }
+
+    // nothing fits, so go for the largest one
+    return lastFitting;
+}
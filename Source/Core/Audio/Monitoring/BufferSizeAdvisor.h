@@ -0,0 +1,76 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+class AudioEngine;
+
+/*
+    Watches the engine's load and finds the buffer size which fits it:
+    the size chosen by the user is the preferred one, and when a block
+    gets close to a dropout, a larger size is recommended, or, in the
+    automatic mode, switched to; as soon as the load allows, it goes back
+    to the preferred size the same way. Changing the size restarts the
+    device, so it only happens when the audio core falls asleep, i.e.
+    nothing is playing, and the decision is based on the loads measured
+    since it has woken up, e.g. during the last playback.
+*/
+
+class BufferSizeAdvisor final : private Timer
+{
+public:
+
+    BufferSizeAdvisor(AudioDeviceManager &deviceManager, AudioEngine &engine);
+
+    enum class Mode : int
+    {
+        Off = 0,
+        Suggest = 1,
+        Automatic = 2
+    };
+
+    void setMode(Mode newMode);
+    Mode getMode() const noexcept;
+
+    // the adaptive sizes never go below this one
+    void setPreferredBufferSize(int bufferSize);
+    int getPreferredBufferSize() const noexcept;
+
+    // zero, if the current size fits the load
+    int getSuggestedBufferSize() const noexcept;
+
+    // called by the audio core when it falls asleep
+    void onIdle();
+
+private:
+
+    void timerCallback() override;
+
+    int findBufferSizeFor(float maxLoad, int currentBufferSize) const;
+
+    AudioDeviceManager &deviceManager;
+    AudioEngine &engine;
+
+    Mode mode = Mode::Off;
+    int preferredBufferSize = 0;
+    int suggestedBufferSize = 0;
+
+    // the largest load since the core has woken up last time
+    float sessionMaxLoad = 0.f;
+
+    JUCE_DECLARE_NON_COPYABLE(BufferSizeAdvisor)
+};
@@ -0,0 +1,301 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Common.h"
+#include "LoudnessMeter.h"
+
+#define LOUDNESS_SUBBLOCK_MS (100)
+#define LOUDNESS_RELATIVE_GATE (-10.f)
+
+static inline float energyToLoudness(double meanSquare) noexcept
+{
+    return meanSquare > 0.0 ? float(-0.691 + 10.0 * std::log10(meanSquare)) :
+        std::numeric_limits<float>::lowest();
+}
+
+//===----------------------------------------------------------------------===//
+// TruePeakDetector
+//===----------------------------------------------------------------------===//
+
+TruePeakDetector::TruePeakDetector()
+{
+    // a windowed sinc interpolation filter, split into the polyphase form,
+    // the phase 0 just passes the original samples, delayed by a half of the filter
+    const int numTaps = oversampling * tapsPerPhase;
+    const double centre = numTaps / 2;
+
+    for (int tap = 0; tap < numTaps; ++tap)
+    {
+        const double x = (tap - centre) / oversampling;
+        const double sinc = (x == 0.0) ? 1.0 : std::sin(MathConstants<double>::pi * x) / (MathConstants<double>::pi * x);
+        const double window = 0.5 - 0.5 * std::cos(MathConstants<double>::twoPi * tap / numTaps);
+
+        // the taps are stored reversed, to be multiplied by the history in order
+        this->coefficients[tap % oversampling][tapsPerPhase - 1 - tap / oversampling] = float(sinc * window);
+    }
+
+    this->reset();
+}
+
+void TruePeakDetector::reset() noexcept
+{
+    FloatVectorOperations::clear(this->history, tapsPerPhase * 2);
+    this->historyPosition = 0;
+}
+
+float TruePeakDetector::process(const float *samples, int numSamples) noexcept
+{
+    float peak = 0.f;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        this->history[this->historyPosition] = samples[i];
+        this->history[this->historyPosition + tapsPerPhase] = samples[i];
+        this->historyPosition = (this->historyPosition + 1) % tapsPerPhase;
+
+        // the oldest sample is at historyPosition, the newest one is the last
+        const float *x = this->history + this->historyPosition;
+
+        for (int phase = 0; phase < oversampling; ++phase)
+        {
+            const float *h = this->coefficients[phase];
+
+            float y = 0.f;
+            for (int k = 0; k < tapsPerPhase; ++k)
+            {
+                y += h[k] * x[k];
+            }
+
+            peak = jmax(peak, std::abs(y));
+        }
+    }
+
+    return peak;
+}
+
+//===----------------------------------------------------------------------===//
+// LoudnessMeter
+//===----------------------------------------------------------------------===//
+
+void LoudnessMeter::Biquad::reset() noexcept
+{
+    this->z1 = 0.0;
+    this->z2 = 0.0;
+}
+
+inline float LoudnessMeter::Biquad::process(float x) noexcept
+{
+    const double y = this->b0 * x + this->z1;
+    this->z1 = this->b1 * x - this->a1 * y + this->z2;
+    this->z2 = this->b2 * x - this->a2 * y;
+    return float(y);
+}
+
+LoudnessMeter::LoudnessMeter()
+{
+    this->prepare(44100.0);
+}
+
+void LoudnessMeter::prepare(double sampleRate) noexcept
+{
+    jassert(sampleRate > 0.0);
+
+    // the K-weighting filter coefficients for an arbitrary sample rate,
+    // the first stage is a high shelf, modelling the head,
+    // the second one is a high pass (the revised low frequency B curve)
+    {
+        const double f0 = 1681.974450955533;
+        const double gain = 3.999843853973347;
+        const double q = 0.7071752369554196;
+        const double k = std::tan(MathConstants<double>::pi * f0 / sampleRate);
+        const double vh = std::pow(10.0, gain / 20.0);
+        const double vb = std::pow(vh, 0.4996667741545416);
+        const double a0 = 1.0 + k / q + k * k;
+
+        for (auto &filter : this->preFilter)
+        {
+            filter.b0 = (vh + vb * k / q + k * k) / a0;
+            filter.b1 = 2.0 * (k * k - vh) / a0;
+            filter.b2 = (vh - vb * k / q + k * k) / a0;
+            filter.a1 = 2.0 * (k * k - 1.0) / a0;
+            filter.a2 = (1.0 - k / q + k * k) / a0;
+        }
+    }
+
+    {
+        const double f0 = 38.13547087602444;
+        const double q = 0.5003270373238773;
+        const double k = std::tan(MathConstants<double>::pi * f0 / sampleRate);
+        const double a0 = 1.0 + k / q + k * k;
+
+        for (auto &filter : this->highPassFilter)
+        {
+            filter.b0 = 1.0;
+            filter.b1 = -2.0;
+            filter.b2 = 1.0;
+            filter.a1 = 2.0 * (k * k - 1.0) / a0;
+            filter.a2 = (1.0 - k / q + k * k) / a0;
+        }
+    }
+
+    this->subBlockLength = jmax(1, int(sampleRate * LOUDNESS_SUBBLOCK_MS / 1000.0));
+    this->reset();
+}
+
+void LoudnessMeter::reset() noexcept
+{
+    for (int i = 0; i < LOUDNESS_METER_NUM_CHANNELS; ++i)
+    {
+        this->preFilter[i].reset();
+        this->highPassFilter[i].reset();
+    }
+
+    for (auto &subBlock : this->subBlocks)
+    {
+        subBlock = 0.0;
+    }
+
+    this->subBlockIndex = 0;
+    this->numSubBlocksFilled = 0;
+    this->currentSubBlock = 0.0;
+    this->currentSubBlockLength = 0;
+
+    for (int i = 0; i < numHistogramBins; ++i)
+    {
+        this->histogramEnergy[i] = 0.0;
+        this->histogramCount[i] = 0;
+    }
+
+    this->momentaryLoudness = LOUDNESS_METER_MIN_LOUDNESS;
+    this->integratedLoudness = LOUDNESS_METER_MIN_LOUDNESS;
+}
+
+void LoudnessMeter::process(const float **channelData, int numChannels, int numSamples) noexcept
+{
+    numChannels = jmin(numChannels, LOUDNESS_METER_NUM_CHANNELS);
+
+    int position = 0;
+    while (position < numSamples)
+    {
+        const int numToProcess = jmin(numSamples - position,
+            this->subBlockLength - this->currentSubBlockLength);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            auto &preFilter = this->preFilter[channel];
+            auto &highPassFilter = this->highPassFilter[channel];
+            const float *samples = channelData[channel] + position;
+
+            double squaresSum = 0.0;
+            for (int i = 0; i < numToProcess; ++i)
+            {
+                const float y = highPassFilter.process(preFilter.process(samples[i]));
+                squaresSum += y * y;
+            }
+
+            // both stereo channels have the weight of 1.0
+            this->currentSubBlock += squaresSum;
+        }
+
+        position += numToProcess;
+        this->currentSubBlockLength += numToProcess;
+
+        if (this->currentSubBlockLength == this->subBlockLength)
+        {
+            this->subBlocks[this->subBlockIndex] = this->currentSubBlock / this->subBlockLength;
+            this->subBlockIndex = (this->subBlockIndex + 1) % numSubBlocks;
+            this->numSubBlocksFilled = jmin(this->numSubBlocksFilled + 1, int(numSubBlocks));
+            this->currentSubBlock = 0.0;
+            this->currentSubBlockLength = 0;
+
+            if (this->numSubBlocksFilled == numSubBlocks)
+            {
+                double blockEnergy = 0.0;
+                for (const auto subBlock : this->subBlocks)
+                {
+                    blockEnergy += subBlock;
+                }
+
+                this->addBlock(blockEnergy / numSubBlocks);
+            }
+        }
+    }
+}
+
+void LoudnessMeter::addBlock(double meanSquare) noexcept
+{
+    const float loudness = energyToLoudness(meanSquare);
+    this->momentaryLoudness = jmax(LOUDNESS_METER_MIN_LOUDNESS, loudness);
+
+    // the absolute gate
+    if (loudness <= LOUDNESS_METER_MIN_LOUDNESS)
+    {
+        return;
+    }
+
+    const int bin = jlimit(0, numHistogramBins - 1,
+        int((loudness - LOUDNESS_METER_MIN_LOUDNESS) * 10.f));
+
+    this->histogramEnergy[bin] += meanSquare;
+    this->histogramCount[bin]++;
+
+    this->updateIntegratedLoudness();
+}
+
+void LoudnessMeter::updateIntegratedLoudness() noexcept
+{
+    double totalEnergy = 0.0;
+    int totalCount = 0;
+    for (int i = 0; i < numHistogramBins; ++i)
+    {
+        totalEnergy += this->histogramEnergy[i];
+        totalCount += this->histogramCount[i];
+    }
+
+    if (totalCount == 0)
+    {
+        this->integratedLoudness = LOUDNESS_METER_MIN_LOUDNESS;
+        return;
+    }
+
+    // the relative gate
+    const float threshold = energyToLoudness(totalEnergy / totalCount) + LOUDNESS_RELATIVE_GATE;
+    const int firstBin = jlimit(0, numHistogramBins - 1,
+        int((threshold - LOUDNESS_METER_MIN_LOUDNESS) * 10.f));
+
+    double gatedEnergy = 0.0;
+    int gatedCount = 0;
+    for (int i = firstBin; i < numHistogramBins; ++i)
+    {
+        gatedEnergy += this->histogramEnergy[i];
+        gatedCount += this->histogramCount[i];
+    }
+
+    this->integratedLoudness = gatedCount > 0 ?
+        jmax(LOUDNESS_METER_MIN_LOUDNESS, energyToLoudness(gatedEnergy / gatedCount)) :
+        LOUDNESS_METER_MIN_LOUDNESS;
+}
+
+float LoudnessMeter::getMomentaryLoudness() const noexcept
+{
+    return this->momentaryLoudness;
+}
+
+float LoudnessMeter::getIntegratedLoudness() const noexcept
+{
+    return this->integratedLoudness;
+}
@@ -0,0 +1,107 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+// Loudness measurement as described in ITU-R BS.1770:
+// the true peak is detected on the 4x oversampled signal,
+// and the loudness is measured on the K-weighted signal,
+// with the momentary loudness over the last 400ms, and the integrated
+// loudness over all 400ms blocks since the last reset, gated both
+// absolutely at -70 LUFS and relatively at -10 LU
+
+#define LOUDNESS_METER_NUM_CHANNELS 2
+#define LOUDNESS_METER_MIN_LOUDNESS (-70.f)
+
+class TruePeakDetector final
+{
+public:
+
+    TruePeakDetector();
+
+    void reset() noexcept;
+
+    // returns the absolute peak of the oversampled signal
+    float process(const float *samples, int numSamples) noexcept;
+
+private:
+
+    static constexpr int oversampling = 4;
+    static constexpr int tapsPerPhase = 12;
+
+    float coefficients[oversampling][tapsPerPhase];
+
+    // the history is written twice, so that it can always be read contiguously
+    float history[tapsPerPhase * 2];
+    int historyPosition = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TruePeakDetector)
+};
+
+class LoudnessMeter final
+{
+public:
+
+    LoudnessMeter();
+
+    void prepare(double sampleRate) noexcept;
+    void reset() noexcept;
+
+    void process(const float **channelData, int numChannels, int numSamples) noexcept;
+
+    float getMomentaryLoudness() const noexcept;
+    float getIntegratedLoudness() const noexcept;
+
+private:
+
+    struct Biquad final
+    {
+        void reset() noexcept;
+        inline float process(float x) noexcept;
+
+        double b0 = 1.0, b1 = 0.0, b2 = 0.0, a1 = 0.0, a2 = 0.0;
+        double z1 = 0.0, z2 = 0.0;
+    };
+
+    void addBlock(double meanSquare) noexcept;
+    void updateIntegratedLoudness() noexcept;
+
+    Biquad preFilter[LOUDNESS_METER_NUM_CHANNELS];
+    Biquad highPassFilter[LOUDNESS_METER_NUM_CHANNELS];
+
+    // the 400ms blocks overlap by 75%, so they are
+    // summed up from the four last 100ms sub-blocks
+    static constexpr int numSubBlocks = 4;
+    double subBlocks[numSubBlocks];
+    int subBlockIndex = 0;
+    int numSubBlocksFilled = 0;
+
+    double currentSubBlock = 0.0;
+    int currentSubBlockLength = 0;
+    int subBlockLength = 4410;
+
+    // the gated blocks are stored as a histogram of 0.1 LU bins,
+    // so the relative gate is applied without keeping all blocks
+    static constexpr int numHistogramBins = 800;
+    double histogramEnergy[numHistogramBins];
+    int histogramCount[numHistogramBins];
+
+    float momentaryLoudness = LOUDNESS_METER_MIN_LOUDNESS;
+    float integratedLoudness = LOUDNESS_METER_MIN_LOUDNESS;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LoudnessMeter)
+};
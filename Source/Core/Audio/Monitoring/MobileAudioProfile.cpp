@@ -0,0 +1,161 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "Common.h"
+#include "MobileAudioProfile.h"
+#include "AudioCore.h"
+#include "AudioEngine.h"
+#include "BuiltInSynthPiano.h"
+
+#define MOBILE_AUDIO_POLL_MS 1000
+
+// about 5 ms at 48kHz: it's the burst size on most devices,
+// or a multiple of it, anything smaller rarely works well
+#define MOBILE_AUDIO_TARGET_BUFFER_SIZE 256
+
+// the load is measured while playing, how many polls in a row
+// it takes to decide that there's a pressure, and that it's gone
+#define MOBILE_AUDIO_OVERLOAD 65.f
+#define MOBILE_AUDIO_UNDERLOAD 30.f
+#define MOBILE_AUDIO_OVERLOAD_POLLS 5
+#define MOBILE_AUDIO_UNDERLOAD_POLLS 30
+
+#define MOBILE_AUDIO_MAX_PRESSURE_LEVEL 2
+#define MOBILE_AUDIO_MIN_CAPPED_VOICES 8
+
+MobileAudioProfile::MobileAudioProfile(AudioCore &audioCore, AudioEngine &engine) :
+    audioCore(audioCore),
+    engine(engine)
+{
+    this->startTimer(MOBILE_AUDIO_POLL_MS);
+}
+
+MobileAudioProfile::~MobileAudioProfile()
+{
+    this->stopTimer();
+}
+
+void MobileAudioProfile::applyDeviceSetup(AudioDeviceManager &deviceManager)
+{
+    // Oboe uses AAudio in the low latency performance mode, where available,
+    // and falls back to OpenSL ES by itself; the devices are only listed
+    // when the corresponding backend is enabled in the build
+    static const StringArray preferredTypes = { "Android Oboe", "Android OpenSL ES" };
+
+    for (const auto &typeName : preferredTypes)
+    {
+        for (auto *type : deviceManager.getAvailableDeviceTypes())
+        {
+            if (type->getTypeName() == typeName &&
+                deviceManager.getCurrentAudioDeviceType() != typeName)
+            {
+                type->scanForDevices();
+                deviceManager.setCurrentAudioDeviceType(typeName, true);
+                break;
+            }
+        }
+
+        if (deviceManager.getCurrentAudioDeviceType() == typeName)
+        {
+            break;
+        }
+    }
+
+    auto *device = deviceManager.getCurrentAudioDevice();
+    if (device == nullptr)
+    {
+        return;
+    }
+
+    // on iOS, the requested size becomes the session's preferred IO buffer duration
+    int bufferSize = device->getDefaultBufferSize();
+    for (const auto size : device->getAvailableBufferSizes())
+    {
+        if (size >= MOBILE_AUDIO_TARGET_BUFFER_SIZE)
+        {
+            bufferSize = size;
+            break;
+        }
+    }
+
+    AudioDeviceManager::AudioDeviceSetup setup;
+    deviceManager.getAudioDeviceSetup(setup);
+    if (setup.bufferSize != bufferSize)
+    {
+        setup.bufferSize = bufferSize;
+        const auto error = deviceManager.setAudioDeviceSetup(setup, true);
+        if (error.isNotEmpty())
+        {
+            DBG("Failed to apply the mobile buffer size: " + error);
+        }
+    }
+}
+
+void MobileAudioProfile::timerCallback()
+{
+    const auto load = this->engine.getProcessingLoad();
+
+    if (load.averagePercent > MOBILE_AUDIO_OVERLOAD)
+    {
+        this->numUnderloadedPolls = 0;
+        if (++this->numOverloadedPolls >= MOBILE_AUDIO_OVERLOAD_POLLS &&
+            this->pressureLevel < MOBILE_AUDIO_MAX_PRESSURE_LEVEL)
+        {
+            this->numOverloadedPolls = 0;
+            this->pressureLevel++;
+            DBG("Audio pressure level: " + String(this->pressureLevel));
+            this->updateVoiceCaps();
+        }
+    }
+    else if (load.averagePercent < MOBILE_AUDIO_UNDERLOAD)
+    {
+        this->numOverloadedPolls = 0;
+        if (++this->numUnderloadedPolls >= MOBILE_AUDIO_UNDERLOAD_POLLS &&
+            this->pressureLevel > 0)
+        {
+            this->numUnderloadedPolls = 0;
+            this->pressureLevel--;
+            DBG("Audio pressure level: " + String(this->pressureLevel));
+            this->updateVoiceCaps();
+        }
+    }
+    else
+    {
+        this->numOverloadedPolls = 0;
+        this->numUnderloadedPolls = 0;
+    }
+}
+
+void MobileAudioProfile::updateVoiceCaps()
+{
+    for (auto *instrument : this->audioCore.getInstruments())
+    {
+        for (int i = 0; i < instrument->getNumNodes(); ++i)
+        {
+            const auto node = instrument->getNode(i);
+            if (auto *piano = dynamic_cast<BuiltInSynthPiano *>(node->getProcessor()))
+            {
+                const auto cap = this->pressureLevel == 0 ? 0 :
+                    jmax(MOBILE_AUDIO_MIN_CAPPED_VOICES,
+                        BUILTIN_SYNTH_NUM_VOICES >> this->pressureLevel);
+
+                piano->setVoiceCap(cap);
+            }
+        }
+    }
+}
@@ -0,0 +1,57 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+class AudioCore;
+class AudioEngine;
+
+/*
+    The audio setup for phones and tablets: picks the lowest latency device
+    type and a buffer size which is small, but not the smallest possible,
+    since that's what makes both the glitches and the battery drain.
+
+    Once running, it watches the engine's load, which creeps up when
+    the device gets hot and throttles the cpu, and caps the number
+    of the built-in piano's voices until the load goes back down.
+*/
+
+class MobileAudioProfile final : private Timer
+{
+public:
+
+    MobileAudioProfile(AudioCore &audioCore, AudioEngine &engine);
+    ~MobileAudioProfile() override;
+
+    static void applyDeviceSetup(AudioDeviceManager &deviceManager);
+
+private:
+
+    void timerCallback() override;
+    void updateVoiceCaps();
+
+    AudioCore &audioCore;
+    AudioEngine &engine;
+
+    // 0 means no pressure, and each next level halves the voices
+    int pressureLevel = 0;
+    int numOverloadedPolls = 0;
+    int numUnderloadedPolls = 0;
+
+    JUCE_DECLARE_NON_COPYABLE(MobileAudioProfile)
+};
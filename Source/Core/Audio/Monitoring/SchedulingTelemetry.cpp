@@ -0,0 +1,136 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Common.h"
+#include "SchedulingTelemetry.h"
+
+static const double bucketLimitsMs[SCHEDULING_TELEMETRY_NUM_BUCKETS - 1] =
+    { 0.1, 0.5, 1.0, 2.0, 5.0, 10.0, 20.0, 50.0 };
+
+double SchedulingTelemetry::getBucketLimitMs(int bucket) noexcept
+{
+    jassert(bucket >= 0 && bucket < SCHEDULING_TELEMETRY_NUM_BUCKETS);
+    return bucket < SCHEDULING_TELEMETRY_NUM_BUCKETS - 1 ?
+        bucketLimitsMs[bucket] : std::numeric_limits<double>::infinity();
+}
+
+// there's only one writer thread at a time, so the read-modify-write
+// operations below don't need to be atomic as a whole, and the readers
+// only need not to see torn values
+void SchedulingTelemetry::addEvent(double deviationMs) noexcept
+{
+    const auto absDeviationMs = std::abs(deviationMs);
+
+    int bucket = 0;
+    while (bucket < SCHEDULING_TELEMETRY_NUM_BUCKETS - 1 &&
+        absDeviationMs > bucketLimitsMs[bucket])
+    {
+        bucket++;
+    }
+
+    this->histogram[bucket] += 1;
+    this->sumDeviationMs = this->sumDeviationMs.get() + deviationMs;
+
+    if (absDeviationMs > this->maxDeviationMs.get())
+    {
+        this->maxDeviationMs = absDeviationMs;
+    }
+}
+
+void SchedulingTelemetry::addMissedEvent() noexcept
+{
+    this->numMissedEvents += 1;
+}
+
+void SchedulingTelemetry::reset() noexcept
+{
+    for (auto &bucket : this->histogram)
+    {
+        bucket = 0;
+    }
+
+    this->numMissedEvents = 0;
+    this->sumDeviationMs = 0.0;
+    this->maxDeviationMs = 0.0;
+}
+
+SchedulingTelemetry::Summary SchedulingTelemetry::getSummary() const noexcept
+{
+    Summary summary;
+
+    for (int i = 0; i < SCHEDULING_TELEMETRY_NUM_BUCKETS; ++i)
+    {
+        summary.histogram[i] = this->histogram[i].get();
+        summary.numEvents += summary.histogram[i];
+    }
+
+    summary.numMissedEvents = this->numMissedEvents.get();
+    summary.maxMs = this->maxDeviationMs.get();
+
+    if (summary.numEvents == 0)
+    {
+        return summary;
+    }
+
+    summary.meanDeviationMs = this->sumDeviationMs.get() / double(summary.numEvents);
+
+    const auto findPercentile = [&summary](double percentile)
+    {
+        const auto target = int64(std::ceil(double(summary.numEvents) * percentile));
+        int64 count = 0;
+        for (int i = 0; i < SCHEDULING_TELEMETRY_NUM_BUCKETS - 1; ++i)
+        {
+            count += summary.histogram[i];
+            if (count >= target)
+            {
+                return jmin(bucketLimitsMs[i], summary.maxMs);
+            }
+        }
+
+        return summary.maxMs;
+    };
+
+    summary.medianMs = findPercentile(0.5);
+    summary.percentile99Ms = findPercentile(0.99);
+    return summary;
+}
+
+var SchedulingTelemetry::toVar() const
+{
+    const auto summary = this->getSummary();
+
+    Array<var> histogram;
+    for (int i = 0; i < SCHEDULING_TELEMETRY_NUM_BUCKETS; ++i)
+    {
+        DynamicObject::Ptr bucket(new DynamicObject());
+        // the overflow bucket has no upper limit
+        bucket->setProperty("upToMs", i < SCHEDULING_TELEMETRY_NUM_BUCKETS - 1 ?
+            var(bucketLimitsMs[i]) : var());
+        bucket->setProperty("count", summary.histogram[i]);
+        histogram.add(var(bucket.get()));
+    }
+
+    DynamicObject::Ptr json(new DynamicObject());
+    json->setProperty("events", summary.numEvents);
+    json->setProperty("missedEvents", summary.numMissedEvents);
+    json->setProperty("meanDeviationMs", summary.meanDeviationMs);
+    json->setProperty("medianMs", summary.medianMs);
+    json->setProperty("percentile99Ms", summary.percentile99Ms);
+    json->setProperty("maxMs", summary.maxMs);
+    json->setProperty("histogram", histogram);
+    return var(json.get());
+}
@@ -0,0 +1,69 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#define SCHEDULING_TELEMETRY_NUM_BUCKETS 9
+
+/*
+    Counts how far the playback events have been from their intended time
+    by the moment they have reached the instrument: written by the player thread
+    (which waits for each next event with millisecond sleeps, when the audio device
+    isn't running) or by the audio thread (the scheduled playback, which puts the
+    events at their exact sample offsets, but may miss some of them, e.g. after a
+    seek), and read from anywhere. It is reset at each playback start, so it
+    describes the current or the last playback.
+*/
+
+class SchedulingTelemetry final
+{
+public:
+
+    SchedulingTelemetry() = default;
+
+    // negative deviations are the events sent too early
+    void addEvent(double deviationMs) noexcept;
+    void addMissedEvent() noexcept;
+    void reset() noexcept;
+
+    struct Summary final
+    {
+        int64 numEvents = 0;
+        int64 numMissedEvents = 0;
+        double meanDeviationMs = 0.0;
+        // the absolute deviations, as the upper limits of the histogram buckets
+        double medianMs = 0.0;
+        double percentile99Ms = 0.0;
+        double maxMs = 0.0;
+        int64 histogram[SCHEDULING_TELEMETRY_NUM_BUCKETS] = {};
+    };
+
+    Summary getSummary() const noexcept;
+    var toVar() const;
+
+    // the last bucket is for everything above the last limit
+    static double getBucketLimitMs(int bucket) noexcept;
+
+private:
+
+    Atomic<int64> histogram[SCHEDULING_TELEMETRY_NUM_BUCKETS];
+    Atomic<int64> numMissedEvents = 0;
+    Atomic<double> sumDeviationMs = 0.0;
+    Atomic<double> maxDeviationMs = 0.0;
+
+    JUCE_DECLARE_NON_COPYABLE(SchedulingTelemetry)
+};
@@ -157,10 +157,10 @@ inline void SpectrumFFT::process(int bits)
     }
 }
 
-void SpectrumFFT::computeSpectrum(float *pcmbuffer,
+void SpectrumFFT::computeSpectrum(const float *pcmbuffer,
                                   unsigned int pcmposition,
                                   unsigned int pcmlength,
-                                  Atomic<float> *spectrum,
+                                  float *spectrum,
                                   int length,
                                   int channel,
                                   int numchannels)
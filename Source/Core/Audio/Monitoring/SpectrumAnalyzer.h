@@ -23,7 +23,7 @@ const int FFT_TABLERANGE = (FFT_COSTABSIZE * 4);
 const int FFT_TABLEMASK  = (FFT_TABLERANGE - 1);
 
 // Make sure no consumer ever asks for a spectrum larger than that:
-#define FFT_MAX_SPECTRUM_SIZE (512)
+#define FFT_MAX_SPECTRUM_SIZE (2048)
 
 class SpectrumFFT final
 {
@@ -31,10 +31,10 @@ public:
     
     SpectrumFFT();
     
-    void computeSpectrum(float *pcmbuffer,
+    void computeSpectrum(const float *pcmbuffer,
         unsigned int pcmposition,
         unsigned int pcmlength,
-        Atomic<float> *spectrum,
+        float *spectrum,
         int length,
         int channel,
         int numchannels);
@@ -0,0 +1,165 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Common.h"
+#include "RealtimeSafety.h"
+
+#if HELIO_REALTIME_SAFETY_CHECKS
+
+// the innermost scope name for the current thread, if any,
+// and whether the thread is busy reporting, in which case
+// it is allowed to allocate whatever it wants
+static thread_local const char *realtimeScopeName = nullptr;
+static thread_local bool isReportingViolation = false;
+
+bool RealtimeSafety::isInRealtimeScope() noexcept
+{
+    return realtimeScopeName != nullptr && !isReportingViolation;
+}
+
+void RealtimeSafety::reportViolation(const char *violation) noexcept
+{
+    if (!RealtimeSafety::isInRealtimeScope())
+    {
+        return;
+    }
+
+    isReportingViolation = true;
+
+    const auto stackTrace = SystemStats::getStackBacktrace();
+
+    static SpinLock reportedTracesLock;
+    static FlatHashSet<int> reportedTraces;
+
+    bool isNewTrace = false;
+
+    {
+        const SpinLock::ScopedLockType lock(reportedTracesLock);
+        isNewTrace = reportedTraces.insert(stackTrace.hashCode()).second;
+    }
+
+    if (isNewTrace)
+    {
+        Logger::writeToLog("Realtime safety: " + String(violation) +
+            " in " + String(realtimeScopeName) + "\n" + stackTrace);
+    }
+
+    isReportingViolation = false;
+}
+
+RealtimeSafety::Scope::Scope(const char *name) noexcept :
+    previousName(realtimeScopeName)
+{
+    realtimeScopeName = name;
+}
+
+RealtimeSafety::Scope::~Scope()
+{
+    realtimeScopeName = this->previousName;
+}
+
+RealtimeSafety::ScopedLock::ScopedLock(const CriticalSection &lock) noexcept :
+    lock(lock)
+{
+    if (!this->lock.tryEnter())
+    {
+        RealtimeSafety::reportViolation("waiting for a lock");
+        this->lock.enter();
+    }
+}
+
+RealtimeSafety::ScopedLock::~ScopedLock()
+{
+    this->lock.exit();
+}
+
+//===----------------------------------------------------------------------===//
+// Global allocation functions
+//===----------------------------------------------------------------------===//
+
+void *operator new(std::size_t size)
+{
+    RealtimeSafety::reportViolation("heap allocation");
+
+    if (auto *ptr = std::malloc(size > 0 ? size : 1))
+    {
+        return ptr;
+    }
+
+    throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept
+{
+    RealtimeSafety::reportViolation("heap allocation");
+    return std::malloc(size > 0 ? size : 1);
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &tag) noexcept
+{
+    return operator new(size, tag);
+}
+
+void operator delete(void *ptr) noexcept
+{
+    if (ptr != nullptr)
+    {
+        RealtimeSafety::reportViolation("heap deallocation");
+        std::free(ptr);
+    }
+}
+
+void operator delete[](void *ptr) noexcept
+{
+    operator delete(ptr);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept
+{
+    operator delete(ptr);
+}
+
+void operator delete[](void *ptr, std::size_t) noexcept
+{
+    operator delete(ptr);
+}
+
+#else
+
+bool RealtimeSafety::isInRealtimeScope() noexcept { return false; }
+void RealtimeSafety::reportViolation(const char *) noexcept {}
+
+RealtimeSafety::Scope::Scope(const char *) noexcept : previousName(nullptr) {}
+RealtimeSafety::Scope::~Scope() {}
+
+RealtimeSafety::ScopedLock::ScopedLock(const CriticalSection &lock) noexcept :
+    lock(lock)
+{
+    this->lock.enter();
+}
+
+RealtimeSafety::ScopedLock::~ScopedLock()
+{
+    this->lock.exit();
+}
+
+#endif
@@ -0,0 +1,87 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+// off by default, since it replaces the global operator new and delete;
+// add HELIO_REALTIME_SAFETY_CHECKS=1 to the preprocessor definitions
+// of a debug build to enable it (it's ignored in release builds)
+#if !defined (HELIO_REALTIME_SAFETY_CHECKS) || !JUCE_DEBUG
+#   undef HELIO_REALTIME_SAFETY_CHECKS
+#   define HELIO_REALTIME_SAFETY_CHECKS 0
+#endif
+
+/*
+    The audio callbacks mark their scopes with REALTIME_SCOPE, and take their locks
+    with REALTIME_SCOPED_LOCK; when the checks are enabled, any heap allocation or
+    deallocation within such a scope, or any lock acquisition which has to wait for
+    another thread, is written into the log along with the stack trace, so that the
+    glitches can be traced to code; each stack trace is only reported once.
+
+    Without the checks, the scopes compile to nothing, and the locks are just ScopedLocks.
+*/
+
+class RealtimeSafety final
+{
+public:
+
+    static bool isInRealtimeScope() noexcept;
+    static void reportViolation(const char *violation) noexcept;
+
+    class Scope final
+    {
+    public:
+
+        explicit Scope(const char *name) noexcept;
+        ~Scope();
+
+    private:
+
+        const char *previousName;
+
+        JUCE_DECLARE_NON_COPYABLE(Scope)
+    };
+
+    class ScopedLock final
+    {
+    public:
+
+        explicit ScopedLock(const CriticalSection &lock) noexcept;
+        ~ScopedLock();
+
+    private:
+
+        const CriticalSection &lock;
+
+        JUCE_DECLARE_NON_COPYABLE(ScopedLock)
+    };
+};
+
+#if HELIO_REALTIME_SAFETY_CHECKS
+
+#   define REALTIME_SCOPE(name) \
+        const RealtimeSafety::Scope JUCE_JOIN_MACRO(realtimeScope, __LINE__)(name)
+#   define REALTIME_SCOPED_LOCK(lock) \
+        const RealtimeSafety::ScopedLock JUCE_JOIN_MACRO(realtimeLock, __LINE__)(lock)
+
+#else
+
+#   define REALTIME_SCOPE(name)
+#   define REALTIME_SCOPED_LOCK(lock) \
+        const ScopedLock JUCE_JOIN_MACRO(realtimeLock, __LINE__)(lock)
+
+#endif
@@ -0,0 +1,150 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Common.h"
+#include "AsyncAudioWriter.h"
+
+AsyncAudioWriter::AsyncAudioWriter(AudioFormatWriter *writer, int blockSize, int numBlocks) :
+    Thread("AsyncAudioWriter"),
+    writer(writer),
+    fifo(numBlocks)
+{
+    jassert(writer != nullptr);
+
+    for (int i = 0; i < numBlocks; ++i)
+    {
+        this->blocks.add(new AudioSampleBuffer(writer->getNumChannels(), blockSize));
+    }
+
+    this->startThread(8);
+}
+
+AsyncAudioWriter::~AsyncAudioWriter()
+{
+    this->signalThreadShouldExit();
+    this->blockAdded.signal();
+    this->stopThread(1000);
+}
+
+static void copyBlock(AudioSampleBuffer &target, const AudioSampleBuffer &source, int sourceChannel, int targetChannel)
+{
+    target.copyFrom(targetChannel, 0, source, sourceChannel, 0, source.getNumSamples());
+}
+
+static void copyBlock(AudioSampleBuffer &target, const AudioBuffer<double> &source, int sourceChannel, int targetChannel)
+{
+    auto *destination = target.getWritePointer(targetChannel);
+    const auto *samples = source.getReadPointer(sourceChannel);
+    for (int i = 0; i < source.getNumSamples(); ++i)
+    {
+        destination[i] = float(samples[i]);
+    }
+}
+
+bool AsyncAudioWriter::write(const AudioSampleBuffer &block, Thread &callingThread)
+{
+    return this->writeBlock(block, callingThread);
+}
+
+bool AsyncAudioWriter::write(const AudioBuffer<double> &block, Thread &callingThread)
+{
+    return this->writeBlock(block, callingThread);
+}
+
+template <typename T>
+bool AsyncAudioWriter::writeBlock(const AudioBuffer<T> &block, Thread &callingThread)
+{
+    for (;;)
+    {
+        if (this->failed.get() || callingThread.threadShouldExit())
+        {
+            return false;
+        }
+
+        int start1, size1, start2, size2;
+        this->fifo.prepareToWrite(1, start1, size1, start2, size2);
+        if (size1 > 0)
+        {
+            auto *target = this->blocks.getUnchecked(start1);
+            jassert(block.getNumSamples() <= target->getNumSamples());
+            target->setSize(target->getNumChannels(), block.getNumSamples(), true, false, true);
+
+            for (int i = 0; i < target->getNumChannels(); ++i)
+            {
+                copyBlock(*target, block, jmin(i, block.getNumChannels() - 1), i);
+            }
+
+            this->fifo.finishedWrite(1);
+            this->blockAdded.signal();
+            return true;
+        }
+
+        // the ring is full, so the encoding is slower than the rendering
+        this->blockWritten.wait(100);
+    }
+}
+
+bool AsyncAudioWriter::flush(Thread &callingThread)
+{
+    while (this->fifo.getNumReady() > 0)
+    {
+        if (this->failed.get() || callingThread.threadShouldExit())
+        {
+            break;
+        }
+
+        this->blockWritten.wait(100);
+    }
+
+    if (!this->failed.get())
+    {
+        this->writer->flush();
+    }
+
+    return !this->failed.get() && this->fifo.getNumReady() == 0;
+}
+
+bool AsyncAudioWriter::hasFailed() const noexcept
+{
+    return this->failed.get();
+}
+
+void AsyncAudioWriter::run()
+{
+    while (!this->threadShouldExit())
+    {
+        int start1, size1, start2, size2;
+        this->fifo.prepareToRead(1, start1, size1, start2, size2);
+        if (size1 == 0)
+        {
+            this->blockAdded.wait(100);
+            continue;
+        }
+
+        const auto *block = this->blocks.getUnchecked(start1);
+        if (!this->writer->writeFromAudioSampleBuffer(*block, 0, block->getNumSamples()))
+        {
+            DBG("Failed to write a rendered block");
+            this->failed = true;
+            this->blockWritten.signal();
+            return;
+        }
+
+        this->fifo.finishedRead(1);
+        this->blockWritten.signal();
+    }
+}
@@ -0,0 +1,63 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+/*
+    Encodes and writes the rendered blocks on its own thread, so that
+    the rendering and the encoding (which is noticeable for flac) overlap:
+    the blocks are copied into a bounded ring of pre-allocated buffers,
+    and the renderer only waits when the ring is full.
+*/
+
+class AsyncAudioWriter final : private Thread
+{
+public:
+
+    AsyncAudioWriter(AudioFormatWriter *writer, int blockSize, int numBlocks = 32);
+    ~AsyncAudioWriter() override;
+
+    // returns false, if the writer has failed, or if interrupted by the calling thread;
+    // the block should be of the block size as given in the constructor, or smaller
+    bool write(const AudioSampleBuffer &block, Thread &callingThread);
+    bool write(const AudioBuffer<double> &block, Thread &callingThread);
+
+    // waits until all the pending blocks are written;
+    // returns false, if anything has failed to write
+    bool flush(Thread &callingThread);
+
+    bool hasFailed() const noexcept;
+
+private:
+
+    void run() override;
+
+    template <typename T>
+    bool writeBlock(const AudioBuffer<T> &block, Thread &callingThread);
+
+    UniquePointer<AudioFormatWriter> writer;
+
+    AbstractFifo fifo;
+    OwnedArray<AudioSampleBuffer> blocks;
+
+    WaitableEvent blockAdded;
+    WaitableEvent blockWritten;
+
+    Atomic<bool> failed = false;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AsyncAudioWriter)
+};
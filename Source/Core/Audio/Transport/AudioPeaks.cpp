@@ -0,0 +1,306 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "Common.h"
+#include "AudioPeaks.h"
+
+#define AUDIO_PEAKS_BASE_RESOLUTION 256
+#define AUDIO_PEAKS_LEVEL_FACTOR 4
+#define AUDIO_PEAKS_NUM_LEVELS 6
+
+#define AUDIO_PEAKS_FILE_MAGIC 0x534b5048
+#define AUDIO_PEAKS_FILE_VERSION 1
+
+static void combinePeaks(const Array<AudioPeaks::Peak> &peaks, int numChannels,
+    int firstPeak, int endPeak, AudioPeaks::Peak *result) noexcept
+{
+    for (int c = 0; c < numChannels; ++c)
+    {
+        auto combined = peaks.getUnchecked(firstPeak * numChannels + c);
+        for (int i = firstPeak + 1; i < endPeak; ++i)
+        {
+            const auto &peak = peaks.getReference(i * numChannels + c);
+            combined.min = jmin(combined.min, peak.min);
+            combined.max = jmax(combined.max, peak.max);
+        }
+
+        result[c] = combined;
+    }
+}
+
+//===----------------------------------------------------------------------===//
+// Builder
+//===----------------------------------------------------------------------===//
+
+AudioPeaks::Builder::Builder(int numChannels, double sampleRate) :
+    peaks(new AudioPeaks())
+{
+    this->peaks->numChannels = numChannels;
+    this->peaks->sampleRate = sampleRate;
+
+    for (int i = 0, samplesPerPeak = AUDIO_PEAKS_BASE_RESOLUTION;
+        i < AUDIO_PEAKS_NUM_LEVELS; ++i, samplesPerPeak *= AUDIO_PEAKS_LEVEL_FACTOR)
+    {
+        Level level;
+        level.samplesPerPeak = samplesPerPeak;
+        this->peaks->levels.add(level);
+    }
+
+    this->currentPeaks.calloc(numChannels);
+    this->combinedPeaks.calloc(numChannels);
+}
+
+void AudioPeaks::Builder::addSamples(const AudioSampleBuffer &buffer, int startSample, int numSamples)
+{
+    jassert(this->peaks != nullptr);
+
+    const auto numChannels = this->peaks->numChannels;
+
+    int processed = 0;
+    while (processed < numSamples)
+    {
+        const auto numToScan = jmin(numSamples - processed,
+            AUDIO_PEAKS_BASE_RESOLUTION - this->numSamplesInCurrentPeak);
+
+        for (int c = 0; c < numChannels; ++c)
+        {
+            const auto *samples = buffer.getReadPointer(jmin(c, buffer.getNumChannels() - 1));
+            const auto range = FloatVectorOperations::findMinAndMax(samples + startSample + processed, numToScan);
+
+            auto &peak = this->currentPeaks[c];
+            if (this->numSamplesInCurrentPeak == 0)
+            {
+                peak = { range.getStart(), range.getEnd() };
+            }
+            else
+            {
+                peak.min = jmin(peak.min, range.getStart());
+                peak.max = jmax(peak.max, range.getEnd());
+            }
+        }
+
+        processed += numToScan;
+        this->numSamplesInCurrentPeak += numToScan;
+        this->peaks->lengthInSamples += numToScan;
+
+        if (this->numSamplesInCurrentPeak == AUDIO_PEAKS_BASE_RESOLUTION)
+        {
+            this->addPeaks(0, this->currentPeaks);
+            this->numSamplesInCurrentPeak = 0;
+        }
+    }
+}
+
+// Each completed group of peaks of a level makes a peak of the next one
+void AudioPeaks::Builder::addPeaks(int levelIndex, const Peak *channelPeaks)
+{
+    const auto numChannels = this->peaks->numChannels;
+    auto &level = this->peaks->levels.getReference(levelIndex);
+    level.peaks.addArray(channelPeaks, numChannels);
+
+    const auto numPeaks = level.peaks.size() / numChannels;
+    if (levelIndex + 1 < this->peaks->levels.size() &&
+        numPeaks % AUDIO_PEAKS_LEVEL_FACTOR == 0)
+    {
+        combinePeaks(level.peaks, numChannels,
+            numPeaks - AUDIO_PEAKS_LEVEL_FACTOR, numPeaks, this->combinedPeaks);
+
+        this->addPeaks(levelIndex + 1, this->combinedPeaks);
+    }
+}
+
+AudioPeaks::Ptr AudioPeaks::Builder::build()
+{
+    jassert(this->peaks != nullptr);
+
+    if (this->numSamplesInCurrentPeak > 0)
+    {
+        this->addPeaks(0, this->currentPeaks);
+        this->numSamplesInCurrentPeak = 0;
+    }
+
+    // the coarser levels also get the remainders of the finer ones
+    auto &levels = this->peaks->levels;
+    const auto numChannels = this->peaks->numChannels;
+    for (int i = 1; i < levels.size(); ++i)
+    {
+        const auto numFinerPeaks = levels.getReference(i - 1).peaks.size() / numChannels;
+        const auto numCoveredPeaks = levels.getReference(i).peaks.size() / numChannels * AUDIO_PEAKS_LEVEL_FACTOR;
+        if (numFinerPeaks > numCoveredPeaks)
+        {
+            combinePeaks(levels.getReference(i - 1).peaks, numChannels,
+                numCoveredPeaks, numFinerPeaks, this->combinedPeaks);
+
+            levels.getReference(i).peaks.addArray(this->combinedPeaks.get(), numChannels);
+        }
+    }
+
+    AudioPeaks::Ptr result;
+    std::swap(result, this->peaks);
+    return result;
+}
+
+//===----------------------------------------------------------------------===//
+// AudioPeaks
+//===----------------------------------------------------------------------===//
+
+int AudioPeaks::getNumChannels() const noexcept
+{
+    return this->numChannels;
+}
+
+double AudioPeaks::getSampleRate() const noexcept
+{
+    return this->sampleRate;
+}
+
+int64 AudioPeaks::getLengthInSamples() const noexcept
+{
+    return this->lengthInSamples;
+}
+
+AudioPeaks::Peak AudioPeaks::getPeakInRange(int channel,
+    int64 startSample, int64 endSample) const noexcept
+{
+    startSample = jmax(int64(0), startSample);
+    endSample = jmin(this->lengthInSamples, endSample);
+
+    if (this->levels.isEmpty() || endSample <= startSample ||
+        !isPositiveAndBelow(channel, this->numChannels))
+    {
+        return { 0.f, 0.f };
+    }
+
+    // the coarsest level with its peaks no longer than the range
+    int levelIndex = 0;
+    while (levelIndex + 1 < this->levels.size() &&
+        this->levels.getReference(levelIndex + 1).samplesPerPeak <= endSample - startSample)
+    {
+        levelIndex++;
+    }
+
+    const auto &level = this->levels.getReference(levelIndex);
+    const auto numPeaks = level.peaks.size() / this->numChannels;
+    if (numPeaks == 0)
+    {
+        return { 0.f, 0.f };
+    }
+
+    const auto firstPeak = jmin(numPeaks - 1, int(startSample / level.samplesPerPeak));
+    const auto lastPeak = jmin(numPeaks - 1, int((endSample - 1) / level.samplesPerPeak));
+
+    auto result = level.peaks.getUnchecked(firstPeak * this->numChannels + channel);
+    for (int i = firstPeak + 1; i <= lastPeak; ++i)
+    {
+        const auto &peak = level.peaks.getReference(i * this->numChannels + channel);
+        result.min = jmin(result.min, peak.min);
+        result.max = jmax(result.max, peak.max);
+    }
+
+    return result;
+}
+
+//===----------------------------------------------------------------------===//
+// Files
+//===----------------------------------------------------------------------===//
+
+// The peaks are written as is, in the native float layout,
+// which is little-endian on all platforms the app runs on
+
+bool AudioPeaks::saveTo(const File &file) const
+{
+    TemporaryFile tempFile(file);
+
+    {
+        FileOutputStream out(tempFile.getFile());
+        if (out.failedToOpen())
+        {
+            return false;
+        }
+
+        out.writeInt(AUDIO_PEAKS_FILE_MAGIC);
+        out.writeInt(AUDIO_PEAKS_FILE_VERSION);
+        out.writeInt(this->numChannels);
+        out.writeDouble(this->sampleRate);
+        out.writeInt64(this->lengthInSamples);
+        out.writeInt(this->levels.size());
+
+        for (const auto &level : this->levels)
+        {
+            out.writeInt(level.samplesPerPeak);
+            out.writeInt(level.peaks.size());
+            out.write(level.peaks.begin(), size_t(level.peaks.size()) * sizeof(Peak));
+        }
+
+        out.flush();
+        if (out.getStatus().failed())
+        {
+            return false;
+        }
+    }
+
+    return tempFile.overwriteTargetFileWithTemporary();
+}
+
+AudioPeaks::Ptr AudioPeaks::loadFrom(const File &file)
+{
+    FileInputStream in(file);
+    if (in.failedToOpen() ||
+        in.readInt() != AUDIO_PEAKS_FILE_MAGIC ||
+        in.readInt() != AUDIO_PEAKS_FILE_VERSION)
+    {
+        return nullptr;
+    }
+
+    Ptr peaks(new AudioPeaks());
+    peaks->numChannels = in.readInt();
+    peaks->sampleRate = in.readDouble();
+    peaks->lengthInSamples = in.readInt64();
+
+    const auto numLevels = in.readInt();
+    if (peaks->numChannels <= 0 || peaks->sampleRate <= 0.0 ||
+        peaks->lengthInSamples < 0 || !isPositiveAndBelow(numLevels, 32))
+    {
+        return nullptr;
+    }
+
+    for (int i = 0; i < numLevels; ++i)
+    {
+        Level level;
+        level.samplesPerPeak = in.readInt();
+        const auto numPeaks = in.readInt();
+        const auto numBytes = int64(numPeaks) * int64(sizeof(Peak));
+
+        if (level.samplesPerPeak <= 0 || numPeaks < 0 ||
+            numPeaks % peaks->numChannels != 0 ||
+            numBytes > in.getNumBytesRemaining())
+        {
+            return nullptr;
+        }
+
+        level.peaks.resize(numPeaks);
+        if (in.read(level.peaks.begin(), int(numBytes)) != int(numBytes))
+        {
+            return nullptr;
+        }
+
+        peaks->levels.add(level);
+    }
+
+    return peaks;
+}
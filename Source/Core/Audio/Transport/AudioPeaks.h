@@ -0,0 +1,97 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+/*
+    The multi-resolution min/max summary of a recorded take, so that
+    its waveform can be drawn at any zoom level without reading the audio:
+    the finest level has a peak per channel for every 256 samples,
+    and each next level is 4 times coarser than the previous one.
+
+    The peaks are built incrementally by the recorder's writer thread,
+    as the samples go to disk, and saved next to the audio file.
+*/
+
+class AudioPeaks final : public ReferenceCountedObject
+{
+public:
+
+    using Ptr = ReferenceCountedObjectPtr<AudioPeaks>;
+
+    struct Peak final
+    {
+        float min;
+        float max;
+    };
+
+    class Builder final
+    {
+    public:
+
+        Builder(int numChannels, double sampleRate);
+
+        void addSamples(const AudioSampleBuffer &buffer, int startSample, int numSamples);
+
+        // includes the last incomplete peaks, if any;
+        // the builder shouldn't be used after that
+        AudioPeaks::Ptr build();
+
+    private:
+
+        void addPeaks(int level, const Peak *channelPeaks);
+
+        AudioPeaks::Ptr peaks;
+        HeapBlock<Peak> currentPeaks;
+        HeapBlock<Peak> combinedPeaks;
+        int numSamplesInCurrentPeak = 0;
+
+        JUCE_DECLARE_NON_COPYABLE(Builder)
+    };
+
+    // Returns nullptr, if the file is missing or corrupted
+    static Ptr loadFrom(const File &file);
+    bool saveTo(const File &file) const;
+
+    int getNumChannels() const noexcept;
+    double getSampleRate() const noexcept;
+    int64 getLengthInSamples() const noexcept;
+
+    // Combines the peaks of the coarsest level which still resolves
+    // the given range, i.e. the waveform's pixel, so that it takes
+    // a few reads, however long the range is
+    Peak getPeakInRange(int channel, int64 startSample, int64 endSample) const noexcept;
+
+private:
+
+    AudioPeaks() = default;
+
+    struct Level final
+    {
+        int samplesPerPeak = 0;
+        // the peaks of all channels, interleaved
+        Array<Peak> peaks;
+    };
+
+    int numChannels = 0;
+    double sampleRate = 0.0;
+    int64 lengthInSamples = 0;
+    Array<Level> levels;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AudioPeaks)
+};
@@ -0,0 +1,336 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "Common.h"
+#include "AudioRecorder.h"
+#include "RealtimeSafety.h"
+
+// enough for the disk hiccups, but not too much memory for multichannel inputs
+#define AUDIO_RECORDER_BUFFER_SECONDS 4
+#define AUDIO_RECORDER_WRITER_INTERVAL_MS 20
+#define AUDIO_RECORDER_WRITER_PRIORITY 8
+#define AUDIO_RECORDER_STOP_TIMEOUT_MS 2000
+
+AudioRecorder::AudioRecorder() :
+    Thread("AudioRecorder"),
+    fifo(1) {}
+
+AudioRecorder::~AudioRecorder()
+{
+    if (this->isRecording())
+    {
+        this->stopRecording();
+    }
+}
+
+//===----------------------------------------------------------------------===//
+// Message thread
+//===----------------------------------------------------------------------===//
+
+bool AudioRecorder::startRecording(const File &targetFile)
+{
+    if (this->isRecording())
+    {
+        jassertfalse;
+        return false;
+    }
+
+    int numChannels = 0;
+    double rate = 0.0;
+
+    {
+        const ScopedLock sl(this->lock);
+        numChannels = this->numInputChannels;
+        rate = this->sampleRate;
+    }
+
+    if (numChannels <= 0 || rate <= 0.0)
+    {
+        return false;
+    }
+
+    targetFile.deleteFile();
+    UniquePointer<FileOutputStream> fileStream(targetFile.createOutputStream());
+    if (fileStream == nullptr)
+    {
+        return false;
+    }
+
+    WavAudioFormat format;
+    UniquePointer<AudioFormatWriter> newWriter(format.createWriterFor(fileStream.get(),
+        rate, unsigned(numChannels), 32, {}, 0));
+
+    if (newWriter == nullptr)
+    {
+        return false;
+    }
+
+    fileStream.release(); // now owned by the writer
+
+    this->audioFile = targetFile;
+    this->writer = std::move(newWriter);
+    this->peaksBuilder = makeUnique<AudioPeaks::Builder>(numChannels, rate);
+    this->writerFailed = false;
+
+    const auto capacity = int(rate * AUDIO_RECORDER_BUFFER_SECONDS);
+    this->ring.setSize(numChannels, capacity);
+    this->fifo.setTotalSize(capacity);
+
+    this->startThread(AUDIO_RECORDER_WRITER_PRIORITY);
+
+    const ScopedLock sl(this->lock);
+    this->startSamplePosition = -1;
+    this->numSamplesToPad = 0;
+    this->numDroppedSamples = 0;
+    this->recording = true;
+    this->recordingFlag = true;
+    return true;
+}
+
+AudioRecorder::Take AudioRecorder::stopRecording()
+{
+    if (!this->isRecording())
+    {
+        return {};
+    }
+
+    Take take;
+
+    {
+        // once this is done, the audio thread doesn't touch the ring anymore
+        const ScopedLock sl(this->lock);
+        this->recording = false;
+        this->recordingFlag = false;
+        take.startSamplePosition = this->startSamplePosition;
+        take.numDroppedSamples = this->numDroppedSamples + this->numSamplesToPad;
+    }
+
+    this->signalThreadShouldExit();
+    this->notify();
+    this->stopThread(AUDIO_RECORDER_STOP_TIMEOUT_MS);
+
+    // the writer thread is done, so whatever is left is written right here
+    const bool written = !this->writerFailed.get() && this->writePendingSamples();
+    this->writer = nullptr; // finalizes the file
+
+    auto peaks = this->peaksBuilder->build();
+    this->peaksBuilder = nullptr;
+
+    this->ring.setSize(0, 0);
+
+    if (!written || take.startSamplePosition < 0 || peaks->getLengthInSamples() == 0)
+    {
+        DBG("Nothing has been recorded, or failed to write the take");
+        this->audioFile.deleteFile();
+        return {};
+    }
+
+    take.audioFile = this->audioFile;
+    take.peaksFile = this->audioFile.withFileExtension("peaks");
+    take.lengthInSamples = peaks->getLengthInSamples();
+    take.sampleRate = peaks->getSampleRate();
+    take.peaks = peaks;
+
+    // the peaks can be rebuilt from the audio anytime, so this isn't fatal
+    if (!peaks->saveTo(take.peaksFile))
+    {
+        DBG("Failed to save the take peaks");
+    }
+
+    return take;
+}
+
+bool AudioRecorder::isRecording() const noexcept
+{
+    return this->recordingFlag.get();
+}
+
+void AudioRecorder::setPlaybackSchedule(PlaybackSchedule::Ptr newSchedule)
+{
+    const ScopedLock sl(this->lock);
+    std::swap(this->schedule, newSchedule);
+}
+
+void AudioRecorder::updatePlaybackSchedule(const PlaybackSchedule *previousSchedule,
+    PlaybackSchedule::Ptr newSchedule)
+{
+    const ScopedLock sl(this->lock);
+    if (this->schedule.get() == previousSchedule)
+    {
+        std::swap(this->schedule, newSchedule);
+    }
+}
+
+//===----------------------------------------------------------------------===//
+// Writer thread
+//===----------------------------------------------------------------------===//
+
+void AudioRecorder::run()
+{
+    while (!this->threadShouldExit())
+    {
+        if (!this->writePendingSamples())
+        {
+            DBG("Failed to write the recorded samples");
+            this->writerFailed = true;
+            return;
+        }
+
+        // the ring is large enough to only be drained every now and then
+        this->wait(AUDIO_RECORDER_WRITER_INTERVAL_MS);
+    }
+}
+
+bool AudioRecorder::writePendingSamples()
+{
+    int start1, size1, start2, size2;
+    this->fifo.prepareToRead(this->fifo.getNumReady(), start1, size1, start2, size2);
+
+    if (size1 > 0)
+    {
+        if (!this->writer->writeFromAudioSampleBuffer(this->ring, start1, size1))
+        {
+            return false;
+        }
+
+        this->peaksBuilder->addSamples(this->ring, start1, size1);
+    }
+
+    if (size2 > 0)
+    {
+        if (!this->writer->writeFromAudioSampleBuffer(this->ring, start2, size2))
+        {
+            return false;
+        }
+
+        this->peaksBuilder->addSamples(this->ring, start2, size2);
+    }
+
+    this->fifo.finishedRead(size1 + size2);
+    return true;
+}
+
+//===----------------------------------------------------------------------===//
+// AudioIODeviceCallback
+//===----------------------------------------------------------------------===//
+
+void AudioRecorder::audioDeviceIOCallback(const float **inputChannelData, int numInputChannels,
+    float **outputChannelData, int numOutputChannels, int numSamples)
+{
+    REALTIME_SCOPE("AudioRecorder::audioDeviceIOCallback");
+
+    for (int i = 0; i < numOutputChannels; ++i)
+    {
+        FloatVectorOperations::clear(outputChannelData[i], numSamples);
+    }
+
+    if (!this->recordingFlag.get())
+    {
+        return;
+    }
+
+    REALTIME_SCOPED_LOCK(this->lock);
+
+    if (!this->recording || this->schedule == nullptr || this->schedule->isStopped())
+    {
+        return;
+    }
+
+    const auto blockPosition = this->schedule->getBlockPosition();
+
+    // nothing is captured while counting in
+    const auto startSample = int(jlimit(int64(0), int64(numSamples), -blockPosition));
+    if (startSample >= numSamples)
+    {
+        return;
+    }
+
+    if (this->startSamplePosition < 0)
+    {
+        // what's coming in now has been played along with
+        // what has been sent out a round trip earlier
+        const auto length = this->schedule->getLengthInSamples();
+        const auto position = blockPosition + startSample;
+        const auto localPosition = this->schedule->isLooped() ? (position % length) : position;
+        this->startSamplePosition = jmax(int64(0), this->schedule->getStartSamplePosition() +
+            localPosition - this->roundTripLatency);
+    }
+
+    this->captureBlock(inputChannelData, numInputChannels, startSample, numSamples - startSample);
+}
+
+void AudioRecorder::captureBlock(const float **inputChannelData, int numInputChannels,
+    int startSample, int numSamples) noexcept
+{
+    // the silence for the previously dropped blocks goes first
+    if (this->numSamplesToPad > 0)
+    {
+        int start1, size1, start2, size2;
+        this->fifo.prepareToWrite(int(jmin(this->numSamplesToPad, int64(this->fifo.getFreeSpace()))),
+            start1, size1, start2, size2);
+
+        for (int c = 0; c < this->ring.getNumChannels(); ++c)
+        {
+            this->ring.clear(c, start1, size1);
+            this->ring.clear(c, start2, size2);
+        }
+
+        this->fifo.finishedWrite(size1 + size2);
+        this->numSamplesToPad -= size1 + size2;
+        this->numDroppedSamples += size1 + size2;
+    }
+
+    // the blocks are never split, so that a gap is always a whole block
+    if (this->numSamplesToPad > 0 || this->fifo.getFreeSpace() < numSamples)
+    {
+        this->numSamplesToPad += numSamples;
+        return;
+    }
+
+    int start1, size1, start2, size2;
+    this->fifo.prepareToWrite(numSamples, start1, size1, start2, size2);
+
+    for (int c = 0; c < this->ring.getNumChannels(); ++c)
+    {
+        if (numInputChannels == 0 || inputChannelData[jmin(c, numInputChannels - 1)] == nullptr)
+        {
+            this->ring.clear(c, start1, size1);
+            this->ring.clear(c, start2, size2);
+            continue;
+        }
+
+        const auto *input = inputChannelData[jmin(c, numInputChannels - 1)] + startSample;
+        this->ring.copyFrom(c, start1, input, size1);
+        this->ring.copyFrom(c, start2, input + size1, size2);
+    }
+
+    this->fifo.finishedWrite(size1 + size2);
+}
+
+void AudioRecorder::audioDeviceAboutToStart(AudioIODevice *device)
+{
+    const ScopedLock sl(this->lock);
+    this->numInputChannels = device->getActiveInputChannels().countNumberOfSetBits();
+    this->sampleRate = device->getCurrentSampleRate();
+
+    // one block for the input, and one for the output, as the instruments count it
+    this->roundTripLatency = device->getInputLatencyInSamples() +
+        device->getOutputLatencyInSamples() + device->getCurrentBufferSizeSamples() * 2;
+}
+
+void AudioRecorder::audioDeviceStopped() {}
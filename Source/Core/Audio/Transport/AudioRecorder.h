@@ -0,0 +1,122 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#include "PlaybackSchedule.h"
+#include "AudioPeaks.h"
+
+/*
+    Captures the audio input into a file while playing: the device callback
+    only copies the input into a lock-free ring buffer, and the writer thread
+    streams it to disk, building the take's peaks along the way, so that
+    neither the encoding nor the disk can ever stall the audio thread.
+
+    If the disk is so slow that the ring overflows, the blocks which didn't
+    fit are replaced with silence as soon as there's room again, so the rest
+    of the take stays in time; the number of such samples is reported.
+
+    Like the metronome, it follows the playback schedule, and the capture
+    starts right with the first block after the count-in, so that the take's
+    position in the project is sample-accurate, given the device's latency.
+*/
+
+class AudioRecorder final : public AudioIODeviceCallback, private Thread
+{
+public:
+
+    AudioRecorder();
+    ~AudioRecorder() override;
+
+    struct Take final
+    {
+        File audioFile;
+        File peaksFile;
+        AudioPeaks::Ptr peaks;
+
+        // the position of the first sample since the project start
+        int64 startSamplePosition = 0;
+        int64 lengthInSamples = 0;
+        double sampleRate = 0.0;
+
+        int64 numDroppedSamples = 0;
+    };
+
+    // Creates the 32-bit float wav file with all active input channels,
+    // and starts the capture, which begins with the playback's range;
+    // returns false, if there are no inputs, or if the file can't be created
+    bool startRecording(const File &targetFile);
+
+    // Waits for the writer to flush the rest of the ring, finalizes the file,
+    // and saves the peaks file next to it; returns the take, or the take
+    // with no file, if nothing has been recorded, or if writing has failed
+    Take stopRecording();
+    bool isRecording() const noexcept;
+
+    // Called by the player thread, along with the metronome's methods
+    void setPlaybackSchedule(PlaybackSchedule::Ptr newSchedule);
+    void updatePlaybackSchedule(const PlaybackSchedule *previousSchedule,
+        PlaybackSchedule::Ptr newSchedule);
+
+    //===------------------------------------------------------------------===//
+    // AudioIODeviceCallback
+    //===------------------------------------------------------------------===//
+
+    void audioDeviceIOCallback(const float **inputChannelData, int numInputChannels,
+        float **outputChannelData, int numOutputChannels, int numSamples) override;
+    void audioDeviceAboutToStart(AudioIODevice *device) override;
+    void audioDeviceStopped() override;
+
+private:
+
+    void run() override;
+    bool writePendingSamples();
+
+    void captureBlock(const float **inputChannelData, int numInputChannels,
+        int startSample, int numSamples) noexcept;
+
+    CriticalSection lock;
+    PlaybackSchedule::Ptr schedule;
+
+    // the device's input setup, as of its last start
+    int numInputChannels = 0;
+    double sampleRate = 0.0;
+    int roundTripLatency = 0;
+
+    // set up by the message thread before the capture starts,
+    // and then shared by the audio thread and the writer thread
+    AudioSampleBuffer ring;
+    AbstractFifo fifo;
+
+    bool recording = false;
+    Atomic<bool> recordingFlag = false;
+
+    // only accessed by the audio thread while recording
+    int64 startSamplePosition = -1;
+    int64 numSamplesToPad = 0;
+    int64 numDroppedSamples = 0;
+
+    // only accessed by the writer thread while recording
+    UniquePointer<AudioFormatWriter> writer;
+    UniquePointer<AudioPeaks::Builder> peaksBuilder;
+    Atomic<bool> writerFailed = false;
+
+    File audioFile;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AudioRecorder)
+};
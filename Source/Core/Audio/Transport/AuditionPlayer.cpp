@@ -0,0 +1,176 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "Common.h"
+#include "AuditionPlayer.h"
+#include "Instrument.h"
+
+#define AUDITION_STOP_TIMEOUT_MS 1000
+
+AuditionPlayer::AuditionPlayer() :
+    Thread("AuditionPlayer")
+{
+    this->startThread(9);
+}
+
+AuditionPlayer::~AuditionPlayer()
+{
+    this->signalThreadShouldExit();
+    this->notify();
+    this->stopThread(AUDITION_STOP_TIMEOUT_MS);
+}
+
+void AuditionPlayer::play(const MidiMessageSequence &sequence,
+    WeakReference<Instrument> instrument)
+{
+    {
+        const SpinLock::ScopedLockType lock(this->slotLock);
+        this->pendingSequence = sequence;
+        this->pendingInstrument = instrument;
+        this->hasPendingSequence = true;
+        ++this->lastRequestId;
+    }
+
+    this->notify();
+}
+
+void AuditionPlayer::stop()
+{
+    if (!this->isPlaying())
+    {
+        return;
+    }
+
+    {
+        const SpinLock::ScopedLockType lock(this->slotLock);
+        this->pendingSequence.clear();
+        this->pendingInstrument = nullptr;
+        this->hasPendingSequence = false;
+        ++this->lastRequestId;
+    }
+
+    this->notify();
+}
+
+bool AuditionPlayer::isPlaying() const
+{
+    return this->lastRequestId.get() != this->finishedRequestId.get();
+}
+
+bool AuditionPlayer::waitUntil(double targetTimeMs)
+{
+    for (;;)
+    {
+        if (this->threadShouldExit() ||
+            this->lastRequestId.get() != this->currentRequestId)
+        {
+            return false;
+        }
+
+        const auto timeNow = Time::getMillisecondCounterHiRes();
+        if (timeNow >= targetTimeMs)
+        {
+            return true;
+        }
+
+        this->wait(jmax(1, int(targetTimeMs - timeNow)));
+    }
+}
+
+void AuditionPlayer::run()
+{
+    while (!this->threadShouldExit())
+    {
+        MidiMessageSequence sequence;
+        WeakReference<Instrument> instrument;
+        bool hasSequence = false;
+        int requestId = 0;
+
+        {
+            const SpinLock::ScopedLockType lock(this->slotLock);
+            hasSequence = this->hasPendingSequence;
+            this->pendingSequence.swapWith(sequence);
+            instrument = this->pendingInstrument;
+            requestId = this->lastRequestId.get();
+            this->hasPendingSequence = false;
+        }
+
+        if (requestId == this->currentRequestId)
+        {
+            this->wait(-1);
+            continue;
+        }
+
+        this->currentRequestId = requestId;
+
+        if (hasSequence && instrument != nullptr)
+        {
+            this->play(sequence, *instrument);
+        }
+
+        this->finishedRequestId = requestId;
+    }
+}
+
+void AuditionPlayer::play(const MidiMessageSequence &sequence, Instrument &instrument)
+{
+    struct HoldingNote final
+    {
+        int channel;
+        int key;
+    };
+
+    Array<HoldingNote> holdingNotes;
+    auto &player = instrument.getProcessorPlayer();
+    const auto startTimeMs = Time::getMillisecondCounterHiRes();
+
+    for (int i = 0; i < sequence.getNumEvents(); ++i)
+    {
+        auto message = sequence.getEventPointer(i)->message;
+        if (!this->waitUntil(startTimeMs + message.getTimeStamp()))
+        {
+            break;
+        }
+
+        message.setTimeStamp(Time::getMillisecondCounterHiRes() * 0.001);
+        player.addPreviewMessage(message);
+
+        if (message.isNoteOn())
+        {
+            holdingNotes.add({ message.getChannel(), message.getNoteNumber() });
+        }
+        else if (message.isNoteOff())
+        {
+            for (int j = 0; j < holdingNotes.size(); ++j)
+            {
+                if (holdingNotes.getReference(j).channel == message.getChannel() &&
+                    holdingNotes.getReference(j).key == message.getNoteNumber())
+                {
+                    holdingNotes.remove(j);
+                    break;
+                }
+            }
+        }
+    }
+
+    // interrupted, release whatever is still sounding
+    for (const auto &note : holdingNotes)
+    {
+        player.addPreviewMessage(MidiMessage::noteOff(note.channel, note.key));
+    }
+}
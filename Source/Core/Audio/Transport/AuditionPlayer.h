@@ -0,0 +1,62 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+class Instrument;
+
+/*
+    Plays the short sequences, like the scale or arpeggio previews, through
+    the instrument's preview messages: unlike the player thread, it doesn't
+    need the playback cache, so auditioning something never invalidates it.
+    Only one sequence plays at a time, the next one interrupts the current.
+*/
+
+class AuditionPlayer final : public Thread
+{
+public:
+
+    AuditionPlayer();
+    ~AuditionPlayer() override;
+
+    // the time stamps are in milliseconds from the start
+    void play(const MidiMessageSequence &sequence, WeakReference<Instrument> instrument);
+    void stop();
+    bool isPlaying() const;
+
+private:
+
+    void run() override;
+    void play(const MidiMessageSequence &sequence, Instrument &instrument);
+
+    // returns false, if interrupted
+    bool waitUntil(double targetTimeMs);
+
+    SpinLock slotLock;
+    MidiMessageSequence pendingSequence;
+    WeakReference<Instrument> pendingInstrument;
+    bool hasPendingSequence = false;
+
+    Atomic<int> lastRequestId = 0;
+    Atomic<int> finishedRequestId = 0;
+
+    // only accessed by the thread itself
+    int currentRequestId = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AuditionPlayer)
+};
@@ -0,0 +1,357 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "Common.h"
+#include "Metronome.h"
+#include "RealtimeSafety.h"
+
+#define METRONOME_CLICK_FREQUENCY (1000.0)
+#define METRONOME_ACCENT_FREQUENCY (1500.0)
+#define METRONOME_CLICK_LEVEL (0.35f)
+#define METRONOME_ACCENT_LEVEL (0.5f)
+#define METRONOME_CLICK_DECAY_MS (8.0)
+#define METRONOME_CLICK_LENGTH_MS (40.0)
+
+// less than any click interval, so that stepping by it finds the next click
+#define METRONOME_CLICK_SEARCH_STEP (1.0 / 256.0)
+
+double Metronome::findNextClick(const TimeSignatures &timeSignatures,
+    double timeStamp, bool &outIsBarStart) noexcept
+{
+    int index = 0;
+    while (index + 1 < timeSignatures.size() &&
+        timeSignatures.getReference(index + 1).timeStamp <= timeStamp)
+    {
+        index++;
+    }
+
+    double anchor = 0.0;
+    int numerator = 4;
+    int denominator = 4;
+
+    if (!timeSignatures.isEmpty())
+    {
+        const auto &signature = timeSignatures.getReference(index);
+        anchor = signature.timeStamp;
+        numerator = jmax(1, signature.numerator);
+        denominator = jmax(1, signature.denominator);
+    }
+
+    // the clicks are on the denominator's beats, and the bars start at the signature
+    const double step = 4.0 / double(denominator);
+    const auto clickIndex = int64(std::ceil((timeStamp - anchor) / step));
+    const double click = anchor + double(clickIndex) * step;
+
+    // the next signature may come before the next click of this one
+    if (index + 1 < timeSignatures.size() &&
+        click >= timeSignatures.getReference(index + 1).timeStamp)
+    {
+        outIsBarStart = true;
+        return timeSignatures.getReference(index + 1).timeStamp;
+    }
+
+    outIsBarStart = (clickIndex % numerator) == 0;
+    return click;
+}
+
+double Metronome::findClickAfter(const TimeSignatures &timeSignatures,
+    double click, bool &outIsBarStart) noexcept
+{
+    return findNextClick(timeSignatures, click + METRONOME_CLICK_SEARCH_STEP, outIsBarStart);
+}
+
+//===----------------------------------------------------------------------===//
+// Voice
+//===----------------------------------------------------------------------===//
+
+void Metronome::Voice::prepare(double newSampleRate) noexcept
+{
+    this->sampleRate = newSampleRate;
+    this->decay = float(std::exp(-1000.0 / (METRONOME_CLICK_DECAY_MS * newSampleRate)));
+    this->reset();
+}
+
+void Metronome::Voice::trigger(bool isAccent) noexcept
+{
+    const auto frequency = isAccent ? METRONOME_ACCENT_FREQUENCY : METRONOME_CLICK_FREQUENCY;
+    this->phase = 0.0;
+    this->phaseDelta = MathConstants<double>::twoPi * frequency / this->sampleRate;
+    this->level = isAccent ? METRONOME_ACCENT_LEVEL : METRONOME_CLICK_LEVEL;
+    this->samplesLeft = int(METRONOME_CLICK_LENGTH_MS * this->sampleRate / 1000.0);
+}
+
+void Metronome::Voice::reset() noexcept
+{
+    this->samplesLeft = 0;
+    this->level = 0.f;
+}
+
+void Metronome::Voice::render(float **channels, int numChannels,
+    int startSample, int numSamples) noexcept
+{
+    const int numToRender = jmin(numSamples, this->samplesLeft);
+    for (int i = startSample; i < startSample + numToRender; ++i)
+    {
+        const auto sample = float(std::sin(this->phase)) * this->level;
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            channels[channel][i] += sample;
+        }
+
+        this->phase += this->phaseDelta;
+        this->level *= this->decay;
+    }
+
+    this->samplesLeft -= numToRender;
+}
+
+//===----------------------------------------------------------------------===//
+// Settings
+//===----------------------------------------------------------------------===//
+
+void Metronome::setEnabled(bool shouldBeEnabled) noexcept
+{
+    this->enabled = shouldBeEnabled;
+}
+
+bool Metronome::isEnabled() const noexcept
+{
+    return this->enabled.get();
+}
+
+void Metronome::setCountInBars(int numBars) noexcept
+{
+    this->countInBars = jmax(0, numBars);
+}
+
+int Metronome::getCountInBars() const noexcept
+{
+    return this->countInBars.get();
+}
+
+//===----------------------------------------------------------------------===//
+// Schedule
+//===----------------------------------------------------------------------===//
+
+double Metronome::getClickIntervalInSamples(const PlaybackSchedule &schedule,
+    const TimeSignatures &timeSignatures, int &outNumerator) noexcept
+{
+    double msPerQuarter = 0.0;
+    const auto startTimeStamp = schedule.getTimeStampAt(0, msPerQuarter);
+
+    int denominator = 4;
+    outNumerator = 4;
+    for (int i = 0; i < timeSignatures.size(); ++i)
+    {
+        const auto &signature = timeSignatures.getReference(i);
+        if (i > 0 && signature.timeStamp > startTimeStamp)
+        {
+            break;
+        }
+
+        outNumerator = jmax(1, signature.numerator);
+        denominator = jmax(1, signature.denominator);
+    }
+
+    return msPerQuarter * 4.0 / double(denominator) * schedule.getSampleRate() / 1000.0;
+}
+
+int64 Metronome::getCountInLength(const PlaybackSchedule &schedule,
+    const TimeSignatures &timeSignatures) const noexcept
+{
+    const int numBars = this->countInBars.get();
+    if (!this->enabled.get() || numBars <= 0)
+    {
+        return 0;
+    }
+
+    int numerator = 4;
+    const auto interval = getClickIntervalInSamples(schedule, timeSignatures, numerator);
+    return int64(interval * numBars * numerator);
+}
+
+void Metronome::setPlaybackSchedule(PlaybackSchedule::Ptr newSchedule,
+    const TimeSignatures &newTimeSignatures)
+{
+    double interval = 0.0;
+    int numClicks = 0;
+    int numerator = 4;
+
+    if (newSchedule != nullptr && newSchedule->getCountInLength() > 0)
+    {
+        interval = getClickIntervalInSamples(*newSchedule, newTimeSignatures, numerator);
+        numClicks = roundToInt(double(newSchedule->getCountInLength()) / interval);
+    }
+
+    TimeSignatures timeSignaturesCopy(newTimeSignatures);
+
+    {
+        const ScopedLock sl(this->lock);
+        std::swap(this->schedule, newSchedule);
+        this->timeSignatures.swapWith(timeSignaturesCopy);
+        this->countInInterval = interval;
+        this->numCountInClicks = numClicks;
+        this->countInNumerator = numerator;
+    }
+
+    // the previous schedule is released here, not on the audio thread
+}
+
+void Metronome::updatePlaybackSchedule(const PlaybackSchedule *previousSchedule,
+    PlaybackSchedule::Ptr newSchedule, const TimeSignatures &newTimeSignatures)
+{
+    TimeSignatures timeSignaturesCopy(newTimeSignatures);
+
+    const ScopedLock sl(this->lock);
+    if (this->schedule.get() == previousSchedule)
+    {
+        std::swap(this->schedule, newSchedule);
+        this->timeSignatures.swapWith(timeSignaturesCopy);
+    }
+}
+
+//===----------------------------------------------------------------------===//
+// AudioIODeviceCallback
+//===----------------------------------------------------------------------===//
+
+void Metronome::audioDeviceIOCallback(const float **inputChannelData, int numInputChannels,
+    float **outputChannelData, int numOutputChannels, int numSamples)
+{
+    REALTIME_SCOPE("Metronome::audioDeviceIOCallback");
+
+    for (int i = 0; i < numOutputChannels; ++i)
+    {
+        FloatVectorOperations::clear(outputChannelData[i], numSamples);
+    }
+
+    int rendered = 0;
+
+    {
+        REALTIME_SCOPED_LOCK(this->lock);
+
+        if (this->schedule != nullptr && !this->schedule->isStopped())
+        {
+            const auto blockPosition = this->schedule->getBlockPosition();
+
+            this->renderCountIn(blockPosition, numSamples,
+                outputChannelData, numOutputChannels, rendered);
+
+            if (this->enabled.get())
+            {
+                this->renderClicks(blockPosition, numSamples,
+                    outputChannelData, numOutputChannels, rendered);
+            }
+        }
+    }
+
+    // the last click's tail, if any
+    this->renderUntil(numSamples, outputChannelData, numOutputChannels, rendered);
+}
+
+void Metronome::audioDeviceAboutToStart(AudioIODevice *device)
+{
+    this->voice.prepare(device->getCurrentSampleRate());
+}
+
+void Metronome::audioDeviceStopped()
+{
+    this->voice.reset();
+}
+
+void Metronome::renderUntil(int sampleOffset, float **outputChannelData,
+    int numOutputChannels, int &rendered) noexcept
+{
+    if (sampleOffset > rendered)
+    {
+        this->voice.render(outputChannelData, numOutputChannels, rendered, sampleOffset - rendered);
+        rendered = sampleOffset;
+    }
+}
+
+void Metronome::renderCountIn(int64 blockPosition, int numSamples,
+    float **outputChannelData, int numOutputChannels, int &rendered) noexcept
+{
+    if (blockPosition >= 0 || this->numCountInClicks == 0)
+    {
+        return;
+    }
+
+    const auto countInStart = -this->schedule->getCountInLength();
+    const auto blockEnd = blockPosition + numSamples;
+
+    // the first click at or after the block start
+    auto clickIndex = jmax(0, int(std::ceil(double(blockPosition - countInStart) / this->countInInterval)));
+    for (; clickIndex < this->numCountInClicks; ++clickIndex)
+    {
+        const auto clickPosition = countInStart + int64(clickIndex * this->countInInterval);
+        if (clickPosition >= blockEnd || clickPosition >= 0)
+        {
+            break;
+        }
+
+        this->renderUntil(int(clickPosition - blockPosition), outputChannelData, numOutputChannels, rendered);
+        this->voice.trigger(clickIndex % this->countInNumerator == 0);
+    }
+}
+
+// The beats are searched by the timestamps of each block's segment within the
+// playback range, and each click found is converted back to its exact sample
+void Metronome::renderClicks(int64 blockPosition, int numSamples,
+    float **outputChannelData, int numOutputChannels, int &rendered) noexcept
+{
+    const auto length = this->schedule->getLengthInSamples();
+    const auto isLooped = this->schedule->isLooped();
+
+    int processed = int(jlimit(int64(0), int64(numSamples), -blockPosition));
+    while (processed < numSamples)
+    {
+        const auto position = blockPosition + processed;
+        const auto localPosition = isLooped ? (position % length) : position;
+        if (localPosition >= length)
+        {
+            break;
+        }
+
+        const auto segmentEnd = jmin(localPosition + int64(numSamples - processed), length);
+
+        // the range start is taken as is, and not converted back and forth,
+        // so that a click right at the start is never missed by rounding
+        double msPerQuarter = 0.0;
+        const double segmentStartTimeStamp = (localPosition == 0) ?
+            this->schedule->getStartTimeStamp() :
+            this->schedule->getTimeStampAt(localPosition, msPerQuarter);
+        // the exact end, so that the loop start's click never doubles at the seam
+        const double segmentEndTimeStamp = (segmentEnd == length) ?
+            this->schedule->getEndTimeStamp() :
+            this->schedule->getTimeStampAt(segmentEnd, msPerQuarter);
+
+        bool isBarStart = false;
+        auto click = findNextClick(this->timeSignatures, segmentStartTimeStamp, isBarStart);
+        while (click < segmentEndTimeStamp)
+        {
+            const auto clickPosition = this->schedule->getSamplePositionAt(click);
+            const auto clickOffset = jlimit(int64(0), segmentEnd - localPosition - 1, clickPosition - localPosition);
+            this->renderUntil(processed + int(clickOffset), outputChannelData, numOutputChannels, rendered);
+            this->voice.trigger(isBarStart);
+
+            click = findClickAfter(this->timeSignatures, click, isBarStart);
+        }
+
+        processed += int(segmentEnd - localPosition);
+    }
+}
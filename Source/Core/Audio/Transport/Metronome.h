@@ -0,0 +1,139 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#include "PlaybackSchedule.h"
+
+/*
+    The click track, generated right in the audio callback: instead of
+    sending the clicks through some instrument as midi, which would make
+    them as late as the instrument is, it follows the playback schedule,
+    finds the beats within each block by the schedule's tempo map, and
+    mixes the clicks in at their exact sample offsets.
+
+    The count-in is a number of bars clicked before the schedule starts:
+    the schedule is simply delayed by their length, see getCountInLength.
+*/
+
+class Metronome final : public AudioIODeviceCallback
+{
+public:
+
+    Metronome() = default;
+
+    // The time signature changes, in the playback cache timestamps
+    struct TimeSignature final
+    {
+        double timeStamp;
+        int numerator;
+        int denominator;
+    };
+
+    using TimeSignatures = Array<TimeSignature>;
+
+    // Returns the first click at or after the time stamp, and whether it starts a bar;
+    // the first time signature also applies before it, and with none at all it's 4/4
+    static double findNextClick(const TimeSignatures &timeSignatures,
+        double timeStamp, bool &outIsBarStart) noexcept;
+
+    // The same, but strictly after the given click
+    static double findClickAfter(const TimeSignatures &timeSignatures,
+        double click, bool &outIsBarStart) noexcept;
+
+    // One click sound at a time, each next one cuts the previous
+    class Voice final
+    {
+    public:
+
+        void prepare(double sampleRate) noexcept;
+        void trigger(bool isAccent) noexcept;
+        void reset() noexcept;
+
+        // adds the sound to the channels, from the start sample on
+        void render(float **channels, int numChannels, int startSample, int numSamples) noexcept;
+
+    private:
+
+        double sampleRate = 44100.0;
+        double phase = 0.0;
+        double phaseDelta = 0.0;
+        float level = 0.f;
+        float decay = 0.f;
+        int samplesLeft = 0;
+    };
+
+    void setEnabled(bool shouldBeEnabled) noexcept;
+    bool isEnabled() const noexcept;
+
+    // the count-in is only played along with the metronome itself, and 0 means none
+    void setCountInBars(int numBars) noexcept;
+    int getCountInBars() const noexcept;
+
+    // How long the count-in would be for this schedule, in its tempo and meter at
+    // the start, or 0 if none; to be set before it's handed to the instruments
+    int64 getCountInLength(const PlaybackSchedule &schedule,
+        const TimeSignatures &timeSignatures) const noexcept;
+
+    // Called by the player thread after the instruments have got the schedule,
+    // so that whichever callback comes first, all of them start together
+    void setPlaybackSchedule(PlaybackSchedule::Ptr newSchedule,
+        const TimeSignatures &timeSignatures);
+
+    // Swaps the schedule with its updated version, see withUpdatedSequences,
+    // unless the playback has been restarted with another one meanwhile
+    void updatePlaybackSchedule(const PlaybackSchedule *previousSchedule,
+        PlaybackSchedule::Ptr newSchedule, const TimeSignatures &timeSignatures);
+
+    //===------------------------------------------------------------------===//
+    // AudioIODeviceCallback
+    //===------------------------------------------------------------------===//
+
+    void audioDeviceIOCallback(const float **inputChannelData, int numInputChannels,
+        float **outputChannelData, int numOutputChannels, int numSamples) override;
+    void audioDeviceAboutToStart(AudioIODevice *device) override;
+    void audioDeviceStopped() override;
+
+private:
+
+    static double getClickIntervalInSamples(const PlaybackSchedule &schedule,
+        const TimeSignatures &timeSignatures, int &outNumerator) noexcept;
+
+    void renderCountIn(int64 blockPosition, int numSamples,
+        float **outputChannelData, int numOutputChannels, int &rendered) noexcept;
+    void renderClicks(int64 blockPosition, int numSamples,
+        float **outputChannelData, int numOutputChannels, int &rendered) noexcept;
+    void renderUntil(int sampleOffset, float **outputChannelData,
+        int numOutputChannels, int &rendered) noexcept;
+
+    Atomic<bool> enabled = false;
+    Atomic<int> countInBars = 1;
+
+    CriticalSection lock;
+    PlaybackSchedule::Ptr schedule;
+    TimeSignatures timeSignatures;
+
+    // the count-in clicks before the schedule start, in samples
+    double countInInterval = 0.0;
+    int numCountInClicks = 0;
+    int countInNumerator = 4;
+
+    Voice voice;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Metronome)
+};
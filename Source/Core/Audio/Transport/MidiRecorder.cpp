@@ -0,0 +1,198 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Common.h"
+#include "MidiRecorder.h"
+#include "Transport.h"
+#include "PianoSequence.h"
+
+#define MIDI_RECORDER_FIFO_SIZE 4096
+#define MIDI_RECORDER_COMMIT_INTERVAL_MS 250
+#define MIDI_RECORDER_MIN_NOTE_LENGTH (1.f / TICKS_PER_BEAT)
+
+MidiRecorder::MidiRecorder(Transport &transport, AudioDeviceManager &deviceManager) :
+    transport(transport),
+    deviceManager(deviceManager),
+    fifo(MIDI_RECORDER_FIFO_SIZE),
+    fifoBuffer(MIDI_RECORDER_FIFO_SIZE) {}
+
+MidiRecorder::~MidiRecorder()
+{
+    this->stopRecording();
+}
+
+void MidiRecorder::startRecording(WeakReference<MidiSequence> targetSequence, const Clip &targetClip)
+{
+    this->stopRecording();
+
+    if (dynamic_cast<PianoSequence *>(targetSequence.get()) == nullptr)
+    {
+        jassertfalse;
+        return;
+    }
+
+    this->sequence = targetSequence;
+    this->clip = targetClip;
+    this->fifo.reset();
+
+    // all batches of this take will go into the same undo transaction
+    this->sequence->checkpoint();
+
+    this->recording = true;
+    this->deviceManager.addMidiInputCallback({}, this);
+    this->startTimer(MIDI_RECORDER_COMMIT_INTERVAL_MS);
+}
+
+void MidiRecorder::stopRecording()
+{
+    if (!this->recording.get())
+    {
+        return;
+    }
+
+    // this waits for the midi threads to leave the callback
+    this->deviceManager.removeMidiInputCallback({}, this);
+    this->recording = false;
+    this->stopTimer();
+
+    this->processRecordedEvents();
+
+    // the keys still held at the end of the take are released right there
+    const auto endBeat = float(this->transport.getPlaybackBeat());
+    for (const auto &holding : this->holdingNotes)
+    {
+        if (this->sequence != nullptr)
+        {
+            this->finishedNotes.add(Note(this->sequence, holding.key, holding.beat,
+                jmax(MIDI_RECORDER_MIN_NOTE_LENGTH, endBeat - holding.beat), holding.velocity));
+        }
+    }
+
+    this->holdingNotes.clearQuick();
+    this->commitFinishedNotes();
+    this->sequence = nullptr;
+}
+
+bool MidiRecorder::isRecording() const noexcept
+{
+    return this->recording.get();
+}
+
+//===----------------------------------------------------------------------===//
+// MidiInputCallback
+//===----------------------------------------------------------------------===//
+
+void MidiRecorder::handleIncomingMidiMessage(MidiInput *, const MidiMessage &message)
+{
+    if (!this->recording.get() || !(message.isNoteOn() || message.isNoteOff()))
+    {
+        return;
+    }
+
+    const RecordedEvent event {
+        this->transport.getPlaybackBeat(),
+        int8(message.getChannel()),
+        int8(message.getNoteNumber()),
+        message.isNoteOn() ? message.getVelocity() : uint8(0)
+    };
+
+    const SpinLock::ScopedLockType lock(this->writerLock);
+
+    int start1, size1, start2, size2;
+    this->fifo.prepareToWrite(1, start1, size1, start2, size2);
+    if (size1 + size2 == 0)
+    {
+        return; // the message thread is way too late, just drop it
+    }
+
+    this->fifoBuffer[size1 > 0 ? start1 : start2] = event;
+    this->fifo.finishedWrite(1);
+}
+
+//===----------------------------------------------------------------------===//
+// Timer
+//===----------------------------------------------------------------------===//
+
+void MidiRecorder::timerCallback()
+{
+    // the take ends when the playback does
+    if (!this->transport.isPlaying())
+    {
+        this->stopRecording();
+        return;
+    }
+
+    this->processRecordedEvents();
+    this->commitFinishedNotes();
+}
+
+void MidiRecorder::processRecordedEvents()
+{
+    int start1, size1, start2, size2;
+    this->fifo.prepareToRead(this->fifo.getNumReady(), start1, size1, start2, size2);
+
+    const auto processEvent = [this](const RecordedEvent &event)
+    {
+        const auto beat = float(event.beat) - this->clip.getBeat();
+        const int key = int(event.key) - this->clip.getKey();
+
+        // a note-on for the key already held also ends the previous one
+        for (int i = 0; i < this->holdingNotes.size(); ++i)
+        {
+            const auto &holding = this->holdingNotes.getReference(i);
+            if (holding.key == key && holding.channel == int(event.channel))
+            {
+                if (this->sequence != nullptr)
+                {
+                    this->finishedNotes.add(Note(this->sequence, key, holding.beat,
+                        jmax(MIDI_RECORDER_MIN_NOTE_LENGTH, beat - holding.beat), holding.velocity));
+                }
+
+                this->holdingNotes.remove(i);
+                break;
+            }
+        }
+
+        if (event.velocity > 0)
+        {
+            this->holdingNotes.add({ int(event.channel), key, beat, float(event.velocity) / 127.f });
+        }
+    };
+
+    for (int i = 0; i < size1; ++i)
+    {
+        processEvent(this->fifoBuffer[start1 + i]);
+    }
+
+    for (int i = 0; i < size2; ++i)
+    {
+        processEvent(this->fifoBuffer[start2 + i]);
+    }
+
+    this->fifo.finishedRead(size1 + size2);
+}
+
+void MidiRecorder::commitFinishedNotes()
+{
+    auto *pianoSequence = dynamic_cast<PianoSequence *>(this->sequence.get());
+    if (pianoSequence != nullptr && !this->finishedNotes.isEmpty())
+    {
+        pianoSequence->insertGroup(this->finishedNotes, true);
+    }
+
+    this->finishedNotes.clearQuick();
+}
@@ -0,0 +1,96 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+class Transport;
+class MidiSequence;
+
+#include "Clip.h"
+#include "Note.h"
+
+/*
+    Records the live midi input into a piano sequence, while playing.
+
+    The midi thread only pushes the incoming notes, timestamped by the
+    transport's playback position, into a lock-free fifo; the message thread
+    drains it several times a second, pairs the note-ons with the note-offs,
+    and commits the finished notes via the bulk insert, so that the sequence
+    isn't changed per message, and the whole take is one undo transaction.
+*/
+
+class MidiRecorder final : public MidiInputCallback, private Timer
+{
+public:
+
+    MidiRecorder(Transport &transport, AudioDeviceManager &deviceManager);
+    ~MidiRecorder() override;
+
+    // the notes are placed into the sequence as seen through the clip,
+    // i.e. the clip's offset and transposition are subtracted from them
+    void startRecording(WeakReference<MidiSequence> sequence, const Clip &clip);
+    void stopRecording();
+    bool isRecording() const noexcept;
+
+    //===------------------------------------------------------------------===//
+    // MidiInputCallback
+    //===------------------------------------------------------------------===//
+
+    void handleIncomingMidiMessage(MidiInput *source, const MidiMessage &message) override;
+
+private:
+
+    void timerCallback() override;
+
+    void processRecordedEvents();
+    void commitFinishedNotes();
+
+    Transport &transport;
+    AudioDeviceManager &deviceManager;
+
+    struct RecordedEvent final
+    {
+        double beat;
+        int8 channel;
+        int8 key;
+        uint8 velocity; // zero for note-offs
+    };
+
+    AbstractFifo fifo;
+    HeapBlock<RecordedEvent> fifoBuffer;
+
+    // several devices may call back from different threads
+    SpinLock writerLock;
+
+    Atomic<bool> recording = false;
+
+    WeakReference<MidiSequence> sequence;
+    Clip clip;
+
+    struct HoldingNote final
+    {
+        int channel;
+        int key;
+        float beat;
+        float velocity;
+    };
+
+    Array<HoldingNote> holdingNotes;
+    Array<Note> finishedNotes;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MidiRecorder)
+};
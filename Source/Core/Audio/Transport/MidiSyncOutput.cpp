@@ -0,0 +1,380 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "Common.h"
+#include "MidiSyncOutput.h"
+#include "RealtimeSafety.h"
+
+#define MIDI_SYNC_CLOCKS_PER_QUARTER (24)
+#define MIDI_SYNC_MAX_SONG_POSITION (16383)
+
+// enough for any block's ticks and quarter frames
+#define MIDI_SYNC_BUFFER_SIZE (2048)
+
+static int getFramesPerSecond(MidiMessage::SmpteTimecodeType type) noexcept
+{
+    switch (type)
+    {
+        case MidiMessage::fps24: return 24;
+        case MidiMessage::fps25: return 25;
+        default: return 30;
+    }
+}
+
+// Each of the 8 quarter frames carries a nibble of the time code
+// of the frame at which the first of them has been sent
+static int getQuarterFrameValue(int piece, int64 frame, int framesPerSecond,
+    MidiMessage::SmpteTimecodeType type) noexcept
+{
+    const auto frames = int(frame % framesPerSecond);
+    const auto totalSeconds = frame / framesPerSecond;
+    const auto seconds = int(totalSeconds % 60);
+    const auto minutes = int((totalSeconds / 60) % 60);
+    const auto hours = int((totalSeconds / 3600) % 24);
+
+    switch (piece)
+    {
+        case 0: return frames & 0x0f;
+        case 1: return frames >> 4;
+        case 2: return seconds & 0x0f;
+        case 3: return seconds >> 4;
+        case 4: return minutes & 0x0f;
+        case 5: return minutes >> 4;
+        case 6: return hours & 0x0f;
+        default: return (hours >> 4) | (int(type) << 1);
+    }
+}
+
+//===----------------------------------------------------------------------===//
+// Ports
+//===----------------------------------------------------------------------===//
+
+void MidiSyncOutput::setPorts(const Array<PortSettings> &newPorts)
+{
+    OwnedArray<Port> oldPorts;
+
+    {
+        const ScopedLock sl(this->lock);
+        oldPorts.swapWith(this->ports);
+    }
+
+    OwnedArray<Port> updatedPorts;
+    for (const auto &settings : newPorts)
+    {
+        auto port = makeUnique<Port>();
+        port->settings = settings;
+        port->buffer.ensureSize(MIDI_SYNC_BUFFER_SIZE);
+
+        // the devices still listed are kept open
+        for (auto *oldPort : oldPorts)
+        {
+            if (oldPort->output != nullptr &&
+                oldPort->settings.deviceName == settings.deviceName)
+            {
+                port->output = std::move(oldPort->output);
+                break;
+            }
+        }
+
+        // if the device is not connected now, its settings are still kept
+        if (port->output == nullptr)
+        {
+            port->output = HardwareMidiOutput::open(settings.deviceName);
+        }
+
+        updatedPorts.add(port.release());
+    }
+
+    const ScopedLock sl(this->lock);
+    this->ports.swapWith(updatedPorts);
+}
+
+Array<MidiSyncOutput::PortSettings> MidiSyncOutput::getPorts() const
+{
+    Array<PortSettings> result;
+
+    const ScopedLock sl(this->lock);
+    for (const auto *port : this->ports)
+    {
+        result.add(port->settings);
+    }
+
+    return result;
+}
+
+//===----------------------------------------------------------------------===//
+// Schedule
+//===----------------------------------------------------------------------===//
+
+void MidiSyncOutput::setPlaybackSchedule(PlaybackSchedule::Ptr newSchedule)
+{
+    const ScopedLock sl(this->lock);
+    std::swap(this->schedule, newSchedule);
+    this->scheduleIsNew = true;
+}
+
+void MidiSyncOutput::updatePlaybackSchedule(const PlaybackSchedule *previousSchedule,
+    PlaybackSchedule::Ptr newSchedule)
+{
+    const ScopedLock sl(this->lock);
+    if (this->schedule.get() == previousSchedule)
+    {
+        std::swap(this->schedule, newSchedule);
+    }
+}
+
+//===----------------------------------------------------------------------===//
+// AudioIODeviceCallback
+//===----------------------------------------------------------------------===//
+
+void MidiSyncOutput::audioDeviceIOCallback(const float **inputChannelData, int numInputChannels,
+    float **outputChannelData, int numOutputChannels, int numSamples)
+{
+    REALTIME_SCOPE("MidiSyncOutput::audioDeviceIOCallback");
+
+    for (int i = 0; i < numOutputChannels; ++i)
+    {
+        FloatVectorOperations::clear(outputChannelData[i], numSamples);
+    }
+
+    // this block will be heard after the one being played now
+    const auto blockTimeMs = Time::getMillisecondCounterHiRes() + this->outputLatencyMs;
+
+    REALTIME_SCOPED_LOCK(this->lock);
+
+    if (this->ports.isEmpty())
+    {
+        return;
+    }
+
+    for (auto *port : this->ports)
+    {
+        port->buffer.clear();
+    }
+
+    this->renderScheduledMessages(numSamples);
+
+    for (auto *port : this->ports)
+    {
+        if (port->output != nullptr && !port->buffer.isEmpty())
+        {
+            port->output->addBlock(port->buffer,
+                blockTimeMs + port->settings.latencyOffsetMs, this->sampleRate);
+        }
+    }
+}
+
+void MidiSyncOutput::audioDeviceAboutToStart(AudioIODevice *device)
+{
+    const ScopedLock sl(this->lock);
+    this->sampleRate = device->getCurrentSampleRate();
+    this->outputLatencyMs = double(device->getOutputLatencyInSamples() +
+        device->getCurrentBufferSizeSamples()) / this->sampleRate * 1000.0;
+}
+
+void MidiSyncOutput::audioDeviceStopped() {}
+
+//===----------------------------------------------------------------------===//
+// Audio thread
+//===----------------------------------------------------------------------===//
+
+void MidiSyncOutput::renderScheduledMessages(int numSamples) noexcept
+{
+    if (this->scheduleIsNew)
+    {
+        if (this->isSending)
+        {
+            this->addStop(0);
+            this->isSending = false;
+        }
+
+        this->scheduleIsNew = false;
+    }
+
+    if (this->schedule == nullptr || this->schedule->isStopped())
+    {
+        if (this->isSending)
+        {
+            this->addStop(0);
+            this->isSending = false;
+        }
+
+        return;
+    }
+
+    const auto blockPosition = this->schedule->getBlockPosition();
+    const auto length = this->schedule->getLengthInSamples();
+    const auto isLooped = this->schedule->isLooped();
+
+    // nothing is sent while counting in
+    int processed = int(jlimit(int64(0), int64(numSamples), -blockPosition));
+    while (processed < numSamples)
+    {
+        const auto position = blockPosition + processed;
+        const auto iteration = isLooped ? (position / length) : 0;
+        const auto localPosition = isLooped ? (position % length) : position;
+
+        if (localPosition >= length)
+        {
+            if (this->isSending)
+            {
+                this->addStop(processed);
+                this->isSending = false;
+            }
+
+            break;
+        }
+
+        if (!this->isSending)
+        {
+            this->addStart(processed, localPosition);
+            this->isSending = true;
+            this->loopIteration = iteration;
+        }
+        else if (iteration != this->loopIteration)
+        {
+            // wrapped around the loop end
+            this->addStop(processed);
+            this->addStart(processed, localPosition);
+            this->loopIteration = iteration;
+        }
+
+        const auto segmentEnd = jmin(localPosition + int64(numSamples - processed), length);
+
+        this->addClockTicks(processed, localPosition, segmentEnd);
+
+        for (auto *port : this->ports)
+        {
+            if (port->settings.sendsTimecode)
+            {
+                this->addQuarterFrames(*port, processed, localPosition, segmentEnd);
+            }
+        }
+
+        processed += int(segmentEnd - localPosition);
+    }
+}
+
+void MidiSyncOutput::addClockMessage(const MidiMessage &message, int sampleOffset) noexcept
+{
+    for (auto *port : this->ports)
+    {
+        if (port->settings.sendsClock)
+        {
+            port->buffer.addEvent(message, sampleOffset);
+        }
+    }
+}
+
+void MidiSyncOutput::addStart(int sampleOffset, int64 localPosition) noexcept
+{
+    // the song position is in sixteenth notes since the project start
+    double msPerQuarter = 0.0;
+    const auto timeStamp = (localPosition == 0) ?
+        this->schedule->getStartTimeStamp() :
+        this->schedule->getTimeStampAt(localPosition, msPerQuarter);
+
+    const auto songPosition = jlimit(0, MIDI_SYNC_MAX_SONG_POSITION, int(std::floor(timeStamp * 4.0)));
+    this->addClockMessage(MidiMessage::songPositionPointerMessage(songPosition), sampleOffset);
+    this->addClockMessage(songPosition == 0 ? MidiMessage::midiStart() : MidiMessage::midiContinue(), sampleOffset);
+
+    const auto seconds = double(this->schedule->getStartSamplePosition() + localPosition) /
+        this->schedule->getSampleRate();
+
+    for (auto *port : this->ports)
+    {
+        if (port->settings.sendsTimecode)
+        {
+            const auto framesPerSecond = getFramesPerSecond(port->settings.timecodeType);
+            const auto frame = int64(seconds * framesPerSecond);
+            port->buffer.addEvent(MidiMessage::fullFrame(
+                int((frame / (framesPerSecond * 3600)) % 24),
+                int((frame / (framesPerSecond * 60)) % 60),
+                int((frame / framesPerSecond) % 60),
+                int(frame % framesPerSecond),
+                port->settings.timecodeType), sampleOffset);
+        }
+    }
+}
+
+void MidiSyncOutput::addStop(int sampleOffset) noexcept
+{
+    this->addClockMessage(MidiMessage::midiStop(), sampleOffset);
+}
+
+// The ticks are found by the timestamps, as the metronome's clicks are,
+// so they follow the tempo ramps, and each is placed at its exact sample
+void MidiSyncOutput::addClockTicks(int sampleOffset,
+    int64 localPosition, int64 segmentEnd) noexcept
+{
+    double msPerQuarter = 0.0;
+    const double startTimeStamp = (localPosition == 0) ?
+        this->schedule->getStartTimeStamp() :
+        this->schedule->getTimeStampAt(localPosition, msPerQuarter);
+    const double endTimeStamp = (segmentEnd == this->schedule->getLengthInSamples()) ?
+        this->schedule->getEndTimeStamp() :
+        this->schedule->getTimeStampAt(segmentEnd, msPerQuarter);
+
+    const auto ticksPerQuarter = double(MIDI_SYNC_CLOCKS_PER_QUARTER);
+    for (auto tick = int64(std::ceil(startTimeStamp * ticksPerQuarter)); ; ++tick)
+    {
+        const double tickTimeStamp = double(tick) / ticksPerQuarter;
+        if (tickTimeStamp >= endTimeStamp)
+        {
+            break;
+        }
+
+        const auto tickPosition = this->schedule->getSamplePositionAt(tickTimeStamp);
+        const auto tickOffset = jlimit(int64(0), segmentEnd - localPosition - 1, tickPosition - localPosition);
+        this->addClockMessage(MidiMessage::midiClock(), sampleOffset + int(tickOffset));
+    }
+}
+
+// The time code goes by the time since the project start, not by beats;
+// each quarter frame is at the first sample at or after its time
+void MidiSyncOutput::addQuarterFrames(Port &port, int sampleOffset,
+    int64 localPosition, int64 segmentEnd) noexcept
+{
+    const auto framesPerSecond = getFramesPerSecond(port.settings.timecodeType);
+    const auto quartersPerSample = double(framesPerSecond * 4) / this->schedule->getSampleRate();
+    const auto startPosition = this->schedule->getStartSamplePosition();
+
+    // starting a bit earlier, and skipping the ones before the segment,
+    // so that rounding never skips any quarter at the block boundaries
+    auto quarter = int64(std::floor(double(startPosition + localPosition) * quartersPerSample)) - 1;
+    for (; ; ++quarter)
+    {
+        const auto position = int64(std::ceil(double(quarter) / quartersPerSample)) - startPosition;
+        if (position >= segmentEnd)
+        {
+            break;
+        }
+
+        if (position < localPosition)
+        {
+            continue;
+        }
+
+        const auto piece = int(quarter & 7);
+        const auto value = getQuarterFrameValue(piece, (quarter - piece) / 4,
+            framesPerSecond, port.settings.timecodeType);
+
+        port.buffer.addEvent(MidiMessage::quarterFrame(piece, value),
+            sampleOffset + int(position - localPosition));
+    }
+}
@@ -0,0 +1,104 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#include "PlaybackSchedule.h"
+#include "HardwareMidiOutput.h"
+
+/*
+    Sends the midi clock (24 ticks per quarter) and the midi time code
+    to the external gear: like the metronome, it follows the playback schedule
+    in the audio callback, finds the ticks and the quarter frames within each
+    block by the schedule's tempo map, and passes them to the hardware outputs
+    stamped with the time at which that block will be heard.
+
+    At the playback start, the clock gets the song position and the start,
+    or continue, and the time code gets a full frame message; the same is sent
+    at each loop rewind, with a stop before it, so that the gear relocates.
+*/
+
+class MidiSyncOutput final : public AudioIODeviceCallback
+{
+public:
+
+    MidiSyncOutput() = default;
+
+    struct PortSettings final
+    {
+        String deviceName;
+        bool sendsClock = true;
+        bool sendsTimecode = false;
+        MidiMessage::SmpteTimecodeType timecodeType = MidiMessage::fps25;
+
+        // positive values delay the messages, and negative values
+        // send them earlier, e.g. to compensate the gear's own latency
+        double latencyOffsetMs = 0.0;
+    };
+
+    // Opens the devices, if needed, and closes the ones not listed anymore
+    void setPorts(const Array<PortSettings> &newPorts);
+    Array<PortSettings> getPorts() const;
+
+    // Called by the player thread, along with the metronome's methods
+    void setPlaybackSchedule(PlaybackSchedule::Ptr newSchedule);
+    void updatePlaybackSchedule(const PlaybackSchedule *previousSchedule,
+        PlaybackSchedule::Ptr newSchedule);
+
+    //===------------------------------------------------------------------===//
+    // AudioIODeviceCallback
+    //===------------------------------------------------------------------===//
+
+    void audioDeviceIOCallback(const float **inputChannelData, int numInputChannels,
+        float **outputChannelData, int numOutputChannels, int numSamples) override;
+    void audioDeviceAboutToStart(AudioIODevice *device) override;
+    void audioDeviceStopped() override;
+
+private:
+
+    struct Port final
+    {
+        PortSettings settings;
+        UniquePointer<HardwareMidiOutput> output;
+        MidiBuffer buffer;
+    };
+
+    void renderScheduledMessages(int numSamples) noexcept;
+    void addStart(int sampleOffset, int64 localPosition) noexcept;
+    void addStop(int sampleOffset) noexcept;
+    void addClockTicks(int sampleOffset, int64 localPosition, int64 segmentEnd) noexcept;
+    void addQuarterFrames(Port &port, int sampleOffset, int64 localPosition, int64 segmentEnd) noexcept;
+
+    void addClockMessage(const MidiMessage &message, int sampleOffset) noexcept;
+
+    CriticalSection lock;
+    OwnedArray<Port> ports;
+    PlaybackSchedule::Ptr schedule;
+
+    // set when the playback restarts, so that the gear relocates
+    bool scheduleIsNew = false;
+
+    // only accessed by the audio thread
+    bool isSending = false;
+    int64 loopIteration = 0;
+
+    double sampleRate = 0.0;
+    double outputLatencyMs = 0.0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MidiSyncOutput)
+};
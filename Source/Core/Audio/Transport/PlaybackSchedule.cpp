@@ -0,0 +1,239 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Common.h"
+#include "PlaybackSchedule.h"
+#include "ProjectSequencesWrapper.h"
+#include "AudioCore.h"
+
+PlaybackSchedule::PlaybackSchedule(const AudioClock &clock) :
+    clock(clock),
+    sampleRate(clock.getSampleRate()) {}
+
+PlaybackSchedule::Ptr PlaybackSchedule::createFrom(const ProjectSequences &sequences,
+    const TempoMap &tempoMap, const AudioClock &clock, double startTimeStamp,
+    double endTimeStamp, bool looped, const FrozenAudio::Map &frozenInstruments)
+{
+    Ptr schedule(new PlaybackSchedule(clock));
+    schedule->looped = looped;
+    schedule->startTimeStamp = startTimeStamp;
+    schedule->endTimeStamp = endTimeStamp;
+    schedule->tempoMap = tempoMap;
+    schedule->startTimeMs = tempoMap.getTimeAt(startTimeStamp);
+    schedule->start = new StartPosition();
+    schedule->build(sequences, sequences.getUniqueInstruments(), frozenInstruments);
+    return schedule;
+}
+
+PlaybackSchedule::Ptr PlaybackSchedule::withUpdatedSequences(const ProjectSequences &sequences,
+    const TempoMap &tempoMap, const FrozenAudio::Map &frozenInstruments) const
+{
+    Ptr schedule(new PlaybackSchedule(this->clock));
+    schedule->sampleRate = this->sampleRate;
+    schedule->looped = this->looped;
+    schedule->startTimeStamp = this->startTimeStamp;
+    schedule->endTimeStamp = this->endTimeStamp;
+    schedule->tempoMap = tempoMap;
+    schedule->startTimeMs = tempoMap.getTimeAt(this->startTimeStamp);
+    schedule->start = this->start;
+
+    // instruments which are not used anymore still need
+    // their lanes to release holding notes at the right time
+    auto instruments = sequences.getUniqueInstruments();
+    for (const auto *lane : this->lanes)
+    {
+        instruments.addIfNotAlreadyThere(lane->instrument);
+    }
+
+    schedule->build(sequences, instruments, frozenInstruments);
+    return schedule;
+}
+
+void PlaybackSchedule::build(const ProjectSequences &sequences,
+    const Array<Instrument *> &instruments, const FrozenAudio::Map &frozenInstruments)
+{
+    const double samplesPerMs = this->sampleRate / 1000.0;
+    jassert(samplesPerMs > 0.0);
+
+    FlatHashMap<Instrument *, Lane *> lanesByInstrument;
+    for (auto *instrument : instruments)
+    {
+        auto *lane = this->lanes.add(new Lane());
+        lane->instrument = instrument;
+        lanesByInstrument[instrument] = lane;
+
+        const auto frozen = frozenInstruments.find(instrument);
+        if (frozen != frozenInstruments.end() &&
+            frozen->second->getSampleRate() == this->sampleRate)
+        {
+            lane->frozenAudio = frozen->second;
+        }
+    }
+
+    CachedMidiMessage wrapper;
+    ProjectSequences::Cursor cursor(sequences);
+    cursor.seekToTime(this->startTimeStamp);
+    while (cursor.getNextMessage(wrapper))
+    {
+        const double timeStamp = wrapper.message.getTimeStamp();
+
+        // in looped mode, the events at the end of range
+        // will be played as the first ones at the next iteration
+        if (this->looped ? (timeStamp >= this->endTimeStamp) : (timeStamp > this->endTimeStamp))
+        {
+            break;
+        }
+
+        const double timeMs = this->tempoMap.getTimeAt(timeStamp) - this->startTimeMs;
+        const auto samplePosition = int64(timeMs * samplesPerMs);
+
+        if (wrapper.message.isTempoMetaEvent())
+        {
+            // master tempo event is sent to everybody (need to do that for drum-machines)
+            for (auto *lane : this->lanes)
+            {
+                lane->events.add({ samplePosition, wrapper.message });
+            }
+        }
+        else if (auto *lane = lanesByInstrument[wrapper.instrument])
+        {
+            lane->events.add({ samplePosition, wrapper.message });
+        }
+    }
+
+    const double lengthMs = this->tempoMap.getTimeAt(this->endTimeStamp) - this->startTimeMs;
+    this->lengthInSamples = jmax(int64(1), int64(lengthMs * samplesPerMs));
+}
+
+int PlaybackSchedule::getNumLanes() const noexcept
+{
+    return this->lanes.size();
+}
+
+const PlaybackSchedule::Lane *PlaybackSchedule::getLane(int index) const noexcept
+{
+    return this->lanes[index];
+}
+
+//===----------------------------------------------------------------------===//
+// Audio thread
+//===----------------------------------------------------------------------===//
+
+int64 PlaybackSchedule::getBlockPosition() noexcept
+{
+    const auto blockStart = this->clock.getBlockStartSample();
+
+    // all callbacks within the same device cycle get the same block start,
+    // so whoever comes first, the rest will agree upon the start position
+    this->start->clockPosition.compareAndSetBool(blockStart, -1);
+
+    return blockStart - this->start->clockPosition.get() - this->start->countInLength;
+}
+
+//===----------------------------------------------------------------------===//
+// Any thread
+//===----------------------------------------------------------------------===//
+
+bool PlaybackSchedule::hasStarted() const noexcept
+{
+    return this->start->clockPosition.get() >= 0;
+}
+
+bool PlaybackSchedule::isLooped() const noexcept
+{
+    return this->looped;
+}
+
+bool PlaybackSchedule::isStopped() const noexcept
+{
+    return this->stopped.get();
+}
+
+void PlaybackSchedule::stop() noexcept
+{
+    this->stopped = true;
+}
+
+double PlaybackSchedule::getSampleRate() const noexcept
+{
+    return this->sampleRate;
+}
+
+int64 PlaybackSchedule::getLengthInSamples() const noexcept
+{
+    return this->lengthInSamples;
+}
+
+void PlaybackSchedule::setCountInLength(int64 numSamples) noexcept
+{
+    jassert(!this->hasStarted());
+    this->start->countInLength = jmax(int64(0), numSamples);
+}
+
+int64 PlaybackSchedule::getCountInLength() const noexcept
+{
+    return this->start->countInLength;
+}
+
+int64 PlaybackSchedule::getStartSamplePosition() const noexcept
+{
+    return int64(this->startTimeMs * this->sampleRate / 1000.0);
+}
+
+int64 PlaybackSchedule::getPlaybackPosition() const noexcept
+{
+    return this->getPlaybackPositionAt(this->clock.getBlockStartSample());
+}
+
+int64 PlaybackSchedule::getPlaybackPositionAt(int64 clockPosition) const noexcept
+{
+    const auto startPosition = this->start->clockPosition.get();
+    if (startPosition < 0)
+    {
+        return -1;
+    }
+
+    const auto position = clockPosition - startPosition - this->start->countInLength;
+    if (position < 0)
+    {
+        return -1;
+    }
+
+    return this->looped ? (position % this->lengthInSamples) : position;
+}
+
+double PlaybackSchedule::getTimeStampAt(int64 samplePosition, double &outMsPerQuarter) const noexcept
+{
+    const double msFromStart = double(samplePosition) / this->sampleRate * 1000.0;
+    return this->tempoMap.getBeatAt(this->startTimeMs + msFromStart, outMsPerQuarter);
+}
+
+int64 PlaybackSchedule::getSamplePositionAt(double timeStamp) const noexcept
+{
+    const double msFromStart = this->tempoMap.getTimeAt(timeStamp) - this->startTimeMs;
+    return int64(msFromStart * this->sampleRate / 1000.0);
+}
+
+double PlaybackSchedule::getStartTimeStamp() const noexcept
+{
+    return this->startTimeStamp;
+}
+
+double PlaybackSchedule::getEndTimeStamp() const noexcept
+{
+    return this->endTimeStamp;
+}
@@ -0,0 +1,150 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "FrozenAudio.h"
+#include "TempoMap.h"
+
+class AudioClock;
+class Instrument;
+class ProjectSequences;
+
+/*
+    A pre-computed playback plan: all events of the playback cache
+    with their exact sample positions relative to the playback start,
+    grouped by instrument, so that each instrument's audio callback
+    can put them right into the block's midi buffer.
+
+    Playback starts at the block at which the first audio callback
+    touches the schedule, and from then on its position is derived
+    from the audio clock only, not from when the threads wake up.
+*/
+
+class PlaybackSchedule final : public ReferenceCountedObject
+{
+public:
+
+    struct Event final
+    {
+        int64 samplePosition;
+        MidiMessage message;
+    };
+
+    struct Lane final
+    {
+        Instrument *instrument;
+        Array<Event> events;
+
+        // if the instrument is frozen, its pre-rendered output
+        // is played instead, and the events are not processed
+        FrozenAudio::Ptr frozenAudio;
+    };
+
+    using Ptr = ReferenceCountedObjectPtr<PlaybackSchedule>;
+
+    // Timestamps here are the playback cache's timestamps (i.e. beats),
+    // and the tempo map of that cache tells their time since the project start
+    static Ptr createFrom(const ProjectSequences &sequences, const TempoMap &tempoMap,
+        const AudioClock &clock, double startTimeStamp, double endTimeStamp,
+        bool looped, const FrozenAudio::Map &frozenInstruments);
+
+    // Re-creates the schedule from the updated playback cache, keeping the same
+    // range and the same start point, so that the playback goes on seamlessly;
+    // lanes for all current instruments are kept, even if they have no events now
+    Ptr withUpdatedSequences(const ProjectSequences &sequences,
+        const TempoMap &tempoMap, const FrozenAudio::Map &frozenInstruments) const;
+
+    int getNumLanes() const noexcept;
+    const Lane *getLane(int index) const noexcept;
+
+    //===------------------------------------------------------------------===//
+    // Audio thread
+    //===------------------------------------------------------------------===//
+
+    // Returns the position of the current audio block relative to the
+    // playback start, not wrapped for loops; the first call marks the start;
+    // it's negative while counting in, i.e. before the range has started
+    int64 getBlockPosition() noexcept;
+
+    //===------------------------------------------------------------------===//
+    // Any thread
+    //===------------------------------------------------------------------===//
+
+    bool hasStarted() const noexcept;
+    bool isLooped() const noexcept;
+    bool isStopped() const noexcept;
+    void stop() noexcept;
+
+    double getSampleRate() const noexcept;
+    int64 getLengthInSamples() const noexcept;
+
+    // The delay before the range starts, during which only the metronome plays;
+    // it can only be set before the schedule is handed to the audio callbacks
+    void setCountInLength(int64 numSamples) noexcept;
+    int64 getCountInLength() const noexcept;
+
+    // The playback start's position since the project start,
+    // i.e. where to start reading frozen instruments' audio
+    int64 getStartSamplePosition() const noexcept;
+
+    // Returns the position within the (looped) playback range,
+    // or -1 if not started yet, or while still counting in
+    int64 getPlaybackPosition() const noexcept;
+    int64 getPlaybackPositionAt(int64 clockPosition) const noexcept;
+
+    // Converts the position within playback range into the cache timestamp
+    double getTimeStampAt(int64 samplePosition, double &outMsPerQuarter) const noexcept;
+
+    // And the other way round, for the timestamps within the range
+    int64 getSamplePositionAt(double timeStamp) const noexcept;
+    double getStartTimeStamp() const noexcept;
+    double getEndTimeStamp() const noexcept;
+
+private:
+
+    explicit PlaybackSchedule(const AudioClock &clock);
+
+    void build(const ProjectSequences &sequences, const Array<Instrument *> &instruments,
+        const FrozenAudio::Map &frozenInstruments);
+
+    const AudioClock &clock;
+
+    // shared between the schedule and its updated versions
+    struct StartPosition final : public ReferenceCountedObject
+    {
+        Atomic<int64> clockPosition = -1;
+        int64 countInLength = 0;
+        using Ptr = ReferenceCountedObjectPtr<StartPosition>;
+    };
+
+    OwnedArray<Lane> lanes;
+    TempoMap tempoMap;
+
+    double sampleRate = 0.0;
+    int64 lengthInSamples = 0;
+    bool looped = false;
+
+    double startTimeStamp = 0.0;
+    double endTimeStamp = 0.0;
+    double startTimeMs = 0.0;
+
+    StartPosition::Ptr start;
+    Atomic<bool> stopped = false;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PlaybackSchedule)
+};
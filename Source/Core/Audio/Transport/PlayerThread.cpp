@@ -18,38 +18,206 @@
 #include "Common.h"
 
 #include "PlayerThread.h"
+#include "PlaybackSchedule.h"
 #include "Instrument.h"
 #include "MidiSequence.h"
+#include "AudioCore.h"
 
 #define MINIMUM_STOP_CHECK_TIME_MS 1000
+#define SCHEDULED_PLAYBACK_CHECK_TIME_MS 10
 
 PlayerThread::PlayerThread(Transport &transport) :
     Thread("PlayerThread"),
-    transport(transport) {}
+    transport(transport)
+{
+    this->startThread(10);
+}
 
 PlayerThread::~PlayerThread()
 {
+    this->signalThreadShouldExit();
+    this->notify();
     this->stopThread(MINIMUM_STOP_CHECK_TIME_MS * 2);
 }
 
 //===----------------------------------------------------------------------===//
-// Thread
+// Commands
 //===----------------------------------------------------------------------===//
 
+void PlayerThread::startPlayback(bool shouldBroadcastTransportEvents, bool withCountIn)
+{
+    Command command;
+    command.play = true;
+    command.start = jlimit(0.0, 1.0, this->transport.getSeekPosition());
+    command.end = 1.0;
+    command.broadcast = shouldBroadcastTransportEvents;
+    command.countIn = withCountIn;
+    this->postCommand(command);
+}
+
 void PlayerThread::startPlayback(double start, double end,
     bool shouldLoop, bool shouldBroadcastTransportEvents)
 {
-    this->broadcastMode = shouldBroadcastTransportEvents;
-    this->loopedMode = shouldLoop;
-    this->absStartPosition = jlimit(0.0, 1.0, start);
-    this->absEndPosition = jlimit(0.0, 1.0, end);
-    this->startThread(10);
+    Command command;
+    command.play = true;
+    command.start = jlimit(0.0, 1.0, start);
+    command.end = jlimit(0.0, 1.0, end);
+    command.looped = shouldLoop;
+    command.broadcast = shouldBroadcastTransportEvents;
+    this->postCommand(command);
+}
+
+void PlayerThread::stopPlayback()
+{
+    this->postCommand({});
+}
+
+bool PlayerThread::isPlaying() const
+{
+    const int requestedPlaybackId = this->requestedPlaybackId.get();
+    return requestedPlaybackId != 0 &&
+        requestedPlaybackId != this->finishedPlaybackId.get();
+}
+
+void PlayerThread::postCommand(const Command &newCommand)
+{
+    {
+        const SpinLock::ScopedLockType lock(this->commandLock);
+        this->pendingCommand = newCommand;
+        this->pendingCommand.id = ++this->lastCommandId;
+        this->hasPendingCommand = true;
+        this->requestedPlaybackId = newCommand.play ? this->pendingCommand.id : 0;
+    }
+
+    // wakes up the thread, if it's idle or waiting for the next event
+    this->notify();
+}
+
+bool PlayerThread::shouldInterrupt() const
+{
+    return this->threadShouldExit() ||
+        this->lastCommandId.get() != this->currentCommandId;
+}
+
+bool PlayerThread::waitUntil(uint32 targetTime)
+{
+    for (;;)
+    {
+        if (this->shouldInterrupt())
+        {
+            return false;
+        }
+
+        const auto timeNow = Time::getMillisecondCounter();
+        if (timeNow >= targetTime)
+        {
+            return true;
+        }
+
+        this->wait(int(targetTime - timeNow));
+    }
+}
+
+//===----------------------------------------------------------------------===//
+// Thread
+//===----------------------------------------------------------------------===//
+
+bool PlayerThread::canUpdatePlayback() const
+{
+    const SpinLock::ScopedLockType lock(this->scheduleLock);
+    return this->schedule != nullptr && !this->shouldInterrupt();
+}
+
+// Called from the message thread, while the playback goes on
+bool PlayerThread::updatePlayback(const ProjectSequences &sequences)
+{
+    PlaybackSchedule::Ptr current;
+
+    {
+        const SpinLock::ScopedLockType lock(this->scheduleLock);
+        current = this->schedule;
+    }
+
+    if (current == nullptr || current->isStopped())
+    {
+        return false;
+    }
+
+    auto updated = current->withUpdatedSequences(sequences,
+        this->transport.getTempoMap(), this->transport.getFrozenInstruments());
+
+    for (int i = 0; i < updated->getNumLanes(); ++i)
+    {
+        auto *instrument = updated->getLane(i)->instrument;
+        instrument->getProcessorPlayer().updatePlaybackSchedule(updated, i);
+    }
+
+    this->transport.metronome.updatePlaybackSchedule(current.get(),
+        updated, this->transport.getTimeSignatures());
+    this->transport.syncOutput.updatePlaybackSchedule(current.get(), updated);
+    this->transport.audioRecorder.updatePlaybackSchedule(current.get(), updated);
+
+    {
+        const SpinLock::ScopedLockType lock(this->scheduleLock);
+        if (this->schedule != current)
+        {
+            // the playback has been stopped meanwhile,
+            // make sure the callbacks won't keep playing the update
+            updated->stop();
+            return false;
+        }
+
+        this->schedule = updated;
+    }
+
+    return true;
 }
 
 void PlayerThread::run()
+{
+    while (!this->threadShouldExit())
+    {
+        Command command;
+        bool hasCommand = false;
+
+        {
+            const SpinLock::ScopedLockType lock(this->commandLock);
+            hasCommand = this->hasPendingCommand;
+            command = this->pendingCommand;
+            this->hasPendingCommand = false;
+        }
+
+        if (!hasCommand)
+        {
+            this->wait(-1);
+            continue;
+        }
+
+        this->currentCommandId = command.id;
+
+        if (command.play)
+        {
+            this->broadcastMode = command.broadcast;
+            this->loopedMode = command.looped;
+            this->countInMode = command.countIn;
+            this->absStartPosition = command.start;
+            this->absEndPosition = command.end;
+            this->play();
+            this->transport.resetPlaybackAnchor();
+            this->finishedPlaybackId = command.id;
+        }
+    }
+}
+
+void PlayerThread::play()
 {
     auto &sequences = this->transport.getPlaybackCache();
     Array<Instrument *> uniqueInstruments(sequences.getUniqueInstruments());
+
+    for (auto *instrument : uniqueInstruments)
+    {
+        instrument->getProcessorPlayer().getSchedulingTelemetry().reset();
+    }
     
     double nextEventTimeDelta = 0.0;
     
@@ -70,20 +238,30 @@ void PlayerThread::run()
     const double startPositionInTime = this->absStartPosition * totalTime;
     const double endPositionInTime = this->absEndPosition * totalTime;
     
-    sequences.seekToTime(startPositionInTime);
+    ProjectSequences::Cursor cursor(sequences);
+    cursor.seekToTime(startPositionInTime);
     double prevTimeStamp = startPositionInTime;
     if (this->broadcastMode)
     {
         this->transport.broadcastSeek(prevTimeStamp / totalTime, currentTimeMs, totalTimeMs);
     }
 
+    // Timing by the audio clock is only possible while the device is running,
+    // otherwise fallback to the old way of waiting for each next event:
+    if (this->transport.audioClock.isRunning())
+    {
+        this->runScheduled(sequences, startPositionInTime, endPositionInTime,
+            msPerQuarter, currentTimeMs, totalTimeMs);
+        return;
+    }
+
     // This hack is here to keep track of still playing events
     // to be able to send noteOff's when playback interrupts.
     struct HoldingNote final
     {
         int key;
         int channel;
-        MidiMessageCollector *listener;
+        Instrument *instrument;
     };
     // (some plugins just don't understand allNotesOff message)
     Array<HoldingNote> holdingNotes;
@@ -95,7 +273,7 @@ void PlayerThread::run()
         {
             MidiMessage startPlayback(MidiMessage::midiStart());
             startPlayback.setTimeStamp(Time::getMillisecondCounterHiRes() * 0.001);
-            instrument->getProcessorPlayer().getMidiMessageCollector().addMessageToQueue(startPlayback);
+            instrument->getProcessorPlayer().addMessageToQueue(startPlayback);
         }
     };
 
@@ -105,7 +283,7 @@ void PlayerThread::run()
         {
             MidiMessage noteOff(MidiMessage::noteOff(holding.channel, holding.key, 0.f));
             noteOff.setTimeStamp(Time::getMillisecondCounterHiRes() * 0.001);
-            holding.listener->addMessageToQueue(noteOff);
+            holding.instrument->getProcessorPlayer().addMessageToQueue(noteOff);
         }
         
         MidiMessage stopPlayback(MidiMessage::midiStop());
@@ -113,101 +291,130 @@ void PlayerThread::run()
         
         for (auto &instrument : uniqueInstruments)
         {
-            instrument->getProcessorPlayer().getMidiMessageCollector().addMessageToQueue(stopPlayback);
+            instrument->getProcessorPlayer().addMessageToQueue(stopPlayback);
         }
-        
-        // Wait until all plugins process the messages in their queues
-        Thread::sleep(50);
+
+        // no need to wait for the plugins to process these: the queues keep
+        // the order, so they will go before the next playback's messages
     };
     
     auto sendTempoChangeToEverybody = [&uniqueInstruments](const MidiMessage &tempoEvent)
     {
         for (auto &instrument : uniqueInstruments)
         {
-            instrument->getProcessorPlayer().getMidiMessageCollector().addMessageToQueue(tempoEvent);
+            instrument->getProcessorPlayer().addMessageToQueue(tempoEvent);
+        }
+    };
+
+    // without the audio clock, the playhead is extrapolated by the system time
+    // from the moment when the last event has been sent:
+    auto updatePlaybackAnchor = [this, &prevTimeStamp, &msPerQuarter, endPositionInTime]()
+    {
+        if (this->broadcastMode)
+        {
+            this->transport.setPlaybackAnchor(Time::getMillisecondCounterHiRes(),
+                false, prevTimeStamp, msPerQuarter, endPositionInTime);
         }
     };
     
     // And here we go.
     sendMidiStart();
+    updatePlaybackAnchor();
+
+    // the system time at which the next event is supposed to be sent,
+    // as opposed to when the thread actually wakes up to send it
+    double intendedTimeMs = Time::getMillisecondCounterHiRes();
+
+    // the delays are counted from the intended time, not from the moment
+    // the thread has woken up, so that the wake-up latencies don't pile up
+    auto waitForIntendedTime = [this, &intendedTimeMs]()
+    {
+        const double delayMs = intendedTimeMs - Time::getMillisecondCounterHiRes();
+        return this->waitUntil(Time::getMillisecondCounter() + uint32(jmax(0.0, delayMs)));
+    };
+
+    // the time of each event is integrated by the tempo map, ramps included,
+    // so the tempo events themselves only matter to the instruments
+    const auto tempoMap = this->transport.getTempoMap();
+
+    // the state at the loop start, restored at each next iteration
+    const double loopStartTimeMs = currentTimeMs;
+    const double loopStartMsPerQuarter = msPerQuarter;
+    bool hasJustWrapped = false;
     
     while (1)
     {
         CachedMidiMessage wrapper;
+        const bool hasNextMessage = cursor.getNextMessage(wrapper);
 
-        // Handle playback from the last event to the end of track:
-        if (!sequences.getNextMessage(wrapper))
+        // In looped mode, the next iteration is scheduled ahead of time:
+        // as soon as the next event is beyond the loop end, the cursor rewinds,
+        // and the time left until the loop end is added to the delay before
+        // the first event of the next iteration, so there's no gap in between
+        if (this->loopedMode &&
+            (!hasNextMessage || wrapper.message.getTimeStamp() > endPositionInTime))
         {
-            nextEventTimeDelta = msPerQuarter * (endPositionInTime - prevTimeStamp);
-            const uint32 targetTime = Time::getMillisecondCounter() + uint32(nextEventTimeDelta);
+            intendedTimeMs += tempoMap.getTimeAt(endPositionInTime) - currentTimeMs;
 
-            // Give thread a chance to exit by checking at least once a, say, second
-            while (nextEventTimeDelta > MINIMUM_STOP_CHECK_TIME_MS)
+            // nothing to play within the loop, so just wait for its end
+            if (hasJustWrapped)
             {
-                nextEventTimeDelta -= MINIMUM_STOP_CHECK_TIME_MS;
-                Thread::sleep(MINIMUM_STOP_CHECK_TIME_MS);
-                if (this->threadShouldExit())
+                if (!waitForIntendedTime())
                 {
                     sendHoldingNotesOffAndMidiStop();
                     return;
                 }
-            }
 
-            Time::waitForMillisecondCounter(targetTime);
-
-            if (this->loopedMode)
-            {
-                sequences.seekToTime(startPositionInTime);
-                prevTimeStamp = startPositionInTime;
                 if (this->broadcastMode)
                 {
-                    this->transport.broadcastSeek(prevTimeStamp / totalTime, currentTimeMs, totalTimeMs);
+                    this->transport.broadcastSeek(startPositionInTime / totalTime, loopStartTimeMs, totalTimeMs);
                 }
-                continue;
             }
-            else
-            {
-                sendHoldingNotesOffAndMidiStop();
-                this->transport.allNotesControllersAndSoundOff();
 
-                if (this->broadcastMode)
-                {
-                    this->transport.seekToPosition(this->transport.getSeekPosition());
-                    this->transport.broadcastStop();
-                }
-                return;
-            }
+            cursor.seekToTime(startPositionInTime);
+            prevTimeStamp = startPositionInTime;
+            currentTimeMs = loopStartTimeMs;
+            msPerQuarter = loopStartMsPerQuarter;
+            hasJustWrapped = true;
+            continue;
         }
 
-        const bool shouldRewind =
-            (this->loopedMode &&
-            (wrapper.message.getTimeStamp() > endPositionInTime));
+        // Handle playback from the last event to the end of track:
+        if (!hasNextMessage)
+        {
+            intendedTimeMs += tempoMap.getTimeAt(endPositionInTime) - currentTimeMs;
 
-        const double nextEventTimeStamp =
-            shouldRewind ? endPositionInTime : wrapper.message.getTimeStamp();
+            if (!waitForIntendedTime())
+            {
+                sendHoldingNotesOffAndMidiStop();
+                return;
+            }
 
-        nextEventTimeDelta = msPerQuarter * (nextEventTimeStamp - prevTimeStamp);
-        currentTimeMs += nextEventTimeDelta;
-        prevTimeStamp = nextEventTimeStamp;
+            sendHoldingNotesOffAndMidiStop();
+            this->transport.allNotesControllersAndSoundOff();
 
-        // Zero-delay check (we're playing a chord or so)
-        if (uint32(nextEventTimeDelta) != 0)
-        {
-            const uint32 targetTime = Time::getMillisecondCounter() + uint32(nextEventTimeDelta);
-            while (nextEventTimeDelta > MINIMUM_STOP_CHECK_TIME_MS)
+            if (this->broadcastMode)
             {
-                nextEventTimeDelta -= MINIMUM_STOP_CHECK_TIME_MS;
-                Thread::sleep(MINIMUM_STOP_CHECK_TIME_MS);
-                if (this->threadShouldExit())
-                {
-                    sendHoldingNotesOffAndMidiStop();
-                    return;
-                }
+                this->transport.resetPlaybackAnchor();
+                this->transport.seekToPosition(this->transport.getSeekPosition());
+                this->transport.broadcastStop();
             }
+            return;
+        }
 
-            Time::waitForMillisecondCounter(targetTime);
+        const double nextEventTimeStamp = wrapper.message.getTimeStamp();
+        double nextEventTimeMs = 0.0;
+        tempoMap.getTimeAndTempoAt(nextEventTimeStamp, nextEventTimeMs, msPerQuarter);
+        nextEventTimeDelta = nextEventTimeMs - currentTimeMs;
+        currentTimeMs = nextEventTimeMs;
+        intendedTimeMs += nextEventTimeDelta;
+        prevTimeStamp = nextEventTimeStamp;
 
-            if (this->threadShouldExit())
+        // Zero-delay check (we're playing a chord or so),
+        // but the first event after the loop end has to wait for that end anyway
+        if (hasJustWrapped || nextEventTimeDelta > 0.0)
+        {
+            if (!waitForIntendedTime())
             {
                 sendHoldingNotesOffAndMidiStop();
                 return;
@@ -217,61 +424,168 @@ void PlayerThread::run()
             {
                 this->transport.broadcastSeek(prevTimeStamp / totalTime, currentTimeMs, totalTimeMs);
             }
+
+            updatePlaybackAnchor();
         }
+
+        hasJustWrapped = false;
+        
+        const int key = wrapper.message.getNoteNumber();
+        const int channel = wrapper.message.getChannel();
+        wrapper.message.setTimeStamp(Time::getMillisecondCounterHiRes() * 0.001);
         
-        if (shouldRewind)
+        // Master tempo event is sent to everybody
+        if (wrapper.message.isTempoMetaEvent())
         {
-            sequences.seekToTime(startPositionInTime);
-            prevTimeStamp = startPositionInTime;
             if (this->broadcastMode)
             {
-                this->transport.broadcastSeek(prevTimeStamp / totalTime, currentTimeMs, totalTimeMs);
+                this->transport.broadcastTempoChanged(msPerQuarter);
             }
+
+            updatePlaybackAnchor();
+
+            // Sends this to everybody (need to do that for drum-machines) - TODO test
+            sendTempoChangeToEverybody(wrapper.message);
         }
         else
         {
-            const int key = wrapper.message.getNoteNumber();
-            const int channel = wrapper.message.getChannel();
-            wrapper.message.setTimeStamp(Time::getMillisecondCounterHiRes() * 0.001);
-            
-            // Master tempo event is sent to everybody
-            if (wrapper.message.isTempoMetaEvent())
+            auto &player = wrapper.instrument->getProcessorPlayer();
+            player.getSchedulingTelemetry().addEvent(wrapper.message.getTimeStamp() * 1000.0 - intendedTimeMs);
+            player.addMessageToQueue(wrapper.message);
+        }
+        
+        if (wrapper.message.isNoteOn())
+        {
+            holdingNotes.add({ key, channel, wrapper.instrument });
+        }
+        
+        if (wrapper.message.isNoteOff())
+        {
+            for (int i = 0; i < holdingNotes.size(); ++i)
             {
-                msPerQuarter = wrapper.message.getTempoSecondsPerQuarterNote() * 1000.f;
-
-                if (this->broadcastMode)
+                if (holdingNotes[i].key == key &&
+                    holdingNotes[i].channel == channel &&
+                    holdingNotes[i].instrument == wrapper.instrument)
                 {
-                    this->transport.broadcastTempoChanged(msPerQuarter);
+                    holdingNotes.remove(i);
+                    break;
                 }
-
-                // Sends this to everybody (need to do that for drum-machines) - TODO test
-                sendTempoChangeToEverybody(wrapper.message);
             }
-            else
+        }
+    }
+    
+    jassertfalse;
+}
+
+void PlayerThread::runScheduled(ProjectSequences &sequences,
+    double startPositionInTime, double endPositionInTime,
+    double msPerQuarter, double startTimeMs, double totalTimeMs)
+{
+    const double totalTime = this->transport.getTotalTime();
+
+    auto newSchedule = PlaybackSchedule::createFrom(sequences,
+        this->transport.getTempoMap(), this->transport.audioClock,
+        startPositionInTime, endPositionInTime, this->loopedMode,
+        this->transport.getFrozenInstruments());
+
+    auto &metronome = this->transport.metronome;
+    auto &syncOutput = this->transport.syncOutput;
+    auto &audioRecorder = this->transport.audioRecorder;
+    const auto timeSignatures = this->transport.getTimeSignatures();
+    if (this->countInMode)
+    {
+        newSchedule->setCountInLength(metronome.getCountInLength(*newSchedule, timeSignatures));
+    }
+
+    for (int i = 0; i < newSchedule->getNumLanes(); ++i)
+    {
+        auto *instrument = newSchedule->getLane(i)->instrument;
+        instrument->getProcessorPlayer().setPlaybackSchedule(newSchedule, i);
+    }
+
+    metronome.setPlaybackSchedule(newSchedule, timeSignatures);
+    syncOutput.setPlaybackSchedule(newSchedule);
+    audioRecorder.setPlaybackSchedule(newSchedule);
+
+    {
+        const SpinLock::ScopedLockType lock(this->scheduleLock);
+        this->schedule = newSchedule;
+    }
+
+    double lastMsPerQuarter = msPerQuarter;
+
+    while (!this->shouldInterrupt())
+    {
+        this->wait(SCHEDULED_PLAYBACK_CHECK_TIME_MS);
+
+        PlaybackSchedule::Ptr schedule;
+
+        {
+            const SpinLock::ScopedLockType lock(this->scheduleLock);
+            schedule = this->schedule;
+        }
+
+        const auto clockPosition = this->transport.audioClock.getBlockStartSample();
+        const auto position = schedule->getPlaybackPositionAt(clockPosition);
+        if (position < 0)
+        {
+            continue; // audio callbacks haven't picked it up yet
+        }
+
+        if (!this->loopedMode && position >= schedule->getLengthInSamples())
+        {
             {
-                wrapper.listener->addMessageToQueue(wrapper.message);
+                const SpinLock::ScopedLockType lock(this->scheduleLock);
+                this->schedule->stop();
+                this->schedule = nullptr;
             }
-            
-            if (wrapper.message.isNoteOn())
+
+            // at this point all callbacks have already released their holding notes
+            this->transport.allNotesControllersAndSoundOff();
+            metronome.setPlaybackSchedule(nullptr, {});
+            syncOutput.setPlaybackSchedule(nullptr);
+            audioRecorder.setPlaybackSchedule(nullptr);
+
+            if (this->broadcastMode)
             {
-                holdingNotes.add({ key, channel, wrapper.listener });
+                this->transport.resetPlaybackAnchor();
+                this->transport.seekToPosition(this->transport.getSeekPosition());
+                this->transport.broadcastStop();
             }
-            
-            if (wrapper.message.isNoteOff())
+
+            return;
+        }
+
+        if (this->broadcastMode)
+        {
+            double currentMsPerQuarter = lastMsPerQuarter;
+            const double timeStamp = schedule->getTimeStampAt(position, currentMsPerQuarter);
+            const double currentTimeMs = startTimeMs + double(position) / schedule->getSampleRate() * 1000.0;
+
+            if (currentMsPerQuarter != lastMsPerQuarter)
             {
-                for (int i = 0; i < holdingNotes.size(); ++i)
-                {
-                    if (holdingNotes[i].key == key &&
-                        holdingNotes[i].channel == channel &&
-                        holdingNotes[i].listener == wrapper.listener)
-                    {
-                        holdingNotes.remove(i);
-                        break;
-                    }
-                }
+                lastMsPerQuarter = currentMsPerQuarter;
+                this->transport.broadcastTempoChanged(currentMsPerQuarter);
             }
+
+            // the exact position at this clock position, which the playhead
+            // extrapolates from by the samples processed until it's redrawn
+            this->transport.setPlaybackAnchor(double(clockPosition), true,
+                timeStamp, currentMsPerQuarter, endPositionInTime);
+
+            // still needed for the time indicators and such
+            this->transport.broadcastSeek(timeStamp / totalTime, currentTimeMs, totalTimeMs);
         }
     }
-    
-    jassertfalse;
+
+    // callbacks will send noteOff's for holding notes in their next blocks
+    {
+        const SpinLock::ScopedLockType lock(this->scheduleLock);
+        this->schedule->stop();
+        this->schedule = nullptr;
+    }
+
+    metronome.setPlaybackSchedule(nullptr, {});
+    syncOutput.setPlaybackSchedule(nullptr);
+    audioRecorder.setPlaybackSchedule(nullptr);
 }
@@ -19,6 +19,15 @@
 
 #include "Transport.h"
 
+/*
+    A single long-lived scheduler thread: instead of starting a new thread
+    on each playback start, it takes commands from the message thread,
+    which only post them and wake it up, so that starting and stopping
+    never waits for a thread to be created or to exit. The latest command
+    wins, e.g. seeking or changing the loop range while playing is simply
+    the next start command, interrupting the current playback.
+*/
+
 class PlayerThread final : public Thread
 {
 public:
@@ -26,20 +35,71 @@ public:
     explicit PlayerThread(Transport &transport);
     ~PlayerThread() override;
 
+    // Starts from the transport's seek position to the end,
+    // optionally after the metronome's count-in
+    void startPlayback(bool shouldBroadcastTransportEvents = true, bool withCountIn = false);
     void startPlayback(double start, double end, bool shouldLoop,
         bool shouldBroadcastTransportEvents = true);
 
+    void stopPlayback();
+    bool isPlaying() const;
+
+    // Only available in the sample-accurate mode, when the schedule is ready:
+    bool canUpdatePlayback() const;
+    bool updatePlayback(const ProjectSequences &sequences);
+
 private:
 
     void run() override;
+    void play();
+
+    struct Command final
+    {
+        bool play = false;
+        double start = 0.0;
+        double end = 1.0;
+        bool looped = false;
+        bool broadcast = true;
+        bool countIn = false;
+        int id = 0;
+    };
+
+    void postCommand(const Command &command);
+
+    // true if the thread is exiting or a new command has arrived
+    bool shouldInterrupt() const;
+
+    // returns false, if interrupted
+    bool waitUntil(uint32 targetTime);
+
+    // Sample-accurate mode: the events are rendered by instruments' audio callbacks,
+    // and this thread only watches the playback position to notify the listeners
+    void runScheduled(ProjectSequences &sequences,
+        double startPositionInTime, double endPositionInTime,
+        double msPerQuarter, double startTimeMs, double totalTimeMs);
 
     Transport &transport;
 
     bool broadcastMode = false;
     bool loopedMode = false;
+    bool countInMode = false;
 
     double absStartPosition = 0.0;
     double absEndPosition = 1.0;
 
+    SpinLock scheduleLock;
+    PlaybackSchedule::Ptr schedule;
+
+    SpinLock commandLock;
+    Command pendingCommand;
+    bool hasPendingCommand = false;
+
+    Atomic<int> lastCommandId = 0;
+    Atomic<int> requestedPlaybackId = 0;
+    Atomic<int> finishedPlaybackId = 0;
+
+    // only accessed by the thread itself
+    int currentCommandId = 0;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PlayerThread)
 };
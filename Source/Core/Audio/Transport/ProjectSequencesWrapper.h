@@ -23,12 +23,74 @@ class MidiSequence;
 
 struct CachedMidiSequence final : public ReferenceCountedObject
 {
+    // The messages of the track's sequence, exported once without
+    // any clip transform, since all clips of a track share the sequence;
+    // the clip instances are applied on the fly by whoever reads them,
+    // so the cache takes as much memory as the unique content does,
+    // and moving or muting a clip only needs to update the instances
     MidiMessageSequence midiMessages;
-    int currentIndex;
+
+    struct ClipInstance final
+    {
+        double timeOffset;
+        int keyOffset;
+        float velocityMultiplier;
+    };
+
+    Array<ClipInstance> clips;
+
     MidiMessageCollector *listener;
     Instrument *instrument;
     const MidiSequence *track;
 
+    inline double getTimeStamp(int index, int clipIndex) const noexcept
+    {
+        return this->midiMessages.getEventPointer(index)->message.getTimeStamp() +
+            this->clips.getReference(clipIndex).timeOffset;
+    }
+
+    MidiMessage getMessage(int index, int clipIndex) const noexcept
+    {
+        const auto &clip = this->clips.getReference(clipIndex);
+        MidiMessage message(this->midiMessages.getEventPointer(index)->message);
+        message.addToTimeStamp(clip.timeOffset);
+
+        if (message.isNoteOnOrOff())
+        {
+            message.setNoteNumber(message.getNoteNumber() + clip.keyOffset);
+            message.multiplyVelocity(clip.velocityMultiplier);
+        }
+
+        return message;
+    }
+
+    // Calls back with the note-on index of each note sounding at the given
+    // time, relative to the clip; used on the message thread for probing
+    // the sound at some position, e.g. while scrubbing the playhead
+    template <typename Callback>
+    void findNotesSoundingAt(double localTime, const Callback &callback)
+    {
+        if (!this->hasNoteIntervals)
+        {
+            this->buildNoteIntervals();
+        }
+
+        // the last note started at or before that time
+        auto i = int(std::upper_bound(this->noteIntervals.begin(), this->noteIntervals.end(), localTime,
+            [](double t, const NoteInterval &interval) { return t < interval.start; }) -
+            this->noteIntervals.begin()) - 1;
+
+        // and back from it, while any of the notes up to it can still be sounding
+        for (; i >= 0 && this->noteIntervals.getReference(i).maxEnd > localTime; --i)
+        {
+            const auto &interval = this->noteIntervals.getReference(i);
+            if (interval.end > localTime)
+            {
+                callback(interval.noteOnIndex);
+            }
+        }
+    }
+
     using Ptr = ReferenceCountedObjectPtr<CachedMidiSequence>;
 
     static Ptr createFrom(Instrument *instrument, const MidiSequence *track = nullptr)
@@ -36,11 +98,45 @@ struct CachedMidiSequence final : public ReferenceCountedObject
         jassert(instrument != nullptr);
         CachedMidiSequence::Ptr wrapper(new CachedMidiSequence());
         wrapper->track = track;
-        wrapper->currentIndex = 0;
         wrapper->instrument = instrument;
         wrapper->listener = &instrument->getProcessorPlayer().getMidiMessageCollector();
         return wrapper;
     }
+
+private:
+
+    // The notes sorted by start, each with the maximum end of all notes
+    // up to it, which never decreases, so the search can stop early;
+    // the messages never change once exported, so it's built only once
+    struct NoteInterval final
+    {
+        double start;
+        double end;
+        double maxEnd;
+        int noteOnIndex;
+    };
+
+    Array<NoteInterval> noteIntervals;
+    bool hasNoteIntervals = false;
+
+    void buildNoteIntervals()
+    {
+        this->noteIntervals.clearQuick();
+
+        double maxEnd = -DBL_MAX;
+        for (int i = 0; i < this->midiMessages.getNumEvents(); ++i)
+        {
+            const auto *event = this->midiMessages.getEventPointer(i);
+            if (event->message.isNoteOn() && event->noteOffObject != nullptr)
+            {
+                const double end = event->noteOffObject->message.getTimeStamp();
+                maxEnd = jmax(maxEnd, end);
+                this->noteIntervals.add({ event->message.getTimeStamp(), end, maxEnd, i });
+            }
+        }
+
+        this->hasNoteIntervals = true;
+    }
 };
 
 struct CachedMidiMessage final : public ReferenceCountedObject
@@ -59,8 +155,135 @@ private:
     ReferenceCountedArray<CachedMidiSequence> sequences;
 
 public:
-    
-    ProjectSequences() = default;
+
+    /*
+        A k-way merge over all clip instances of all cached sequences:
+        keeps a min-heap of their heads, so that getting each next message
+        costs O(log k), not O(k), where k is the number of clips.
+
+        Each reader is supposed to have its own cursor, which only reads
+        the sequences, so no locking is needed, as long as the cache
+        is not modified while reading (and it is only rebuilt when stopped);
+        the cursor needs to be re-seeked after the cache has changed.
+    */
+    class Cursor final
+    {
+    public:
+
+        explicit Cursor(const ProjectSequences &sequences) noexcept :
+            sequences(sequences.sequences) {}
+
+        void seekToTime(double position)
+        {
+            this->reset();
+            for (int i = 0; i < this->streams.size(); ++i)
+            {
+                const auto &stream = this->streams.getReference(i);
+                const auto *wrapper = this->sequences.getObjectPointerUnchecked(stream.sequenceIndex);
+                const double localPosition = position - wrapper->clips.getReference(stream.clipIndex).timeOffset;
+                this->indices.add(ProjectSequences::getNextIndexAtTime(wrapper->midiMessages, (localPosition - DBL_MIN)));
+                this->pushHeadOf(i);
+            }
+        }
+
+        void seekToStart()
+        {
+            this->reset();
+            for (int i = 0; i < this->streams.size(); ++i)
+            {
+                this->indices.add(0);
+                this->pushHeadOf(i);
+            }
+        }
+
+        bool getNextMessage(CachedMidiMessage &target)
+        {
+            if (this->heap.isEmpty())
+            {
+                return false;
+            }
+
+            std::pop_heap(this->heap.begin(), this->heap.end(), Cursor::isLater);
+            const int streamIndex = this->heap.getLast().streamIndex;
+            this->heap.removeLast();
+
+            const auto &stream = this->streams.getReference(streamIndex);
+            const auto *wrapper = this->sequences.getObjectPointerUnchecked(stream.sequenceIndex);
+            auto &index = this->indices.getReference(streamIndex);
+
+            target.message = wrapper->getMessage(index, stream.clipIndex);
+            target.listener = wrapper->listener;
+            target.instrument = wrapper->instrument;
+
+            index++;
+            this->pushHeadOf(streamIndex);
+            return true;
+        }
+
+    private:
+
+        // one per clip instance of each sequence
+        struct Stream final
+        {
+            int sequenceIndex;
+            int clipIndex;
+        };
+
+        struct Head final
+        {
+            double timeStamp;
+            int streamIndex;
+        };
+
+        // the heap comparator: earlier events go first, and for the same
+        // timestamps, the earlier added sequence and the earlier clip go first,
+        // which is the order the messages were added in, when exporting clips
+        static bool isLater(const Head &a, const Head &b) noexcept
+        {
+            return (a.timeStamp > b.timeStamp) ||
+                (a.timeStamp == b.timeStamp && a.streamIndex > b.streamIndex);
+        }
+
+        void reset()
+        {
+            this->streams.clearQuick();
+            for (int i = 0; i < this->sequences.size(); ++i)
+            {
+                const auto *wrapper = this->sequences.getObjectPointerUnchecked(i);
+                for (int j = 0; j < wrapper->clips.size(); ++j)
+                {
+                    this->streams.add({ i, j });
+                }
+            }
+
+            this->indices.clearQuick();
+            this->heap.clearQuick();
+            this->heap.ensureStorageAllocated(this->streams.size());
+        }
+
+        void pushHeadOf(int streamIndex)
+        {
+            const auto &stream = this->streams.getReference(streamIndex);
+            const auto *wrapper = this->sequences.getObjectPointerUnchecked(stream.sequenceIndex);
+            const int index = this->indices.getUnchecked(streamIndex);
+            if (index < wrapper->midiMessages.getNumEvents())
+            {
+                const double timeStamp = wrapper->getTimeStamp(index, stream.clipIndex);
+                this->heap.add({ timeStamp, streamIndex });
+                std::push_heap(this->heap.begin(), this->heap.end(), Cursor::isLater);
+            }
+        }
+
+        const ReferenceCountedArray<CachedMidiSequence> &sequences;
+
+        Array<Stream> streams;
+        Array<int> indices;
+        Array<Head> heap;
+
+        JUCE_DECLARE_NON_COPYABLE(Cursor)
+    };
+
+    ProjectSequences() : defaultCursor(*this) {}
     
     inline Array<Instrument *> getUniqueInstruments() const noexcept
     {
@@ -71,18 +294,65 @@ public:
     void addWrapper(CachedMidiSequence::Ptr newWrapper) noexcept
     {
         const SpinLock::ScopedLockType lock(this->sequencesLock);
-        if (newWrapper->midiMessages.getNumEvents() > 0)
+        if (newWrapper->midiMessages.getNumEvents() > 0 &&
+            newWrapper->clips.size() > 0)
         {
             this->uniqueInstruments.addIfNotAlreadyThere(newWrapper->instrument);
             this->sequences.add(newWrapper);
         }
     }
     
+    // Used for partial updates, when only some tracks have changed
+    void removeAllFor(const MidiSequence *track) noexcept
+    {
+        const SpinLock::ScopedLockType lock(this->sequencesLock);
+
+        for (int i = this->sequences.size(); --i >= 0;)
+        {
+            if (this->sequences.getObjectPointerUnchecked(i)->track == track)
+            {
+                this->sequences.remove(i);
+            }
+        }
+
+        this->uniqueInstruments.clearQuick();
+        for (const auto *wrapper : this->sequences)
+        {
+            this->uniqueInstruments.addIfNotAlreadyThere(wrapper->instrument);
+        }
+    }
+
+    // Used when only the clips of a track have changed, but not its sequence;
+    // returns false if there's nothing to update, so the track has to be re-exported
+    bool updateClipsFor(const MidiSequence *track,
+        const Array<CachedMidiSequence::ClipInstance> &clips) noexcept
+    {
+        const SpinLock::ScopedLockType lock(this->sequencesLock);
+
+        for (int i = 0; i < this->sequences.size(); ++i)
+        {
+            auto *wrapper = this->sequences.getObjectPointerUnchecked(i);
+            if (wrapper->track == track)
+            {
+                if (clips.isEmpty())
+                {
+                    return false;
+                }
+
+                wrapper->clips = clips;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
     inline void clear()
     {
         const SpinLock::ScopedLockType lock(this->sequencesLock);
         this->uniqueInstruments.clearQuick();
         this->sequences.clearQuick();
+        this->defaultCursor.seekToStart();
     }
     
     inline bool isEmpty() const
@@ -130,7 +400,7 @@ public:
         return this->sequences[0]->instrument->getProcessorGraph()->getTotalNumInputChannels();
     }
 
-    ReferenceCountedArray<CachedMidiSequence> getAllFor(const MidiSequence *midiTrack)
+    ReferenceCountedArray<CachedMidiSequence> getAllFor(const MidiSequence *midiTrack) const
     {
         const SpinLock::ScopedLockType lock(this->sequencesLock);
 
@@ -147,81 +417,61 @@ public:
         return result;
     }
 
-    void seekToTime(double position)
+    // for the memory report: each cached message is a separate heap object
+    void getCachedMessagesUsage(int &numMessages, int64 &numBytes) const
     {
         const SpinLock::ScopedLockType lock(this->sequencesLock);
-        
-        for (auto *wrapper : this->sequences)
+
+        for (const auto *wrapper : this->sequences)
         {
-            wrapper->currentIndex = this->getNextIndexAtTime(wrapper->midiMessages, (position - DBL_MIN));
+            const auto numEvents = wrapper->midiMessages.getNumEvents();
+            numMessages += numEvents;
+            numBytes += int64(numEvents) *
+                (sizeof(MidiMessageSequence::MidiEventHolder) + sizeof(void *)) +
+                int64(wrapper->clips.size()) * sizeof(CachedMidiSequence::ClipInstance);
         }
     }
+
+    //===------------------------------------------------------------------===//
+    // The shared cursor, used by the transport on the message thread;
+    // playback and rendering threads have their own cursors instead
+    //===------------------------------------------------------------------===//
+
+    void seekToTime(double position)
+    {
+        const SpinLock::ScopedLockType lock(this->sequencesLock);
+        this->defaultCursor.seekToTime(position);
+    }
     
     void seekToZeroIndexes()
     {
         const SpinLock::ScopedLockType lock(this->sequencesLock);
-
-        for (auto *wrapper : this->sequences)
-        {
-            wrapper->currentIndex = 0;
-        }
+        this->defaultCursor.seekToStart();
     }
     
     bool getNextMessage(CachedMidiMessage &target)
     {
         const SpinLock::ScopedLockType lock(this->sequencesLock);
-
-        double minTimeStamp = DBL_MAX;
-        int targetSequenceIndex = -1;
-
-        for (int i = 0; i < this->sequences.size(); ++i)
-        {
-            const auto *wrapper = this->sequences.getObjectPointer(i);
-            if (wrapper->currentIndex < wrapper->midiMessages.getNumEvents())
-            {
-                const auto &message = wrapper->midiMessages.getEventPointer(wrapper->currentIndex)->message;
-
-                if (message.getTimeStamp() < minTimeStamp)
-                {
-                    minTimeStamp = message.getTimeStamp();
-                    targetSequenceIndex = i;
-                }
-            }
-        }
-
-        if (targetSequenceIndex < 0)
-        {
-            return false;
-        }
-
-        auto *foundWrapper = this->sequences.getObjectPointer(targetSequenceIndex);
-        auto &foundMessage = foundWrapper->midiMessages.getEventPointer(foundWrapper->currentIndex)->message;
-        foundWrapper->currentIndex++;
-
-        target.message = foundMessage;
-        target.listener = foundWrapper->listener;
-        target.instrument = foundWrapper->instrument;
-
-        return true;
+        return this->defaultCursor.getNextMessage(target);
     }
     
 private:
     
-    int getNextIndexAtTime(const MidiMessageSequence &sequence, double timeStamp) const
+    // the sequences are always sorted by time, so this is a binary search
+    static int getNextIndexAtTime(const MidiMessageSequence &sequence, double timeStamp)
     {
-        int i = 0;
-        for (; i < sequence.getNumEvents(); ++i)
-        {
-            const double eventTs = sequence.getEventPointer(i)->message.getTimeStamp();
-            if (eventTs >= timeStamp)
+        const auto *first = sequence.begin();
+        const auto *found = std::lower_bound(first, sequence.end(), timeStamp,
+            [](const MidiMessageSequence::MidiEventHolder *event, double t)
             {
-                break;
-            }
-        }
-        
-        return i;
+                return event->message.getTimeStamp() < t;
+            });
+
+        return int(found - first);
     }
 
+    Cursor defaultCursor;
+
     SpinLock instrumentsLock;
     SpinLock sequencesLock;
 
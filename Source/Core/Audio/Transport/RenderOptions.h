@@ -0,0 +1,48 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+class Instrument;
+
+struct RenderOptions final
+{
+    // larger blocks mean less overhead per block, which adds up on long projects
+    int blockSize = 512;
+
+    // 16, 24, or 32 for floating point (the latter is only supported by wav)
+    int bitDepth = 16;
+
+    // processor graphs are rendered in double precision, if they support it
+    bool useDoublePrecision = false;
+
+    // each instrument is also written to its own file, next to the mix
+    bool renderStems = false;
+
+    // the metronome clicks are mixed in, but not into the stems
+    bool renderMetronome = false;
+
+    // the absolute positions of the range to render, as in startPlaybackFragment,
+    // and the number of beats to render before it without writing, to warm up
+    double startPosition = 0.0;
+    double endPosition = 1.0;
+    double preRollBeats = 0.0;
+
+    // if set, only this instrument is rendered, the stems are ignored
+    // (used for freezing instruments, see Transport::freezeInstrument)
+    Instrument *soloInstrument = nullptr;
+};
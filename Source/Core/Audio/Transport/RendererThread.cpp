@@ -21,12 +21,16 @@
 #include "SerializationKeys.h"
 #include "Workspace.h"
 #include "AudioCore.h"
+#include "AsyncAudioWriter.h"
+#include "MixdownKernel.h"
+
+// The progress counter doesn't need to be updated after each block
+#define RENDER_PROGRESS_UPDATE_INTERVAL_BLOCKS 8
 
 RendererThread::RendererThread(Transport &parentTrasport) :
     Thread("RendererThread"),
     transport(parentTrasport),
-    writer(nullptr),
-    percentsDone(0.f) {}
+    writer(nullptr) {}
 
 RendererThread::~RendererThread()
 {
@@ -35,11 +39,80 @@ RendererThread::~RendererThread()
 
 float RendererThread::getPercentsComplete() const
 {
-    const ScopedReadLock lock(this->percentsLock);
-    return this->percentsDone;
+    const auto done = this->framesDone.load(std::memory_order_relaxed);
+    const auto total = this->framesTotal.load(std::memory_order_relaxed);
+    return total > 0 ? float(jlimit(0.0, 1.0, double(done) / double(total))) : 0.f;
+}
+
+double RendererThread::getRealtimeRatio() const
+{
+    const auto startTimeMs = this->renderStartTimeMs.load(std::memory_order_relaxed);
+    const auto sampleRate = this->renderSampleRate.load(std::memory_order_relaxed);
+    const auto elapsedMs = Time::getMillisecondCounterHiRes() - startTimeMs;
+    if (startTimeMs <= 0.0 || sampleRate <= 0.0 || elapsedMs <= 0.0)
+    {
+        return 0.0;
+    }
+
+    const auto done = this->framesDone.load(std::memory_order_relaxed);
+    return (double(done) / sampleRate * 1000.0) / elapsedMs;
+}
+
+double RendererThread::getEstimatedTimeLeftMs() const
+{
+    const auto ratio = this->getRealtimeRatio();
+    if (ratio <= 0.0)
+    {
+        return 0.0;
+    }
+
+    const auto sampleRate = this->renderSampleRate.load(std::memory_order_relaxed);
+    const auto framesLeft = jmax(int64(0), this->framesTotal.load(std::memory_order_relaxed) -
+        this->framesDone.load(std::memory_order_relaxed));
+
+    return double(framesLeft) / sampleRate * 1000.0 / ratio;
 }
 
-void RendererThread::startRecording(const File &file)
+// 16 bits per sample should be enough for anybody :)
+// ..wanna fight about it? https://people.xiph.org/~xiphmont/demo/neil-young.html
+// (but 24 and 32-bit float are also here, if you insist)
+static AudioFormatWriter *createWriterFor(const File &file,
+    double sampleRate, int numChannels, int preferredBitDepth)
+{
+    // Create an OutputStream to write to our destination file...
+    file.deleteFile();
+    UniquePointer<FileOutputStream> fileStream(file.createOutputStream());
+
+    if (fileStream == nullptr)
+    {
+        return nullptr;
+    }
+
+    UniquePointer<AudioFormat> format;
+    if (file.getFileExtension().endsWithIgnoreCase("wav"))
+    {
+        format = makeUnique<WavAudioFormat>();
+    }
+    else if (file.getFileExtension().endsWithIgnoreCase("flac"))
+    {
+        format = makeUnique<FlacAudioFormat>();
+    }
+    else
+    {
+        return nullptr;
+    }
+
+    const int bitDepth = format->getPossibleBitDepths().contains(preferredBitDepth) ? preferredBitDepth : 16;
+    auto *writer = format->createWriterFor(fileStream.get(), sampleRate, numChannels, bitDepth, {}, 0);
+    if (writer != nullptr)
+    {
+        fileStream.release(); // now owned by the writer
+    }
+
+    return writer;
+}
+
+void RendererThread::startRecording(const File &file, const RenderOptions &renderOptions)
 {
     this->transport.recacheIfNeeded();
     const auto &sequencesCache = this->transport.getPlaybackCache();
@@ -54,40 +127,50 @@ void RendererThread::startRecording(const File &file)
     double sampleRate = sequencesCache.getSampleRate();
     int numChannels = sequencesCache.getNumOutputChannels();
 
-    // Create an OutputStream to write to our destination file...
-    file.deleteFile();
-    UniquePointer<FileOutputStream> fileStream(file.createOutputStream());
+    this->options = renderOptions;
+    this->options.blockSize = jlimit(64, 8192, renderOptions.blockSize);
 
-    if (fileStream != nullptr)
+    auto *formatWriter = createWriterFor(file, sampleRate, numChannels, this->options.bitDepth);
+    if (formatWriter == nullptr)
     {
-        {
-            const ScopedWriteLock pl(this->percentsLock);
-            this->percentsDone = 0.f;
-        }
-        
-        // 16 bits per sample should be enough for anybody :)
-        // ..wanna fight about it? https://people.xiph.org/~xiphmont/demo/neil-young.html
-        const int bitDepth = 16;
+        return;
+    }
 
-        if (file.getFileExtension().endsWithIgnoreCase("wav"))
-        {
-            WavAudioFormat wavFormat;
-            const ScopedLock sl(this->writerLock);
-            this->writer.reset(wavFormat.createWriterFor(fileStream.release(), sampleRate, numChannels, bitDepth, {}, 0));
-        }
-        else if (file.getFileExtension().endsWithIgnoreCase("flac"))
-        {
-            FlacAudioFormat flacFormat;
-            const ScopedLock sl(this->writerLock);
-            this->writer.reset(flacFormat.createWriterFor(fileStream.release(), sampleRate, numChannels, bitDepth, {}, 0));
-        }
+    this->framesDone.store(0, std::memory_order_relaxed);
+    this->framesTotal.store(0, std::memory_order_relaxed);
+    this->renderStartTimeMs.store(0.0, std::memory_order_relaxed);
+
+    const ScopedLock sl(this->writerLock);
+
+    this->writer = makeUnique<AsyncAudioWriter>(formatWriter, this->options.blockSize);
+    this->failed = false;
 
-        if (writer != nullptr)
+    // the stems are rendered along with the master mix, in the same pass,
+    // each to its own file next to the mix, named after the instrument
+    if (this->options.renderStems && this->options.soloInstrument == nullptr)
+    {
+        for (auto *instrument : sequencesCache.getUniqueInstruments())
         {
-            DBG(file.getFullPathName());
-            this->startThread(9);
+            const auto stemName = File::createLegalFileName(file.getFileNameWithoutExtension() +
+                " - " + instrument->getName()) + file.getFileExtension();
+
+            const auto stemFile = file.getSiblingFile(stemName);
+            auto *stemWriter = createWriterFor(stemFile, sampleRate, numChannels, this->options.bitDepth);
+            if (stemWriter == nullptr)
+            {
+                this->stemWriters.clear();
+                this->stemInstruments.clearQuick();
+                this->writer = nullptr;
+                return;
+            }
+
+            this->stemInstruments.add(instrument);
+            this->stemWriters.add(new AsyncAudioWriter(stemWriter, this->options.blockSize));
         }
     }
+
+    DBG(file.getFullPathName());
+    this->startThread(9);
 }
 
 void RendererThread::stop()
@@ -100,9 +183,16 @@ void RendererThread::stop()
     {
         const ScopedLock sl(this->writerLock);
         this->writer = nullptr;
+        this->stemWriters.clear();
+        this->stemInstruments.clearQuick();
     }
 }
 
+bool RendererThread::hasFailed() const noexcept
+{
+    return this->failed.get();
+}
+
 bool RendererThread::isRecording() const
 {
     //return (this->writer != nullptr) && this->isThreadRunning();
@@ -116,79 +206,405 @@ bool RendererThread::isRecording() const
 struct RenderBuffer final
 {
     Instrument *instrument;
+    AsyncAudioWriter *stemWriter = nullptr;
     AudioSampleBuffer sampleBuffer;
+    AudioBuffer<double> sampleBufferDouble;
     MidiBuffer midiBuffer;
+
+    struct Send final
+    {
+        RenderBuffer *bus;
+        float level;
+    };
+
+    Array<Send> sends;
+
+    bool usesDoublePrecision() const
+    {
+        return this->instrument->getProcessorGraph()->isUsingDoublePrecision();
+    }
+
+    // the effect bus graphs get the sum of the sends as their input,
+    // in whichever precision each of the graphs is processing
+    void addSendFrom(const RenderBuffer &source, float level)
+    {
+        const bool isDouble = this->usesDoublePrecision();
+        const bool isSourceDouble = source.usesDoublePrecision();
+        const int numChannels = this->sampleBuffer.getNumChannels();
+        const int numSamples = this->sampleBuffer.getNumSamples();
+
+        for (int i = 0; i < numChannels; ++i)
+        {
+            if (isDouble && isSourceDouble)
+            {
+                this->sampleBufferDouble.addFrom(i, 0, source.sampleBufferDouble, i, 0, numSamples, double(level));
+            }
+            else if (!isDouble && !isSourceDouble)
+            {
+                this->sampleBuffer.addFrom(i, 0, source.sampleBuffer, i, 0, numSamples, level);
+            }
+            else if (isDouble)
+            {
+                auto *destination = this->sampleBufferDouble.getWritePointer(i);
+                const auto *input = source.sampleBuffer.getReadPointer(i);
+                for (int k = 0; k < numSamples; ++k)
+                {
+                    destination[k] += double(input[k]) * level;
+                }
+            }
+            else
+            {
+                auto *destination = this->sampleBuffer.getWritePointer(i);
+                const auto *input = source.sampleBufferDouble.getReadPointer(i);
+                for (int k = 0; k < numSamples; ++k)
+                {
+                    destination[k] += float(input[k] * level);
+                }
+            }
+        }
+    }
+
+    void process()
+    {
+        // also called on the worker threads
+        const ScopedNoDenormals noDenormals;
+        AudioProcessorGraph *graph = this->instrument->getProcessorGraph();
+        const ScopedLock lock(graph->getCallbackLock());
+
+        if (graph->isUsingDoublePrecision())
+        {
+            graph->processBlock(this->sampleBufferDouble, this->midiBuffer);
+        }
+        else
+        {
+            graph->processBlock(this->sampleBuffer, this->midiBuffer);
+        }
+
+        this->midiBuffer.clear();
+    }
 };
 
+// The processor graphs rebuild their rendering sequences asynchronously
+// after prepareToPlay is called from a non-message thread; since the message
+// queue is ordered, once a message posted after that has been delivered,
+// the graphs are ready to render (instead of sleeping for a while)
+static bool waitForMessageThread(Thread &thread)
+{
+    struct Signal final : ReferenceCountedObject
+    {
+        WaitableEvent event;
+    };
+
+    ReferenceCountedObjectPtr<Signal> signal(new Signal());
+    if (!MessageManager::callAsync([signal]() { signal->event.signal(); }))
+    {
+        return false;
+    }
+
+    while (!signal->event.wait(100))
+    {
+        if (thread.threadShouldExit())
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
 void RendererThread::run()
 {
+    const ScopedNoDenormals noDenormals;
+
     // step 0. init.
     this->transport.recacheIfNeeded();
     auto &sequences = this->transport.getPlaybackCache();
-    const int bufferSize = 512;
+    const int bufferSize = this->options.blockSize;
 
     // assuming that number of channels and sample rate is equal for all instruments
     const int numOutChannels = sequences.getNumOutputChannels();
     const int numInChannels = sequences.getNumInputChannels();
     const double sampleRate = sequences.getSampleRate();
     
-    double totalTimeMs = 0.0;
-    double tempoAtTheEndOfTrack = 0.0;
-    this->transport.calcTimeAndTempoAt(1.0, totalTimeMs, tempoAtTheEndOfTrack);
-    
+    // the range to be written, and the pre-roll before it, which is rendered,
+    // but not written, so that the plugins' state and reverb tails warm up
+    const double totalTime = this->transport.getTotalTime();
+    const double rangeStart = jlimit(0.0, 1.0, this->options.startPosition);
+    const double rangeEnd = jlimit(rangeStart, 1.0, this->options.endPosition);
+    const double preRollStart = (totalTime > 0.0) ?
+        jmax(0.0, rangeStart - jmax(0.0, this->options.preRollBeats) / totalTime) : rangeStart;
+
+    double endTimeMs = 0.0;
+    double tempoAtTheEnd = 0.0;
+    this->transport.calcTimeAndTempoAt(rangeEnd, endTimeMs, tempoAtTheEnd);
+
+    double rangeStartTimeMs = 0.0;
+    double tempoAtRangeStart = 0.0;
+    this->transport.calcTimeAndTempoAt(rangeStart, rangeStartTimeMs, tempoAtRangeStart);
+
     double startTimeMs = 0.0;
-    double msPerQuarter = 0.0;
-    this->transport.calcTimeAndTempoAt(0.0, startTimeMs, msPerQuarter);
-    double secPerQuarter = msPerQuarter / 1000.0;
+    double tempoAtPreRollStart = 0.0;
+    this->transport.calcTimeAndTempoAt(preRollStart, startTimeMs, tempoAtPreRollStart);
+
+    // the whole render goes on the integer sample timeline, which
+    // every position is rounded to once, so nothing drifts over time
+    const auto getFrameAt = [sampleRate](double timeMs)
+    {
+        return int64(std::floor(timeMs / 1000.0 * sampleRate + 0.5));
+    };
 
-    double currentFrame = 0.0;
-    const double lastFrame = totalTimeMs / 1000.0 * sampleRate;
+    // the blocks are aligned so that the first written one starts right at the range start
+    const int64 firstWrittenFrame = getFrameAt(rangeStartTimeMs);
+    const int64 preRollFrames = firstWrittenFrame - getFrameAt(startTimeMs);
+    const int64 numPreRollBlocks = (preRollFrames + bufferSize - 1) / bufferSize;
+    int64 currentFrame = firstWrittenFrame - numPreRollBlocks * bufferSize;
+    const int64 lastFrame = getFrameAt(endTimeMs);
 
     // step 1. create a list of unique instruments with audio buffers for them.
     OwnedArray<RenderBuffer> subBuffers;
     Array<Instrument *> uniqueInstruments(sequences.getUniqueInstruments());
 
+    if (this->options.soloInstrument != nullptr)
+    {
+        const bool hasSoloInstrument = uniqueInstruments.contains(this->options.soloInstrument);
+        uniqueInstruments.clearQuick();
+        if (hasSoloInstrument)
+        {
+            uniqueInstruments.add(this->options.soloInstrument);
+        }
+    }
+
+    // the effect buses, including the ones which the rendered instruments send to,
+    // go after all the instruments, because they are rendered after them, see step 3b
+    Array<Instrument *> buses;
+    for (int i = uniqueInstruments.size(); --i >= 0;)
+    {
+        if (uniqueInstruments.getUnchecked(i)->isEffectBus())
+        {
+            buses.add(uniqueInstruments.removeAndReturn(i));
+        }
+    }
+
+    const int numInstrumentBuffers = uniqueInstruments.size();
+    for (auto *instrument : uniqueInstruments)
+    {
+        for (const auto &send : instrument->getSends())
+        {
+            auto *bus = this->transport.orchestra.findInstrumentById(send.busId);
+            if (bus != nullptr && bus->isEffectBus())
+            {
+                buses.addIfNotAlreadyThere(bus);
+            }
+        }
+    }
+
+    uniqueInstruments.addArray(buses);
+
     for (int i = 0; i < uniqueInstruments.size(); ++i)
     {
         Instrument *instrument = uniqueInstruments[i];
         auto *subBuffer = new RenderBuffer();
         subBuffer->instrument = instrument;
         subBuffer->sampleBuffer = AudioSampleBuffer(numOutChannels, bufferSize);
+        subBuffer->sampleBufferDouble = AudioBuffer<double>(numOutChannels, bufferSize);
+        subBuffer->stemWriter = this->stemWriters[this->stemInstruments.indexOf(instrument)];
         subBuffers.add(subBuffer);
         //DBG("Adding instrument: " + String(instrument->getName()));
     }
 
+    for (int i = 0; i < numInstrumentBuffers; ++i)
+    {
+        auto *subBuffer = subBuffers.getUnchecked(i);
+        for (const auto &send : subBuffer->instrument->getSends())
+        {
+            for (int j = numInstrumentBuffers; j < subBuffers.size(); ++j)
+            {
+                auto *bus = subBuffers.getUnchecked(j);
+                if (bus->instrument->getIdAndHash() == send.busId)
+                {
+                    subBuffer->sends.add({ bus, send.level });
+                    break;
+                }
+            }
+        }
+    }
+
     // step 2. release resources, prepare to play, etc.
     for (auto *subBuffer : subBuffers)
     {
         AudioProcessorGraph *graph = subBuffer->instrument->getProcessorGraph();
         graph->setPlayConfigDetails(numInChannels, numOutChannels, sampleRate, bufferSize);
         graph->releaseResources();
-        // TODO:
-        //graph->setProcessingPrecision(AudioProcessor::singlePrecision);
+
+        const bool canUseDoublePrecision = this->options.useDoublePrecision &&
+            graph->supportsDoublePrecisionProcessing();
+
+        graph->setProcessingPrecision(canUseDoublePrecision ?
+            AudioProcessor::doublePrecision : AudioProcessor::singlePrecision);
+
         graph->prepareToPlay(graph->getSampleRate(), bufferSize);
         graph->setNonRealtime(true);
     }
 
     // let processor graphs call handle their async updates
-    Thread::sleep(200);
+    const bool graphsAreReady = waitForMessageThread(*this);
+
+    // the graphs only know their latencies once they are ready;
+    // every instrument will get its events earlier by its own latency,
+    // so the pre-roll is extended to have the earliest ones rendered
+    int maxLatency = 0;
+    for (const auto *subBuffer : subBuffers)
+    {
+        maxLatency = jmax(maxLatency, subBuffer->instrument->getProcessorGraph()->getLatencySamples());
+    }
+
+    currentFrame -= int64((maxLatency + bufferSize - 1) / bufferSize) * bufferSize;
+
+    // all instruments have separate processor graphs, so they are
+    // independent and can be rendered in parallel, joining before the mixdown
+    const int numWorkers = jmin(subBuffers.size(), SystemStats::getNumCpus()) - 1;
+    UniquePointer<ThreadPool> workers;
+    if (numWorkers > 0)
+    {
+        workers = makeUnique<ThreadPool>(numWorkers);
+    }
+
+    Atomic<int> numPendingBuffers;
+    WaitableEvent allBuffersDone;
+
+    const auto processBuffers = [&](int begin, int end)
+    {
+        if (workers == nullptr || end - begin < 2)
+        {
+            for (int i = begin; i < end; ++i)
+            {
+                subBuffers.getUnchecked(i)->process();
+            }
+
+            return;
+        }
+
+        // the first buffer is rendered by this thread, the rest by workers
+        numPendingBuffers = end - begin - 1;
+        for (int i = begin + 1; i < end; ++i)
+        {
+            auto *subBuffer = subBuffers.getUnchecked(i);
+            workers->addJob([subBuffer, &numPendingBuffers, &allBuffersDone]()
+            {
+                subBuffer->process();
+                if (--numPendingBuffers == 0)
+                {
+                    allBuffersDone.signal();
+                }
+            });
+        }
+
+        subBuffers.getUnchecked(begin)->process();
+        allBuffersDone.wait();
+    };
 
     // step 3. render loop itself.
-    sequences.seekToTime(0.0);
-    
-    CachedMidiMessage nextMessage;
-    bool hasNextMessage = sequences.getNextMessage(nextMessage);
-    jassert(hasNextMessage);
-    
-    // TODO: add double precision rendering someday (for processor graphs who support it)
+    // all events are placed at their exact frames in advance, as the tempo map
+    // integrates their time, ramps included, so the loop only compares integers
+    struct RenderEvent final
+    {
+        int64 frame;
+        MidiMessage message;
+        Instrument *instrument;
+    };
+
+    Array<RenderEvent> events;
+
+    // the click track, if requested, goes right into the mix
+    struct RenderClick final
+    {
+        int64 frame;
+        bool isBarStart;
+    };
+
+    Array<RenderClick> clicks;
+
+    {
+        FlatHashMap<Instrument *, int> latencies;
+        for (const auto *subBuffer : subBuffers)
+        {
+            latencies[subBuffer->instrument] = subBuffer->instrument->getProcessorGraph()->getLatencySamples();
+        }
+
+        const auto tempoMap = this->transport.getTempoMap();
+        ProjectSequences::Cursor cursor(sequences);
+        cursor.seekToTime(preRollStart * totalTime);
+
+        CachedMidiMessage wrapper;
+        while (cursor.getNextMessage(wrapper))
+        {
+            const auto frame = getFrameAt(tempoMap.getTimeAt(wrapper.message.getTimeStamp()));
+            if (frame >= lastFrame)
+            {
+                break;
+            }
+
+            const auto latency = latencies.find(wrapper.instrument);
+            const auto compensatedFrame = (latency != latencies.end()) ? frame - latency->second : frame;
+            events.add({ jmax(currentFrame, compensatedFrame), wrapper.message, wrapper.instrument });
+        }
+
+        // the shifted events are not in order anymore;
+        // the sort is stable to keep the order of simultaneous events
+        struct EventsComparator final
+        {
+            static int compareElements(const RenderEvent &first, const RenderEvent &second) noexcept
+            {
+                return (first.frame < second.frame) ? -1 : ((first.frame > second.frame) ? 1 : 0);
+            }
+        };
+
+        EventsComparator comparator;
+        events.sort(comparator, true);
+
+        if (this->options.renderMetronome && this->options.soloInstrument == nullptr)
+        {
+            const auto timeSignatures = this->transport.getTimeSignatures();
+
+            bool isBarStart = false;
+            auto click = Metronome::findNextClick(timeSignatures, preRollStart * totalTime, isBarStart);
+            for (auto frame = getFrameAt(tempoMap.getTimeAt(click)); frame < lastFrame;
+                frame = getFrameAt(tempoMap.getTimeAt(click)))
+            {
+                clicks.add({ frame, isBarStart });
+                click = Metronome::findClickAfter(timeSignatures, click, isBarStart);
+            }
+        }
+    }
+
+    int nextEventIndex = 0;
+    int nextClickIndex = 0;
+
+    Metronome::Voice clickVoice;
+    clickVoice.prepare(sampleRate);
+
+    // double precision graphs are mixed in double precision too,
+    // and only converted to floats before writing
     AudioSampleBuffer mixingBuffer(numOutChannels, bufferSize);
-    
-    double lastEventTick = 0.0;
-    double prevEventTimeStamp = 0.0;
-    double nextEventTickDelta = (nextMessage.message.getTimeStamp() - prevEventTimeStamp) * secPerQuarter;
-    double nextEventTick = lastEventTick + nextEventTickDelta;
+    AudioBuffer<double> mixingBufferDouble(numOutChannels, bufferSize);
+
+    // the precisions are settled since step 2
+    Array<const RenderBuffer *> floatSubBuffers;
+    Array<const RenderBuffer *> doubleSubBuffers;
+    for (const auto *subBuffer : subBuffers)
+    {
+        (subBuffer->usesDoublePrecision() ? doubleSubBuffers : floatSubBuffers).add(subBuffer);
+    }
 
-    int messageFrame = int((nextEventTick * sampleRate) - currentFrame);
+    Array<const float *> floatSources;
+    Array<const double *> doubleSources;
+    Array<float> mixGains;
+    Array<double> mixGainsDouble;
+    mixGains.insertMultiple(0, 1.f, floatSubBuffers.size());
+    mixGainsDouble.insertMultiple(0, 1.0, doubleSubBuffers.size());
+    
+    int messageFrame = events.isEmpty() ? 0 :
+        int(jmin(int64(bufferSize - 1), events.getReference(0).frame - currentFrame));
 
     // And here we go: send MidiStart
     for (auto *subBuffer : subBuffers)
@@ -196,7 +612,15 @@ void RendererThread::run()
         subBuffer->midiBuffer.addEvent(MidiMessage::midiStart(), messageFrame);
     }
 
-    while (currentFrame < lastFrame)
+    // the progress includes the pre-roll and the latency compensation,
+    // so that the estimated time left is right from the very start
+    const int64 firstRenderedFrame = currentFrame;
+    this->framesTotal.store(jmax(int64(1), lastFrame - firstRenderedFrame), std::memory_order_relaxed);
+    this->renderSampleRate.store(sampleRate, std::memory_order_relaxed);
+    this->renderStartTimeMs.store(Time::getMillisecondCounterHiRes(), std::memory_order_relaxed);
+    int numBlocksRendered = 0;
+
+    while (graphsAreReady && currentFrame < lastFrame)
     {
         if (this->threadShouldExit())
         {
@@ -204,94 +628,147 @@ void RendererThread::run()
         }
         
         // step 3a. fill up the midi buffers.
-        while (hasNextMessage &&
-               ( (nextEventTick * sampleRate) >= currentFrame &&
-                 (nextEventTick * sampleRate) < (currentFrame + bufferSize) ))
+        const int64 nextBlockFrame = currentFrame + bufferSize;
+        while (nextEventIndex < events.size() &&
+            events.getReference(nextEventIndex).frame < nextBlockFrame)
         {
-            messageFrame = int((nextEventTick * sampleRate) - currentFrame);
+            const auto &event = events.getReference(nextEventIndex++);
+            messageFrame = int(event.frame - currentFrame);
 
-            if (nextMessage.message.isTempoMetaEvent())
+            if (event.message.isTempoMetaEvent())
             {
-                secPerQuarter = nextMessage.message.getTempoSecondsPerQuarterNote();
-
                 // Sends this to everybody (need to do that for drum-machines) - TODO test
                 for (auto subBuffer : subBuffers)
                 {
-                    subBuffer->midiBuffer.addEvent(nextMessage.message, messageFrame);
+                    subBuffer->midiBuffer.addEvent(event.message, messageFrame);
                 }
             }
             else
             {
                 for (auto *subBuffer : subBuffers)
                 {
-                    if (nextMessage.instrument == subBuffer->instrument)
+                    if (event.instrument == subBuffer->instrument)
                     {
                         //DBG("Adding message with frame " + String(messageFrame));
-                        subBuffer->midiBuffer.addEvent(nextMessage.message, messageFrame);
+                        subBuffer->midiBuffer.addEvent(event.message, messageFrame);
                     }
                 }
             }
-
-            lastEventTick += nextEventTickDelta;
-            prevEventTimeStamp = nextMessage.message.getTimeStamp();
-            
-            hasNextMessage = sequences.getNextMessage(nextMessage);
-            nextEventTickDelta = (nextMessage.message.getTimeStamp() - prevEventTimeStamp) * secPerQuarter;
-            nextEventTick = lastEventTick + nextEventTickDelta;
         }
 
-        // step 3b. call processBlock for every instrument.
-        for (auto subBuffer : subBuffers)
+        // step 3b. call processBlock for every instrument, and then for every bus.
+        processBuffers(0, numInstrumentBuffers);
+
+        if (subBuffers.size() > numInstrumentBuffers)
         {
-            AudioProcessorGraph *graph = subBuffer->instrument->getProcessorGraph();
+            for (int i = numInstrumentBuffers; i < subBuffers.size(); ++i)
             {
-                const ScopedLock lock(graph->getCallbackLock());
-                
-                //DBG("processBlock num midi events: " + String(subBuffer->midiBuffer.getNumEvents()));
-                graph->processBlock(subBuffer->sampleBuffer, subBuffer->midiBuffer);
-                subBuffer->midiBuffer.clear();
+                subBuffers.getUnchecked(i)->sampleBuffer.clear();
+                subBuffers.getUnchecked(i)->sampleBufferDouble.clear();
+            }
 
-                //Thread::yield();
+            for (int i = 0; i < numInstrumentBuffers; ++i)
+            {
+                const auto *subBuffer = subBuffers.getUnchecked(i);
+                for (const auto &send : subBuffer->sends)
+                {
+                    send.bus->addSendFrom(*subBuffer, send.level);
+                }
             }
+
+            processBuffers(numInstrumentBuffers, subBuffers.size());
         }
 
-        // step 3c. mix them down to the render buffer.
-        mixingBuffer.clear();
+        // step 3c. mix them down to the render buffer, in one pass per channel.
+        for (int j = 0; j < numOutChannels; ++j)
+        {
+            floatSources.clearQuick();
+            for (const auto *subBuffer : floatSubBuffers)
+            {
+                floatSources.add(subBuffer->sampleBuffer.getReadPointer(j));
+            }
+
+            auto *destination = mixingBuffer.getWritePointer(j);
+            MixdownKernel::process(destination, floatSources.getRawDataPointer(),
+                mixGains.getRawDataPointer(), floatSources.size(), bufferSize);
+
+            if (doubleSubBuffers.isEmpty())
+            {
+                continue;
+            }
+
+            doubleSources.clearQuick();
+            for (const auto *subBuffer : doubleSubBuffers)
+            {
+                doubleSources.add(subBuffer->sampleBufferDouble.getReadPointer(j));
+            }
+
+            auto *destinationDouble = mixingBufferDouble.getWritePointer(j);
+            MixdownKernel::process(destinationDouble, doubleSources.getRawDataPointer(),
+                mixGainsDouble.getRawDataPointer(), doubleSources.size(), bufferSize);
 
-        for (auto subBuffer : subBuffers)
+            for (int k = 0; k < bufferSize; ++k)
+            {
+                destination[k] += float(destinationDouble[k]);
+            }
+        }
+
+        // step 3c'. add the clicks at their exact frames.
+        if (!clicks.isEmpty())
         {
-            for (int j = 0; j < numOutChannels; ++j)
+            auto **channels = mixingBuffer.getArrayOfWritePointers();
+            int rendered = 0;
+
+            while (nextClickIndex < clicks.size() &&
+                clicks.getReference(nextClickIndex).frame < nextBlockFrame)
             {
-                mixingBuffer.addFrom(j, 0,
-                    subBuffer->sampleBuffer, j, 0,
-                    bufferSize,
-                    1.0f);
+                const auto &click = clicks.getReference(nextClickIndex++);
+                const auto clickOffset = int(jmax(int64(0), click.frame - currentFrame));
+                clickVoice.render(channels, numOutChannels, rendered, clickOffset - rendered);
+                clickVoice.trigger(click.isBarStart);
+                rendered = clickOffset;
             }
+
+            clickVoice.render(channels, numOutChannels, rendered, bufferSize - rendered);
         }
 
-        // step 3d. write resulting buffer to disk.
+        // step 3d. pass the resulting buffer to the writer thread,
+        // which encodes and writes it to disk while we're rendering the next one.
+        if (currentFrame >= firstWrittenFrame)
         {
             const ScopedLock sl(this->writerLock);
-            bool writedSuccessfullty = false;
-            
-            while (! writedSuccessfullty)
+            bool writtenSuccessfully = this->writer->write(mixingBuffer, *this);
+
+            for (const auto *subBuffer : subBuffers)
             {
-                writedSuccessfullty =
-                this->writer->writeFromAudioSampleBuffer(mixingBuffer, 0, mixingBuffer.getNumSamples());
+                if (writtenSuccessfully && subBuffer->stemWriter != nullptr)
+                {
+                    writtenSuccessfully = subBuffer->instrument->getProcessorGraph()->isUsingDoublePrecision() ?
+                        subBuffer->stemWriter->write(subBuffer->sampleBufferDouble, *this) :
+                        subBuffer->stemWriter->write(subBuffer->sampleBuffer, *this);
+                }
+            }
+
+            if (!writtenSuccessfully)
+            {
+                this->failed = !this->threadShouldExit();
+                break;
             }
         }
 
         // step 3e. finally, update counters.
         currentFrame += bufferSize;
 
+        if (++numBlocksRendered % RENDER_PROGRESS_UPDATE_INTERVAL_BLOCKS == 0)
         {
-            const ScopedWriteLock pl(this->percentsLock);
-            this->percentsDone = float(currentFrame / lastFrame);
-            //DBG("this->percentsDone : " + String(this->percentsDone));
+            this->framesDone.store(currentFrame - firstRenderedFrame, std::memory_order_relaxed);
         }
     }
 
-    // step 4. setNonRealtime false.
+    this->framesDone.store(currentFrame - firstRenderedFrame, std::memory_order_relaxed);
+
+    // step 4. setNonRealtime false
+    // (the audio callbacks will prepare graphs in single precision again, when woken up).
     for (auto subBuffer : subBuffers)
     {
         AudioProcessorGraph *graph = subBuffer->instrument->getProcessorGraph();
@@ -300,8 +777,26 @@ void RendererThread::run()
     
     {
         const ScopedLock sl(this->writerLock);
+        if (!this->writer->flush(*this) && this->writer->hasFailed())
+        {
+            this->failed = true;
+        }
+
+        for (auto *stemWriter : this->stemWriters)
+        {
+            if (!stemWriter->flush(*this) && stemWriter->hasFailed())
+            {
+                this->failed = true;
+            }
+        }
+
         this->writer = nullptr;
+        this->stemWriters.clear();
+        this->stemInstruments.clearQuick();
     }
 
+    const bool isComplete = graphsAreReady && !this->failed.get() && currentFrame >= lastFrame;
+    this->transport.onRenderFinished(isComplete);
+
     App::Workspace().getAudioCore().setAwake();
 }
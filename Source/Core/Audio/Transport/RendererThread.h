@@ -19,6 +19,8 @@
 
 #include "Transport.h"
 
+class AsyncAudioWriter;
+
 class RendererThread final : private Thread
 {
 public:
@@ -28,10 +30,18 @@ public:
     
     float getPercentsComplete() const;
 
-    void startRecording(const File &file);
+    // the render speed, as a multiple of real time,
+    // and the estimated time left, both zero until known
+    double getRealtimeRatio() const;
+    double getEstimatedTimeLeftMs() const;
+
+    void startRecording(const File &file, const RenderOptions &options);
     void stop();
     bool isRecording() const;
 
+    // true, if the last render has stopped because of a write error
+    bool hasFailed() const noexcept;
+
 private:
 
     //===------------------------------------------------------------------===//
@@ -45,10 +55,19 @@ private:
     Transport &transport;
 
     CriticalSection writerLock;
-    UniquePointer<AudioFormatWriter> writer;
+    UniquePointer<AsyncAudioWriter> writer;
+    OwnedArray<AsyncAudioWriter> stemWriters;
+    Array<Instrument *> stemInstruments;
+    Atomic<bool> failed = false;
+
+    RenderOptions options;
 
-    ReadWriteLock percentsLock;
-    float percentsDone;
+    // written by the render loop, polled from the ui,
+    // none of them need to be consistent with each other
+    std::atomic<int64> framesDone { 0 };
+    std::atomic<int64> framesTotal { 0 };
+    std::atomic<double> renderSampleRate { 0.0 };
+    std::atomic<double> renderStartTimeMs { 0.0 };
     
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(RendererThread)
 };
@@ -0,0 +1,164 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Common.h"
+#include "TempoMap.h"
+#include "ProjectSequencesWrapper.h"
+#include "AutomationSequence.h"
+#include "MidiTrack.h"
+#include "Transport.h"
+
+#define DEFAULT_MS_PER_QUARTER (500.0) // 120 BPM
+
+void TempoMap::rebuild(const ProjectSequences &sequences)
+{
+    this->anchors.clearQuick();
+
+    struct TempoPoint final
+    {
+        double beat;
+        double msPerQuarter;
+    };
+
+    // the tempo tracks only have their own events in the playback cache,
+    // so the ramps are taken from their curves, as they look in the editor
+    Array<TempoPoint> points;
+    for (const auto *wrapper : sequences.getAllFor(nullptr))
+    {
+        const auto *sequence = dynamic_cast<const AutomationSequence *>(wrapper->track);
+        if (sequence == nullptr || !sequence->getTrack()->isTempoTrack())
+        {
+            continue;
+        }
+
+        const auto &curve = sequence->getInterpolatedCurve();
+        for (const auto &clip : wrapper->clips)
+        {
+            for (const auto &point : curve)
+            {
+                const auto usPerQuarter = Transport::getTempoByControllerValue(point.controllerValue);
+                points.add({ double(point.beat) + clip.timeOffset, usPerQuarter / 1000.0 });
+            }
+        }
+    }
+
+    std::stable_sort(points.begin(), points.end(),
+        [](const TempoPoint &a, const TempoPoint &b) { return a.beat < b.beat; });
+
+    for (int i = 0; i < points.size(); ++i)
+    {
+        const auto &point = points.getReference(i);
+
+        double timeMs = point.msPerQuarter * point.beat;
+        if (!this->anchors.isEmpty())
+        {
+            const auto &last = this->anchors.getReference(this->anchors.size() - 1);
+            const double length = point.beat - last.beat;
+            timeMs = last.timeMs + (last.msPerQuarter + last.slope * length * 0.5) * length;
+        }
+
+        double slope = 0.0;
+        if (i < points.size() - 1)
+        {
+            const auto &next = points.getReference(i + 1);
+            const double length = next.beat - point.beat;
+            slope = (length > 0.0) ? ((next.msPerQuarter - point.msPerQuarter) / length) : 0.0;
+        }
+
+        this->anchors.add({ point.beat, timeMs, point.msPerQuarter, slope });
+    }
+}
+
+void TempoMap::clear() noexcept
+{
+    this->anchors.clearQuick();
+}
+
+void TempoMap::swapWith(TempoMap &other) noexcept
+{
+    this->anchors.swapWith(other.anchors);
+}
+
+bool TempoMap::isEmpty() const noexcept
+{
+    return this->anchors.isEmpty();
+}
+
+double TempoMap::getFirstMsPerQuarter() const noexcept
+{
+    return this->anchors.isEmpty() ?
+        DEFAULT_MS_PER_QUARTER :
+        this->anchors.getReference(0).msPerQuarter;
+}
+
+// the last anchor at or before the given beat, if any
+const TempoMap::Anchor *TempoMap::findAnchorFor(double beat) const noexcept
+{
+    const auto *next = std::upper_bound(this->anchors.begin(), this->anchors.end(), beat,
+        [](double b, const Anchor &anchor) { return b < anchor.beat; });
+
+    return (next == this->anchors.begin()) ? nullptr : (next - 1);
+}
+
+void TempoMap::getTimeAndTempoAt(double beat,
+    double &outTimeMs, double &outMsPerQuarter) const noexcept
+{
+    const auto *anchor = this->findAnchorFor(beat);
+    if (anchor == nullptr)
+    {
+        // the first tempo change sets the tempo all the way before it
+        outMsPerQuarter = this->getFirstMsPerQuarter();
+        outTimeMs = outMsPerQuarter * beat;
+        return;
+    }
+
+    // the integral of the linear function
+    const double length = beat - anchor->beat;
+    outMsPerQuarter = anchor->msPerQuarter + anchor->slope * length;
+    outTimeMs = anchor->timeMs + (anchor->msPerQuarter + anchor->slope * length * 0.5) * length;
+}
+
+double TempoMap::getTimeAt(double beat) const noexcept
+{
+    double timeMs = 0.0;
+    double msPerQuarter = 0.0;
+    this->getTimeAndTempoAt(beat, timeMs, msPerQuarter);
+    return timeMs;
+}
+
+double TempoMap::getBeatAt(double timeMs, double &outMsPerQuarter) const noexcept
+{
+    const auto *next = std::upper_bound(this->anchors.begin(), this->anchors.end(), timeMs,
+        [](double t, const Anchor &anchor) { return t < anchor.timeMs; });
+
+    if (next == this->anchors.begin())
+    {
+        outMsPerQuarter = this->getFirstMsPerQuarter();
+        return timeMs / outMsPerQuarter;
+    }
+
+    // solving slope / 2 * x^2 + msPerQuarter * x = dt, in the form
+    // which doesn't divide by the slope, since it's mostly zero
+    const auto &anchor = *(next - 1);
+    const double dt = timeMs - anchor.timeMs;
+    const double discriminant = jmax(0.0,
+        anchor.msPerQuarter * anchor.msPerQuarter + 2.0 * anchor.slope * dt);
+    const double length = 2.0 * dt / (anchor.msPerQuarter + std::sqrt(discriminant));
+
+    outMsPerQuarter = anchor.msPerQuarter + anchor.slope * length;
+    return anchor.beat + length;
+}
@@ -0,0 +1,72 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+class ProjectSequences;
+
+/*
+    A piecewise-linear tempo function of the playback cache timeline:
+    keeps the sorted tempo points along with the time accumulated
+    by each of them, so that converting a beat into milliseconds
+    is a binary search instead of walking through all the messages.
+
+    Between the points, the milliseconds per quarter change linearly,
+    which is how the tempo ramps are represented, so the time is
+    integrated in the closed form, and it's a quadratic equation backwards;
+    the ramps don't need any interpolated tempo events to sound right.
+
+    Tempo before the first point is the tempo of that point, and so is
+    the tempo after the last one, or the default 120 BPM, if there are none.
+*/
+
+class TempoMap final
+{
+public:
+
+    TempoMap() = default;
+
+    void rebuild(const ProjectSequences &sequences);
+    void clear() noexcept;
+    void swapWith(TempoMap &other) noexcept;
+
+    bool isEmpty() const noexcept;
+    double getFirstMsPerQuarter() const noexcept;
+
+    void getTimeAndTempoAt(double beat,
+        double &outTimeMs, double &outMsPerQuarter) const noexcept;
+
+    double getTimeAt(double beat) const noexcept;
+    double getBeatAt(double timeMs, double &outMsPerQuarter) const noexcept;
+
+private:
+
+    struct Anchor final
+    {
+        double beat;
+        double timeMs;
+        double msPerQuarter;
+        // the change of milliseconds per quarter per beat until the next anchor
+        double slope;
+    };
+
+    Array<Anchor> anchors;
+
+    const Anchor *findAnchorFor(double beat) const noexcept;
+
+    JUCE_LEAK_DETECTOR(TempoMap)
+};
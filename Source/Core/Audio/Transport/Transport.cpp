@@ -20,35 +20,54 @@
 #include "OrchestraPit.h"
 #include "PlayerThread.h"
 #include "RendererThread.h"
+#include "AuditionPlayer.h"
 #include "MidiSequence.h"
+#include "AutomationSequence.h"
+#include "PianoSequence.h"
+#include "MidiExportBuffer.h"
 #include "MidiEvent.h"
+#include "TimeSignatureEvent.h"
 #include "MidiTrack.h"
 #include "Clip.h"
 #include "Pattern.h"
 #include "Workspace.h"
 #include "AudioCore.h"
+#include "AudioMonitor.h"
 #include "HybridRoll.h"
 #include "SerializationKeys.h"
-#include "PlayerThreadPool.h"
 
 #define TIME_NOW (Time::getMillisecondCounterHiRes() * 0.001)
 #define SOUND_SLEEP_DELAY_MS (10000)
 
-Transport::Transport(OrchestraPit &orchestraPit, SleepTimer &sleepTimer) :
+Transport::Transport(OrchestraPit &orchestraPit, SleepTimer &sleepTimer,
+    const AudioClock &audioClock, Metronome &metronome,
+    MidiSyncOutput &syncOutput, AudioRecorder &audioRecorder) :
     orchestra(orchestraPit),
-    sleepTimer(sleepTimer)
+    sleepTimer(sleepTimer),
+    audioClock(audioClock),
+    metronome(metronome),
+    syncOutput(syncOutput),
+    audioRecorder(audioRecorder)
 {
-    this->player = makeUnique<PlayerThreadPool>(*this);
+    this->player = makeUnique<PlayerThread>(*this);
     this->renderer = makeUnique<RendererThread>(*this);
+    this->audition = makeUnique<AuditionPlayer>();
     this->orchestra.addOrchestraListener(this);
 }
 
 Transport::~Transport()
 {
+    this->cancelPendingUpdate();
     this->orchestra.removeOrchestraListener(this);
+    this->audition = nullptr;
     this->renderer = nullptr;
     this->player = nullptr;
     this->transportListeners.clear();
+
+    if (this->freezingFile != File())
+    {
+        this->freezingFile.deleteFile();
+    }
 }
 
 String Transport::getTimeString(double timeMs, bool includeMilliseconds)
@@ -112,6 +131,88 @@ void Transport::setSeekPosition(const double absPosition)
     this->seekPosition = absPosition;
 }
 
+double Transport::getPlaybackPosition() const noexcept
+{
+    bool hasAnchor = false;
+    bool usesAudioClock = false;
+    double clockPosition = 0.0;
+    double timeStamp = 0.0;
+    double msPerQuarter = 1.0;
+    double endTimeStamp = 0.0;
+
+    for (;;)
+    {
+        const int version = this->playbackAnchorVersion.get();
+        if ((version & 1) != 0)
+        {
+            continue;
+        }
+
+        hasAnchor = this->hasPlaybackAnchor.get();
+        usesAudioClock = this->anchorUsesAudioClock.get();
+        clockPosition = this->anchorClockPosition.get();
+        timeStamp = this->anchorTimeStamp.get();
+        msPerQuarter = this->anchorMsPerQuarter.get();
+        endTimeStamp = this->anchorEndTimeStamp.get();
+
+        if (this->playbackAnchorVersion.get() == version)
+        {
+            break;
+        }
+    }
+
+    if (!hasAnchor)
+    {
+        return this->lastBroadcastPosition.get();
+    }
+
+    double msSinceAnchor = 0.0;
+    if (usesAudioClock)
+    {
+        const double sampleRate = this->audioClock.getSampleRate();
+        if (sampleRate > 0.0)
+        {
+            msSinceAnchor = (this->audioClock.getEstimatedSamplePosition() - clockPosition) / sampleRate * 1000.0;
+        }
+    }
+    else
+    {
+        msSinceAnchor = Time::getMillisecondCounterHiRes() - clockPosition;
+    }
+
+    // the player thread re-anchors at tempo changes and loop rewinds,
+    // meanwhile the playhead shouldn't run past the end of the range
+    const double currentTimeStamp = jmin(endTimeStamp,
+        timeStamp + jmax(0.0, msSinceAnchor) / msPerQuarter);
+
+    return currentTimeStamp / this->getTotalTime();
+}
+
+double Transport::getPlaybackBeat() const noexcept
+{
+    return this->trackStartMs.get() + this->getPlaybackPosition() * this->getTotalTime();
+}
+
+void Transport::setPlaybackAnchor(double clockPosition, bool usesAudioClock,
+    double timeStamp, double msPerQuarter, double endTimeStamp) noexcept
+{
+    ++this->playbackAnchorVersion;
+    this->anchorUsesAudioClock = usesAudioClock;
+    this->anchorClockPosition = clockPosition;
+    this->anchorTimeStamp = timeStamp;
+    this->anchorMsPerQuarter = jmax(msPerQuarter, 0.01);
+    this->anchorEndTimeStamp = endTimeStamp;
+    this->hasPlaybackAnchor = true;
+    ++this->playbackAnchorVersion;
+}
+
+void Transport::resetPlaybackAnchor() noexcept
+{
+    ++this->playbackAnchorVersion;
+    this->hasPlaybackAnchor = false;
+    ++this->playbackAnchorVersion;
+}
+
 double Transport::getTotalTime() const noexcept
 {
     return this->totalTime.get();
@@ -145,59 +246,120 @@ void Transport::probeSoundAt(double absTrackPosition, const MidiSequence *limitT
     
     const double targetFlatTime = this->getTotalTime() * absTrackPosition;
     const auto sequencesToProbe(this->playbackCache.getAllFor(limitToLayer));
-    
-    for (const auto &seq : sequencesToProbe)
+
+    Array<ProbedNote> soundingNotes;
+    for (auto *seq : sequencesToProbe)
     {
-        for (int j = 0; j < seq->midiMessages.getNumEvents(); ++j)
+        for (int c = 0; c < seq->clips.size(); ++c)
         {
-            auto *noteOnHolder = seq->midiMessages.getEventPointer(j);
-            
-            if (auto *noteOffHolder = noteOnHolder->noteOffObject)
+            const double localTime = targetFlatTime - seq->clips.getReference(c).timeOffset;
+            seq->findNotesSoundingAt(localTime, [&soundingNotes, seq, c](int noteOnIndex)
             {
-                const double noteOn(noteOnHolder->message.getTimeStamp());
-                const double noteOff(noteOffHolder->message.getTimeStamp());
-                
-                if (noteOn <= targetFlatTime && noteOff > targetFlatTime)
-                {
-                    MidiMessage messageTimestampedAsNow(noteOnHolder->message);
-                    messageTimestampedAsNow.setTimeStamp(TIME_NOW);
-                    seq->listener->addMessageToQueue(messageTimestampedAsNow);
-                }
-            }
+                soundingNotes.add({ seq, c, noteOnIndex });
+            });
+        }
+    }
+
+    // only a handful of notes are sounding at once, so the linear lookups are fine
+    for (const auto &note : this->probedNotes)
+    {
+        if (!soundingNotes.contains(note))
+        {
+            sendProbedNote(note, false);
+        }
+    }
+
+    for (const auto &note : soundingNotes)
+    {
+        if (!this->probedNotes.contains(note))
+        {
+            sendProbedNote(note, true);
         }
     }
 
+    this->probedNotes.swapWith(soundingNotes);
+
     this->sleepTimer.setCanSleepAfter(SOUND_SLEEP_DELAY_MS);
 }
 
-// Only used in a key signature dialog to test how scales sound
-void Transport::probeSequence(const MidiMessageSequence &sequence)
+// Releases the probed notes gently, unlike allNotesControllersAndSoundOff(),
+// which cuts off the sound and may click
+void Transport::stopSoundProbe()
 {
-    this->playbackCache.clear();
-    this->sequencesAreOutdated = true; // will update on the next playback
+    this->sleepTimer.setAwake();
 
-    const double startPositionInTime = this->getSeekPosition() * this->getTotalTime();
+    for (const auto &note : this->probedNotes)
+    {
+        sendProbedNote(note, false);
+    }
 
-    // using the last instrument (TODO something more clever in the future)
-    auto *instrument = this->orchestra.getInstruments().getLast();
-    auto cached = CachedMidiSequence::createFrom(instrument);
-    cached->midiMessages = MidiMessageSequence(sequence);
-    cached->midiMessages.addTimeToMessages(startPositionInTime);
+    this->probedNotes.clearQuick();
 
-    this->playbackCache.addWrapper(cached);
+    this->sleepTimer.setCanSleepAfter(SOUND_SLEEP_DELAY_MS);
+}
 
-    if (this->player->isPlaying())
+void Transport::sendProbedNote(const ProbedNote &note, bool isNoteOn)
+{
+    auto message = note.sequence->getMessage(note.noteOnIndex, note.clipIndex);
+    if (!isNoteOn)
     {
-        this->player->stopPlayback();
-        this->allNotesControllersAndSoundOff();
+        message = MidiMessage::noteOff(message.getChannel(), message.getNoteNumber());
     }
 
-    this->player->startPlayback(false);
+    message.setTimeStamp(TIME_NOW);
+    note.sequence->instrument->getProcessorPlayer().addPreviewMessage(message);
 }
 
-void Transport::startPlayback()
+// Used in the key signature dialog and the preview tools to hear how things sound:
+// the sequence goes to the audition player, so the playback cache stays valid
+void Transport::probeSequence(const MidiMessageSequence &sequence, const MidiTrack *track)
+{
+    WeakReference<Instrument> instrument;
+    if (track != nullptr && this->linksCache.contains(track->getTrackId()))
+    {
+        instrument = this->linksCache[track->getTrackId()];
+    }
+
+    if (instrument == nullptr)
+    {
+        // using the last instrument (TODO something more clever in the future)
+        instrument = this->orchestra.getInstruments().getLast();
+    }
+
+    if (instrument == nullptr)
+    {
+        return;
+    }
+
+    this->stopPlayback();
+
+    // the tempo at the seek position is applied here, once,
+    // so that the audition player only deals with milliseconds
+    const auto tempoMap = this->getTempoMap();
+    const double startBeat = this->getSeekPosition() * this->getTotalTime();
+    const double startTimeMs = tempoMap.getTimeAt(startBeat);
+
+    MidiMessageSequence timedSequence(sequence);
+    for (int i = 0; i < timedSequence.getNumEvents(); ++i)
+    {
+        auto &message = timedSequence.getEventPointer(i)->message;
+        message.setTimeStamp(tempoMap.getTimeAt(startBeat + message.getTimeStamp()) - startTimeMs);
+    }
+
+    this->sleepTimer.setAwake();
+    this->audition->play(timedSequence, instrument);
+    this->sleepTimer.setCanSleepAfter(int(timedSequence.getEndTime()) + SOUND_SLEEP_DELAY_MS);
+}
+
+bool Transport::isProbingSequence() const
+{
+    return this->audition->isPlaying();
+}
+
+void Transport::startPlayback(bool withCountIn)
 {
     this->sleepTimer.setAwake();
+    this->audition->stop();
     this->recacheIfNeeded();
 
     if (this->player->isPlaying())
@@ -205,14 +367,18 @@ void Transport::startPlayback()
         this->player->stopPlayback();
         this->allNotesControllersAndSoundOff();
     }
-    
-    this->player->startPlayback();
+
+    // the integrated loudness is measured for each playback from the start
+    App::Workspace().getAudioCore().getMonitor()->resetLoudness();
+
+    this->player->startPlayback(true, withCountIn);
     this->broadcastPlay();
 }
 
 void Transport::startPlaybackFragment(double absLoopStart, double absLoopEnd, bool looped)
 {
     this->sleepTimer.setAwake();
+    this->audition->stop();
     this->recacheIfNeeded();
     
     if (this->player->isPlaying())
@@ -227,6 +393,8 @@ void Transport::startPlaybackFragment(double absLoopStart, double absLoopEnd, bo
 
 void Transport::stopPlayback()
 {
+    this->audition->stop();
+
     if (this->player->isPlaying())
     {
         this->player->stopPlayback();
@@ -247,7 +415,7 @@ bool Transport::isPlaying() const
     return this->player->isPlaying();
 }
 
-void Transport::startRender(const String &fileName)
+void Transport::startRender(const String &fileName, const RenderOptions &options)
 {
     if (this->renderer->isRecording())
     {
@@ -257,7 +425,7 @@ void Transport::startRender(const String &fileName)
     this->sleepTimer.setCanSleepAfter(0);
 
     File file(File::getCurrentWorkingDirectory().getChildFile(fileName));
-    this->renderer->startRecording(file);
+    this->renderer->startRecording(file, options);
 }
 
 void Transport::stopRender()
@@ -277,82 +445,194 @@ bool Transport::isRendering() const
     return this->renderer->isRecording();
 }
 
+bool Transport::hasRenderFailed() const
+{
+    return this->renderer->hasFailed();
+}
+
 float Transport::getRenderingPercentsComplete() const
 {
     return this->renderer->getPercentsComplete();
 }
 
-//===----------------------------------------------------------------------===//
-// Sending messages at real-time
-//===----------------------------------------------------------------------===//
+double Transport::getRenderingRealtimeRatio() const
+{
+    return this->renderer->getRealtimeRatio();
+}
 
-Transport::MidiMessageDelayedPreview::~MidiMessageDelayedPreview()
+double Transport::getRenderingTimeLeftMs() const
 {
-    this->cancelPendingPreview();
+    return this->renderer->getEstimatedTimeLeftMs();
 }
 
-void Transport::MidiMessageDelayedPreview::cancelPendingPreview()
+//===----------------------------------------------------------------------===//
+// Freezing instruments
+//===----------------------------------------------------------------------===//
+
+void Transport::freezeInstrument(Instrument *instrument)
 {
-    this->stopTimer();
-    this->messages.clearQuick();
-    this->instruments.clearQuick();
+    if (instrument == nullptr || this->renderer->isRecording())
+    {
+        return;
+    }
+
+    // the instrument's graph is used by the renderer exclusively
+    this->stopPlayback();
+    this->unfreezeInstrument(instrument);
+
+    // any pending changes should not invalidate the result
+    this->recacheIfNeeded();
+
+    // the whole project from its first beat, so that the playback
+    // can start at any position; 32-bit float wav can be memory-mapped
+    RenderOptions options;
+    options.bitDepth = 32;
+    options.soloInstrument = instrument;
+
+    this->freezingInstrument = instrument;
+    this->freezingWasInvalidated = false;
+    this->freezingFile = File::getSpecialLocation(File::tempDirectory)
+        .getNonexistentChildFile("freeze", ".wav", false);
+
+    this->sleepTimer.setCanSleepAfter(0);
+    this->renderer->startRecording(this->freezingFile, options);
+
+    if (!this->renderer->isRecording())
+    {
+        this->freezingFile.deleteFile();
+        this->freezingFile = File();
+        this->freezingInstrument = nullptr;
+    }
 }
 
-void Transport::MidiMessageDelayedPreview::previewMessage(const MidiMessage &message,
-    WeakReference<Instrument> instrument)
+void Transport::unfreezeInstrument(Instrument *instrument)
 {
-    this->messages.add(message);
-    this->instruments.add(instrument);
-    if (!this->isTimerRunning())
     {
-        this->startTimer(50);
+        // the memory-mapped file will be released along with
+        // the last schedule that uses it, not necessarily right here
+        const ScopedLock lock(this->frozenInstrumentsLock);
+        this->frozenInstruments.erase(instrument);
+    }
+
+    if (this->isPlaying())
+    {
+        // switch to processing the instrument on the fly
+        this->triggerAsyncUpdate();
     }
 }
 
-void Transport::MidiMessageDelayedPreview::timerCallback()
+bool Transport::isInstrumentFrozen(const Instrument *instrument) const
 {
-    this->stopTimer();
+    const ScopedLock lock(this->frozenInstrumentsLock);
+    return this->frozenInstruments.find(instrument) != this->frozenInstruments.end();
+}
 
-#if HELIO_MOBILE
-    // iSEM tends to hang >_< if too many messages are send simultaniously
-    const auto time = TIME_NOW + float(rand() % 50) * 0.01;
-#elif HELIO_DESKTOP
-    const auto time = TIME_NOW;
-#endif
+bool Transport::isFreezingInstrument(const Instrument *instrument) const
+{
+    return instrument != nullptr && this->freezingInstrument == instrument;
+}
 
-    for (int i = 0; i < this->messages.size(); ++i)
+FrozenAudio::Map Transport::getFrozenInstruments() const
+{
+    const ScopedLock lock(this->frozenInstrumentsLock);
+    return this->frozenInstruments;
+}
+
+void Transport::onRenderFinished(bool isComplete)
+{
+    this->renderIsComplete = isComplete;
+    this->renderHasFinished = true;
+    this->triggerAsyncUpdate();
+}
+
+void Transport::finishFreezing()
+{
+    if (this->freezingFile == File())
     {
-        if (Instrument *instrument = this->instruments.getUnchecked(i))
+        return; // just a usual render
+    }
+
+    // the thread is about to exit at this point
+    this->renderer->stop();
+
+    auto *instrument = this->freezingInstrument.get();
+    const auto file = this->freezingFile;
+
+    this->freezingInstrument = nullptr;
+    this->freezingFile = File();
+
+    if (instrument != nullptr &&
+        !this->freezingWasInvalidated &&
+        this->renderIsComplete.get())
+    {
+        if (auto frozenAudio = FrozenAudio::createFrom(file))
         {
-            auto &message = this->messages.getReference(i);
-            message.setTimeStamp(time);
-            instrument->getProcessorPlayer().getMidiMessageCollector().addMessageToQueue(message);
+            const ScopedLock lock(this->frozenInstrumentsLock);
+            this->frozenInstruments[instrument] = frozenAudio;
+            return;
         }
     }
 
-    this->messages.clearQuick();
-    this->instruments.clearQuick();
+    file.deleteFile();
 }
 
+void Transport::invalidateFrozenInstruments(const MidiTrack *track)
+{
+    // any tempo change moves all the rendered audio, and so does
+    // any change in the sequences which is not tied to a single track
+    const bool invalidatesAll = track == nullptr ||
+        track->getTrackControllerNumber() == MidiTrack::tempoController;
+
+    const Instrument *instrument = invalidatesAll ?
+        nullptr : this->linksCache[track->getTrackId()].get();
+
+    if (invalidatesAll || this->isFreezingInstrument(instrument))
+    {
+        this->freezingWasInvalidated = this->freezingFile != File();
+    }
+
+    const ScopedLock lock(this->frozenInstrumentsLock);
+    if (invalidatesAll)
+    {
+        this->frozenInstruments.clear();
+    }
+    else
+    {
+        this->frozenInstruments.erase(instrument);
+    }
+}
+
+//===----------------------------------------------------------------------===//
+// Sending messages at real-time
+//===----------------------------------------------------------------------===//
+
+// The previews go through the instruments' own preview lanes, which keep
+// the order of the messages, unlike MidiMessageCollector, so the note-ons
+// and note-offs, sent quickly while dragging notes around, are never swapped,
+// and there's no need to delay them anymore: they'll play in the next block
 void Transport::previewMidiMessage(const String &trackId, const MidiMessage &message) const
 {
     this->sleepTimer.setAwake();
-    this->messagePreviewQueue.previewMessage(message, this->linksCache[trackId]);
+
+    if (Instrument *instrument = this->linksCache[trackId])
+    {
+        instrument->getProcessorPlayer().addPreviewMessage(message.withTimeStamp(TIME_NOW));
+    }
+
     this->sleepTimer.setCanSleepAfter(SOUND_SLEEP_DELAY_MS);
 }
 
 static void stopSoundForInstrument(Instrument *instrument)
 {
-    auto &collector = instrument->getProcessorPlayer().getMidiMessageCollector();
-    collector.addMessageToQueue(MidiMessage::allControllersOff(1).withTimeStamp(TIME_NOW));
-    collector.addMessageToQueue(MidiMessage::allNotesOff(1).withTimeStamp(TIME_NOW));
-    collector.addMessageToQueue(MidiMessage::allSoundOff(1).withTimeStamp(TIME_NOW));
+    auto &player = instrument->getProcessorPlayer();
+    player.addPreviewMessage(MidiMessage::allControllersOff(1).withTimeStamp(TIME_NOW));
+    player.addPreviewMessage(MidiMessage::allNotesOff(1).withTimeStamp(TIME_NOW));
+    player.addPreviewMessage(MidiMessage::allSoundOff(1).withTimeStamp(TIME_NOW));
 }
 
 void Transport::stopSound(const String &trackId) const
 {
     this->sleepTimer.setAwake();
-    this->messagePreviewQueue.cancelPendingPreview();
 
     if (Instrument *instrument = this->linksCache[trackId])
     {
@@ -375,7 +655,6 @@ void Transport::stopSound(const String &trackId) const
 void Transport::allNotesControllersAndSoundOff() const
 {
     this->sleepTimer.setAwake();
-    this->messagePreviewQueue.cancelPendingPreview();
 
     static const int c = 1;
     //for (int c = 1; c <= 16; ++c)
@@ -384,19 +663,20 @@ void Transport::allNotesControllersAndSoundOff() const
         const MidiMessage soundOff(MidiMessage::allSoundOff(c).withTimeStamp(TIME_NOW));
         const MidiMessage controllersOff(MidiMessage::allControllersOff(c).withTimeStamp(TIME_NOW));
         
-        Array<const MidiMessageCollector *> duplicateCollectors;
+        Array<Instrument *> duplicateInstruments;
         
         for (int l = 0; l < this->tracksCache.size(); ++l)
         {
             const auto &trackId = this->tracksCache.getUnchecked(l)->getTrackId();
-            auto *collector = &this->linksCache[trackId]->getProcessorPlayer().getMidiMessageCollector();
+            auto *instrument = this->linksCache[trackId].get();
             
-            if (! duplicateCollectors.contains(collector))
+            if (instrument != nullptr && !duplicateInstruments.contains(instrument))
             {
-                collector->addMessageToQueue(notesOff);
-                collector->addMessageToQueue(controllersOff);
-                collector->addMessageToQueue(soundOff);
-                duplicateCollectors.add(collector);
+                auto &player = instrument->getProcessorPlayer();
+                player.addPreviewMessage(notesOff);
+                player.addPreviewMessage(controllersOff);
+                player.addPreviewMessage(soundOff);
+                duplicateInstruments.add(instrument);
             }
         }
     }
@@ -427,6 +707,8 @@ void Transport::instrumentRemoved(Instrument *instrument)
     // the instrument stack have still not changed here,
     // so just stop the playback before it's too late
     this->stopPlayback();
+    this->probedNotes.clearQuick();
+    this->unfreezeInstrument(instrument);
 }
 
 void Transport::instrumentRemovedPostAction()
@@ -452,50 +734,55 @@ void Transport::instrumentRemovedPostAction()
 
 void Transport::onChangeMidiEvent(const MidiEvent &oldEvent, const MidiEvent &newEvent)
 {
-    // todo stop playback only if the event is in future
-    // and getTrackControllerNumber == 0 (not an automation)
-    this->stopPlayback();
+    this->updateOrStopPlayback(newEvent.getSequence()->getTrack());
     updateLengthAndTimeIfNeeded((&newEvent));
-    this->sequencesAreOutdated = true;
 }
 
 void Transport::onAddMidiEvent(const MidiEvent &event)
 {
-    // todo stop playback only if the event is in future
-    // and getTrackControllerNumber == 0 (not an automation)
-    this->stopPlayback();
+    this->updateOrStopPlayback(event.getSequence()->getTrack());
     updateLengthAndTimeIfNeeded((&event));
-    this->sequencesAreOutdated = true;
 }
 
 void Transport::onRemoveMidiEvent(const MidiEvent &event) {}
+
+// all events of a group edit belong to the same track:
+
+void Transport::onAddMidiEvents(const Array<const MidiEvent *> &events)
+{
+    if (events.isEmpty()) { return; }
+    this->onAddMidiEvent(*events.getFirst());
+}
+
+void Transport::onChangeMidiEvents(const Array<const MidiEvent *> &oldEvents,
+    const Array<const MidiEvent *> &newEvents)
+{
+    if (newEvents.isEmpty()) { return; }
+    this->onChangeMidiEvent(*oldEvents.getFirst(), *newEvents.getFirst());
+}
 void Transport::onPostRemoveMidiEvent(MidiSequence *const sequence)
 {
-    this->stopPlayback();
+    this->updateOrStopPlayback(sequence->getTrack());
     updateLengthAndTimeIfNeeded(sequence->getTrack());
-    this->sequencesAreOutdated = true;
 }
 
 void Transport::onAddClip(const Clip &clip)
 {
-    this->stopPlayback();
+    this->updateOrStopPlayback(clip.getPattern()->getTrack(), true);
     updateLengthAndTimeIfNeeded((&clip));
-    this->sequencesAreOutdated = true;
 }
 
 void Transport::onChangeClip(const Clip &oldClip, const Clip &newClip)
 {
-    this->stopPlayback();
+    this->updateOrStopPlayback(newClip.getPattern()->getTrack(), true);
     updateLengthAndTimeIfNeeded((&newClip));
-    this->sequencesAreOutdated = true;
 }
 
 void Transport::onRemoveClip(const Clip &clip) {}
 void Transport::onPostRemoveClip(Pattern *const pattern)
 {
-    this->stopPlayback();
+    this->updateOrStopPlayback(pattern->getTrack(), true);
     updateLengthAndTimeIfNeeded(pattern->getTrack());
-    this->sequencesAreOutdated = true;
 }
 
 void Transport::onChangeTrackProperties(MidiTrack *const track)
@@ -506,14 +793,17 @@ void Transport::onChangeTrackProperties(MidiTrack *const track)
         this->linksCache[trackId]->getInstrumentId() != track->getTrackInstrumentId())
     {
         this->stopPlayback();
-        this->sequencesAreOutdated = true;
+        this->invalidateFrozenInstruments(track);
         this->updateLinkForTrack(track);
+        this->setTrackOutdated(track);
     }
 }
 
 void Transport::onReloadProjectContent(const Array<MidiTrack *> &tracks)
 {
     this->sequencesAreOutdated = true;
+    this->outdatedTracks.clearQuick();
+    this->tracksWithOutdatedClips.clearQuick();
 
     this->tracksCache.clearQuick();
     this->linksCache.clear();
@@ -531,17 +821,20 @@ void Transport::onAddTrack(MidiTrack *const track)
 {
     this->stopPlayback();
     
-    this->sequencesAreOutdated = true;
     this->tracksCache.addIfNotAlreadyThere(track);
     this->updateLinkForTrack(track);
+    this->setTrackOutdated(track);
 }
 
 void Transport::onRemoveTrack(MidiTrack *const track)
 {
     this->stopPlayback();
     
-    this->sequencesAreOutdated = true;
     this->tracksCache.removeAllInstancesOf(track);
+    this->outdatedTracks.removeAllInstancesOf(track);
+    this->tracksWithOutdatedClips.removeAllInstancesOf(track);
+    this->playbackCache.removeAllFor(track->getSequence());
+    this->invalidateFrozenInstruments(track);
     this->removeLinkForTrack(track);
 }
 
@@ -588,106 +881,373 @@ void Transport::calcTimeAndTempoAt(const double targetAbsPosition,
                                    double &outTimeMs, double &outTempo)
 {
     this->recacheIfNeeded();
-    this->playbackCache.seekToZeroIndexes();
-    
+
     const double targetTime = targetAbsPosition * this->getTotalTime();
-    
-    outTimeMs = 0.0;
-    outTempo = 500.0; // default 120 BPM
-    
-    double prevTimestamp = 0.0;
-    double nextEventTimeDelta = 0.0;
-    bool foundFirstTempoEvent = false;
-    
-    CachedMidiMessage cached;
-    
-    while (this->playbackCache.getNextMessage(cached))
-    {
-        const double nextAbsPosition = cached.message.getTimeStamp() / this->getTotalTime();
-        
-        // first tempo event sets the tempo all the way before it
-        if (nextAbsPosition > targetAbsPosition && foundFirstTempoEvent) { break; }
-        
-        nextEventTimeDelta = outTempo * (cached.message.getTimeStamp() - prevTimestamp);
-        outTimeMs += nextEventTimeDelta;
-        prevTimestamp = cached.message.getTimeStamp();
-        
-        if (cached.message.isTempoMetaEvent())
-        {
-            outTempo = cached.message.getTempoSecondsPerQuarterNote() * 1000.f;
-            foundFirstTempoEvent = true;
-        }
-    }
-    
-    nextEventTimeDelta = outTempo * (targetTime - prevTimestamp);
-    outTimeMs += nextEventTimeDelta;
+
+    const SpinLock::ScopedLockType lock(this->tempoMapLock);
+    this->tempoMap.getTimeAndTempoAt(targetTime, outTimeMs, outTempo);
 }
 
 MidiMessage Transport::findFirstTempoEvent()
 {
     this->recacheIfNeeded();
-    this->playbackCache.seekToZeroIndexes();
-    
-    CachedMidiMessage wrapper;
-    
-    while (this->playbackCache.getNextMessage(wrapper))
+
+    const SpinLock::ScopedLockType lock(this->tempoMapLock);
+    const double msPerQuarter = this->tempoMap.getFirstMsPerQuarter();
+    return MidiMessage::tempoMetaEvent(int(msPerQuarter * 1000.0));
+}
+
+void Transport::setTimeSignaturesTrack(const MidiTrack *track)
+{
+    this->timeSignaturesTrack = track;
+    if (track != nullptr)
     {
-        if (wrapper.message.isTempoMetaEvent())
-        {
-            return wrapper.message;
-        }
+        this->setTrackOutdated(track);
     }
-    
-    // return default 120 bpm (== 500 ms per quarter note)
-    return MidiMessage::tempoMetaEvent(500 * 1000);
+}
+
+//===----------------------------------------------------------------------===//
+// Suspending
+//===----------------------------------------------------------------------===//
+
+void Transport::suspend()
+{
+    if (this->suspended)
+    {
+        return;
+    }
+
+    this->stopPlayback();
+    this->stopSoundProbe();
+
+    // instruments added or removed meanwhile are picked up on resume,
+    // and the frozen audio is dropped, since it's keyed by instruments
+    this->orchestra.removeOrchestraListener(this);
+    this->invalidateFrozenInstruments(nullptr);
+
+    {
+        const SpinLock::ScopedLockType lock(this->sequencesLock);
+        this->playbackCache.clear();
+    }
+
+    this->outdatedTracks.clearQuick();
+    this->tracksWithOutdatedClips.clearQuick();
+    this->sequencesAreOutdated = true;
+    this->suspended = true;
+}
+
+void Transport::resume()
+{
+    if (!this->suspended)
+    {
+        return;
+    }
+
+    this->suspended = false;
+    this->orchestra.addOrchestraListener(this);
+
+    for (const auto *track : this->tracksCache)
+    {
+        this->updateLinkForTrack(track);
+    }
+}
+
+bool Transport::isSuspended() const noexcept
+{
+    return this->suspended;
 }
 
 //===----------------------------------------------------------------------===//
 // Playback cache management
 //===----------------------------------------------------------------------===//
 
+// a copy, so that the threads don't hold the lock while using it
+TempoMap Transport::getTempoMap() const
+{
+    const SpinLock::ScopedLockType lock(this->tempoMapLock);
+    return this->tempoMap;
+}
+
+Metronome::TimeSignatures Transport::getTimeSignatures() const
+{
+    const SpinLock::ScopedLockType lock(this->tempoMapLock);
+    return this->timeSignatures;
+}
+
 void Transport::recacheIfNeeded()
 {
+    if (!this->sequencesAreOutdated &&
+        this->outdatedTracks.isEmpty() &&
+        this->tracksWithOutdatedClips.isEmpty())
+    {
+        return;
+    }
+
+    jassert(!this->isPlaying() || this->player->canUpdatePlayback());
+
+    const double offset = -this->trackStartMs.get();
+
+    // Find solo clips, if any
+    bool hasSoloClips = false;
+    for (const auto *track : this->tracksCache)
+    {
+        if (track->getPattern() != nullptr &&
+            track->getPattern()->hasSoloClips())
+        {
+            hasSoloClips = true;
+            break;
+        }
+    }
+
+    // soloing affects all the tracks, and so does the offset
+    if (hasSoloClips != this->cacheHasSoloClips || offset != this->cacheOffset)
+    {
+        this->sequencesAreOutdated = true;
+    }
+
+    // the tracks to re-export, all at once, see exportTracks
+    Array<const MidiTrack *> tracksToExport;
+
     if (this->sequencesAreOutdated)
     {
-        jassert(!this->isPlaying());
+        this->invalidateFrozenInstruments(nullptr);
         this->playbackCache.clear();
-        static Clip noTransform;
-        const double offset = -this->trackStartMs.get();
-
-        // Find solo clips, if any
-        bool hasSoloClips = false;
-        for (const auto *track : this->tracksCache)
+        tracksToExport.addArray(this->tracksCache);
+    }
+    else
+    {
+        for (const auto *track : this->outdatedTracks)
         {
-            if (track->getPattern() != nullptr &&
-                track->getPattern()->hasSoloClips())
+            this->playbackCache.removeAllFor(track->getSequence());
+            if (this->tracksCache.contains(track))
             {
-                hasSoloClips = true;
-                break;
+                tracksToExport.add(track);
             }
         }
 
-        for (const auto *track : this->tracksCache)
+        // clip changes don't need re-exporting the sequence, unless its
+        // wrapper was not cached at all, e.g. when all clips were muted:
+        for (const auto *track : this->tracksWithOutdatedClips)
         {
-            const auto instrument = this->linksCache[track->getTrackId()];
-            auto cached = CachedMidiSequence::createFrom(instrument, track->getSequence());
-
-            if (track->getPattern() != nullptr)
+            if (this->outdatedTracks.contains(track) || !this->tracksCache.contains(track))
             {
-                for (const auto *clip : track->getPattern()->getClips())
-                {
-                    cached->track->exportMidi(cached->midiMessages, *clip, hasSoloClips, offset, 1.0);
-                }
+                continue;
             }
-            else
+
+            const auto clips = this->getClipInstances(track, hasSoloClips, offset);
+            if (!this->playbackCache.updateClipsFor(track->getSequence(), clips))
             {
-                cached->track->exportMidi(cached->midiMessages, noTransform, hasSoloClips, offset, 1.0);
+                this->playbackCache.removeAllFor(track->getSequence());
+                tracksToExport.add(track);
             }
+        }
+    }
+
+    for (auto &cached : this->exportTracks(tracksToExport, hasSoloClips, offset))
+    {
+        this->playbackCache.addWrapper(cached);
+    }
+
+    this->outdatedTracks.clearQuick();
+    this->tracksWithOutdatedClips.clearQuick();
+    this->sequencesAreOutdated = false;
+    this->cacheHasSoloClips = hasSoloClips;
+    this->cacheOffset = offset;
+
+    TempoMap newTempoMap;
+    newTempoMap.rebuild(this->playbackCache);
 
-            this->playbackCache.addWrapper(cached);
+    // the signatures are sorted by beat, as all sequences are
+    Metronome::TimeSignatures newTimeSignatures;
+    if (this->timeSignaturesTrack != nullptr)
+    {
+        for (const auto *event : *this->timeSignaturesTrack->getSequence())
+        {
+            const auto *signature = static_cast<const TimeSignatureEvent *>(event);
+            newTimeSignatures.add({ double(signature->getBeat()) + offset,
+                signature->getNumerator(), signature->getDenominator() });
         }
-        
-        this->sequencesAreOutdated = false;
+    }
+
+    const SpinLock::ScopedLockType lock(this->tempoMapLock);
+    this->tempoMap.swapWith(newTempoMap);
+    this->timeSignatures.swapWith(newTimeSignatures);
+}
+
+// The sequences have lazy caches which are only built on the message thread,
+// so what's read from them is taken here: the notes' snapshots, or the exported
+// automation events, and the clip instances; then the notes are exported,
+// sorted and paired for all tracks in parallel, which is most of the work
+Array<CachedMidiSequence::Ptr> Transport::exportTracks(const Array<const MidiTrack *> &tracks,
+    bool hasSoloClips, double offset) const
+{
+    static Clip noTransform;
+
+    Array<CachedMidiSequence::Ptr> result;
+    Array<PianoSequence::Snapshot::Ptr> snapshots;
+    OwnedArray<MidiExportBuffer> buffers;
+
+    for (const auto *track : tracks)
+    {
+        const auto instrument = this->linksCache[track->getTrackId()];
+        auto cached = CachedMidiSequence::createFrom(instrument, track->getSequence());
+        cached->clips = this->getClipInstances(track, hasSoloClips, offset);
+
+        // the sequence is exported only once, the clips are applied while reading:
+        auto *buffer = buffers.add(new MidiExportBuffer());
+        buffer->ensureStorageAllocated(cached->track->size() * 2);
+
+        const auto *piano = dynamic_cast<const PianoSequence *>(cached->track);
+        const auto *automation = dynamic_cast<const AutomationSequence *>(cached->track);
+        if (piano != nullptr)
+        {
+            snapshots.add(piano->getSnapshot());
+        }
+        else if (automation != nullptr && track->isTempoTrack())
+        {
+            // the ramps between the tempo events are up to the tempo map
+            automation->exportKeyEvents(*buffer, noTransform, false, 0.0, 1.0);
+            snapshots.add(nullptr);
+        }
+        else
+        {
+            cached->track->exportMidi(*buffer, noTransform, false, 0.0, 1.0);
+            snapshots.add(nullptr);
+        }
+
+        result.add(cached);
+    }
+
+    App::Tasks().parallelFor(result.size(), [&](int i)
+    {
+        auto *buffer = buffers.getUnchecked(i);
+        if (const auto snapshot = snapshots[i])
+        {
+            snapshot->exportMidi(*buffer, noTransform, false, 0.0, 1.0);
+        }
+
+        buffer->flush(result.getUnchecked(i)->midiMessages);
+    });
+
+    return result;
+}
+
+Array<CachedMidiSequence::ClipInstance> Transport::getClipInstances(const MidiTrack *track,
+    bool hasSoloClips, double offset) const
+{
+    Array<CachedMidiSequence::ClipInstance> result;
+    const auto *sequence = track->getSequence();
+
+    if (const auto *pattern = track->getPattern())
+    {
+        for (const auto *clip : pattern->getClips())
+        {
+            if (sequence->isClipAudible(*clip, hasSoloClips))
+            {
+                result.add({ double(clip->getBeat()) + offset,
+                    clip->getKey(), clip->getVelocity() });
+            }
+        }
+    }
+    else
+    {
+        result.add({ offset, 0, 1.f });
+    }
+
+    return result;
+}
+
+void Transport::setTrackOutdated(const MidiTrack *track)
+{
+    this->invalidateFrozenInstruments(track);
+
+    if (track != nullptr)
+    {
+        this->outdatedTracks.addIfNotAlreadyThere(track);
+    }
+    else
+    {
+        this->sequencesAreOutdated = true;
+    }
+}
+
+void Transport::setTrackOutdated(const MidiSequence *sequence)
+{
+    this->setTrackOutdated(sequence != nullptr ? sequence->getTrack() : nullptr);
+}
+
+void Transport::setTrackOutdated(const Pattern *pattern)
+{
+    this->setTrackOutdated(pattern != nullptr ? pattern->getTrack() : nullptr);
+}
+
+void Transport::setClipsOutdated(const Pattern *pattern)
+{
+    const auto *track = pattern != nullptr ? pattern->getTrack() : nullptr;
+    this->invalidateFrozenInstruments(track);
+
+    if (track != nullptr)
+    {
+        this->tracksWithOutdatedClips.addIfNotAlreadyThere(track);
+    }
+    else
+    {
+        this->sequencesAreOutdated = true;
+    }
+}
+
+void Transport::updateOrStopPlayback(const MidiTrack *track, bool onlyClipsChanged)
+{
+    if (onlyClipsChanged && track != nullptr)
+    {
+        this->setClipsOutdated(track->getPattern());
+    }
+    else
+    {
+        this->setTrackOutdated(track);
+    }
+
+    if (!this->isPlaying())
+    {
+        return;
+    }
+
+    if (track != nullptr &&
+        track->getTrackControllerNumber() != MidiTrack::tempoController &&
+        this->player->canUpdatePlayback())
+    {
+        // batch all the changes made within one message loop iteration
+        this->triggerAsyncUpdate();
+    }
+    else
+    {
+        this->stopPlayback();
+    }
+}
+
+void Transport::handleAsyncUpdate()
+{
+    if (this->renderHasFinished.compareAndSetBool(false, true))
+    {
+        this->finishFreezing();
+    }
+
+    if (!this->isPlaying())
+    {
+        return; // will recache on the next playback
+    }
+
+    if (!this->player->canUpdatePlayback())
+    {
+        this->stopPlayback();
+        return;
+    }
+
+    this->recacheIfNeeded();
+
+    if (!this->player->updatePlayback(this->playbackCache))
+    {
+        this->stopPlayback();
     }
 }
 
@@ -754,6 +1314,7 @@ void Transport::removeTransportListener(TransportListener *listener)
 void Transport::broadcastSeek(const double newPosition,
     const double currentTimeMs, const double totalTimeMs)
 {
+    this->lastBroadcastPosition = newPosition;
     this->transportListeners.call(&TransportListener::onSeek,
         newPosition, currentTimeMs, totalTimeMs);
 }
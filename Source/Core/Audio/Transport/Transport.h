@@ -17,25 +17,35 @@
 
 #pragma once
 
+class AudioClock;
 class SleepTimer;
 class OrchestraPit;
 class PlayerThread;
-class PlayerThreadPool;
 class RendererThread;
+class AuditionPlayer;
 
 #include "TransportListener.h"
 #include "ProjectSequencesWrapper.h"
+#include "TempoMap.h"
+#include "Metronome.h"
+#include "MidiSyncOutput.h"
+#include "AudioRecorder.h"
+#include "RenderOptions.h"
+#include "FrozenAudio.h"
 #include "ProjectListener.h"
 #include "OrchestraListener.h"
 #include "Instrument.h"
 
 class Transport final : public Serializable,
                         public ProjectListener,
-                        private OrchestraListener
+                        private OrchestraListener,
+                        private AsyncUpdater
 {
 public:
 
-    Transport(OrchestraPit &orchestraPit, SleepTimer &sleepTimer);
+    Transport(OrchestraPit &orchestraPit, SleepTimer &sleepTimer,
+        const AudioClock &audioClock, Metronome &metronome,
+        MidiSyncOutput &syncOutput, AudioRecorder &audioRecorder);
     ~Transport() override;
     
     static String getTimeString(double timeMs, bool includeMilliseconds = false);
@@ -51,31 +61,70 @@ public:
     
     double getSeekPosition() const noexcept;
     double getTotalTime() const noexcept;
+
+    // The position to draw the playhead at, lock-free and safe to call from any thread:
+    // while playing, it is extrapolated from the last anchor published by the player
+    // thread by the samples processed since then (or by the system time, if the audio
+    // device isn't running), otherwise it's just the last broadcast seek position
+    double getPlaybackPosition() const noexcept;
+
+    // The same, but in the project beats, e.g. to timestamp the live input
+    double getPlaybackBeat() const noexcept;
     void seekToPosition(double absPosition);
     
+    // Only sends the difference with the notes sounding at the last probed
+    // position, so that scrubbing doesn't re-trigger the notes held across
     void probeSoundAt(double absTrackPosition, 
         const MidiSequence *limitToLayer = nullptr);
+    void stopSoundProbe();
     
-    void probeSequence(const MidiMessageSequence &sequence);
-
-    void startPlayback();
+    // Plays the sequence alone, as if it started from the seek position,
+    // through the track's instrument, or the last instrument if none given;
+    // the time stamps are in beats, and the playback cache is left intact
+    void probeSequence(const MidiMessageSequence &sequence,
+        const MidiTrack *track = nullptr);
+    bool isProbingSequence() const;
+
+    // The count-in is for recording, and only if the metronome is on
+    void startPlayback(bool withCountIn = false);
     void startPlaybackFragment(double absStart, double absEnd, bool looped = false);
 
     bool isPlaying() const;
     void stopPlayback();
     void toggleStartStopPlayback();
 
-    void startRender(const String &filename);
+    void startRender(const String &filename, const RenderOptions &options = {});
     bool isRendering() const;
+    bool hasRenderFailed() const;
     void stopRender();
     
     float getRenderingPercentsComplete() const;
+    double getRenderingRealtimeRatio() const;
+    double getRenderingTimeLeftMs() const;
+
+    // Renders the instrument's output in the background and plays that
+    // instead of processing it, until any of its tracks is changed
+    void freezeInstrument(Instrument *instrument);
+    void unfreezeInstrument(Instrument *instrument);
+    bool isInstrumentFrozen(const Instrument *instrument) const;
+    bool isFreezingInstrument(const Instrument *instrument) const;
     
     void calcTimeAndTempoAt(const double absPosition,
         double &outTimeMs, double &outTempo);
 
     MidiMessage findFirstTempoEvent();
 
+    // The metronome follows the project's time signatures, which
+    // are not in the playback cache, since nothing plays them
+    void setTimeSignaturesTrack(const MidiTrack *track);
+
+    // While the project is in the background, the transport doesn't
+    // listen to the orchestra and keeps no playback cache; it's all
+    // rebuilt on resume, or lazily, on the next playback start
+    void suspend();
+    void resume();
+    bool isSuspended() const noexcept;
+
     //===------------------------------------------------------------------===//
     // Sending messages in real-time
     //===------------------------------------------------------------------===//
@@ -101,6 +150,9 @@ public:
         const MidiEvent &newEvent) override;
     void onAddMidiEvent(const MidiEvent &event) override;
     void onRemoveMidiEvent(const MidiEvent &event) override;
+    void onAddMidiEvents(const Array<const MidiEvent *> &events) override;
+    void onChangeMidiEvents(const Array<const MidiEvent *> &oldEvents,
+        const Array<const MidiEvent *> &newEvents) override;
     void onPostRemoveMidiEvent(MidiSequence *const layer) override;
 
     void onAddClip(const Clip &clip) override;
@@ -143,13 +195,24 @@ protected:
     void broadcastSeek(const double newPosition,
         const double currentTimeMs, const double totalTimeMs);
 
+    // called by the player thread only, the clock position is either
+    // the audio clock's sample position, or the system time in ms
+    void setPlaybackAnchor(double clockPosition, bool usesAudioClock,
+        double timeStamp, double msPerQuarter, double endTimeStamp) noexcept;
+    void resetPlaybackAnchor() noexcept;
+
 private:
     
     OrchestraPit &orchestra;
     SleepTimer &sleepTimer;
+    const AudioClock &audioClock;
+    Metronome &metronome;
+    MidiSyncOutput &syncOutput;
+    AudioRecorder &audioRecorder;
 
-    UniquePointer<PlayerThreadPool> player;
+    UniquePointer<PlayerThread> player;
     UniquePointer<RendererThread> renderer;
+    UniquePointer<AuditionPlayer> audition;
 
     friend class RendererThread;
     friend class PlayerThread;
@@ -157,11 +220,61 @@ private:
 private:
 
     ProjectSequences &getPlaybackCache();
+    TempoMap getTempoMap() const;
+    Metronome::TimeSignatures getTimeSignatures() const;
     void recacheIfNeeded();
-    
+    Array<CachedMidiSequence::Ptr> exportTracks(const Array<const MidiTrack *> &tracks,
+        bool hasSoloClips, double offset) const;
+    Array<CachedMidiSequence::ClipInstance> getClipInstances(const MidiTrack *track,
+        bool hasSoloClips, double offset) const;
+
+    void setTrackOutdated(const MidiTrack *track);
+    void setTrackOutdated(const MidiSequence *sequence);
+    void setTrackOutdated(const Pattern *pattern);
+    void setClipsOutdated(const Pattern *pattern);
+
+    // Edits made during the playback are applied on the fly, when possible,
+    // by re-exporting the changed track (or only updating its clip instances,
+    // if the sequence itself hasn't changed) and swapping the playback schedule;
+    // tempo changes and structural changes still stop the playback
+    void updateOrStopPlayback(const MidiTrack *track, bool onlyClipsChanged = false);
+    void handleAsyncUpdate() override;
+
+    // called by the renderer thread when it's done
+    void onRenderFinished(bool isComplete);
+    void finishFreezing();
+
+    FrozenAudio::Map getFrozenInstruments() const;
+    void invalidateFrozenInstruments(const MidiTrack *track);
+
+    CriticalSection frozenInstrumentsLock;
+    FrozenAudio::Map frozenInstruments;
+
+    WeakReference<Instrument> freezingInstrument;
+    File freezingFile;
+    bool freezingWasInvalidated = false;
+    Atomic<bool> renderHasFinished = false;
+    Atomic<bool> renderIsComplete = false;
+
     SpinLock sequencesLock;
     ProjectSequences playbackCache;
+
+    // the full recache is needed when instruments change, or solo clips
+    // toggle, or the track start offset moves; otherwise only the tracks
+    // that have changed are re-exported, and the tracks with only their
+    // clips changed just update the clip instances of the cached sequence:
     bool sequencesAreOutdated = true;
+    bool suspended = false;
+    Array<const MidiTrack *> outdatedTracks;
+    Array<const MidiTrack *> tracksWithOutdatedClips;
+    bool cacheHasSoloClips = false;
+    double cacheOffset = 0.0;
+
+    // rebuilt along with the playback cache
+    SpinLock tempoMapLock;
+    TempoMap tempoMap;
+    Metronome::TimeSignatures timeSignatures;
+    const MidiTrack *timeSignaturesTrack = nullptr;
     
     // linksCache is <track id : instrument>
     mutable Array<const MidiTrack *> tracksCache;
@@ -169,33 +282,25 @@ private:
 
     void updateLinkForTrack(const MidiTrack *track);
     void removeLinkForTrack(const MidiTrack *track);
-    
-private:
 
-    /*
-        The purpose of this class is to help with previewing messages on the fly in piano roll.
-        Will simply send messages to queue after a delay, and cancels all pending messages when
-        someone calls allNotesControllersAndSoundOff(); that delay is needed because some plugins
-        (e.g. Kontakt in my case) are often processing play/stop messages out of order, which is weird -
-        note the word `queue` in addMessageToQueue() method name - but it still happens in some cases,
-        for example, when a user drags some notes around quickly. Said that, for whatever reason,
-        JUCE's message collector cannot be relied upon, and this hack is used instead.
-    */
-    class MidiMessageDelayedPreview final : private Timer
+    // the notes sounding at the last probed position
+    struct ProbedNote final
     {
-    public:
-        MidiMessageDelayedPreview() = default;
-        ~MidiMessageDelayedPreview();
-        void cancelPendingPreview();
-        void previewMessage(const MidiMessage &message, WeakReference<Instrument> instrument);
-    private:
-        void timerCallback() override;
-        Array<WeakReference<Instrument>> instruments;
-        Array<MidiMessage> messages;
+        CachedMidiSequence::Ptr sequence;
+        int clipIndex;
+        int noteOnIndex;
+
+        bool operator== (const ProbedNote &other) const noexcept
+        {
+            return this->sequence == other.sequence &&
+                this->clipIndex == other.clipIndex &&
+                this->noteOnIndex == other.noteOnIndex;
+        }
     };
 
-    mutable MidiMessageDelayedPreview messagePreviewQueue;
-
+    Array<ProbedNote> probedNotes;
+    static void sendProbedNote(const ProbedNote &note, bool isNoteOn);
+    
 private:
 
     Atomic<double> seekPosition = 0.0;
@@ -207,6 +312,18 @@ private:
     Atomic<float> projectFirstBeat = 0.f;
     Atomic<float> projectLastBeat = PROJECT_DEFAULT_NUM_BEATS;
 
+    Atomic<double> lastBroadcastPosition = 0.0;
+
+    // the anchor is a seqlock: the version is odd while the player thread writes,
+    // and the readers retry, if it has changed while they were reading
+    Atomic<int> playbackAnchorVersion = 0;
+    Atomic<bool> hasPlaybackAnchor = false;
+    Atomic<bool> anchorUsesAudioClock = false;
+    Atomic<double> anchorClockPosition = 0.0;
+    Atomic<double> anchorTimeStamp = 0.0;
+    Atomic<double> anchorMsPerQuarter = 1.0;
+    Atomic<double> anchorEndTimeStamp = 0.0;
+
     ListenerList<TransportListener> transportListeners;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Transport)
@@ -0,0 +1,449 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Common.h"
+#include "Benchmarks.h"
+
+#if JUCE_UNIT_TESTS
+
+#include "ProjectNode.h"
+#include "PianoTrackNode.h"
+#include "AutomationTrackNode.h"
+#include "Pattern.h"
+#include "MidiTrack.h"
+#include "PianoSequence.h"
+#include "AutomationSequence.h"
+#include "VersionControl.h"
+#include "BinarySerializer.h"
+#include "DocumentHelpers.h"
+#include "Transport.h"
+
+#define BENCHMARKS_FLAG "--benchmarks"
+#define BENCHMARKS_RESULTS_FILE "benchmarks.json"
+
+// the generated projects are the same every time
+#define BENCHMARKS_RANDOM_SEED (123456)
+
+#define BENCHMARKS_NUM_ITERATIONS (10)
+#define BENCHMARKS_NUM_TEMPO_LOOKUPS (1000)
+
+struct BenchmarkResult final
+{
+    String name;
+    String size;
+    int numIterations;
+    double medianMs;
+    double minMs;
+};
+
+static Array<BenchmarkResult> &getBenchmarkResults()
+{
+    static Array<BenchmarkResult> results;
+    return results;
+}
+
+Benchmark::Benchmark(const String &name) :
+    UnitTest(name, UnitTestCategories::benchmarks) {}
+
+bool Benchmark::isBenchmarkCommandLine(const String &commandLine)
+{
+    return StringArray::fromTokens(commandLine, true).contains(BENCHMARKS_FLAG);
+}
+
+File Benchmark::getResultsFile(const String &commandLine)
+{
+    const auto args = StringArray::fromTokens(commandLine, true);
+    const auto flagIndex = args.indexOf(BENCHMARKS_FLAG);
+    const auto workingDirectory = File::getCurrentWorkingDirectory();
+
+    if (flagIndex >= 0 && flagIndex + 1 < args.size() &&
+        !args[flagIndex + 1].startsWith("--"))
+    {
+        return workingDirectory.getChildFile(args[flagIndex + 1].unquoted());
+    }
+
+    return workingDirectory.getChildFile(BENCHMARKS_RESULTS_FILE);
+}
+
+File Benchmark::saveResults(const String &commandLine)
+{
+    Array<var> results;
+    for (const auto &result : getBenchmarkResults())
+    {
+        DynamicObject::Ptr json(new DynamicObject());
+        json->setProperty("name", result.name);
+        json->setProperty("size", result.size);
+        json->setProperty("iterations", result.numIterations);
+        json->setProperty("medianMs", result.medianMs);
+        json->setProperty("minMs", result.minMs);
+        results.add(var(json.get()));
+    }
+
+    DynamicObject::Ptr root(new DynamicObject());
+    root->setProperty("version", App::getAppReadableVersion());
+    root->setProperty("date", Time::getCurrentTime().toISO8601(true));
+    root->setProperty("operatingSystem", SystemStats::getOperatingSystemName());
+    root->setProperty("numCpus", SystemStats::getNumCpus());
+    root->setProperty("results", results);
+
+    const auto resultsFile = Benchmark::getResultsFile(commandLine);
+    resultsFile.replaceWithText(JSON::toString(var(root.get())));
+    return resultsFile;
+}
+
+void Benchmark::addResult(const String &caseName,
+    const ProjectSize &size, Array<double> &timesMs)
+{
+    jassert(!timesMs.isEmpty());
+    std::sort(timesMs.begin(), timesMs.end());
+
+    const auto sizeString = size.toString();
+    const auto medianMs = timesMs[timesMs.size() / 2];
+    getBenchmarkResults().add({ caseName, sizeString,
+        timesMs.size(), medianMs, timesMs.getFirst() });
+
+    this->logMessage(caseName + " [" + sizeString + "]: " +
+        String(medianMs, 3) + " ms median, " +
+        String(timesMs.getFirst(), 3) + " ms min");
+}
+
+String Benchmark::ProjectSize::toString() const
+{
+    return String(this->numTracks) + "x" +
+        String(this->numNotesPerTrack) + "x" +
+        String(this->numClipsPerTrack);
+}
+
+Array<Benchmark::ProjectSize> Benchmark::getProjectSizes()
+{
+    return {
+        { 4, 250, 4 },
+        { 16, 1000, 8 },
+        { 64, 2000, 16 }
+    };
+}
+
+UniquePointer<ProjectNode> Benchmark::createSyntheticProject(const ProjectSize &size)
+{
+    const auto file = DocumentHelpers::getTempSlot("benchmark-" + size.toString() + ".helio");
+    file.deleteFile();
+
+    auto project = makeUnique<ProjectNode>(file);
+    Random random(BENCHMARKS_RANDOM_SEED);
+
+    float projectLength = 0.f;
+
+    for (int i = 0; i < size.numTracks; ++i)
+    {
+        auto *track = new PianoTrackNode("Track " + String(i));
+        project->addChildNode(track);
+
+        auto *sequence = static_cast<PianoSequence *>(track->getSequence());
+
+        // some chords, some melodies, some overlaps
+        float beat = 0.f;
+        Array<Note> notes;
+        notes.ensureStorageAllocated(size.numNotesPerTrack);
+        for (int j = 0; j < size.numNotesPerTrack; ++j)
+        {
+            const auto key = MIDDLE_C - 24 + random.nextInt(48);
+            const auto length = float(1 + random.nextInt(8)) / 4.f;
+            const auto velocity = 0.25f + random.nextFloat() * 0.5f;
+            notes.add(Note(sequence, key, beat, length, velocity));
+            beat += float(random.nextInt(4)) / 4.f;
+        }
+
+        sequence->insertGroup(notes, false);
+
+        const auto clipLength = (floorf(beat / BEATS_PER_BAR) + 1.f) * BEATS_PER_BAR;
+        Array<Clip> clips;
+        for (int k = 0; k < size.numClipsPerTrack; ++k)
+        {
+            clips.add(Clip(track->getPattern(), clipLength * float(k)));
+        }
+
+        track->getPattern()->insertGroup(clips, false);
+        projectLength = jmax(projectLength, clipLength * float(size.numClipsPerTrack));
+    }
+
+    // a tempo change in every bar makes the time lookups do some work
+    auto *tempoTrack = new AutomationTrackNode("Tempo");
+    tempoTrack->getPattern()->insert(Clip(tempoTrack->getPattern()), false);
+    tempoTrack->setTrackControllerNumber(MidiTrack::tempoController, false);
+    project->addChildNode(tempoTrack);
+
+    auto *tempoSequence = static_cast<AutomationSequence *>(tempoTrack->getSequence());
+    Array<AutomationEvent> tempoEvents;
+    for (float beat = 0.f; beat < projectLength; beat += BEATS_PER_BAR)
+    {
+        tempoEvents.add(AutomationEvent(tempoSequence, beat, 0.25f + random.nextFloat() * 0.5f));
+    }
+
+    tempoSequence->insertGroup(tempoEvents, false);
+
+    project->broadcastReloadProjectContent();
+    project->broadcastChangeProjectBeatRange();
+    return project;
+}
+
+//===----------------------------------------------------------------------===//
+// Benchmarks
+//===----------------------------------------------------------------------===//
+
+class TransportBenchmarks final : public Benchmark
+{
+public:
+    TransportBenchmarks() : Benchmark("Transport benchmarks") {}
+
+    void runTest() override
+    {
+        beginTest("Playback cache and tempo map");
+
+        for (const auto &size : Benchmark::getProjectSizes())
+        {
+            auto project = Benchmark::createSyntheticProject(size);
+            auto &transport = project->getTransport();
+            const auto tracks = project->getTracks();
+
+            // recacheIfNeeded is private, but these are the paths which trigger it
+            this->measure("Transport::recacheIfNeeded, all tracks", size,
+                BENCHMARKS_NUM_ITERATIONS, [&]()
+            {
+                transport.onReloadProjectContent(tracks);
+                transport.findFirstTempoEvent();
+            });
+
+            auto *sequence = static_cast<PianoSequence *>(tracks.getFirst()->getSequence());
+            float delta = 1.f;
+            this->measure("Transport::recacheIfNeeded, one track", size,
+                BENCHMARKS_NUM_ITERATIONS, [&]()
+            {
+                const auto &note = static_cast<const Note &>(*sequence->getUnchecked(0));
+                sequence->change(note, note.withDeltaBeat(delta), false);
+                delta = -delta;
+                transport.findFirstTempoEvent();
+            });
+
+            double timeMs = 0.0;
+            double tempo = 0.0;
+            this->measure("Transport::calcTimeAndTempoAt x" +
+                String(BENCHMARKS_NUM_TEMPO_LOOKUPS), size,
+                BENCHMARKS_NUM_ITERATIONS, [&]()
+            {
+                for (int i = 0; i < BENCHMARKS_NUM_TEMPO_LOOKUPS; ++i)
+                {
+                    const auto position = double(i) / double(BENCHMARKS_NUM_TEMPO_LOOKUPS);
+                    transport.calcTimeAndTempoAt(position, timeMs, tempo);
+                }
+            });
+
+            expect(timeMs > 0.0);
+        }
+    }
+};
+
+static TransportBenchmarks transportBenchmarks;
+
+class PianoSequenceBenchmarks final : public Benchmark
+{
+public:
+    PianoSequenceBenchmarks() : Benchmark("Piano sequence benchmarks") {}
+
+    void runTest() override
+    {
+        beginTest("Group edits");
+
+        for (const auto &size : Benchmark::getProjectSizes())
+        {
+            auto project = Benchmark::createSyntheticProject(size);
+            auto *sequence = static_cast<PianoSequence *>(project->getTracks().getFirst()->getSequence());
+
+            Array<Note> notesBefore;
+            Array<Note> notesAfter;
+            for (const auto *event : *sequence)
+            {
+                const auto &note = static_cast<const Note &>(*event);
+                notesBefore.add(note);
+                notesAfter.add(note.withDeltaBeat(1.f));
+            }
+
+            // moving all notes back and forth, undoable, as the editors do
+            this->measure("PianoSequence::changeGroup", size,
+                BENCHMARKS_NUM_ITERATIONS, [&]()
+            {
+                sequence->changeGroup(notesBefore, notesAfter, true);
+                sequence->changeGroup(notesAfter, notesBefore, true);
+            });
+
+            expectEquals(sequence->size(), size.numNotesPerTrack);
+        }
+    }
+};
+
+static PianoSequenceBenchmarks pianoSequenceBenchmarks;
+
+class VersionControlBenchmarks final : public Benchmark
+{
+public:
+    VersionControlBenchmarks() : Benchmark("Version control benchmarks") {}
+
+    void runTest() override
+    {
+        beginTest("Head diffing");
+
+        for (const auto &size : Benchmark::getProjectSizes())
+        {
+            auto project = Benchmark::createSyntheticProject(size);
+
+            // a standalone vcs at the empty root revision,
+            // so that everything in the project is a new item
+            VersionControl vcs(*project);
+            auto &head = vcs.getHead();
+
+            this->measure("VCS::Head::rebuildDiff", size,
+                BENCHMARKS_NUM_ITERATIONS, [&]()
+            {
+                head.onReloadProjectContent({});
+                head.rebuildDiffSynchronously();
+            });
+
+            expect(head.hasAnythingOnTheStage());
+        }
+    }
+};
+
+static VersionControlBenchmarks versionControlBenchmarks;
+
+class SerializationBenchmarks final : public Benchmark
+{
+public:
+    SerializationBenchmarks() : Benchmark("Serialization benchmarks") {}
+
+    void runTest() override
+    {
+        beginTest("Binary serializer");
+
+        const BinarySerializer serializer;
+        const auto file = DocumentHelpers::getTempSlot("benchmark.bin");
+
+        for (const auto &size : Benchmark::getProjectSizes())
+        {
+            auto project = Benchmark::createSyntheticProject(size);
+
+            this->measure("BinarySerializer::saveToFile", size,
+                BENCHMARKS_NUM_ITERATIONS, [&]()
+            {
+                serializer.saveToFile(file, project->serialize());
+            });
+
+            SerializedData tree;
+            this->measure("BinarySerializer::loadFromFile", size,
+                BENCHMARKS_NUM_ITERATIONS, [&]()
+            {
+                tree = serializer.loadFromFile(file);
+            });
+
+            expect(tree.isValid());
+
+            this->measure("ProjectNode::deserialize", size,
+                BENCHMARKS_NUM_ITERATIONS, [&]()
+            {
+                project->deserialize(tree);
+            });
+
+            expectEquals(project->getTracks().size(), size.numTracks + 1);
+        }
+
+        file.deleteFile();
+    }
+};
+
+static SerializationBenchmarks serializationBenchmarks;
+
+class MidiBenchmarks final : public Benchmark
+{
+public:
+    MidiBenchmarks() : Benchmark("Midi import and export benchmarks") {}
+
+    void runTest() override
+    {
+        beginTest("Midi files");
+
+        auto midiFile = DocumentHelpers::getTempSlot("benchmark.mid");
+        const auto importFile = DocumentHelpers::getTempSlot("benchmark-import.helio");
+
+        for (const auto &size : Benchmark::getProjectSizes())
+        {
+            auto project = Benchmark::createSyntheticProject(size);
+
+            this->measure("ProjectNode::exportMidi", size,
+                BENCHMARKS_NUM_ITERATIONS, [&]()
+            {
+                project->exportMidi(midiFile);
+            });
+
+            expect(midiFile.getSize() > 0);
+
+            this->measure("ProjectNode::importMidi", size,
+                BENCHMARKS_NUM_ITERATIONS, [&]()
+            {
+                ProjectNode importedProject(importFile);
+                importedProject.importMidi(midiFile);
+            });
+        }
+
+        midiFile.deleteFile();
+        importFile.deleteFile();
+    }
+};
+
+static MidiBenchmarks midiBenchmarks;
+
+class RenderBenchmarks final : public Benchmark
+{
+public:
+    RenderBenchmarks() : Benchmark("Offline render benchmarks") {}
+
+    void runTest() override
+    {
+        beginTest("Offline render");
+
+        // rendering is slow enough, so only the smallest project is timed
+        const auto size = Benchmark::getProjectSizes().getFirst();
+        auto project = Benchmark::createSyntheticProject(size);
+        auto &transport = project->getTransport();
+
+        const auto file = DocumentHelpers::getTempSlot("benchmark.wav");
+
+        // the renderer thread waits for the message thread before starting
+        this->measure("Transport::startRender", size, 3, [&]()
+        {
+            transport.startRender(file.getFullPathName());
+            while (transport.isRendering())
+            {
+                MessageManager::getInstance()->runDispatchLoopUntil(5);
+            }
+        });
+
+        expect(!transport.hasRenderFailed());
+        file.deleteFile();
+    }
+};
+
+static RenderBenchmarks renderBenchmarks;
+
+#endif
@@ -0,0 +1,85 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#if JUCE_UNIT_TESTS
+
+class ProjectNode;
+
+/*
+    When the unit tests build is started with `--benchmarks [results file]`,
+    it runs the benchmarks category instead of the tests, with a headless
+    workspace (see Workspace::initHeadless), and saves the timings as json
+    into the given file, or into benchmarks.json in the working directory,
+    so that the results of the different releases can be compared by scripts.
+
+    Each benchmark is run on the synthetic projects of several sizes,
+    which are generated from a fixed seed, so they are the same every time.
+*/
+
+class Benchmark : public UnitTest
+{
+public:
+
+    explicit Benchmark(const String &name);
+
+    static bool isBenchmarkCommandLine(const String &commandLine);
+    static File getResultsFile(const String &commandLine);
+    static File saveResults(const String &commandLine);
+
+    struct ProjectSize final
+    {
+        int numTracks;
+        int numNotesPerTrack;
+        int numClipsPerTrack;
+
+        String toString() const;
+    };
+
+    static Array<ProjectSize> getProjectSizes();
+
+    // the project is owned by the caller and is never added to the workspace tree;
+    // its document lives in the temp folder, so that nothing is saved elsewhere
+    static UniquePointer<ProjectNode> createSyntheticProject(const ProjectSize &size);
+
+protected:
+
+    // the first call is only a warm-up, the others are timed,
+    // and the median and the minimum of them are reported
+    template <typename Fn>
+    void measure(const String &caseName, const ProjectSize &size, int numIterations, Fn &&fn)
+    {
+        fn();
+
+        Array<double> timesMs;
+        for (int i = 0; i < numIterations; ++i)
+        {
+            const auto startTimeMs = Time::getMillisecondCounterHiRes();
+            fn();
+            timesMs.add(Time::getMillisecondCounterHiRes() - startTimeMs);
+        }
+
+        this->addResult(caseName, size, timesMs);
+    }
+
+private:
+
+    void addResult(const String &caseName, const ProjectSize &size, Array<double> &timesMs);
+};
+
+#endif
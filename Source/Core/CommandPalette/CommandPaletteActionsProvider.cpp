@@ -17,10 +17,20 @@
 
 #include "Common.h"
 #include "CommandPaletteActionsProvider.h"
+#include "MessageThreadWatchdog.h"
+
+// the list box only shows about a dozen of rows at once,
+// and the rest of matches are sorted when scrolled to
+#define COMMAND_PALETTE_NUM_PRESORTED_ACTIONS (32)
 
 struct CommandPaletteActionSortByMatch final
 {
-    static int compareElements(const CommandPaletteAction::Ptr first, const CommandPaletteAction::Ptr second)
+    bool operator()(const CommandPaletteAction *first, const CommandPaletteAction *second) const noexcept
+    {
+        return compareElements(first, second) < 0;
+    }
+
+    static int compareElements(const CommandPaletteAction *first, const CommandPaletteAction *second) noexcept
     {
         // first, descending sort by match:
         const auto matchResult = int(second->getMatchScore() - first->getMatchScore());
@@ -55,7 +65,7 @@ CommandPaletteAction::Ptr CommandPaletteAction::unfiltered()
 {
     CommandPaletteAction::Ptr action(this);
     action->required = true;
-    action->setMatch(0, nullptr);
+    action->setMatch(0, nullptr, 0);
     return action;
 }
 
@@ -64,9 +74,31 @@ CommandPaletteAction::CommandPaletteAction(String text, String hint, float order
     hint(std::move(hint)),
     order(order) {}
 
-void CommandPaletteAction::setMatch(int score, const uint8 *matches)
+void CommandPaletteAction::setMatch(int score, const uint8 *matches, int numMatches)
 {
     this->matchScore = score;
+    this->matchedGlyphs.clearQuick();
+    if (matches != nullptr)
+    {
+        this->matchedGlyphs.addArray(matches, numMatches);
+    }
+
+    this->highlightedMatchIsOutdated = true;
+}
+
+int CommandPaletteAction::getMatchScore() const noexcept
+{
+    return this->matchScore;
+}
+
+const GlyphArrangement &CommandPaletteAction::getGlyphArrangement() const
+{
+    if (!this->highlightedMatchIsOutdated)
+    {
+        return this->highlightedMatch;
+    }
+
+    this->highlightedMatchIsOutdated = false;
     this->highlightedMatch.clear();
 
     static const Font fontNormal(21, Font::plain);
@@ -90,11 +122,11 @@ void CommandPaletteAction::setMatch(int score, const uint8 *matches)
         const auto thisX = xOffsets.getUnchecked(i);
 
         bool isMatchGlyph = false;
-        if (matches != nullptr && matches[nextMatch] == i)
+        if (nextMatch < this->matchedGlyphs.size() &&
+            this->matchedGlyphs.getUnchecked(nextMatch) == i)
         {
             isMatchGlyph = true;
             nextMatch++;
-            jassert(nextMatch < 32);
         }
 
         const bool isWhitespace = t.isWhitespace();
@@ -104,15 +136,7 @@ void CommandPaletteAction::setMatch(int score, const uint8 *matches)
             xOffset + thisX, yOffset, nextX - thisX,
             isWhitespace));
     }
-}
 
-int CommandPaletteAction::getMatchScore() const noexcept
-{
-    return this->matchScore;
-}
-
-const GlyphArrangement &CommandPaletteAction::getGlyphArrangement() const noexcept
-{
     return this->highlightedMatch;
 }
 
@@ -168,7 +192,7 @@ static bool fuzzyMatch(String::CharPointerType pattern, String::CharPointerType
 
 void CommandPaletteActionsProvider::updateFilter(const String &pattern, bool skipPrefix)
 {
-    this->filteredActions.clearQuick();
+    WATCHDOG_SCOPE("CommandPaletteActionsProvider::updateFilter");
 
     auto patternPtr = pattern.getCharPointer();
     if (skipPrefix)
@@ -176,7 +200,26 @@ void CommandPaletteActionsProvider::updateFilter(const String &pattern, bool ski
         patternPtr.getAndAdvance();
     }
 
-    for (const auto &action : this->getActions())
+    const String newPattern(patternPtr);
+    const auto numPatternChars = int(patternPtr.length());
+    const auto &allActions = this->getActions();
+
+    // anything matching the longer pattern also matches its beginning,
+    // so there's no need to check the actions that didn't match before
+    // (the unfiltered actions are always among the filtered ones)
+    const bool canNarrowDown = this->lastPattern.isNotEmpty() &&
+        this->lastNumActions == allActions.size() &&
+        newPattern.startsWith(this->lastPattern);
+
+    Actions previousMatches;
+    if (canNarrowDown)
+    {
+        previousMatches.swapWith(this->filteredActions);
+    }
+
+    this->filteredActions.clearQuick();
+
+    for (const auto &action : (canNarrowDown ? previousMatches : allActions))
     {
         if (action->isUnfiltered())
         {
@@ -189,27 +232,71 @@ void CommandPaletteActionsProvider::updateFilter(const String &pattern, bool ski
             const auto match = fuzzyMatch(patternPtr, action->getName().getCharPointer(), outScore, matches);
             if (match)
             {
-                action->setMatch(outScore, matches);
+                action->setMatch(outScore, matches, numPatternChars);
                 this->filteredActions.add(action);
             }
         }
     }
 
-    static CommandPaletteActionSortByMatch comparator;
-    this->filteredActions.sort(comparator);
+    this->lastPattern = newPattern;
+    this->lastNumActions = allActions.size();
+
+    this->numSortedActions = 0;
+    this->sortFilteredActionsUpTo(COMMAND_PALETTE_NUM_PRESORTED_ACTIONS - 1);
 }
 
 void CommandPaletteActionsProvider::clearFilter()
 {
+    this->resetIncrementalFilter();
+
     this->filteredActions.clearQuick();
     this->filteredActions.addArray(this->getActions());
+
     for (const auto &action : this->filteredActions)
     {
-        action->setMatch(0, nullptr);
+        action->setMatch(0, nullptr, 0);
+    }
+
+    this->numSortedActions = 0;
+    this->sortFilteredActionsUpTo(COMMAND_PALETTE_NUM_PRESORTED_ACTIONS - 1);
+}
+
+void CommandPaletteActionsProvider::resetIncrementalFilter() noexcept
+{
+    this->lastPattern.clear();
+    this->lastNumActions = 0;
+}
+
+CommandPaletteAction::Ptr CommandPaletteActionsProvider::getFilteredAction(int index) const
+{
+    this->sortFilteredActionsUpTo(index);
+    return this->filteredActions[index];
+}
+
+void CommandPaletteActionsProvider::sortFilteredActionsUpTo(int index) const
+{
+    const auto numActions = this->filteredActions.size();
+    if (index < this->numSortedActions || this->numSortedActions >= numActions)
+    {
+        return;
     }
 
     static CommandPaletteActionSortByMatch comparator;
-    this->filteredActions.sort(comparator);
+    auto *begin = this->filteredActions.begin();
+    auto *end = this->filteredActions.end();
+
+    // first, only pick the top matches; since all of the rest
+    // are not better than them, sorting the rest later completes the order
+    if (this->numSortedActions == 0 && numActions > COMMAND_PALETTE_NUM_PRESORTED_ACTIONS &&
+        index < COMMAND_PALETTE_NUM_PRESORTED_ACTIONS)
+    {
+        std::partial_sort(begin, begin + COMMAND_PALETTE_NUM_PRESORTED_ACTIONS, end, comparator);
+        this->numSortedActions = COMMAND_PALETTE_NUM_PRESORTED_ACTIONS;
+        return;
+    }
+
+    std::sort(begin + this->numSortedActions, end, comparator);
+    this->numSortedActions = numActions;
 }
 
 static bool fuzzyMatch(String::CharPointerType pattern, String::CharPointerType str, int &outScore,
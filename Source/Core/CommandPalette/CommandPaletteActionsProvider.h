@@ -35,10 +35,13 @@ public:
     const Callback getCallback() const noexcept;
     const bool isUnfiltered() const noexcept;
 
-    void setMatch(int score, const uint8 *matches);
+    void setMatch(int score, const uint8 *matches, int numMatches);
     int getMatchScore() const noexcept;
     float getOrder() const noexcept;
-    const GlyphArrangement &getGlyphArrangement() const noexcept;
+
+    // the highlighted glyphs are only built when the row gets painted,
+    // since most of matched actions are never scrolled to
+    const GlyphArrangement &getGlyphArrangement() const;
 
 private:
 
@@ -54,7 +57,9 @@ private:
     bool shouldClosePalette = true;
     bool required = false;
 
-    GlyphArrangement highlightedMatch;
+    Array<uint8> matchedGlyphs;
+    mutable GlyphArrangement highlightedMatch;
+    mutable bool highlightedMatchIsOutdated = true;
     int matchScore = 0;
 
     // actions will be sorted by match, as user is entering the search text,
@@ -78,11 +83,15 @@ public:
     virtual bool usesPrefix(const Prefix prefix) const = 0;
 
     using Actions = ReferenceCountedArray<CommandPaletteAction>;
-    const Actions &getFilteredActions() const
+    int getNumFilteredActions() const noexcept
     {
-        return this->filteredActions;
+        return this->filteredActions.size();
     }
 
+    // the filtered actions are only sorted up to the requested index,
+    // since the list shows just a few top matches at a time
+    CommandPaletteAction::Ptr getFilteredAction(int index) const;
+
     virtual void updateFilter(const String &pattern, bool skipPrefix);
     virtual void clearFilter();
 
@@ -90,9 +99,19 @@ protected:
 
     virtual const Actions &getActions() const = 0;
 
+    // when the pattern grows, only the previous matches are filtered again;
+    // providers which rebuild their actions for the new pattern need to reset that
+    void resetIncrementalFilter() noexcept;
+
 private:
 
-    Actions filteredActions;
+    void sortFilteredActionsUpTo(int index) const;
+
+    mutable Actions filteredActions;
+    mutable int numSortedActions = 0;
+
+    String lastPattern;
+    int lastNumActions = 0;
 
     JUCE_DECLARE_WEAK_REFERENCEABLE(CommandPaletteActionsProvider)
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CommandPaletteActionsProvider)
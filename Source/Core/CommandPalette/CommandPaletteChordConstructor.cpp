@@ -1557,6 +1557,8 @@ void CommandPaletteChordConstructor::updateFilter(const String &pattern, bool sk
 
     this->chordCompiler->fillSuggestions(this->actions);
 
+    // the suggestions are new for every input
+    this->resetIncrementalFilter();
     CommandPaletteActionsProvider::updateFilter(pattern, skipPrefix);
 }
 
@@ -1606,6 +1608,9 @@ void CommandPaletteChordConstructor::previewIfNeeded()
 
             bool atLeastOneNoteShowsInViewport = false;
 
+            Array<Note> chordNotes;
+            chordNotes.ensureStorageAllocated(this->chord.size());
+
             for (const auto &relativeKey : this->chord)
             {
                 const auto key = jlimit(0, 128, MIDDLE_C + relativeKey);
@@ -1613,18 +1618,26 @@ void CommandPaletteChordConstructor::previewIfNeeded()
                 minKey = jmin(minKey, key);
                 maxKey = jmax(maxKey, key);
 
-                const Note note(pianoSequence, key, targetBeat,
-                    CHORD_COMPILER_NOTE_LENGTH, CHORD_COMPILER_NOTE_VELOCITY);
-
-                pianoSequence->insert(note, true);
-                this->hasMadeChanges = true;
+                chordNotes.add(Note(pianoSequence, key, targetBeat,
+                    CHORD_COMPILER_NOTE_LENGTH, CHORD_COMPILER_NOTE_VELOCITY));
 
                 atLeastOneNoteShowsInViewport = atLeastOneNoteShowsInViewport ||
                     this->roll.isNoteVisible(clipKey + key, clipBeat + targetBeat, CHORD_COMPILER_NOTE_LENGTH);
+            }
 
+            // the whole chord is a single undo action, and the roll
+            // gets a single notification, instead of one per each key
+            if (!chordNotes.isEmpty())
+            {
+                pianoSequence->insertGroup(chordNotes, true);
+                this->hasMadeChanges = true;
+            }
+
+            for (const auto &note : chordNotes)
+            {
                 this->roll.getTransport().previewMidiMessage(pianoSequence->getTrackId(),
                     MidiMessage::noteOn(note.getTrackChannel(),
-                        key + clipKey, CHORD_COMPILER_NOTE_VELOCITY));
+                        note.getKey() + clipKey, CHORD_COMPILER_NOTE_VELOCITY));
             }
 
             if (!atLeastOneNoteShowsInViewport)
@@ -44,8 +44,10 @@ CommandPaletteTimelineEvents::~CommandPaletteTimelineEvents()
 
 const CommandPaletteActionsProvider::Actions &CommandPaletteTimelineEvents::getActions() const
 {
-    if (!this->keySignatureActionsOutdated && !this->timeSignatureActionsOutdated &&
-        !this->annotationActionsOutdated && !this->clipActionsOutdated)
+    if (!this->allActionsOutdated && !this->clipActionsOutdated &&
+        !this->annotationActions.isOutdated &&
+        !this->keySignatureActions.isOutdated &&
+        !this->timeSignatureActions.isOutdated)
     {
         return this->allActions;
     }
@@ -57,113 +59,23 @@ const CommandPaletteActionsProvider::Actions &CommandPaletteTimelineEvents::getA
     const auto *timeline = this->project.getTimeline();
     const auto *roll = this->project.getLastFocusedRoll();
     jassert(roll != nullptr);
-    
-    if (this->annotationActionsOutdated)
-    {
-        this->annotationActionsCache.clearQuick();
-
-        const auto *annotationsSequence = timeline->getAnnotations()->getSequence();
-        for (int i = 0; i < annotationsSequence->size(); ++i)
-        {
-            const auto *annotation = dynamic_cast<AnnotationEvent *>(annotationsSequence->getUnchecked(i));
-            jassert(annotation != nullptr);
-
-            const double seekPos = roll->getTransportPositionByBeat(annotation->getBeat());
-            this->project.getTransport().calcTimeAndTempoAt(seekPos, outStartTimeMs, outTempo);
-            const auto action = [this, i](TextEditor &ed)
-            {
-                auto *roll = this->project.getLastFocusedRoll();
-                const auto *timeline = this->project.getTimeline();
-                const auto *annotations = timeline->getAnnotations()->getSequence();
-                const auto *annotation = dynamic_cast<AnnotationEvent *>(annotations->getUnchecked(i));
-                jassert(annotation != nullptr);
-
-                jassert(!this->project.getTransport().isPlaying());
-                const double seekPosition = roll->getTransportPositionByBeat(annotation->getBeat());
-                this->project.getTransport().seekToPosition(seekPosition);
-                roll->scrollToSeekPosition();
-                return true;
-            };
-
-            this->annotationActionsCache.add(CommandPaletteAction::action(annotation->getDescription(),
-                Transport::getTimeString(outStartTimeMs), float(outStartTimeMs))->
-                withColour(annotation->getTrackColour())->
-                withCallback(action));
-        }
 
-        this->annotationActionsOutdated = false;
+    if (this->annotationActions.isOutdated)
+    {
+        this->rebuildActions(this->annotationActions,
+            timeline->getAnnotations()->getSequence());
     }
 
-    if (this->keySignatureActionsOutdated)
+    if (this->keySignatureActions.isOutdated)
     {
-        this->keySignatureActionsCache.clearQuick();
-
-        const auto *ksSequence = timeline->getKeySignatures()->getSequence();
-        for (int i = 0; i < ksSequence->size(); ++i)
-        {
-            const auto *event = dynamic_cast<KeySignatureEvent *>(ksSequence->getUnchecked(i));
-            jassert(event != nullptr);
-
-            const double seekPos = roll->getTransportPositionByBeat(event->getBeat());
-            this->project.getTransport().calcTimeAndTempoAt(seekPos, outStartTimeMs, outTempo);
-            const auto action = [this, i](TextEditor &ed)
-            {
-                auto *roll = this->project.getLastFocusedRoll();
-                const auto *timeline = this->project.getTimeline();
-                const auto *ksSequence = timeline->getKeySignatures()->getSequence();
-                const auto *event = dynamic_cast<KeySignatureEvent *>(ksSequence->getUnchecked(i));
-                jassert(event != nullptr);
-
-                jassert(!this->project.getTransport().isPlaying());
-                const double seekPosition = roll->getTransportPositionByBeat(event->getBeat());
-                this->project.getTransport().seekToPosition(seekPosition);
-                roll->scrollToSeekPosition();
-                return true;
-            };
-
-            this->keySignatureActionsCache.add(CommandPaletteAction::action(event->toString(),
-                Transport::getTimeString(outStartTimeMs), float(outStartTimeMs))->
-                withColour(event->getTrackColour())->
-                withCallback(action));
-        }
-
-        this->keySignatureActionsOutdated = false;
+        this->rebuildActions(this->keySignatureActions,
+            timeline->getKeySignatures()->getSequence());
     }
 
-    if (this->timeSignatureActionsOutdated)
+    if (this->timeSignatureActions.isOutdated)
     {
-        this->timeSignatureActionsCache.clearQuick();
-
-        const auto *tsSequence = timeline->getTimeSignatures()->getSequence();
-        for (int i = 0; i < tsSequence->size(); ++i)
-        {
-            const auto *event = dynamic_cast<TimeSignatureEvent *>(tsSequence->getUnchecked(i));
-            jassert(event != nullptr);
-
-            const double seekPos = roll->getTransportPositionByBeat(event->getBeat());
-            this->project.getTransport().calcTimeAndTempoAt(seekPos, outStartTimeMs, outTempo);
-            const auto action = [this, i](TextEditor &ed)
-            {
-                auto *roll = this->project.getLastFocusedRoll();
-                const auto *timeline = this->project.getTimeline();
-                const auto *tsSequence = timeline->getTimeSignatures()->getSequence();
-                const auto *event = dynamic_cast<TimeSignatureEvent *>(tsSequence->getUnchecked(i));
-                jassert(event != nullptr);
-
-                jassert(!this->project.getTransport().isPlaying());
-                const double seekPosition = roll->getTransportPositionByBeat(event->getBeat());
-                this->project.getTransport().seekToPosition(seekPosition);
-                roll->scrollToSeekPosition();
-                return true;
-            };
-
-            this->timeSignatureActionsCache.add(CommandPaletteAction::action(event->toString(),
-                Transport::getTimeString(outStartTimeMs), float(outStartTimeMs))->
-                withColour(event->getTrackColour())->
-                withCallback(action));
-        }
-
-        this->timeSignatureActionsOutdated = false;
+        this->rebuildActions(this->timeSignatureActions,
+            timeline->getTimeSignatures()->getSequence());
     }
 
     if (this->clipActionsOutdated)
@@ -202,46 +114,190 @@ const CommandPaletteActionsProvider::Actions &CommandPaletteTimelineEvents::getA
     }
 
     this->allActions.clearQuick();
-    this->allActions.addArray(this->annotationActionsCache);
-    this->allActions.addArray(this->keySignatureActionsCache);
-    this->allActions.addArray(this->timeSignatureActionsCache);
+    this->allActions.addArray(this->annotationActions.actions);
+    this->allActions.addArray(this->keySignatureActions.actions);
+    this->allActions.addArray(this->timeSignatureActions.actions);
     this->allActions.addArray(this->clipActionsCache);
+    this->allActionsOutdated = false;
     return this->allActions;
 }
 
-//===----------------------------------------------------------------------===//
-// ProjectListener
-//===----------------------------------------------------------------------===//
-
-void CommandPaletteTimelineEvents::onAddMidiEvent(const MidiEvent &event)
+CommandPaletteTimelineEvents::TimelineEventActions *
+    CommandPaletteTimelineEvents::findActionsFor(const MidiEvent &event) const noexcept
 {
     switch (event.getType())
     {
     case MidiEvent::Type::Annotation:
-        this->annotationActionsOutdated = true;
-        break;
+        return &this->annotationActions;
     case MidiEvent::Type::KeySignature:
-        this->keySignatureActionsOutdated = true;
-        break;
+        return &this->keySignatureActions;
     case MidiEvent::Type::TimeSignature:
-        this->timeSignatureActionsOutdated = true;
-        break;
+        return &this->timeSignatureActions;
     case MidiEvent::Type::Note:
         // if any added/changed/removed note changes its track range, onChangeTrackBeatRange() will be called
     case MidiEvent::Type::Auto:
     default:
-        break;
+        return nullptr;
+    }
+}
+
+void CommandPaletteTimelineEvents::rebuildActions(TimelineEventActions &target,
+    const MidiSequence *sequence) const
+{
+    target.actions.clearQuick();
+    target.eventActions.clear();
+
+    // the sequence is sorted already, and so are the actions built from it
+    for (int i = 0; i < sequence->size(); ++i)
+    {
+        const auto *event = sequence->getUnchecked(i);
+        auto action = this->createAction(*event);
+        target.eventActions[event->getId()] = action;
+        target.actions.add(action);
+    }
+
+    target.isOutdated = false;
+    this->allActionsOutdated = true;
+}
+
+void CommandPaletteTimelineEvents::insertAction(TimelineEventActions &target,
+    const MidiEvent &event)
+{
+    auto action = this->createAction(event);
+    const auto order = action->getOrder();
+
+    // right after the actions with the same order, like the sequence does
+    int start = 0;
+    int end = target.actions.size();
+    while (start < end)
+    {
+        const auto middle = (start + end) / 2;
+        if (order < target.actions.getUnchecked(middle)->getOrder())
+        {
+            end = middle;
+        }
+        else
+        {
+            start = middle + 1;
+        }
+    }
+
+    target.actions.insert(start, action);
+    target.eventActions[event.getId()] = action;
+    this->allActionsOutdated = true;
+
+    // the same number of actions doesn't mean the same actions now
+    this->resetIncrementalFilter();
+}
+
+void CommandPaletteTimelineEvents::removeAction(TimelineEventActions &target,
+    const MidiEvent &event)
+{
+    const auto found = target.eventActions.find(event.getId());
+    if (found == target.eventActions.end())
+    {
+        jassertfalse;
+        target.isOutdated = true;
+        return;
+    }
+
+    target.actions.removeObject(found->second.get());
+    target.eventActions.erase(found);
+    this->allActionsOutdated = true;
+    this->resetIncrementalFilter();
+}
+
+CommandPaletteAction::Ptr CommandPaletteTimelineEvents::createAction(const MidiEvent &event) const
+{
+    String name;
+    if (event.isTypeOf(MidiEvent::Type::Annotation))
+    {
+        name = static_cast<const AnnotationEvent &>(event).getDescription();
     }
+    else if (event.isTypeOf(MidiEvent::Type::KeySignature))
+    {
+        name = static_cast<const KeySignatureEvent &>(event).toString();
+    }
+    else if (event.isTypeOf(MidiEvent::Type::TimeSignature))
+    {
+        name = static_cast<const TimeSignatureEvent &>(event).toString();
+    }
+
+    double outTempo = 0.0;
+    double outStartTimeMs = 0.0;
+    const auto *roll = this->project.getLastFocusedRoll();
+    const double seekPos = roll->getTransportPositionByBeat(event.getBeat());
+    this->project.getTransport().calcTimeAndTempoAt(seekPos, outStartTimeMs, outTempo);
+
+    // the action only needs the position, so it doesn't
+    // hold onto the event which might be gone by the time it's called
+    const auto beat = event.getBeat();
+    const auto action = [this, beat](TextEditor &ed)
+    {
+        auto *roll = this->project.getLastFocusedRoll();
+        jassert(!this->project.getTransport().isPlaying());
+        const double seekPosition = roll->getTransportPositionByBeat(beat);
+        this->project.getTransport().seekToPosition(seekPosition);
+        roll->scrollToSeekPosition();
+        return true;
+    };
+
+    return CommandPaletteAction::action(name,
+        Transport::getTimeString(outStartTimeMs), float(outStartTimeMs))->
+        withColour(event.getTrackColour())->
+        withCallback(action);
+}
+
+void CommandPaletteTimelineEvents::resetAllActions()
+{
+    this->annotationActions.isOutdated = true;
+    this->keySignatureActions.isOutdated = true;
+    this->timeSignatureActions.isOutdated = true;
+    this->clipActionsOutdated = true;
+}
+
+//===----------------------------------------------------------------------===//
+// ProjectListener
+//===----------------------------------------------------------------------===//
+
+void CommandPaletteTimelineEvents::onAddMidiEvent(const MidiEvent &event)
+{
+    auto *target = this->findActionsFor(event);
+    if (target == nullptr || target->isOutdated)
+    {
+        return;
+    }
+
+    if (this->project.getLastFocusedRoll() == nullptr)
+    {
+        target->isOutdated = true;
+        return;
+    }
+
+    this->insertAction(*target, event);
 }
 
 void CommandPaletteTimelineEvents::onChangeMidiEvent(const MidiEvent &event, const MidiEvent &newEvent)
 {
-    this->onAddMidiEvent(event); // same
+    auto *target = this->findActionsFor(event);
+    if (target == nullptr || target->isOutdated)
+    {
+        return;
+    }
+
+    this->removeAction(*target, event);
+    this->onAddMidiEvent(newEvent);
 }
 
 void CommandPaletteTimelineEvents::onRemoveMidiEvent(const MidiEvent &event)
 {
-    this->onAddMidiEvent(event); // same
+    auto *target = this->findActionsFor(event);
+    if (target == nullptr || target->isOutdated)
+    {
+        return;
+    }
+
+    this->removeAction(*target, event);
 }
 
 void CommandPaletteTimelineEvents::onAddClip(const Clip &clip)
@@ -281,17 +337,11 @@ void CommandPaletteTimelineEvents::onChangeTrackBeatRange(MidiTrack *const track
 
 void CommandPaletteTimelineEvents::onReloadProjectContent(const Array<MidiTrack *> &tracks)
 {
-    this->annotationActionsOutdated = true;
-    this->keySignatureActionsOutdated = true;
-    this->timeSignatureActionsOutdated = true;
-    this->clipActionsOutdated = true;
+    this->resetAllActions();
 }
 
 void CommandPaletteTimelineEvents::onChangeProjectBeatRange(float firstBeat, float lastBeat)
 {
-    // time signatures have changed, reset all
-    this->annotationActionsOutdated = true;
-    this->keySignatureActionsOutdated = true;
-    this->timeSignatureActionsOutdated = true;
-    this->clipActionsOutdated = true;
+    // the transport positions of all events have changed
+    this->resetAllActions();
 }
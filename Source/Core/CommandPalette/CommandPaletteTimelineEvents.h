@@ -59,19 +59,37 @@ protected:
 
     const Actions &getActions() const override;
 
-    mutable Actions keySignatureActionsCache;
-    mutable Actions timeSignatureActionsCache;
-    mutable Actions annotationActionsCache;
-    mutable Actions clipActionsCache;
-    mutable Actions allActions;
+    // The timeline events' actions are kept sorted by their position,
+    // and are updated one by one as the events are added, changed or removed;
+    // only the project beat range or the content reload makes them rebuild
+
+    struct TimelineEventActions final
+    {
+        Actions actions;
+        FlatHashMap<MidiEvent::Id, CommandPaletteAction::Ptr, MidiEventIdHash> eventActions;
+        bool isOutdated = true;
+    };
+
+    mutable TimelineEventActions keySignatureActions;
+    mutable TimelineEventActions timeSignatureActions;
+    mutable TimelineEventActions annotationActions;
 
-    mutable bool keySignatureActionsOutdated = true;
-    mutable bool timeSignatureActionsOutdated = true;
-    mutable bool annotationActionsOutdated = true;
+    mutable Actions clipActionsCache;
     mutable bool clipActionsOutdated = true;
 
+    mutable Actions allActions;
+    mutable bool allActionsOutdated = true;
+
 private:
-    
+
+    TimelineEventActions *findActionsFor(const MidiEvent &event) const noexcept;
+    void rebuildActions(TimelineEventActions &target, const MidiSequence *sequence) const;
+    void insertAction(TimelineEventActions &target, const MidiEvent &event);
+    void removeAction(TimelineEventActions &target, const MidiEvent &event);
+    CommandPaletteAction::Ptr createAction(const MidiEvent &event) const;
+
+    void resetAllActions();
+
     ProjectNode &project;
 
 };
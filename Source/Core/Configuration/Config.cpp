@@ -89,10 +89,10 @@ void Config::initResources()
         }
     }
 
-    for (auto &manager : this->resources)
-    {
-        manager.second->reloadResources();
-    }
+    // all other resources are loaded on the first access,
+    // but the translations are used by literally everything,
+    // including the background threads, so they are loaded right away
+    this->translationsManager->reloadResources();
 
     this->load(this->uiFlags.get(), Serialization::Config::activeUiFlags);
 }
@@ -166,24 +166,45 @@ bool Config::saveIfNeeded()
         return false;
     }
 
-    // make sure only the used properties are saved
-    SerializedData cleanedUpConfig(Serialization::Core::globalConfig);
+    // make sure only the used properties are saved, and in the same order
+    // each time, since the order of the lookups is not the same between runs
+    const auto byName = [](const Identifier &a, const Identifier &b)
+    {
+        return a.toString() < b.toString();
+    };
+
+    Array<Identifier> propertyKeys;
     for (const auto &i : this->properties)
     {
         if (this->usedKeys.contains(i.first))
         {
-            cleanedUpConfig.setProperty(i.first, i.second);
+            propertyKeys.add(i.first);
         }
     }
 
+    Array<Identifier> childrenKeys;
     for (const auto &i : this->children)
     {
         if (this->usedKeys.contains(i.first))
         {
-            cleanedUpConfig.appendChild(i.second);
+            childrenKeys.add(i.first);
         }
     }
 
+    std::sort(propertyKeys.begin(), propertyKeys.end(), byName);
+    std::sort(childrenKeys.begin(), childrenKeys.end(), byName);
+
+    SerializedData cleanedUpConfig(Serialization::Core::globalConfig);
+    for (const auto &key : propertyKeys)
+    {
+        cleanedUpConfig.setProperty(key, this->properties.at(key));
+    }
+
+    for (const auto &key : childrenKeys)
+    {
+        cleanedUpConfig.appendChild(this->children.at(key));
+    }
+
     if (DocumentHelpers::save<XmlSerializer>(this->propertiesFile, cleanedUpConfig))
     {
         this->needsSaving = false;
@@ -200,9 +200,21 @@ SerializedData ColourScheme::serialize() const
 
     SerializedData mapXml(UI::Colours::colourMap);
 
+    // sorted, so that the saved schemes don't change between runs
+    Array<Identifier> keys;
     for (const auto &i : this->colours)
     {
-        mapXml.setProperty(i.first, i.second.toString());
+        keys.add(i.first);
+    }
+
+    std::sort(keys.begin(), keys.end(), [](const Identifier &a, const Identifier &b)
+    {
+        return a.toString() < b.toString();
+    });
+
+    for (const auto &key : keys)
+    {
+        mapXml.setProperty(key, this->colours.at(key).toString());
     }
 
     tree.appendChild(mapXml);
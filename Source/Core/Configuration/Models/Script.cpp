@@ -29,7 +29,7 @@ Script &Script::operator=(const Script &other)
 
     this->name = other.name;
     this->type = other.type;
-    //this->content.replaceAllContent(other.content.getAllContent());
+    this->content = other.content;
     return *this;
 }
 
@@ -38,10 +38,10 @@ bool operator==(const Script &l, const Script &r)
     return &l == &r || (l.name == r.name);
 }
 
-Script::Script(const String &name, const Identifier &type, const String &content)
-{
-    // TODO
-}
+Script::Script(const String &name, const Identifier &type, const String &content) :
+    name(name),
+    type(type),
+    content(content) {}
 
 //===----------------------------------------------------------------------===//
 // BaseResource
@@ -68,6 +68,7 @@ SerializedData Script::serialize() const
 
     tree.setProperty(Scripts::name, this->name);
     tree.setProperty(Scripts::type, this->type.toString());
+    tree.setProperty(Scripts::content, this->content);
 
     return tree;
 }
@@ -85,11 +86,12 @@ void Script::deserialize(const SerializedData &data)
 
     this->name = root.getProperty(Scripts::name);
     this->type = root.getProperty(Scripts::type).toString();
-    //this->mapper = createMapperOfType(this->type);
+    this->content = root.getProperty(Scripts::content);
 }
 
 void Script::reset()
 {
     this->name.clear();
-    // TODO
+    this->type = {};
+    this->content.clear();
 }
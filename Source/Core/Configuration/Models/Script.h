@@ -31,6 +31,8 @@ public:
     using Ptr = ReferenceCountedObjectPtr<Script>;
 
     String getName() const noexcept { return this->name; };
+    const Identifier &getType() const noexcept { return this->type; }
+    const String &getContent() const noexcept { return this->content; }
 
     Script &operator=(const Script &other);
     friend bool operator==(const Script &l, const Script &r);
@@ -54,7 +56,7 @@ protected:
 
     String name;
     Identifier type;
-    //CodeDocument content;
+    String content;
 
     JUCE_LEAK_DETECTOR(Script)
 };
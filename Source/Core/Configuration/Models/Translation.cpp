@@ -56,37 +56,50 @@ void Translation::deserialize(const SerializedData &data)
 
     this->name = root.getProperty(Translations::name);
     this->author = root.getProperty(Translations::author);
+    this->pluralExpression = root.getProperty(Translations::pluralEquation, "1").toString();
     this->pluralEquation = Translations::wrapperClassName + "." +
-        Translations::wrapperMethodName + "(" +
-        root.getProperty(Translations::pluralEquation, "1").toString() + ")";
+        Translations::wrapperMethodName + "(" + this->pluralExpression + ")";
 
-    forEachChildWithType(root, pluralLiteral, Translations::pluralLiteral)
+    this->unparsedLiterals.add(root);
+}
+
+void Translation::parseLiteralsIfNeeded()
+{
+    using namespace Serialization;
+
+    for (const auto &root : this->unparsedLiterals)
     {
-        const String baseLiteral = pluralLiteral.getProperty(Translations::name);
+        forEachChildWithType(root, pluralLiteral, Translations::pluralLiteral)
+        {
+            const String baseLiteral = pluralLiteral.getProperty(Translations::name);
+
+            auto *formsAndTranslations = new TranslationMap();
+            this->plurals[baseLiteral] = UniquePointer<TranslationMap>(formsAndTranslations);
+            
+            forEachChildWithType(pluralLiteral, pluralTranslation, Translations::translation)
+            {
+                const String translatedLiteral = pluralTranslation.getProperty(Translations::name);
+                const String pluralForm = pluralTranslation.getProperty(Translations::pluralForm);
+                (*formsAndTranslations)[pluralForm] = translatedLiteral;
+            }
+        }
 
-        auto *formsAndTranslations = new TranslationMap();
-        this->plurals[baseLiteral] = UniquePointer<TranslationMap>(formsAndTranslations);
-        
-        forEachChildWithType(pluralLiteral, pluralTranslation, Translations::translation)
+        forEachChildWithType(root, literal, Translations::literal)
         {
-            const String translatedLiteral = pluralTranslation.getProperty(Translations::name);
-            const String pluralForm = pluralTranslation.getProperty(Translations::pluralForm);
-            (*formsAndTranslations)[pluralForm] = translatedLiteral;
+            const String literalName = literal.getProperty(Translations::name);
+            const String translatedLiteral = literal.getProperty(Translations::translation);
+            this->singulars[literalName] = translatedLiteral;
         }
     }
 
-    forEachChildWithType(root, literal, Translations::literal)
-    {
-        const String literalName = literal.getProperty(Translations::name);
-        const String translatedLiteral = literal.getProperty(Translations::translation);
-        this->singulars[literalName] = translatedLiteral;
-    }
+    this->unparsedLiterals.clearQuick();
 }
 
 void Translation::reset()
 {
     this->singulars.clear();
     this->plurals.clear();
+    this->unparsedLiterals.clear();
 }
 
 //===----------------------------------------------------------------------===//
@@ -36,6 +36,10 @@ public:
     void deserialize(const SerializedData &data) override;
     void reset() override;
 
+    // only the header is parsed on deserialization, and the literals
+    // are kept as is, until the locale is used, see TranslationsManager
+    void parseLiteralsIfNeeded();
+
     //===------------------------------------------------------------------===//
     // BaseResource
     //===------------------------------------------------------------------===//
@@ -49,6 +53,7 @@ private:
     String name;
     String author;
     String pluralEquation;
+    String pluralExpression; // the original one, without the JS wrapper
 
     using TranslationMap = FlatHashMap<String, String, StringHash>;
     using PluralsMap = FlatHashMap<String, UniquePointer<TranslationMap>, StringHash>;
@@ -56,6 +61,9 @@ private:
     TranslationMap singulars;
     PluralsMap plurals;
 
+    // each of the resource files may extend the locale
+    Array<SerializedData> unparsedLiterals;
+
     friend class TranslationsManager;
 
     JUCE_LEAK_DETECTOR(Translation)
@@ -47,6 +47,7 @@ namespace I18n
         static const Identifier supportProject = "common::support";
         static const Identifier updateProceed = "update::proceed";
         static const Identifier networkError = "common::networkerror";
+        static const Identifier loadingInstruments = "common::loadinginstruments";
     }
 
     namespace Defaults
@@ -97,6 +98,7 @@ namespace I18n
         static const Identifier renderCaption = "dialog::render::caption";
         static const Identifier renderClose = "dialog::render::close";
         static const Identifier renderProceed = "dialog::render::proceed";
+        static const Identifier renderProgress = "dialog::render::progress";
         static const Identifier renderSelectFile = "dialog::render::selectfile";
         static const Identifier scanFolderCaption = "dialog::scanfolder::caption";
         static const Identifier timeSignatureAddCaption = "dialog::timesignature::add::caption";
@@ -128,12 +130,19 @@ namespace I18n
         static const Identifier instrumentAddEffect = "menu::instrument::addeffect";
         static const Identifier instrumentAdd = "menu::instrument::addinstrument";
         static const Identifier instrumentDelete = "menu::instrument::delete";
+        static const Identifier instrumentMidiOutput = "menu::instrument::midioutput";
+        static const Identifier instrumentMidiOutputNone = "menu::instrument::midioutput::none";
+        static const Identifier instrumentPrograms = "menu::instrument::programs";
+        static const Identifier instrumentEffectBus = "menu::instrument::effectbus";
+        static const Identifier instrumentSends = "menu::instrument::sends";
+        static const Identifier instrumentSendOff = "menu::instrument::sends::off";
         static const Identifier instrumentRename = "menu::instrument::rename";
         static const Identifier instrumentSetColour = "menu::instrument::setcolour";
         static const Identifier instrumentSetIcon = "menu::instrument::seticon";
         static const Identifier instrumentShowEditor = "menu::instrument::showeditor";
         static const Identifier instrumentsReload = "menu::instruments::reload";
         static const Identifier instrumentsScanFolder = "menu::instruments::scanfolder";
+        static const Identifier instrumentsExportTimings = "menu::instruments::exporttimings";
         static const Identifier keySignatureAdd = "menu::keysignature::add";
 
         static const Identifier refactoringInverseDown = "menu::refactoring::inversedown";
@@ -184,6 +193,7 @@ namespace I18n
             static const Identifier notesRescale = "menu::selection::notes::rescale";
             static const Identifier notesToTrack = "menu::selection::notes::totrack";
             static const Identifier pluginInit = "menu::selection::plugin::init";
+            static const Identifier pluginInitSandboxed = "menu::selection::plugin::initsandboxed";
             static const Identifier pluginPlug = "menu::selection::plugin::plug";
             static const Identifier pluginRemove = "menu::selection::plugin::remove";
             static const Identifier routeDisconnect = "menu::selection::route::disconnect";
@@ -212,7 +222,10 @@ namespace I18n
         static const Identifier trackDelete = "menu::track::delete";
         static const Identifier trackRename = "menu::track::rename";
         static const Identifier trackDuplicate = "menu::track::duplicate";
+        static const Identifier trackFreeze = "menu::track::freeze";
+        static const Identifier trackUnfreeze = "menu::track::unfreeze";
         static const Identifier trackSelectall = "menu::track::selectall";
+        static const Identifier trackSimplify = "menu::track::simplify";
         static const Identifier tuplet1 = "menu::tuplet::1";
         static const Identifier tuplet2 = "menu::tuplet::2";
         static const Identifier tuplet3 = "menu::tuplet::3";
@@ -243,6 +256,7 @@ namespace I18n
     {
         static const Identifier orchestraCategory = "page::orchestra::category";
         static const Identifier orchestraFormat = "page::orchestra::format";
+        static const Identifier orchestraHeadroom = "page::orchestra::headroom";
         static const Identifier orchestraInstruments = "page::orchestra::instruments";
         static const Identifier orchestraPlugins = "page::orchestra::plugins";
         static const Identifier orchestraVendorandname = "page::orchestra::vendorandname";
@@ -278,10 +292,21 @@ namespace I18n
     {
         static const Identifier audio = "settings::audio";
         static const Identifier audioBufferSize = "settings::audio::buffersize";
+        static const Identifier audioBufferSizeAdaptive = "settings::audio::buffersize::adaptive";
+        static const Identifier audioBufferSizeAutomatic = "settings::audio::buffersize::automatic";
+        static const Identifier audioBufferSizeFixed = "settings::audio::buffersize::fixed";
+        static const Identifier audioBufferSizeSuggest = "settings::audio::buffersize::suggest";
+        static const Identifier audioBufferSizeSuggested = "settings::audio::buffersize::suggested";
         static const Identifier audioDevice = "settings::audio::device";
         static const Identifier audioDriver = "settings::audio::driver";
+        static const Identifier audioLatency = "settings::audio::latency";
+        static const Identifier audioLatencyAligned = "settings::audio::latency::aligned";
+        static const Identifier audioLatencyPlayback = "settings::audio::latency::playback";
         static const Identifier audioSampleRate = "settings::audio::samplerate";
+        static const Identifier audioThreads = "settings::audio::threads";
         static const Identifier languageHelp = "settings::language::help";
+        static const Identifier memory = "settings::memory";
+        static const Identifier memoryBudget = "settings::memory::budget";
         static const Identifier rendererCoreGraphics = "settings::renderer::coregraphics";
         static const Identifier rendererDefault = "settings::renderer::default";
         static const Identifier rendererDirect2d = "settings::renderer::direct2d";
@@ -43,8 +43,9 @@ HotkeyScheme::Ptr HotkeySchemesManager::findActiveScheme() const
     return { new HotkeyScheme() };
 }
 
-const HotkeyScheme::Ptr HotkeySchemesManager::getCurrent() const noexcept
+const HotkeyScheme::Ptr HotkeySchemesManager::getCurrent() const
 {
+    this->loadResourcesIfNeeded();
     jassert(this->activeScheme != nullptr);
     return this->activeScheme;
 }
@@ -36,7 +36,7 @@ public:
         return this->getAllResources<HotkeyScheme>();
     }
 
-    const HotkeyScheme::Ptr getCurrent() const noexcept;
+    const HotkeyScheme::Ptr getCurrent() const;
     void setCurrent(const HotkeyScheme::Ptr scheme);
 
 private:
@@ -31,20 +31,40 @@ ResourceManager::~ResourceManager()
     this->reset();
 }
 
+// The downloaded resources override the built-in ones, so the received tree
+// is merged on top of the loaded resources, just like loadResources does,
+// instead of parsing all the files again; the file is written in background
 void ResourceManager::updateBaseResource(const SerializedData &resource)
 {
     DBG("Updating downloaded resource file for " + this->resourceType.toString());
 
 #if DEBUG
-    JsonSerializer serializer(false);
+    using ResourceSerializer = JsonSerializer;
 #else
-    BinarySerializer serializer;
+    using ResourceSerializer = BinarySerializer;
 #endif
 
-    serializer.saveToFile(this->getDownloadedResourceFile(), resource);
+    if (!this->resourcesAreLoaded)
+    {
+        // they will be loaded from the file later, when needed
+        DocumentHelpers::save<ResourceSerializer>(this->getDownloadedResourceFile(), resource);
+        return;
+    }
+
+    this->isWritingDownloadedResource = true;
+    WeakReference<ResourceManager> weakThis(this);
+    DocumentHelpers::saveInBackground<ResourceSerializer>(this->getDownloadedResourceFile(), resource,
+        [weakThis](bool savedOk)
+        {
+            if (weakThis != nullptr)
+            {
+                weakThis->isWritingDownloadedResource = false;
+            }
+        });
 
 #if HELIO_DESKTOP
-    this->reloadResources();
+    this->deserializeResources(resource, this->baseResources);
+    this->resetSnapshot();
     // Do not send update message here, since resource update should go silently
     //this->sendChangeMessage();
 #endif
@@ -52,7 +72,11 @@ void ResourceManager::updateBaseResource(const SerializedData &resource)
 
 void ResourceManager::updateUserResource(const BaseResource::Ptr resource)
 {
+    // all other user's resources are to be saved as well
+    this->loadResourcesIfNeeded();
+
     this->userResources[resource->getResourceId()] = resource;
+    this->resetSnapshot();
 
     // TODO sync with server?
     DBG("Updating user's resource file for " + this->resourceType.toString());
@@ -94,6 +118,44 @@ const BaseResource &ResourceManager::getResourceComparator() const
     return this->comparator;
 }
 
+ResourceManager::Snapshot::Ptr ResourceManager::getSnapshot() const
+{
+    this->loadResourcesIfNeeded();
+
+    if (this->snapshot != nullptr)
+    {
+        return this->snapshot;
+    }
+
+    auto *newSnapshot = new Snapshot();
+
+    for (const auto &baseConfig : this->baseResources)
+    {
+        if (!this->userResources.contains(baseConfig.first))
+        {
+            newSnapshot->allResources.add(baseConfig.second);
+        }
+    }
+
+    for (const auto &userConfig : this->userResources)
+    {
+        newSnapshot->allResources.add(userConfig.second);
+        newSnapshot->userResources.add(userConfig.second);
+    }
+
+    const auto &comparator = this->getResourceComparator();
+    newSnapshot->allResources.sort(comparator, true);
+    newSnapshot->userResources.sort(comparator, true);
+
+    this->snapshot = newSnapshot;
+    return this->snapshot;
+}
+
+void ResourceManager::resetSnapshot() noexcept
+{
+    this->snapshot = nullptr;
+}
+
 
 SerializedData ResourceManager::serializeResources(const Resources &resources)
 {
@@ -111,15 +173,29 @@ void ResourceManager::reset()
 {
     this->baseResources.clear();
     this->userResources.clear();
+    this->resetSnapshot();
+    this->resourcesAreLoaded = false;
 }
 
 void ResourceManager::reloadResources()
 {
-    bool shouldBroadcastChange = false;
+    if (this->loadResources())
+    {
+        this->sendChangeMessage();
+    }
+}
+
+bool ResourceManager::loadResources()
+{
+    bool hasLoadedAnything = false;
 
     // Reset and store an empty tree to append user objects to
     this->baseResources.clear();
     this->userResources.clear();
+    this->resetSnapshot();
+
+    // set before deserializing, which may access the resources
+    this->resourcesAreLoaded = true;
 
     // load both built-in and downloaded resource:
     // downloaded extends and overrides built-in one,
@@ -136,7 +212,7 @@ void ResourceManager::reloadResources()
         if (tree.isValid())
         {
             this->deserializeResources(tree, this->baseResources);
-            shouldBroadcastChange = true;
+            hasLoadedAnything = true;
         }
 
         DBG("Loaded built-in " + this->resourceType.toString() + " in " + String(Time::getMillisecondCounter() - startTime) + " ms");
@@ -146,7 +222,13 @@ void ResourceManager::reloadResources()
     startTime = Time::getMillisecondCounter();
 #endif
 
-    // Try to extend built-in config with downloaded one
+    // Try to extend built-in config with downloaded one,
+    // which might still be being written, see updateBaseResource
+    if (this->isWritingDownloadedResource)
+    {
+        DocumentHelpers::waitForBackgroundSaves();
+    }
+
     const File downloadedResource(this->getDownloadedResourceFile());
     if (downloadedResource.existsAsFile())
     {
@@ -154,7 +236,7 @@ void ResourceManager::reloadResources()
         if (tree.isValid())
         {
             this->deserializeResources(tree, this->baseResources);
-            shouldBroadcastChange = true;
+            hasLoadedAnything = true;
         }
 
         DBG("Loaded extended " + this->resourceType.toString() + " in " + String(Time::getMillisecondCounter() - startTime) + " ms");
@@ -173,14 +255,11 @@ void ResourceManager::reloadResources()
         if (tree.isValid())
         {
             this->deserializeResources(tree, this->userResources);
-            shouldBroadcastChange = true;
+            hasLoadedAnything = true;
         }
 
         DBG("Loaded user's " + this->resourceType.toString() + " in " + String(Time::getMillisecondCounter() - startTime) + " ms");
     }
 
-    if (shouldBroadcastChange)
-    {
-        this->sendChangeMessage();
-    }
+    return hasLoadedAnything;
 }
@@ -26,53 +26,45 @@ public:
     explicit ResourceManager(const Identifier &resourceType);
     ~ResourceManager() override;
 
+    // the resources are loaded on the first access, so that the app
+    // start only pays for the ones which the first screen needs;
+    // reloading also notifies the listeners, unlike the lazy loading
     void reloadResources();
 
-    inline bool isEmpty() const noexcept
+    inline bool isEmpty() const
     {
+        this->loadResourcesIfNeeded();
         return this->baseResources.size() == 0 && this->userResources.size() == 0;
     }
 
-    template<typename T = BaseResource>
-    const Array<typename T::Ptr> getAllResources() const
+    // The sorted lists of the resources, which are only rebuilt when
+    // the resources change, so the popups opening don't sort anything;
+    // a snapshot is never modified, so it's safe to keep it as long as needed
+    struct Snapshot final : public ReferenceCountedObject
     {
-        Array<typename T::Ptr> result;
+        Array<BaseResource::Ptr> allResources;
+        Array<BaseResource::Ptr> userResources;
+        using Ptr = ReferenceCountedObjectPtr<Snapshot>;
+    };
 
-        for (const auto &baseConfig : this->baseResources)
-        {
-            if (!this->userResources.contains(baseConfig.first))
-            {
-                result.addSorted(this->getResourceComparator(),
-                    typename T::Ptr(static_cast<T *>(baseConfig.second.get())));
-            }
-        }
+    Snapshot::Ptr getSnapshot() const;
 
-        for (const auto &userConfig : this->userResources)
-        {
-            result.addSorted(this->getResourceComparator(),
-                typename T::Ptr(static_cast<T *>(userConfig.second.get())));
-        }
-
-        return result;
+    template<typename T = BaseResource>
+    const Array<typename T::Ptr> getAllResources() const
+    {
+        return castResources<T>(this->getSnapshot()->allResources);
     }
 
     template<typename T = BaseResource>
     const Array<typename T::Ptr> getUserResources() const
     {
-        Array<typename T::Ptr> result;
-
-        for (const auto &userConfig : this->userResources)
-        {
-            result.addSorted(this->getResourceComparator(),
-                typename T::Ptr(static_cast<T *>(userConfig.second.get())));
-        }
-
-        return result;
+        return castResources<T>(this->getSnapshot()->userResources);
     }
 
     template<typename T = BaseResource>
     const typename T::Ptr getResourceById(const String &resourceId) const
     {
+        this->loadResourcesIfNeeded();
         const auto foundUserResource = this->userResources.find(resourceId);
         if (foundUserResource != this->userResources.end())
         {
@@ -91,6 +83,7 @@ public:
     template<typename T = BaseResource>
     const typename T::Ptr getUserResourceById(const String &resourceId) const
     {
+        this->loadResourcesIfNeeded();
         const auto foundUserResource = this->userResources.find(resourceId);
         if (foundUserResource != this->userResources.end())
         {
@@ -103,6 +96,7 @@ public:
     template<typename T = BaseResource>
     const bool containsUserResourceWithId(const String &resourceId) const
     {
+        this->loadResourcesIfNeeded();
         const auto foundUserResource = this->userResources.find(resourceId);
         return foundUserResource != this->userResources.end();
     }
@@ -128,8 +122,40 @@ protected:
     virtual void deserializeResources(const SerializedData &tree, Resources &outResources) = 0;
     virtual void reset();
 
+    inline void loadResourcesIfNeeded() const
+    {
+        if (!this->resourcesAreLoaded)
+        {
+            const_cast<ResourceManager *>(this)->loadResources();
+        }
+    }
+
+    // to be called whenever the resources maps are changed
+    void resetSnapshot() noexcept;
+
 private: 
 
+    bool loadResources();
+    bool resourcesAreLoaded = false;
+    bool isWritingDownloadedResource = false;
+
+    // all access is on the message thread, including the sync callbacks,
+    // so swapping the pointer needs no locking
+    mutable Snapshot::Ptr snapshot;
+
+    template<typename T>
+    static Array<typename T::Ptr> castResources(const Array<BaseResource::Ptr> &resources)
+    {
+        Array<typename T::Ptr> result;
+        result.ensureStorageAllocated(resources.size());
+        for (const auto &resource : resources)
+        {
+            result.add(typename T::Ptr(static_cast<T *>(resource.get())));
+        }
+
+        return result;
+    }
+
     const Identifier resourceType;
     const DummyBaseResource comparator;
 
@@ -55,6 +55,257 @@ struct PluralEquationWrapper final : public DynamicObject
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PluralEquationWrapper)
 };
 
+//===----------------------------------------------------------------------===//
+// Compiled translation
+//===----------------------------------------------------------------------===//
+
+// Identifiers are pooled, so the same strings always share the same pointer
+struct IdentifierPointerHash final
+{
+    inline HashCode operator()(const Identifier &key) const noexcept
+    {
+        return std::hash<const void *>()(key.getCharPointer().getAddress());
+    }
+};
+
+/*
+    The plural equations are the C-like expressions, like
+    "({x}%10==1 && {x}%100!=11 ? 1 : 2)", compiled once into a function
+    on loading the locale, instead of substituting the number into the text
+    and parsing it with the JS engine on every call.
+    Supports integers, {x}, parentheses, ?:, ||, &&, !, comparisons and arithmetics;
+    anything else makes the compilation fail, so the JS engine is used instead.
+*/
+
+class PluralRuleCompiler final
+{
+public:
+
+    using Rule = Function<int64(int64)>;
+
+    static Rule compile(const String &expression)
+    {
+        PluralRuleCompiler compiler(expression);
+        auto rule = compiler.parseTernary();
+        compiler.skipSpaces();
+        return (compiler.failed || !compiler.text.isEmpty()) ? nullptr : rule;
+    }
+
+private:
+
+    explicit PluralRuleCompiler(const String &expression) :
+        source(expression.replace(Serialization::Translations::metaSymbol.toString(), "n")),
+        text(source.getCharPointer()) {}
+
+    Rule parseTernary()
+    {
+        auto condition = this->parseBinary(0);
+        if (!this->consume("?"))
+        {
+            return condition;
+        }
+
+        auto ifTrue = this->parseTernary();
+        if (!this->consume(":"))
+        {
+            return this->fail();
+        }
+
+        auto ifFalse = this->parseTernary();
+        return [condition, ifTrue, ifFalse](int64 n)
+        {
+            return condition(n) != 0 ? ifTrue(n) : ifFalse(n);
+        };
+    }
+
+    // the operators are listed by precedence, lowest first; longer ones go
+    // before their prefixes within each level, so that "<=" is not taken for "<"
+    Rule parseBinary(int level)
+    {
+        static const StringArray levels[] =
+        {
+            { "||" },
+            { "&&" },
+            { "==", "!=" },
+            { "<=", ">=", "<", ">" },
+            { "+", "-" },
+            { "*", "/", "%" }
+        };
+
+        constexpr int numLevels = numElementsInArray(levels);
+        if (level >= numLevels)
+        {
+            return this->parseUnary();
+        }
+
+        auto left = this->parseBinary(level + 1);
+        while (!this->failed)
+        {
+            String op;
+            for (const auto &candidate : levels[level])
+            {
+                if (this->consume(candidate))
+                {
+                    op = candidate;
+                    break;
+                }
+            }
+
+            if (op.isEmpty())
+            {
+                break;
+            }
+
+            auto right = this->parseBinary(level + 1);
+            left = makeBinary(op, left, right);
+        }
+
+        return left;
+    }
+
+    Rule parseUnary()
+    {
+        if (this->consume("!"))
+        {
+            auto operand = this->parseUnary();
+            return [operand](int64 n) { return int64(operand(n) == 0); };
+        }
+
+        if (this->consume("-"))
+        {
+            auto operand = this->parseUnary();
+            return [operand](int64 n) { return -operand(n); };
+        }
+
+        return this->parsePrimary();
+    }
+
+    Rule parsePrimary()
+    {
+        if (this->consume("("))
+        {
+            auto inner = this->parseTernary();
+            return this->consume(")") ? inner : this->fail();
+        }
+
+        if (this->consume("n"))
+        {
+            return [](int64 n) { return n; };
+        }
+
+        this->skipSpaces();
+        if (this->text.isDigit())
+        {
+            int64 value = 0;
+            while (this->text.isDigit())
+            {
+                value = value * 10 + (this->text.getAndAdvance() - '0');
+            }
+
+            return [value](int64) { return value; };
+        }
+
+        return this->fail();
+    }
+
+    static Rule makeBinary(const String &op, const Rule &l, const Rule &r)
+    {
+        if (op == "||") { return [l, r](int64 n) { return int64(l(n) != 0 || r(n) != 0); }; }
+        if (op == "&&") { return [l, r](int64 n) { return int64(l(n) != 0 && r(n) != 0); }; }
+        if (op == "==") { return [l, r](int64 n) { return int64(l(n) == r(n)); }; }
+        if (op == "!=") { return [l, r](int64 n) { return int64(l(n) != r(n)); }; }
+        if (op == "<=") { return [l, r](int64 n) { return int64(l(n) <= r(n)); }; }
+        if (op == ">=") { return [l, r](int64 n) { return int64(l(n) >= r(n)); }; }
+        if (op == "<") { return [l, r](int64 n) { return int64(l(n) < r(n)); }; }
+        if (op == ">") { return [l, r](int64 n) { return int64(l(n) > r(n)); }; }
+        if (op == "+") { return [l, r](int64 n) { return l(n) + r(n); }; }
+        if (op == "-") { return [l, r](int64 n) { return l(n) - r(n); }; }
+        if (op == "*") { return [l, r](int64 n) { return l(n) * r(n); }; }
+
+        // the division by zero gives zero rather than crashing
+        if (op == "/") { return [l, r](int64 n) { const auto d = r(n); return d == 0 ? 0 : l(n) / d; }; }
+        return [l, r](int64 n) { const auto d = r(n); return d == 0 ? 0 : l(n) % d; };
+    }
+
+    bool consume(const String &token)
+    {
+        this->skipSpaces();
+        if (this->text.compareUpTo(token.getCharPointer(), token.length()) == 0)
+        {
+            this->text += token.length();
+            return true;
+        }
+
+        return false;
+    }
+
+    void skipSpaces() noexcept
+    {
+        this->text = this->text.findEndOfWhitespace();
+    }
+
+    Rule fail()
+    {
+        this->failed = true;
+        return [](int64) { return int64(0); };
+    }
+
+    const String source;
+    String::CharPointerType text;
+    bool failed = false;
+};
+
+class TranslationsManager::CompiledTranslation final
+{
+public:
+
+    CompiledTranslation(const Translation &current, const Translation &fallback) :
+        pluralEquation(current.pluralEquation),
+        pluralRule(PluralRuleCompiler::compile(current.pluralExpression))
+    {
+        // the same precedence as before: the current singulars,
+        // then the current plurals, then the fallback singulars
+        for (const auto &singular : current.singulars)
+        {
+            this->singulars.emplace(singular.first, singular.second);
+        }
+
+        for (const auto &plural : current.plurals)
+        {
+            if (plural.second->size() > 0)
+            {
+                this->singulars.emplace(plural.first, plural.second->begin()->second);
+            }
+
+            this->plurals.emplace(plural.first, *plural.second);
+        }
+
+        for (const auto &singular : fallback.singulars)
+        {
+            this->singulars.emplace(singular.first, singular.second);
+        }
+
+        for (const auto &singular : this->singulars)
+        {
+            if (singular.first.isNotEmpty())
+            {
+                this->singularsById.emplace(Identifier(singular.first), singular.second);
+            }
+        }
+
+        jassert(this->pluralRule != nullptr); // will fall back to the JS engine
+    }
+
+    FlatHashMap<String, String, StringHash> singulars;
+    FlatHashMap<Identifier, String, IdentifierPointerHash> singularsById;
+    FlatHashMap<String, Translation::TranslationMap, StringHash> plurals;
+
+    const String pluralEquation;
+    const PluralRuleCompiler::Rule pluralRule;
+
+    JUCE_DECLARE_NON_COPYABLE(CompiledTranslation)
+};
+
 TranslationsManager::TranslationsManager() :
     ResourceManager(Serialization::Resources::translations)
 {
@@ -76,6 +327,7 @@ TranslationsManager::~TranslationsManager()
 
 const Translation::Ptr TranslationsManager::getCurrent() const noexcept
 {
+    jassert(this->currentTranslation != nullptr); // see Config::initResources
     return this->currentTranslation;
 }
 
@@ -89,7 +341,9 @@ void TranslationsManager::loadLocaleWithId(const String &localeId)
 
     if (const auto translation = this->getResourceById<Translation>(localeId))
     {
+        translation->parseLiteralsIfNeeded();
         this->currentTranslation = translation;
+        this->compileCurrentTranslation();
         App::Config().setProperty(Serialization::Config::currentLocale, localeId);
         this->sendChangeMessage();
     }
@@ -99,38 +353,28 @@ void TranslationsManager::loadLocaleWithId(const String &localeId)
 // Helpers
 //===----------------------------------------------------------------------===//
 
-String TranslationsManager::translate(const String &text)
+String TranslationsManager::translate(const Identifier &id) const
 {
-    if (text.isEmpty())
+    const auto *compiled = this->compiledTranslation.get();
+    if (id.isNull() || compiled == nullptr)
     {
-        return {};
+        return id.toString();
     }
 
-    const SpinLock::ScopedLockType sl(this->currentTranslationLock);
-
-    const auto foundCurrentSingular = this->currentTranslation->singulars.find(text);
-    if (foundCurrentSingular != this->currentTranslation->singulars.end())
-    {
-        return foundCurrentSingular->second;
-    }
-
-    const auto foundCurrentPlural = this->currentTranslation->plurals.find(text);
-    if (foundCurrentPlural != this->currentTranslation->plurals.end())
-    {
-        const auto *plurals = foundCurrentPlural->second.get();
-        if (plurals->size() > 0)
-        {
-            return plurals->begin()->second;
-        }
-    }
+    const auto found = compiled->singularsById.find(id);
+    return (found != compiled->singularsById.end()) ? found->second : id.toString();
+}
 
-    const auto foundFallbackSingular = this->fallbackTranslation->singulars.find(text);
-    if (foundFallbackSingular != this->fallbackTranslation->singulars.end())
+String TranslationsManager::translate(const String &text) const
+{
+    const auto *compiled = this->compiledTranslation.get();
+    if (text.isEmpty() || compiled == nullptr)
     {
-        return foundFallbackSingular->second;
+        return text;
     }
 
-    return text;
+    const auto found = compiled->singulars.find(text);
+    return (found != compiled->singulars.end()) ? found->second : text;
 }
 
 String TranslationsManager::translate(const String &baseLiteral, int64 targetNumber)
@@ -141,32 +385,57 @@ String TranslationsManager::translate(const String &baseLiteral, int64 targetNum
     }
 
     using namespace Serialization;
-    const SpinLock::ScopedLockType sl(this->currentTranslationLock);
+    const auto *compiled = this->compiledTranslation.get();
+    if (compiled == nullptr)
+    {
+        return baseLiteral.replace(Translations::metaSymbol, String(targetNumber));
+    }
 
-    const auto foundPlural = this->currentTranslation->plurals.find(baseLiteral);
-    if (foundPlural == this->currentTranslation->plurals.end())
+    const auto foundPlural = compiled->plurals.find(baseLiteral);
+    if (foundPlural == compiled->plurals.end())
     {
         return baseLiteral.replace(Translations::metaSymbol, String(targetNumber));
     }
 
-    const String expessionToEvaluate =
-        this->currentTranslation->pluralEquation.replace(Translations::metaSymbol,
-            String(targetNumber > 0 ? targetNumber : -targetNumber));
+    const auto absNumber = targetNumber > 0 ? targetNumber : -targetNumber;
 
-    const Result result = this->engine->execute(expessionToEvaluate);
-    if (!result.failed())
+    String pluralForm;
+    if (compiled->pluralRule != nullptr)
     {
-        const String pluralForm = this->equationResult;
-        const auto foundTranslation = foundPlural->second->find(pluralForm);
-        if (foundTranslation != foundPlural->second->end())
+        pluralForm = String(compiled->pluralRule(absNumber));
+    }
+    else
+    {
+        const SpinLock::ScopedLockType sl(this->engineLock);
+        const String expessionToEvaluate =
+            compiled->pluralEquation.replace(Translations::metaSymbol, String(absNumber));
+
+        const Result result = this->engine->execute(expessionToEvaluate);
+        if (!result.failed())
         {
-            return foundTranslation->second.replace(Translations::metaSymbol, String(targetNumber));
+            pluralForm = this->equationResult;
         }
     }
 
+    const auto foundTranslation = foundPlural->second.find(pluralForm);
+    if (foundTranslation != foundPlural->second.end())
+    {
+        return foundTranslation->second.replace(Translations::metaSymbol, String(targetNumber));
+    }
+
     return baseLiteral.replace(Translations::metaSymbol, String(targetNumber));
 }
 
+void TranslationsManager::compileCurrentTranslation()
+{
+    jassert(this->currentTranslation != nullptr);
+    jassert(this->fallbackTranslation != nullptr);
+
+    auto *compiled = new CompiledTranslation(*this->currentTranslation, *this->fallbackTranslation);
+    this->compiledTranslations.add(compiled);
+    this->compiledTranslation = compiled;
+}
+
 //===----------------------------------------------------------------------===//
 // Serializable
 //===----------------------------------------------------------------------===//
@@ -215,6 +484,11 @@ void TranslationsManager::deserializeResources(const SerializedData &tree, Resou
 
     jassert(this->currentTranslation != nullptr);
     jassert(this->fallbackTranslation != nullptr);
+
+    // all other locales are only shown by name until selected
+    this->currentTranslation->parseLiteralsIfNeeded();
+    this->fallbackTranslation->parseLiteralsIfNeeded();
+    this->compileCurrentTranslation();
 }
 
 void TranslationsManager::reset()
@@ -45,7 +45,10 @@ public:
     // Helpers
     //===------------------------------------------------------------------===//
     
-    String translate(const String &text);
+    // all lookups are lock-free reads of the compiled table,
+    // which is never modified, only replaced when the locale changes
+    String translate(const Identifier &id) const;
+    String translate(const String &text) const;
     String translate(const String &baseLiteral, int64 targetNumber);
     
 private:
@@ -53,13 +56,24 @@ private:
     void deserializeResources(const SerializedData &tree, Resources &outResources) override;
     void reset() override;
 
+    // the JS engine is only used for the plural equations
+    // which are too complex for the built-in compiler
     UniquePointer<JavascriptEngine> engine;
+    SpinLock engineLock;
     String equationResult;
 
-    SpinLock currentTranslationLock;
     Translation::Ptr currentTranslation;
     Translation::Ptr fallbackTranslation;
 
+    class CompiledTranslation;
+    void compileCurrentTranslation();
+
+    Atomic<CompiledTranslation *> compiledTranslation = nullptr;
+
+    // the replaced tables are kept alive, since some other thread
+    // might still be reading them; the locale is rarely changed anyway
+    OwnedArray<CompiledTranslation> compiledTranslations;
+
     String getSelectedLocaleId() const;
     friend struct PluralEquationWrapper;
 
@@ -0,0 +1,206 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Common.h"
+#include "HeadlessConverter.h"
+#include "ProjectNode.h"
+#include "DocumentHelpers.h"
+#include "BinarySerializer.h"
+
+#define HEADLESS_CONVERT_FLAG "--convert"
+#define HEADLESS_CONVERT_OUTPUT_FLAG "--output"
+
+// how many files may be parsed ahead of the main thread,
+// per worker, so that the memory use doesn't depend on the list size
+#define HEADLESS_CONVERT_FILES_PER_WORKER (2)
+
+struct HeadlessConverter::Conversion final
+{
+    File inputFile;
+    File outputFile;
+
+    bool isMidiImport = false;
+    bool hasParsedOk = false;
+
+    MidiFile midiFile;
+    SerializedData projectTree;
+};
+
+static bool isMidiFile(const File &file)
+{
+    return file.hasFileExtension("mid") || file.hasFileExtension("midi");
+}
+
+bool HeadlessConverter::isConvertCommandLine(const String &commandLine)
+{
+    return StringArray::fromTokens(commandLine, true).contains(HEADLESS_CONVERT_FLAG);
+}
+
+HeadlessConverter::HeadlessConverter(const String &commandLine)
+{
+    const auto args = StringArray::fromTokens(commandLine, true);
+    const auto workingDirectory = File::getCurrentWorkingDirectory();
+
+    const auto outputIndex = args.indexOf(HEADLESS_CONVERT_OUTPUT_FLAG);
+    if (outputIndex >= 0 && outputIndex + 1 < args.size())
+    {
+        this->outputDirectory = workingDirectory.getChildFile(args[outputIndex + 1].unquoted());
+    }
+
+    // all the arguments after the flag, up to the next flag, are the files
+    const auto flagIndex = args.indexOf(HEADLESS_CONVERT_FLAG);
+    for (int i = flagIndex + 1; flagIndex >= 0 && i < args.size(); ++i)
+    {
+        if (args[i].startsWith("--"))
+        {
+            break;
+        }
+
+        this->inputFiles.add(workingDirectory.getChildFile(args[i].unquoted()));
+    }
+}
+
+HeadlessConverter::~HeadlessConverter()
+{
+    this->cancellationToken.cancel();
+    DocumentHelpers::waitForBackgroundSaves();
+}
+
+bool HeadlessConverter::start()
+{
+    if (this->inputFiles.isEmpty())
+    {
+        DBG("Usage: helio --convert <file> [<file> ...] [--output <directory>]");
+        return false;
+    }
+
+    if (this->outputDirectory != File() && !this->outputDirectory.createDirectory())
+    {
+        DBG("Failed to create the output directory");
+        return false;
+    }
+
+    for (const auto &file : this->inputFiles)
+    {
+        auto *conversion = this->conversions.add(new Conversion());
+        conversion->inputFile = file;
+        conversion->isMidiImport = isMidiFile(file);
+
+        const auto outputFile = conversion->isMidiImport ?
+            file.withFileExtension("helio") : file.withFileExtension("mid");
+
+        conversion->outputFile = this->outputDirectory == File() ? outputFile :
+            this->outputDirectory.getChildFile(outputFile.getFileName());
+    }
+
+    this->startNextConversions();
+    return true;
+}
+
+void HeadlessConverter::startNextConversions()
+{
+    const auto maxFilesInProgress = jmax(1,
+        App::Tasks().getNumWorkers() * HEADLESS_CONVERT_FILES_PER_WORKER);
+
+    while (this->numInProgress < maxFilesInProgress &&
+        this->numStarted < this->conversions.size())
+    {
+        auto *conversion = this->conversions.getUnchecked(this->numStarted++);
+        this->numInProgress++;
+
+        // reading and parsing are safe to do on any thread,
+        // but the project nodes can only live on the main one
+        App::Tasks().run([conversion]()
+        {
+            if (conversion->isMidiImport)
+            {
+                FileInputStream in(conversion->inputFile);
+                conversion->hasParsedOk = in.openedOk() && conversion->midiFile.readFrom(in);
+            }
+            else
+            {
+                conversion->projectTree = DocumentHelpers::load(conversion->inputFile);
+                conversion->hasParsedOk = conversion->projectTree.isValid();
+            }
+        },
+        TaskPool::Priority::Normal, this->cancellationToken,
+        [this, conversion]()
+        {
+            this->convert(*conversion);
+        });
+    }
+}
+
+void HeadlessConverter::convert(Conversion &conversion)
+{
+    if (!conversion.hasParsedOk)
+    {
+        DBG("Failed to read " + conversion.inputFile.getFullPathName());
+        this->onConversionDone(false);
+        return;
+    }
+
+    if (conversion.isMidiImport)
+    {
+        // the project is never added to the workspace tree, and being
+        // headless, it has no pages; the output file is its document,
+        // which is written in the background, as the project is released
+        ProjectNode project(conversion.outputFile);
+        project.importMidi(conversion.midiFile);
+        conversion.midiFile.clear();
+
+        const auto outputFile = conversion.outputFile;
+        DocumentHelpers::saveInBackground<BinarySerializer>(outputFile,
+            project.serializeDocument(), [this, outputFile](bool savedOk)
+            {
+                DBG((savedOk ? "Converted into " : "Failed to write ") + outputFile.getFullPathName());
+                this->onConversionDone(savedOk);
+            });
+
+        return;
+    }
+
+    ProjectNode project(conversion.inputFile);
+    project.deserializeDocument(conversion.projectTree);
+    conversion.projectTree = {};
+
+    auto outputFile = conversion.outputFile;
+    project.exportMidi(outputFile);
+
+    const bool succeeded = outputFile.getSize() > 0;
+    DBG((succeeded ? "Converted into " : "Failed to write ") + outputFile.getFullPathName());
+    this->onConversionDone(succeeded);
+}
+
+void HeadlessConverter::onConversionDone(bool succeeded)
+{
+    this->numInProgress--;
+    this->numFinished++;
+    this->numFailed += succeeded ? 0 : 1;
+
+    if (this->numFinished < this->conversions.size())
+    {
+        this->startNextConversions();
+        return;
+    }
+
+    DBG("Converted " + String(this->numFinished - this->numFailed) +
+        " of " + String(this->numFinished) + " files");
+
+    JUCEApplication::getInstance()->setApplicationReturnValue(this->numFailed == 0 ? 0 : 1);
+    JUCEApplication::quit();
+}
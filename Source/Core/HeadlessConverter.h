@@ -0,0 +1,67 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "TaskPool.h"
+
+/*
+    When the app is started with
+    `--convert <file> [<file> ...] [--output <directory>]`,
+    it converts each MIDI file into a Helio project, and each project
+    into a MIDI file, next to the original or into the given directory,
+    and quits with the exit code 0, or 1, if any of the files has failed.
+
+    Unlike HeadlessRenderer, it doesn't even load the instruments, and opens
+    no audio device; the files are read and parsed on the worker threads,
+    and the projects are only built on the main thread, a few at a time,
+    then written in the background while the next ones are converted.
+*/
+
+class HeadlessConverter final
+{
+public:
+
+    static bool isConvertCommandLine(const String &commandLine);
+
+    explicit HeadlessConverter(const String &commandLine);
+    ~HeadlessConverter();
+
+    // returns false, if there's nothing to convert
+    bool start();
+
+private:
+
+    struct Conversion;
+    OwnedArray<Conversion> conversions;
+
+    void startNextConversions();
+    void convert(Conversion &conversion);
+    void onConversionDone(bool succeeded);
+
+    Array<File> inputFiles;
+    File outputDirectory;
+
+    int numStarted = 0;
+    int numInProgress = 0;
+    int numFinished = 0;
+    int numFailed = 0;
+
+    TaskPool::CancellationToken cancellationToken;
+
+    JUCE_DECLARE_NON_COPYABLE(HeadlessConverter)
+};
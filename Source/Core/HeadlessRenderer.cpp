@@ -0,0 +1,140 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Common.h"
+#include "HeadlessRenderer.h"
+#include "ProjectNode.h"
+#include "Workspace.h"
+#include "AudioCore.h"
+#include "Transport.h"
+#include "Document.h"
+
+#define HEADLESS_RENDER_FLAG "--render"
+#define HEADLESS_RENDER_STEMS_FLAG "--stems"
+#define HEADLESS_RENDER_CLICK_FLAG "--click"
+#define HEADLESS_RENDER_RANGE_FLAG "--range"
+
+#define HEADLESS_RENDER_POLL_INTERVAL_MS (100)
+
+bool HeadlessRenderer::isRenderCommandLine(const String &commandLine)
+{
+    return StringArray::fromTokens(commandLine, true).contains(HEADLESS_RENDER_FLAG);
+}
+
+HeadlessRenderer::HeadlessRenderer(const String &commandLine)
+{
+    const auto args = StringArray::fromTokens(commandLine, true);
+    const auto workingDirectory = File::getCurrentWorkingDirectory();
+
+    const auto flagIndex = args.indexOf(HEADLESS_RENDER_FLAG);
+    if (flagIndex >= 0 && flagIndex + 2 < args.size())
+    {
+        this->projectFile = workingDirectory.getChildFile(args[flagIndex + 1].unquoted());
+        this->outputFile = workingDirectory.getChildFile(args[flagIndex + 2].unquoted());
+    }
+
+    this->options.renderStems = args.contains(HEADLESS_RENDER_STEMS_FLAG);
+    this->options.renderMetronome = args.contains(HEADLESS_RENDER_CLICK_FLAG);
+
+    const auto rangeIndex = args.indexOf(HEADLESS_RENDER_RANGE_FLAG);
+    if (rangeIndex >= 0 && rangeIndex + 2 < args.size())
+    {
+        this->hasRange = true;
+        this->rangeStartBeat = args[rangeIndex + 1].getFloatValue();
+        this->rangeEndBeat = args[rangeIndex + 2].getFloatValue();
+    }
+}
+
+HeadlessRenderer::~HeadlessRenderer()
+{
+    this->stopTimer();
+    this->project = nullptr;
+}
+
+bool HeadlessRenderer::start()
+{
+    if (!this->projectFile.existsAsFile() || this->outputFile == File())
+    {
+        DBG("Usage: helio --render <project file> <output file> [--stems] [--click] [--range <start beat> <end beat>]");
+        return false;
+    }
+
+    // the project is never added to the workspace tree, so it has no pages shown,
+    // and the workspace doesn't remember it as a recent one
+    DBG("Rendering " + this->projectFile.getFullPathName());
+    this->project = makeUnique<ProjectNode>(this->projectFile);
+    if (!this->project->getDocument()->load(this->projectFile.getFullPathName()))
+    {
+        DBG("Failed to load the project");
+        return false;
+    }
+
+    this->startTimer(HEADLESS_RENDER_POLL_INTERVAL_MS);
+    return true;
+}
+
+void HeadlessRenderer::timerCallback()
+{
+    if (!this->hasStartedRender)
+    {
+        // the plugins are loaded in the background, see AudioCore::deserialize
+        if (!App::Workspace().getAudioCore().isLoadingInstruments())
+        {
+            this->startRender();
+        }
+
+        return;
+    }
+
+    auto &transport = this->project->getTransport();
+    if (transport.isRendering())
+    {
+        return;
+    }
+
+    this->finish(!transport.hasRenderFailed() &&
+        this->outputFile.getSize() > 0);
+}
+
+void HeadlessRenderer::startRender()
+{
+    this->hasStartedRender = true;
+
+    if (this->hasRange)
+    {
+        const auto projectRange = this->project->getProjectRangeInBeats();
+        const double projectLength = projectRange.getY() - projectRange.getX();
+        this->options.startPosition = jlimit(0.0, 1.0,
+            double(this->rangeStartBeat - projectRange.getX()) / projectLength);
+        this->options.endPosition = jlimit(this->options.startPosition, 1.0,
+            double(this->rangeEndBeat - projectRange.getX()) / projectLength);
+    }
+
+    // the offline renderer doesn't wait for the audio device,
+    // so it works as fast as the instruments can process
+    this->project->getTransport().startRender(this->outputFile.getFullPathName(), this->options);
+}
+
+void HeadlessRenderer::finish(bool succeeded)
+{
+    this->stopTimer();
+
+    DBG(succeeded ? "Rendered into " + this->outputFile.getFullPathName() : String("Failed to render"));
+
+    JUCEApplication::getInstance()->setApplicationReturnValue(succeeded ? 0 : 1);
+    JUCEApplication::quit();
+}
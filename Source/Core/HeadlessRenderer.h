@@ -0,0 +1,68 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+class ProjectNode;
+
+#include "RenderOptions.h"
+
+/*
+    When the app is started with
+    `--render <project file> <output file> [--stems] [--click] [--range <start beat> <end beat>]`,
+    it doesn't create the main window: the workspace only loads the instruments,
+    and this loads the given project by itself, renders it into the output file
+    (wav or flac, depending on the extension) and quits with the exit code 0,
+    or 1, if anything has failed; with `--click`, the metronome is mixed in.
+
+    Nothing is saved into the workspace or the config in that mode,
+    so that many instances can render different projects at the same time.
+*/
+
+class HeadlessRenderer final : private Timer
+{
+public:
+
+    static bool isRenderCommandLine(const String &commandLine);
+
+    explicit HeadlessRenderer(const String &commandLine);
+    ~HeadlessRenderer() override;
+
+    // loads the project and waits for the instruments to load before
+    // rendering; returns false, if there's nothing to render
+    bool start();
+
+private:
+
+    void timerCallback() override;
+    void startRender();
+    void finish(bool succeeded);
+
+    File projectFile;
+    File outputFile;
+
+    RenderOptions options;
+    bool hasRange = false;
+    float rangeStartBeat = 0.f;
+    float rangeEndBeat = 0.f;
+
+    bool hasStartedRender = false;
+
+    UniquePointer<ProjectNode> project;
+
+    JUCE_DECLARE_NON_COPYABLE(HeadlessRenderer)
+};
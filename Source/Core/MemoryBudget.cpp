@@ -0,0 +1,306 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Common.h"
+#include "MemoryBudget.h"
+
+MemoryBudget::MemoryBudget() :
+    budget(MemoryBudget::defaultBudget) {}
+
+MemoryBudget::~MemoryBudget()
+{
+    this->cancelPendingUpdate();
+
+    // all caches are expected to unregister before the budget is deleted
+    jassert(this->caches.empty());
+    jassert(this->accounts.isEmpty());
+}
+
+MemoryBudget::Account::Account(const String &name, Estimator estimator) :
+    name(name), estimator(estimator)
+{
+    auto &budget = App::Memory();
+    const ScopedLock sl(budget.lock);
+    budget.accounts.add(this);
+}
+
+MemoryBudget::Account::~Account()
+{
+    auto &budget = App::Memory();
+    const ScopedLock sl(budget.lock);
+    budget.accounts.removeFirstMatchingValue(this);
+}
+
+void MemoryBudget::registerCache(Cache *cache, Priority priority)
+{
+    const ScopedLock sl(this->lock);
+    jassert(!this->caches.contains(cache));
+    this->caches[cache].priority = priority;
+}
+
+void MemoryBudget::unregisterCache(Cache *cache)
+{
+    const ScopedLock sl(this->lock);
+    const auto found = this->caches.find(cache);
+    if (found != this->caches.end())
+    {
+        this->totalCost -= found->second.totalCost;
+        this->caches.erase(found);
+    }
+}
+
+void MemoryBudget::addEntry(Cache *cache, int64 entryId, int64 cost)
+{
+    {
+        const ScopedLock sl(this->lock);
+        const auto found = this->caches.find(cache);
+        if (found == this->caches.end())
+        {
+            jassertfalse;
+            return;
+        }
+
+        auto &cacheEntries = found.value();
+        auto &entry = cacheEntries.entries[entryId];
+        cacheEntries.totalCost += cost - entry.cost;
+        this->totalCost += cost - entry.cost;
+        entry.cost = cost;
+        entry.lastAccess = ++this->accessCounter;
+
+        if (this->totalCost <= this->budget)
+        {
+            return;
+        }
+    }
+
+    this->triggerAsyncUpdate();
+}
+
+void MemoryBudget::touchEntry(Cache *cache, int64 entryId)
+{
+    const ScopedLock sl(this->lock);
+    const auto cacheEntries = this->caches.find(cache);
+    if (cacheEntries != this->caches.end())
+    {
+        const auto entry = cacheEntries->second.entries.find(entryId);
+        if (entry != cacheEntries->second.entries.end())
+        {
+            entry.value().lastAccess = ++this->accessCounter;
+        }
+    }
+}
+
+void MemoryBudget::removeEntry(Cache *cache, int64 entryId)
+{
+    const ScopedLock sl(this->lock);
+    const auto cacheEntries = this->caches.find(cache);
+    if (cacheEntries != this->caches.end())
+    {
+        auto &entries = cacheEntries.value().entries;
+        const auto entry = entries.find(entryId);
+        if (entry != entries.end())
+        {
+            cacheEntries.value().totalCost -= entry->second.cost;
+            this->totalCost -= entry->second.cost;
+            entries.erase(entry);
+        }
+    }
+}
+
+void MemoryBudget::removeAllEntries(Cache *cache)
+{
+    const ScopedLock sl(this->lock);
+    const auto cacheEntries = this->caches.find(cache);
+    if (cacheEntries != this->caches.end())
+    {
+        this->totalCost -= cacheEntries->second.totalCost;
+        cacheEntries.value().totalCost = 0;
+        cacheEntries.value().entries.clear();
+    }
+}
+
+void MemoryBudget::setBudget(int64 numBytes)
+{
+    {
+        const ScopedLock sl(this->lock);
+        this->budget = jmax(int64(0), numBytes);
+        if (this->totalCost <= this->budget)
+        {
+            return;
+        }
+    }
+
+    this->triggerAsyncUpdate();
+}
+
+int64 MemoryBudget::getBudget() const noexcept
+{
+    const ScopedLock sl(this->lock);
+    return this->budget;
+}
+
+int64 MemoryBudget::getTotalCost() const noexcept
+{
+    const ScopedLock sl(this->lock);
+    return this->totalCost;
+}
+
+Array<MemoryBudget::CacheUsage> MemoryBudget::getUsage() const
+{
+    Array<CacheUsage> result;
+
+    const ScopedLock sl(this->lock);
+    for (const auto &cacheEntries : this->caches)
+    {
+        const auto name = cacheEntries.first->getCacheName();
+        const auto &entries = cacheEntries.second;
+
+        bool merged = false;
+        for (auto &usage : result)
+        {
+            if (usage.name == name)
+            {
+                usage.numEntries += int(entries.entries.size());
+                usage.numBytes += entries.totalCost;
+                usage.numEvictions += entries.numEvictions;
+                merged = true;
+                break;
+            }
+        }
+
+        if (!merged)
+        {
+            result.add({ name, entries.priority,
+                int(entries.entries.size()), entries.totalCost, entries.numEvictions });
+        }
+    }
+
+    return result;
+}
+
+Array<MemoryBudget::AccountUsage> MemoryBudget::getAccountsUsage() const
+{
+    JUCE_ASSERT_MESSAGE_THREAD
+
+    Array<AccountUsage> result;
+
+    const ScopedLock sl(this->lock);
+    for (const auto *account : this->accounts)
+    {
+        int numItems = 0;
+        int64 numBytes = 0;
+        account->estimator(numItems, numBytes);
+
+        bool merged = false;
+        for (auto &usage : result)
+        {
+            if (usage.name == account->name)
+            {
+                usage.numItems += numItems;
+                usage.numBytes += numBytes;
+                merged = true;
+                break;
+            }
+        }
+
+        if (!merged)
+        {
+            result.add({ account->name, numItems, numBytes });
+        }
+    }
+
+    return result;
+}
+
+int64 MemoryBudget::getImageCost(const Image &image) noexcept
+{
+    if (!image.isValid())
+    {
+        return 0;
+    }
+
+    const int bytesPerPixel = image.isARGB() ? 4 : (image.isRGB() ? 3 : 1);
+    return int64(image.getWidth()) * int64(image.getHeight()) * bytesPerPixel;
+}
+
+void MemoryBudget::handleAsyncUpdate()
+{
+    struct Victim final
+    {
+        Cache *cache;
+        int64 entryId;
+        Priority priority;
+        uint64 lastAccess;
+        int64 cost;
+    };
+
+    Array<Victim> victims;
+
+    {
+        const ScopedLock sl(this->lock);
+        if (this->totalCost <= this->budget)
+        {
+            return;
+        }
+
+        Array<Victim> candidates;
+        for (const auto &cacheEntries : this->caches)
+        {
+            for (const auto &entry : cacheEntries.second.entries)
+            {
+                candidates.add({ cacheEntries.first, entry.first,
+                    cacheEntries.second.priority, entry.second.lastAccess, entry.second.cost });
+            }
+        }
+
+        std::sort(candidates.begin(), candidates.end(),
+            [](const Victim &a, const Victim &b)
+            {
+                return a.priority != b.priority ?
+                    a.priority < b.priority : a.lastAccess < b.lastAccess;
+            });
+
+        for (const auto &candidate : candidates)
+        {
+            if (this->totalCost <= this->budget)
+            {
+                break;
+            }
+
+            auto &cacheEntries = this->caches.find(candidate.cache).value();
+            cacheEntries.entries.erase(candidate.entryId);
+            cacheEntries.totalCost -= candidate.cost;
+            cacheEntries.numEvictions++;
+            this->totalCost -= candidate.cost;
+            victims.add(candidate);
+        }
+    }
+
+    for (const auto &victim : victims)
+    {
+        // one cache's eviction might have made another cache unregister
+        {
+            const ScopedLock sl(this->lock);
+            if (!this->caches.contains(victim.cache))
+            {
+                continue;
+            }
+        }
+
+        victim.cache->evictCacheEntry(victim.entryId);
+    }
+}
@@ -0,0 +1,154 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+/*
+    The app-wide memory budget for the caches of anything which can be
+    re-created at any time, like the pre-rendered images or the parsed
+    documents (see App::Memory).
+
+    Each cache reports the approximate cost of its entries and touches them
+    when they are used; as soon as the total cost exceeds the budget, the entries
+    of the lower priority caches are evicted first, and the least recently used
+    ones go first within the same priority.
+
+    The entries can be added and touched from any thread, but the eviction
+    callbacks are always called asynchronously on the message thread, without
+    holding the budget's lock, so that the caches are free to lock themselves.
+*/
+
+class MemoryBudget final : private AsyncUpdater
+{
+public:
+
+    enum class Priority : int8
+    {
+        Low = 0,
+        Normal = 1,
+        High = 2
+    };
+
+    class Cache
+    {
+    public:
+
+        virtual ~Cache() = default;
+
+        virtual String getCacheName() const = 0;
+
+        // the cache is expected to drop the entry here,
+        // there's no need to call removeEntry for it afterwards
+        virtual void evictCacheEntry(int64 entryId) = 0;
+    };
+
+    struct CacheUsage final
+    {
+        String name;
+        Priority priority;
+        int numEntries;
+        int64 numBytes;
+        int numEvictions;
+    };
+
+    // the accounts are for the things which are never evicted,
+    // like the project's events or the undo history: instead of tracking
+    // each allocation, the owner estimates its usage when asked for a report;
+    // accounts register themselves for their lifetime, and the estimators
+    // are only called on the message thread
+    class Account final
+    {
+    public:
+
+        using Estimator = Function<void(int &numItems, int64 &numBytes)>;
+
+        Account(const String &name, Estimator estimator);
+        ~Account();
+
+    private:
+
+        const String name;
+        const Estimator estimator;
+
+        friend class MemoryBudget;
+
+        JUCE_DECLARE_NON_COPYABLE(Account)
+    };
+
+    struct AccountUsage final
+    {
+        String name;
+        int numItems;
+        int64 numBytes;
+    };
+
+    MemoryBudget();
+    ~MemoryBudget() override;
+
+    static constexpr int64 defaultBudget = 256 * 1024 * 1024;
+
+    void registerCache(Cache *cache, Priority priority);
+    void unregisterCache(Cache *cache); // forgets all its entries
+
+    // adds the entry or updates its cost, and marks it as the most recently used
+    void addEntry(Cache *cache, int64 entryId, int64 cost);
+    void touchEntry(Cache *cache, int64 entryId);
+    void removeEntry(Cache *cache, int64 entryId);
+    void removeAllEntries(Cache *cache);
+
+    void setBudget(int64 numBytes);
+    int64 getBudget() const noexcept;
+    int64 getTotalCost() const noexcept;
+
+    // the usage of the caches with the same name is summed up,
+    // e.g. when each open project has its own piano roll
+    Array<CacheUsage> getUsage() const;
+
+    // same as above, summed up by the account names; message thread only
+    Array<AccountUsage> getAccountsUsage() const;
+
+    static int64 getImageCost(const Image &image) noexcept;
+
+private:
+
+    void handleAsyncUpdate() override;
+
+    struct Entry final
+    {
+        int64 cost = 0;
+        uint64 lastAccess = 0;
+    };
+
+    struct CacheEntries final
+    {
+        Priority priority;
+        FlatHashMap<int64, Entry> entries;
+        int64 totalCost = 0;
+        int numEvictions = 0;
+    };
+
+    CriticalSection lock;
+    FlatHashMap<Cache *, CacheEntries> caches;
+
+    Array<Account *> accounts;
+
+    uint64 accessCounter = 0;
+    int64 totalCost = 0;
+    int64 budget;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MemoryBudget)
+};
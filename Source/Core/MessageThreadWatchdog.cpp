@@ -0,0 +1,169 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Common.h"
+#include "MessageThreadWatchdog.h"
+#include "DocumentHelpers.h"
+
+#define WATCHDOG_STALL_THRESHOLD_MS (50.0)
+#define WATCHDOG_HEARTBEAT_INTERVAL_MS (10)
+#define WATCHDOG_CHECK_INTERVAL_MS (10)
+#define WATCHDOG_MAX_SCOPES_DEPTH (16)
+#define WATCHDOG_LOG_FILE "stalls.log"
+#define WATCHDOG_MAX_LOG_SIZE (1024 * 1024)
+
+// the scopes are only entered on the message thread, so the watchdog thread
+// may see a slightly outdated stack of names, which is fine for the reports
+struct WatchdogState final
+{
+    Atomic<bool> isRunning = false;
+    Atomic<double> lastHeartbeatMs = 0.0;
+
+    Atomic<int> numScopes = 0;
+    Atomic<const char *> scopes[WATCHDOG_MAX_SCOPES_DEPTH];
+
+    // only the innermost slow scope reports its stack trace,
+    // since the outer ones would just repeat the same stall
+    bool hasReportedNestedScope = false;
+
+    CriticalSection logLock;
+};
+
+static WatchdogState &getWatchdogState()
+{
+    static WatchdogState state;
+    return state;
+}
+
+static void writeWatchdogReport(const String &report)
+{
+    auto &state = getWatchdogState();
+    const ScopedLock lock(state.logLock);
+
+    const auto logFile = DocumentHelpers::getConfigSlot(WATCHDOG_LOG_FILE);
+    if (logFile.getSize() > WATCHDOG_MAX_LOG_SIZE)
+    {
+        logFile.deleteFile();
+    }
+
+    const auto line = Time::getCurrentTime().toISO8601(true) + " " + report;
+    logFile.appendText(line + "\n", false, false, "\n");
+    Logger::writeToLog(line);
+}
+
+static String getScopesInProgress()
+{
+    auto &state = getWatchdogState();
+    const auto numScopes = jmin(state.numScopes.get(), WATCHDOG_MAX_SCOPES_DEPTH);
+
+    StringArray names;
+    for (int i = 0; i < numScopes; ++i)
+    {
+        if (const auto *name = state.scopes[i].get())
+        {
+            names.add(name);
+        }
+    }
+
+    return names.isEmpty() ? String("unknown handler") : names.joinIntoString(" > ");
+}
+
+MessageThreadWatchdog::MessageThreadWatchdog() :
+    Thread("Message thread watchdog")
+{
+    auto &state = getWatchdogState();
+    state.lastHeartbeatMs = Time::getMillisecondCounterHiRes();
+    state.isRunning = true;
+
+    this->startTimer(WATCHDOG_HEARTBEAT_INTERVAL_MS);
+    this->startThread(2);
+}
+
+MessageThreadWatchdog::~MessageThreadWatchdog()
+{
+    getWatchdogState().isRunning = false;
+    this->stopTimer();
+    this->stopThread(1000);
+}
+
+void MessageThreadWatchdog::timerCallback()
+{
+    getWatchdogState().lastHeartbeatMs = Time::getMillisecondCounterHiRes();
+}
+
+void MessageThreadWatchdog::run()
+{
+    auto &state = getWatchdogState();
+    double stallStartMs = 0.0;
+
+    while (!this->threadShouldExit())
+    {
+        this->wait(WATCHDOG_CHECK_INTERVAL_MS);
+
+        const auto lastHeartbeatMs = state.lastHeartbeatMs.get();
+        const auto sinceHeartbeatMs = Time::getMillisecondCounterHiRes() - lastHeartbeatMs;
+        const bool isStalled = sinceHeartbeatMs > WATCHDOG_STALL_THRESHOLD_MS;
+
+        if (isStalled && stallStartMs == 0.0)
+        {
+            // report once per stall, while it's still going on
+            stallStartMs = lastHeartbeatMs;
+            writeWatchdogReport("Message thread stalled in " + getScopesInProgress());
+        }
+        else if (!isStalled && stallStartMs != 0.0)
+        {
+            writeWatchdogReport("Message thread resumed after " +
+                String(roundToInt(lastHeartbeatMs - stallStartMs)) + " ms");
+            stallStartMs = 0.0;
+        }
+    }
+}
+
+MessageThreadWatchdog::Scope::Scope(const char *name) noexcept :
+    name(name),
+    startTimeMs(Time::getMillisecondCounterHiRes())
+{
+    auto &state = getWatchdogState();
+    const auto depth = state.numScopes.get();
+    if (depth < WATCHDOG_MAX_SCOPES_DEPTH)
+    {
+        state.scopes[depth] = name;
+    }
+
+    state.numScopes = depth + 1;
+}
+
+MessageThreadWatchdog::Scope::~Scope()
+{
+    auto &state = getWatchdogState();
+    const auto depth = state.numScopes.get() - 1;
+    state.numScopes = depth;
+
+    const auto durationMs = Time::getMillisecondCounterHiRes() - this->startTimeMs;
+    if (state.isRunning.get() && !state.hasReportedNestedScope &&
+        durationMs > WATCHDOG_STALL_THRESHOLD_MS)
+    {
+        writeWatchdogReport(String(this->name) + " took " +
+            String(roundToInt(durationMs)) + " ms\n" + SystemStats::getStackBacktrace());
+        state.hasReportedNestedScope = true;
+    }
+
+    if (depth == 0)
+    {
+        state.hasReportedNestedScope = false;
+    }
+}
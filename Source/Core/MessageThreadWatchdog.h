@@ -0,0 +1,64 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+/*
+    Detects the message thread handlers which take longer than the threshold:
+    a timer on the message thread keeps updating the heartbeat timestamp,
+    and a background thread reports, when it gets stale.
+
+    The handlers which are the usual suspects (autosaves, vcs diffing, rolls'
+    reloads, command palette filtering) are marked with WATCHDOG_SCOPE, so that
+    a report names the ones in progress; since there's no portable way to sample
+    another thread's stack, the scope which has taken too long adds its own stack
+    trace when it's done. The reports are appended to stalls.log in the app data
+    folder along with the timestamps, so that they can be collected from the users.
+*/
+
+class MessageThreadWatchdog final : private Thread, private Timer
+{
+public:
+
+    MessageThreadWatchdog();
+    ~MessageThreadWatchdog() override;
+
+    class Scope final
+    {
+    public:
+
+        explicit Scope(const char *name) noexcept;
+        ~Scope();
+
+    private:
+
+        const char *name;
+        const double startTimeMs;
+
+        JUCE_DECLARE_NON_COPYABLE(Scope)
+    };
+
+private:
+
+    void run() override;
+    void timerCallback() override;
+
+    JUCE_DECLARE_NON_COPYABLE(MessageThreadWatchdog)
+};
+
+#define WATCHDOG_SCOPE(name) \
+    const MessageThreadWatchdog::Scope JUCE_JOIN_MACRO(watchdogScope, __LINE__)(name)
@@ -0,0 +1,132 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+/*
+    A fixed-size slab allocator for the objects that are created
+    in the hundreds of thousands, like notes, automation events and clips:
+    they are carved out of blocks of many objects at once and recycled
+    through a free list, so loading or checking out a large project
+    doesn't do a heap allocation per event, nor fragments the heap.
+
+    The classes opt in with POOL_ALLOCATED(ClassName) in their declaration,
+    so that all the existing new/delete and OwnedArray code just works;
+    the values stored in Arrays (e.g. temporary copies in diffs and undo
+    actions) are constructed in place and never touch the pool.
+
+    Thread-safe, since e.g. the diff thread creates the events as well.
+    The blocks are never given back to the system, they are only reused.
+*/
+
+template <typename T, int NumObjectsPerBlock = 512>
+class ObjectPool final
+{
+public:
+
+    static void *allocate(size_t size)
+    {
+        // the subclasses of different size would not fit the slots:
+        if (size != sizeof(T))
+        {
+            return ::operator new(size);
+        }
+
+        return ObjectPool::getInstance().allocateSlot();
+    }
+
+    static void deallocate(void *ptr, size_t size) noexcept
+    {
+        if (ptr == nullptr)
+        {
+            return;
+        }
+
+        if (size != sizeof(T))
+        {
+            ::operator delete(ptr);
+            return;
+        }
+
+        ObjectPool::getInstance().freeSlot(ptr);
+    }
+
+private:
+
+    ObjectPool() = default;
+
+    // never destroyed on purpose: some objects may still be deleted
+    // by other statics' destructors at shutdown, after this one
+    static ObjectPool &getInstance()
+    {
+        static auto *instance = new ObjectPool();
+        return *instance;
+    }
+
+    union Slot
+    {
+        Slot *next;
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+    };
+
+    void *allocateSlot()
+    {
+        const SpinLock::ScopedLockType lock(this->slotsLock);
+
+        if (this->freeSlots == nullptr)
+        {
+            auto *block = new Slot[NumObjectsPerBlock];
+            this->blocks.add(block);
+
+            for (int i = NumObjectsPerBlock; --i >= 0;)
+            {
+                block[i].next = this->freeSlots;
+                this->freeSlots = &block[i];
+            }
+        }
+
+        auto *slot = this->freeSlots;
+        this->freeSlots = slot->next;
+        return slot;
+    }
+
+    void freeSlot(void *ptr) noexcept
+    {
+        const SpinLock::ScopedLockType lock(this->slotsLock);
+        auto *slot = static_cast<Slot *>(ptr);
+        slot->next = this->freeSlots;
+        this->freeSlots = slot;
+    }
+
+    SpinLock slotsLock;
+    Slot *freeSlots = nullptr;
+    Array<Slot *> blocks;
+
+    JUCE_DECLARE_NON_COPYABLE(ObjectPool)
+};
+
+// The placement forms are needed too, since declaring a class-specific
+// operator new hides the global placement new, which the Array uses
+#define POOL_ALLOCATED(className) \
+public: \
+    static void *operator new(size_t size) \
+    { return ObjectPool<className>::allocate(size); } \
+    static void operator delete(void *ptr, size_t size) noexcept \
+    { ObjectPool<className>::deallocate(ptr, size); } \
+    static void *operator new(size_t, void *where) noexcept { return where; } \
+    static void operator delete(void *, void *) noexcept {} \
+private:
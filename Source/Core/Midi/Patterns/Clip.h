@@ -17,6 +17,8 @@
 
 #pragma once
 
+#include "ObjectPool.h"
+
 class Pattern;
 
 // Just an instance of a midi sequence on a certain position,
@@ -109,6 +111,7 @@ private:
 
     friend struct ClipHash;
 
+    POOL_ALLOCATED(Clip)
     JUCE_LEAK_DETECTOR(Clip);
 };
 
@@ -116,9 +119,8 @@ struct ClipHash
 {
     inline HashCode operator()(const Clip &key) const noexcept
     {
-        // Note: see the comment for MidiEventHash in MidiEvent.h
-        const auto *ptr = key.id.getCharPointer().getAddress();
-        return 64 * static_cast<HashCode>(ptr[0]) + static_cast<HashCode>(ptr[1]);
-        //return static_cast<HashCode>(key.beat) + static_cast<HashCode>(key.getId().hashCode());
+        // hashing just the first two characters used to be faster,
+        // but it makes the maps degrade with lots of clips having long ids
+        return static_cast<HashCode>(key.id.hashCode64());
     }
 };
@@ -142,14 +142,19 @@ bool AnnotationsSequence::insertGroup(Array<AnnotationEvent> &group, bool undoab
     }
     else
     {
+        Array<const MidiEvent *> addedEvents;
+        addedEvents.ensureStorageAllocated(group.size());
+
         for (int i = 0; i < group.size(); ++i)
         {
             const auto &eventParams = group.getReference(i);
             auto *ownedEvent = new AnnotationEvent(this, eventParams);
             jassert(ownedEvent->isValid());
             this->midiEvents.addSorted(*ownedEvent, ownedEvent);
-            this->eventDispatcher.dispatchAddEvent(*ownedEvent);
+            addedEvents.add(ownedEvent);
         }
+
+        this->eventDispatcher.dispatchAddEvents(addedEvents);
         
         this->updateBeatRange(true);
     }
@@ -167,17 +172,34 @@ bool AnnotationsSequence::removeGroup(Array<AnnotationEvent> &group, bool undoab
     }
     else
     {
+        // find all the events first, so that the listeners get notified
+        // once per group while the events are still in the sequence
+        SortedSet<int> indices;
+        indices.ensureStorageAllocated(group.size());
+        Array<const MidiEvent *> removedEvents;
+        removedEvents.ensureStorageAllocated(group.size());
+
         for (int i = 0; i < group.size(); ++i)
         {
             const AnnotationEvent &annotation = group.getReference(i);
             const int index = this->midiEvents.indexOfSorted(annotation, &annotation);
             if (index >= 0)
             {
-                auto *removedEvent = this->midiEvents.getUnchecked(index);
-                this->eventDispatcher.dispatchRemoveEvent(*removedEvent);
-                this->midiEvents.remove(index, true);
+                indices.add(index);
             }
         }
+
+        for (const auto index : indices)
+        {
+            removedEvents.add(this->midiEvents.getUnchecked(index));
+        }
+
+        this->eventDispatcher.dispatchRemoveEvents(removedEvents);
+
+        for (int i = indices.size(); i --> 0 ;)
+        {
+            this->midiEvents.remove(indices.getUnchecked(i), true);
+        }
         
         this->updateBeatRange(true);
         this->eventDispatcher.dispatchPostRemoveEvent(this);
@@ -199,6 +221,10 @@ bool AnnotationsSequence::changeGroup(Array<AnnotationEvent> &groupBefore,
     }
     else
     {
+        Array<const MidiEvent *> oldEvents, newEvents;
+        oldEvents.ensureStorageAllocated(groupBefore.size());
+        newEvents.ensureStorageAllocated(groupBefore.size());
+
         for (int i = 0; i < groupBefore.size(); ++i)
         {
             const AnnotationEvent &oldParams = groupBefore.getReference(i);
@@ -210,10 +236,13 @@ bool AnnotationsSequence::changeGroup(Array<AnnotationEvent> &groupBefore,
                 changedEvent->applyChanges(newParams);
                 this->midiEvents.remove(index, false);
                 this->midiEvents.addSorted(*changedEvent, changedEvent);
-                this->eventDispatcher.dispatchChangeEvent(oldParams, *changedEvent);
+                oldEvents.add(&oldParams);
+                newEvents.add(changedEvent);
             }
         }
 
+        this->eventDispatcher.dispatchChangeEvents(oldEvents, newEvents);
+
         this->updateBeatRange(true);
     }
 
@@ -18,12 +18,17 @@
 #include "Common.h"
 #include "AutomationSequence.h"
 #include "AutomationEventActions.h"
+#include "MidiExportBuffer.h"
+#include "MidiTrack.h"
 
 #include "ProjectNode.h"
 #include "ProjectListener.h"
 #include "MidiTrackNode.h"
 #include "UndoStack.h"
 
+#define CURVE_INTERPOLATION_MIN_STEP_BEAT (1.f / 32.f)
+#define CURVE_INTERPOLATION_MAX_STEP_BEAT (1.f)
+
 AutomationSequence::AutomationSequence(MidiTrack &track,
     ProjectEventDispatcher &dispatcher) noexcept :
     MidiSequence(track, dispatcher) {}
@@ -36,7 +41,9 @@ void AutomationSequence::importMidi(const MidiMessageSequence &sequence, short t
 {
     this->clearUndoHistory();
     this->checkpoint();
-    
+
+    Array<AutomationEvent> controllerEvents;
+
     for (int i = 0; i < sequence.getNumEvents(); ++i)
     {
         const MidiMessage &message = sequence.getEventPointer(i)->message;
@@ -44,8 +51,7 @@ void AutomationSequence::importMidi(const MidiMessageSequence &sequence, short t
         if (message.isController())
         {
             const int controllerValue = message.getControllerValue();
-            const AutomationEvent event(this, startBeat, float(controllerValue) / 127.f);
-            this->importMidiEvent<AutomationEvent>(event);
+            controllerEvents.add(AutomationEvent(this, startBeat, float(controllerValue) / 127.f));
         }
         else if (message.isTempoMetaEvent())
         {
@@ -54,10 +60,244 @@ void AutomationSequence::importMidi(const MidiMessageSequence &sequence, short t
             this->importMidiEvent<AutomationEvent>(event);
         }
     }
+
+    // the controller data recorded from hardware may have thousands
+    // of events per minute, most of which are not needed to keep the shape
+    const auto redundantEvents = findRedundantEvents(controllerEvents,
+        AUTOMATION_SIMPLIFICATION_TOLERANCE, this->getTrack()->isOnOffAutomationTrack());
+
+    for (int i = 0, r = 0; i < controllerEvents.size(); ++i)
+    {
+        if (r < redundantEvents.size() && redundantEvents.getUnchecked(r) == i)
+        {
+            r++;
+            continue;
+        }
+
+        this->importMidiEvent<AutomationEvent>(controllerEvents.getReference(i));
+    }
     
     this->updateBeatRange(false);
 }
 
+bool AutomationSequence::simplify(float tolerance, bool undoable)
+{
+    Array<AutomationEvent> events;
+    events.ensureStorageAllocated(this->midiEvents.size());
+    for (const auto *event : this->midiEvents)
+    {
+        events.add(*static_cast<const AutomationEvent *>(event));
+    }
+
+    const auto redundantEvents = findRedundantEvents(events,
+        tolerance, this->getTrack()->isOnOffAutomationTrack());
+
+    if (redundantEvents.isEmpty())
+    {
+        return false;
+    }
+
+    Array<AutomationEvent> removedEvents;
+    removedEvents.ensureStorageAllocated(redundantEvents.size());
+    for (const auto i : redundantEvents)
+    {
+        removedEvents.add(events.getReference(i));
+    }
+
+    return this->removeGroup(removedEvents, undoable);
+}
+
+Array<int> AutomationSequence::findRedundantEvents(const Array<AutomationEvent> &events,
+    float tolerance, bool isOnOffCurve)
+{
+    Array<int> result;
+    if (events.size() < 3)
+    {
+        return result;
+    }
+
+    Array<bool> keptEvents;
+    keptEvents.insertMultiple(0, false, events.size());
+    keptEvents.setUnchecked(0, true);
+    keptEvents.setUnchecked(events.size() - 1, true);
+
+    // not recursive, since the recorded curves can be really long
+    Array<Range<int>> segments;
+    segments.add({ 0, events.size() - 1 });
+
+    while (!segments.isEmpty())
+    {
+        const auto segment = segments.removeAndReturn(segments.size() - 1);
+        const auto &start = events.getReference(segment.getStart());
+        const auto &end = events.getReference(segment.getEnd());
+        const float length = end.getBeat() - start.getBeat();
+
+        float maxError = tolerance;
+        int maxErrorIndex = -1;
+
+        for (int i = segment.getStart() + 1; i < segment.getEnd(); ++i)
+        {
+            const auto &event = events.getReference(i);
+
+            // the on/off curves are not interpolated, they are just steps
+            const float simplifiedValue = (isOnOffCurve || length <= 0.f) ?
+                start.getControllerValue() :
+                AutomationEvent::interpolateEvents(start.getControllerValue(),
+                    end.getControllerValue(), (event.getBeat() - start.getBeat()) / length,
+                    start.getCurvature());
+
+            const float error = fabsf(event.getControllerValue() - simplifiedValue);
+            if (error > maxError)
+            {
+                maxError = error;
+                maxErrorIndex = i;
+            }
+        }
+
+        if (maxErrorIndex >= 0)
+        {
+            keptEvents.setUnchecked(maxErrorIndex, true);
+            segments.add({ segment.getStart(), maxErrorIndex });
+            segments.add({ maxErrorIndex, segment.getEnd() });
+        }
+    }
+
+    for (int i = 0; i < keptEvents.size(); ++i)
+    {
+        if (!keptEvents.getUnchecked(i))
+        {
+            result.add(i);
+        }
+    }
+
+    return result;
+}
+
+void AutomationSequence::exportMidi(MidiExportBuffer &outBuffer, const Clip &clip,
+    bool soloPlaybackMode, double timeAdjustment, double timeFactor) const
+{
+    if (!this->isClipAudible(clip, soloPlaybackMode))
+    {
+        return;
+    }
+
+    const auto *track = this->getTrack();
+    const bool isTempoTrack = track->isTempoTrack();
+    const int channel = this->getChannel();
+    const int controllerNumber = track->getTrackControllerNumber();
+
+    for (const auto &point : this->getInterpolatedCurve())
+    {
+        auto message = AutomationEvent::createMessage(point.controllerValue,
+            isTempoTrack, channel, controllerNumber);
+
+        message.setTimeStamp((point.beat + clip.getBeat()) * timeFactor);
+        outBuffer.add(message, timeAdjustment);
+    }
+}
+
+void AutomationSequence::exportKeyEvents(MidiExportBuffer &outBuffer, const Clip &clip,
+    bool soloPlaybackMode, double timeAdjustment, double timeFactor) const
+{
+    if (!this->isClipAudible(clip, soloPlaybackMode))
+    {
+        return;
+    }
+
+    const auto *track = this->getTrack();
+    const bool isTempoTrack = track->isTempoTrack();
+    const int channel = this->getChannel();
+    const int controllerNumber = track->getTrackControllerNumber();
+
+    for (const auto *event : this->midiEvents)
+    {
+        const auto *automationEvent = static_cast<const AutomationEvent *>(event);
+        auto message = AutomationEvent::createMessage(automationEvent->getControllerValue(),
+            isTempoTrack, channel, controllerNumber);
+
+        message.setTimeStamp((automationEvent->getBeat() + clip.getBeat()) * timeFactor);
+        outBuffer.add(message, timeAdjustment);
+    }
+}
+
+const Array<AutomationSequence::CurvePoint> &AutomationSequence::getInterpolatedCurve() const
+{
+    if (!this->interpolatedCurveIsOutdated)
+    {
+        return this->interpolatedCurve;
+    }
+
+    auto &curve = this->interpolatedCurve;
+    curve.clearQuick();
+    curve.ensureStorageAllocated(this->midiEvents.size());
+
+    const bool isPedalOrSwitchTrack = this->getTrack()->isOnOffAutomationTrack();
+
+    for (int i = 0; i < this->midiEvents.size(); ++i)
+    {
+        const auto *event = static_cast<const AutomationEvent *>(this->midiEvents.getUnchecked(i));
+        curve.add({ event->getBeat(), event->getControllerValue() });
+
+        if (isPedalOrSwitchTrack || i == this->midiEvents.size() - 1)
+        {
+            continue;
+        }
+
+        const auto *nextEvent = static_cast<const AutomationEvent *>(this->midiEvents.getUnchecked(i + 1));
+        const float startBeat = event->getBeat();
+        const float length = nextEvent->getBeat() - startBeat;
+        if (length <= 0.f)
+        {
+            continue;
+        }
+
+        const auto valueAt = [&](float beat)
+        {
+            return AutomationEvent::interpolateEvents(event->getControllerValue(),
+                nextEvent->getControllerValue(), jmin(1.f, (beat - startBeat) / length),
+                event->getCurvature());
+        };
+
+        float beat = startBeat;
+        float value = event->getControllerValue();
+        float lastAppliedValue = value;
+
+        while (true)
+        {
+            // the step is how long it takes for the curve to change by the threshold,
+            // judging by the slope at the current point, within some sane limits:
+            const float slope = fabsf(valueAt(beat + CURVE_INTERPOLATION_MIN_STEP_BEAT) - value) /
+                CURVE_INTERPOLATION_MIN_STEP_BEAT;
+
+            const float step = (slope > 0.f) ?
+                jlimit(CURVE_INTERPOLATION_MIN_STEP_BEAT, CURVE_INTERPOLATION_MAX_STEP_BEAT,
+                    CURVE_INTERPOLATION_THRESHOLD / slope) :
+                CURVE_INTERPOLATION_MAX_STEP_BEAT;
+
+            beat += step;
+            if (beat >= nextEvent->getBeat())
+            {
+                break;
+            }
+
+            value = valueAt(beat);
+            if (fabsf(value - lastAppliedValue) > CURVE_INTERPOLATION_THRESHOLD)
+            {
+                curve.add({ beat, value });
+                lastAppliedValue = value;
+            }
+        }
+    }
+
+    this->interpolatedCurveIsOutdated = false;
+    return curve;
+}
+
+void AutomationSequence::invalidateCaches() noexcept
+{
+    this->interpolatedCurveIsOutdated = true;
+}
+
 //===----------------------------------------------------------------------===//
 // Undoable track editing
 //===----------------------------------------------------------------------===//
@@ -148,13 +388,18 @@ bool AutomationSequence::insertGroup(Array<AutomationEvent> &group, bool undoabl
     }
     else
     {
+        Array<const MidiEvent *> addedEvents;
+        addedEvents.ensureStorageAllocated(group.size());
+
         for (int i = 0; i < group.size(); ++i)
         {
             const auto &eventParams = group.getUnchecked(i);
             auto *ownedEvent = new AutomationEvent(this, eventParams);
             this->midiEvents.addSorted(*ownedEvent, ownedEvent);
-            this->eventDispatcher.dispatchAddEvent(*ownedEvent);
+            addedEvents.add(ownedEvent);
         }
+
+        this->eventDispatcher.dispatchAddEvents(addedEvents);
         
         this->updateBeatRange(true);
     }
@@ -172,17 +417,34 @@ bool AutomationSequence::removeGroup(Array<AutomationEvent> &group, bool undoabl
     }
     else
     {
+        // find all the events first, so that the listeners get notified
+        // once per group while the events are still in the sequence
+        SortedSet<int> indices;
+        indices.ensureStorageAllocated(group.size());
+        Array<const MidiEvent *> removedEvents;
+        removedEvents.ensureStorageAllocated(group.size());
+
         for (int i = 0; i < group.size(); ++i)
         {
             const AutomationEvent &autoEvent = group.getUnchecked(i);
             const int index = this->midiEvents.indexOfSorted(autoEvent, &autoEvent);
             if (index >= 0)
             {
-                const auto removedEvent = this->midiEvents[index];
-                this->eventDispatcher.dispatchRemoveEvent(*removedEvent);
-                this->midiEvents.remove(index, true);
+                indices.add(index);
             }
         }
+
+        for (const auto index : indices)
+        {
+            removedEvents.add(this->midiEvents.getUnchecked(index));
+        }
+
+        this->eventDispatcher.dispatchRemoveEvents(removedEvents);
+
+        for (int i = indices.size(); i --> 0 ;)
+        {
+            this->midiEvents.remove(indices.getUnchecked(i), true);
+        }
         
         this->updateBeatRange(true);
         this->eventDispatcher.dispatchPostRemoveEvent(this);
@@ -204,6 +466,10 @@ bool AutomationSequence::changeGroup(const Array<AutomationEvent> groupBefore,
     }
     else
     {
+        Array<const MidiEvent *> oldEvents, newEvents;
+        oldEvents.ensureStorageAllocated(groupBefore.size());
+        newEvents.ensureStorageAllocated(groupBefore.size());
+
         for (int i = 0; i < groupBefore.size(); ++i)
         {
             const AutomationEvent &oldParams = groupBefore.getUnchecked(i);
@@ -215,9 +481,12 @@ bool AutomationSequence::changeGroup(const Array<AutomationEvent> groupBefore,
                 changedEvent->applyChanges(newParams);
                 this->midiEvents.remove(index, false);
                 this->midiEvents.addSorted(*changedEvent, changedEvent);
-                this->eventDispatcher.dispatchChangeEvent(oldParams, *changedEvent);
+                oldEvents.add(&oldParams);
+                newEvents.add(changedEvent);
             }
         }
+
+        this->eventDispatcher.dispatchChangeEvents(oldEvents, newEvents);
         
         this->updateBeatRange(true);
     }
@@ -277,4 +546,5 @@ void AutomationSequence::reset()
 {
     this->midiEvents.clear();
     this->usedEventIds.clear();
+    this->invalidateCaches();
 }
@@ -20,6 +20,10 @@
 #include "MidiSequence.h"
 #include "AutomationEvent.h"
 
+// half a step of 7-bit controller value, so that the simplified curve
+// is still exported almost the same, yet dense recordings get way smaller
+#define AUTOMATION_SIMPLIFICATION_TOLERANCE (0.5f / 127.f)
+
 class AutomationSequence final : public MidiSequence
 {
 public:
@@ -43,11 +47,34 @@ public:
         Array<AutomationEvent> eventsAfter,
         bool undoable);
 
+    // Removes the events which barely affect the curve's shape,
+    // e.g. the dense controller data recorded from hardware
+    bool simplify(float tolerance, bool undoable);
+
     //===------------------------------------------------------------------===//
     // Import/export
     //===------------------------------------------------------------------===//
 
     void importMidi(const MidiMessageSequence &sequence, short timeFormat) override;
+    void exportMidi(MidiExportBuffer &outBuffer, const Clip &clip,
+        bool soloPlaybackMode, double timeAdjustment, double timeFactor) const override;
+
+    // Only the events themselves, without the interpolated points:
+    // the playback doesn't need the dense tempo ramps, since
+    // the tempo map integrates them from the curve anyway
+    void exportKeyEvents(MidiExportBuffer &outBuffer, const Clip &clip,
+        bool soloPlaybackMode, double timeAdjustment, double timeFactor) const;
+
+    // All events along with the points interpolated between them,
+    // placed more densely where the curve is steep and sparsely where it's flat;
+    // rendered in a single pass over the sequence and cached until it changes
+    struct CurvePoint final
+    {
+        float beat;
+        float controllerValue;
+    };
+
+    const Array<CurvePoint> &getInterpolatedCurve() const;
 
     //===------------------------------------------------------------------===//
     // Serializable
@@ -56,8 +83,22 @@ public:
     SerializedData serialize() const override;
     void deserialize(const SerializedData &data) override;
     void reset() override;
-    
+
+protected:
+
+    void invalidateCaches() noexcept override;
+
 private:
 
+    // Ramer-Douglas-Peucker, except that the error is measured vertically,
+    // and not against the straight lines, but against the curves interpolated
+    // between the kept events with their curvature; returns the sorted indices
+    // of events to drop, the first and the last events are always kept
+    static Array<int> findRedundantEvents(const Array<AutomationEvent> &events,
+        float tolerance, bool isOnOffCurve);
+
+    mutable Array<CurvePoint> interpolatedCurve;
+    mutable bool interpolatedCurveIsOutdated = true;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AutomationSequence);
 };
@@ -17,6 +17,7 @@
 
 #include "Common.h"
 #include "AnnotationEvent.h"
+#include "MidiExportBuffer.h"
 #include "MidiSequence.h"
 #include "SerializationKeys.h"
 
@@ -42,12 +43,12 @@ AnnotationEvent::AnnotationEvent(WeakReference<MidiSequence> owner,
     description(parametersToCopy.description),
     colour(parametersToCopy.colour) {}
 
-void AnnotationEvent::exportMessages(MidiMessageSequence &outSequence,
+void AnnotationEvent::exportMessages(MidiExportBuffer &outBuffer,
     const Clip &clip, double timeOffset, double timeFactor) const noexcept
 {
     MidiMessage event(MidiMessage::textMetaEvent(1, this->getDescription()));
     event.setTimeStamp((this->beat + clip.getBeat()) * timeFactor);
-    outSequence.addEvent(event, timeOffset);
+    outBuffer.add(event, timeOffset);
 }
 
 AnnotationEvent AnnotationEvent::withDeltaBeat(float beatOffset) const noexcept
@@ -116,7 +117,7 @@ SerializedData AnnotationEvent::serialize() const
 {
     using namespace Serialization;
     SerializedData tree(Midi::annotation);
-    tree.setProperty(Midi::id, this->id);
+    tree.setProperty(Midi::id, this->id.toString());
     tree.setProperty(Midi::text, this->description);
     tree.setProperty(Midi::colour, this->colour.toString());
     tree.setProperty(Midi::timestamp, int(this->beat * TICKS_PER_BEAT));
@@ -130,7 +131,7 @@ void AnnotationEvent::deserialize(const SerializedData &data)
     this->description = data.getProperty(Midi::text);
     this->colour = Colour::fromString(data.getProperty(Midi::colour).toString());
     this->beat = float(data.getProperty(Midi::timestamp)) / TICKS_PER_BEAT;
-    this->id = data.getProperty(Midi::id);
+    this->id = Id(data.getProperty(Midi::id).toString());
 }
 
 void AnnotationEvent::reset() noexcept {}
@@ -17,6 +17,7 @@
 
 #include "Common.h"
 #include "AutomationEvent.h"
+#include "MidiExportBuffer.h"
 #include "MidiSequence.h"
 #include "Transport.h"
 #include "SerializationKeys.h"
@@ -85,67 +86,27 @@ float AutomationEvent::interpolateEvents(float cv1, float cv2, float factor, flo
     return cv1 + (easeIn + easeOut);
 }
 
-void AutomationEvent::exportMessages(MidiMessageSequence &outSequence,
+void AutomationEvent::exportMessages(MidiExportBuffer &outBuffer,
     const Clip &clip, double timeOffset, double timeFactor) const noexcept
 {
-    MidiMessage cc;
-    const bool isTempoTrack = this->getSequence()->getTrack()->isTempoTrack();
-
-    if (isTempoTrack)
-    {
-        cc = MidiMessage::tempoMetaEvent(Transport::getTempoByControllerValue(this->controllerValue));
-    }
-    else
-    {
-        cc = MidiMessage::controllerEvent(this->getTrackChannel(),
-            this->getTrackControllerNumber(), int(this->controllerValue * 127));
-    }
+    auto cc = AutomationEvent::createMessage(this->controllerValue,
+        this->getSequence()->getTrack()->isTempoTrack(),
+        this->getTrackChannel(), this->getTrackControllerNumber());
 
     const double startTime = (this->beat + clip.getBeat()) * timeFactor;
     cc.setTimeStamp(startTime);
-    outSequence.addEvent(cc, timeOffset);
+    outBuffer.add(cc, timeOffset);
+}
 
-    // add interpolated events, if needed
-    const int indexOfThis = this->getSequence()->indexOfSorted(this);
-    const bool isPedalOrSwitchEvent = this->getSequence()->getTrack()->isOnOffAutomationTrack();
-    if (!isPedalOrSwitchEvent && indexOfThis >= 0 && indexOfThis < (this->getSequence()->size() - 1))
+MidiMessage AutomationEvent::createMessage(float controllerValue,
+    bool isTempoTrack, int channel, int controllerNumber) noexcept
+{
+    if (isTempoTrack)
     {
-        const auto *nextEvent = static_cast<AutomationEvent *>(this->getSequence()->getUnchecked(indexOfThis + 1));
-        float interpolatedBeat = this->beat + CURVE_INTERPOLATION_STEP_BEAT;
-        float lastAppliedValue = this->controllerValue;
-
-        while (interpolatedBeat < nextEvent->beat)
-        {
-            const float factor = (interpolatedBeat - this->beat) / (nextEvent->beat - this->beat);
-
-            const float interpolatedValue =
-                AutomationEvent::interpolateEvents(this->controllerValue,
-                    nextEvent->controllerValue, factor, this->curvature);
-
-            const float controllerDelta = fabs(interpolatedValue - lastAppliedValue);
-            if (controllerDelta > CURVE_INTERPOLATION_THRESHOLD)
-            {
-                const double interpolatedTs = (interpolatedBeat + clip.getBeat()) * timeFactor;
-                if (isTempoTrack)
-                {
-                    MidiMessage ci(MidiMessage::tempoMetaEvent(Transport::getTempoByControllerValue(interpolatedValue)));
-                    ci.setTimeStamp(interpolatedTs);
-                    outSequence.addEvent(ci, timeOffset);
-                }
-                else
-                {
-                    MidiMessage ci(MidiMessage::controllerEvent(this->getTrackChannel(),
-                        this->getTrackControllerNumber(), int(interpolatedValue * 127)));
-                    ci.setTimeStamp(interpolatedTs);
-                    outSequence.addEvent(ci, timeOffset);
-                }
-
-                lastAppliedValue = interpolatedValue;
-            }
-
-            interpolatedBeat += CURVE_INTERPOLATION_STEP_BEAT;
-        }
+        return MidiMessage::tempoMetaEvent(Transport::getTempoByControllerValue(controllerValue));
     }
+
+    return MidiMessage::controllerEvent(channel, controllerNumber, int(controllerValue * 127));
 }
 
 AutomationEvent AutomationEvent::copyWithNewId(WeakReference<MidiSequence> owner) const noexcept
@@ -258,7 +219,7 @@ SerializedData AutomationEvent::serialize() const
 {
     using namespace Serialization;
     SerializedData tree(Midi::automationEvent);
-    tree.setProperty(Midi::id, this->id);
+    tree.setProperty(Midi::id, this->id.toString());
     tree.setProperty(Midi::value, this->controllerValue);
     tree.setProperty(Midi::curve, this->curvature);
     tree.setProperty(Midi::timestamp, int(this->beat * TICKS_PER_BEAT));
@@ -272,7 +233,7 @@ void AutomationEvent::deserialize(const SerializedData &data)
     this->controllerValue = float(data.getProperty(Midi::value));
     this->curvature = float(data.getProperty(Midi::curve, AUTOEVENT_DEFAULT_CURVATURE));
     this->beat = float(data.getProperty(Midi::timestamp)) / TICKS_PER_BEAT;
-    this->id = data.getProperty(Midi::id);
+    this->id = Id(data.getProperty(Midi::id).toString());
 }
 
 void AutomationEvent::reset() noexcept {}
@@ -18,6 +18,7 @@
 #pragma once
 
 #include "MidiEvent.h"
+#include "ObjectPool.h"
 
 #define DEFAULT_ON_OFF_EVENT_STATE (false)
 #define CURVE_INTERPOLATION_STEP_BEAT (0.25f)
@@ -35,9 +36,14 @@ public:
         float beatVal = 0.f,
         float controllerValue = 0.f) noexcept;
 
-    void exportMessages(MidiMessageSequence &outSequence, const Clip &clip,
+    // Exports this event only: the interpolated curve between the events
+    // is rendered by AutomationSequence, which needs to know the neighbours
+    void exportMessages(MidiExportBuffer &outBuffer, const Clip &clip,
         double timeOffset, double timeFactor) const noexcept override;
 
+    static MidiMessage createMessage(float controllerValue, bool isTempoTrack,
+        int channel, int controllerNumber) noexcept;
+
     static float interpolateEvents(float cv1, float cv2, float factor, float easing);
 
     AutomationEvent copyWithNewId(WeakReference<MidiSequence> owner = nullptr) const noexcept;
@@ -87,5 +93,6 @@ protected:
 
 private:
 
+    POOL_ALLOCATED(AutomationEvent)
     JUCE_LEAK_DETECTOR(AutomationEvent);
 };
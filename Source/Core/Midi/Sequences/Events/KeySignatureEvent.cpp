@@ -17,6 +17,7 @@
 
 #include "Common.h"
 #include "KeySignatureEvent.h"
+#include "MidiExportBuffer.h"
 #include "MidiSequence.h"
 #include "SerializationKeys.h"
 
@@ -54,7 +55,7 @@ String KeySignatureEvent::toString() const
     return keyName + ", " + this->scale->getLocalizedName();
 }
 
-void KeySignatureEvent::exportMessages(MidiMessageSequence &outSequence,
+void KeySignatureEvent::exportMessages(MidiExportBuffer &outBuffer,
     const Clip &clip, double timeOffset, double timeFactor) const noexcept
 {
     // Basically, we can have any non-standard scale here:
@@ -78,7 +79,7 @@ void KeySignatureEvent::exportMessages(MidiMessageSequence &outSequence,
 
     MidiMessage event(MidiMessage::keySignatureMetaEvent(flatsOrSharps, isMinor));
     event.setTimeStamp((this->beat + clip.getBeat()) * timeFactor);
-    outSequence.addEvent(event, timeOffset);
+    outBuffer.add(event, timeOffset);
 }
 
 KeySignatureEvent KeySignatureEvent::withDeltaBeat(float beatOffset) const noexcept
@@ -145,7 +146,7 @@ SerializedData KeySignatureEvent::serialize() const
 {
     using namespace Serialization;
     SerializedData tree(Midi::keySignature);
-    tree.setProperty(Midi::id, this->id);
+    tree.setProperty(Midi::id, this->id.toString());
     tree.setProperty(Midi::key, this->rootKey);
     tree.setProperty(Midi::timestamp, int(this->beat * TICKS_PER_BEAT));
     tree.appendChild(this->scale->serialize());
@@ -158,7 +159,7 @@ void KeySignatureEvent::deserialize(const SerializedData &data)
     using namespace Serialization;
     this->rootKey = data.getProperty(Midi::key, 0);
     this->beat = float(data.getProperty(Midi::timestamp)) / TICKS_PER_BEAT;
-    this->id = data.getProperty(Midi::id);
+    this->id = Id(data.getProperty(Midi::id).toString());
 
     this->scale = new Scale();
     this->scale->deserialize(data);
@@ -17,14 +17,17 @@
 
 #pragma once
 
+#include "MidiEventId.h"
+
 class Clip;
+class MidiExportBuffer;
 class MidiSequence;
 
 class MidiEvent : public Serializable
 {
 public:
 
-    using Id = String;
+    using Id = MidiEventId;
 
     // Non-serialized field to be used instead of expensive dynamic casts:
     enum class Type : uint8 
@@ -52,7 +55,7 @@ public:
     // with custom parameters (assumes the id is already valid and unique)
     MidiEvent(WeakReference<MidiSequence> owner, const MidiEvent &parameters) noexcept;
 
-    virtual void exportMessages(MidiMessageSequence &outSequence,
+    virtual void exportMessages(MidiExportBuffer &outBuffer,
         const Clip &clip, double timeOffset, double timeFactor) const noexcept = 0;
 
     //===------------------------------------------------------------------===//
@@ -94,6 +97,7 @@ protected:
     Id createId() const noexcept;
 
     friend struct MidiEventHash;
+    friend class MidiSequence;
 
 };
 
@@ -101,13 +105,6 @@ struct MidiEventHash
 {
     inline HashCode operator()(const MidiEvent &key) const noexcept
     {
-        // Earlier, this function looked like this:
-        // return static_cast<HashCode>(key.beat) + static_cast<HashCode>(key.getId().hashCode());
-
-        // For speed and simplicity's sake we assume that id is not empty,
-        // and is at least of 2 characters (which it should be in all cases).
-        // There are no safety checks and all, but it should work:
-        const auto *ptr = key.id.getCharPointer().getAddress();
-        return 64 * static_cast<HashCode>(ptr[0]) + static_cast<HashCode>(ptr[1]);
+        return MidiEventIdHash()(key.id);
     }
 };
@@ -0,0 +1,104 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Common.h"
+#include "MidiEventId.h"
+
+#define MIDI_EVENT_ID_BITS_PER_CHAR 6
+#define MIDI_EVENT_ID_CHAR_MASK 0x3f
+
+static inline uint64 charToCode(juce_wchar c) noexcept
+{
+    if (c >= '0' && c <= '9') { return uint64(c - '0') + 1; }
+    if (c >= 'A' && c <= 'Z') { return uint64(c - 'A') + 11; }
+    if (c >= 'a' && c <= 'z') { return uint64(c - 'a') + 37; }
+    return 0;
+}
+
+static inline char codeToChar(uint64 code) noexcept
+{
+    if (code <= 10) { return char('0' + code - 1); }
+    if (code <= 36) { return char('A' + code - 11); }
+    return char('a' + code - 37);
+}
+
+MidiEventId::MidiEventId(const String &string) noexcept
+{
+    // the ids are always generated by MidiSequence,
+    // so anything else must be some broken data:
+    jassert(string.length() <= MIDI_EVENT_ID_MAX_LENGTH);
+
+    int i = 0;
+    for (auto ptr = string.getCharPointer();
+        !ptr.isEmpty() && i < MIDI_EVENT_ID_MAX_LENGTH; ++i)
+    {
+        const auto code = charToCode(ptr.getAndAdvance());
+        jassert(code != 0);
+        const auto shift = (MIDI_EVENT_ID_MAX_LENGTH - 1 - i) * MIDI_EVENT_ID_BITS_PER_CHAR;
+        this->packed |= (code << shift);
+    }
+}
+
+String MidiEventId::toString() const
+{
+    char result[MIDI_EVENT_ID_MAX_LENGTH + 1] = {};
+
+    for (int i = 0; i < MIDI_EVENT_ID_MAX_LENGTH; ++i)
+    {
+        const auto shift = (MIDI_EVENT_ID_MAX_LENGTH - 1 - i) * MIDI_EVENT_ID_BITS_PER_CHAR;
+        const auto code = (this->packed >> shift) & MIDI_EVENT_ID_CHAR_MASK;
+        if (code == 0)
+        {
+            break;
+        }
+
+        result[i] = codeToChar(code);
+    }
+
+    return String(result);
+}
+
+uint64 MidiEventId::getCompactValue() const noexcept
+{
+    auto value = this->packed;
+    while (value != 0 && (value & MIDI_EVENT_ID_CHAR_MASK) == 0)
+    {
+        value >>= MIDI_EVENT_ID_BITS_PER_CHAR;
+    }
+
+    return value;
+}
+
+MidiEventId MidiEventId::fromCompactValue(uint64 value) noexcept
+{
+    MidiEventId result;
+
+    int numChars = 0;
+    for (auto v = value; v != 0; v >>= MIDI_EVENT_ID_BITS_PER_CHAR)
+    {
+        numChars++;
+    }
+
+    if (numChars > MIDI_EVENT_ID_MAX_LENGTH)
+    {
+        jassertfalse;
+        return result;
+    }
+
+    result.packed = value << ((MIDI_EVENT_ID_MAX_LENGTH - numChars) * MIDI_EVENT_ID_BITS_PER_CHAR);
+    return result;
+}
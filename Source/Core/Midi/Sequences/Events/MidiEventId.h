@@ -0,0 +1,81 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+// The longest id that fits in 64 bits, 6 bits per character
+#define MIDI_EVENT_ID_MAX_LENGTH 10
+
+// Event ids are the short random strings of [0-9A-Za-z], unique within
+// a track; instead of keeping them as strings, they are packed into
+// a single integer, 6 bits per character, the first one in the highest
+// bits, and zero code meaning the end of the string; this way, comparing
+// the ids is just comparing integers, and the order is still the same as
+// the strings' order, while the string form is kept in the serialized
+// data and VCS deltas, so it all round-trips to what was there before
+
+class MidiEventId final
+{
+public:
+
+    MidiEventId() noexcept = default;
+    explicit MidiEventId(const String &string) noexcept;
+
+    MidiEventId(const MidiEventId &other) noexcept = default;
+    MidiEventId &operator= (const MidiEventId &other) noexcept = default;
+
+    String toString() const;
+
+    inline bool isEmpty() const noexcept { return this->packed == 0; }
+    inline bool isNotEmpty() const noexcept { return this->packed != 0; }
+    inline uint64 getPackedValue() const noexcept { return this->packed; }
+
+    // the packed value without the trailing empty characters, so that
+    // the short ids are small numbers, e.g. for PackedColumn's varints
+    uint64 getCompactValue() const noexcept;
+    static MidiEventId fromCompactValue(uint64 value) noexcept;
+
+    inline int compare(const MidiEventId &other) const noexcept
+    {
+        return (this->packed > other.packed) - (this->packed < other.packed);
+    }
+
+    friend inline bool operator==(const MidiEventId &l, const MidiEventId &r) noexcept
+    { return l.packed == r.packed; }
+
+    friend inline bool operator!=(const MidiEventId &l, const MidiEventId &r) noexcept
+    { return l.packed != r.packed; }
+
+private:
+
+    uint64 packed = 0;
+
+};
+
+struct MidiEventIdHash
+{
+    inline HashCode operator()(const MidiEventId &key) const noexcept
+    {
+        // the ids are random, but most of them are 2-3 characters long,
+        // so all the entropy is in the highest bits, which need mixing
+        // (this is the splitmix64's finalizer):
+        auto x = key.getPackedValue();
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+        return static_cast<HashCode>(x ^ (x >> 31));
+    }
+};
@@ -17,6 +17,7 @@
 
 #include "Common.h"
 #include "Note.h"
+#include "MidiExportBuffer.h"
 #include "MidiSequence.h"
 #include "SerializationKeys.h"
 
@@ -37,16 +38,25 @@ Note::Note(WeakReference<MidiSequence> owner, const Note &parametersToCopy) noex
     velocity(parametersToCopy.velocity),
     tuplet(parametersToCopy.tuplet) {}
 
-void Note::exportMessages(MidiMessageSequence &outSequence, const Clip &clip,
+void Note::exportMessages(MidiExportBuffer &outBuffer, const Clip &clip,
     double timeOffset, double timeFactor) const noexcept
 {
-    const auto finalKey = this->key + clip.getKey();
-    const auto finalVolume = this->velocity * clip.getVelocity();
-    const auto tupletLength = this->length / float(this->tuplet);
+    Note::exportMessages(outBuffer, clip, this->getTrackChannel(),
+        this->key, this->beat, this->length, this->velocity, this->tuplet,
+        timeOffset, timeFactor);
+}
+
+void Note::exportMessages(MidiExportBuffer &outBuffer, const Clip &clip,
+    int channel, Key keyVal, float beatVal, float lengthVal, float velocityVal, Tuplet tupletVal,
+    double timeOffset, double timeFactor) noexcept
+{
+    const auto finalKey = keyVal + clip.getKey();
+    const auto finalVolume = velocityVal * clip.getVelocity();
+    const auto tupletLength = lengthVal / float(tupletVal);
 
-    for (int i = 0; i < this->tuplet; ++i)
+    for (int i = 0; i < tupletVal; ++i)
     {
-        const float tupletStart = this->beat + tupletLength * float(i);
+        const float tupletStart = beatVal + tupletLength * float(i);
 
         // slightly adjust volume for tuplet sequence: factor fading from 1 to 0.9;
         // this should sound anyway better than the same volume for all tuplets,
@@ -54,10 +64,10 @@ void Note::exportMessages(MidiMessageSequence &outSequence, const Clip &clip,
         // (like implement auto curves for individual notes?)
         const float tupletVolume = finalVolume * (1.f - float(i) / 100.f);
 
-        MidiMessage eventNoteOn(MidiMessage::noteOn(this->getTrackChannel(), finalKey, tupletVolume));
+        MidiMessage eventNoteOn(MidiMessage::noteOn(channel, finalKey, tupletVolume));
         const double startTime = (tupletStart + clip.getBeat()) * timeFactor;
         eventNoteOn.setTimeStamp(startTime);
-        outSequence.addEvent(eventNoteOn, timeOffset);
+        outBuffer.add(eventNoteOn, timeOffset);
 
         // here, when having odd tuplet, note-off event time might end up
         // being slightly after next event's start time, due to rounding errors,
@@ -71,10 +81,10 @@ void Note::exportMessages(MidiMessageSequence &outSequence, const Clip &clip,
         // to make sure end/start times of neighbor notes never overlap:
         const double oddTupletFix = double(i % 2) / 1000;
 
-        MidiMessage eventNoteOff(MidiMessage::noteOff(this->getTrackChannel(), finalKey));
+        MidiMessage eventNoteOff(MidiMessage::noteOff(channel, finalKey));
         const double endTime = (tupletStart + tupletLength + clip.getBeat()) * timeFactor - oddTupletFix;
         eventNoteOff.setTimeStamp(endTime);
-        outSequence.addEvent(eventNoteOff, timeOffset);
+        outBuffer.add(eventNoteOff, timeOffset);
     }
 }
 
@@ -204,7 +214,7 @@ SerializedData Note::serialize() const
 {
     using namespace Serialization;
     SerializedData tree(Midi::note);
-    tree.setProperty(Midi::id, this->id);
+    tree.setProperty(Midi::id, this->id.toString());
     tree.setProperty(Midi::key, this->key);
     tree.setProperty(Midi::timestamp, int(this->beat * TICKS_PER_BEAT));
     tree.setProperty(Midi::length, int(this->length * TICKS_PER_BEAT));
@@ -220,7 +230,7 @@ void Note::deserialize(const SerializedData &data)
 {
     this->reset();
     using namespace Serialization;
-    this->id = data.getProperty(Midi::id);
+    this->id = Id(data.getProperty(Midi::id).toString());
     this->key = data.getProperty(Midi::key);
     this->beat = float(data.getProperty(Midi::timestamp)) / TICKS_PER_BEAT;
     this->length = float(data.getProperty(Midi::length)) / TICKS_PER_BEAT;
@@ -229,6 +239,17 @@ void Note::deserialize(const SerializedData &data)
     this->tuplet = Tuplet(int(data.getProperty(Midi::tuplet, 1)));
 }
 
+void Note::deserialize(const Id &newId, Key newKey, float newBeat,
+    float newLength, float newVelocity, Tuplet newTuplet) noexcept
+{
+    this->id = newId;
+    this->key = newKey;
+    this->beat = newBeat;
+    this->length = newLength;
+    this->velocity = jmax(jmin(newVelocity, 1.f), 0.f);
+    this->tuplet = jmax(Tuplet(1), newTuplet);
+}
+
 void Note::reset() noexcept {}
 
 void Note::applyChanges(const Note &other) noexcept
@@ -241,6 +262,60 @@ void Note::applyChanges(const Note &other) noexcept
     this->tuplet = other.tuplet;
 }
 
+// the raw parameters are assumed to be taken from this very note before,
+// e.g. when undoing a transform, so they are not rounded or clamped again
+void Note::applyChanges(Key newKey, float newBeat,
+    float newLength, float newVelocity, Tuplet newTuplet) noexcept
+{
+    this->beat = newBeat;
+    this->key = newKey;
+    this->length = newLength;
+    this->velocity = newVelocity;
+    this->tuplet = newTuplet;
+}
+
+static float snappedBeat(float beat, float snapsPerBeat)
+{
+    return roundf(beat / snapsPerBeat) * snapsPerBeat;
+}
+
+float Note::Transform::transformBeat(float beat) const noexcept
+{
+    if (!this->changesBeats())
+    {
+        return beat;
+    }
+
+    const float shiftedBeat = roundBeat(beat + this->deltaBeat);
+    return this->changesLengths() ?
+        roundBeat(snappedBeat(shiftedBeat, this->snapsPerBeat)) : shiftedBeat;
+}
+
+void Note::applyTransform(const Transform &transform) noexcept
+{
+    if (transform.changesLengths())
+    {
+        const float shiftedBeat = roundBeat(this->beat + transform.deltaBeat);
+        const float startBeatSnap = snappedBeat(shiftedBeat, transform.snapsPerBeat);
+        const float endBeatSnap = snappedBeat(shiftedBeat + this->length, transform.snapsPerBeat);
+        this->length = jmax(MIN_LENGTH, roundBeat(endBeatSnap - startBeatSnap));
+    }
+
+    // the beat update must be the same as in transformBeat(),
+    // which is used to find the transformed notes for undo:
+    this->beat = transform.transformBeat(this->beat);
+
+    if (transform.changesKeys())
+    {
+        this->key = jlimit(0, 128, this->key + transform.deltaKey);
+    }
+
+    if (transform.changesVelocities())
+    {
+        this->velocity = jlimit(0.f, 1.f, this->velocity * transform.velocityMultiplier);
+    }
+}
+
 int Note::compareElements(const Note *const first, const Note *const second) noexcept
 {
     if (first == second) { return 0; }
@@ -18,6 +18,7 @@
 #pragma once
 
 #include "MidiEvent.h"
+#include "ObjectPool.h"
 
 #define MIDDLE_C 60
 
@@ -41,9 +42,39 @@ public:
          int keyVal = MIDDLE_C, float beatVal = 0.f,
          float lengthVal = 1.f, float velocityVal = 1.f) noexcept;
 
-    void exportMessages(MidiMessageSequence &outSequence, const Clip &clip,
+    void exportMessages(MidiExportBuffer &outBuffer, const Clip &clip,
         double timeOffset, double timeFactor) const noexcept override;
+
+    // the same, but for the packed parameters, see PianoSequence::PackedNotes
+    static void exportMessages(MidiExportBuffer &outBuffer, const Clip &clip,
+        int channel, Key keyVal, float beatVal, float lengthVal, float velocityVal, Tuplet tupletVal,
+        double timeOffset, double timeFactor) noexcept;
     
+    // A kernel of the bulk edits applied to many notes at once,
+    // see PianoSequence::transformGroup; the quantization, if enabled,
+    // snaps both start and end beats, like SequencerOperations::snapSelection
+    struct Transform final
+    {
+        float deltaBeat = 0.f;
+        Key deltaKey = 0;
+        float velocityMultiplier = 1.f;
+        float snapsPerBeat = 0.f;
+
+        inline bool changesBeats() const noexcept
+        { return this->deltaBeat != 0.f || this->snapsPerBeat > 0.f; }
+
+        inline bool changesKeys() const noexcept
+        { return this->deltaKey != 0; }
+
+        inline bool changesLengths() const noexcept
+        { return this->snapsPerBeat > 0.f; }
+
+        inline bool changesVelocities() const noexcept
+        { return this->velocityMultiplier != 1.f; }
+
+        float transformBeat(float beat) const noexcept;
+    };
+
     Note copyWithNewId(WeakReference<MidiSequence> owner = nullptr) const noexcept;
     Note withKey(Key newKey) const noexcept;
     Note withBeat(float newBeat) const noexcept;
@@ -74,11 +105,18 @@ public:
     void deserialize(const SerializedData &data) override;
     void reset() noexcept override;
 
+    // the same, but for the parameters read from the packed
+    // columns of a track, see PianoSequence::deserialize
+    void deserialize(const Id &newId, Key newKey, float newBeat,
+        float newLength, float newVelocity, Tuplet newTuplet) noexcept;
+
     //===------------------------------------------------------------------===//
     // Helpers
     //===------------------------------------------------------------------===//
     
     void applyChanges(const Note &parameters) noexcept;
+    void applyChanges(Key newKey, float newBeat, float newLength, float newVelocity, Tuplet newTuplet) noexcept;
+    void applyTransform(const Transform &transform) noexcept;
 
     static inline int compareElements(const MidiEvent *const first, const MidiEvent *const second) noexcept
     {
@@ -101,5 +139,6 @@ protected:
 
 private:
 
+    POOL_ALLOCATED(Note)
     JUCE_LEAK_DETECTOR(Note);
 };
@@ -159,13 +159,18 @@ bool KeySignaturesSequence::insertGroup(Array<KeySignatureEvent> &group, bool un
     }
     else
     {
+        Array<const MidiEvent *> addedEvents;
+        addedEvents.ensureStorageAllocated(group.size());
+
         for (int i = 0; i < group.size(); ++i)
         {
             const KeySignatureEvent &eventParams = group.getReference(i);
             auto *ownedEvent = new KeySignatureEvent(this, eventParams);
             this->midiEvents.addSorted(*ownedEvent, ownedEvent);
-            this->eventDispatcher.dispatchAddEvent(*ownedEvent);
+            addedEvents.add(ownedEvent);
         }
+
+        this->eventDispatcher.dispatchAddEvents(addedEvents);
         
         this->updateBeatRange(true);
     }
@@ -183,17 +188,34 @@ bool KeySignaturesSequence::removeGroup(Array<KeySignatureEvent> &group, bool un
     }
     else
     {
+        // find all the events first, so that the listeners get notified
+        // once per group while the events are still in the sequence
+        SortedSet<int> indices;
+        indices.ensureStorageAllocated(group.size());
+        Array<const MidiEvent *> removedEvents;
+        removedEvents.ensureStorageAllocated(group.size());
+
         for (int i = 0; i < group.size(); ++i)
         {
             const KeySignatureEvent &signature = group.getReference(i);
             const int index = this->midiEvents.indexOfSorted(signature, &signature);
             if (index >= 0)
             {
-                auto *removedEvent = this->midiEvents.getUnchecked(index);
-                this->eventDispatcher.dispatchRemoveEvent(*removedEvent);
-                this->midiEvents.remove(index, true);
+                indices.add(index);
             }
         }
+
+        for (const auto index : indices)
+        {
+            removedEvents.add(this->midiEvents.getUnchecked(index));
+        }
+
+        this->eventDispatcher.dispatchRemoveEvents(removedEvents);
+
+        for (int i = indices.size(); i --> 0 ;)
+        {
+            this->midiEvents.remove(indices.getUnchecked(i), true);
+        }
         
         this->updateBeatRange(true);
         this->eventDispatcher.dispatchPostRemoveEvent(this);
@@ -215,6 +237,10 @@ bool KeySignaturesSequence::changeGroup(Array<KeySignatureEvent> &groupBefore,
     }
     else
     {
+        Array<const MidiEvent *> oldEvents, newEvents;
+        oldEvents.ensureStorageAllocated(groupBefore.size());
+        newEvents.ensureStorageAllocated(groupBefore.size());
+
         for (int i = 0; i < groupBefore.size(); ++i)
         {
             const KeySignatureEvent &oldParams = groupBefore.getReference(i);
@@ -226,10 +252,13 @@ bool KeySignaturesSequence::changeGroup(Array<KeySignatureEvent> &groupBefore,
                 changedEvent->applyChanges(newParams);
                 this->midiEvents.remove(index, false);
                 this->midiEvents.addSorted(*changedEvent, changedEvent);
-                this->eventDispatcher.dispatchChangeEvent(oldParams, *changedEvent);
+                oldEvents.add(&oldParams);
+                newEvents.add(changedEvent);
             }
         }
 
+        this->eventDispatcher.dispatchChangeEvents(oldEvents, newEvents);
+
         this->updateBeatRange(true);
     }
 
@@ -290,4 +319,85 @@ void KeySignaturesSequence::reset()
 {
     this->midiEvents.clear();
     this->usedEventIds.clear();
+    this->invalidateCaches();
+}
+
+//===----------------------------------------------------------------------===//
+// Harmonic context
+//===----------------------------------------------------------------------===//
+
+const KeySignaturesSequence::HarmonicContext *
+KeySignaturesSequence::findHarmonicContextAt(float beat) const
+{
+    this->rebuildHarmonicContextsIfNeeded();
+    if (this->harmonicContexts.isEmpty())
+    {
+        return nullptr;
+    }
+
+    return &this->harmonicContexts.getReference(this->indexOfHarmonicContextAt(beat));
+}
+
+const KeySignaturesSequence::HarmonicContext *
+KeySignaturesSequence::findHarmonicContext(float startBeat, float endBeat) const
+{
+    const auto *context = this->findHarmonicContextAt(startBeat);
+
+    // the key signatures exactly at the end beat don't count:
+    if (context == nullptr || context->endBeat < endBeat)
+    {
+        return nullptr;
+    }
+
+    return context;
+}
+
+void KeySignaturesSequence::invalidateCaches() noexcept
+{
+    this->harmonicContextsAreOutdated = true;
+}
+
+// the last context starting at or before the beat, or the first one
+int KeySignaturesSequence::indexOfHarmonicContextAt(float beat) const noexcept
+{
+    const auto *begin = this->harmonicContexts.begin();
+    const auto found = std::upper_bound(begin, this->harmonicContexts.end(), beat,
+        [](float b, const HarmonicContext &context) { return b < context.startBeat; });
+
+    return jmax(0, int(found - begin) - 1);
+}
+
+void KeySignaturesSequence::rebuildHarmonicContextsIfNeeded() const
+{
+    if (!this->harmonicContextsAreOutdated)
+    {
+        return;
+    }
+
+    this->harmonicContexts.clearQuick();
+    this->harmonicContexts.ensureStorageAllocated(this->midiEvents.size());
+
+    for (int i = 0; i < this->midiEvents.size(); ++i)
+    {
+        const auto *signature = static_cast<const KeySignatureEvent *>(this->midiEvents.getUnchecked(i));
+
+        HarmonicContext context;
+        context.startBeat = signature->getBeat();
+        context.endBeat = (i + 1 < this->midiEvents.size()) ?
+            this->midiEvents.getUnchecked(i + 1)->getBeat() : FLT_MAX;
+        context.rootKey = signature->getRootKey();
+        context.scale = signature->getScale();
+
+        for (int key = 0; key < 128 && context.scale != nullptr; ++key)
+        {
+            if (context.scale->hasKey(key - context.rootKey))
+            {
+                context.keysMask[key >> 6] |= (uint64(1) << (key & 63));
+            }
+        }
+
+        this->harmonicContexts.add(context);
+    }
+
+    this->harmonicContextsAreOutdated = false;
 }
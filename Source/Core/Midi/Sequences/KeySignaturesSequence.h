@@ -49,6 +49,35 @@ public:
         Array<KeySignatureEvent> &signaturesAfter,
         bool undoable);
 
+    //===------------------------------------------------------------------===//
+    // Harmonic context
+    //===------------------------------------------------------------------===//
+
+    // A key signature resolved into the beat range where it's in effect,
+    // with the mask of all midi keys within its scale from its root key,
+    // so checking if a note is in scale doesn't search the scale each time
+    struct HarmonicContext final
+    {
+        float startBeat = 0.f; // the first context also applies before it
+        float endBeat = FLT_MAX;
+        Note::Key rootKey = 0;
+        Scale::Ptr scale;
+
+        inline bool hasKey(int key) const noexcept
+        {
+            return key >= 0 && key < 128 &&
+                ((this->keysMask[key >> 6] >> (key & 63)) & 1) != 0;
+        }
+
+        uint64 keysMask[2] = { 0, 0 };
+    };
+
+    // Both are O(log n), the contexts are rebuilt lazily after any change;
+    // the first returns nullptr if there are no key signatures, the second
+    // one also returns nullptr if the context changes within the range
+    const HarmonicContext *findHarmonicContextAt(float beat) const;
+    const HarmonicContext *findHarmonicContext(float startBeat, float endBeat) const;
+
     //===------------------------------------------------------------------===//
     // Serializable
     //===------------------------------------------------------------------===//
@@ -57,8 +86,18 @@ public:
     void deserialize(const SerializedData &data) override;
     void reset() override;
 
+protected:
+
+    void invalidateCaches() noexcept override;
+
 private:
 
+    void rebuildHarmonicContextsIfNeeded() const;
+    int indexOfHarmonicContextAt(float beat) const noexcept;
+
+    mutable Array<HarmonicContext> harmonicContexts;
+    mutable bool harmonicContextsAreOutdated = true;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(KeySignaturesSequence);
     JUCE_DECLARE_WEAK_REFERENCEABLE(KeySignaturesSequence);
 };
@@ -0,0 +1,167 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Common.h"
+#include "MidiExportBuffer.h"
+
+#define MIDI_EXPORT_NUM_CHANNELS 16
+#define MIDI_EXPORT_NUM_KEYS 128
+
+void MidiExportBuffer::ensureStorageAllocated(int numMessages)
+{
+    this->messages.ensureStorageAllocated(numMessages);
+}
+
+void MidiExportBuffer::sortMessages()
+{
+    // stable, so that the messages at the same time keep the order
+    // they were added in, just like MidiMessageSequence::addEvent does:
+    std::stable_sort(this->messages.begin(), this->messages.end(),
+        [](const MidiMessage &a, const MidiMessage &b)
+        {
+            return a.getTimeStamp() < b.getTimeStamp();
+        });
+}
+
+void MidiExportBuffer::flush(MidiMessageSequence &outSequence)
+{
+    this->sortMessages();
+
+    // the last note-on still waiting for its note-off, per channel and key;
+    // unlike updateMatchedPairs, overlapping notes of the same key are not
+    // split with an extra note-off, the later one just takes over the slot
+    using Holder = MidiMessageSequence::MidiEventHolder;
+    HeapBlock<Holder *> pendingNoteOns(MIDI_EXPORT_NUM_CHANNELS * MIDI_EXPORT_NUM_KEYS, true);
+
+    for (const auto &message : this->messages)
+    {
+        // appending in time order, this never has to look back:
+        auto *holder = outSequence.addEvent(message);
+
+        if (message.isNoteOn())
+        {
+            const auto slot = (message.getChannel() - 1) * MIDI_EXPORT_NUM_KEYS + message.getNoteNumber();
+            pendingNoteOns[slot] = holder;
+        }
+        else if (message.isNoteOff())
+        {
+            const auto slot = (message.getChannel() - 1) * MIDI_EXPORT_NUM_KEYS + message.getNoteNumber();
+            if (auto *noteOn = pendingNoteOns[slot])
+            {
+                noteOn->noteOffObject = holder;
+                pendingNoteOns[slot] = nullptr;
+            }
+        }
+    }
+
+    this->messages.clearQuick();
+}
+
+//===----------------------------------------------------------------------===//
+// Standard midi file chunks
+//===----------------------------------------------------------------------===//
+
+static void writeVariableLengthInt(OutputStream &out, uint32 value)
+{
+    auto buffer = value & 0x7f;
+
+    while ((value >>= 7) != 0)
+    {
+        buffer <<= 8;
+        buffer |= ((value & 0x7f) | 0x80);
+    }
+
+    for (;;)
+    {
+        out.writeByte(char(buffer));
+        if (buffer & 0x80)
+        {
+            buffer >>= 8;
+        }
+        else
+        {
+            break;
+        }
+    }
+}
+
+void MidiExportBuffer::writeHeaderChunk(OutputStream &out, int numTracks, int ticksPerQuarterNote)
+{
+    out.writeIntBigEndian(int(ByteOrder::bigEndianInt("MThd")));
+    out.writeIntBigEndian(6);
+    out.writeShortBigEndian(1); // multi-track file
+    out.writeShortBigEndian(short(numTracks));
+    out.writeShortBigEndian(short(ticksPerQuarterNote));
+}
+
+// The same encoding as in MidiFile::writeTrack, including the running status,
+// but straight from the flat buffer, without building a MidiMessageSequence
+void MidiExportBuffer::writeTrackChunk(OutputStream &out)
+{
+    this->sortMessages();
+
+    MemoryOutputStream data(size_t(this->messages.size()) * 4 + 4);
+
+    int lastTick = 0;
+    uint8 lastStatusByte = 0;
+    bool hasEndOfTrackEvent = false;
+
+    for (int i = 0; i < this->messages.size(); ++i)
+    {
+        const auto &message = this->messages.getReference(i);
+        hasEndOfTrackEvent = hasEndOfTrackEvent || message.isEndOfTrackMetaEvent();
+
+        const auto tick = roundToInt(message.getTimeStamp());
+        writeVariableLengthInt(data, uint32(jmax(0, tick - lastTick)));
+        lastTick = tick;
+
+        const auto *rawData = message.getRawData();
+        auto rawDataSize = message.getRawDataSize();
+        const auto statusByte = rawData[0];
+
+        if (statusByte == lastStatusByte &&
+            (statusByte & 0xf0) != 0xf0 && rawDataSize > 1 && i > 0)
+        {
+            ++rawData;
+            --rawDataSize;
+        }
+        else if (statusByte == 0xf0)
+        {
+            // sysex messages are written with their length
+            data.writeByte(char(statusByte));
+            ++rawData;
+            --rawDataSize;
+            writeVariableLengthInt(data, uint32(rawDataSize));
+        }
+
+        data.write(rawData, size_t(rawDataSize));
+        lastStatusByte = statusByte;
+    }
+
+    if (!hasEndOfTrackEvent)
+    {
+        data.writeByte(0); // zero delta time
+        const auto endOfTrack = MidiMessage::endOfTrack();
+        data.write(endOfTrack.getRawData(), size_t(endOfTrack.getRawDataSize()));
+    }
+
+    this->messages.clear();
+
+    out.writeIntBigEndian(int(ByteOrder::bigEndianInt("MTrk")));
+    out.writeIntBigEndian(int(data.getDataSize()));
+    out << data;
+}
@@ -0,0 +1,62 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+/*
+    A flat buffer the exported messages of all clips of a track
+    are appended to, unsorted, so that exporting a clip doesn't pay
+    for a sorted insertion per message and re-pairing the notes
+    of the whole growing sequence; flushing sorts the messages once
+    and links note-ons with their note-offs in a single linear pass.
+*/
+
+class MidiExportBuffer final
+{
+public:
+
+    MidiExportBuffer() = default;
+
+    void ensureStorageAllocated(int numMessages);
+
+    inline void add(const MidiMessage &message, double timeOffset)
+    {
+        this->messages.add(message);
+        this->messages.getReference(this->messages.size() - 1).addToTimeStamp(timeOffset);
+    }
+
+    inline int size() const noexcept { return this->messages.size(); }
+
+    // Moves all messages into the sequence, leaves the buffer empty
+    void flush(MidiMessageSequence &outSequence);
+
+    // Encodes the messages as a standard midi file track chunk, the time
+    // stamps are expected to be in ticks; leaves the buffer empty.
+    // Doesn't need the messages to be paired, so it's safe to call
+    // for different buffers on different threads at the same time.
+    void writeTrackChunk(OutputStream &out);
+
+    static void writeHeaderChunk(OutputStream &out, int numTracks, int ticksPerQuarterNote);
+
+private:
+
+    void sortMessages();
+
+    Array<MidiMessage> messages;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MidiExportBuffer)
+};
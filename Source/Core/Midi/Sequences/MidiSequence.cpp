@@ -17,6 +17,7 @@
 
 #include "Common.h"
 #include "MidiSequence.h"
+#include "MidiExportBuffer.h"
 #include "ProjectEventDispatcher.h"
 #include "ProjectNode.h"
 #include "UndoStack.h"
@@ -24,17 +25,17 @@
 
 struct EventIdGenerator final
 {
-    static String generateId(uint8 length = 2)
+    static MidiEvent::Id generateId(uint8 length = 2)
     {
-        String id;
+        char id[MIDI_EVENT_ID_MAX_LENGTH + 1] = {};
         static Random r;
         r.setSeedRandomly();
         static const char idChars[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
-        for (size_t i = 0; i < length; ++i)
+        for (size_t i = 0; i < jmin(size_t(length), size_t(MIDI_EVENT_ID_MAX_LENGTH)); ++i)
         {
-            id += idChars[r.nextInt(62)];
+            id[i] = idChars[r.nextInt(62)];
         }
-        return id;
+        return MidiEvent::Id(String(id));
     }
 };
 
@@ -98,27 +99,29 @@ void MidiSequence::clearUndoHistory()
 // Import/export
 //===----------------------------------------------------------------------===//
 
-void MidiSequence::exportMidi(MidiMessageSequence &outSequence, const Clip &clip,
-    bool soloPlaybackMode, double timeAdjustment, double timeFactor) const
+bool MidiSequence::isClipAudible(const Clip &clip, bool soloPlaybackMode) const noexcept
 {
-    if (clip.isMuted())
-    {
-        return;
-    }
-
     // Common logic is to ignore soloPlaybackMode flag
     // (which means there's at least one solo clip somewhere),
     // since not all sequence types are supposed to be soloed,
     // for example, automations should be exported all the time unless muted.
     // Moreover, for now, only PianoSequence will override this method
     // and make sure it skips a no-solo clip, when soloPlaybackMode is true.
+    return !clip.isMuted();
+}
 
-    for (const auto *event : this->midiEvents)
+void MidiSequence::exportMidi(MidiExportBuffer &outBuffer, const Clip &clip,
+    bool soloPlaybackMode, double timeAdjustment, double timeFactor) const
+{
+    if (!this->isClipAudible(clip, soloPlaybackMode))
     {
-        event->exportMessages(outSequence, clip, timeAdjustment, timeFactor);
+        return;
     }
 
-    outSequence.updateMatchedPairs();
+    for (const auto *event : this->midiEvents)
+    {
+        event->exportMessages(outBuffer, clip, timeAdjustment, timeFactor);
+    }
 }
 
 float MidiSequence::midiTicksToBeats(double ticks, int timeFormat) noexcept
@@ -171,6 +174,56 @@ float MidiSequence::getLengthInBeats() const noexcept
     return this->getLastBeat() - this->getFirstBeat();
 }
 
+int MidiSequence::indexOfFirstEventAtOrAfter(float beat) const noexcept
+{
+    const int numEvents = this->midiEvents.size();
+    const auto isBefore = [beat](const MidiEvent *e) { return e->getBeat() < beat; };
+
+    // the hint is only a guess and might be stale, so it is validated here
+    for (int i = jmin(this->lastLookupIndex, numEvents);
+        i <= jmin(this->lastLookupIndex + 1, numEvents); ++i)
+    {
+        if ((i == 0 || isBefore(this->midiEvents.getUnchecked(i - 1))) &&
+            (i == numEvents || !isBefore(this->midiEvents.getUnchecked(i))))
+        {
+            this->lastLookupIndex = i;
+            return i;
+        }
+    }
+
+    const auto *found = std::partition_point(this->midiEvents.begin(),
+        this->midiEvents.end(), isBefore);
+
+    this->lastLookupIndex = int(found - this->midiEvents.begin());
+    return this->lastLookupIndex;
+}
+
+int MidiSequence::indexOfFirstEventAfter(float beat) const noexcept
+{
+    const auto *found = std::partition_point(this->midiEvents.begin(),
+        this->midiEvents.end(), [beat](const MidiEvent *e) { return e->getBeat() <= beat; });
+
+    return int(found - this->midiEvents.begin());
+}
+
+int MidiSequence::indexOfEvent(float beat, const MidiEvent::Id &id) const noexcept
+{
+    // the same order as in MidiEvent::compareElements
+    const auto *found = std::partition_point(this->midiEvents.begin(),
+        this->midiEvents.end(), [beat, &id](const MidiEvent *e)
+        {
+            return e->getBeat() < beat || (e->getBeat() == beat && e->getId().compare(id) < 0);
+        });
+
+    if (found != this->midiEvents.end() &&
+        (*found)->getBeat() == beat && (*found)->getId() == id)
+    {
+        return int(found - this->midiEvents.begin());
+    }
+
+    return -1;
+}
+
 MidiTrack *MidiSequence::getTrack() const noexcept
 {
     return &this->track;
@@ -190,8 +243,25 @@ UndoStack *MidiSequence::getUndoStack() const noexcept
 // Events change listener
 //===----------------------------------------------------------------------===//
 
+void MidiSequence::adoptSortedEvents(OwnedArray<MidiEvent> &events,
+    FlatHashSet<MidiEvent::Id, MidiEventIdHash> &ids)
+{
+    const WeakReference<MidiSequence> owner(this);
+    for (auto *event : events)
+    {
+        jassert(event->sequence == nullptr);
+        event->sequence = owner;
+    }
+
+    this->midiEvents.swapWith(events);
+    this->usedEventIds.swap(ids);
+    this->lastLookupIndex = 0;
+}
+
 void MidiSequence::updateBeatRange(bool shouldNotifyIfChanged)
 {
+    this->invalidateCaches();
+
     if (this->lastStartBeat == this->getFirstBeat() &&
         this->lastEndBeat == this->getLastBeat())
     {
@@ -208,13 +278,14 @@ void MidiSequence::updateBeatRange(bool shouldNotifyIfChanged)
     }
 }
 
-String MidiSequence::createUniqueEventId() const noexcept
+MidiEvent::Id MidiSequence::createUniqueEventId() const noexcept
 {
     uint8 length = 2;
-    String eventId = EventIdGenerator::generateId(length);
+    auto eventId = EventIdGenerator::generateId(length);
     while (this->usedEventIds.contains(eventId))
     {
-        length++;
+        // the longest ids still have 62^10 combinations to try:
+        length = uint8(jmin(length + 1, MIDI_EVENT_ID_MAX_LENGTH));
         eventId = EventIdGenerator::generateId(length);
     }
     
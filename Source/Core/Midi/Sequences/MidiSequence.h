@@ -50,8 +50,9 @@ public:
 
     static float midiTicksToBeats(double ticks, int timeFormat) noexcept;
     virtual void importMidi(const MidiMessageSequence &sequence, short timeFormat) = 0;
-    virtual void exportMidi(MidiMessageSequence &outSequence, const Clip &clip,
+    virtual void exportMidi(MidiExportBuffer &outBuffer, const Clip &clip,
         bool soloPlaybackMode, double timeAdjustment, double timeFactor) const;
+    virtual bool isClipAudible(const Clip &clip, bool soloPlaybackMode) const noexcept;
 
     //===------------------------------------------------------------------===//
     // Track editing
@@ -129,13 +130,25 @@ public:
         return this->midiEvents.indexOfSorted(*event, event);
     }
 
+    // binary searches over the sorted events, both returning size() if not found;
+    // a last-hit hint is checked first, so that sweeping queries coming
+    // with monotonically increasing beats, e.g. from paint(), are O(1)
+    int indexOfFirstEventAtOrAfter(float beat) const noexcept;
+    int indexOfFirstEventAfter(float beat) const noexcept;
+
+    // the same as indexOfSorted, but only needs the sorting keys, not an event;
+    // returns -1 if there's no such event
+    int indexOfEvent(float beat, const MidiEvent::Id &id) const noexcept;
+
     //===------------------------------------------------------------------===//
     // Helpers
     //===------------------------------------------------------------------===//
 
+    // should be called after any changes to the events,
+    // also invalidates whatever caches the subclasses have
     void updateBeatRange(bool shouldNotifyIfChanged);
 
-    String createUniqueEventId() const noexcept;
+    MidiEvent::Id createUniqueEventId() const noexcept;
     const String &getTrackId() const noexcept;
     int getChannel() const noexcept;
 
@@ -155,10 +168,19 @@ protected:
 
     ProjectEventDispatcher &eventDispatcher;
     ProjectNode *getProject() const noexcept;
+
+    // called whenever the events have changed, see updateBeatRange()
+    virtual void invalidateCaches() noexcept {}
     UndoStack *getUndoStack() const noexcept;
 
     OwnedArray<MidiEvent> midiEvents;
-    mutable FlatHashSet<MidiEvent::Id, StringHash> usedEventIds;
+    mutable int lastLookupIndex = 0;
+    mutable FlatHashSet<MidiEvent::Id, MidiEventIdHash> usedEventIds;
+
+    // takes the sorted events which were parsed without an owner,
+    // e.g. on a worker thread, see PianoSequence::attachNotes
+    void adoptSortedEvents(OwnedArray<MidiEvent> &events,
+        FlatHashSet<MidiEvent::Id, MidiEventIdHash> &ids);
     
 private:
 
@@ -17,11 +17,13 @@
 
 #include "Common.h"
 #include "PianoSequence.h"
+#include "MidiExportBuffer.h"
 
 #include "PianoRoll.h"
 #include "Note.h"
 #include "NoteActions.h"
 #include "SerializationKeys.h"
+#include "PackedColumn.h"
 #include "ProjectNode.h"
 #include "UndoStack.h"
 
@@ -33,52 +35,127 @@ PianoSequence::PianoSequence(MidiTrack &track,
 // Import/export
 //===----------------------------------------------------------------------===//
 
+#define MIDI_IMPORT_NUM_CHANNELS 16
+#define MIDI_IMPORT_NUM_KEYS 128
+
 void PianoSequence::importMidi(const MidiMessageSequence &sequence, short timeFormat)
 {
-    this->clearUndoHistory();
-    this->checkpoint();
+    Array<ImportedNote> notes;
+    PianoSequence::parseMidi(sequence, timeFormat, notes);
+    this->importNotes(notes);
+}
+
+void PianoSequence::parseMidi(const MidiMessageSequence &sequence,
+    short timeFormat, Array<ImportedNote> &outNotes)
+{
+    // the notes still waiting for their note-offs, per channel and key,
+    // in the order they came in, so that the overlapping notes of the same key
+    // end in the same order they've started; one pass instead of searching
+    // for the matching note-off for each note-on:
+    Array<Array<int>> pendingNotes;
+    pendingNotes.resize(MIDI_IMPORT_NUM_CHANNELS * MIDI_IMPORT_NUM_KEYS);
+
+    // the notes are added on note-ons, so they come sorted by start beat,
+    // and those never closed with a note-off are removed in the end
+    const int firstNewNote = outNotes.size();
+    outNotes.ensureStorageAllocated(firstNewNote + sequence.getNumEvents() / 2);
 
     for (int i = 0; i < sequence.getNumEvents(); ++i)
     {
-        const auto &messageOn = sequence.getEventPointer(i)->message;
-        if (messageOn.isNoteOn())
+        const auto &message = sequence.getEventPointer(i)->message;
+        if (!message.isNoteOnOrOff())
         {
-            const int key = messageOn.getNoteNumber();
-            const float velocity = messageOn.getVelocity() / 128.f;
-            const float startBeat = MidiSequence::midiTicksToBeats(messageOn.getTimeStamp(), timeFormat);
-            const int noteOffIndex = sequence.getIndexOfMatchingKeyUp(i);
-            if (noteOffIndex > 0)
-            {
-                const MidiMessage &messageOff = sequence.getEventPointer(noteOffIndex)->message;
-                const float endBeat = MidiSequence::midiTicksToBeats(messageOff.getTimeStamp(), timeFormat);
-                if (endBeat > startBeat)
-                {
-                    const float length = float(endBeat - startBeat);
-                    const Note note(this, key, startBeat, length, velocity);
-                    this->importMidiEvent<Note>(note);
-                }
-            }
+            continue;
+        }
+
+        const int slot = (message.getChannel() - 1) * MIDI_IMPORT_NUM_KEYS + message.getNoteNumber();
+        auto &pending = pendingNotes.getReference(slot);
+        const float beat = MidiSequence::midiTicksToBeats(message.getTimeStamp(), timeFormat);
+
+        if (message.isNoteOn())
+        {
+            pending.add(outNotes.size());
+            outNotes.add({ message.getNoteNumber(), beat, 0.f, message.getVelocity() / 128.f });
+        }
+        else if (!pending.isEmpty())
+        {
+            auto &note = outNotes.getReference(pending.getFirst());
+            note.length = beat - note.beat;
+            pending.remove(0);
+        }
+    }
+
+    int numValidNotes = firstNewNote;
+    for (int i = firstNewNote; i < outNotes.size(); ++i)
+    {
+        const auto &note = outNotes.getReference(i);
+        if (note.length > 0.f)
+        {
+            outNotes.setUnchecked(numValidNotes++, note);
         }
     }
 
+    outNotes.removeRange(numValidNotes, outNotes.size() - numValidNotes);
+}
+
+void PianoSequence::importNotes(const Array<ImportedNote> &notes)
+{
+    this->clearUndoHistory();
+    this->checkpoint();
+
+    // created unsorted, each note gets its unique id here,
+    // and then the sequence is sorted just once:
+    this->midiEvents.ensureStorageAllocated(this->midiEvents.size() + notes.size());
+    for (const auto &n : notes)
+    {
+        this->midiEvents.add(new Note(this, n.key, n.beat, n.length, n.velocity));
+    }
+
+    this->sort();
     this->updateBeatRange(false);
 }
 
-void PianoSequence::exportMidi(MidiMessageSequence &outSequence, const Clip &clip,
+bool PianoSequence::isClipAudible(const Clip &clip, bool soloPlaybackMode) const noexcept
+{
+    return !clip.isMuted() && (!soloPlaybackMode || clip.isSoloed());
+}
+
+static void exportPackedNotes(MidiExportBuffer &outBuffer,
+    const PianoSequence::PackedNotes &notes, int channel,
+    const Clip &clip, double timeAdjustment, double timeFactor)
+{
+    for (int i = 0; i < notes.size(); ++i)
+    {
+        Note::exportMessages(outBuffer, clip, channel,
+            notes.keys.getUnchecked(i), notes.beats.getUnchecked(i),
+            notes.lengths.getUnchecked(i), notes.velocities.getUnchecked(i),
+            notes.tuplets.getUnchecked(i), timeAdjustment, timeFactor);
+    }
+}
+
+void PianoSequence::exportMidi(MidiExportBuffer &outBuffer, const Clip &clip,
     bool soloPlaybackMode, double timeAdjustment, double timeFactor) const
 {
-    // This method pretty much duplicates base method, except for this check:
-    if (clip.isMuted() || (soloPlaybackMode && !clip.isSoloed()))
+    if (!this->isClipAudible(clip, soloPlaybackMode))
     {
         return;
     }
 
-    for (const auto *event : this->midiEvents)
+    exportPackedNotes(outBuffer, this->getPackedNotes(),
+        this->getChannel(), clip, timeAdjustment, timeFactor);
+}
+
+void PianoSequence::Snapshot::exportMidi(MidiExportBuffer &outBuffer, const Clip &clip,
+    bool soloPlaybackMode, double timeAdjustment, double timeFactor) const
+{
+    // see isClipAudible
+    if (clip.isMuted() || (soloPlaybackMode && !clip.isSoloed()))
     {
-        event->exportMessages(outSequence, clip, timeAdjustment, timeFactor);
+        return;
     }
 
-    outSequence.updateMatchedPairs();
+    exportPackedNotes(outBuffer, this->notes,
+        this->channel, clip, timeAdjustment, timeFactor);
 }
 
 //===----------------------------------------------------------------------===//
@@ -97,6 +174,7 @@ MidiEvent *PianoSequence::insert(const Note &eventParams, const bool undoable)
     {
         auto *ownedNote = new Note(this, eventParams);
         this->midiEvents.addSorted(*ownedNote, ownedNote);
+        this->invalidateCaches();
         this->eventDispatcher.dispatchAddEvent(*ownedNote);
         this->updateBeatRange(true);
         return ownedNote;
@@ -123,6 +201,7 @@ bool PianoSequence::remove(const Note &eventParams, const bool undoable)
             jassert(removedNote->isValid());
             this->eventDispatcher.dispatchRemoveEvent(*removedNote);
             this->midiEvents.remove(index, true);
+            this->invalidateCaches();
             this->updateBeatRange(true);
             this->eventDispatcher.dispatchPostRemoveEvent(this);
             return true;
@@ -153,6 +232,7 @@ bool PianoSequence::change(const Note &oldParams,
             changedNote->applyChanges(newParams);
             this->midiEvents.remove(index, false);
             this->midiEvents.addSorted(*changedNote, changedNote);
+            this->invalidateCaches();
             this->eventDispatcher.dispatchChangeEvent(oldParams, *changedNote);
             this->updateBeatRange(true);
             return true;
@@ -164,6 +244,11 @@ bool PianoSequence::change(const Note &oldParams,
     return true;
 }
 
+// Group operations don't use addSorted/remove for each note, as that would
+// make them O(group size * sequence size), which is way too slow for pasting
+// or transposing thousands of notes; instead, the group is sorted once and
+// merged with the sequence in a single pass, and so is the removal
+
 bool PianoSequence::insertGroup(Array<Note> &group, bool undoable)
 {
     if (undoable)
@@ -174,14 +259,19 @@ bool PianoSequence::insertGroup(Array<Note> &group, bool undoable)
     }
     else
     {
-        for (int i = 0; i < group.size(); ++i)
+        Array<MidiEvent *> newNotes;
+        newNotes.ensureStorageAllocated(group.size());
+        for (const auto &eventParams : group)
         {
-            const Note &eventParams = group.getUnchecked(i);
-            auto *ownedNote = new Note(this, eventParams);
-            this->midiEvents.addSorted(*ownedNote, ownedNote);
-            this->eventDispatcher.dispatchAddEvent(*ownedNote);
+            newNotes.add(new Note(this, eventParams));
         }
 
+        this->mergeSorted(newNotes);
+
+        Array<const MidiEvent *> addedEvents;
+        addedEvents.addArray(newNotes);
+        this->eventDispatcher.dispatchAddEvents(addedEvents);
+
         this->updateBeatRange(true);
     }
 
@@ -198,9 +288,10 @@ bool PianoSequence::removeGroup(Array<Note> &group, bool undoable)
     }
     else
     {
-        for (int i = 0; i < group.size(); ++i)
+        Array<int> indices;
+        indices.ensureStorageAllocated(group.size());
+        for (const auto &note : group)
         {
-            const Note &note = group.getUnchecked(i);
             const int index = this->midiEvents.indexOfSorted(note, &note);
             // Hitting this assertion almost likely means that target note array
             // contains more than one instance of the same note, but from different clips.
@@ -209,12 +300,24 @@ bool PianoSequence::removeGroup(Array<Note> &group, bool undoable)
             jassert(index >= 0);
             if (index >= 0)
             {
-                auto *removedNote = this->midiEvents.getUnchecked(index);
-                this->eventDispatcher.dispatchRemoveEvent(*removedNote);
-                this->midiEvents.remove(index, true);
+                indices.add(index);
             }
         }
 
+        Array<const MidiEvent *> removedEvents;
+        removedEvents.ensureStorageAllocated(indices.size());
+        for (const auto index : indices)
+        {
+            removedEvents.add(this->midiEvents.getUnchecked(index));
+        }
+
+        this->eventDispatcher.dispatchRemoveEvents(removedEvents);
+
+        for (auto *removedEvent : this->removeSorted(indices))
+        {
+            delete removedEvent;
+        }
+
         this->updateBeatRange(true);
         this->eventDispatcher.dispatchPostRemoveEvent(this);
     }
@@ -235,10 +338,21 @@ bool PianoSequence::changeGroup(Array<Note> &groupBefore,
     }
     else
     {
+        // all lookups go first, while the sequence is still sorted:
+        Array<int> indices;
+        Array<Note *> targets;
+        Array<int> groupIndices;
+        Array<const MidiEvent *> oldEvents;
+        Array<const MidiEvent *> newEvents;
+        indices.ensureStorageAllocated(groupBefore.size());
+        targets.ensureStorageAllocated(groupBefore.size());
+        groupIndices.ensureStorageAllocated(groupBefore.size());
+        oldEvents.ensureStorageAllocated(groupBefore.size());
+        newEvents.ensureStorageAllocated(groupBefore.size());
+
         for (int i = 0; i < groupBefore.size(); ++i)
         {
             const Note &oldParams = groupBefore.getReference(i);
-            const Note &newParams = groupAfter.getReference(i);
             const int index = this->midiEvents.indexOfSorted(oldParams, &oldParams);
             // if you're hitting this assertion, one of the reasons might be
             // allowing user to somehow select notes of different clips simultaneously,
@@ -249,87 +363,671 @@ bool PianoSequence::changeGroup(Array<Note> &groupBefore,
             if (index >= 0)
             {
                 auto *changedNote = static_cast<Note *>(this->midiEvents.getUnchecked(index));
-                changedNote->applyChanges(newParams);
-                this->midiEvents.remove(index, false);
-                this->midiEvents.addSorted(*changedNote, changedNote);
-                this->eventDispatcher.dispatchChangeEvent(oldParams, *changedNote);
+                indices.add(index);
+                targets.add(changedNote);
+                groupIndices.add(i);
+                oldEvents.add(&oldParams);
+                newEvents.add(changedNote);
             }
         }
 
+        // then the changed notes are taken out, updated and merged back:
+        auto changedNotes = this->removeSorted(indices);
+
+        for (int i = 0; i < targets.size(); ++i)
+        {
+            targets.getUnchecked(i)->applyChanges(groupAfter.getReference(groupIndices.getUnchecked(i)));
+        }
+
+        this->mergeSorted(changedNotes);
+        this->eventDispatcher.dispatchChangeEvents(oldEvents, newEvents);
+
         this->updateBeatRange(true);
     }
 
     return true;
 }
 
+bool PianoSequence::changeGroup(const Array<Note::Id> &ids,
+    const NotesState &stateBefore, const NotesState &stateAfter)
+{
+    // the beats missing in either state mean they don't change:
+    const auto &beatsBefore = stateBefore.beats.isEmpty() ? stateAfter.beats : stateBefore.beats;
+    const bool changesBeats = !stateBefore.beats.isEmpty() && !stateAfter.beats.isEmpty();
+
+    this->updateGroup(ids, beatsBefore, changesBeats, [&stateAfter](Note &note, int i)
+    {
+        note.applyChanges(
+            stateAfter.keys.isEmpty() ? note.getKey() : stateAfter.keys.getUnchecked(i),
+            stateAfter.beats.isEmpty() ? note.getBeat() : stateAfter.beats.getUnchecked(i),
+            stateAfter.lengths.isEmpty() ? note.getLength() : stateAfter.lengths.getUnchecked(i),
+            stateAfter.velocities.isEmpty() ? note.getVelocity() : stateAfter.velocities.getUnchecked(i),
+            stateAfter.tuplets.isEmpty() ? note.getTuplet() : stateAfter.tuplets.getUnchecked(i));
+    });
+
+    return true;
+}
+
+bool PianoSequence::changeGroup(Array<Note::Id> &ids,
+    NotesState &stateBefore, NotesState &stateAfter, bool undoable)
+{
+    jassert(stateBefore.beats.size() == ids.size());
+
+    if (undoable)
+    {
+        this->getUndoStack()->
+            perform(new NotesGroupChangeAction(*this->getProject(),
+                this->getTrackId(), ids, stateBefore, stateAfter));
+    }
+    else
+    {
+        this->changeGroup(ids, stateBefore, stateAfter);
+    }
+
+    return true;
+}
+
+bool PianoSequence::transformGroup(const Array<const Note *> &notes,
+    const Note::Transform &transform, bool undoable)
+{
+    Array<Note::Id> ids;
+    NotesState initialState;
+    ids.ensureStorageAllocated(notes.size());
+    initialState.beats.ensureStorageAllocated(notes.size());
+
+    for (const auto *note : notes)
+    {
+        jassert(note->getSequence() == this);
+        ids.add(note->getId());
+        initialState.beats.add(note->getBeat());
+
+        if (transform.changesKeys())
+        {
+            initialState.keys.add(note->getKey());
+        }
+
+        if (transform.changesLengths())
+        {
+            initialState.lengths.add(note->getLength());
+        }
+
+        if (transform.changesVelocities())
+        {
+            initialState.velocities.add(note->getVelocity());
+        }
+    }
+
+    if (undoable)
+    {
+        this->getUndoStack()->
+            perform(new NotesGroupTransformAction(*this->getProject(),
+                this->getTrackId(), transform, ids, initialState));
+    }
+    else
+    {
+        this->applyTransform(ids, initialState, transform, false);
+    }
+
+    return true;
+}
+
+bool PianoSequence::applyTransform(const Array<Note::Id> &ids,
+    const NotesState &initialState, const Note::Transform &transform, bool shouldRevert)
+{
+    jassert(initialState.beats.size() == ids.size());
+    jassert(!transform.changesKeys() || initialState.keys.size() == ids.size());
+    jassert(!transform.changesLengths() || initialState.lengths.size() == ids.size());
+    jassert(!transform.changesVelocities() || initialState.velocities.size() == ids.size());
+
+    if (!shouldRevert)
+    {
+        this->updateGroup(ids, initialState.beats, transform.changesBeats(),
+            [&transform](Note &note, int) { note.applyTransform(transform); });
+
+        return true;
+    }
+
+    Array<float> transformedBeats;
+    transformedBeats.ensureStorageAllocated(ids.size());
+    for (const auto beat : initialState.beats)
+    {
+        transformedBeats.add(transform.transformBeat(beat));
+    }
+
+    this->updateGroup(ids, transformedBeats, transform.changesBeats(),
+        [&initialState, &transform](Note &note, int i)
+    {
+        note.applyChanges(
+            transform.changesKeys() ? initialState.keys.getUnchecked(i) : note.getKey(),
+            initialState.beats.getUnchecked(i),
+            transform.changesLengths() ? initialState.lengths.getUnchecked(i) : note.getLength(),
+            transform.changesVelocities() ? initialState.velocities.getUnchecked(i) : note.getVelocity(),
+            note.getTuplet());
+    });
+
+    return true;
+}
+
+void PianoSequence::updateGroup(const Array<Note::Id> &ids,
+    const Array<float> &currentBeats, bool changesBeats,
+    const Function<void(Note &note, int index)> &update)
+{
+    jassert(ids.size() == currentBeats.size());
+
+    // all lookups go first, while the sequence is still sorted:
+    Array<int> indices;
+    Array<int> groupIndices;
+    Array<Note> oldNotes;
+    indices.ensureStorageAllocated(ids.size());
+    groupIndices.ensureStorageAllocated(ids.size());
+    oldNotes.ensureStorageAllocated(ids.size());
+
+    for (int i = 0; i < ids.size(); ++i)
+    {
+        const int index = this->indexOfEvent(currentBeats.getUnchecked(i), ids.getUnchecked(i));
+        jassert(index >= 0);
+        if (index >= 0)
+        {
+            indices.add(index);
+            groupIndices.add(i);
+            oldNotes.add(*static_cast<Note *>(this->midiEvents.getUnchecked(index)));
+        }
+    }
+
+    Array<Note *> targets;
+    Array<const MidiEvent *> oldEvents;
+    Array<const MidiEvent *> newEvents;
+    targets.ensureStorageAllocated(indices.size());
+    oldEvents.ensureStorageAllocated(indices.size());
+    newEvents.ensureStorageAllocated(indices.size());
+
+    for (int i = 0; i < indices.size(); ++i)
+    {
+        auto *note = static_cast<Note *>(this->midiEvents.getUnchecked(indices.getUnchecked(i)));
+        targets.add(note);
+        oldEvents.add(&oldNotes.getReference(i));
+        newEvents.add(note);
+    }
+
+    // the sequence order depends on beats only, so if they stay the same,
+    // the notes are updated right where they are, otherwise they are
+    // taken out, updated and merged back:
+    Array<MidiEvent *> movedNotes;
+    if (changesBeats)
+    {
+        movedNotes = this->removeSorted(indices);
+    }
+
+    for (int i = 0; i < targets.size(); ++i)
+    {
+        update(*targets.getUnchecked(i), groupIndices.getUnchecked(i));
+    }
+
+    if (changesBeats)
+    {
+        this->mergeSorted(movedNotes);
+    }
+
+    this->eventDispatcher.dispatchChangeEvents(oldEvents, newEvents);
+    this->updateBeatRange(true);
+}
+
+void PianoSequence::mergeSorted(Array<MidiEvent *> &newEvents)
+{
+    static Note comparator;
+    newEvents.sort(comparator, true);
+
+    Array<MidiEvent *> merged;
+    merged.ensureStorageAllocated(this->midiEvents.size() + newEvents.size());
+
+    int i = 0, j = 0;
+    while (i < this->midiEvents.size() && j < newEvents.size())
+    {
+        auto *existing = this->midiEvents.getUnchecked(i);
+        auto *inserted = newEvents.getUnchecked(j);
+        if (MidiEvent::compareElements(inserted, existing) < 0)
+        {
+            merged.add(inserted);
+            ++j;
+        }
+        else
+        {
+            merged.add(existing);
+            ++i;
+        }
+    }
+
+    while (i < this->midiEvents.size()) { merged.add(this->midiEvents.getUnchecked(i++)); }
+    while (j < newEvents.size()) { merged.add(newEvents.getUnchecked(j++)); }
+
+    this->midiEvents.clearQuick(false);
+    this->midiEvents.addArray(merged);
+    this->invalidateCaches();
+}
+
+Array<MidiEvent *> PianoSequence::removeSorted(Array<int> &indices)
+{
+    indices.sort();
+
+    Array<MidiEvent *> removed;
+    removed.ensureStorageAllocated(indices.size());
+
+    auto *data = this->midiEvents.getRawDataPointer();
+    const int numEvents = this->midiEvents.size();
+    int writeIndex = 0;
+    int nextRemoved = 0;
+
+    for (int readIndex = 0; readIndex < numEvents; ++readIndex)
+    {
+        // the same note might be listed twice, which is a bug, but still
+        while (nextRemoved < indices.size() && indices.getUnchecked(nextRemoved) < readIndex)
+        {
+            ++nextRemoved;
+        }
+
+        if (nextRemoved < indices.size() && indices.getUnchecked(nextRemoved) == readIndex)
+        {
+            removed.add(data[readIndex]);
+            ++nextRemoved;
+        }
+        else
+        {
+            data[writeIndex++] = data[readIndex];
+        }
+    }
+
+    this->midiEvents.removeLast(numEvents - writeIndex, false);
+    this->invalidateCaches();
+    return removed;
+}
+
 //===----------------------------------------------------------------------===//
 // Accessors
 //===----------------------------------------------------------------------===//
 
 float PianoSequence::getLastBeat() const noexcept
 {
-    float lastBeat = -FLT_MAX;
     if (this->midiEvents.size() == 0)
     {
-        return lastBeat;
+        return -FLT_MAX;
     }
 
-    // FIXME:
-    // sometimes the last event is not the one that lasts longer
-    // (as events *must* be sorted by start beat, not by end beat),
-    // so here we have to iterate through a number of last events
-    // to guess where the sequence really ends, with still no guarantee
-    // we'll end up with right event (not sure how to fix it at the moment):
-    const int checkStart = jmax(0, this->midiEvents.size() - 5);
-    for (int i = checkStart; i < this->midiEvents.size(); ++i)
+    // events are sorted by start beat, not by end beat,
+    // so the last event is not necessarily the one that lasts longer:
+    if (this->lastNoteEndBeatIsOutdated)
     {
-        const auto *n = static_cast<const Note *>(this->midiEvents.getUnchecked(i));
-        lastBeat = jmax(lastBeat, n->getBeat() + n->getLength());
+        float lastBeat = -FLT_MAX;
+        for (const auto *event : this->midiEvents)
+        {
+            const auto *n = static_cast<const Note *>(event);
+            lastBeat = jmax(lastBeat, n->getBeat() + n->getLength());
+        }
+
+        this->lastNoteEndBeat = lastBeat;
+        this->lastNoteEndBeatIsOutdated = false;
     }
 
-    return lastBeat;
+    return this->lastNoteEndBeat;
+}
+
+void PianoSequence::PackedNotes::clear() noexcept
+{
+    this->beats.clearQuick();
+    this->lengths.clearQuick();
+    this->velocities.clearQuick();
+    this->keys.clearQuick();
+    this->tuplets.clearQuick();
+    this->handles.clearQuick();
+    this->maxEndBeats.clearQuick();
+}
+
+Range<int> PianoSequence::PackedNotes::getCandidatesInRange(float startBeat, float endBeat) const noexcept
+{
+    const auto *maxEnds = this->maxEndBeats.begin();
+    const auto first = int(std::upper_bound(maxEnds, this->maxEndBeats.end(),
+        startBeat) - maxEnds);
+
+    const auto *beatsBegin = this->beats.begin();
+    const auto last = int(std::lower_bound(beatsBegin + first, this->beats.end(),
+        endBeat) - beatsBegin);
+
+    return { first, jmax(first, last) };
+}
+
+const PianoSequence::PackedNotes &PianoSequence::getPackedNotes() const
+{
+    jassert(MessageManager::getInstance()->isThisTheMessageThread());
+
+    if (!this->packedNotesAreOutdated)
+    {
+        return this->packedNotes;
+    }
+
+    auto &notes = this->packedNotes;
+    notes.clear();
+
+    const auto numNotes = this->midiEvents.size();
+    notes.beats.ensureStorageAllocated(numNotes);
+    notes.lengths.ensureStorageAllocated(numNotes);
+    notes.velocities.ensureStorageAllocated(numNotes);
+    notes.keys.ensureStorageAllocated(numNotes);
+    notes.tuplets.ensureStorageAllocated(numNotes);
+    notes.handles.ensureStorageAllocated(numNotes);
+    notes.maxEndBeats.ensureStorageAllocated(numNotes);
+
+    float maxEndBeat = -FLT_MAX;
+    for (const auto *event : this->midiEvents)
+    {
+        jassert(event->isTypeOf(MidiEvent::Type::Note));
+        const auto *note = static_cast<const Note *>(event);
+        notes.beats.add(note->getBeat());
+        notes.lengths.add(note->getLength());
+        notes.velocities.add(note->getVelocity());
+        notes.keys.add(note->getKey());
+        notes.tuplets.add(note->getTuplet());
+        notes.handles.add(note);
+
+        maxEndBeat = jmax(maxEndBeat, note->getBeat() + note->getLength());
+        notes.maxEndBeats.add(maxEndBeat);
+    }
+
+    this->packedNotesAreOutdated = false;
+    return notes;
+}
+
+PianoSequence::Snapshot::Ptr PianoSequence::getSnapshot() const
+{
+    const auto channel = this->getChannel();
+    if (this->snapshot != nullptr &&
+        this->snapshot->version == this->version &&
+        this->snapshot->channel == channel)
+    {
+        return this->snapshot;
+    }
+
+    // the readers may still hold the previous one, so it's never updated in place
+    Snapshot::Ptr newSnapshot(new Snapshot());
+    newSnapshot->version = this->version;
+    newSnapshot->channel = channel;
+    newSnapshot->notes = this->getPackedNotes();
+    newSnapshot->notes.handles.clear();
+
+    this->snapshot = newSnapshot;
+    return newSnapshot;
+}
+
+void PianoSequence::findNotesInRange(float startBeat, float endBeat,
+    Array<const Note *> &result) const
+{
+    const auto &notes = this->getPackedNotes();
+    const auto candidates = notes.getCandidatesInRange(startBeat, endBeat);
+    const auto *beats = notes.beats.begin();
+
+    for (int i = candidates.getStart(); i < candidates.getEnd(); ++i)
+    {
+        if (beats[i] + notes.lengths.getUnchecked(i) > startBeat)
+        {
+            result.add(notes.handles.getUnchecked(i));
+        }
+    }
+}
+
+void PianoSequence::findNotesSoundingAt(float beat, Array<const Note *> &result) const
+{
+    const auto &notes = this->getPackedNotes();
+
+    const auto *maxEnds = notes.maxEndBeats.begin();
+    const auto first = int(std::upper_bound(maxEnds, notes.maxEndBeats.end(),
+        beat) - maxEnds);
+
+    // unlike the range query, includes the notes starting exactly at the beat:
+    const auto *beats = notes.beats.begin();
+    const auto last = int(std::upper_bound(beats + first, notes.beats.end(),
+        beat) - beats);
+
+    for (int i = first; i < last; ++i)
+    {
+        if (beats[i] + notes.lengths.getUnchecked(i) > beat)
+        {
+            result.add(notes.handles.getUnchecked(i));
+        }
+    }
+}
+
+void PianoSequence::invalidateCaches() noexcept
+{
+    ++this->version;
+    this->packedNotesAreOutdated = true;
+    this->lastNoteEndBeatIsOutdated = true;
+    this->notesHashIsOutdated = true;
 }
 
 //===----------------------------------------------------------------------===//
 // Serializable
 //===----------------------------------------------------------------------===//
 
+// The notes are saved as the packed columns, one per parameter, so that
+// each note takes about a dozen bytes instead of a node with six named
+// properties; the events are sorted, so the beats are stored as deltas;
+// the per-note nodes are still used by the vcs deltas,
+// and the older files with them are still loaded as usual
 SerializedData PianoSequence::serialize() const
 {
-    SerializedData tree(Serialization::Midi::track);
+    using namespace Serialization;
+    SerializedData tree(Midi::track);
+
+    if (this->midiEvents.isEmpty())
+    {
+        return tree;
+    }
 
-    for (int i = 0; i < this->midiEvents.size(); ++i)
+    Array<const Note *> notes;
+    notes.ensureStorageAllocated(this->midiEvents.size());
+    for (const auto *event : this->midiEvents)
     {
-        const auto *event = this->midiEvents.getUnchecked(i);
-        tree.appendChild(event->serialize());
+        jassert(event->isTypeOf(MidiEvent::Type::Note));
+        notes.add(static_cast<const Note *>(event));
     }
-    
+
+    tree.appendChild(PianoSequence::packNotes(notes));
     return tree;
 }
 
+SerializedData PianoSequence::packNotes(const Array<const Note *> &notes)
+{
+    using namespace Serialization;
+
+    PackedColumn::Writer ids, keys, beats, lengths, volumes, tuplets;
+    bool hasTuplets = false;
+    int64 lastTimestamp = 0;
+
+    for (const auto *note : notes)
+    {
+        // the same rounding as in Note::serialize; the deltas are
+        // zigzag-encoded, so the unsorted notes are fine here too
+        const auto timestamp = int64(int(note->getBeat() * TICKS_PER_BEAT));
+        ids.add(int64(note->getId().getCompactValue()));
+        keys.add(note->getKey());
+        beats.add(timestamp - lastTimestamp);
+        lengths.add(int(note->getLength() * TICKS_PER_BEAT));
+        volumes.add(int(note->getVelocity() * VELOCITY_SAVE_ACCURACY));
+        tuplets.add(note->getTuplet());
+        hasTuplets = hasTuplets || note->getTuplet() > 1;
+        lastTimestamp = timestamp;
+    }
+
+    SerializedData packed(Midi::packedNotes);
+    packed.setProperty(Midi::id, ids.toVar());
+    packed.setProperty(Midi::key, keys.toVar());
+    packed.setProperty(Midi::timestamp, beats.toVar());
+    packed.setProperty(Midi::length, lengths.toVar());
+    packed.setProperty(Midi::volume, volumes.toVar());
+    if (hasTuplets)
+    {
+        packed.setProperty(Midi::tuplet, tuplets.toVar());
+    }
+
+    return packed;
+}
+
+static inline uint64 mixNoteHash(uint64 x) noexcept
+{
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+static inline uint64 hashNoteParameters(uint64 id, int key,
+    int timestamp, int length, int volume, int tuplet) noexcept
+{
+    auto h = mixNoteHash(id);
+    h = mixNoteHash(h ^ uint32(key));
+    h = mixNoteHash(h ^ uint32(timestamp));
+    h = mixNoteHash(h ^ uint32(length));
+    h = mixNoteHash(h ^ uint32(volume));
+    return mixNoteHash(h ^ uint32(tuplet));
+}
+
+// the per-note hashes are summed up, so that the order doesn't matter,
+// and the number of notes is mixed in; never returns zero, "no hash"
+static inline HashCode finishNotesHash(uint64 sum, int numNotes) noexcept
+{
+    const auto h = mixNoteHash(sum ^ uint64(numNotes));
+    return h == 0 ? HashCode(1) : HashCode(h);
+}
+
+HashCode PianoSequence::getNotesHash() const noexcept
+{
+    if (!this->notesHashIsOutdated)
+    {
+        return this->notesHash;
+    }
+
+    uint64 sum = 0;
+    for (const auto *event : this->midiEvents)
+    {
+        jassert(event->isTypeOf(MidiEvent::Type::Note));
+        const auto *note = static_cast<const Note *>(event);
+
+        // the same rounding as in Note::serialize
+        sum += hashNoteParameters(note->getId().getCompactValue(),
+            note->getKey(),
+            int(note->getBeat() * TICKS_PER_BEAT),
+            int(note->getLength() * TICKS_PER_BEAT),
+            int(note->getVelocity() * VELOCITY_SAVE_ACCURACY),
+            note->getTuplet());
+    }
+
+    this->notesHash = finishNotesHash(sum, this->midiEvents.size());
+    this->notesHashIsOutdated = false;
+    return this->notesHash;
+}
+
+HashCode PianoSequence::getNotesHash(const SerializedData &notesData)
+{
+    using namespace Serialization;
+
+    uint64 sum = 0;
+    int numNotes = 0;
+    forEachChildWithType(notesData, e, Midi::note)
+    {
+        sum += hashNoteParameters(Note::Id(e.getProperty(Midi::id).toString()).getCompactValue(),
+            e.getProperty(Midi::key),
+            e.getProperty(Midi::timestamp),
+            e.getProperty(Midi::length),
+            e.getProperty(Midi::volume),
+            e.getProperty(Midi::tuplet, 1));
+
+        numNotes++;
+    }
+
+    return finishNotesHash(sum, numNotes);
+}
+
 void PianoSequence::deserialize(const SerializedData &data)
 {
-    this->reset();
+    ParsedNotes parsedNotes;
+    PianoSequence::parseNotes(data, parsedNotes);
+    this->attachNotes(parsedNotes);
+}
 
+void PianoSequence::parseNotes(const SerializedData &data, ParsedNotes &result)
+{
+    using namespace Serialization;
     const auto root =
-        data.hasType(Serialization::Midi::track) ?
-        data : data.getChildWithName(Serialization::Midi::track);
+        data.hasType(Midi::track) ?
+        data : data.getChildWithName(Midi::track);
 
     if (!root.isValid())
     {
         return;
     }
 
-    forEachChildWithType(root, e, Serialization::Midi::note)
+    // the notes are created without an owner here, which also
+    // saves generating the new unique ids only to overwrite them
+    auto &notes = result.notes;
+
+    const auto packed = root.getChildWithName(Midi::packedNotes);
+    if (packed.isValid())
+    {
+        PackedColumn::Reader ids(packed.getProperty(Midi::id));
+        PackedColumn::Reader keys(packed.getProperty(Midi::key));
+        PackedColumn::Reader beats(packed.getProperty(Midi::timestamp));
+        PackedColumn::Reader lengths(packed.getProperty(Midi::length));
+        PackedColumn::Reader volumes(packed.getProperty(Midi::volume));
+        PackedColumn::Reader tuplets(packed.getProperty(Midi::tuplet));
+
+        const auto numNotes = ids.size();
+        const bool hasTuplets = tuplets.size() == numNotes;
+        if (keys.size() == numNotes && beats.size() == numNotes &&
+            lengths.size() == numNotes && volumes.size() == numNotes)
+        {
+            notes.ensureStorageAllocated(numNotes);
+
+            int64 timestamp = 0;
+            for (int i = 0; i < numNotes; ++i)
+            {
+                timestamp += beats.next();
+
+                auto *note = new Note();
+                note->deserialize(Note::Id::fromCompactValue(uint64(ids.next())),
+                    Note::Key(keys.next()),
+                    float(timestamp) / TICKS_PER_BEAT,
+                    float(lengths.next()) / TICKS_PER_BEAT,
+                    float(volumes.next()) / VELOCITY_SAVE_ACCURACY,
+                    hasTuplets ? Note::Tuplet(tuplets.next()) : Note::Tuplet(1));
+
+                notes.add(note); // sorted later
+                result.ids.insert(note->getId());
+            }
+        }
+        else
+        {
+            jassertfalse; // broken columns
+        }
+    }
+
+    forEachChildWithType(root, e, Midi::note)
     {
-        auto *note = new Note(this);
+        auto *note = new Note();
         note->deserialize(e);
 
-        this->midiEvents.add(note); // sorted later
-        this->usedEventIds.insert(note->getId());
+        notes.add(note); // sorted later
+        result.ids.insert(note->getId());
     }
 
-    this->sort();
+    if (!notes.isEmpty())
+    {
+        notes.sort(*notes.getFirst());
+    }
+}
+
+void PianoSequence::attachNotes(ParsedNotes &parsedNotes)
+{
+    this->reset();
+    this->adoptSortedEvents(parsedNotes.notes, parsedNotes.ids);
     this->updateBeatRange(false);
 }
 
@@ -337,4 +1035,36 @@ void PianoSequence::reset()
 {
     this->midiEvents.clear();
     this->usedEventIds.clear();
+    this->invalidateCaches();
+}
+
+//===----------------------------------------------------------------------===//
+// NotesState
+//===----------------------------------------------------------------------===//
+
+int PianoSequence::NotesState::getSizeInBytes() const noexcept
+{
+    return this->beats.size() * int(sizeof(float)) +
+        this->keys.size() * int(sizeof(Note::Key)) +
+        this->lengths.size() * int(sizeof(float)) +
+        this->velocities.size() * int(sizeof(float)) +
+        this->tuplets.size() * int(sizeof(Note::Tuplet));
+}
+
+void PianoSequence::NotesState::swapWith(NotesState &other) noexcept
+{
+    this->beats.swapWith(other.beats);
+    this->keys.swapWith(other.keys);
+    this->lengths.swapWith(other.lengths);
+    this->velocities.swapWith(other.velocities);
+    this->tuplets.swapWith(other.tuplets);
+}
+
+void PianoSequence::NotesState::clear() noexcept
+{
+    this->beats.clear();
+    this->keys.clear();
+    this->lengths.clear();
+    this->velocities.clear();
+    this->tuplets.clear();
 }
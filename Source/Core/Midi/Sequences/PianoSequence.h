@@ -33,8 +33,24 @@ public:
     //===------------------------------------------------------------------===//
 
     void importMidi(const MidiMessageSequence &sequence, short timeFormat) override;
-    void exportMidi(MidiMessageSequence &outSequence, const Clip &clip,
+
+    // The import is split in two: pairing note-ons with note-offs doesn't
+    // touch the sequence, so it can run on any thread, e.g. for all tracks
+    // of a file at once, and the notes are then added to the sequence in bulk
+    struct ImportedNote final
+    {
+        Note::Key key;
+        float beat;
+        float length;
+        float velocity;
+    };
+
+    static void parseMidi(const MidiMessageSequence &sequence,
+        short timeFormat, Array<ImportedNote> &outNotes);
+    void importNotes(const Array<ImportedNote> &notes);
+    void exportMidi(MidiExportBuffer &outBuffer, const Clip &clip,
         bool soloPlaybackMode, double timeAdjustment, double timeFactor) const override;
+    bool isClipAudible(const Clip &clip, bool soloPlaybackMode) const noexcept override;
 
     //===------------------------------------------------------------------===//
     // Undoable track editing
@@ -52,11 +68,108 @@ public:
         Array<Note> &eventsAfter,
         bool undoable);
 
+    // The notes' parameters in parallel arrays, which is how the undo stack
+    // keeps the group edits compactly: the notes are found by their ids and
+    // beats, and only the parameters that change are stored, while the arrays
+    // for the parameters that don't change are left empty (in the initial state
+    // of a change, the beats are always there, since they are needed for lookups)
+    struct NotesState final
+    {
+        Array<float> beats;
+        Array<Note::Key> keys;
+        Array<float> lengths;
+        Array<float> velocities;
+        Array<Note::Tuplet> tuplets;
+
+        int getSizeInBytes() const noexcept;
+        void swapWith(NotesState &other) noexcept;
+        void clear() noexcept;
+    };
+
+    // Applies the changes recorded as above, see NotesGroupChangeAction
+    bool changeGroup(const Array<Note::Id> &ids,
+        const NotesState &stateBefore, const NotesState &stateAfter);
+
+    // Records the changes as above in one undo action, which takes the arrays'
+    // contents; the bulk edits, like the velocity map's, use this to skip
+    // the notes' copies, and the consecutive changes of the same ids coalesce
+    bool changeGroup(Array<Note::Id> &ids, NotesState &stateBefore,
+        NotesState &stateAfter, bool undoable);
+
+    // Bulk edits, applied to the notes in place; instead of the notes' copies,
+    // the undo stack only keeps the transform, the ids and the initial values
+    // of the parameters which the transform changes, see NotesGroupTransformAction
+    bool transformGroup(const Array<const Note *> &notes,
+        const Note::Transform &transform, bool undoable);
+    bool applyTransform(const Array<Note::Id> &ids, const NotesState &initialState,
+        const Note::Transform &transform, bool shouldRevert);
+
     //===------------------------------------------------------------------===//
     // Accessors
     //===------------------------------------------------------------------===//
     
     float getLastBeat() const noexcept override;
+
+    // A compact copy of all notes' parameters in parallel arrays, sorted
+    // the same way as the sequence itself, so that the long scans, like
+    // exporting or painting the whole track, don't chase a pointer per note;
+    // the owned Note objects are still the stable handles for the UI and undo,
+    // and the arrays are rebuilt lazily after any change (message thread only)
+    struct PackedNotes final
+    {
+        Array<float> beats;
+        Array<float> lengths;
+        Array<float> velocities;
+        Array<Note::Key> keys;
+        Array<Note::Tuplet> tuplets;
+        Array<const Note *> handles;
+
+        // the running maximum of the notes' end beats, which is
+        // non-decreasing, so that the interval queries below can
+        // binary search for the first note still sounding at some beat
+        Array<float> maxEndBeats;
+
+        inline int size() const noexcept { return this->beats.size(); }
+        void clear() noexcept;
+
+        // the indices of the notes that may intersect the range, i.e. all notes
+        // before have ended by startBeat, and all notes after haven't started by endBeat;
+        // the views painting the notes right from these arrays cull them this way
+        Range<int> getCandidatesInRange(float startBeat, float endBeat) const noexcept;
+    };
+
+    const PackedNotes &getPackedNotes() const;
+
+    // An immutable copy of the packed notes, for the background readers,
+    // like the exporters, to hold while the sequence keeps being edited;
+    // it has no handles, since the notes may be deleted any time, and it is
+    // only re-packed after the changes, so the snapshots of an unchanged
+    // sequence are all shared: compare the versions to see if it's outdated
+    struct Snapshot final : public ReferenceCountedObject
+    {
+        using Ptr = ReferenceCountedObjectPtr<Snapshot>;
+
+        uint32 version = 0;
+        int channel = 0;
+        PackedNotes notes;
+
+        // the same as PianoSequence::exportMidi, callable from any thread
+        void exportMidi(MidiExportBuffer &outBuffer, const Clip &clip,
+            bool soloPlaybackMode, double timeAdjustment, double timeFactor) const;
+    };
+
+    // message thread only, like getPackedNotes
+    Snapshot::Ptr getSnapshot() const;
+
+    // incremented on any change of the notes
+    inline uint32 getVersion() const noexcept { return this->version; }
+
+    // Both take O(log n + k) where k is the number of candidates between
+    // the first note that may still sound and the last note starting in time;
+    // the results are sorted the same way as the sequence
+    void findNotesInRange(float startBeat, float endBeat,
+        Array<const Note *> &result) const;
+    void findNotesSoundingAt(float beat, Array<const Note *> &result) const;
     
     //===------------------------------------------------------------------===//
     // Serializable
@@ -66,8 +179,61 @@ public:
     void deserialize(const SerializedData &data) override;
     void reset() override;
 
+    // The deserialization is split in two as well: parsing the notes
+    // doesn't touch the sequence, so it can run on any thread, e.g. for
+    // all tracks of a project at once (see ProjectNode::load), and the
+    // parsed notes, already sorted, are then moved into the sequence
+    struct ParsedNotes final
+    {
+        OwnedArray<MidiEvent> notes;
+        FlatHashSet<MidiEvent::Id, MidiEventIdHash> ids;
+    };
+
+    static void parseNotes(const SerializedData &data, ParsedNotes &result);
+    void attachNotes(ParsedNotes &parsedNotes);
+
+    // packs any notes into the columns node, which parseNotes reads back,
+    // used by serialize and by the clipboard to copy the large selections
+    static SerializedData packNotes(const Array<const Note *> &notes);
+
+    // The order-independent hash of all notes' saved parameters, the same
+    // as the static one gives for their serialized nodes (see Note::serialize),
+    // used by the vcs to skip the unchanged tracks when rebuilding the diff;
+    // it's cached until any change, like the last note end beat
+    HashCode getNotesHash() const noexcept;
+    static HashCode getNotesHash(const SerializedData &notesData);
+
+protected:
+
+    void invalidateCaches() noexcept override;
+
 private:
 
+    // finds the notes by their current beats and ids, and updates them,
+    // keeping the sequence sorted and notifying the listeners once
+    void updateGroup(const Array<Note::Id> &ids,
+        const Array<float> &currentBeats, bool changesBeats,
+        const Function<void(Note &note, int index)> &update);
+
+    // both keep the owned events sorted in a single pass,
+    // the removal returns the events taken out, not deleted
+    void mergeSorted(Array<MidiEvent *> &newEvents);
+    Array<MidiEvent *> removeSorted(Array<int> &indices);
+
+    mutable PackedNotes packedNotes;
+    mutable bool packedNotesAreOutdated = true;
+
+    uint32 version = 0;
+    mutable Snapshot::Ptr snapshot;
+
+    // the exact end of the longest note, which is not necessarily
+    // the last one; unlike the packed notes, can be updated from any thread
+    mutable float lastNoteEndBeat = -FLT_MAX;
+    mutable bool lastNoteEndBeatIsOutdated = true;
+
+    mutable HashCode notesHash = 0;
+    mutable bool notesHashIsOutdated = true;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PianoSequence);
     JUCE_DECLARE_WEAK_REFERENCEABLE(PianoSequence);
 };
@@ -143,13 +143,18 @@ bool TimeSignaturesSequence::insertGroup(Array<TimeSignatureEvent> &signatures,
     }
     else
     {
+        Array<const MidiEvent *> addedEvents;
+        addedEvents.ensureStorageAllocated(signatures.size());
+
         for (int i = 0; i < signatures.size(); ++i)
         {
             const TimeSignatureEvent &eventParams = signatures.getReference(i);
             auto *ownedEvent = new TimeSignatureEvent(this, eventParams);
             this->midiEvents.addSorted(*ownedEvent, ownedEvent);
-            this->eventDispatcher.dispatchAddEvent(*ownedEvent);
+            addedEvents.add(ownedEvent);
         }
+
+        this->eventDispatcher.dispatchAddEvents(addedEvents);
         
         this->updateBeatRange(true);
     }
@@ -167,17 +172,34 @@ bool TimeSignaturesSequence::removeGroup(Array<TimeSignatureEvent> &signatures,
     }
     else
     {
+        // find all the events first, so that the listeners get notified
+        // once per group while the events are still in the sequence
+        SortedSet<int> indices;
+        indices.ensureStorageAllocated(signatures.size());
+        Array<const MidiEvent *> removedEvents;
+        removedEvents.ensureStorageAllocated(signatures.size());
+
         for (int i = 0; i < signatures.size(); ++i)
         {
             const TimeSignatureEvent &signature = signatures.getReference(i);
             const int index = this->midiEvents.indexOfSorted(signature, &signature);
             if (index >= 0)
             {
-                auto *removedSignature = this->midiEvents.getUnchecked(index);
-                this->eventDispatcher.dispatchRemoveEvent(*removedSignature);
-                this->midiEvents.remove(index, true);
+                indices.add(index);
             }
         }
+
+        for (const auto index : indices)
+        {
+            removedEvents.add(this->midiEvents.getUnchecked(index));
+        }
+
+        this->eventDispatcher.dispatchRemoveEvents(removedEvents);
+
+        for (int i = indices.size(); i --> 0 ;)
+        {
+            this->midiEvents.remove(indices.getUnchecked(i), true);
+        }
         
         this->updateBeatRange(true);
         this->eventDispatcher.dispatchPostRemoveEvent(this);
@@ -199,6 +221,10 @@ bool TimeSignaturesSequence::changeGroup(Array<TimeSignatureEvent> &groupBefore,
     }
     else
     {
+        Array<const MidiEvent *> oldEvents, newEvents;
+        oldEvents.ensureStorageAllocated(groupBefore.size());
+        newEvents.ensureStorageAllocated(groupBefore.size());
+
         for (int i = 0; i < groupBefore.size(); ++i)
         {
             const TimeSignatureEvent &oldParams = groupBefore.getReference(i);
@@ -210,10 +236,13 @@ bool TimeSignaturesSequence::changeGroup(Array<TimeSignatureEvent> &groupBefore,
                 changedEvent->applyChanges(newParams);
                 this->midiEvents.remove(index, false);
                 this->midiEvents.addSorted(*changedEvent, changedEvent);
-                this->eventDispatcher.dispatchChangeEvent(oldParams, *changedEvent);
+                oldEvents.add(&oldParams);
+                newEvents.add(changedEvent);
             }
         }
 
+        this->eventDispatcher.dispatchChangeEvents(oldEvents, newEvents);
+
         this->updateBeatRange(true);
     }
 
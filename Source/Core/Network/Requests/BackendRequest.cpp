@@ -25,6 +25,9 @@
 #define CONNECTION_TIMEOUT_MS (0)
 #define NUM_CONNECT_ATTEMPTS (3)
 
+// The first byte of the gzip header, never found in json:
+#define GZIP_MAGIC_BYTE (0x1f)
+
 BackendRequest::Response::Response() {}
 
 bool BackendRequest::Response::hasValidBody() const noexcept
@@ -37,6 +40,17 @@ bool BackendRequest::Response::is2xx() const noexcept
     return (this->statusCode / 100) == 2;
 }
 
+bool BackendRequest::Response::is5xx() const noexcept
+{
+    return (this->statusCode / 100) == 5;
+}
+
+bool BackendRequest::Response::isRetriable() const noexcept
+{
+    // no connection or the server is having issues
+    return this->statusCode == 0 || this->is5xx();
+}
+
 bool BackendRequest::Response::is200() const noexcept
 {
     return this->statusCode == 200;
@@ -96,6 +110,8 @@ static String getHeaders()
         << "Content-Type: " << apiVersion1
         << "\r\n"
         << "User-Agent: " << userAgent
+        << "\r\n"
+        << "Accept-Encoding: gzip"
         << "\r\n";
 
     const auto &profile = App::Workspace().getUserProfile();
@@ -109,6 +125,71 @@ static String getHeaders()
     return extraHeaders;
 }
 
+//===----------------------------------------------------------------------===//
+// Conditional requests
+//===----------------------------------------------------------------------===//
+
+// The last seen bodies of the cacheable responses, per endpoint and token,
+// so that they aren't sent again by the server if nothing has changed
+struct CachedResponse final
+{
+    String eTag;
+    SerializedData body;
+};
+
+static SpinLock cachedResponsesLock;
+static FlatHashMap<String, CachedResponse, StringHash> cachedResponses;
+
+static String getCacheKey(const String &apiEndpoint)
+{
+    const auto &profile = App::Workspace().getUserProfile();
+    return apiEndpoint + (profile.isLoggedIn() ? profile.getApiToken() : String());
+}
+
+BackendRequest::Response BackendRequest::getCached() const
+{
+    const auto cacheKey = getCacheKey(this->apiEndpoint);
+
+    String eTag;
+    {
+        SpinLock::ScopedLockType lock(cachedResponsesLock);
+        const auto cached = cachedResponses.find(cacheKey);
+        if (cached != cachedResponses.end())
+        {
+            eTag = cached->second.eTag;
+        }
+    }
+
+    const String extraHeaders = eTag.isEmpty() ? String() :
+        "If-None-Match: " + eTag + "\r\n";
+
+    auto response = this->doRequest("GET", extraHeaders);
+
+    if (response.is(304))
+    {
+        SpinLock::ScopedLockType lock(cachedResponsesLock);
+        const auto cached = cachedResponses.find(cacheKey);
+        if (cached != cachedResponses.end())
+        {
+            // callers may modify the body, so they get a copy
+            DBG("<< Not modified, using the cached response");
+            response.statusCode = 200;
+            response.body = cached->second.body.createCopy();
+        }
+    }
+    else if (response.is200() && response.hasValidBody())
+    {
+        const auto newETag = response.headers.getValue("ETag", {});
+        if (newETag.isNotEmpty())
+        {
+            SpinLock::ScopedLockType lock(cachedResponsesLock);
+            cachedResponses[cacheKey] = { newETag, response.body.createCopy() };
+        }
+    }
+
+    return response;
+}
+
 void BackendRequest::processResponse(BackendRequest::Response &response, InputStream *const stream) const
 {
     if (stream == nullptr)
@@ -116,19 +197,32 @@ void BackendRequest::processResponse(BackendRequest::Response &response, InputSt
         return;
     }
 
-    // Try to parse response as JSON object wrapping all properties
-    const String responseBody = stream->readEntireStreamAsString();
-    if (responseBody.isNotEmpty())
+    // Some platforms decode the gzipped body transparently,
+    // and some don't, so rather check the body itself than the Content-Encoding header
+    BufferedInputStream bufferedStream(stream, 256, false);
+    const bool isGzipped = (uint8(bufferedStream.peekByte()) == GZIP_MAGIC_BYTE);
+
+    GZIPDecompressorInputStream decompressedStream(&bufferedStream, false,
+        GZIPDecompressorInputStream::gzipFormat);
+
+    InputStream &bodyStream = isGzipped ?
+        static_cast<InputStream &>(decompressedStream) :
+        static_cast<InputStream &>(bufferedStream);
+
+    // Try to parse response as JSON object wrapping all properties,
+    // reading it right from the stream, without a copy of the whole text
+    SerializedData body;
+    if (this->serializer.loadFromStream(bodyStream, body).failed())
     {
-        DBG("<< Received " << response.statusCode << " " // << responseBody);
-            << responseBody.substring(0, 128) << (responseBody.length() > 128 ? ".." : ""));
+        DBG("<< Received " << response.statusCode << ", failed to parse");
+        response.errors.add(TRANS(I18n::Common::networkError));
+        return;
+    }
 
-        response.body = this->serializer.loadFromString(responseBody);
-        if (!response.body.isValid())
-        {
-            response.errors.add(TRANS(I18n::Common::networkError));
-            return;
-        }
+    if (body.isValid())
+    {
+        DBG("<< Received " << response.statusCode);
+        response.body = body;
 
         // Try to parse errors
         if (response.statusCode < 200 || response.statusCode >= 400)
@@ -171,7 +265,7 @@ BackendRequest::Response BackendRequest::del() const
     return this->doRequest("DELETE");
 }
 
-BackendRequest::Response BackendRequest::doRequest(const String &verb) const
+BackendRequest::Response BackendRequest::doRequest(const String &verb, const String &extraHeaders) const
 {
     Response response;
     UniquePointer<InputStream> stream;
@@ -184,7 +278,7 @@ BackendRequest::Response BackendRequest::doRequest(const String &verb) const
         DBG(">> " << verb << " " << this->apiEndpoint);
         stream.reset(url.createInputStream(false,
             nullptr, (void *)(this),
-            getHeaders(), CONNECTION_TIMEOUT_MS,
+            getHeaders() + extraHeaders, CONNECTION_TIMEOUT_MS,
             &response.headers, &response.statusCode,
             5, verb));
     } while (stream == nullptr && ++i < NUM_CONNECT_ATTEMPTS);
@@ -198,20 +292,22 @@ BackendRequest::Response BackendRequest::doRequest(const SerializedData &payload
     Response response;
     UniquePointer<InputStream> stream;
 
-    String jsonPayload;
-    if (this->serializer.saveToString(jsonPayload, payload).failed())
+    MemoryOutputStream jsonPayload;
+    if (this->serializer.saveToStream(jsonPayload, payload).failed())
     {
         return response;
     }
 
     const auto url = URL(Routes::Api::baseURL + this->apiEndpoint)
-        .withPOSTData(MemoryBlock(jsonPayload.toRawUTF8(), jsonPayload.getNumBytesAsUTF8()));
+        .withPOSTData(jsonPayload.getMemoryBlock());
 
     int i = 0;
     do
     {
-        DBG(">> " << verb << " " << this->apiEndpoint << " " 
-            << jsonPayload.substring(0, 128) + (jsonPayload.length() > 128 ? ".." : ""));
+        DBG(">> " << verb << " " << this->apiEndpoint << " "
+            << String::fromUTF8(static_cast<const char *>(jsonPayload.getData()),
+                int(jmin(jsonPayload.getDataSize(), size_t(128))))
+            << (jsonPayload.getDataSize() > 128 ? ".." : ""));
 
         stream.reset(url.createInputStream(true,
             nullptr, (void *)(this),
@@ -30,8 +30,12 @@ public:
         Response();
 
         bool is2xx() const noexcept;
+        bool is5xx() const noexcept;
         bool is200() const noexcept;
         bool is(int code) const noexcept;
+
+        // the failures which make sense to try again later
+        bool isRetriable() const noexcept;
         bool hasValidBody() const noexcept;
 
         // SerializedData wrappers
@@ -57,6 +61,11 @@ public:
     };
 
     Response get() const;
+
+    // A conditional GET: sends the ETag of the last response, if any,
+    // and if the server replies it's not modified, returns its body again;
+    // meant for the rarely changing resources like configs and profile
+    Response getCached() const;
     Response post(const SerializedData &payload) const;
     Response put(const SerializedData &payload) const;
     Response del() const;
@@ -66,7 +75,7 @@ private:
     String apiEndpoint;
     JsonSerializer serializer;
 
-    Response doRequest(const String &verb) const;
+    Response doRequest(const String &verb, const String &extraHeaders = {}) const;
     Response doRequest(const SerializedData &payload, const String &verb) const;
     void processResponse(Response &response, InputStream *const stream) const;
 
@@ -61,7 +61,7 @@ private:
 
         const String uri = Routes::Api::baseResource.replace(":resourceType", this->resourceType);
         const BackendRequest request(uri);
-        this->response = request.get();
+        this->response = request.getCached();
 
         if (!this->response.hasValidBody() || !this->response.is2xx())
         {
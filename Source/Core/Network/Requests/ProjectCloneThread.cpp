@@ -19,6 +19,7 @@
 #include "ProjectCloneThread.h"
 #include "RevisionsSyncHelpers.h"
 #include "ProjectDto.h"
+#include "RevisionDto.h"
 #include "Network.h"
 
 namespace ApiKeys = Serialization::Api::V1;
@@ -72,40 +73,47 @@ void ProjectCloneThread::run()
     {
         DBG("Failed to construct remote history tree");
         callbackOnMessageThread(ProjectCloneThread, onCloneFailed, {}, self->projectId);
+        return;
     }
 
     this->vcs->replaceHistory(remoteHistory);
 
-    this->newHead = nullptr;
+    RevisionsMap revisionsIndex;
+    RevisionsSyncHelpers::buildLocalRevisionsIndex(revisionsIndex, this->vcs->getRoot());
 
-    // if anything is needed to pull, fetch all data for each, then update and callback
-    for (const auto &dto : remoteProject.getRevisions())
+    if (revisionsIndex.contains(remoteProject.getHead()))
     {
-        const String revisionRoute(Routes::Api::projectRevision
-            .replace(":projectId", this->projectId)
-            .replace(":revisionId", dto.getId()));
-
-        const BackendRequest revisionRequest(revisionRoute);
-        this->response = revisionRequest.get();
-        if (!this->response.is2xx())
+        this->newHead = revisionsIndex[remoteProject.getHead()];
+    }
+    else
+    {
+        // if project's head is null, this will at least point the new head to one of leafs:
+        this->newHead = this->vcs->getRoot();
+        while (!this->newHead->getChildren().isEmpty())
         {
-            DBG("Failed to fetch revision data: " + this->response.getErrors().getFirst());
-            callbackOnMessageThread(ProjectCloneThread, onCloneFailed, self->response.getErrors(), self->projectId);
-            return;
+            this->newHead = this->newHead->getChildren().getFirst();
         }
+    }
 
-        const RevisionDto fullData(this->response.getBody());
-        auto revision = this->vcs->updateShallowRevisionData(fullData.getId(), fullData.getData());
+    // the project is usable as soon as the chain from the root
+    // to the head revision is fetched, the rest of revisions are
+    // left as shallow copies for now, and fetched after the checkout
+    ReferenceCountedArray<VCS::Revision> headChain;
+    for (VCS::Revision::Ptr revision = this->newHead; revision != nullptr; revision = revision->getParent())
+    {
+        headChain.add(revision);
+    }
 
-        // if project's head is null, this will at least point the new head to one of leafs:
-        if ((this->newHead == nullptr && revision->getChildren().isEmpty()) ||
-            revision->getUuid() == remoteProject.getHead())
+    if (!this->fetchRevisionsData(headChain))
+    {
+        if (!this->threadShouldExit())
         {
-            this->newHead = revision;
+            DBG("Failed to fetch revision data: " + this->response.getErrors().getFirst());
+            callbackOnMessageThread(ProjectCloneThread, onCloneFailed, self->response.getErrors(), self->projectId);
         }
-    }
 
-    jassert(this->newHead != nullptr);
+        return;
+    }
 
     // checkout the head revision
     MessageManager::getInstance()->callFunctionOnMessageThread([](void *ptr) -> void*
@@ -116,4 +124,54 @@ void ProjectCloneThread::run()
     }, this);
 
     callbackOnMessageThread(ProjectCloneThread, onCloneDone);
+
+    // fill in the rest of the history in background; if that fails,
+    // the revisions that are still shallow copies can be pulled later
+    ReferenceCountedArray<VCS::Revision> otherRevisions;
+    for (const auto &revision : revisionsIndex)
+    {
+        if (revision.second->isShallowCopy())
+        {
+            otherRevisions.add(revision.second);
+        }
+    }
+
+    if (!this->fetchRevisionsData(otherRevisions))
+    {
+        DBG("Failed to fetch the rest of the history: " + this->response.getErrors().getFirst());
+    }
+}
+
+bool ProjectCloneThread::fetchRevisionsData(const ReferenceCountedArray<VCS::Revision> &revisions)
+{
+    Array<RevisionsSyncHelpers::SyncRequest> requests;
+    for (const auto *revision : revisions)
+    {
+        requests.add({ Routes::Api::projectRevision
+            .replace(":projectId", this->projectId)
+            .replace(":revisionId", revision->getUuid()), {} });
+    }
+
+    // each revision is applied as soon as it's fetched, so that
+    // only the responses being processed are kept in memory
+    bool allFetched = true;
+    RevisionsSyncHelpers::sendConcurrently(requests, *this,
+        [this, &allFetched](int, const BackendRequest::Response &revisionResponse)
+    {
+        if (!revisionResponse.is2xx())
+        {
+            if (allFetched)
+            {
+                allFetched = false;
+                this->response = revisionResponse;
+            }
+
+            return;
+        }
+
+        const RevisionDto fullData(revisionResponse.getBody());
+        this->vcs->updateShallowRevisionData(fullData.getId(), fullData.getData());
+    });
+
+    return allFetched && !this->threadShouldExit();
 }
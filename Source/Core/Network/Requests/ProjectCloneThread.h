@@ -37,6 +37,9 @@ public:
 private:
     
     void run() override;
+
+    // returns false if any of the revisions failed to fetch, or if cancelled
+    bool fetchRevisionsData(const ReferenceCountedArray<VCS::Revision> &revisions);
     
     String projectId;
     WeakReference<VersionControl> vcs;
@@ -55,7 +55,7 @@ private:
         namespace ApiRoutes = Routes::Api;
 
         const BackendRequest request(ApiRoutes::userProfile);
-        this->response = request.get();
+        this->response = request.getCached();
 
         if (!this->response.hasValidBody() || !this->response.is200())
         {
@@ -18,6 +18,10 @@
 #include "Common.h"
 #include "RevisionsSyncHelpers.h"
 
+// How many requests could be sent at once,
+// so that syncing lots of revisions isn't bound by round trips:
+#define NUM_SYNC_CONNECTIONS (4)
+
 void RevisionsSyncHelpers::buildLocalRevisionsIndex(RevisionsMap &map, VCS::Revision::Ptr root)
 {
     map[root->getUuid()] = root;
@@ -131,3 +135,89 @@ VCS::Revision::Ptr RevisionsSyncHelpers::constructRemoteTree(const Array<Revisio
     jassert(root != nullptr);
     return root;
 }
+
+void RevisionsSyncHelpers::sendConcurrently(const Array<SyncRequest> &requests,
+    const Thread &thread, const ResponseHandler &handler)
+{
+    if (requests.isEmpty())
+    {
+        return;
+    }
+
+    struct CompletedRequest final
+    {
+        int index;
+        BackendRequest::Response response;
+    };
+
+    CriticalSection completedRequestsLock;
+    Array<CompletedRequest> completedRequests;
+    WaitableEvent requestCompleted;
+
+    // each connection takes the next pending request until none is left,
+    // or until the thread is told to exit, leaving the rest of requests unsent
+    Atomic<int> nextRequest(0);
+    const auto sendRequests = [&]()
+    {
+        for (int i = (++nextRequest) - 1; i < requests.size(); i = (++nextRequest) - 1)
+        {
+            if (thread.threadShouldExit())
+            {
+                return;
+            }
+
+            const auto &request = requests.getReference(i);
+            const BackendRequest backendRequest(request.route);
+            auto response = request.payload.isValid() ?
+                backendRequest.put(request.payload) : backendRequest.get();
+
+            {
+                const ScopedLock lock(completedRequestsLock);
+                completedRequests.add({ i, std::move(response) });
+            }
+
+            requestCompleted.signal();
+        }
+    };
+
+    const int numWorkers = jmin(requests.size(), NUM_SYNC_CONNECTIONS);
+    ThreadPool workers(numWorkers);
+    Atomic<int> numActiveWorkers(numWorkers);
+
+    for (int i = 0; i < numWorkers; ++i)
+    {
+        workers.addJob([&sendRequests, &numActiveWorkers, &requestCompleted]()
+        {
+            sendRequests();
+            --numActiveWorkers;
+            requestCompleted.signal();
+        });
+    }
+
+    // this thread only handles the responses
+    Array<CompletedRequest> responsesToHandle;
+    while (true)
+    {
+        // checked before taking the responses, so that none is left behind
+        const bool allWorkersDone = (numActiveWorkers.get() == 0);
+
+        {
+            const ScopedLock lock(completedRequestsLock);
+            responsesToHandle.swapWith(completedRequests);
+        }
+
+        for (const auto &completedRequest : responsesToHandle)
+        {
+            handler(completedRequest.index, completedRequest.response);
+        }
+
+        responsesToHandle.clearQuick();
+
+        if (allWorkersDone)
+        {
+            break;
+        }
+
+        requestCompleted.wait(100);
+    }
+}
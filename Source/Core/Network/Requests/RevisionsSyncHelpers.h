@@ -19,6 +19,7 @@
 
 #include "Revision.h"
 #include "RevisionDto.h"
+#include "BackendRequest.h"
 
 using RevisionsMap = FlatHashMap<String, VCS::Revision::Ptr, StringHash>;
 
@@ -35,4 +36,19 @@ struct RevisionsSyncHelpers final
 
     // only used when cloning projects, assuming all revisions will fit in one subtree
     static VCS::Revision::Ptr constructRemoteTree(const Array<RevisionDto> &list);
+
+    // A GET request if the payload is not valid, or a PUT request otherwise
+    struct SyncRequest final
+    {
+        String route;
+        SerializedData payload;
+    };
+
+    using ResponseHandler = Function<void(int requestIndex, const BackendRequest::Response &response)>;
+
+    // Sends the requests over a few connections at once, until the thread is told
+    // to exit; the handler is called on the calling thread for each response
+    // as soon as it arrives, so that the responses are not piled up in memory
+    static void sendConcurrently(const Array<SyncRequest> &requests,
+        const Thread &thread, const ResponseHandler &handler);
 };
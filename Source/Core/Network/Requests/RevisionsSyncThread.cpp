@@ -50,13 +50,15 @@ void RevisionsSyncThread::doFetch(WeakReference<VersionControl> vcs,
     this->vcs = vcs;
     this->idsToPull = {};
     this->idsToPush = {};
+    this->operationId = {};
     this->startThread(2); // bg fetching is a really low priority task
 }
 
 void RevisionsSyncThread::doSync(WeakReference<VersionControl> vcs,
     const String &projectId, const String &projectName,
     const Array<String> &revisionIdsToPull,
-    const Array<String> &revisionIdsToPush)
+    const Array<String> &revisionIdsToPush,
+    const String &operationId)
 {
     if (this->isThreadRunning())
     {
@@ -71,6 +73,7 @@ void RevisionsSyncThread::doSync(WeakReference<VersionControl> vcs,
     this->vcs = vcs;
     this->idsToPull = revisionIdsToPull;
     this->idsToPush = revisionIdsToPush;
+    this->operationId = operationId;
     this->startThread(7);
 }
 
@@ -98,7 +101,8 @@ void RevisionsSyncThread::run()
             if (!this->response.is2xx())
             {
                 DBG("Failed to create the project on remote: " + this->response.getErrors().getFirst());
-                callbackOnMessageThread(RevisionsSyncThread, onSyncFailed, self->response.getErrors());
+                callbackOnMessageThread(RevisionsSyncThread, onSyncFailed,
+                    self->vcs, self->operationId, self->response.getErrors(), self->response.isRetriable());
                 return;
             }
 
@@ -109,7 +113,8 @@ void RevisionsSyncThread::run()
     {
         DBG("Failed to fetch project heads from remote: " + this->response.getErrors().getFirst());
         this->vcs->updateRemoteSyncCache({});
-        callbackOnMessageThread(RevisionsSyncThread, onSyncFailed, self->response.getErrors());
+        callbackOnMessageThread(RevisionsSyncThread, onSyncFailed,
+            self->vcs, self->operationId, self->response.getErrors(), self->response.isRetriable());
         return;
     }
 
@@ -147,7 +152,7 @@ void RevisionsSyncThread::run()
     // everything is up to date
     if (newLocalRevisions.isEmpty() && newRemoteRevisions.isEmpty())
     {
-        callbackOnMessageThread(RevisionsSyncThread, onSyncDone, true);
+        callbackOnMessageThread(RevisionsSyncThread, onSyncDone, self->vcs, self->operationId, true);
         return;
     }
 
@@ -184,34 +189,108 @@ void RevisionsSyncThread::run()
     }
 
     // if anything is needed to pull, fetch all data for each, then update and callback
+    Array<RevisionsSyncHelpers::SyncRequest> pullRequests;
     for (const auto &revisionId : remoteRevisionsToPull)
     {
-        const String revisionRoute(ApiRoutes::projectRevision
+        pullRequests.add({ ApiRoutes::projectRevision
             .replace(":projectId", this->projectId)
-            .replace(":revisionId", revisionId));
+            .replace(":revisionId", revisionId), {} });
+    }
 
-        const BackendRequest revisionRequest(revisionRoute);
-        this->response = revisionRequest.get();
-        if (!this->response.is2xx())
+    // apply each revision as soon as it's fetched, even if some requests have failed,
+    // so that the next sync attempt only has to pull the rest
+    bool pullFailed = false;
+    RevisionsSyncHelpers::sendConcurrently(pullRequests, *this,
+        [this, &pullFailed](int, const BackendRequest::Response &pullResponse)
+    {
+        if (pullResponse.is2xx())
         {
-            DBG("Failed to fetch revision data: " + this->response.getErrors().getFirst());
-            callbackOnMessageThread(RevisionsSyncThread, onSyncFailed, self->response.getErrors());
-            return;
+            const RevisionDto fullRevision(pullResponse.getBody());
+            this->vcs->updateShallowRevisionData(fullRevision.getId(), fullRevision.getData());
         }
+        else if (!pullFailed)
+        {
+            pullFailed = true;
+            this->response = pullResponse;
+        }
+    });
+
+    if (this->threadShouldExit())
+    {
+        return;
+    }
 
-        const RevisionDto fullRevision(this->response.getBody());
-        const auto revision = this->vcs->updateShallowRevisionData(fullRevision.getId(), fullRevision.getData());
+    if (pullFailed)
+    {
+        DBG("Failed to fetch revision data: " + this->response.getErrors().getFirst());
+        callbackOnMessageThread(RevisionsSyncThread, onSyncFailed,
+            self->vcs, self->operationId, self->response.getErrors(), self->response.isRetriable());
+        return;
     }
 
     // if anything is needed to push,
     // build tree(s) from newLocalRevisions list
     const auto newLocalTrees = RevisionsSyncHelpers::constructNewLocalTrees(newLocalRevisions);
 
-    // push them recursively, starting from the root, so that
-    // each pushed revision already has a valid remote parent
-    for (auto *subtree : newLocalTrees)
+    // push them level by level, starting from the roots, so that
+    // each pushed revision already has a valid remote parent,
+    // and all the revisions on the same level are sent concurrently
+    ReferenceCountedArray<VCS::Revision> pushLevel(newLocalTrees);
+    while (!pushLevel.isEmpty())
     {
-        this->pushSubtreeRecursively(subtree);
+        Array<RevisionsSyncHelpers::SyncRequest> pushRequests;
+        ReferenceCountedArray<VCS::Revision> pushedRevisions;
+        ReferenceCountedArray<VCS::Revision> nextLevel;
+
+        for (auto *revision : pushLevel)
+        {
+            // todo debug and fix `push branch` for non-existing remotely project
+            if (this->idsToPush.isEmpty() ||
+                this->idsToPush.contains(revision->getUuid()))
+            {
+                pushRequests.add({ ApiRoutes::projectRevision
+                    .replace(":projectId", this->projectId)
+                    .replace(":revisionId", revision->getUuid()),
+                    this->createRevisionPayload(revision) });
+
+                pushedRevisions.add(revision);
+            }
+
+            nextLevel.addArray(revision->getChildren());
+        }
+
+        bool pushFailed = false;
+        RevisionsSyncHelpers::sendConcurrently(pushRequests, *this,
+            [this, &pushFailed, &pushedRevisions](int i, const BackendRequest::Response &pushResponse)
+        {
+            if (pushResponse.is2xx())
+            {
+                // notify vcs that revision is available remotely
+                this->vcs->updateLocalSyncCache(pushedRevisions[i]);
+            }
+            else if (!pushFailed)
+            {
+                pushFailed = true;
+                this->response = pushResponse;
+            }
+        });
+
+        if (this->threadShouldExit())
+        {
+            return;
+        }
+
+        // children can't be pushed without their parents,
+        // the pushed ones will be skipped on the next attempt
+        if (pushFailed)
+        {
+            DBG("Failed to put revision data: " + this->response.getErrors().getFirst());
+            callbackOnMessageThread(RevisionsSyncThread, onSyncFailed,
+                self->vcs, self->operationId, self->response.getErrors(), self->response.isRetriable());
+            return;
+        }
+
+        pushLevel.swapWith(nextLevel);
     }
 
     // finally, update project head ref
@@ -224,48 +303,25 @@ void RevisionsSyncThread::run()
     if (!this->response.is2xx())
     {
         DBG("Failed to update the project on remote: " + this->response.getErrors().getFirst());
-        callbackOnMessageThread(RevisionsSyncThread, onSyncFailed, self->response.getErrors());
+        callbackOnMessageThread(RevisionsSyncThread, onSyncFailed,
+            self->vcs, self->operationId, self->response.getErrors(), self->response.isRetriable());
         return;
     }
 
-    callbackOnMessageThread(RevisionsSyncThread, onSyncDone, false);
+    callbackOnMessageThread(RevisionsSyncThread, onSyncDone, self->vcs, self->operationId, false);
 }
 
-void RevisionsSyncThread::pushSubtreeRecursively(VCS::Revision::Ptr root)
+SerializedData RevisionsSyncThread::createRevisionPayload(VCS::Revision::Ptr revision) const
 {
-    // todo debug and fix `push branch` for non-existing remotely project
-    if (this->idsToPush.isEmpty() ||
-        this->idsToPush.contains(root->getUuid()))
-    {
-        const String revisionRoute(ApiRoutes::projectRevision
-            .replace(":projectId", this->projectId)
-            .replace(":revisionId", root->getUuid()));
-
-        SerializedData payload(ApiKeys::Revisions::revision);
-        payload.setProperty(ApiKeys::Revisions::message, root->getMessage());
-        payload.setProperty(ApiKeys::Revisions::timestamp, String(root->getTimeStamp()));
-        payload.setProperty(ApiKeys::Revisions::parentId,
-            (root->getParent() ? var(root->getParent()->getUuid()) : var()));
+    SerializedData payload(ApiKeys::Revisions::revision);
+    payload.setProperty(ApiKeys::Revisions::message, revision->getMessage());
+    payload.setProperty(ApiKeys::Revisions::timestamp, String(revision->getTimeStamp()));
+    payload.setProperty(ApiKeys::Revisions::parentId,
+        (revision->getParent() ? var(revision->getParent()->getUuid()) : var()));
 
-        SerializedData data(ApiKeys::Revisions::data);
-        data.appendChild(root->serializeDeltas());
-        payload.appendChild(data);
+    SerializedData data(ApiKeys::Revisions::data);
+    data.appendChild(revision->serializeDeltas());
+    payload.appendChild(data);
 
-        const BackendRequest revisionRequest(revisionRoute);
-        this->response = revisionRequest.put(payload);
-        if (!this->response.is2xx())
-        {
-            DBG("Failed to put revision data: " + this->response.getErrors().getFirst());
-            callbackOnMessageThread(RevisionsSyncThread, onSyncFailed, self->response.getErrors());
-            return;
-        }
-
-        // notify vcs that revision is available remotely
-        this->vcs->updateLocalSyncCache(root);
-    }
-
-    for (auto *child : root->getChildren())
-    {
-        this->pushSubtreeRecursively(child);
-    }
+    return payload;
 }
@@ -28,9 +28,12 @@ public:
     RevisionsSyncThread();
     ~RevisionsSyncThread() override;
     
+    // the operation id is the one given to doSync, see SyncQueue
     Function<void()> onFetchDone;
-    Function<void(bool nothingToSync)> onSyncDone;
-    Function<void(const Array<String> &errors)> onSyncFailed;
+    Function<void(WeakReference<VersionControl> vcs,
+        const String &operationId, bool nothingToSync)> onSyncDone;
+    Function<void(WeakReference<VersionControl> vcs, const String &operationId,
+        const Array<String> &errors, bool canRetry)> onSyncFailed;
 
     void doFetch(WeakReference<VersionControl> vcs,
         const String &projectId, const String &projectName);
@@ -38,16 +41,19 @@ public:
     void doSync(WeakReference<VersionControl> vcs,
         const String &projectId, const String &projectName,
         const Array<String> &revisionIdsToPull = {},
-        const Array<String> &revisionIdsToPush = {});
+        const Array<String> &revisionIdsToPush = {},
+        const String &operationId = {});
 
 private:
     
     void run() override;
-    void pushSubtreeRecursively(VCS::Revision::Ptr subtree);
+
+    SerializedData createRevisionPayload(VCS::Revision::Ptr revision) const;
     
     bool fetchOnly;
     String projectId;
     String projectName;
+    String operationId;
     
     WeakReference<VersionControl> vcs;
 
@@ -65,7 +65,7 @@ private:
         }
 
         const BackendRequest request(ApiRoutes::updatesInfo);
-        this->response = request.get();
+        this->response = request.getCached();
 
         if (!this->response.hasValidBody() || !this->response.is2xx())
         {
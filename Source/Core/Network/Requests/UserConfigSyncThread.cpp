@@ -23,6 +23,13 @@
 namespace ApiKeys = Serialization::Api::V1;
 namespace ApiRoutes = Routes::Api;
 
+// Wait for more changes before uploading:
+#define SYNC_QUIET_PERIOD_MS (1500)
+
+// Retry the failed requests after 2, 4, 8 and 16 seconds:
+#define NUM_SYNC_ATTEMPTS (5)
+#define SYNC_RETRY_DELAY_MS (2000)
+
 UserConfigSyncThread::UserConfigSyncThread() :
     Thread("Sync") {}
 
@@ -33,23 +40,83 @@ UserConfigSyncThread::~UserConfigSyncThread()
     this->stopThread(1000);
 }
 
+static void removeConfiguration(ReferenceCountedArray<BaseResource, CriticalSection> &queue,
+    const BaseResource::Ptr resource)
+{
+    const ScopedLock lock(queue.getLock());
+    for (int i = queue.size(); --i >= 0;)
+    {
+        const auto *queued = queue.getUnchecked(i).get();
+        if (queued->getResourceType() == resource->getResourceType() &&
+            queued->getResourceId() == resource->getResourceId())
+        {
+            queue.remove(i);
+        }
+    }
+}
+
+static void removeConfigurationInfo(ReferenceCountedArray<SyncedConfigurationInfo, CriticalSection> &queue,
+    const SyncedConfigurationInfo::Ptr resource)
+{
+    const ScopedLock lock(queue.getLock());
+    for (int i = queue.size(); --i >= 0;)
+    {
+        const auto *queued = queue.getUnchecked(i).get();
+        if (queued->getType() == resource->getType() &&
+            queued->getName() == resource->getName())
+        {
+            queue.remove(i);
+        }
+    }
+}
+
+template<typename T>
+static ReferenceCountedObjectPtr<T> takeLast(ReferenceCountedArray<T, CriticalSection> &queue)
+{
+    const ScopedLock lock(queue.getLock());
+    ReferenceCountedObjectPtr<T> last(queue.getLast());
+    queue.removeLast();
+    return last;
+}
+
 void UserConfigSyncThread::queueGetConfiguration(const SyncedConfigurationInfo::Ptr resource)
 {
-    this->resourcesToGet.addIfNotAlreadyThere(resource);
+    {
+        const ScopedLock lock(this->resourcesToGet.getLock());
+        removeConfigurationInfo(this->resourcesToGet, resource);
+
+        this->resourcesToGet.add(resource);
+    }
+
     this->signal();
 }
 
 void UserConfigSyncThread::queuePutConfiguration(const BaseResource::Ptr resource)
 {
-    this->resourcesToDelete.removeObject(resource);
-    this->resourcesToPut.addIfNotAlreadyThere(resource);
+    removeConfiguration(this->resourcesToDelete, resource);
+
+    {
+        // the latest version of the resource wins
+        const ScopedLock lock(this->resourcesToPut.getLock());
+        removeConfiguration(this->resourcesToPut, resource);
+        this->resourcesToPut.add(resource);
+    }
+
+    this->lastQueueTime = Time::getMillisecondCounter();
     this->signal();
 }
 
 void UserConfigSyncThread::queueDeleteConfiguration(const BaseResource::Ptr resource)
 {
-    this->resourcesToPut.removeObject(resource);
-    this->resourcesToDelete.addIfNotAlreadyThere(resource);
+    removeConfiguration(this->resourcesToPut, resource);
+
+    {
+        const ScopedLock lock(this->resourcesToDelete.getLock());
+        removeConfiguration(this->resourcesToDelete, resource);
+        this->resourcesToDelete.add(resource);
+    }
+
+    this->lastQueueTime = Time::getMillisecondCounter();
     this->signal();
 }
 
@@ -62,14 +129,22 @@ void UserConfigSyncThread::run()
         // need to wait after each operation,
         // so that callback receives target resource object and says signal()
 
-        if (const auto resource = this->resourcesToGet.getLast())
+        // the resources are taken out of the queues before sending,
+        // so that if they are changed meanwhile, they are queued again
+
+        if (const SyncedConfigurationInfo::Ptr resource = takeLast(this->resourcesToGet))
         {
             const String configurationRoute(ApiRoutes::customResource
                 .replace(":resourceType", resource->getType())
                 .replace(":resourceId", URL::addEscapeChars(resource->getName(), false)));
 
             const BackendRequest syncRequest(configurationRoute);
-            this->response = syncRequest.get();
+            this->response = this->sendWithRetries([&syncRequest]() { return syncRequest.get(); });
+            if (this->threadShouldExit())
+            {
+                return;
+            }
+
             if (this->response.is2xx())
             {
                 callbackOnMessageThread(UserConfigSyncThread, onResourceFetched, { self->response.getBody() });
@@ -80,16 +155,25 @@ void UserConfigSyncThread::run()
                 callbackOnMessageThread(UserConfigSyncThread, onSyncError, self->response.getErrors());
             }
 
-            this->resourcesToGet.removeObject(resource);
-
             WaitableEvent::wait();
         }
 
-        if (const auto resource = this->resourcesToPut.getLast())
+        const auto timeSinceLastQueue = Time::getMillisecondCounter() - this->lastQueueTime.get();
+        if (timeSinceLastQueue < SYNC_QUIET_PERIOD_MS &&
+            !(this->resourcesToPut.isEmpty() && this->resourcesToDelete.isEmpty()))
         {
+            this->waitFor(int(SYNC_QUIET_PERIOD_MS - timeSinceLastQueue));
+            continue;
+        }
+
+        if (const BaseResource::Ptr resource = takeLast(this->resourcesToPut))
+        {
+            this->currentConfigType = resource->getResourceType();
+            this->currentConfigName = resource->getResourceId();
+
             const String configurationRoute(ApiRoutes::customResource
-                .replace(":resourceType", resource->getResourceType())
-                .replace(":resourceId", URL::addEscapeChars(resource->getResourceId(), false)));
+                .replace(":resourceType", this->currentConfigType)
+                .replace(":resourceId", URL::addEscapeChars(this->currentConfigName, false)));
 
             SerializedData payload(ApiKeys::Resources::resource);
             SerializedData data(ApiKeys::Resources::data);
@@ -97,7 +181,12 @@ void UserConfigSyncThread::run()
             payload.appendChild(data);
 
             const BackendRequest syncRequest(configurationRoute);
-            this->response = syncRequest.put(payload);
+            this->response = this->sendWithRetries([&syncRequest, &payload]() { return syncRequest.put(payload); });
+            if (this->threadShouldExit())
+            {
+                return;
+            }
+
             if (this->response.is2xx())
             {
                 callbackOnMessageThread(UserConfigSyncThread, onResourceUpdated, { self->response.getBody() });
@@ -105,39 +194,43 @@ void UserConfigSyncThread::run()
             else
             {
                 DBG("Failed to update resource: " + this->response.getErrors().getFirst());
-                callbackOnMessageThread(UserConfigSyncThread, onSyncError, self->response.getErrors());
+                callbackOnMessageThread(UserConfigSyncThread, onUploadError,
+                    self->currentConfigType, self->currentConfigName,
+                    self->response.getErrors(), self->response.isRetriable());
             }
 
-            this->resourcesToPut.removeObject(resource);
-
             WaitableEvent::wait();
         }
 
-        if (const auto resource = this->resourcesToDelete.getLast())
+        if (const BaseResource::Ptr resource = takeLast(this->resourcesToDelete))
         {
-            this->deletedConfigType = resource->getResourceType();
-            this->deletedConfigName = resource->getResourceId();
+            this->currentConfigType = resource->getResourceType();
+            this->currentConfigName = resource->getResourceId();
 
             const String configurationRoute(ApiRoutes::customResource
-                .replace(":resourceType", this->deletedConfigType)
-                .replace(":resourceId", URL::addEscapeChars(this->deletedConfigName, false)));
+                .replace(":resourceType", this->currentConfigType)
+                .replace(":resourceId", URL::addEscapeChars(this->currentConfigName, false)));
 
             const BackendRequest syncRequest(configurationRoute);
-            this->response = syncRequest.del();
+            this->response = this->sendWithRetries([&syncRequest]() { return syncRequest.del(); });
+            if (this->threadShouldExit())
+            {
+                return;
+            }
 
             if (this->response.is(204) || this->response.is(404))
             {
                 callbackOnMessageThread(UserConfigSyncThread, onResourceDeleted,
-                    self->deletedConfigType, self->deletedConfigName);
+                    self->currentConfigType, self->currentConfigName);
             }
             else
             {
                 DBG("Failed to delete resource: " + this->response.getErrors().getFirst());
-                callbackOnMessageThread(UserConfigSyncThread, onSyncError, self->response.getErrors());
+                callbackOnMessageThread(UserConfigSyncThread, onUploadError,
+                    self->currentConfigType, self->currentConfigName,
+                    self->response.getErrors(), self->response.isRetriable());
             }
 
-            this->resourcesToDelete.removeObject(resource);
-
             WaitableEvent::wait();
         }
 
@@ -149,6 +242,44 @@ void UserConfigSyncThread::run()
     }
 }
 
+BackendRequest::Response UserConfigSyncThread::sendWithRetries(const Function<BackendRequest::Response()> &send)
+{
+    auto response = send();
+
+    for (int i = 1; i < NUM_SYNC_ATTEMPTS; ++i)
+    {
+        if (!response.isRetriable())
+        {
+            break;
+        }
+
+        DBG("Request failed, retrying in " << (SYNC_RETRY_DELAY_MS << (i - 1)) << " ms");
+        if (!this->waitFor(SYNC_RETRY_DELAY_MS << (i - 1)))
+        {
+            break;
+        }
+
+        response = send();
+    }
+
+    return response;
+}
+
+bool UserConfigSyncThread::waitFor(int timeoutMs) const
+{
+    const auto targetTime = Time::getMillisecondCounter() + uint32(timeoutMs);
+    while (Time::getMillisecondCounter() < targetTime)
+    {
+        Thread::sleep(100);
+        if (this->threadShouldExit())
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
 bool UserConfigSyncThread::areQueuesEmpty() const
 {
     return this->resourcesToGet.isEmpty()
@@ -30,6 +30,8 @@ public:
 
     Function<void()> onQueueEmptied;
     Function<void(const Array<String> &errors)> onSyncError;
+    Function<void(const Identifier &type, const String &name,
+        const Array<String> &errors, bool canRetry)> onUploadError;
     Function<void(const UserResourceDto resource)> onResourceFetched;
     Function<void(const UserResourceDto resource)> onResourceUpdated;
     Function<void(const Identifier &type, const String &name)> onResourceDeleted;
@@ -42,6 +44,19 @@ private:
 
     void run() override;
 
+    // Retries the failed requests with a growing delay,
+    // unless the server has rejected the request itself
+    BackendRequest::Response sendWithRetries(const Function<BackendRequest::Response()> &send);
+
+    // Returns false if the thread was told to exit while waiting
+    bool waitFor(int timeoutMs) const;
+
+    // The queues are keyed by resource type and id, so that
+    // only the latest version of each resource is uploaded;
+    // changes are only sent after a short quiet period
+    // to coalesce the bursts of edits into one upload
+    Atomic<uint32> lastQueueTime;
+
     ReferenceCountedArray<SyncedConfigurationInfo, CriticalSection> resourcesToGet;
     ReferenceCountedArray<BaseResource, CriticalSection> resourcesToPut;
     ReferenceCountedArray<BaseResource, CriticalSection> resourcesToDelete;
@@ -49,8 +64,8 @@ private:
     bool areQueuesEmpty() const;
 
     BackendRequest::Response response;
-    Identifier deletedConfigType;
-    String deletedConfigName;
+    Identifier currentConfigType;
+    String currentConfigName;
 
     friend class BackendService;
 
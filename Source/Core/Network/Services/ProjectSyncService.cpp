@@ -38,7 +38,8 @@ void ProjectSyncService::fetchRevisionsInfo(WeakReference<VersionControl> vcs,
 void ProjectSyncService::syncRevisions(WeakReference<VersionControl> vcs,
     const String &projectId, const String &projectName,
     const Array<String> &revisionIdsToPull,
-    const Array<String> &revisionIdsToPush)
+    const Array<String> &revisionIdsToPush,
+    const String &operationId)
 {
     if (auto *thread = this->getRunningThreadFor<RevisionsSyncThread>())
     {
@@ -47,7 +48,7 @@ void ProjectSyncService::syncRevisions(WeakReference<VersionControl> vcs,
     }
 
     this->prepareSyncRevisionsThread()->doSync(vcs, projectId,
-        projectName, revisionIdsToPull, revisionIdsToPush);
+        projectName, revisionIdsToPull, revisionIdsToPush, operationId);
 }
 
 void ProjectSyncService::cancelSyncRevisions()
@@ -102,15 +103,29 @@ RevisionsSyncThread *ProjectSyncService::prepareSyncRevisionsThread()
         // and views will update themselves on the message thread
     };
 
-    thread->onSyncDone = [this](bool nothingToSync)
+    thread->onSyncDone = [this](WeakReference<VersionControl> vcs,
+        const String &operationId, bool nothingToSync)
     {
+        if (vcs != nullptr)
+        {
+            vcs->onSyncOperationDone(operationId);
+        }
+
         const String message = nothingToSync ? TRANS(I18n::VCS::syncUptodate) : TRANS(I18n::VCS::syncDone);
         App::Layout().showTooltip(message, MainLayout::TooltipType::Success);
     };
 
-    thread->onSyncFailed = [](const Array<String> &errors)
+    thread->onSyncFailed = [](WeakReference<VersionControl> vcs, const String &operationId,
+        const Array<String> &errors, bool canRetry)
     {
-        App::Layout().showTooltip(errors.getFirst(), MainLayout::TooltipType::Failure);
+        // the background retries fail silently, until they succeed
+        const bool isUserAttempt = vcs == nullptr ||
+            vcs->onSyncOperationFailed(operationId, canRetry);
+
+        if (isUserAttempt)
+        {
+            App::Layout().showTooltip(errors.getFirst(), MainLayout::TooltipType::Failure);
+        }
     };
 
     return thread;
@@ -34,7 +34,8 @@ public:
     void syncRevisions(WeakReference<VersionControl> vcs,
         const String &projectId, const String &projectName,
         const Array<String> &revisionIdsToPull,
-        const Array<String> &revisionIdsToPush);
+        const Array<String> &revisionIdsToPush,
+        const String &operationId = {});
 
     void cancelSyncRevisions();
 
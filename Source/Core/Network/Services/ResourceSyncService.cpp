@@ -35,14 +35,32 @@ ResourceSyncService::ResourceSyncService() :
     this->prepareUpdatesCheckThread()->checkForUpdates(UPDATE_INFO_TIMEOUT_MS);
     this->synchronizer->startThread(6);
 
+    this->pendingChanges.onRetry = [this](const SyncQueue::Operation &operation)
+    {
+        this->retryPendingChange(operation);
+    };
+
+    App::Config().load(&this->pendingChanges, Serialization::Config::pendingResourceSync);
+
     // todo subscribe on user profile changes
     // detect resources missing locally
     // and put them to download queue
 }
 
+static String getSyncTarget(const Identifier &type, const String &name)
+{
+    return type.toString() + "/" + name;
+}
+
 void ResourceSyncService::queueSync(const BaseResource::Ptr resource)
 {
     jassert(this->synchronizer != nullptr);
+
+    const auto target = getSyncTarget(resource->getResourceType(), resource->getResourceId());
+    this->pendingChanges.cancel(Serialization::Sync::deleteResource, target);
+    this->pendingChanges.enqueue(Serialization::Sync::putResource, target);
+    this->savePendingChanges();
+
     this->synchronizer->queuePutConfiguration(resource);
     DBG("Queued uploading configuration resource: " +
         resource->getResourceType() + "/" + resource->getResourceId());
@@ -51,6 +69,12 @@ void ResourceSyncService::queueSync(const BaseResource::Ptr resource)
 void ResourceSyncService::queueDelete(const BaseResource::Ptr resource)
 {
     jassert(this->synchronizer != nullptr);
+
+    const auto target = getSyncTarget(resource->getResourceType(), resource->getResourceId());
+    this->pendingChanges.cancel(Serialization::Sync::putResource, target);
+    this->pendingChanges.enqueue(Serialization::Sync::deleteResource, target);
+    this->savePendingChanges();
+
     this->synchronizer->queueDeleteConfiguration(resource);
     DBG("Queued deleting configuration resource: " +
         resource->getResourceType() + "/" + resource->getResourceId());
@@ -64,6 +88,42 @@ void ResourceSyncService::queueFetch(const SyncedConfigurationInfo::Ptr resource
         resource->getType() + "/" + resource->getName());
 }
 
+void ResourceSyncService::retryPendingChange(const SyncQueue::Operation &operation)
+{
+    const auto typeName = operation.target.upToFirstOccurrenceOf("/", false, false);
+    const auto name = operation.target.fromFirstOccurrenceOf("/", false, false);
+
+    // the resources are looked up again, so that the latest version is sent
+    BaseResource::Ptr resource;
+    auto &configs = App::Config().getAllResources();
+    if (typeName.isNotEmpty() && configs.contains(Identifier(typeName)))
+    {
+        resource = configs.at(Identifier(typeName))->getResourceById(name);
+    }
+
+    if (resource == nullptr)
+    {
+        DBG("Dropping the sync operation for a missing resource: " + operation.target);
+        this->pendingChanges.acknowledge(operation.id);
+        this->savePendingChanges();
+        return;
+    }
+
+    if (operation.type == Serialization::Sync::putResource)
+    {
+        this->synchronizer->queuePutConfiguration(resource);
+    }
+    else if (operation.type == Serialization::Sync::deleteResource)
+    {
+        this->synchronizer->queueDeleteConfiguration(resource);
+    }
+}
+
+void ResourceSyncService::savePendingChanges()
+{
+    App::Config().save(&this->pendingChanges, Serialization::Config::pendingResourceSync);
+}
+
 UserConfigSyncThread *ResourceSyncService::prepareSyncThread()
 {
     auto *thread = this->getNewThreadFor<UserConfigSyncThread>();
@@ -97,10 +157,25 @@ UserConfigSyncThread *ResourceSyncService::prepareSyncThread()
         this->synchronizer->signal();
     };
 
+    thread->onUploadError = [this](const Identifier &type, const String &name,
+        const Array<String> &errors, bool canRetry)
+    {
+        const auto target = getSyncTarget(type, name);
+        this->pendingChanges.reportFailure(Serialization::Sync::putResource, target, canRetry);
+        this->pendingChanges.reportFailure(Serialization::Sync::deleteResource, target, canRetry);
+        this->savePendingChanges();
+        this->synchronizer->signal();
+    };
+
     thread->onResourceUpdated = [this](const UserResourceDto resource)
     {
         auto &profile = App::Workspace().getUserProfile();
         profile.onConfigurationInfoUpdated(resource);
+
+        this->pendingChanges.cancel(Serialization::Sync::putResource,
+            getSyncTarget(resource.getType(), resource.getName()));
+        this->savePendingChanges();
+
         this->synchronizer->signal();
     };
 
@@ -108,6 +183,10 @@ UserConfigSyncThread *ResourceSyncService::prepareSyncThread()
     {
         auto &profile = App::Workspace().getUserProfile();
         profile.onConfigurationInfoReset(type, name);
+
+        this->pendingChanges.cancel(Serialization::Sync::deleteResource, getSyncTarget(type, name));
+        this->savePendingChanges();
+
         this->synchronizer->signal();
     };
 
@@ -24,6 +24,7 @@
 #include "BackendService.h"
 #include "SyncedConfigurationInfo.h"
 #include "BaseResource.h"
+#include "SyncQueue.h"
 
 class ResourceSyncService final : private BackendService
 {
@@ -40,6 +41,12 @@ private:
     UserConfigSyncThread *prepareSyncThread();
     WeakReference<UserConfigSyncThread> synchronizer;
 
+    // the uploads and deletions not yet confirmed, kept in the config,
+    // so that they are re-sent when the connection is back
+    SyncQueue pendingChanges;
+    void retryPendingChange(const SyncQueue::Operation &operation);
+    void savePendingChanges();
+
     UpdatesCheckThread *prepareUpdatesCheckThread();
     BaseConfigSyncThread *prepareResourceRequestThread();
 
@@ -0,0 +1,261 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Common.h"
+#include "SyncQueue.h"
+#include "SerializationKeys.h"
+
+// Retry after 5, 10, 20 seconds and so on, up to 10 minutes:
+#define SYNC_RETRY_MIN_DELAY_MS (5 * 1000)
+#define SYNC_RETRY_MAX_DELAY_MS (10 * 60 * 1000)
+
+// If neither ack nor failure came back, e.g. if the request
+// couldn't even start because of another running sync:
+#define SYNC_ACK_TIMEOUT_MS (60 * 1000)
+
+// The operations left from the previous session are re-sent after:
+#define SYNC_RESUME_DELAY_MS (15 * 1000)
+
+SyncQueue::~SyncQueue()
+{
+    this->stopTimer();
+}
+
+String SyncQueue::enqueue(const Identifier &type, const String &target)
+{
+    const auto inFlightTimeout = Time::getCurrentTime() +
+        RelativeTime::milliseconds(SYNC_ACK_TIMEOUT_MS);
+
+    const auto existingIndex = this->indexOf(type, target);
+    if (existingIndex >= 0)
+    {
+        auto &existing = this->operations.getReference(existingIndex);
+        existing.nextAttemptTime = inFlightTimeout;
+        this->scheduleNextRetry();
+        return existing.id;
+    }
+
+    Operation operation;
+    operation.id = Uuid().toString();
+    operation.type = type;
+    operation.target = target;
+    operation.nextAttemptTime = inFlightTimeout;
+    this->operations.add(operation);
+
+    this->scheduleNextRetry();
+    return operation.id;
+}
+
+void SyncQueue::cancel(const Identifier &type, const String &target)
+{
+    const auto index = this->indexOf(type, target);
+    if (index >= 0)
+    {
+        this->operations.remove(index);
+        this->scheduleNextRetry();
+    }
+}
+
+void SyncQueue::acknowledge(const String &operationId)
+{
+    const auto index = this->indexOf(operationId);
+    if (index >= 0)
+    {
+        this->operations.remove(index);
+        this->scheduleNextRetry();
+    }
+}
+
+bool SyncQueue::reportFailure(const String &operationId, bool canRetry)
+{
+    const auto index = this->indexOf(operationId);
+    if (index < 0)
+    {
+        return true;
+    }
+
+    auto &operation = this->operations.getReference(index);
+    const bool isFirstAttempt = operation.numAttempts == 0;
+
+    if (!canRetry)
+    {
+        DBG("Sync operation rejected, dropping: " + operation.type.toString() + " " + operation.target);
+        this->operations.remove(index);
+        this->scheduleNextRetry();
+        return isFirstAttempt;
+    }
+
+    const auto delay = jmin(SYNC_RETRY_MAX_DELAY_MS,
+        SYNC_RETRY_MIN_DELAY_MS << jmin(operation.numAttempts, 16));
+
+    operation.numAttempts++;
+    operation.nextAttemptTime = Time::getCurrentTime() + RelativeTime::milliseconds(delay);
+    DBG("Sync operation failed, retrying in " << delay << " ms: " << operation.type.toString());
+
+    this->scheduleNextRetry();
+    return isFirstAttempt;
+}
+
+bool SyncQueue::reportFailure(const Identifier &type, const String &target, bool canRetry)
+{
+    const auto index = this->indexOf(type, target);
+    if (index < 0)
+    {
+        return true;
+    }
+
+    return this->reportFailure(this->operations.getReference(index).id, canRetry);
+}
+
+bool SyncQueue::isEmpty() const noexcept
+{
+    return this->operations.isEmpty();
+}
+
+void SyncQueue::timerCallback()
+{
+    const auto now = Time::getCurrentTime();
+
+    Array<Operation> dueOperations;
+    for (auto &operation : this->operations)
+    {
+        if (operation.nextAttemptTime <= now)
+        {
+            // not due again until it either fails or times out
+            operation.nextAttemptTime = now + RelativeTime::milliseconds(SYNC_ACK_TIMEOUT_MS);
+            dueOperations.add(operation);
+        }
+    }
+
+    this->scheduleNextRetry();
+
+    // the callbacks are likely to modify the queue
+    for (const auto &operation : dueOperations)
+    {
+        if (this->onRetry != nullptr)
+        {
+            this->onRetry(operation);
+        }
+    }
+}
+
+void SyncQueue::scheduleNextRetry()
+{
+    if (this->operations.isEmpty())
+    {
+        this->stopTimer();
+        return;
+    }
+
+    auto nextAttemptTime = this->operations.getReference(0).nextAttemptTime;
+    for (const auto &operation : this->operations)
+    {
+        nextAttemptTime = jmin(nextAttemptTime, operation.nextAttemptTime);
+    }
+
+    const auto delay = (nextAttemptTime - Time::getCurrentTime()).inMilliseconds();
+    this->startTimer(int(jlimit(int64(100), int64(SYNC_RETRY_MAX_DELAY_MS), delay)));
+}
+
+int SyncQueue::indexOf(const String &operationId) const
+{
+    for (int i = 0; i < this->operations.size(); ++i)
+    {
+        if (this->operations.getReference(i).id == operationId)
+        {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+int SyncQueue::indexOf(const Identifier &type, const String &target) const
+{
+    for (int i = 0; i < this->operations.size(); ++i)
+    {
+        const auto &operation = this->operations.getReference(i);
+        if (operation.type == type && operation.target == target)
+        {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+//===----------------------------------------------------------------------===//
+// Serializable
+//===----------------------------------------------------------------------===//
+
+SerializedData SyncQueue::serialize() const
+{
+    using namespace Serialization;
+    SerializedData tree(Sync::queue);
+
+    for (const auto &operation : this->operations)
+    {
+        SerializedData node(Sync::operation);
+        node.setProperty(Sync::operationId, operation.id);
+        node.setProperty(Sync::operationType, operation.type.toString());
+        node.setProperty(Sync::operationTarget, operation.target);
+        node.setProperty(Sync::numAttempts, operation.numAttempts);
+        tree.appendChild(node);
+    }
+
+    return tree;
+}
+
+void SyncQueue::deserialize(const SerializedData &data)
+{
+    this->reset();
+
+    using namespace Serialization;
+    const auto root = data.hasType(Sync::queue) ?
+        data : data.getChildWithName(Sync::queue);
+
+    if (!root.isValid()) { return; }
+
+    const auto resumeTime = Time::getCurrentTime() +
+        RelativeTime::milliseconds(SYNC_RESUME_DELAY_MS);
+
+    forEachChildWithType(root, e, Sync::operation)
+    {
+        const String id = e.getProperty(Sync::operationId);
+        const String type = e.getProperty(Sync::operationType);
+        if (id.isEmpty() || type.isEmpty())
+        {
+            continue;
+        }
+
+        Operation operation;
+        operation.id = id;
+        operation.type = Identifier(type);
+        operation.target = e.getProperty(Sync::operationTarget);
+        operation.numAttempts = e.getProperty(Sync::numAttempts);
+        operation.nextAttemptTime = resumeTime;
+        this->operations.add(operation);
+    }
+
+    this->scheduleNextRetry();
+}
+
+void SyncQueue::reset()
+{
+    this->operations.clearQuick();
+    this->stopTimer();
+}
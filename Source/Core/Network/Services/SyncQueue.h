@@ -0,0 +1,81 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "Serializable.h"
+
+// The outgoing operations not yet acknowledged by the server: they are
+// persisted along with their owner, so that the failed uploads survive
+// the restart, and re-sent with a growing delay until they succeed,
+// or until the server rejects them; the operations only refer to their
+// targets, which are looked up again on retry, so that the latest state
+// is sent, and sending the same operation twice is harmless
+class SyncQueue final : public Serializable, private Timer
+{
+public:
+
+    SyncQueue() = default;
+    ~SyncQueue() override;
+
+    struct Operation final
+    {
+        String id;
+        Identifier type;
+        String target;
+        int numAttempts = 0;
+        Time nextAttemptTime;
+    };
+
+    // Re-queueing the same type and target keeps the operation id,
+    // the returned id is to be passed back on ack or failure
+    String enqueue(const Identifier &type, const String &target);
+    void cancel(const Identifier &type, const String &target);
+
+    void acknowledge(const String &operationId);
+
+    // Returns true if this was a first attempt, i.e. the one
+    // made by user, and not the one from the background retries
+    bool reportFailure(const String &operationId, bool canRetry);
+    bool reportFailure(const Identifier &type, const String &target, bool canRetry);
+
+    bool isEmpty() const noexcept;
+
+    // Called on the message thread for each operation to re-send,
+    // supposed to end up in either acknowledge() or reportFailure()
+    Function<void(const Operation &operation)> onRetry;
+
+    //===------------------------------------------------------------------===//
+    // Serializable
+    //===------------------------------------------------------------------===//
+
+    SerializedData serialize() const override;
+    void deserialize(const SerializedData &data) override;
+    void reset() override;
+
+private:
+
+    void timerCallback() override;
+    void scheduleNextRetry();
+
+    int indexOf(const String &operationId) const;
+    int indexOf(const Identifier &type, const String &target) const;
+
+    Array<Operation> operations;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SyncQueue)
+};
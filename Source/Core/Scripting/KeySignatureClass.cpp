@@ -20,9 +20,10 @@
 #include "ScaleClass.h"
 #include "SerializationKeys.h"
 
+using namespace Scripting;
+
 KeySignatureClass::KeySignatureClass(const KeySignatureEvent &event)
 {
-    using namespace Scripting;
     using namespace Serialization::Scripts;
 
     ScaleClass::Ptr scale(new ScaleClass(event.getScale()));
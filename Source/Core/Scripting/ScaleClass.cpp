@@ -19,9 +19,10 @@
 #include "ScaleClass.h"
 #include "SerializationKeys.h"
 
+using namespace Scripting;
+
 ScaleClass::ScaleClass(const Scale::Ptr scale) : scale(scale)
 {
-    using namespace Scripting;
     using namespace Serialization::Scripts;
 
     this->setProperty(Api::Scale::name, scale->getLocalizedName());
@@ -67,7 +68,7 @@ var Scripting::ScaleClass::getChromaticKey(Args &a)
         if (a.numArguments == 1)
         {
             const int key = a.arguments[0];
-            return var(self->scale->getChromaticKey(key));
+            return var(self->scale->getChromaticKey(key, 0, false));
         }
     }
 
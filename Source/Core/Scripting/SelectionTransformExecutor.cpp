@@ -18,47 +18,144 @@
 #include "Common.h"
 #include "SelectionTransformExecutor.h"
 #include "NoteComponent.h"
+#include "SerializationKeys.h"
 
-#include "NoteClass.h"
 #include "ScaleClass.h"
 #include "KeySignatureClass.h"
 #include "TimeSignatureClass.h"
 
 using namespace Scripting;
 
+#define SCRIPT_MAX_EXECUTION_TIME_SECONDS 5
+
 SelectionTransformExecutor::SelectionTransformExecutor()
 {
-    // TODO init engine
+    // the scripts are user-written, so the endless loops are expected
+    this->engine.maximumExecutionTime = RelativeTime::seconds(SCRIPT_MAX_EXECUTION_TIME_SECONDS);
 }
 
-Array<Note> Scripting::SelectionTransformExecutor::execute(Lasso &selection,
-    TimeSignatureEvent &time, KeySignatureEvent &key)
+bool SelectionTransformExecutor::compileIfNeeded(const Script &script)
 {
-    Array<var> selectionWrapper;
-    for (int i = 0; i <= selection.getNumSelected(); ++i)
+    if (this->isCompiled && this->compiledContent == script.getContent())
+    {
+        return true;
+    }
+
+    this->isCompiled = false;
+    this->compiledContent = script.getContent();
+
+    const auto result = this->engine.execute(this->compiledContent);
+    if (result.failed())
     {
-        const auto *nc = selection.getItemAs<NoteComponent>(i);
-        NoteClass::Ptr noteWrapper(new NoteClass(nc->getNote()));
-        selectionWrapper.add(var(noteWrapper.get()));
+        DBG(result.getErrorMessage());
+        return false;
     }
 
+    this->isCompiled = true;
+    return true;
+}
+
+// the script's results are numbers of any kind, or not numbers at all
+static float getFiniteOr(const var &value, float fallback) noexcept
+{
+    const auto number = float(value);
+    return std::isfinite(number) ? number : fallback;
+}
+
+bool SelectionTransformExecutor::execute(const Script &script, const Lasso &selection,
+    TimeSignatureEvent &time, KeySignatureEvent &key,
+    Array<Note> &groupBefore, Array<Note> &groupAfter)
+{
+    using namespace Serialization::Scripts;
+
+    jassert(script.getType() == Types::transformSelection);
+
+    const int numSelected = selection.getNumSelected();
+    if (numSelected == 0 || !this->compileIfNeeded(script))
+    {
+        return false;
+    }
+
+    Array<var> keys, positions, lengths, volumes;
+    keys.ensureStorageAllocated(numSelected);
+    positions.ensureStorageAllocated(numSelected);
+    lengths.ensureStorageAllocated(numSelected);
+    volumes.ensureStorageAllocated(numSelected);
+
+    for (int i = 0; i < numSelected; ++i)
+    {
+        const auto &note = selection.getItemAs<NoteComponent>(i)->getNote();
+        keys.add(note.getKey());
+        positions.add(note.getBeat());
+        lengths.add(note.getLength());
+        volumes.add(note.getVelocity());
+    }
+
+    DynamicObject::Ptr notesWrapper(new DynamicObject());
+    notesWrapper->setProperty(Api::Note::key, keys);
+    notesWrapper->setProperty(Api::Note::position, positions);
+    notesWrapper->setProperty(Api::Note::length, lengths);
+    notesWrapper->setProperty(Api::Note::volume, volumes);
+
     TimeSignatureClass::Ptr timeSignatureWrapper(new TimeSignatureClass(time));
     KeySignatureClass::Ptr keySignatureWrapper(new KeySignatureClass(key));
 
-    var args;
-    args.append(var(selectionWrapper));
-    args.append(var(timeSignatureWrapper.get()));
-    args.append(var(keySignatureWrapper.get()));
+    var args[] = {
+        var(notesWrapper.get()),
+        var(timeSignatureWrapper.get()),
+        var(keySignatureWrapper.get())
+    };
 
     // TODO any root object API in future?
     var self(var::undefined());
 
-    Result result = Result::fail("Unknown");
+    Result result = Result::ok();
+    this->engine.callFunction("transform",
+        var::NativeFunctionArgs(self, args, numElementsInArray(args)), &result);
+
+    if (result.failed())
+    {
+        DBG(result.getErrorMessage());
+        return false;
+    }
+
+    // the script may either change the columns in place, or replace them
+    const auto *newKeys = notesWrapper->getProperty(Api::Note::key).getArray();
+    const auto *newPositions = notesWrapper->getProperty(Api::Note::position).getArray();
+    const auto *newLengths = notesWrapper->getProperty(Api::Note::length).getArray();
+    const auto *newVolumes = notesWrapper->getProperty(Api::Note::volume).getArray();
 
-    const auto call = this->engine.callFunction("transform",
-        var::NativeFunctionArgs(self, &args, args.size()), &result);
+    if (newKeys == nullptr || newKeys->size() != numSelected ||
+        newPositions == nullptr || newPositions->size() != numSelected ||
+        newLengths == nullptr || newLengths->size() != numSelected ||
+        newVolumes == nullptr || newVolumes->size() != numSelected)
+    {
+        jassertfalse; // the script is not supposed to add or remove notes
+        return false;
+    }
+
+    groupBefore.ensureStorageAllocated(numSelected);
+    groupAfter.ensureStorageAllocated(numSelected);
+
+    for (int i = 0; i < numSelected; ++i)
+    {
+        const auto &note = selection.getItemAs<NoteComponent>(i)->getNote();
+        const auto newKey = Note::Key(getFiniteOr(newKeys->getUnchecked(i), float(note.getKey())));
+        const auto newBeat = getFiniteOr(newPositions->getUnchecked(i), note.getBeat());
+        const auto newLength = getFiniteOr(newLengths->getUnchecked(i), note.getLength());
+        const auto newVelocity = getFiniteOr(newVolumes->getUnchecked(i), note.getVelocity());
+
+        // compared after rounding and clamping, so that the no-op scripts change nothing
+        const auto newNote = note.withKeyBeat(newKey, newBeat)
+            .withLength(newLength).withVelocity(newVelocity);
+
+        if (newNote.getKey() != note.getKey() || newNote.getBeat() != note.getBeat() ||
+            newNote.getLength() != note.getLength() || newNote.getVelocity() != note.getVelocity())
+        {
+            groupBefore.add(note);
+            groupAfter.add(newNote);
+        }
+    }
 
-    Array<Note> updates;
-    return updates;
-    // TODO apply transforms?
+    return !groupAfter.isEmpty();
 }
@@ -19,6 +19,7 @@
 
 #include "Note.h"
 #include "Lasso.h"
+#include "Script.h"
 #include "KeySignatureEvent.h"
 #include "TimeSignatureEvent.h"
 
@@ -31,11 +32,23 @@ namespace Scripting
         SelectionTransformExecutor();
         using Args = const var::NativeFunctionArgs &;
 
-        Array<Note> execute(Lasso &selection, TimeSignatureEvent &time, KeySignatureEvent &key);
+        // The script's transform function gets the whole selection as columns,
+        // i.e. one array per note parameter, instead of an object per note,
+        // and is called once for all of them; the changed notes are returned
+        // as groups, to be previewed, and then applied at once, see
+        // SequencerOperations::applyTransform; the script is only compiled
+        // once, as long as the executor is reused with the same script
+        bool execute(const Script &script, const Lasso &selection,
+            TimeSignatureEvent &time, KeySignatureEvent &key,
+            Array<Note> &groupBefore, Array<Note> &groupAfter);
 
     private:
 
+        bool compileIfNeeded(const Script &script);
+
         JavascriptEngine engine;
+        String compiledContent;
+        bool isCompiled = false;
 
         JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SelectionTransformExecutor)
     };
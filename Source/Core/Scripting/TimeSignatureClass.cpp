@@ -19,9 +19,10 @@
 #include "TimeSignatureClass.h"
 #include "SerializationKeys.h"
 
+using namespace Scripting;
+
 TimeSignatureClass::TimeSignatureClass(const TimeSignatureEvent &event)
 {
-    using namespace Scripting;
     using namespace Serialization::Scripts;
 
     this->setProperty(Api::TimeSignature::position, event.getBeat());
@@ -20,6 +20,13 @@
 
 #include "DocumentOwner.h"
 #include "Document.h"
+#include "MessageThreadWatchdog.h"
+
+// the message thread should not spend more than this fraction
+// of the time between saves on taking the snapshots
+#define AUTOSAVE_TARGET_DUTY_CYCLE (0.005)
+#define AUTOSAVE_MAX_DELAY_MS (10 * 60 * 1000)
+#define AUTOSAVE_RETRY_DELAY_MS (3000)
 
 Autosaver::Autosaver(DocumentOwner &targetDocumentOwner, int waitDelayMs) :
     documentOwner(targetDocumentOwner),
@@ -38,11 +45,40 @@ void Autosaver::changeListenerCallback(ChangeBroadcaster *source)
     // add some randomness to the delay, so that 
     // several open projects are not saved at once:
     static Random r;
-    this->startTimer(this->delay + r.nextInt(1000));
+    this->startTimer(this->getAdaptiveDelay() + r.nextInt(1000));
 }
 
 void Autosaver::timerCallback()
 {
+    WATCHDOG_SCOPE("Autosaver::timerCallback");
+
+    // a hitch in the middle of a drag or playback is way more
+    // noticeable than a save which comes a few seconds later
+    if (Desktop::getInstance().getNumDraggingMouseSources() > 0 ||
+        this->documentOwner.shouldDeferAutosave())
+    {
+        this->startTimer(AUTOSAVE_RETRY_DELAY_MS);
+        return;
+    }
+
     this->stopTimer();
-    this->documentOwner.getDocument()->save();
+
+    auto *document = this->documentOwner.getDocument();
+    if (!document->hasUnsavedChanges())
+    {
+        return;
+    }
+
+    const auto startTimeMs = Time::getMillisecondCounterHiRes();
+    document->saveInBackground();
+    const auto saveTimeMs = Time::getMillisecondCounterHiRes() - startTimeMs;
+
+    this->averageSaveTimeMs = (this->averageSaveTimeMs == 0.0) ? saveTimeMs :
+        (this->averageSaveTimeMs * 0.75 + saveTimeMs * 0.25);
+}
+
+int Autosaver::getAdaptiveDelay() const noexcept
+{
+    const auto minDelayMs = this->averageSaveTimeMs / AUTOSAVE_TARGET_DUTY_CYCLE;
+    return jlimit(this->delay, jmax(this->delay, AUTOSAVE_MAX_DELAY_MS), int(minDelayMs));
 }
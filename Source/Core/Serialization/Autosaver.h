@@ -35,10 +35,16 @@ private:
 
     void timerCallback() override;
 
+    int getAdaptiveDelay() const noexcept;
+
     DocumentOwner &documentOwner;
 
     const int delay;
 
+    // the smoothed time the message thread spends on taking a snapshot,
+    // which grows with the project size, unlike the delay above
+    double averageSaveTimeMs = 0.0;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Autosaver)
 
 };
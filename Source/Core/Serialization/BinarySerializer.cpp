@@ -17,10 +17,297 @@
 
 #include "Common.h"
 #include "BinarySerializer.h"
+#include "SerializationKeys.h"
 
 static const char *kHelioHeaderV2String = "Helio2::";
 static const uint64 kHelioHeaderV2 = ByteOrder::littleEndianInt64(kHelioHeaderV2String);
 
+static const char *kHelioHeaderV3String = "Helio3::";
+static const uint64 kHelioHeaderV3 = ByteOrder::littleEndianInt64(kHelioHeaderV3String);
+
+//===----------------------------------------------------------------------===//
+// Chunked container
+//===----------------------------------------------------------------------===//
+
+// The V3 file is a container, which keeps the skeleton of the tree
+// (the project node, track groups, etc.) in the table of contents,
+// and all the leaf subtrees (tracks, timeline, vcs, undo stack)
+// as independent chunks that can be addressed by their offsets:
+//
+//     [header][toc offset][chunk][chunk]...[toc][new chunk][new toc]...
+//
+// Updating the file only appends the chunks that have changed,
+// followed by the new toc, and then rewrites the toc offset in place,
+// so that the file stays valid even if writing gets interrupted;
+// when the garbage takes more than a half of the file, it is
+// rewritten from scratch, see BinarySerializer::updateFile
+
+// The larger chunks, mostly the vcs history, are also compressed;
+// the compressed chunk starts with a marker, which can't be the first
+// byte of a serialized node, followed by its uncompressed size;
+// zlib at the fastest level is used, since that's what JUCE ships,
+// and it still packs the history several times
+
+#define CHUNKED_HEADER_SIZE (sizeof(int64) * 2)
+#define CHUNKED_COMPACTION_MIN_SIZE (64 * 1024)
+#define CHUNK_COMPRESSION_MIN_SIZE (16 * 1024)
+#define CHUNK_COMPRESSION_LEVEL 1
+
+static const uint8 kInlineNode = 0;
+static const uint8 kChunkReference = 1;
+static const uint8 kCompressedChunk = 1;
+
+struct Chunk final
+{
+    int64 offset;
+    int64 size;
+    uint64 hash;
+};
+
+struct EncodedTree final
+{
+    OwnedArray<MemoryBlock> chunks;
+    MemoryOutputStream skeleton;
+};
+
+// the hash is taken from the uncompressed data, so that the chunks
+// can be checked for changes before (and instead of) compressing them
+static uint64 getChunkHash(const MemoryBlock &data) noexcept
+{
+    // FNV-1a, which is good enough to tell if a chunk is the same
+    uint64 hash = 14695981039346656037ull ^ uint64(data.getSize());
+    const auto *bytes = static_cast<const uint8 *>(data.getData());
+    for (size_t i = 0; i < data.getSize(); ++i)
+    {
+        hash = (hash ^ bytes[i]) * 1099511628211ull;
+    }
+
+    return hash;
+}
+
+// the nodes which contain other tree nodes, like the project
+// or a track group, are the skeleton, the rest are chunks
+static bool isSkeletonNode(const SerializedData &node)
+{
+    for (const auto &child : node)
+    {
+        if (child.hasType(Serialization::Core::treeNode))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static MemoryBlock packChunk(const MemoryBlock &data)
+{
+    if (data.getSize() < CHUNK_COMPRESSION_MIN_SIZE)
+    {
+        return data;
+    }
+
+    MemoryOutputStream packed(data.getSize() / 2);
+    packed.writeByte(char(kCompressedChunk));
+    packed.writeCompressedInt(int(data.getSize()));
+
+    {
+        GZIPCompressorOutputStream compressor(packed, CHUNK_COMPRESSION_LEVEL);
+        compressor.write(data.getData(), data.getSize());
+        compressor.flush();
+    }
+
+    if (packed.getDataSize() >= data.getSize())
+    {
+        return data;
+    }
+
+    return packed.getMemoryBlock();
+}
+
+static SerializedData readChunk(const void *fileData, const Chunk &chunk)
+{
+    const auto *chunkData = addBytesToPointer(fileData, chunk.offset);
+    if (*static_cast<const uint8 *>(chunkData) != kCompressedChunk)
+    {
+        return SerializedData::readFromData(chunkData, size_t(chunk.size));
+    }
+
+    MemoryInputStream packed(chunkData, size_t(chunk.size), false);
+    packed.readByte();
+
+    const auto unpackedSize = packed.readCompressedInt();
+    if (unpackedSize <= 0)
+    {
+        return {};
+    }
+
+    MemoryBlock unpacked(size_t(unpackedSize));
+    GZIPDecompressorInputStream decompressor(packed);
+    if (decompressor.read(unpacked.getData(), unpackedSize) != unpackedSize)
+    {
+        jassertfalse;
+        return {};
+    }
+
+    return SerializedData::readFromData(unpacked.getData(), unpacked.getSize());
+}
+
+static void writeSkeletonNode(const SerializedData &node, EncodedTree &result)
+{
+    auto &out = result.skeleton;
+    out.writeString(node.getType().toString());
+    out.writeCompressedInt(node.getNumProperties());
+
+    for (int i = 0; i < node.getNumProperties(); ++i)
+    {
+        const auto name = node.getPropertyName(i);
+        out.writeString(name.toString());
+        node.getProperty(name).writeToStream(out);
+    }
+
+    out.writeCompressedInt(node.getNumChildren());
+
+    for (const auto &child : node)
+    {
+        if (isSkeletonNode(child))
+        {
+            out.writeByte(kInlineNode);
+            writeSkeletonNode(child, result);
+        }
+        else
+        {
+            out.writeByte(kChunkReference);
+            out.writeCompressedInt(result.chunks.size());
+
+            MemoryOutputStream chunk;
+            child.writeToStream(chunk);
+            result.chunks.add(new MemoryBlock(chunk.getData(), chunk.getDataSize()));
+        }
+    }
+}
+
+static void writeTableOfContents(OutputStream &out,
+    const Array<Chunk> &chunks, const EncodedTree &tree)
+{
+    out.writeCompressedInt(chunks.size());
+    for (const auto &chunk : chunks)
+    {
+        out.writeInt64(chunk.offset);
+        out.writeInt64(chunk.size);
+        out.writeInt64(static_cast<int64>(chunk.hash));
+    }
+
+    out.write(tree.skeleton.getData(), tree.skeleton.getDataSize());
+}
+
+static bool readChunksTable(InputStream &in, int64 fileSize, Array<Chunk> &chunks)
+{
+    const auto numChunks = in.readCompressedInt();
+    if (numChunks < 0)
+    {
+        return false;
+    }
+
+    chunks.ensureStorageAllocated(numChunks);
+    for (int i = 0; i < numChunks; ++i)
+    {
+        Chunk chunk;
+        chunk.offset = in.readInt64();
+        chunk.size = in.readInt64();
+        chunk.hash = static_cast<uint64>(in.readInt64());
+
+        if (chunk.offset < int64(CHUNKED_HEADER_SIZE) ||
+            chunk.size <= 0 || chunk.offset + chunk.size > fileSize)
+        {
+            return false;
+        }
+
+        chunks.add(chunk);
+    }
+
+    return !in.isExhausted();
+}
+
+static SerializedData readSkeletonNode(InputStream &in,
+    const void *fileData, const Array<Chunk> &chunks)
+{
+    const Identifier type(in.readString());
+    if (!type.isValid())
+    {
+        return {};
+    }
+
+    SerializedData node(type);
+
+    const auto numProps = in.readCompressedInt();
+    for (int i = 0; i < numProps; ++i)
+    {
+        const Identifier name(in.readString());
+        if (!name.isValid())
+        {
+            jassertfalse;
+            return {};
+        }
+
+        node.setProperty(name, var::readFromStream(in));
+    }
+
+    const auto numChildren = in.readCompressedInt();
+    for (int i = 0; i < numChildren; ++i)
+    {
+        SerializedData child;
+
+        if (in.readByte() == kInlineNode)
+        {
+            child = readSkeletonNode(in, fileData, chunks);
+        }
+        else
+        {
+            const auto index = in.readCompressedInt();
+            if (isPositiveAndBelow(index, chunks.size()))
+            {
+                child = readChunk(fileData, chunks.getReference(index));
+            }
+        }
+
+        if (!child.isValid())
+        {
+            return node;
+        }
+
+        node.appendChild(child);
+    }
+
+    return node;
+}
+
+static SerializedData readChunkedTree(const void *fileData, size_t numBytes)
+{
+    MemoryInputStream in(fileData, numBytes, false);
+    in.setPosition(sizeof(int64));
+
+    const auto fileSize = int64(numBytes);
+    const auto tocOffset = in.readInt64();
+    if (tocOffset < int64(CHUNKED_HEADER_SIZE) || tocOffset >= fileSize)
+    {
+        return {};
+    }
+
+    Array<Chunk> chunks;
+    in.setPosition(tocOffset);
+    if (!readChunksTable(in, fileSize, chunks))
+    {
+        return {};
+    }
+
+    return readSkeletonNode(in, fileData, chunks);
+}
+
+//===----------------------------------------------------------------------===//
+// Serializer
+//===----------------------------------------------------------------------===//
+
 Result BinarySerializer::saveToFile(File file, const SerializedData &tree) const
 {
     FileOutputStream fileStream(file);
@@ -28,14 +315,154 @@ Result BinarySerializer::saveToFile(File file, const SerializedData &tree) const
     {
         fileStream.setPosition(0);
         fileStream.truncate();
-        fileStream.writeInt64(kHelioHeaderV2);
-        tree.writeToStream(fileStream);
-        return Result::ok();
+        fileStream.writeInt64(kHelioHeaderV3);
+        fileStream.writeInt64(0); // toc offset placeholder
+
+        EncodedTree encoded;
+        writeSkeletonNode(tree, encoded);
+
+        Array<Chunk> chunks;
+        for (const auto *data : encoded.chunks)
+        {
+            const auto packed = packChunk(*data);
+            chunks.add({ fileStream.getPosition(), int64(packed.getSize()), getChunkHash(*data) });
+            fileStream.write(packed.getData(), packed.getSize());
+        }
+
+        const auto tocOffset = fileStream.getPosition();
+        writeTableOfContents(fileStream, chunks, encoded);
+
+        fileStream.flush();
+        fileStream.setPosition(sizeof(int64));
+        fileStream.writeInt64(tocOffset);
+        fileStream.flush();
+
+        if (fileStream.getStatus().wasOk())
+        {
+            return Result::ok();
+        }
     }
 
     return Result::fail("Failed to save");
 }
 
+Result BinarySerializer::updateFile(File file, const SerializedData &tree) const
+{
+    Array<Chunk> existingChunks;
+    int64 fileSize = 0;
+
+    {
+        FileInputStream in(file);
+        if (!in.openedOk() ||
+            static_cast<uint64>(in.readInt64()) != kHelioHeaderV3)
+        {
+            return Result::fail("Not a chunked file");
+        }
+
+        fileSize = in.getTotalLength();
+        const auto tocOffset = in.readInt64();
+        if (tocOffset < int64(CHUNKED_HEADER_SIZE) || tocOffset >= fileSize ||
+            !in.setPosition(tocOffset) || !readChunksTable(in, fileSize, existingChunks))
+        {
+            return Result::fail("Corrupted table of contents");
+        }
+    }
+
+    EncodedTree encoded;
+    writeSkeletonNode(tree, encoded);
+
+    // figure out which chunks can be kept as they are
+    HashMap<int64, int> existingChunksByHash;
+    for (int i = 0; i < existingChunks.size(); ++i)
+    {
+        existingChunksByHash.set(static_cast<int64>(existingChunks.getReference(i).hash), i);
+    }
+
+    Array<Chunk> chunks;
+    OwnedArray<MemoryBlock> newChunks; // packed, or nullptr if reused
+    int64 liveSize = int64(CHUNKED_HEADER_SIZE) + int64(encoded.skeleton.getDataSize());
+    int64 appendedSize = int64(encoded.skeleton.getDataSize());
+
+    for (const auto *data : encoded.chunks)
+    {
+        const auto hash = getChunkHash(*data);
+        const auto key = static_cast<int64>(hash);
+
+        if (existingChunksByHash.contains(key))
+        {
+            chunks.add(existingChunks[existingChunksByHash[key]]);
+            newChunks.add(nullptr);
+        }
+        else
+        {
+            auto *packed = newChunks.add(new MemoryBlock(packChunk(*data)));
+            chunks.add({ 0, int64(packed->getSize()), hash });
+            appendedSize += int64(packed->getSize());
+        }
+
+        liveSize += chunks.getLast().size;
+    }
+
+    const auto expectedSize = fileSize + appendedSize;
+    if (expectedSize > CHUNKED_COMPACTION_MIN_SIZE && expectedSize > liveSize * 2)
+    {
+        return Result::fail("Needs compaction");
+    }
+
+    // FileOutputStream opens existing files at the end
+    FileOutputStream fileStream(file);
+    if (!fileStream.openedOk() || fileStream.getPosition() != fileSize)
+    {
+        return Result::fail("Failed to open the file");
+    }
+
+    for (int i = 0; i < newChunks.size(); ++i)
+    {
+        if (const auto *packed = newChunks.getUnchecked(i))
+        {
+            chunks.getReference(i).offset = fileStream.getPosition();
+            fileStream.write(packed->getData(), packed->getSize());
+        }
+    }
+
+    const auto tocOffset = fileStream.getPosition();
+    writeTableOfContents(fileStream, chunks, encoded);
+    fileStream.flush();
+
+    if (fileStream.getStatus().failed())
+    {
+        return Result::fail("Failed to save");
+    }
+
+    // only now the new chunks become visible
+    fileStream.setPosition(sizeof(int64));
+    fileStream.writeInt64(tocOffset);
+    fileStream.flush();
+
+    return fileStream.getStatus();
+}
+
+static SerializedData readTreeFromData(const void *data, size_t numBytes)
+{
+    if (numBytes < sizeof(int64))
+    {
+        return {};
+    }
+
+    MemoryInputStream inputStream(data, numBytes, false);
+    const auto magicNumber = static_cast<uint64>(inputStream.readInt64());
+    if (magicNumber == kHelioHeaderV3)
+    {
+        return readChunkedTree(data, numBytes);
+    }
+    else if (magicNumber == kHelioHeaderV2)
+    {
+        return SerializedData::readFromStream(inputStream);
+    }
+
+    return {};
+}
+
 SerializedData BinarySerializer::loadFromFile(const File &file) const
 {
     // here's the thing: reading from FileInputStream is slow asfuck (at least, on Windows);
@@ -43,17 +470,20 @@ SerializedData BinarySerializer::loadFromFile(const File &file) const
     // ValueTree::readFromStream still calls getTotalLength() quite often, which
     // ends up calling File::getSize(), which, in turn, consumes a lot time.
 
-    // so instead we'll just read the whole file into memory and deserialize from it;
-    // somewhat ugly, but works, and saved files should never be really large anyway.
+    // so instead we'll map the whole file into memory and deserialize from it,
+    // the chunks are parsed right from the mapped pages without copying the file,
+    // and the pages are only loaded as the parser touches them:
+    const MemoryMappedFile mappedFile(file, MemoryMappedFile::readOnly);
+    if (mappedFile.getData() != nullptr)
+    {
+        return readTreeFromData(mappedFile.getData(), mappedFile.getSize());
+    }
+
+    // mapping might fail on some file systems, so fall back to reading it all
     MemoryBlock mb;
     if (file.loadFileAsData(mb))
     {
-        MemoryInputStream inputStream(mb, false);
-        const auto magicNumber = static_cast<uint64>(inputStream.readInt64());
-        if (magicNumber == kHelioHeaderV2)
-        {
-            return SerializedData::readFromStream(inputStream);
-        }
+        return readTreeFromData(mb.getData(), mb.getSize());
     }
 
     return {};
@@ -86,5 +516,6 @@ bool BinarySerializer::supportsFileWithExtension(const String &extension) const
 
 bool BinarySerializer::supportsFileWithHeader(const String &header) const
 {
-    return header.startsWith(kHelioHeaderV2String);
+    return header.startsWith(kHelioHeaderV3String) ||
+        header.startsWith(kHelioHeaderV2String);
 }
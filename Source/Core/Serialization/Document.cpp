@@ -43,6 +43,7 @@ Document::Document(DocumentOwner &documentOwner,
 
 Document::Document(DocumentOwner &documentOwner, const File &existingFile) :
     owner(documentOwner),
+    hasChanges(false),
     extension(existingFile.getFileExtension().replace(",", ""))
 {
     this->workingFile = existingFile;
@@ -96,14 +97,64 @@ void Document::renameFile(const String &newName)
 // Save
 //===----------------------------------------------------------------------===//
 
+static bool hasEmptyFileName(const File &file)
+{
+    const String fullPath = file.getFullPathName();
+    const auto firstCharAfterLastSlash = fullPath.lastIndexOfChar(File::getSeparatorChar()) + 1;
+    const auto lastDot = fullPath.lastIndexOfChar('.');
+    return fullPath.isEmpty() || (lastDot == firstCharAfterLastSlash);
+}
+
 void Document::save()
 {
     if (this->hasChanges && this->workingFile.getFullPathName().isNotEmpty())
     {
+        DocumentHelpers::waitForBackgroundSaves();
         this->internalSave(this->workingFile);
     }
 }
 
+// only the snapshot is taken here, and the changes made while it's being
+// written will be saved next time, unless the background save fails
+void Document::saveInBackground()
+{
+    if (!this->hasChanges || hasEmptyFileName(this->workingFile))
+    {
+        return;
+    }
+
+    const auto file = this->workingFile;
+    this->hasChanges = false;
+
+    WeakReference<Document> weakThis(this);
+    const bool isSaving = this->owner.onDocumentSaveInBackground(file,
+        [weakThis, file](bool savedOk)
+        {
+            if (weakThis == nullptr)
+            {
+                return;
+            }
+
+            if (savedOk)
+            {
+                DBG("Document saved: " + file.getFullPathName());
+                auto target = file;
+                weakThis->owner.onDocumentDidSave(target);
+            }
+            else
+            {
+                DBG("Document save failed: " + file.getFullPathName());
+                weakThis->hasChanges = true;
+            }
+        });
+
+    if (!isSaving)
+    {
+        this->hasChanges = true;
+        this->internalSave(file);
+    }
+}
+
 void Document::saveAs()
 {
 #if HELIO_DESKTOP
@@ -195,18 +246,42 @@ void Document::import(const String &filePattern)
 #endif
 }
 
+// the size and the modification time are checked first, since that's
+// just a stat; the contents are only compared when the file was touched
+// but kept its size, which is rare, so it's fine to hash it right here
 bool Document::fileHasBeenModified() const
 {
-    return this->fileModificationTime != this->workingFile.getLastModificationTime()
-           && (this->fileSize != this->workingFile.getSize()
-               || this->calculateFileHashCode(this->workingFile) != this->fileHashCode);
+    if (this->fileModificationTime == this->workingFile.getLastModificationTime())
+    {
+        return false;
+    }
+
+    if (this->fileSize != this->workingFile.getSize())
+    {
+        return true;
+    }
+
+    return this->fileHashCode == 0 ||
+        DocumentHelpers::calculateFileHash(this->workingFile) != this->fileHashCode;
 }
 
 void Document::updateHash()
 {
     this->fileModificationTime = this->workingFile.getLastModificationTime();
     this->fileSize = this->workingFile.getSize();
-    this->fileHashCode = this->calculateFileHashCode(this->workingFile);
+    this->fileHashCode = 0;
+
+    // the hash is computed by the background writer, i.e. after
+    // all pending saves, which is exactly the state it should describe
+    WeakReference<Document> weakThis(this);
+    DocumentHelpers::calculateFileHashInBackground(this->workingFile,
+        [weakThis](int64 hash)
+    {
+        if (weakThis != nullptr)
+        {
+            weakThis->fileHashCode = hash;
+        }
+    });
 }
 
 bool Document::hasUnsavedChanges() const noexcept
@@ -218,41 +293,9 @@ bool Document::hasUnsavedChanges() const noexcept
 // Protected
 //===----------------------------------------------------------------------===//
 
-int64 Document::calculateStreamHashCode(InputStream &in) const
-{
-    int64 t = 0;
-
-    const int bufferSize = 4096;
-    HeapBlock <uint8> buffer;
-    buffer.malloc(bufferSize);
-
-    for (;;)
-    {
-        const int num = in.read(buffer, bufferSize);
-
-        if (num <= 0)
-        { break; }
-
-        for (int i = 0; i < num; ++i)
-        { t = t * 65599 + buffer[i]; }
-    }
-
-    return t;
-}
-
-int64 Document::calculateFileHashCode(const File &file) const
-{
-    UniquePointer<FileInputStream> stream(file.createInputStream());
-    return stream != nullptr ? calculateStreamHashCode(*stream) : 0;
-}
-
 bool Document::internalSave(File result)
 {
-    const String fullPath = result.getFullPathName();
-    const auto firstCharAfterLastSlash = fullPath.lastIndexOfChar(File::getSeparatorChar()) + 1;
-    const auto lastDot = fullPath.lastIndexOfChar('.');
-    const bool hasEmptyName = (lastDot == firstCharAfterLastSlash);
-    if (hasEmptyName)
+    if (hasEmptyFileName(result))
     {
         return false;
     }
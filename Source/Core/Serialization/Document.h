@@ -46,6 +46,7 @@ public:
     //===------------------------------------------------------------------===//
 
     void save();
+    void saveInBackground();
     void saveAs();
     void exportAs(const String &exportExtension,
         const String &defaultFilename = "");
@@ -67,9 +68,6 @@ protected:
     bool internalLoad(File result);
     bool fileHasBeenModified() const;
 
-    int64 calculateStreamHashCode(InputStream &in) const;
-    int64 calculateFileHashCode(const File &file) const;
-
 protected:
 
     DocumentOwner &owner;
@@ -84,4 +82,5 @@ protected:
 private:
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Document)
+    JUCE_DECLARE_WEAK_REFERENCEABLE(Document)
 };
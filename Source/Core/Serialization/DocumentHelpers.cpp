@@ -241,11 +241,168 @@ SerializedData DocumentHelpers::load(const String &string)
     return DocumentHelpers::load<XmlSerializer>(string);
 }
 
+//===----------------------------------------------------------------------===//
+// Hashing
+//===----------------------------------------------------------------------===//
+
+#define FILE_HASH_BUFFER_SIZE (64 * 1024)
+
+static const uint64 kHashPrime1 = 11400714785074694791ULL;
+static const uint64 kHashPrime2 = 14029467366897019727ULL;
+
+static inline uint64 rotateLeft(uint64 x, int r) noexcept
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+static int readFully(InputStream &in, void *buffer, int numBytes)
+{
+    int total = 0;
+    while (total < numBytes)
+    {
+        const auto num = in.read(addBytesToPointer(buffer, total), numBytes - total);
+        if (num <= 0)
+        {
+            break;
+        }
+
+        total += num;
+    }
+
+    return total;
+}
+
+// Word at a time in four independent lanes, the way xxHash does it,
+// so that the loop is limited by the memory bandwidth rather than by
+// the multiplication latency; it only needs to detect changes, so
+// it's not guaranteed to match any published hash function's output
+int64 DocumentHelpers::calculateFileHash(const File &file)
+{
+    FileInputStream in(file);
+    if (!in.openedOk())
+    {
+        return 0;
+    }
+
+    HeapBlock<uint64> buffer(FILE_HASH_BUFFER_SIZE / sizeof(uint64));
+    uint64 lanes[4] = { kHashPrime1 + kHashPrime2, kHashPrime2, 0, 0 - kHashPrime1 };
+    uint64 totalLength = 0;
+
+    for (;;)
+    {
+        const auto numBytes = readFully(in, buffer, FILE_HASH_BUFFER_SIZE);
+        if (numBytes <= 0)
+        {
+            break;
+        }
+
+        totalLength += uint64(numBytes);
+
+        // the tail is only possible at the end of file, pad it with zeros
+        const auto numWords = (numBytes + int(sizeof(uint64)) - 1) / int(sizeof(uint64));
+        zeromem(addBytesToPointer(buffer.get(), numBytes), size_t(numWords) * sizeof(uint64) - size_t(numBytes));
+
+        for (int i = 0; i < numWords; ++i)
+        {
+            auto &lane = lanes[i & 3];
+            lane = rotateLeft(lane + buffer[i] * kHashPrime2, 31) * kHashPrime1;
+        }
+
+        if (numBytes < FILE_HASH_BUFFER_SIZE)
+        {
+            break;
+        }
+    }
+
+    auto hash = rotateLeft(lanes[0], 1) + rotateLeft(lanes[1], 7) +
+        rotateLeft(lanes[2], 12) + rotateLeft(lanes[3], 18);
+
+    hash ^= totalLength;
+    hash = (hash ^ (hash >> 33)) * kHashPrime2;
+    hash = (hash ^ (hash >> 29)) * kHashPrime1;
+    hash ^= (hash >> 32);
+
+    // zero is reserved for "unknown"
+    return hash == 0 ? 1 : static_cast<int64>(hash);
+}
+
+bool DocumentHelpers::saveWith(const Serializer &serializer,
+    const File &file, const SerializedData &tree)
+{
+    if (file.existsAsFile() && serializer.updateFile(file, tree).wasOk())
+    {
+        return true;
+    }
+
+    TempDocument tempDoc(file);
+    if (serializer.saveToFile(tempDoc.getFile(), tree).wasOk())
+    {
+        return tempDoc.overwriteTargetFileWithTemporary();
+    }
+
+    return false;
+}
+
 static File createTempFileForSaving(const File &parentDirectory, String name, const String& suffix)
 {
     return parentDirectory.getNonexistentChildFile(name, suffix, false);
 }
 
+//===----------------------------------------------------------------------===//
+// Background saving
+//===----------------------------------------------------------------------===//
+
+static ThreadPool &getBackgroundWriter()
+{
+    static ThreadPool writer(1);
+    return writer;
+}
+
+void DocumentHelpers::writeInBackground(const File &file, const SerializedData &tree,
+    SnapshotWriter writer, Function<void(bool savedOk)> callback)
+{
+    // the snapshot might share some immutable nodes with the caches of the model,
+    // e.g. the undo stack's, so it's only referenced from the message thread,
+    // where the nodes' parent links are updated when the snapshot is released:
+    auto *snapshot = new SerializedData(tree);
+
+    getBackgroundWriter().addJob([file, snapshot, writer, callback]()
+    {
+        const bool savedOk = writer(file, *snapshot);
+
+        MessageManager::callAsync([snapshot, callback, savedOk]()
+        {
+            delete snapshot;
+
+            if (callback != nullptr)
+            {
+                callback(savedOk);
+            }
+        });
+    });
+}
+
+void DocumentHelpers::calculateFileHashInBackground(const File &file,
+    Function<void(int64 hash)> callback)
+{
+    getBackgroundWriter().addJob([file, callback]()
+    {
+        const auto hash = DocumentHelpers::calculateFileHash(file);
+        MessageManager::callAsync([callback, hash]()
+        {
+            callback(hash);
+        });
+    });
+}
+
+void DocumentHelpers::waitForBackgroundSaves()
+{
+    while (getBackgroundWriter().getNumJobs() > 0)
+    {
+        Thread::sleep(5);
+    }
+}
+
 DocumentHelpers::TempDocument::TempDocument(const File &target) :
     temporaryFile(createTempFileForSaving(target.getParentDirectory(),
         target.getFileNameWithoutExtension() + "_temp_" + String::toHexString(Random::getSystemRandom().nextInt()),
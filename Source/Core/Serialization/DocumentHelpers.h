@@ -17,6 +17,8 @@
 
 #pragma once
 
+class Serializer;
+
 class DocumentHelpers final
 {
 public:
@@ -49,29 +51,42 @@ public:
     static bool save(const File &file, const SerializedData &tree)
     {
         static T serializer;
-        TempDocument tempDoc(file);
-        if (serializer.saveToFile(tempDoc.getFile(), tree).wasOk())
-        {
-            return tempDoc.overwriteTargetFileWithTemporary();
-        }
-
-        return false;
+        return saveWith(serializer, file, tree);
     }
 
     template<typename T>
     static bool save(const File &file, const Serializable &serializable)
     {
         static T serializer;
-        TempDocument tempDoc(file);
-        const auto treeNode(serializable.serialize());
-        if (serializer.saveToFile(tempDoc.getFile(), treeNode).wasOk())
-        {
-            return tempDoc.overwriteTargetFileWithTemporary();
-        }
+        return saveWith(serializer, file, serializable.serialize());
+    }
 
-        return false;
+    // The tree is a snapshot which nobody changes, so encoding and writing it
+    // can be done on a worker thread; all background saves go through the same
+    // single thread, so that they never overtake each other; the snapshot is
+    // released and the callback is called back on the message thread
+    template<typename T>
+    static void saveInBackground(const File &file, const SerializedData &tree,
+        Function<void(bool savedOk)> callback)
+    {
+        writeInBackground(file, tree, [](const File &target, const SerializedData &snapshot)
+        {
+            T serializer;
+            return saveWith(serializer, target, snapshot);
+        }, callback);
     }
 
+    // A fast hash of the file's contents, to tell if it has changed;
+    // the background version runs after the pending saves,
+    // and calls back on the message thread
+    static int64 calculateFileHash(const File &file);
+    static void calculateFileHashInBackground(const File &file,
+        Function<void(int64 hash)> callback);
+
+    // the synchronous saves should wait for the pending ones,
+    // otherwise an older snapshot might overwrite the newer file
+    static void waitForBackgroundSaves();
+
     class TempDocument final
     {
     public:
@@ -92,4 +107,15 @@ public:
 
         JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TempDocument)
     };
+
+private:
+
+    // tries to update the existing file in place first, if the serializer
+    // supports that, otherwise writes a temporary file and swaps it
+    static bool saveWith(const Serializer &serializer,
+        const File &file, const SerializedData &tree);
+
+    using SnapshotWriter = Function<bool(const File &file, const SerializedData &snapshot)>;
+    static void writeInBackground(const File &file, const SerializedData &tree,
+        SnapshotWriter writer, Function<void(bool savedOk)> callback);
 };
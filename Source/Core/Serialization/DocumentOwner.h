@@ -38,11 +38,22 @@ public:
         return this->document.get();
     }
 
+    // the autosaver waits while this returns true, e.g. during playback;
+    // the explicit saves are never deferred
+    virtual bool shouldDeferAutosave() const { return false; }
+
 protected:
 
     virtual bool onDocumentLoad(File &file) = 0;
     virtual void onDocumentDidLoad(File &file) {}
     virtual bool onDocumentSave(File &file) = 0;
+
+    // the owners which can build a snapshot of their data quickly
+    // may write it in background, see DocumentHelpers::saveInBackground,
+    // and call back when it's done; the default is to save synchronously
+    virtual bool onDocumentSaveInBackground(const File &file,
+        Function<void(bool savedOk)> callback) { return false; }
+
     virtual void onDocumentDidSave(File &file) {}
     virtual void onDocumentImport(File &file) = 0;
     virtual bool onDocumentExport(File &file) = 0;
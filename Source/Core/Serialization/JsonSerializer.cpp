@@ -17,6 +17,7 @@
 
 #include "Common.h"
 #include "JsonSerializer.h"
+#include "PackedColumn.h"
 
 //===----------------------------------------------------------------------===//
 // Json parser
@@ -26,26 +27,110 @@
 // but returns SerializedData instead of var, and supports comments like `//` and `/* */`.
 // Parses arrays and objects as nodes/children, and all others as properties.
 
-struct JsonParser final
+// Unlike JUCE's one, it reads the input stream in chunks, so that neither
+// the large files nor the backend responses are held in memory as text,
+// and it keeps its own buffers, so it can be used on any thread; the input
+// is parsed as UTF-8 bytes, since all the syntax is ASCII anyway
+
+#define JSON_INPUT_BUFFER_SIZE (8 * 1024)
+#define JSON_MAX_NUMBER_LENGTH 64
+
+class JsonInput final
+{
+public:
+
+    explicit JsonInput(InputStream &stream) noexcept : stream(stream) {}
+
+    // returns 0 at the end of input
+    inline uint8 peek(int offset = 0)
+    {
+        if (this->position + offset >= this->size && !this->fill(offset + 1))
+        {
+            return 0;
+        }
+
+        return this->buffer[this->position + offset];
+    }
+
+    inline uint8 next()
+    {
+        const auto c = this->peek();
+        if (c != 0)
+        {
+            this->position++;
+            if (c == '\n') { this->lineNumber++; }
+        }
+
+        return c;
+    }
+
+    inline int getLineNumber() const noexcept
+    {
+        return this->lineNumber;
+    }
+
+private:
+
+    bool fill(int numBytesNeeded)
+    {
+        // keep the bytes not yet consumed, and read the rest of the buffer
+        const auto numBytesLeft = this->size - this->position;
+        memmove(this->buffer, this->buffer + this->position, size_t(numBytesLeft));
+        this->position = 0;
+        this->size = numBytesLeft;
+
+        while (this->size < numBytesNeeded)
+        {
+            const auto numRead = this->stream.read(this->buffer + this->size,
+                JSON_INPUT_BUFFER_SIZE - this->size);
+
+            if (numRead <= 0)
+            {
+                return false;
+            }
+
+            this->size += numRead;
+        }
+
+        return true;
+    }
+
+    InputStream &stream;
+
+    uint8 buffer[JSON_INPUT_BUFFER_SIZE];
+    int position = 0;
+    int size = 0;
+    int lineNumber = 1;
+
+    JUCE_DECLARE_NON_COPYABLE(JsonInput)
+};
+
+class JsonParser final
 {
-    static Result parseObjectOrArray(String::CharPointerType t, SerializedData &result)
+public:
+
+    explicit JsonParser(InputStream &stream) noexcept : input(stream) {}
+
+    Result parseObjectOrArray(SerializedData &result)
     {
-        skipCommentsAndWhitespaces(t);
+        this->skipCommentsAndWhitespaces();
 
-        switch (t.getAndAdvance())
+        switch (this->input.next())
         {
         case 0:      result = SerializedData(); return Result::ok();
-        case '{':    return parseObject(t, result);
-        case '[':    return parseArray(t, result, result.getType());
+        case '{':    return this->parseObject(result);
+        case '[':    return this->parseArray(result, result.getType());
         }
 
-        return createFail("Expected '{' or '['", &t);
+        return this->createFail("Expected '{' or '['");
     }
 
-    static Result parseStringProperty(const juce_wchar quoteChar, String::CharPointerType &t, const Identifier &propertyName, SerializedData &tree)
+private:
+
+    Result parseStringProperty(const uint8 quoteChar, const Identifier &propertyName, SerializedData &tree)
     {
         String property;
-        const auto r = parseString(quoteChar, t, property);
+        const auto r = this->parseString(quoteChar, property);
         if (r.wasOk())
         {
             tree.setProperty(propertyName, property);
@@ -54,165 +139,191 @@ struct JsonParser final
         return r;
     }
 
-    static Result parseString(const juce_wchar quoteChar, String::CharPointerType &t, String &result)
+    Result parseString(const uint8 quoteChar, String &result)
     {
-        static MemoryOutputStream buffer(256);
+        auto &buffer = this->stringBuffer;
         buffer.reset();
 
         for (;;)
         {
-            auto c = t.getAndAdvance();
+            auto c = this->input.next();
 
             if (c == quoteChar)
             {
                 break;
             }
 
-            if (c == '\\')
+            if (c == 0) { return this->createFail("Unexpected end-of-input in string constant"); }
+
+            if (c != '\\')
+            {
+                // the UTF-8 sequences are copied as they are
+                buffer.writeByte(char(c));
+                continue;
+            }
+
+            c = this->input.next();
+
+            switch (c)
+            {
+            case '"':
+            case '\'':
+            case '\\':
+            case '/':  buffer.writeByte(char(c)); break;
+
+            case 'a':  buffer.writeByte('\a'); break;
+            case 'b':  buffer.writeByte('\b'); break;
+            case 'f':  buffer.writeByte('\f'); break;
+            case 'n':  buffer.writeByte('\n'); break;
+            case 'r':  buffer.writeByte('\r'); break;
+            case 't':  buffer.writeByte('\t'); break;
+
+            case 'u':
             {
-                c = t.getAndAdvance();
+                juce_wchar unicode = 0;
+                const auto r = this->parseUnicodeEscape(unicode);
+                if (r.failed()) { return r; }
 
-                switch (c)
-                {
-                case '"':
-                case '\'':
-                case '\\':
-                case '/':  break;
-
-                case 'a':  c = '\a'; break;
-                case 'b':  c = '\b'; break;
-                case 'f':  c = '\f'; break;
-                case 'n':  c = '\n'; break;
-                case 'r':  c = '\r'; break;
-                case 't':  c = '\t'; break;
-
-                case 'u':
+                // the formatter writes the characters outside of BMP as surrogate pairs
+                if (unicode >= 0xd800 && unicode <= 0xdbff &&
+                    this->input.peek() == '\\' && this->input.peek(1) == 'u')
                 {
-                    c = 0;
+                    this->input.next();
+                    this->input.next();
 
-                    for (int i = 4; --i >= 0;)
-                    {
-                        auto digitValue = CharacterFunctions::getHexDigitValue(t.getAndAdvance());
-                        if (digitValue < 0) { return createFail("Syntax error in Unicode escape sequence"); }
-                        c = (juce_wchar)((c << 4) + static_cast<juce_wchar> (digitValue));
-                    }
+                    juce_wchar lowSurrogate = 0;
+                    const auto r2 = this->parseUnicodeEscape(lowSurrogate);
+                    if (r2.failed()) { return r2; }
 
-                    break;
-                }
+                    unicode = 0x10000 + ((unicode - 0xd800) << 10) + (lowSurrogate - 0xdc00);
                 }
+
+                buffer.appendUTF8Char(unicode);
+                break;
             }
 
-            if (c == 0) { return createFail("Unexpected end-of-input in string constant"); }
-            buffer.appendUTF8Char(c);
+            case 0:
+                return this->createFail("Unexpected end-of-input in string constant");
+
+            default:
+                buffer.writeByte(char(c));
+                break;
+            }
+        }
+
+        result = String::fromUTF8(static_cast<const char *>(buffer.getData()), int(buffer.getDataSize()));
+        return Result::ok();
+    }
+
+    Result parseUnicodeEscape(juce_wchar &result)
+    {
+        result = 0;
+
+        for (int i = 4; --i >= 0;)
+        {
+            const auto digitValue = CharacterFunctions::getHexDigitValue(this->input.next());
+            if (digitValue < 0) { return this->createFail("Syntax error in Unicode escape sequence"); }
+            result = (juce_wchar)((result << 4) + static_cast<juce_wchar>(digitValue));
         }
 
-        result = buffer.toUTF8();
         return Result::ok();
     }
 
-    static void findNextNewline(String::CharPointerType &t)
+    void findNextNewline()
     {
-        juce_wchar c = 0;
-        do { c = t.getAndAdvance(); } while (c != '\n' && c != '\r');
+        uint8 c = 0;
+        do { c = this->input.next(); } while (c != '\n' && c != '\r' && c != 0);
     }
 
-    static void findEndOfMultilineComment(String::CharPointerType &t)
+    void findEndOfMultilineComment()
     {
-        juce_wchar c1 = 0;
-        juce_wchar c2 = 0;
+        uint8 c1 = 0;
+        uint8 c2 = 0;
         do
-        { 
+        {
             c1 = c2;
-            c2 = t.getAndAdvance();
+            c2 = this->input.next();
             if (c2 == 0) { return; }
         } while (c1 != '*' || c2 != '/');
     }
 
-    static void skipCommentsAndWhitespaces(String::CharPointerType &t)
+    void skipCommentsAndWhitespaces()
     {
-        t = t.findEndOfWhitespace();
-        auto t2 = t;
-        switch (t2.getAndAdvance())
+        for (;;)
         {
-        case '/':
-            const auto c = t2.getAndAdvance();
-            if (c == '/')
+            const auto c = this->input.peek();
+            if (CharacterFunctions::isWhitespace(juce_wchar(c)))
             {
-                t = t2;
-                findNextNewline(t);
-                skipCommentsAndWhitespaces(t);
+                this->input.next();
             }
-            else if (c == '*')
+            else if (c == '/' && this->input.peek(1) == '/')
+            {
+                this->findNextNewline();
+            }
+            else if (c == '/' && this->input.peek(1) == '*')
+            {
+                this->input.next();
+                this->input.next();
+                this->findEndOfMultilineComment();
+            }
+            else
             {
-                t = t2;
-                findEndOfMultilineComment(t);
-                skipCommentsAndWhitespaces(t);
+                return;
             }
         }
     }
 
-    static Result parseAny(String::CharPointerType &t, SerializedData &result, const Identifier &nodeOrProperty)
+    Result parseAny(SerializedData &result, const Identifier &nodeOrProperty)
     {
-        skipCommentsAndWhitespaces(t);
-        auto t2 = t;
+        this->skipCommentsAndWhitespaces();
 
-        switch (t2.getAndAdvance())
+        switch (this->input.peek())
         {
         case '{':
             {
-                t = t2;
+                this->input.next();
                 SerializedData child(nodeOrProperty);
                 result.appendChild(child);
-                return parseObject(t, child);
+                return this->parseObject(child);
             }
 
         case '[':
-            t = t2;
-            return parseArray(t, result, nodeOrProperty);
+            this->input.next();
+            if (this->isColumnStart())
+            {
+                return this->parseColumn(result, nodeOrProperty);
+            }
 
-        case '"':
-            t = t2;
-            return parseStringProperty('"', t, nodeOrProperty, result);
+            return this->parseArray(result, nodeOrProperty);
 
+        case '"':
         case '\'':
-            t = t2;
-            return parseStringProperty('\'', t, nodeOrProperty, result);
+            return this->parseStringProperty(this->input.next(), nodeOrProperty, result);
 
         case '-':
-            skipCommentsAndWhitespaces(t2);
-            if (!CharacterFunctions::isDigit(*t2))
-                break;
-
-            t = t2;
-            return parseNumberProperty(t, nodeOrProperty, result, true);
-
         case '0': case '1': case '2': case '3': case '4':
         case '5': case '6': case '7': case '8': case '9':
-            return parseNumberProperty(t, nodeOrProperty, result, false);
+            return this->parseNumberProperty(nodeOrProperty, result);
 
         case 't':   // "true"
-            if (t2.getAndAdvance() == 'r' && t2.getAndAdvance() == 'u' && t2.getAndAdvance() == 'e')
+            if (this->parseKeyword("true"))
             {
-                t = t2;
                 result.setProperty(nodeOrProperty, true);
                 return Result::ok();
             }
             break;
 
         case 'f':   // "false"
-            if (t2.getAndAdvance() == 'a' && t2.getAndAdvance() == 'l'
-                && t2.getAndAdvance() == 's' && t2.getAndAdvance() == 'e')
+            if (this->parseKeyword("false"))
             {
-                t = t2;
                 result.setProperty(nodeOrProperty, false);
                 return Result::ok();
             }
             break;
 
         case 'n':   // "null"
-            if (t2.getAndAdvance() == 'u' && t2.getAndAdvance() == 'l' && t2.getAndAdvance() == 'l')
+            if (this->parseKeyword("null"))
             {
-                t = t2;
                 // no need to set any property in this case?
                 return Result::ok();
             }
@@ -222,139 +333,209 @@ struct JsonParser final
             break;
         }
 
-        return createFail("Syntax error", &t);
+        return this->createFail("Syntax error");
     }
 
-private:
-    static Result createFail(const char *const message, const String::CharPointerType *location = nullptr)
+    bool parseKeyword(const char *keyword)
     {
-        String m(message);
-        if (location != nullptr)
-            m << ": \"" << String(*location, 20) << '"';
+        for (; *keyword != 0; ++keyword)
+        {
+            if (this->input.next() != uint8(*keyword))
+            {
+                return false;
+            }
+        }
 
-        return Result::fail(m);
+        return true;
     }
 
-    static Result parseNumberProperty(String::CharPointerType &t, const Identifier &propertyName, SerializedData &result, const bool isNegative)
+    Result createFail(const char *const message) const
     {
-        auto oldT = t;
+        String m(message);
+        m << " at line " << this->input.getLineNumber();
+        return Result::fail(m);
+    }
 
-        int64 intValue = t.getAndAdvance() - '0';
-        jassert(intValue >= 0 && intValue < 10);
+    Result parseNumber(var &result)
+    {
+        char text[JSON_MAX_NUMBER_LENGTH + 1] = {};
+        int length = 0;
+        bool isDouble = false;
 
         for (;;)
         {
-            auto previousChar = t;
-            auto c = t.getAndAdvance();
-            auto digit = ((int)c) - '0';
+            const auto c = this->input.peek();
+            const bool isDigit = (c >= '0' && c <= '9');
+            const bool isExponentSign = length > 0 && (c == '+' || c == '-') &&
+                (text[length - 1] == 'e' || text[length - 1] == 'E');
+            const bool isDoublePart = (c == '.' || c == 'e' || c == 'E' || isExponentSign);
 
-            if (isPositiveAndBelow(digit, 10))
+            if (!isDigit && !isDoublePart && !(length == 0 && c == '-'))
             {
-                intValue = intValue * 10 + digit;
-                continue;
+                break;
             }
 
-            if (c == 'e' || c == 'E' || c == '.')
+            if (length == JSON_MAX_NUMBER_LENGTH)
             {
-                t = oldT;
-                auto asDouble = CharacterFunctions::readDoubleValue(t);
-                result.setProperty(propertyName, isNegative ? -asDouble : asDouble);
-                return Result::ok();
+                return this->createFail("Syntax error in number");
             }
 
-            if (CharacterFunctions::isWhitespace(c)
-                || c == ',' || c == '}' || c == ']' || c == 0)
-            {
-                t = previousChar;
-                break;
-            }
+            isDouble = isDouble || isDoublePart;
+            text[length++] = char(this->input.next());
+        }
+
+        const auto c = this->input.peek();
+        if (!CharacterFunctions::isWhitespace(juce_wchar(c))
+            && c != ',' && c != '}' && c != ']' && c != '/' && c != 0)
+        {
+            return this->createFail("Syntax error in number");
+        }
+
+        const bool isNegative = text[0] == '-';
+        const auto *digits = isNegative ? text + 1 : text;
+        if (!(*digits >= '0' && *digits <= '9'))
+        {
+            return this->createFail("Syntax error in number");
+        }
+
+        if (isDouble)
+        {
+            auto t = CharPointer_ASCII(text);
+            result = CharacterFunctions::readDoubleValue(t);
+            return Result::ok();
+        }
 
-            return createFail("Syntax error in number", &oldT);
+        int64 intValue = 0;
+        for (; *digits != 0; ++digits)
+        {
+            intValue = intValue * 10 + (*digits - '0');
         }
 
-        auto correctedValue = isNegative ? -intValue : intValue;
+        const auto correctedValue = isNegative ? -intValue : intValue;
 
         if ((intValue >> 31) != 0)
-            result.setProperty(propertyName, correctedValue);
+            result = correctedValue;
         else
-            result.setProperty(propertyName, (int)correctedValue);
+            result = (int)correctedValue;
 
         return Result::ok();
     }
 
-    static Result parseObject(String::CharPointerType &t, SerializedData &result)
+    Result parseNumberProperty(const Identifier &propertyName, SerializedData &result)
+    {
+        var value;
+        const auto r = this->parseNumber(value);
+        if (r.wasOk())
+        {
+            result.setProperty(propertyName, value);
+        }
+
+        return r;
+    }
+
+    Result parseObject(SerializedData &result)
     {
         for (;;)
         {
-            skipCommentsAndWhitespaces(t);
+            this->skipCommentsAndWhitespaces();
 
-            auto oldT = t;
-            auto c = t.getAndAdvance();
+            const auto c = this->input.next();
 
             if (c == '}') { break; }
-            if (c == 0) { return createFail("Unexpected end-of-input in object declaration"); }
+            if (c == 0) { return this->createFail("Unexpected end-of-input in object declaration"); }
             if (c == '"')
             {
                 String nodeNameVar;
-                const auto r = parseString('"', t, nodeNameVar);
+                const auto r = this->parseString('"', nodeNameVar);
                 if (r.failed()) { return r; }
 
                 const Identifier nodeName(nodeNameVar);
                 if (nodeName.isValid())
                 {
-                    skipCommentsAndWhitespaces(t);
-                    oldT = t;
-
-                    auto c2 = t.getAndAdvance();
+                    this->skipCommentsAndWhitespaces();
 
-                    if (c2 != ':') { return createFail("Expected ':', but found", &oldT); }
+                    if (this->input.next() != ':') { return this->createFail("Expected ':'"); }
 
-                    const auto r2 = parseAny(t, result, nodeName);
+                    const auto r2 = this->parseAny(result, nodeName);
                     if (r2.failed()) { return r2; }
 
-                    skipCommentsAndWhitespaces(t);
-                    oldT = t;
+                    this->skipCommentsAndWhitespaces();
 
-                    auto nextChar = t.getAndAdvance();
+                    const auto nextChar = this->input.next();
                     if (nextChar == ',') { continue; }
                     if (nextChar == '}') { break; }
                 }
             }
 
-            return createFail("Expected object member declaration, but found", &oldT);
+            return this->createFail("Expected object member declaration");
         }
 
         return Result::ok();
     }
 
-    static Result parseArray(String::CharPointerType &t, SerializedData &result, const Identifier &nodeName)
+    // the arrays of numbers are the packed columns, see PackedColumn
+    bool isColumnStart()
+    {
+        this->skipCommentsAndWhitespaces();
+        const auto c = this->input.peek();
+        return c == '-' || (c >= '0' && c <= '9');
+    }
+
+    Result parseColumn(SerializedData &result, const Identifier &propertyName)
     {
+        PackedColumn::Writer column;
+
         for (;;)
         {
-            skipCommentsAndWhitespaces(t);
+            this->skipCommentsAndWhitespaces();
 
-            auto oldT = t;
-            auto c = t.getAndAdvance();
+            var value;
+            const auto r = this->parseNumber(value);
+            if (r.failed()) { return r; }
 
-            if (c == ']') { break; }
-            if (c == 0) { return createFail("Unexpected end-of-input in array declaration"); }
+            column.add(static_cast<int64>(value));
 
-            t = oldT;
-            auto r = parseAny(t, result, nodeName);
+            this->skipCommentsAndWhitespaces();
 
+            const auto nextChar = this->input.next();
+            if (nextChar == ',') { continue; }
+            if (nextChar == ']') { break; }
+            return this->createFail("Expected integer array item");
+        }
+
+        result.setProperty(propertyName, column.toVar());
+        return Result::ok();
+    }
+
+    Result parseArray(SerializedData &result, const Identifier &nodeName)
+    {
+        for (;;)
+        {
+            this->skipCommentsAndWhitespaces();
+
+            const auto c = this->input.peek();
+
+            if (c == ']') { this->input.next(); break; }
+            if (c == 0) { return this->createFail("Unexpected end-of-input in array declaration"); }
+
+            const auto r = this->parseAny(result, nodeName);
             if (r.failed()) { return r; }
 
-            skipCommentsAndWhitespaces(t);
-            oldT = t;
+            this->skipCommentsAndWhitespaces();
 
-            auto nextChar = t.getAndAdvance();
+            const auto nextChar = this->input.next();
             if (nextChar == ',') { continue; }
             if (nextChar == ']') { break; }
-            return createFail("Expected object array item, but found", &oldT);
+            return this->createFail("Expected object array item");
         }
 
         return Result::ok();
     }
+
+    JsonInput input;
+    MemoryOutputStream stringBuffer { 256 };
+
+    JUCE_DECLARE_NON_COPYABLE(JsonParser)
 };
 
 //===----------------------------------------------------------------------===//
@@ -431,23 +612,27 @@ struct JsonFormatter final
             }
         }
 
+        // the groups are written in the order of their first appearance,
+        // the hash map's order is not the same between runs
         using GroupedChildren = FlatHashMap<Identifier, Array<SerializedData>, IdentifierHash>;
         GroupedChildren children;
+        Array<Identifier> childrenTypes;
         for (const auto &child : tree)
         {
             if (!children.contains(child.getType()))
             {
                 children[child.getType()] = Array<SerializedData>(child);
+                childrenTypes.add(child.getType());
                 continue;
             }
 
             children.at(child.getType()).add(child);
         }
 
-        for (auto i = children.begin(); i != children.end(); ++i)
+        for (int i = 0; i < childrenTypes.size(); ++i)
         {
-            const auto &childrenType = i->first;
-            const auto &childGroupOfSameType = i->second;
+            const auto &childrenType = childrenTypes.getReference(i);
+            const auto &childGroupOfSameType = children.at(childrenType);
 
             if (!allOnOneLine)
             {
@@ -469,7 +654,7 @@ struct JsonFormatter final
                     indentLevel + indentSize, allOnOneLine, maximumDecimalPlaces);
             }
 
-            if (i != children.end() && std::next(i) != children.end())
+            if (i < childrenTypes.size() - 1)
             {
                 if (allOnOneLine) { out << ", "; } else { out << ',' << newLine; }
             }
@@ -515,6 +700,22 @@ struct JsonFormatter final
         {
             out << String(static_cast<double> (v), maximumDecimalPlaces);
         }
+        else if (PackedColumn::isPackedColumn(v))
+        {
+            PackedColumn::Reader column(v);
+            out << '[';
+            for (int i = 0; i < column.size(); ++i)
+            {
+                if (i > 0) { out << ", "; }
+                out << String(column.next());
+            }
+            out << ']';
+        }
+        else if (const auto *data = v.getBinaryData())
+        {
+            // the same encoding as in xml, see var::toString
+            out << '"' << data->toBase64Encoding() << '"';
+        }
         else
         {
             // Should never hit this point anyway
@@ -637,9 +838,7 @@ Result JsonSerializer::saveToFile(File file, const SerializedData &tree) const
     {
         fileStream.setPosition(0);
         fileStream.truncate();
-
-        JsonFormatter::write(fileStream, tree, this->headerComments, 0, this->allOnOneLine, 6);
-        return Result::ok();
+        return this->saveToStream(fileStream, tree);
     }
 
     return Result::fail("Failed to save");
@@ -647,9 +846,15 @@ Result JsonSerializer::saveToFile(File file, const SerializedData &tree) const
 
 SerializedData JsonSerializer::loadFromFile(const File &file) const
 {
-    const String text(file.loadFileAsString());
+    FileInputStream fileStream(file);
+    if (!fileStream.openedOk())
+    {
+        return {};
+    }
+
     SerializedData root(fakeRoot);
-    const auto result = JsonParser::parseObjectOrArray(text.getCharPointer(), root);
+    JsonParser parser(fileStream);
+    const auto result = parser.parseObjectOrArray(root);
     if (result.wasOk())
     {
         return root.getChild(0);
@@ -661,30 +866,48 @@ SerializedData JsonSerializer::loadFromFile(const File &file) const
 Result JsonSerializer::saveToString(String &string, const SerializedData &tree) const
 {
     MemoryOutputStream mo(1024);
-    JsonFormatter::write(mo, tree, this->headerComments, 0, this->allOnOneLine, 6);
+    this->saveToStream(mo, tree);
     string = mo.toUTF8();
     return Result::ok();
 }
 
 SerializedData JsonSerializer::loadFromString(const String &string) const
+{
+    MemoryInputStream stream(string.toRawUTF8(), string.getNumBytesAsUTF8(), false);
+    SerializedData result;
+    this->loadFromStream(stream, result);
+    return result;
+}
+
+Result JsonSerializer::saveToStream(OutputStream &stream, const SerializedData &tree) const
+{
+    JsonFormatter::write(stream, tree, this->headerComments, 0, this->allOnOneLine, 6);
+    return Result::ok();
+}
+
+Result JsonSerializer::loadFromStream(InputStream &stream, SerializedData &result) const
 {
     SerializedData root(fakeRoot);
-    const auto result = JsonParser::parseObjectOrArray(string.getCharPointer(), root);
-    if (result.wasOk())
+    JsonParser parser(stream);
+    const auto parseResult = parser.parseObjectOrArray(root);
+    if (parseResult.failed())
     {
-        if (root.getNumChildren() == 1 && root.getNumProperties() == 0)
-        {
-            // expected behaviour in most cases:
-            return root.getChild(0);
-        }
-        else
-        {
-            // but it might be just a regular json we need to parse:
-            return root;
-        }
+        result = {};
+        return parseResult;
     }
 
-    return {};
+    if (root.getNumChildren() == 1 && root.getNumProperties() == 0)
+    {
+        // expected behaviour in most cases:
+        result = root.getChild(0);
+    }
+    else
+    {
+        // but it might be just a regular json we need to parse:
+        result = root;
+    }
+
+    return Result::ok();
 }
 
 bool JsonSerializer::supportsFileWithExtension(const String &extension) const
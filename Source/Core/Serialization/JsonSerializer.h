@@ -33,6 +33,11 @@ public:
     Result saveToString(String &string, const SerializedData &tree) const override;
     SerializedData loadFromString(const String &string) const override;
 
+    // both work incrementally, and can be used on any thread;
+    // an empty input is not an error, but gives an invalid tree
+    Result saveToStream(OutputStream &stream, const SerializedData &tree) const;
+    Result loadFromStream(InputStream &stream, SerializedData &result) const;
+
     bool supportsFileWithExtension(const String &extension) const override;
     bool supportsFileWithHeader(const String &header) const override;
 
@@ -0,0 +1,130 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Common.h"
+#include "PackedColumn.h"
+
+static const uint8 kPackedColumnMarker = 0xc1;
+
+static inline void writeVarInt(OutputStream &out, uint64 value)
+{
+    while (value >= 0x80)
+    {
+        out.writeByte(char(uint8(value) | 0x80));
+        value >>= 7;
+    }
+
+    out.writeByte(char(uint8(value)));
+}
+
+static inline bool readVarInt(const uint8 *&ptr, const uint8 *end, uint64 &result) noexcept
+{
+    result = 0;
+    for (int shift = 0; ptr < end && shift < 64; shift += 7)
+    {
+        const auto byte = *ptr++;
+        result |= uint64(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static inline uint64 zigzagEncode(int64 value) noexcept
+{
+    return (uint64(value) << 1) ^ uint64(value >> 63);
+}
+
+static inline int64 zigzagDecode(uint64 value) noexcept
+{
+    return int64(value >> 1) ^ -int64(value & 1);
+}
+
+//===----------------------------------------------------------------------===//
+// Writer
+//===----------------------------------------------------------------------===//
+
+void PackedColumn::Writer::add(int64 value)
+{
+    writeVarInt(this->values, zigzagEncode(value));
+    this->numValues++;
+}
+
+var PackedColumn::Writer::toVar() const
+{
+    MemoryOutputStream result(this->values.getDataSize() + 8);
+    result.writeByte(char(kPackedColumnMarker));
+    writeVarInt(result, uint64(this->numValues));
+    result.write(this->values.getData(), this->values.getDataSize());
+    return var(result.getData(), result.getDataSize());
+}
+
+//===----------------------------------------------------------------------===//
+// Reader
+//===----------------------------------------------------------------------===//
+
+PackedColumn::Reader::Reader(const var &property)
+{
+    if (const auto *data = property.getBinaryData())
+    {
+        this->init(data->getData(), data->getSize());
+    }
+    else if (property.isString() &&
+        this->decodedData.fromBase64Encoding(property.toString()))
+    {
+        this->init(this->decodedData.getData(), this->decodedData.getSize());
+    }
+}
+
+bool PackedColumn::Reader::init(const void *data, size_t numBytes) noexcept
+{
+    this->ptr = static_cast<const uint8 *>(data);
+    this->end = this->ptr + numBytes;
+
+    uint64 count = 0;
+    if (numBytes == 0 || *this->ptr++ != kPackedColumnMarker ||
+        !readVarInt(this->ptr, this->end, count) || count > uint64(numBytes))
+    {
+        this->ptr = this->end = nullptr;
+        return false;
+    }
+
+    this->numValues = int(count);
+    return true;
+}
+
+int64 PackedColumn::Reader::next() noexcept
+{
+    uint64 value = 0;
+    if (!readVarInt(this->ptr, this->end, value))
+    {
+        jassertfalse; // reading past the end or a broken column
+        return 0;
+    }
+
+    return zigzagDecode(value);
+}
+
+bool PackedColumn::isPackedColumn(const var &property) noexcept
+{
+    const auto *data = property.getBinaryData();
+    return data != nullptr && data->getSize() > 0 &&
+        static_cast<const uint8 *>(data->getData())[0] == kPackedColumnMarker;
+}
@@ -0,0 +1,77 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+// A column of integers, packed into a single binary property:
+// the bulk arrays of events, like the notes of a track, are stored
+// as one column per parameter instead of a node with named properties
+// per event; values are zigzag varints, so the small ones take a byte,
+// binary files keep the column as is, json files show it as an array
+// of numbers, and xml files keep it as a base64 string
+
+class PackedColumn final
+{
+public:
+
+    class Writer final
+    {
+    public:
+
+        Writer() = default;
+
+        void add(int64 value);
+        inline int size() const noexcept { return this->numValues; }
+
+        var toVar() const;
+
+    private:
+
+        MemoryOutputStream values;
+        int numValues = 0;
+
+        JUCE_DECLARE_NON_COPYABLE(Writer)
+    };
+
+    // the property must stay alive while it's being read
+    class Reader final
+    {
+    public:
+
+        explicit Reader(const var &property);
+
+        inline int size() const noexcept { return this->numValues; }
+        inline bool isValid() const noexcept { return this->numValues >= 0; }
+
+        // returns 0 when there's nothing more to read
+        int64 next() noexcept;
+
+    private:
+
+        MemoryBlock decodedData;
+        const uint8 *ptr = nullptr;
+        const uint8 *end = nullptr;
+        int numValues = -1;
+
+        bool init(const void *data, size_t numBytes) noexcept;
+
+        JUCE_DECLARE_NON_COPYABLE(Reader)
+    };
+
+    static bool isPackedColumn(const var &property) noexcept;
+
+};
@@ -86,6 +86,7 @@ namespace Serialization
 
         // Events
         static const Identifier note = "note";
+        static const Identifier packedNotes = "notes";
         static const Identifier automationEvent = "event";
         static const Identifier annotation = "annotation";
         static const Identifier timeSignature = "timeSignature";
@@ -124,6 +125,11 @@ namespace Serialization
         static const Identifier instrument = "instrument";
         static const Identifier instrumentId = "id";
         static const Identifier instrumentName = "name";
+        static const Identifier midiOutputDevice = "midiOutput";
+        static const Identifier effectBus = "bus";
+        static const Identifier send = "send";
+        static const Identifier sendBusId = "busId";
+        static const Identifier sendLevel = "level";
 
         static const Identifier node = "node";
         static const Identifier nodeId = "id";
@@ -157,8 +163,19 @@ namespace Serialization
         static const Identifier midiInput = "midiInput";
         static const Identifier midiInputName = "name";
         static const Identifier defaultMidiOutput = "defaultMidiOutput";
+        static const Identifier midiSyncOutput = "midiSyncOutput";
+        static const Identifier midiSyncOutputName = "name";
+        static const Identifier midiSyncSendsClock = "clock";
+        static const Identifier midiSyncSendsTimecode = "timecode";
+        static const Identifier midiSyncTimecodeType = "timecodeRate";
+        static const Identifier midiSyncLatencyOffset = "latencyOffset";
 
         static const Identifier pluginsList = "plugins";
+        static const Identifier pluginsScanCache = "scanCache";
+        static const Identifier pluginsScanCacheEntry = "entry";
+        static const Identifier pluginsScanCacheFile = "file";
+        static const Identifier pluginsScanCacheFileSize = "size";
+        static const Identifier pluginsScanCacheFileTime = "time";
         static const Identifier audioCore = "audioCore";
         static const Identifier orchestra = "orchestra";
 
@@ -170,6 +187,31 @@ namespace Serialization
         static const Identifier audioDeviceBufferSize = "bufferSize";
         static const Identifier audioDeviceInputChannels = "inputChannels";
         static const Identifier audioDeviceOutputChannels = "outputChannels";
+        static const Identifier audioProcessingThreads = "processingThreads";
+        static const Identifier audioLatencyAlignment = "latencyAlignment";
+        static const Identifier audioBufferSizeMode = "bufferSizeMode";
+        static const Identifier metronomeEnabled = "metronome";
+        static const Identifier metronomeCountInBars = "countInBars";
+
+        // the control messages between the host and the plugin sandbox process
+        namespace Sandbox
+        {
+            static const Identifier load = "load";
+            static const Identifier prepare = "prepare";
+            static const Identifier release = "release";
+            static const Identifier getState = "getState";
+            static const Identifier setState = "setState";
+            static const Identifier reply = "reply";
+
+            static const Identifier sharedFile = "sharedFile";
+            static const Identifier sampleRate = "sampleRate";
+            static const Identifier blockSize = "blockSize";
+            static const Identifier error = "error";
+            static const Identifier latency = "latency";
+            static const Identifier tailLength = "tail";
+            static const Identifier acceptsMidi = "acceptsMidi";
+            static const Identifier producesMidi = "producesMidi";
+        } // namespace Sandbox
     } // namespace Audio
 
     namespace Config
@@ -185,6 +227,8 @@ namespace Serialization
         static const Identifier lastUpdatesInfo = "lastUpdatesInfo";
         static const Identifier lastUsedFont = "lastUsedFont";
         static const Identifier lastSearch = "lastSearch";
+        static const Identifier memoryBudget = "memoryBudget";
+        static const Identifier pendingResourceSync = "pendingResourceSync";
 
         // obsolete, to be removed in future versions (moved to global ui flags):
         static const Identifier nativeTitleBar = "nativeTitleBar";
@@ -405,6 +449,9 @@ namespace Serialization
             static const Identifier title = "title";
             static const Identifier projectId = "id";
             static const Identifier updatedAt = "updatedAt";
+            static const Identifier fileSize = "fileSize";
+            static const Identifier numTracks = "numTracks";
+            static const Identifier numEvents = "numEvents";
         } // namespace RecentProjects
 
         namespace Sessions
@@ -449,6 +496,9 @@ namespace Serialization
 
         static const Identifier vcsItemId = "vcsId";
 
+        static const Identifier packedRevisionItems = "packedItems";
+        static const Identifier packedRevisionItemsData = "data";
+
         static const Identifier revisionItem = "revisionItem";
         static const Identifier revisionItemType = "type";
         static const Identifier revisionItemName = "name";
@@ -516,6 +566,20 @@ namespace Serialization
         }
     } // namespace VCS
 
+    namespace Sync
+    {
+        static const Identifier queue = "syncQueue";
+        static const Identifier operation = "operation";
+        static const Identifier operationId = "id";
+        static const Identifier operationType = "type";
+        static const Identifier operationTarget = "target";
+        static const Identifier numAttempts = "attempts";
+
+        static const Identifier pushRevisions = "pushRevisions";
+        static const Identifier putResource = "putResource";
+        static const Identifier deleteResource = "deleteResource";
+    } // namespace Sync
+
     namespace Api
     {
         // Config keys
@@ -652,6 +716,10 @@ namespace Serialization
         static const Identifier groupAfter = "groupAfter";
         static const Identifier instanceBefore = "instanceBefore";
         static const Identifier instanceAfter = "instanceAfter";
+        static const Identifier deltaBeat = "deltaBeat";
+        static const Identifier deltaKey = "deltaKey";
+        static const Identifier velocityMultiplier = "velocityMultiplier";
+        static const Identifier snapsPerBeat = "snapsPerBeat";
 
         static const Identifier pianoTrackInsertAction = "pianoTrackInsert";
         static const Identifier pianoTrackRemoveAction = "pianoTrackRemove";
@@ -677,6 +745,7 @@ namespace Serialization
         static const Identifier notesGroupInsertAction = "notesInsert";
         static const Identifier notesGroupRemoveAction = "notesRemove";
         static const Identifier notesGroupChangeAction = "notesChange";
+        static const Identifier notesGroupTransformAction = "notesTransform";
         
         static const Identifier annotationEventInsertAction = "annotationInsert";
         static const Identifier annotationEventRemoveAction = "annotationRemove";
@@ -705,5 +774,14 @@ namespace Serialization
         static const Identifier automationEventsGroupInsertAction = "automationEventsInsert";
         static const Identifier automationEventsGroupRemoveAction = "automationEventsRemove";
         static const Identifier automationEventsGroupChangeAction = "automationEventsChange";
+
+        // see UndoJournal
+        static const Identifier journalCheckpoint = "journalCheckpoint";
+        static const Identifier journalCheckpointId = "id";
+        static const Identifier journalPerform = "perform";
+        static const Identifier journalUndo = "undo";
+        static const Identifier journalRedo = "redo";
+        static const Identifier journalTransactionId = "transactionId";
+        static const Identifier journalNewTransactionId = "newTransactionId";
     } // namespace Undo
 }  // namespace Serialization
@@ -44,26 +44,80 @@ public:
     ~SharedData()
     {
         jassert(parent == nullptr);
+        this->resetChildIndex();
         for (auto i = this->children.size(); --i >= 0;)
         {
             const Ptr c(this->children.getObjectPointerUnchecked(i));
-            c->parent = nullptr;
+            if (c->parent == this) // the shared children keep their first parent
+            {
+                c->parent = nullptr;
+            }
             this->children.remove(i);
         }
     }
     
     SerializedData getChildWithName(const Identifier &typeToMatch) const
     {
-        for (auto *s : this->children)
+        if (this->children.size() < SharedData::minChildrenToIndex)
         {
-            if (s->type == typeToMatch)
+            for (auto *s : this->children)
             {
-                return SerializedData(*s);
+                if (s->type == typeToMatch)
+                {
+                    return SerializedData(*s);
+                }
             }
+
+            return {};
+        }
+
+        const auto *index = this->getChildIndex();
+        const auto found = index->find(typeToMatch);
+        if (found != index->end())
+        {
+            return SerializedData(*found->second);
         }
 
         return {};
     }
+
+    // The deserializers look up the children by type a lot, and a linear
+    // scan per lookup makes it quadratic for the larger nodes, so those
+    // build an index of the first child of each type on the first lookup;
+    // the trees are not modified while being read, but might be read from
+    // several threads, hence the index is published atomically
+    using ChildIndex = FlatHashMap<Identifier, SharedData *, IdentifierHash>;
+
+    const ChildIndex *getChildIndex() const
+    {
+        if (const auto *existingIndex = this->childIndex.load(std::memory_order_acquire))
+        {
+            return existingIndex;
+        }
+
+        auto *newIndex = new ChildIndex();
+        for (auto *s : this->children)
+        {
+            if (newIndex->find(s->type) == newIndex->end())
+            {
+                (*newIndex)[s->type] = s;
+            }
+        }
+
+        ChildIndex *expected = nullptr;
+        if (!this->childIndex.compare_exchange_strong(expected, newIndex, std::memory_order_acq_rel))
+        {
+            delete newIndex;
+            return expected;
+        }
+
+        return newIndex;
+    }
+
+    void resetChildIndex() noexcept
+    {
+        delete this->childIndex.exchange(nullptr, std::memory_order_acq_rel);
+    }
     
     bool isAChildOf(const SharedData *possibleParent) const noexcept
     {
@@ -84,6 +138,7 @@ public:
         {
             jassert(child != this && !this->isAChildOf(child));
             jassert(child->parent == nullptr);
+            this->resetChildIndex();
             this->children.insert(index, child);
             child->parent = this;
         }
@@ -95,11 +150,26 @@ public:
         {
             jassert(child != this && !this->isAChildOf(child));
             jassert(child->parent == nullptr);
+            this->resetChildIndex();
             this->children.add(child);
             child->parent = this;
         }
     }
 
+    void appendSharedChild(SharedData *child)
+    {
+        if (child != nullptr)
+        {
+            jassert(child != this && !this->isAChildOf(child));
+            this->resetChildIndex();
+            this->children.add(child);
+            if (child->parent == nullptr)
+            {
+                child->parent = this;
+            }
+        }
+    }
+
     bool isEquivalentTo(const SharedData &other) const noexcept
     {
         if (this->type != other.type
@@ -172,6 +242,9 @@ public:
     ReferenceCountedArray<SharedData> children;
     SharedData *parent = nullptr;
 
+    static constexpr int minChildrenToIndex = 8;
+    mutable std::atomic<ChildIndex *> childIndex { nullptr };
+
     JUCE_LEAK_DETECTOR(SharedData)
 };
 
@@ -321,6 +394,12 @@ void SerializedData::appendChild(const SerializedData &child)
     this->data->appendChild(child.data.get());
 }
 
+void SerializedData::appendSharedChild(const SerializedData &child)
+{
+    jassert(this->data != nullptr);
+    this->data->appendSharedChild(child.data.get());
+}
+
 SerializedData::Iterator::Iterator(const SerializedData &v, bool isEnd)
     : internal(v.data != nullptr ? (isEnd ? v.data->children.end() : v.data->children.begin()) : nullptr) {}
 
@@ -444,7 +523,7 @@ SerializedData SerializedData::readFromStream(InputStream &input)
             return v;
         }
 
-        v.data->children.add(child.data);
+        v.data->children.add(child.data); // not indexed yet
         child.data->parent = v.data.get();
     }
 
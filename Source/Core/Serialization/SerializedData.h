@@ -55,6 +55,12 @@ public:
     void addChild(const SerializedData &child, int index);
     void appendChild(const SerializedData &child);
 
+    // Appends the child without copying it, even if it already belongs to
+    // another tree, so that the immutable data, like the vcs deltas, can be
+    // shared by the revisions, stashes and saved trees; the shared nodes
+    // must never be modified afterwards, and getParent returns the first one
+    void appendSharedChild(const SerializedData &child);
+
     SerializedData getParent() const noexcept;
 
     UniquePointer<XmlElement> writeToXml() const;
@@ -29,6 +29,13 @@ public:
     virtual Result saveToFile(File file, const SerializedData &tree) const = 0;
     virtual SerializedData loadFromFile(const File &file) const = 0;
 
+    // the formats which allow to rewrite only the changed parts of the existing
+    // file should implement this; if it fails, the file is saved from scratch
+    virtual Result updateFile(File file, const SerializedData &tree) const
+    {
+        return Result::fail("Not supported");
+    }
+
     virtual Result saveToString(String &string, const SerializedData &tree) const = 0;
     virtual SerializedData loadFromString(const String &string) const = 0;
 
@@ -0,0 +1,157 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Common.h"
+#include "StartupProfiler.h"
+#include "DocumentHelpers.h"
+#include "Workspace.h"
+#include "RootNode.h"
+
+#define STARTUP_PROFILER_FLAG "--profile-startup"
+#define STARTUP_PROFILER_TRACE_FILE "startup-trace.json"
+
+// gives the project page a chance to get laid out and painted before quitting
+#define STARTUP_PROFILER_SETTLE_TIME_MS (100)
+
+struct StartupTraceEvent final
+{
+    const char *name;
+    double startTimeMs;
+    double durationMs;
+    int64 threadId;
+};
+
+struct StartupTrace final
+{
+    SpinLock eventsLock;
+    Array<StartupTraceEvent> events;
+    double startTimeMs = 0.0;
+    File projectFile;
+};
+
+static StartupTrace &getStartupTrace()
+{
+    static StartupTrace trace;
+    return trace;
+}
+
+// written once in App::initialise, before any scopes, and never reset
+static bool isStartupProfilingEnabled = false;
+
+bool StartupProfiler::initWithCommandLine(const String &commandLine)
+{
+    const auto args = StringArray::fromTokens(commandLine, true);
+    const auto flagIndex = args.indexOf(STARTUP_PROFILER_FLAG);
+    if (flagIndex < 0)
+    {
+        return false;
+    }
+
+    auto &trace = getStartupTrace();
+    trace.startTimeMs = Time::getMillisecondCounterHiRes();
+    trace.events.ensureStorageAllocated(64);
+
+    if (flagIndex + 1 < args.size())
+    {
+        trace.projectFile = File::getCurrentWorkingDirectory()
+            .getChildFile(args[flagIndex + 1].unquoted());
+    }
+
+    isStartupProfilingEnabled = true;
+    return true;
+}
+
+bool StartupProfiler::isEnabled() noexcept
+{
+    return isStartupProfilingEnabled;
+}
+
+void StartupProfiler::runOpenProjectAndQuit()
+{
+    if (!isStartupProfilingEnabled)
+    {
+        return;
+    }
+
+    const auto &projectFile = getStartupTrace().projectFile;
+    if (projectFile.existsAsFile())
+    {
+        STARTUP_PROFILER_SCOPE("RootNode::openProject");
+        App::Workspace().getTreeRoot()->openProject(projectFile);
+    }
+    else if (projectFile != File())
+    {
+        DBG("Startup profiler: project not found: " + projectFile.getFullPathName());
+    }
+
+    Timer::callAfterDelay(STARTUP_PROFILER_SETTLE_TIME_MS, []()
+    {
+        const auto traceFile = StartupProfiler::saveTrace();
+        DBG("Startup profiler: saved the trace into " + traceFile.getFullPathName());
+        JUCEApplication::quit();
+    });
+}
+
+File StartupProfiler::saveTrace()
+{
+    auto &trace = getStartupTrace();
+
+    Array<var> traceEvents;
+
+    {
+        const SpinLock::ScopedLockType lock(trace.eventsLock);
+        for (const auto &event : trace.events)
+        {
+            DynamicObject::Ptr json(new DynamicObject());
+            json->setProperty("name", String(event.name));
+            json->setProperty("cat", "startup");
+            json->setProperty("ph", "X"); // a complete event, i.e. with duration
+            json->setProperty("ts", (event.startTimeMs - trace.startTimeMs) * 1000.0);
+            json->setProperty("dur", event.durationMs * 1000.0);
+            json->setProperty("pid", 1);
+            json->setProperty("tid", event.threadId);
+            traceEvents.add(var(json.get()));
+        }
+    }
+
+    DynamicObject::Ptr root(new DynamicObject());
+    root->setProperty("traceEvents", traceEvents);
+    root->setProperty("displayTimeUnit", "ms");
+
+    const auto traceFile = DocumentHelpers::getTempSlot(STARTUP_PROFILER_TRACE_FILE);
+    traceFile.replaceWithText(JSON::toString(var(root.get())));
+    return traceFile;
+}
+
+StartupProfiler::Scope::Scope(const char *name) noexcept :
+    name(name),
+    startTimeMs(isStartupProfilingEnabled ? Time::getMillisecondCounterHiRes() : 0.0) {}
+
+StartupProfiler::Scope::~Scope()
+{
+    if (!isStartupProfilingEnabled)
+    {
+        return;
+    }
+
+    const auto durationMs = Time::getMillisecondCounterHiRes() - this->startTimeMs;
+    const auto threadId = int64(pointer_sized_int(Thread::getCurrentThreadId()));
+
+    auto &trace = getStartupTrace();
+    const SpinLock::ScopedLockType lock(trace.eventsLock);
+    trace.events.add({ this->name, this->startTimeMs, durationMs, threadId });
+}
@@ -0,0 +1,58 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+/*
+    When the app is started with `--profile-startup [project file]`,
+    this records the timings of the startup phases, which are nested as
+    the scopes are, and saves them as a Chrome trace into the temp folder
+    (see chrome://tracing or https://ui.perfetto.dev).
+
+    In that mode, the app also opens the given project as soon as the
+    workspace is shown, and then quits, so that the cold start time
+    can be measured by scripts, e.g. to catch regressions.
+*/
+
+class StartupProfiler final
+{
+public:
+
+    static bool initWithCommandLine(const String &commandLine);
+    static bool isEnabled() noexcept;
+
+    static void runOpenProjectAndQuit();
+    static File saveTrace();
+
+    class Scope final
+    {
+    public:
+
+        explicit Scope(const char *name) noexcept;
+        ~Scope();
+
+    private:
+
+        const char *name;
+        const double startTimeMs;
+
+        JUCE_DECLARE_NON_COPYABLE(Scope)
+    };
+};
+
+#define STARTUP_PROFILER_SCOPE(name) \
+    const StartupProfiler::Scope JUCE_JOIN_MACRO(startupProfilerScope, __LINE__)(name)
@@ -0,0 +1,238 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Common.h"
+#include "TaskPool.h"
+
+#define TASK_POOL_IDLE_WAIT_MS (500)
+#define TASK_POOL_STOP_TIMEOUT_MS (5000)
+
+class TaskPool::Worker final : public Thread
+{
+public:
+
+    Worker(TaskPool &pool, int index) :
+        Thread("TaskPool worker " + String(index)),
+        pool(pool) {}
+
+    void run() override
+    {
+        while (!this->threadShouldExit())
+        {
+            Job job;
+            if (this->pool.takeJob(job))
+            {
+                this->pool.runJob(job);
+            }
+            else
+            {
+                this->pool.jobAdded.wait(TASK_POOL_IDLE_WAIT_MS);
+            }
+        }
+    }
+
+private:
+
+    TaskPool &pool;
+
+    JUCE_DECLARE_NON_COPYABLE(Worker)
+};
+
+//===----------------------------------------------------------------------===//
+// CancellationToken
+//===----------------------------------------------------------------------===//
+
+TaskPool::CancellationToken::CancellationToken() :
+    flag(new Flag()) {}
+
+void TaskPool::CancellationToken::cancel() noexcept
+{
+    this->flag->isCancelled = true;
+}
+
+bool TaskPool::CancellationToken::isCancelled() const noexcept
+{
+    return this->flag->isCancelled.get();
+}
+
+//===----------------------------------------------------------------------===//
+// TaskPool
+//===----------------------------------------------------------------------===//
+
+TaskPool::TaskPool(int numWorkers)
+{
+    for (int i = 0; i < jmax(1, numWorkers); ++i)
+    {
+        this->workers.add(new Worker(*this, i))->startThread();
+    }
+}
+
+TaskPool::~TaskPool()
+{
+    for (auto *worker : this->workers)
+    {
+        worker->signalThreadShouldExit();
+    }
+
+    // the pending jobs are just dropped, along with their continuations
+    {
+        const ScopedLock lock(this->queuesLock);
+        for (auto &queue : this->queues)
+        {
+            queue.clear();
+        }
+    }
+
+    for (auto *worker : this->workers)
+    {
+        this->jobAdded.signal();
+        worker->stopThread(TASK_POOL_STOP_TIMEOUT_MS);
+    }
+}
+
+int TaskPool::getNumWorkers() const noexcept
+{
+    return this->workers.size();
+}
+
+void TaskPool::run(Task task, Priority priority,
+    CancellationToken token, Task continuation)
+{
+    this->addJob({ std::move(task), std::move(continuation), token }, priority);
+}
+
+bool TaskPool::parallelFor(int numTasks, const Function<void(int)> &function,
+    CancellationToken token, Priority priority)
+{
+    if (numTasks <= 0)
+    {
+        return !token.isCancelled();
+    }
+
+    // the helper jobs may start after this has returned, so the state is shared,
+    // and they only touch the function after they've taken a valid index,
+    // which can't happen after all indices are done and this has returned
+    struct State final : ReferenceCountedObject
+    {
+        const Function<void(int)> *function = nullptr;
+        CancellationToken token;
+        int numTasks = 0;
+        Atomic<int> nextTask = 0;
+        Atomic<int> numTasksDone = 0;
+        WaitableEvent allTasksDone;
+
+        void runTasks()
+        {
+            for (;;)
+            {
+                const int i = (++this->nextTask) - 1;
+                if (i >= this->numTasks)
+                {
+                    return;
+                }
+
+                if (!this->token.isCancelled())
+                {
+                    (*this->function)(i);
+                }
+
+                if (++this->numTasksDone == this->numTasks)
+                {
+                    this->allTasksDone.signal();
+                }
+            }
+        }
+    };
+
+    ReferenceCountedObjectPtr<State> state(new State());
+    state->function = &function;
+    state->token = token;
+    state->numTasks = numTasks;
+
+    const int numHelpers = jmin(numTasks - 1, this->workers.size());
+    for (int i = 0; i < numHelpers; ++i)
+    {
+        this->addJob({ [state]() { state->runTasks(); }, nullptr, {} }, priority);
+    }
+
+    state->runTasks();
+    state->allTasksDone.wait();
+
+    return !token.isCancelled();
+}
+
+void TaskPool::addJob(Job &&job, Priority priority)
+{
+    {
+        const ScopedLock lock(this->queuesLock);
+        this->queues[int(priority)].add(std::move(job));
+    }
+
+    this->jobAdded.signal();
+}
+
+bool TaskPool::takeJob(Job &job)
+{
+    const ScopedLock lock(this->queuesLock);
+
+    bool hasTakenJob = false;
+    bool hasMoreJobs = false;
+
+    for (int i = numPriorities - 1; i >= 0; --i)
+    {
+        auto &queue = this->queues[i];
+        if (!hasTakenJob && !queue.isEmpty())
+        {
+            job = std::move(queue.getReference(0));
+            queue.remove(0);
+            hasTakenJob = true;
+        }
+
+        hasMoreJobs = hasMoreJobs || !queue.isEmpty();
+    }
+
+    // the event only wakes up one worker at a time
+    if (hasMoreJobs)
+    {
+        this->jobAdded.signal();
+    }
+
+    return hasTakenJob;
+}
+
+void TaskPool::runJob(Job &job)
+{
+    if (job.token.isCancelled())
+    {
+        return;
+    }
+
+    job.task();
+
+    if (job.continuation != nullptr && !job.token.isCancelled())
+    {
+        auto continuation = std::move(job.continuation);
+        auto token = job.token;
+        MessageManager::callAsync([continuation, token]()
+        {
+            if (!token.isCancelled())
+            {
+                continuation();
+            }
+        });
+    }
+}
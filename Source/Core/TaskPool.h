@@ -0,0 +1,105 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+/*
+    The app-wide worker threads for the CPU-bound work which can be split
+    into independent parts, e.g. parsing the sequences, importing the tracks
+    or diffing the tracked items, so that each of those doesn't start its own
+    threads every time (see App::Tasks).
+
+    The jobs are queued by priority. parallelFor runs the tasks on the calling
+    thread as well, taking the indices from the same counter as the workers,
+    so the busy workers never make it wait, the faster threads just take more
+    tasks, and the nested calls can't deadlock.
+*/
+
+class TaskPool final
+{
+public:
+
+    enum class Priority : int8
+    {
+        Background = 0,
+        Normal = 1,
+        High = 2
+    };
+
+    // Cheap to copy, shared by the tasks and whoever may want to cancel them
+    class CancellationToken final
+    {
+    public:
+
+        CancellationToken();
+
+        void cancel() noexcept;
+        bool isCancelled() const noexcept;
+
+    private:
+
+        struct Flag final : ReferenceCountedObject
+        {
+            Atomic<bool> isCancelled = false;
+        };
+
+        ReferenceCountedObjectPtr<Flag> flag;
+    };
+
+    using Task = Function<void()>;
+
+    explicit TaskPool(int numWorkers = SystemStats::getNumCpus() - 1);
+    ~TaskPool();
+
+    int getNumWorkers() const noexcept;
+
+    // Runs the task on a worker thread, then, unless the token gets cancelled,
+    // calls the continuation (if any) asynchronously on the message thread
+    void run(Task task, Priority priority = Priority::Normal,
+        CancellationToken token = {}, Task continuation = nullptr);
+
+    // Calls the function for each index in [0, numTasks) on the workers
+    // and on the calling thread, and returns when all of them are done;
+    // once the token is cancelled, the remaining indices are skipped,
+    // and it returns false
+    bool parallelFor(int numTasks, const Function<void(int)> &function,
+        CancellationToken token = {}, Priority priority = Priority::High);
+
+private:
+
+    struct Job final
+    {
+        Task task;
+        Task continuation;
+        CancellationToken token;
+    };
+
+    void addJob(Job &&job, Priority priority);
+    bool takeJob(Job &job);
+    void runJob(Job &job);
+
+    class Worker;
+    OwnedArray<Worker> workers;
+
+    static constexpr int numPriorities = 3;
+
+    CriticalSection queuesLock;
+    Array<Job> queues[numPriorities];
+    WaitableEvent jobAdded;
+
+    JUCE_DECLARE_NON_COPYABLE(TaskPool)
+};
@@ -362,6 +362,31 @@ void MidiTrackNode::dispatchPostRemoveEvent(MidiSequence *const layer)
     }
 }
 
+void MidiTrackNode::dispatchAddEvents(const Array<const MidiEvent *> &events)
+{
+    if (this->lastFoundParent != nullptr)
+    {
+        this->lastFoundParent->broadcastAddEvents(events);
+    }
+}
+
+void MidiTrackNode::dispatchChangeEvents(const Array<const MidiEvent *> &oldEvents,
+    const Array<const MidiEvent *> &newEvents)
+{
+    if (this->lastFoundParent != nullptr)
+    {
+        this->lastFoundParent->broadcastChangeEvents(oldEvents, newEvents);
+    }
+}
+
+void MidiTrackNode::dispatchRemoveEvents(const Array<const MidiEvent *> &events)
+{
+    if (this->lastFoundParent != nullptr)
+    {
+        this->lastFoundParent->broadcastRemoveEvents(events);
+    }
+}
+
 void MidiTrackNode::dispatchChangeTrackProperties()
 {
     if (this->lastFoundParent != nullptr)
@@ -437,6 +462,12 @@ void MidiTrackNode::onNodeAddedToTree(bool sendNotifications)
     const bool parentHasChanged = (this->lastFoundParent != newParent);
     this->lastFoundParent = newParent;
 
+    // the tracks order has changed, even if the parent project has not
+    if (newParent != nullptr)
+    {
+        newParent->invalidateTracksCache();
+    }
+
     if (parentHasChanged &&
         sendNotifications &&
         this->lastFoundParent != nullptr)
@@ -458,6 +489,7 @@ void MidiTrackNode::onNodeDeletedFromTree(bool sendNotifications)
 
         // Then disconnect from the tree
         this->removeNodeFromParent();
+        this->lastFoundParent->invalidateTracksCache();
         TrackGroupNode::removeAllEmptyGroupsInProject(this->lastFoundParent);
     }
 }
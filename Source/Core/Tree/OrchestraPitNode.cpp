@@ -54,6 +54,20 @@ void OrchestraPitNode::recreatePage()
     this->instrumentsPage = makeUnique<OrchestraPitPage>(App::Workspace().getPluginManager(), *this);
 }
 
+float OrchestraPitNode::getTotalProcessingLoad() const
+{
+    float result = 0.f;
+    for (const auto *instrumentNode : this->findChildrenOfType<InstrumentNode>())
+    {
+        if (auto *instrument = instrumentNode->getInstrument().get())
+        {
+            result += instrument->getProcessorPlayer().getProcessingLoad().bufferPercent;
+        }
+    }
+
+    return result;
+}
+
 //===----------------------------------------------------------------------===//
 // Menu
 //===----------------------------------------------------------------------===//
@@ -35,6 +35,10 @@ public:
     void showPage() override;
     void recreatePage() override;
 
+    // the sum of all instruments' average loads,
+    // in percent of the audio buffer duration
+    float getTotalProcessingLoad() const;
+
     //===------------------------------------------------------------------===//
     // Menu
     //===------------------------------------------------------------------===//
@@ -124,6 +124,17 @@ SerializedData PianoTrackNode::getDeltaData(int deltaIndex) const
     return {};
 }
 
+HashCode PianoTrackNode::getDeltaHash(int deltaIndex) const
+{
+    using namespace Serialization::VCS;
+    if (this->deltas[deltaIndex]->hasType(PianoSequenceDeltas::notesAdded))
+    {
+        return static_cast<PianoSequence *>(this->getSequence())->getNotesHash();
+    }
+
+    return 0;
+}
+
 VCS::DiffLogic *PianoTrackNode::getDiffLogic() const
 {
     return this->vcsDiffLogic.get();
@@ -196,7 +207,18 @@ void PianoTrackNode::deserialize(const SerializedData &data)
 
     forEachChildWithType(data, e, Serialization::Midi::track)
     {
-        this->sequence->deserialize(e);
+        auto *pianoSequence = static_cast<PianoSequence *>(this->sequence.get());
+
+        PianoSequence::ParsedNotes parsedNotes;
+        if (this->lastFoundParent != nullptr &&
+            this->lastFoundParent->takePreparsedNotes(e, parsedNotes))
+        {
+            pianoSequence->attachNotes(parsedNotes);
+        }
+        else
+        {
+            pianoSequence->deserialize(e);
+        }
     }
 
     forEachChildWithType(data, e, Serialization::Midi::pattern)
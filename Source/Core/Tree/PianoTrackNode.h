@@ -35,6 +35,7 @@ public:
     int getNumDeltas() const override;
     VCS::Delta *getDelta(int index) const override;
     SerializedData getDeltaData(int deltaIndex) const override;
+    HashCode getDeltaHash(int deltaIndex) const override;
     VCS::DiffLogic *getDiffLogic() const override;
     void resetStateTo(const VCS::TrackedItem &newState) override;
     
@@ -38,6 +38,26 @@ public:
     virtual void dispatchRemoveEvent(const MidiEvent &event) = 0;
     virtual void dispatchPostRemoveEvent(MidiSequence *const sequence) = 0;
 
+    // Batched versions for group edits, see ProjectListener::onAddMidiEvents
+    virtual void dispatchAddEvents(const Array<const MidiEvent *> &events)
+    {
+        for (const auto *event : events) { this->dispatchAddEvent(*event); }
+    }
+
+    virtual void dispatchChangeEvents(const Array<const MidiEvent *> &oldEvents,
+        const Array<const MidiEvent *> &newEvents)
+    {
+        for (int i = 0; i < oldEvents.size(); ++i)
+        {
+            this->dispatchChangeEvent(*oldEvents.getUnchecked(i), *newEvents.getUnchecked(i));
+        }
+    }
+
+    virtual void dispatchRemoveEvents(const Array<const MidiEvent *> &events)
+    {
+        for (const auto *event : events) { this->dispatchRemoveEvent(*event); }
+    }
+
     // Patterns and clips
     virtual void dispatchAddClip(const Clip &clip) = 0;
     virtual void dispatchChangeClip(const Clip &oldClip, const Clip &newClip) = 0;
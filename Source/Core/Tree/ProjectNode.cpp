@@ -37,12 +37,21 @@
 
 #include "AudioCore.h"
 #include "PlayerThread.h"
+#include "MidiRecorder.h"
 #include "Pattern.h"
 #include "MidiTrack.h"
 #include "MidiEvent.h"
+#include "MidiExportBuffer.h"
+#include "PianoSequence.h"
+#include "Note.h"
+#include "AutomationEvent.h"
+#include "AnnotationEvent.h"
+#include "TimeSignatureEvent.h"
+#include "KeySignatureEvent.h"
 #include "TrackedItem.h"
 #include "HybridRoll.h"
 #include "UndoStack.h"
+#include "UndoJournal.h"
 
 #include "ProjectMetadata.h"
 #include "ProjectTimeline.h"
@@ -60,6 +69,11 @@
 #include "SerializationKeys.h"
 #include "Config.h"
 #include "Icons.h"
+#include "TaskPool.h"
+
+// the undo journal keeps the unsaved changes safe,
+// so there's no need to re-save the whole project that often
+#define PROJECT_AUTOSAVE_IDLE_DELAY_MS (2 * 60 * 1000)
 
 ProjectNode::ProjectNode() :
     DocumentOwner({}, "helio"),
@@ -87,30 +101,77 @@ ProjectNode::ProjectNode(const File &existingFile) :
 void ProjectNode::initialize()
 {
     this->undoStack = makeUnique<UndoStack>(*this);
-    this->autosaver = makeUnique<Autosaver>(*this);
+    this->journal = makeUnique<UndoJournal>(*this);
+    this->undoStack->setJournal(this->journal.get());
+    this->autosaver = makeUnique<Autosaver>(*this, PROJECT_AUTOSAVE_IDLE_DELAY_MS);
 
     auto &orchestra = App::Workspace().getAudioCore();
     auto &audioCoreSleepTimer = App::Workspace().getAudioCore(); // yup, the same
-    this->transport = makeUnique<Transport>(orchestra, audioCoreSleepTimer);
+    const auto &audioClock = App::Workspace().getAudioCore().getClock();
+    auto &metronome = App::Workspace().getAudioCore().getMetronome();
+    auto &syncOutput = App::Workspace().getAudioCore().getSyncOutput();
+    auto &audioRecorder = App::Workspace().getAudioCore().getAudioRecorder();
+    this->transport = makeUnique<Transport>(orchestra, audioCoreSleepTimer,
+        audioClock, metronome, syncOutput, audioRecorder);
     this->addListener(this->transport.get());
 
+    this->recorder = makeUnique<MidiRecorder>(*this->transport,
+        App::Workspace().getAudioCore().getDevice());
+
     this->metadata = makeUnique<ProjectMetadata>(*this);
     this->vcsItems.add(this->metadata.get());
 
     this->timeline = makeUnique<ProjectTimeline>(*this, "Project Timeline");
     this->vcsItems.add(this->timeline.get());
 
+    this->transport->setTimeSignaturesTrack(this->timeline->getTimeSignatures());
     this->transport->seekToPosition(0.0);
 
     this->consoleTimelineEvents = makeUnique<CommandPaletteTimelineEvents>(*this);
 
-    this->recreatePage();
+    this->memoryAccounts.add(new MemoryBudget::Account("Project events",
+        [this](int &numItems, int64 &numBytes)
+        {
+            this->getEventsMemoryUsage(numItems, numBytes);
+        }));
+
+    this->memoryAccounts.add(new MemoryBudget::Account("Undo history",
+        [this](int &numItems, int64 &numBytes)
+        {
+            numItems += this->undoStack->getNumTransactions();
+            numBytes += this->undoStack->getTotalSize();
+        }));
+
+    this->memoryAccounts.add(new MemoryBudget::Account("Playback cache",
+        [this](int &numItems, int64 &numBytes)
+        {
+            this->transport->getPlaybackCache().getCachedMessagesUsage(numItems, numBytes);
+        }));
+
+    // nothing is ever shown in the headless modes,
+    // so the project starts suspended, without any pages
+    if (App::isHeadless())
+    {
+        this->suspended = true;
+    }
+    else
+    {
+        this->recreatePage();
+    }
 }
 
 ProjectNode::~ProjectNode()
 {
+    this->memoryAccounts.clear();
+
+    // the unfinished take is committed before saving
+    this->recorder = nullptr;
+
     this->getDocument()->save();
 
+    this->journal->close();
+    this->undoStack->setJournal(nullptr);
+
     this->transport->stopPlayback();
     this->transport->stopRender();
 
@@ -122,6 +183,7 @@ ProjectNode::~ProjectNode()
     this->removeAllListeners();
     this->sequencerLayout = nullptr;
 
+    this->transport->setTimeSignaturesTrack(nullptr);
     this->timeline = nullptr;
     this->metadata = nullptr;
 
@@ -158,6 +220,12 @@ Transport &ProjectNode::getTransport() const noexcept
     return (*this->transport);
 }
 
+MidiRecorder &ProjectNode::getMidiRecorder() const noexcept
+{
+    jassert(this->recorder);
+    return (*this->recorder);
+}
+
 ProjectMetadata *ProjectNode::getProjectInfo() const noexcept
 {
     jassert(this->metadata);
@@ -177,6 +245,11 @@ HybridRollEditMode &ProjectNode::getEditMode() noexcept
 
 HybridRoll *ProjectNode::getLastFocusedRoll() const
 {
+    if (this->suspended)
+    {
+        return nullptr;
+    }
+
     return this->sequencerLayout->getRoll();
 }
 
@@ -187,6 +260,7 @@ Image ProjectNode::getIcon() const noexcept
 
 void ProjectNode::showPage()
 {
+    App::Workspace().setActiveProject(*this);
     this->projectPage->updateContent();
     App::Layout().showPage(this->projectPage.get(), this);
 }
@@ -216,11 +290,21 @@ void ProjectNode::safeRename(const String &newName, bool sendNotifications)
 
 void ProjectNode::recreatePage()
 {
+    if (this->suspended)
+    {
+        return; // will be re-created on resume
+    }
+
     SerializedData layoutState(Serialization::UI::sequencer);
     if (this->sequencerLayout || this->projectPage)
     {
         layoutState = this->sequencerLayout->serialize();
     }
+    else if (this->suspendedLayoutState.isValid())
+    {
+        layoutState = this->suspendedLayoutState;
+        this->suspendedLayoutState = {};
+    }
     
     this->sequencerLayout = makeUnique<SequencerLayout>(*this);
     this->projectPage = makeUnique<ProjectPage>(*this);
@@ -238,6 +322,7 @@ void ProjectNode::recreatePage()
 void ProjectNode::showPatternEditor(WeakReference<TreeNode> source)
 {
     jassert(source != nullptr);
+    App::Workspace().setActiveProject(*this);
     this->sequencerLayout->showPatternEditor();
     App::Layout().showPage(this->sequencerLayout.get(), source);
 }
@@ -267,6 +352,7 @@ void ProjectNode::showLinearEditor(WeakReference<MidiTrack> activeTrack,
 
     if (auto *pianoTrack = dynamic_cast<PianoTrackNode *>(activeTrack.get()))
     {
+        App::Workspace().setActiveProject(*this);
         this->sequencerLayout->showLinearEditor(activeTrack);
         this->lastShownTrack = source;
         App::Layout().showPage(this->sequencerLayout.get(), source);
@@ -275,7 +361,10 @@ void ProjectNode::showLinearEditor(WeakReference<MidiTrack> activeTrack,
 
 void ProjectNode::switchMiniMaps()
 {
-    this->sequencerLayout->switchMiniMaps();
+    if (!this->suspended)
+    {
+        this->sequencerLayout->switchMiniMaps();
+    }
 }
 
 WeakReference<TreeNode> ProjectNode::getLastShownTrack() const noexcept
@@ -283,6 +372,47 @@ WeakReference<TreeNode> ProjectNode::getLastShownTrack() const noexcept
     return this->lastShownTrack;
 }
 
+bool ProjectNode::suspend()
+{
+    if (this->suspended)
+    {
+        return true;
+    }
+
+    if (this->transport->isPlaying() ||
+        this->transport->isRendering() ||
+        this->recorder->isRecording())
+    {
+        return false;
+    }
+
+    this->suspendedLayoutState = this->sequencerLayout->serialize();
+
+    this->projectPage = nullptr;
+    this->sequencerLayout = nullptr;
+
+    this->transport->suspend();
+    this->suspended = true;
+    return true;
+}
+
+void ProjectNode::resume()
+{
+    if (!this->suspended)
+    {
+        return;
+    }
+
+    this->suspended = false;
+    this->transport->resume();
+    this->recreatePage();
+}
+
+bool ProjectNode::isSuspended() const noexcept
+{
+    return this->suspended;
+}
+
 //===----------------------------------------------------------------------===//
 // Menu
 //===----------------------------------------------------------------------===//
@@ -354,17 +484,53 @@ void ProjectNode::removeTrack(const MidiTrack &track)
 Array<MidiTrack *> ProjectNode::getTracks() const
 {
     const ScopedReadLock lock(this->tracksListLock);
-    Array<MidiTrack *> tracks;
+    this->rebuildTracksRefsCacheIfNeeded();
+    return this->tracksListCache;
+}
 
-    // now get all layers inside a tree hierarchy
-    this->collectTracks(tracks);
-    
-    // and explicitly add the only non-tree-owned tracks
+static size_t getEventSize(MidiEvent::Type type) noexcept
+{
+    switch (type)
+    {
+        case MidiEvent::Type::Note: return sizeof(Note);
+        case MidiEvent::Type::Auto: return sizeof(AutomationEvent);
+        case MidiEvent::Type::Annotation: return sizeof(AnnotationEvent);
+        case MidiEvent::Type::TimeSignature: return sizeof(TimeSignatureEvent);
+        case MidiEvent::Type::KeySignature: return sizeof(KeySignatureEvent);
+        default: return sizeof(MidiEvent);
+    }
+}
+
+void ProjectNode::getEventsMemoryUsage(int &numEvents, int64 &numBytes) const
+{
+    auto tracks = this->getTracks();
     tracks.add(this->timeline->getAnnotations());
-    tracks.add(this->timeline->getKeySignatures());
     tracks.add(this->timeline->getTimeSignatures());
+    tracks.add(this->timeline->getKeySignatures());
+
+    for (const auto *track : tracks)
+    {
+        // all events of a sequence have the same type and are stored by pointers;
+        // the strings they refer to, like the annotations' texts, are not counted
+        const auto *sequence = track->getSequence();
+        if (sequence != nullptr && sequence->size() > 0)
+        {
+            const auto eventSize = getEventSize(sequence->getUnchecked(0)->getType());
+            numEvents += sequence->size();
+            numBytes += int64(sequence->size()) * (eventSize + sizeof(MidiEvent *));
+        }
+    }
+}
+
+void ProjectNode::invalidateTracksCache() noexcept
+{
+    this->isTracksCacheOutdated = true;
+    this->tracksVersion++;
+}
 
-    return tracks;
+int ProjectNode::getTracksVersion() const noexcept
+{
+    return this->tracksVersion;
 }
 
 void ProjectNode::collectTracks(Array<MidiTrack *> &resultArray, bool onlySelected /*= false*/) const
@@ -477,13 +643,93 @@ SerializedData ProjectNode::save() const
     tree.appendChild(this->timeline->serialize());
     tree.appendChild(this->undoStack->serialize());
     tree.appendChild(this->transport->serialize());
-    tree.appendChild(this->sequencerLayout->serialize());
+    if (!this->suspended)
+    {
+        tree.appendChild(this->sequencerLayout->serialize());
+    }
+    else if (this->suspendedLayoutState.isValid())
+    {
+        tree.appendChild(this->suspendedLayoutState.createCopy());
+    }
 
     TreeNodeSerializer::serializeChildren(*this, tree);
 
     return tree;
 }
 
+SerializedData ProjectNode::serializeDocument() const
+{
+    return this->save();
+}
+
+void ProjectNode::deserializeDocument(const SerializedData &tree)
+{
+    this->load(tree);
+}
+
+struct ProjectNode::PreparsedSequence final
+{
+    SerializedData data;
+    PianoSequence::ParsedNotes notes;
+};
+
+static void collectPianoSequences(const SerializedData &node, Array<SerializedData> &result)
+{
+    using namespace Serialization;
+    forEachChildWithType(node, child, Core::treeNode)
+    {
+        if (Identifier(child.getProperty(Core::treeNodeType)) == Core::pianoTrack)
+        {
+            forEachChildWithType(child, sequence, Midi::track)
+            {
+                result.add(sequence);
+            }
+        }
+
+        collectPianoSequences(child, result);
+    }
+}
+
+// The notes are the bulk of any project, and the tracks are independent,
+// so all of them are parsed and sorted in parallel, and then the tracks,
+// being deserialized on this thread one by one, just take the results
+void ProjectNode::preparseSequences(const SerializedData &root)
+{
+    Array<SerializedData> sequences;
+    collectPianoSequences(root, sequences);
+
+    this->preparsedSequences.clear();
+    for (const auto &sequence : sequences)
+    {
+        this->preparsedSequences.add(new PreparsedSequence())->data = sequence;
+    }
+
+    const auto parseSequence = [this](int i)
+    {
+        auto *sequence = this->preparsedSequences.getUnchecked(i);
+        PianoSequence::parseNotes(sequence->data, sequence->notes);
+    };
+
+    App::Tasks().parallelFor(this->preparsedSequences.size(), parseSequence);
+}
+
+bool ProjectNode::takePreparsedNotes(const SerializedData &sequenceData,
+    PianoSequence::ParsedNotes &result)
+{
+    for (auto *sequence : this->preparsedSequences)
+    {
+        if (sequence->data == sequenceData)
+        {
+            result.notes.swapWith(sequence->notes.notes);
+            result.ids.swap(sequence->notes.ids);
+            this->preparsedSequences.removeObject(sequence);
+            return true;
+        }
+    }
+
+    return false;
+}
+
 void ProjectNode::load(const SerializedData &tree)
 {
     this->reset();
@@ -498,8 +744,11 @@ void ProjectNode::load(const SerializedData &tree)
     this->metadata->deserialize(root);
     this->timeline->deserialize(root);
 
-    // Proceed with basic properties and children
+    // Proceed with basic properties and children,
+    // the tracks will pick up their notes parsed beforehand
+    this->preparseSequences(root);
     TreeNode::deserialize(root);
+    this->preparsedSequences.clear();
 
     // Legacy support: if no pattern set manager found, create one
     if (nullptr == this->findChildOfType<PatternEditorNode>())
@@ -525,7 +774,18 @@ void ProjectNode::load(const SerializedData &tree)
 
     // At least, when all tracks are ready:
     this->transport->deserialize(root);
-    this->sequencerLayout->deserialize(root);
+
+    if (this->suspended)
+    {
+        this->suspendedLayoutState = root.getChildWithName(Serialization::UI::sequencer);
+    }
+    else
+    {
+        this->sequencerLayout->deserialize(root);
+    }
+
+    // and finally, re-apply the changes made after the last save, if any
+    this->journal->recover(int64(root.getProperty(Serialization::Undo::journalCheckpoint, 0)));
 }
 
 void ProjectNode::importMidi(const File &file)
@@ -539,48 +799,82 @@ void ProjectNode::importMidi(const File &file)
         return;
     }
 
+    this->importMidi(tempFile);
+    this->getDocument()->save();
+}
+
+void ProjectNode::importMidi(const MidiFile &tempFile)
+{
     Random r;
     const auto colours = MenuPanel::getColoursList().getAllValues();
     const auto timeFormat = tempFile.getTimeFormat();
 
-    this->timeline->reset();
-
-    for (int i = 0; i < tempFile.getNumTracks(); i++)
+    // the tracks are independent, so they are scanned and their notes
+    // are paired on worker threads; the tree is only built afterwards:
+    struct ImportedTrack final
     {
-        const auto *importedTrack = tempFile.getTrack(i);
-
+        String name;
         bool hasPianoEvents = false;
         bool hasControllerEvents = false;
-        int trackControllerNumber = 0;
-        String trackName = "Track " + String(i);
+        int controllerNumber = 0;
+        Array<PianoSequence::ImportedNote> notes;
+    };
 
-        const int ci = r.nextInt(colours.size()); // set some random colour
-        const Colour colour = Colour::fromString(colours[ci]);
+    OwnedArray<ImportedTrack> importedTracks;
+    for (int i = 0; i < tempFile.getNumTracks(); i++)
+    {
+        importedTracks.add(new ImportedTrack())->name = "Track " + String(i);
+    }
+
+    const auto parseTrack = [&tempFile, &importedTracks, timeFormat](int i)
+    {
+        const auto *importedTrack = tempFile.getTrack(i);
+        auto *result = importedTracks.getUnchecked(i);
 
         for (int j = 0; j < importedTrack->getNumEvents(); ++j)
         {
             const auto *event = importedTrack->getEventPointer(j);
             if (event->message.isTrackNameEvent())
             {
-                trackName = event->message.getTextFromTextMetaEvent();
+                result->name = event->message.getTextFromTextMetaEvent();
             }
             else if (event->message.isController())
             {
-                trackControllerNumber = event->message.getControllerNumber();
-                hasControllerEvents = true;
+                result->controllerNumber = event->message.getControllerNumber();
+                result->hasControllerEvents = true;
             }
             else if (event->message.isTempoMetaEvent())
             {
-                trackControllerNumber = MidiTrack::tempoController;
-                hasControllerEvents = true;
+                result->controllerNumber = MidiTrack::tempoController;
+                result->hasControllerEvents = true;
             }
             else if (event->message.isNoteOnOrOff())
             {
-                hasPianoEvents = true;
+                result->hasPianoEvents = true;
             }
         }
 
-        if (hasControllerEvents)
+        if (result->hasPianoEvents)
+        {
+            PianoSequence::parseMidi(*importedTrack, timeFormat, result->notes);
+        }
+    };
+
+    App::Tasks().parallelFor(tempFile.getNumTracks(), parseTrack);
+
+    this->timeline->reset();
+
+    for (int i = 0; i < tempFile.getNumTracks(); i++)
+    {
+        const auto *importedTrack = tempFile.getTrack(i);
+        const auto *parsedTrack = importedTracks.getUnchecked(i);
+        const auto &trackName = parsedTrack->name;
+        const int trackControllerNumber = parsedTrack->controllerNumber;
+
+        const int ci = r.nextInt(colours.size()); // set some random colour
+        const Colour colour = Colour::fromString(colours[ci]);
+
+        if (parsedTrack->hasControllerEvents)
         {
             const String controllerName = trackControllerNumber == MidiTrack::tempoController ?
                 "Tempo" : MidiMessage::getControllerName(trackControllerNumber);
@@ -597,7 +891,7 @@ void ProjectNode::importMidi(const File &file)
             trackNode->getSequence()->importMidi(*importedTrack, timeFormat);
         }
 
-        if (hasPianoEvents)
+        if (parsedTrack->hasPianoEvents)
         {
             MidiTrackNode *trackNode = new PianoTrackNode(trackName);
 
@@ -607,7 +901,7 @@ void ProjectNode::importMidi(const File &file)
             this->addChildNode(trackNode, -1, false);
 
             trackNode->setTrackColour(colour, dontSendNotification);
-            trackNode->getSequence()->importMidi(*importedTrack, timeFormat);
+            static_cast<PianoSequence *>(trackNode->getSequence())->importNotes(parsedTrack->notes);
         }
 
         // if the track contains any key/time signatures, try importing them all,
@@ -618,12 +912,10 @@ void ProjectNode::importMidi(const File &file)
         this->timeline->getTimeSignatures()->getSequence()->importMidi(*importedTrack, timeFormat);
     }
     
-    this->isTracksCacheOutdated = true;
+    this->invalidateTracksCache();
     this->broadcastReloadProjectContent();
     const auto range = this->broadcastChangeProjectBeatRange();
     this->broadcastChangeViewBeatRange(range.getX(), range.getY());
-
-    this->getDocument()->save();
 }
 
 //===----------------------------------------------------------------------===//
@@ -681,9 +973,29 @@ void ProjectNode::broadcastPostRemoveEvent(MidiSequence *const layer)
     this->sendChangeMessage();
 }
 
+void ProjectNode::broadcastAddEvents(const Array<const MidiEvent *> &events)
+{
+    this->changeListeners.call(&ProjectListener::onAddMidiEvents, events);
+    this->sendChangeMessage();
+}
+
+void ProjectNode::broadcastChangeEvents(const Array<const MidiEvent *> &oldEvents,
+    const Array<const MidiEvent *> &newEvents)
+{
+    jassert(oldEvents.size() == newEvents.size());
+    this->changeListeners.call(&ProjectListener::onChangeMidiEvents, oldEvents, newEvents);
+    this->sendChangeMessage();
+}
+
+void ProjectNode::broadcastRemoveEvents(const Array<const MidiEvent *> &events)
+{
+    this->changeListeners.call(&ProjectListener::onRemoveMidiEvents, events);
+    this->sendChangeMessage();
+}
+
 void ProjectNode::broadcastAddTrack(MidiTrack *const track)
 {
-    this->isTracksCacheOutdated = true;
+    this->invalidateTracksCache();
 
     if (auto *tracked = dynamic_cast<VCS::TrackedItem *>(track))
     {
@@ -697,7 +1009,7 @@ void ProjectNode::broadcastAddTrack(MidiTrack *const track)
 
 void ProjectNode::broadcastRemoveTrack(MidiTrack *const track)
 {
-    this->isTracksCacheOutdated = true;
+    this->invalidateTracksCache();
 
     if (auto *tracked = dynamic_cast<VCS::TrackedItem *>(track))
     {
@@ -749,6 +1061,7 @@ void ProjectNode::broadcastChangeProjectInfo(const ProjectMetadata *info)
 {
     this->changeListeners.call(&ProjectListener::onChangeProjectInfo, info);
     this->sendChangeMessage();
+    this->journal->onUnjournaledChange();
 }
 
 Point<float> ProjectNode::broadcastChangeProjectBeatRange()
@@ -779,6 +1092,7 @@ void ProjectNode::broadcastReloadProjectContent()
 {
     this->changeListeners.call(&ProjectListener::onReloadProjectContent, this->getTracks());
     this->sendChangeMessage();
+    this->journal->onUnjournaledChange();
 }
 
 void ProjectNode::broadcastChangeViewBeatRange(float firstBeat, float lastBeat)
@@ -795,7 +1109,12 @@ bool ProjectNode::onDocumentLoad(File &file)
 {
     if (file.existsAsFile())
     {
-        const auto tree = DocumentHelpers::load(file);
+        auto tree = App::Workspace().takeWarmedUpProject(file);
+        if (!tree.isValid())
+        {
+            tree = DocumentHelpers::load(file);
+        }
+
         if (tree.isValid())
         {
             this->load(tree);
@@ -811,15 +1130,79 @@ void ProjectNode::onDocumentDidLoad(File &file)
     App::Workspace().getUserProfile()
         .onProjectLocalInfoUpdated(this->getId(), this->getName(),
             this->getDocument()->getFullPath());
+
+    this->updateRecentProjectStats(file);
+}
+
+void ProjectNode::onDocumentDidSave(File &file)
+{
+    this->updateRecentProjectStats(file);
+}
+
+void ProjectNode::updateRecentProjectStats(const File &file) const
+{
+    const auto trackNodes = this->findChildrenOfType<MidiTrackNode>();
+
+    int numEvents = 0;
+    for (const auto *trackNode : trackNodes)
+    {
+        numEvents += trackNode->getSequence()->size();
+    }
+
+    App::Workspace().getUserProfile().onProjectLocalStatsUpdated(this->getId(),
+        trackNodes.size(), numEvents, file.getSize());
 }
 
 bool ProjectNode::onDocumentSave(File &file)
 {
-    const auto projectNode(this->save());
+    auto projectNode(this->save());
+    const auto checkpointId = this->journal->beginCheckpoint();
+    projectNode.setProperty(Serialization::Undo::journalCheckpoint, checkpointId);
 #if DEBUG
     DocumentHelpers::save<XmlSerializer>(file.withFileExtension("xml"), projectNode);
 #endif
-    return DocumentHelpers::save<BinarySerializer>(file, projectNode);
+    if (DocumentHelpers::save<BinarySerializer>(file, projectNode))
+    {
+        this->journal->onCheckpointSaved(checkpointId);
+        return true;
+    }
+
+    return false;
+}
+
+// the tree is a structural copy of the project, which is all
+// the message thread needs to do, encoding and writing are done in background
+bool ProjectNode::onDocumentSaveInBackground(const File &file,
+    Function<void(bool savedOk)> callback)
+{
+    auto projectNode(this->save());
+    const auto checkpointId = this->journal->beginCheckpoint();
+    projectNode.setProperty(Serialization::Undo::journalCheckpoint, checkpointId);
+#if DEBUG
+    DocumentHelpers::saveInBackground<XmlSerializer>(file.withFileExtension("xml"), projectNode, nullptr);
+#endif
+    WeakReference<UndoJournal> journal(this->journal.get());
+    DocumentHelpers::saveInBackground<BinarySerializer>(file, projectNode,
+        [journal, checkpointId, callback](bool savedOk)
+    {
+        if (savedOk && journal != nullptr)
+        {
+            journal->onCheckpointSaved(checkpointId);
+        }
+
+        if (callback != nullptr)
+        {
+            callback(savedOk);
+        }
+    });
+    return true;
+}
+
+// the playback cache and the recorder both read the tracks,
+// so snapshotting them meanwhile would only make it worse
+bool ProjectNode::shouldDeferAutosave() const
+{
+    return this->transport->isPlaying();
 }
 
 void ProjectNode::onDocumentImport(File &file)
@@ -843,43 +1226,91 @@ bool ProjectNode::onDocumentExport(File &file)
 
 void ProjectNode::exportMidi(File &file) const
 {
-    MidiFile tempFile;
     static const double midiClock = 960.0;
-    tempFile.setTicksPerQuarterNote(int(midiClock));
     static Clip noTransform;
 
     // Solo flags won't be taken into account
     // in midi export, as I believe they shouldn't:
     const bool soloFlag = false;
 
+    // the sequences can only be read on the message thread (they have lazy caches),
+    // so the piano tracks are exported from their snapshots on the worker threads,
+    // and the rest are collected here; then each track is sorted and encoded
+    // into its chunk in parallel, freeing its buffer as soon as it's done
+    struct TrackExport final
+    {
+        MidiExportBuffer buffer;
+        PianoSequence::Snapshot::Ptr notes;
+        Array<Clip> clips;
+    };
+
     const auto &tracks = this->getTracks();
+    OwnedArray<TrackExport> exports;
     for (const auto *track : tracks)
     {
-        MidiMessageSequence sequence;
         // todo add more meta events like track name
 
-        if (track->getPattern() != nullptr)
+        auto *trackExport = exports.add(new TrackExport());
+        const auto *pattern = track->getPattern();
+        const int numClips = pattern != nullptr ? pattern->size() : 1;
+        trackExport->buffer.ensureStorageAllocated(track->getSequence()->size() * numClips * 2);
+
+        if (auto *pianoSequence = dynamic_cast<PianoSequence *>(track->getSequence()))
         {
-            for (const auto *clip : track->getPattern()->getClips())
+            trackExport->notes = pianoSequence->getSnapshot();
+            if (pattern != nullptr)
+            {
+                for (const auto *clip : pattern->getClips())
+                {
+                    trackExport->clips.add(*clip);
+                }
+            }
+            else
             {
-                track->getSequence()->exportMidi(sequence, *clip, soloFlag, 0.0, midiClock);
+                trackExport->clips.add(noTransform);
+            }
+        }
+        else if (pattern != nullptr)
+        {
+            for (const auto *clip : pattern->getClips())
+            {
+                track->getSequence()->exportMidi(trackExport->buffer, *clip, soloFlag, 0.0, midiClock);
             }
         }
         else
         {
-            track->getSequence()->exportMidi(sequence, noTransform, soloFlag, 0.0, midiClock);
+            track->getSequence()->exportMidi(trackExport->buffer, noTransform, soloFlag, 0.0, midiClock);
         }
-
-        tempFile.addTrack(sequence);
     }
-    
+
+    Array<MemoryBlock> chunks;
+    chunks.resize(exports.size());
+    App::Tasks().parallelFor(exports.size(), [&](int i)
+    {
+        auto *trackExport = exports.getUnchecked(i);
+        if (trackExport->notes != nullptr)
+        {
+            for (const auto &clip : trackExport->clips)
+            {
+                trackExport->notes->exportMidi(trackExport->buffer, clip, soloFlag, 0.0, midiClock);
+            }
+        }
+
+        MemoryOutputStream chunk(chunks.getReference(i), false);
+        trackExport->buffer.writeTrackChunk(chunk);
+    });
+
     if (file.exists())
     {
         file.deleteFile();
     }
 
-    UniquePointer<OutputStream> out(new FileOutputStream(file));
-    tempFile.writeTo(*out);
+    FileOutputStream out(file);
+    MidiExportBuffer::writeHeaderChunk(out, chunks.size(), int(midiClock));
+    for (const auto &chunk : chunks)
+    {
+        out.write(chunk.getData(), chunk.getSize());
+    }
 }
 
 //===----------------------------------------------------------------------===//
@@ -889,13 +1320,13 @@ void ProjectNode::exportMidi(File &file) const
 MidiTrack *ProjectNode::getTrackById(const String &trackId)
 {
     this->rebuildTracksRefsCacheIfNeeded();
-    return this->tracksRefsCache[trackId].get();
+    const auto found = this->tracksRefsCache.find(trackId);
+    return found != this->tracksRefsCache.end() ? found->second.get() : nullptr;
 }
 
 Pattern *ProjectNode::getPatternByTrackId(const String &trackId)
 {
-    this->rebuildTracksRefsCacheIfNeeded();
-    if (auto track = this->tracksRefsCache[trackId].get())
+    if (auto *track = this->getTrackById(trackId))
     {
         return track->getPattern();
     }
@@ -905,8 +1336,7 @@ Pattern *ProjectNode::getPatternByTrackId(const String &trackId)
 
 MidiSequence *ProjectNode::getSequenceByTrackId(const String &trackId)
 {
-    this->rebuildTracksRefsCacheIfNeeded();
-    if (auto track = this->tracksRefsCache[trackId].get())
+    if (auto *track = this->getTrackById(trackId))
     {
         return track->getSequence();
     }
@@ -949,7 +1379,7 @@ VCS::TrackedItem *ProjectNode::initTrackedItem(const Identifier &type,
         track->setVCSUuid(id);
         this->addChildNode(track, -1, false);
         // add explicitly, since we aren't going to receive a notification:
-        this->isTracksCacheOutdated = true;
+        this->invalidateTracksCache();
         this->vcsItems.addIfNotAlreadyThere(track);
         track->resetStateTo(newState);
         return track;
@@ -959,7 +1389,7 @@ VCS::TrackedItem *ProjectNode::initTrackedItem(const Identifier &type,
         auto *track = new AutomationTrackNode("");
         track->setVCSUuid(id);
         this->addChildNode(track, -1, false);
-        this->isTracksCacheOutdated = true;
+        this->invalidateTracksCache();
         this->vcsItems.addIfNotAlreadyThere(track);
         track->resetStateTo(newState);
         return track;
@@ -986,13 +1416,20 @@ bool ProjectNode::deleteTrackedItem(VCS::TrackedItem *item)
     {
         TreeNode::deleteNode(treeItem, false); // don't broadcastRemoveTrack
         this->vcsItems.removeAllInstancesOf(item);
-        this->isTracksCacheOutdated = true;
+        this->invalidateTracksCache();
         return true;
     }
 
     return false;
 }
 
+// the checkouts and resets replace the tracks' contents,
+// so whatever is not saved yet is saved before that
+void ProjectNode::onBeforeResetState()
+{
+    this->getDocument()->save();
+}
+
 void ProjectNode::onResetState()
 {
     this->broadcastReloadProjectContent();
@@ -1025,6 +1462,7 @@ void ProjectNode::changeListenerCallback(ChangeBroadcaster *source)
     if (auto *vcs = dynamic_cast<VersionControl *>(source))
     {
         DocumentOwner::sendChangeMessage();
+        this->journal->onUnjournaledChange();
         // still not sure if it's really needed after commit:
         //this->getDocument()->forceSave();
     }
@@ -1034,25 +1472,22 @@ void ProjectNode::rebuildTracksRefsCacheIfNeeded() const
 {
     if (this->isTracksCacheOutdated)
     {
-        this->tracksRefsCache.clear();
+        this->tracksListCache.clearQuick();
 
-        this->tracksRefsCache[this->timeline->getAnnotations()->getTrackId()] =
-            this->timeline->getAnnotations();
+        // first get all tracks inside a tree hierarchy,
+        this->collectTracks(this->tracksListCache);
 
-        this->tracksRefsCache[this->timeline->getKeySignatures()->getTrackId()] =
-            this->timeline->getKeySignatures();
+        // and explicitly add the only non-tree-owned tracks
+        this->tracksListCache.add(this->timeline->getAnnotations());
+        this->tracksListCache.add(this->timeline->getKeySignatures());
+        this->tracksListCache.add(this->timeline->getTimeSignatures());
 
-        this->tracksRefsCache[this->timeline->getTimeSignatures()->getTrackId()] =
-            this->timeline->getTimeSignatures();
-        
-        const Array<MidiTrack *> children = this->findChildrenOfType<MidiTrack>();
-        
-        for (int i = 0; i < children.size(); ++i)
+        this->tracksRefsCache.clear();
+        for (auto *track : this->tracksListCache)
         {
-            MidiTrack *const track = children.getUnchecked(i);
             this->tracksRefsCache[track->getTrackId()] = track;
         }
-        
+
         this->isTracksCacheOutdated = false;
     }
 }
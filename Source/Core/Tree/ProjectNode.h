@@ -27,10 +27,12 @@ class ProjectPage;
 class Origami;
 class TrackMap;
 class Transport;
+class MidiRecorder;
 class ProjectMetadata;
 class ProjectTimeline;
 class CommandPaletteTimelineEvents;
 class UndoStack;
+class UndoJournal;
 class Pattern;
 class MidiTrack;
 class Clip;
@@ -42,8 +44,10 @@ class Clip;
 #include "ProjectSequencesWrapper.h"
 #include "HybridRollEditMode.h"
 #include "MidiSequence.h"
+#include "PianoSequence.h"
 #include "MidiTrackSource.h"
 #include "CommandPaletteModel.h"
+#include "MemoryBudget.h"
 
 class ProjectNode final :
     public TreeNode,
@@ -64,12 +68,14 @@ public:
     String getStats() const;
 
     Transport &getTransport() const noexcept;
+    MidiRecorder &getMidiRecorder() const noexcept;
     ProjectMetadata *getProjectInfo() const noexcept;
     ProjectTimeline *getTimeline() const noexcept;
     HybridRollEditMode &getEditMode() noexcept;
     HybridRoll *getLastFocusedRoll() const;
     
     void importMidi(const File &file);
+    void importMidi(const MidiFile &midiFile); // doesn't save the document
     void exportMidi(File &file) const;
 
     Image getIcon() const noexcept override;
@@ -87,6 +93,14 @@ public:
     void setEditableScope(MidiTrack *const activeTrack,
         const Clip &activeClip, bool shouldFocusToArea = false);
 
+    // A background project keeps only its model: the pages, the rolls
+    // and the playback cache are dropped, and are rebuilt when any of
+    // its editors is shown again; returns false if it's busy playing,
+    // recording or rendering, and can't be suspended right now
+    bool suspend();
+    void resume();
+    bool isSuspended() const noexcept;
+
     //===------------------------------------------------------------------===//
     // Menu
     //===------------------------------------------------------------------===//
@@ -110,6 +124,13 @@ public:
     //===------------------------------------------------------------------===//
 
     Array<MidiTrack *> getTracks() const;
+
+    // the tracks list and lookups are cached until the tracks are
+    // added, removed or moved around; the version is increased each time,
+    // so that others can also cache whatever they build from the tracks
+    void invalidateTracksCache() noexcept;
+    int getTracksVersion() const noexcept;
+
     Point<float> getProjectRangeInBeats() const;
     StringArray getAllTrackNames() const;
 
@@ -121,6 +142,16 @@ public:
     void deserialize(const SerializedData &data) override;
     void reset() override;
 
+    // the project's own data, as it is stored in its document, for the
+    // headless conversions which read and write the files by themselves
+    SerializedData serializeDocument() const;
+    void deserializeDocument(const SerializedData &tree);
+
+    // while loading, the piano tracks take their notes parsed beforehand
+    // in parallel, if there are any for their data, see ProjectNode::load
+    bool takePreparsedNotes(const SerializedData &sequenceData,
+        PianoSequence::ParsedNotes &result);
+
     //===------------------------------------------------------------------===//
     // Project listeners
     //===------------------------------------------------------------------===//
@@ -138,6 +169,11 @@ public:
     void broadcastRemoveEvent(const MidiEvent &event);
     void broadcastPostRemoveEvent(MidiSequence *const layer);
 
+    void broadcastAddEvents(const Array<const MidiEvent *> &events);
+    void broadcastChangeEvents(const Array<const MidiEvent *> &oldEvents,
+        const Array<const MidiEvent *> &newEvents);
+    void broadcastRemoveEvents(const Array<const MidiEvent *> &events);
+
     void broadcastAddTrack(MidiTrack *const track);
     void broadcastRemoveTrack(MidiTrack *const track);
     void broadcastChangeTrackProperties(MidiTrack *const track);
@@ -164,6 +200,7 @@ public:
     VCS::TrackedItem *initTrackedItem(const Identifier &type,
         const Uuid &id, const VCS::TrackedItem &newState) override;
     bool deleteTrackedItem(VCS::TrackedItem *item) override;
+    void onBeforeResetState() override;
     void onResetState() override;
 
     //===------------------------------------------------------------------===//
@@ -187,6 +224,10 @@ protected:
     bool onDocumentLoad(File &file) override;
     void onDocumentDidLoad(File &file) override;
     bool onDocumentSave(File &file) override;
+    void onDocumentDidSave(File &file) override;
+    bool onDocumentSaveInBackground(const File &file,
+        Function<void(bool savedOk)> callback) override;
+    bool shouldDeferAutosave() const override;
     void onDocumentImport(File &file) override;
     bool onDocumentExport(File &file) override;
 
@@ -201,9 +242,11 @@ protected:
 private:
 
     void collectTracks(Array<MidiTrack *> &resultArray, bool onlySelected = false) const;
+    void updateRecentProjectStats(const File &file) const;
 
     UniquePointer<Autosaver> autosaver;
     UniquePointer<Transport> transport;
+    UniquePointer<MidiRecorder> recorder;
 
     UniquePointer<SequencerLayout> sequencerLayout;
     HybridRollEditMode rollEditMode;
@@ -212,6 +255,9 @@ private:
     UniquePointer<ProjectPage> projectPage;
     ReadWriteLock tracksListLock;
 
+    bool suspended = false;
+    SerializedData suspendedLayoutState;
+
     UniquePointer<ProjectMetadata> metadata;
     UniquePointer<ProjectTimeline> timeline;
 
@@ -219,12 +265,19 @@ private:
 
     UniquePointer<CommandPaletteTimelineEvents> consoleTimelineEvents;
 
+    OwnedArray<MemoryBudget::Account> memoryAccounts;
+    void getEventsMemoryUsage(int &numEvents, int64 &numBytes) const;
+
 private:
 
     void initialize();
     SerializedData save() const;
     void load(const SerializedData &tree);
 
+    struct PreparsedSequence;
+    OwnedArray<PreparsedSequence> preparsedSequences;
+    void preparseSequences(const SerializedData &root);
+
 private:
 
     String id;
@@ -233,11 +286,14 @@ private:
     Array<const VCS::TrackedItem *> vcsItems;
 
     UniquePointer<UndoStack> undoStack;
+    UniquePointer<UndoJournal> journal;
 
     mutable float firstBeatCache = 0.f;
     mutable float lastBeatCache = PROJECT_DEFAULT_NUM_BEATS;
 
     mutable bool isTracksCacheOutdated = true;
+    int tracksVersion = 0;
+    mutable Array<MidiTrack *> tracksListCache;
     mutable FlatHashMap<String, WeakReference<MidiTrack>, StringHash> tracksRefsCache;
     void rebuildTracksRefsCacheIfNeeded() const;
 
@@ -128,30 +128,16 @@ MidiTrack *ProjectTimeline::getKeySignatures() const noexcept
 
 static float findNextTrackAnchor(MidiTrack *track, float beat)
 {
-    for (int i = 0; i < track->getSequence()->size(); ++i)
-    {
-        const auto *current = track->getSequence()->getUnchecked(i);
-        if (current->getBeat() > beat)
-        {
-            return current->getBeat();
-        }
-    }
-
-    return FLT_MAX;
+    const auto *sequence = track->getSequence();
+    const int index = sequence->indexOfFirstEventAfter(beat);
+    return index < sequence->size() ? sequence->getUnchecked(index)->getBeat() : FLT_MAX;
 }
 
 static float findPreviousTrackAnchor(MidiTrack *track, float beat)
 {
-    for (int i = track->getSequence()->size(); i --> 0                        ;)
-    {
-        const auto *current = track->getSequence()->getUnchecked(i);
-        if (current->getBeat() < beat)
-        {
-            return current->getBeat();
-        }
-    }
-
-    return -FLT_MAX;
+    const auto *sequence = track->getSequence();
+    const int index = sequence->indexOfFirstEventAtOrAfter(beat) - 1;
+    return index >= 0 ? sequence->getUnchecked(index)->getBeat() : -FLT_MAX;
 }
 
 // finds the nearest timeline event, like key or time signature, or annotation
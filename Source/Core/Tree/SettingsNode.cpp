@@ -25,6 +25,7 @@
 #include "ThemeSettings.h"
 #include "UserInterfaceSettings.h"
 #include "TranslationSettings.h"
+#include "MemorySettings.h"
 
 #include "LabeledSettingsWrapper.h"
 #include "SimpleSettingsWrapper.h"
@@ -66,6 +67,8 @@ void SettingsNode::showPage()
 void SettingsNode::recreatePage()
 {
     this->settingsPage = nullptr;
+    this->memorySettingsWrapper = nullptr;
+    this->memorySettings = nullptr;
     this->syncSettingsWrapper = nullptr;
     this->syncSettings = nullptr;
     this->translationSettingsWrapper = nullptr;
@@ -103,6 +106,10 @@ void SettingsNode::recreatePage()
     this->syncSettingsWrapper.reset(new LabeledSettingsWrapper(this->syncSettings.get(), TRANS(I18n::Settings::sync)));
     this->settingsList->addAndMakeVisible(this->syncSettingsWrapper.get());
 
+    this->memorySettings.reset(new MemorySettings());
+    this->memorySettingsWrapper.reset(new LabeledSettingsWrapper(this->memorySettings.get(), TRANS(I18n::Settings::memory)));
+    this->settingsList->addAndMakeVisible(this->memorySettingsWrapper.get());
+
     this->settingsPage.reset(new SettingsPage(this->settingsList.get()));
 }
 
@@ -49,6 +49,8 @@ private:
     UniquePointer<Component> translationSettingsWrapper;
     UniquePointer<Component> syncSettings;
     UniquePointer<Component> syncSettingsWrapper;
+    UniquePointer<Component> memorySettings;
+    UniquePointer<Component> memorySettingsWrapper;
     UniquePointer<Component> settingsPage;
 
 };
@@ -48,9 +48,7 @@ void TrackGroupNode::removeAllEmptyGroupsInProject(ProjectNode *project)
             for (int i = 0; i < groups.size(); ++i)
             {
                 TrackGroupNode *group = groups.getUnchecked(i);
-                Array<TreeNode *> groupChildren(group->findChildrenOfType<TreeNode>());
-                
-                if (groupChildren.size() == 0)
+                if (group->getNumChildren() == 0)
                 {
                     groupsToDelete.add(group);
                 }
@@ -66,6 +66,7 @@ void TreeNodeBase::addChild(TreeNodeBase *newNode, int insertPosition /*= -1*/)
         newNode->parent = nullptr;
         newNode->parent = this;
         this->children.insert(insertPosition, newNode);
+        this->invalidateFlattenedSubtrees();
     }
 }
 
@@ -75,6 +76,7 @@ bool TreeNodeBase::removeChild(int index, bool deleteNode /*= true*/)
     {
         child->parent = nullptr;
         this->children.remove(index, deleteNode);
+        this->invalidateFlattenedSubtrees();
         return true;
     }
 
@@ -120,9 +122,40 @@ void TreeNodeBase::deselectAllRecursively(TreeNodeBase *toIgnore)
         this->nodeSelectionChanged(false);
     }
 
-    for (auto *i : this->children)
+    // a copy, since the callbacks are free to change the tree
+    const auto subtree = this->getFlattenedSubtree();
+    for (auto *node : subtree)
     {
-        i->deselectAllRecursively(toIgnore);
+        if (node != toIgnore && node->selected)
+        {
+            node->selected = false;
+            node->nodeSelectionChanged(false);
+        }
+    }
+}
+
+const Array<TreeNodeBase *> &TreeNodeBase::getFlattenedSubtree() const
+{
+    if (this->isFlattenedSubtreeOutdated)
+    {
+        this->flattenedSubtree.clearQuick();
+        for (const auto *child : this->children)
+        {
+            this->flattenedSubtree.add(const_cast<TreeNodeBase *>(child));
+            this->flattenedSubtree.addArray(child->getFlattenedSubtree());
+        }
+
+        this->isFlattenedSubtreeOutdated = false;
+    }
+
+    return this->flattenedSubtree;
+}
+
+void TreeNodeBase::invalidateFlattenedSubtrees() noexcept
+{
+    for (auto *node = this; node != nullptr; node = node->parent)
+    {
+        node->isFlattenedSubtreeOutdated = true;
     }
 }
 
@@ -42,6 +42,12 @@ public:
     int getIndexInParent() const noexcept;
     String getNodeIdentifier() const;
 
+    // All the nodes below this one, depth-first, i.e. in the same order as
+    // the recursive traversal; templates may have hundreds of tracks and the tree
+    // is queried a lot, so the list is cached, and adding or removing a node only
+    // invalidates the lists of its parents, which are rebuilt from the children's ones
+    const Array<TreeNodeBase *> &getFlattenedSubtree() const;
+
     bool isSelected() const noexcept;
     void setSelected(NotificationType shouldNotify = sendNotification);
     // late notify, if called setSelected(doneSendNotification) earlier
@@ -56,10 +62,14 @@ protected:
 private:
 
     void deselectAllRecursively(TreeNodeBase *toIgnore);
+    void invalidateFlattenedSubtrees() noexcept;
 
     bool selected = false;
     TreeNodeBase *parent = nullptr;
     OwnedArray<TreeNodeBase> children;
+
+    mutable Array<TreeNodeBase *> flattenedSubtree;
+    mutable bool isFlattenedSubtreeOutdated = true;
 };
 
 class TreeNode : public TreeNodeBase,
@@ -194,39 +204,28 @@ protected:
     template<typename T, typename ArrayType>
     static void collectChildrenOfType(const TreeNode *rootNode, ArrayType &resultArray, bool pickOnlySelectedOnes)
     {
-        for (int i = 0; i < rootNode->getNumChildren(); ++i)
+        for (auto *node : rootNode->getFlattenedSubtree())
         {
-            TreeNode *child = static_cast<TreeNode *>(rootNode->getChild(i));
-
-            if (T *targetNode = dynamic_cast<T *>(child))
+            TreeNode *child = static_cast<TreeNode *>(node);
+            if (pickOnlySelectedOnes && !child->isSelected())
             {
-                if (!pickOnlySelectedOnes || child->isSelected())
-                {
-                    resultArray.add(targetNode);
-                }
+                continue;
             }
 
-            if (child->getNumChildren() > 0)
+            if (T *targetNode = dynamic_cast<T *>(child))
             {
-                TreeNode::collectChildrenOfType<T, ArrayType>(child, resultArray, pickOnlySelectedOnes);
+                resultArray.add(targetNode);
             }
         }
     }
 
     static void collectActiveSubNodes(const TreeNode *rootNode, Array<TreeNode *> &resultArray)
     {
-        for (int i = 0; i < rootNode->getNumChildren(); ++i)
+        for (auto *node : rootNode->getFlattenedSubtree())
         {
-            TreeNode *child = static_cast<TreeNode *>(rootNode->getChild(i));
-        
-            if (child->isSelected())
-            {
-                resultArray.add(child);
-            }
-        
-            if (child->getNumChildren() > 0)
+            if (node->isSelected())
             {
-                TreeNode::collectActiveSubNodes(child, resultArray);
+                resultArray.add(static_cast<TreeNode *>(node));
             }
         }
     }
@@ -268,6 +268,7 @@ void VersionControlNode::initVCS()
         this->vcs.reset(new VersionControl(*parentProject));
         this->vcs->addChangeListener(parentProject);
         parentProject->addChangeListener(this->vcs.get());
+        parentProject->addListener(&this->vcs->getHead());
     }
 }
 
@@ -276,6 +277,7 @@ void VersionControlNode::shutdownVCS()
     auto *parentProject = this->findParentOfType<ProjectNode>();
     if (parentProject != nullptr && this->vcs != nullptr)
     {
+        parentProject->removeListener(&this->vcs->getHead());
         parentProject->removeChangeListener(this->vcs.get());
         this->vcs->removeChangeListener(parentProject);
     }
@@ -0,0 +1,240 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "Common.h"
+#include "UiProfiler.h"
+
+#define UI_PROFILER_FLAG "--profile-ui"
+#define UI_PROFILER_NUM_RECENT_FRAMES (120)
+#define UI_PROFILER_STATS_WINDOW_MS (1000)
+#define UI_PROFILER_LATENCY_PROBE_MS (100)
+
+struct UiProfilerRecorder final : private AsyncUpdater, private Timer
+{
+    UiProfilerRecorder()
+    {
+        this->frames.insertMultiple(0, {}, UI_PROFILER_NUM_RECENT_FRAMES);
+        this->startTimer(UI_PROFILER_LATENCY_PROBE_MS);
+    }
+
+    ~UiProfilerRecorder() override
+    {
+        this->stopTimer();
+        this->cancelPendingUpdate();
+    }
+
+    void addPaint(const char *name, double selfTimeMs, double totalTimeMs,
+        int64 area, bool isOutermost)
+    {
+        auto &stats = this->currentStats[name];
+        stats.name = name;
+        stats.numPaints++;
+        stats.paintTimeMs += selfTimeMs;
+        stats.paintedArea += area;
+
+        if (isOutermost)
+        {
+            this->currentFrame.paintTimeMs += totalTimeMs;
+            this->currentFrame.paintedArea += area;
+        }
+
+        this->currentFrame.numPaints++;
+        this->triggerAsyncUpdate();
+    }
+
+    // the frame is done when the message thread gets to this
+    void handleAsyncUpdate() override
+    {
+        this->frames.set(this->nextFrameIndex, this->currentFrame);
+        this->nextFrameIndex = (this->nextFrameIndex + 1) % UI_PROFILER_NUM_RECENT_FRAMES;
+        this->currentFrame = {};
+    }
+
+    // posts a message and measures how long it waits in the queue
+    void timerCallback() override
+    {
+        const auto timeNow = Time::getMillisecondCounterHiRes();
+        if (timeNow - this->statsWindowStartMs >= UI_PROFILER_STATS_WINDOW_MS)
+        {
+            this->lastStats.clearQuick();
+            for (const auto &it : this->currentStats)
+            {
+                this->lastStats.add(it.second);
+            }
+
+            this->currentStats.clear();
+            this->statsWindowStartMs = timeNow;
+            this->maxLatencyMs = this->windowMaxLatencyMs;
+            this->windowMaxLatencyMs = 0.0;
+        }
+
+        if (this->isProbingLatency)
+        {
+            return;
+        }
+
+        this->isProbingLatency = true;
+        MessageManager::callAsync([timeNow]()
+        {
+            if (auto *self = UiProfilerRecorder::instance.get())
+            {
+                self->latencyMs = Time::getMillisecondCounterHiRes() - timeNow;
+                self->windowMaxLatencyMs = jmax(self->windowMaxLatencyMs, self->latencyMs);
+                self->isProbingLatency = false;
+            }
+        });
+    }
+
+    // created in App::initialise, if the flag is there, and deleted in App::shutdown
+    static UniquePointer<UiProfilerRecorder> instance;
+
+    Array<UiProfiler::FrameStats> frames;
+    int nextFrameIndex = 0;
+    UiProfiler::FrameStats currentFrame;
+
+    FlatHashMap<const char *, UiProfiler::ComponentStats> currentStats;
+    Array<UiProfiler::ComponentStats> lastStats;
+    double statsWindowStartMs = 0.0;
+
+    bool isProbingLatency = false;
+    double latencyMs = 0.0;
+    double maxLatencyMs = 0.0;
+    double windowMaxLatencyMs = 0.0;
+
+    UiProfiler::PaintScope *currentScope = nullptr;
+
+    JUCE_DECLARE_NON_COPYABLE(UiProfilerRecorder)
+};
+
+UniquePointer<UiProfilerRecorder> UiProfilerRecorder::instance;
+
+bool UiProfiler::initWithCommandLine(const String &commandLine)
+{
+    const auto args = StringArray::fromTokens(commandLine, true);
+    if (!args.contains(UI_PROFILER_FLAG))
+    {
+        return false;
+    }
+
+    UiProfilerRecorder::instance = makeUnique<UiProfilerRecorder>();
+    return true;
+}
+
+void UiProfiler::shutdown()
+{
+    UiProfilerRecorder::instance = nullptr;
+}
+
+bool UiProfiler::isEnabled() noexcept
+{
+    return UiProfilerRecorder::instance != nullptr;
+}
+
+Array<UiProfiler::FrameStats> UiProfiler::getRecentFrames()
+{
+    const auto *recorder = UiProfilerRecorder::instance.get();
+
+    Array<FrameStats> result;
+    if (recorder == nullptr)
+    {
+        return result;
+    }
+
+    result.ensureStorageAllocated(UI_PROFILER_NUM_RECENT_FRAMES);
+    for (int i = 0; i < UI_PROFILER_NUM_RECENT_FRAMES; ++i)
+    {
+        const auto index = (recorder->nextFrameIndex + i) % UI_PROFILER_NUM_RECENT_FRAMES;
+        result.add(recorder->frames.getReference(index));
+    }
+
+    return result;
+}
+
+Array<UiProfiler::ComponentStats> UiProfiler::getWorstOffenders(int maxNumResults)
+{
+    const auto *recorder = UiProfilerRecorder::instance.get();
+    if (recorder == nullptr)
+    {
+        return {};
+    }
+
+    auto result = recorder->lastStats;
+    std::sort(result.begin(), result.end(),
+        [](const ComponentStats &a, const ComponentStats &b)
+    {
+        return a.paintTimeMs > b.paintTimeMs;
+    });
+
+    result.removeRange(maxNumResults, result.size());
+    return result;
+}
+
+double UiProfiler::getMessageLatencyMs() noexcept
+{
+    const auto *recorder = UiProfilerRecorder::instance.get();
+    return recorder != nullptr ? recorder->latencyMs : 0.0;
+}
+
+double UiProfiler::getMaxMessageLatencyMs() noexcept
+{
+    const auto *recorder = UiProfilerRecorder::instance.get();
+    return recorder != nullptr ? recorder->maxLatencyMs : 0.0;
+}
+
+//===----------------------------------------------------------------------===//
+// PaintScope
+//===----------------------------------------------------------------------===//
+
+static int64 getClipArea(const Graphics &g)
+{
+    const auto clip = g.getClipBounds();
+    return int64(clip.getWidth()) * int64(clip.getHeight());
+}
+
+UiProfiler::PaintScope::PaintScope(const char *name, const Graphics &g) noexcept :
+    name(name),
+    startTimeMs(UiProfiler::isEnabled() ? Time::getMillisecondCounterHiRes() : 0.0),
+    area(UiProfiler::isEnabled() ? getClipArea(g) : 0)
+{
+    if (auto *recorder = UiProfilerRecorder::instance.get())
+    {
+        jassert(MessageManager::getInstance()->isThisTheMessageThread());
+        this->outerScope = recorder->currentScope;
+        recorder->currentScope = this;
+    }
+}
+
+UiProfiler::PaintScope::~PaintScope()
+{
+    auto *recorder = UiProfilerRecorder::instance.get();
+    if (recorder == nullptr)
+    {
+        return;
+    }
+
+    const auto totalTimeMs = Time::getMillisecondCounterHiRes() - this->startTimeMs;
+    recorder->currentScope = this->outerScope;
+
+    if (this->outerScope != nullptr)
+    {
+        this->outerScope->nestedTimeMs += totalTimeMs;
+    }
+
+    recorder->addPaint(this->name, totalTimeMs - this->nestedTimeMs,
+        totalTimeMs, this->area, this->outerScope == nullptr);
+}
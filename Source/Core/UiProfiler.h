@@ -0,0 +1,90 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+/*
+    When the app is started with `--profile-ui`, this records how long the
+    instrumented components take to paint, how much area they repaint,
+    and how long the messages wait in the queue, and the overlay on top
+    of the main layout shows that as a graph with the worst offenders.
+
+    JUCE doesn't tell when a frame starts or ends, so a frame here is all
+    the paint calls made while handling one repaint message: the first
+    paint scope in a frame posts an async update, which closes the frame
+    once the message thread is done painting. The paint calls are counted
+    instead of repaint() calls, since JUCE coalesces the latter anyway.
+
+    Everything here is only ever touched from the message thread.
+*/
+
+class UiProfiler final
+{
+public:
+
+    static bool initWithCommandLine(const String &commandLine);
+    static void shutdown();
+    static bool isEnabled() noexcept;
+
+    struct FrameStats final
+    {
+        double paintTimeMs = 0.0;
+        int numPaints = 0;
+        int64 paintedArea = 0;
+    };
+
+    struct ComponentStats final
+    {
+        const char *name = nullptr;
+        int numPaints = 0;
+        double paintTimeMs = 0.0; // excluding the nested scopes
+        int64 paintedArea = 0;
+    };
+
+    // the recent frames, oldest first
+    static Array<FrameStats> getRecentFrames();
+
+    // the components which took the most time painting
+    // during the last second, the slowest first
+    static Array<ComponentStats> getWorstOffenders(int maxNumResults);
+
+    static double getMessageLatencyMs() noexcept;
+    static double getMaxMessageLatencyMs() noexcept;
+
+    class PaintScope final
+    {
+    public:
+
+        PaintScope(const char *name, const Graphics &g) noexcept;
+        ~PaintScope();
+
+    private:
+
+        const char *name;
+        const double startTimeMs;
+        const int64 area;
+
+        double nestedTimeMs = 0.0;
+        PaintScope *outerScope = nullptr;
+
+        JUCE_DECLARE_NON_COPYABLE(PaintScope)
+    };
+};
+
+#define UI_PROFILER_PAINT_SCOPE(name, g) \
+    const UiProfiler::PaintScope JUCE_JOIN_MACRO(uiProfilerScope, __LINE__)(name, g)
@@ -378,6 +378,100 @@ void NotesGroupRemoveAction::reset()
     this->trackId.clear();
 }
 
+//===----------------------------------------------------------------------===//
+// Compact notes state helpers
+//===----------------------------------------------------------------------===//
+
+// the parameters are stored either for all notes of a group, or for none
+static void serializeNotesState(SerializedData &parent,
+    const Array<Note::Id> &ids, const PianoSequence::NotesState &state)
+{
+    using namespace Serialization;
+
+    for (int i = 0; i < ids.size(); ++i)
+    {
+        SerializedData noteState(Midi::note);
+        noteState.setProperty(Midi::id, ids.getUnchecked(i).toString());
+
+        if (!state.beats.isEmpty())
+        {
+            noteState.setProperty(Midi::timestamp, int(state.beats.getUnchecked(i) * TICKS_PER_BEAT));
+        }
+
+        if (!state.keys.isEmpty())
+        {
+            noteState.setProperty(Midi::key, state.keys.getUnchecked(i));
+        }
+
+        if (!state.lengths.isEmpty())
+        {
+            noteState.setProperty(Midi::length, int(state.lengths.getUnchecked(i) * TICKS_PER_BEAT));
+        }
+
+        if (!state.velocities.isEmpty())
+        {
+            noteState.setProperty(Midi::volume, int(state.velocities.getUnchecked(i) * VELOCITY_SAVE_ACCURACY));
+        }
+
+        if (!state.tuplets.isEmpty())
+        {
+            noteState.setProperty(Midi::tuplet, state.tuplets.getUnchecked(i));
+        }
+
+        parent.appendChild(noteState);
+    }
+}
+
+// also reads the full notes, as the older versions used to store them
+static void deserializeNotesState(const SerializedData &parent,
+    Array<Note::Id> &outIds, PianoSequence::NotesState &outState)
+{
+    using namespace Serialization;
+
+    bool hasBeats = false, hasKeys = false, hasLengths = false,
+        hasVelocities = false, hasTuplets = false;
+
+    forEachChildWithType(parent, noteState, Midi::note)
+    {
+        hasBeats = hasBeats || noteState.hasProperty(Midi::timestamp);
+        hasKeys = hasKeys || noteState.hasProperty(Midi::key);
+        hasLengths = hasLengths || noteState.hasProperty(Midi::length);
+        hasVelocities = hasVelocities || noteState.hasProperty(Midi::volume);
+        hasTuplets = hasTuplets || noteState.hasProperty(Midi::tuplet);
+    }
+
+    forEachChildWithType(parent, noteState, Midi::note)
+    {
+        outIds.add(Note::Id(noteState.getProperty(Midi::id).toString()));
+
+        if (hasBeats)
+        {
+            outState.beats.add(float(noteState.getProperty(Midi::timestamp)) / TICKS_PER_BEAT);
+        }
+
+        if (hasKeys)
+        {
+            outState.keys.add(noteState.getProperty(Midi::key, MIDDLE_C));
+        }
+
+        if (hasLengths)
+        {
+            outState.lengths.add(float(noteState.getProperty(Midi::length, TICKS_PER_BEAT)) / TICKS_PER_BEAT);
+        }
+
+        if (hasVelocities)
+        {
+            const auto vol = float(noteState.getProperty(Midi::volume, VELOCITY_SAVE_ACCURACY)) / VELOCITY_SAVE_ACCURACY;
+            outState.velocities.add(jlimit(0.f, 1.f, vol));
+        }
+
+        if (hasTuplets)
+        {
+            outState.tuplets.add(Note::Tuplet(int(noteState.getProperty(Midi::tuplet, 1))));
+        }
+    }
+}
+
 //===----------------------------------------------------------------------===//
 // Change Group
 //===----------------------------------------------------------------------===//
@@ -387,8 +481,78 @@ NotesGroupChangeAction::NotesGroupChangeAction(MidiTrackSource &source,
     UndoAction(source),
     trackId(trackId)
 {
-    this->notesBefore.swapWith(state1);
-    this->notesAfter.swapWith(state2);
+    jassert(state1.size() == state2.size());
+    const int numNotes = jmin(state1.size(), state2.size());
+
+    // finds out which parameters change at least for one note,
+    // the new beats are rounded, the same way Note::applyChanges does:
+    bool changesBeats = false, changesKeys = false, changesLengths = false,
+        changesVelocities = false, changesTuplets = false;
+
+    for (int i = 0; i < numNotes; ++i)
+    {
+        const auto &before = state1.getReference(i);
+        const auto &after = state2.getReference(i);
+        jassert(before.getId() == after.getId());
+        changesBeats = changesBeats || before.getBeat() != roundBeat(after.getBeat());
+        changesKeys = changesKeys || before.getKey() != after.getKey();
+        changesLengths = changesLengths || before.getLength() != after.getLength();
+        changesVelocities = changesVelocities || before.getVelocity() != after.getVelocity();
+        changesTuplets = changesTuplets || before.getTuplet() != after.getTuplet();
+    }
+
+    this->ids.ensureStorageAllocated(numNotes);
+    this->stateBefore.beats.ensureStorageAllocated(numNotes);
+
+    for (int i = 0; i < numNotes; ++i)
+    {
+        const auto &before = state1.getReference(i);
+        const auto &after = state2.getReference(i);
+
+        this->ids.add(before.getId());
+        this->stateBefore.beats.add(before.getBeat());
+
+        if (changesBeats)
+        {
+            this->stateAfter.beats.add(roundBeat(after.getBeat()));
+        }
+
+        if (changesKeys)
+        {
+            this->stateBefore.keys.add(before.getKey());
+            this->stateAfter.keys.add(after.getKey());
+        }
+
+        if (changesLengths)
+        {
+            this->stateBefore.lengths.add(before.getLength());
+            this->stateAfter.lengths.add(after.getLength());
+        }
+
+        if (changesVelocities)
+        {
+            this->stateBefore.velocities.add(before.getVelocity());
+            this->stateAfter.velocities.add(after.getVelocity());
+        }
+
+        if (changesTuplets)
+        {
+            this->stateBefore.tuplets.add(before.getTuplet());
+            this->stateAfter.tuplets.add(after.getTuplet());
+        }
+    }
+}
+
+NotesGroupChangeAction::NotesGroupChangeAction(MidiTrackSource &source,
+    const String &trackId, Array<Note::Id> &ids,
+    PianoSequence::NotesState &stateBefore,
+    PianoSequence::NotesState &stateAfter) noexcept :
+    UndoAction(source),
+    trackId(trackId)
+{
+    this->ids.swapWith(ids);
+    this->stateBefore.swapWith(stateBefore);
+    this->stateAfter.swapWith(stateAfter);
 }
 
 bool NotesGroupChangeAction::perform()
@@ -396,7 +560,7 @@ bool NotesGroupChangeAction::perform()
     if (PianoSequence *sequence =
         this->source.findSequenceByTrackId<PianoSequence>(this->trackId))
     {
-        return sequence->changeGroup(this->notesBefore, this->notesAfter, false);
+        return sequence->changeGroup(this->ids, this->stateBefore, this->stateAfter);
     }
     
     return false;
@@ -407,7 +571,7 @@ bool NotesGroupChangeAction::undo()
     if (PianoSequence *sequence =
         this->source.findSequenceByTrackId<PianoSequence>(this->trackId))
     {
-        return sequence->changeGroup(this->notesAfter, this->notesBefore, false);
+        return sequence->changeGroup(this->ids, this->stateAfter, this->stateBefore);
     }
     
     return false;
@@ -415,43 +579,66 @@ bool NotesGroupChangeAction::undo()
 
 int NotesGroupChangeAction::getSizeInUnits()
 {
-    return (sizeof(Note) * this->notesBefore.size()) +
-        (sizeof(Note) * this->notesAfter.size());
+    return int(sizeof(NotesGroupChangeAction)) +
+        int(this->trackId.getNumBytesAsUTF8()) +
+        this->ids.size() * int(sizeof(Note::Id)) +
+        this->stateBefore.getSizeInBytes() +
+        this->stateAfter.getSizeInBytes();
+}
+
+// keeps the parameter's initial values from the first change,
+// and takes the final values from the second one, if they change there
+template <typename T>
+static void mergeChanges(Array<T> &before1, Array<T> &after1,
+    Array<T> &before2, Array<T> &after2)
+{
+    if (after2.isEmpty())
+    {
+        return;
+    }
+
+    if (after1.isEmpty())
+    {
+        before1.swapWith(before2);
+    }
+
+    after1.swapWith(after2);
+}
+
+bool NotesGroupChangeAction::mergeWith(UndoAction *nextAction)
+{
+    auto *nextChanger = dynamic_cast<NotesGroupChangeAction *>(nextAction);
+    if (nextChanger == nullptr ||
+        nextChanger->trackId != this->trackId ||
+        nextChanger->ids != this->ids)
+    {
+        return false;
+    }
+
+    auto &before2 = nextChanger->stateBefore;
+    auto &after2 = nextChanger->stateAfter;
+
+    // the initial beats are always kept, since the lookups need them
+    if (!after2.beats.isEmpty())
+    {
+        this->stateAfter.beats.swapWith(after2.beats);
+    }
+
+    mergeChanges(this->stateBefore.keys, this->stateAfter.keys, before2.keys, after2.keys);
+    mergeChanges(this->stateBefore.lengths, this->stateAfter.lengths, before2.lengths, after2.lengths);
+    mergeChanges(this->stateBefore.velocities, this->stateAfter.velocities, before2.velocities, after2.velocities);
+    mergeChanges(this->stateBefore.tuplets, this->stateAfter.tuplets, before2.tuplets, after2.tuplets);
+    return true;
 }
 
 UndoAction *NotesGroupChangeAction::createCoalescedAction(UndoAction *nextAction)
 {
-    if (PianoSequence *sequence =
-        this->source.findSequenceByTrackId<PianoSequence>(this->trackId))
+    if (this->mergeWith(nextAction))
     {
-        if (NotesGroupChangeAction *nextChanger =
-            dynamic_cast<NotesGroupChangeAction *>(nextAction))
-        {
-            if (nextChanger->trackId != this->trackId)
-            {
-                return nullptr;
-            }
-            
-            if (this->notesBefore.size() != nextChanger->notesAfter.size())
-            {
-                return nullptr;
-            }
-            
-            for (int i = 0; i < this->notesBefore.size(); ++i)
-            {
-                if (this->notesBefore.getUnchecked(i).getId() !=
-                    nextChanger->notesAfter.getUnchecked(i).getId())
-                {
-                    return nullptr;
-                }
-            }
-            
-            return new NotesGroupChangeAction(this->source,
-                this->trackId, this->notesBefore, nextChanger->notesAfter);
-        }
+        return new NotesGroupChangeAction(this->source,
+            this->trackId, this->ids, this->stateBefore, this->stateAfter);
     }
 
-    (void) nextAction;
     return nullptr;
 }
 
@@ -467,15 +654,8 @@ SerializedData NotesGroupChangeAction::serialize() const
     SerializedData groupBeforeChild(Serialization::Undo::groupBefore);
     SerializedData groupAfterChild(Serialization::Undo::groupAfter);
     
-    for (int i = 0; i < this->notesBefore.size(); ++i)
-    {
-        groupBeforeChild.appendChild(this->notesBefore.getUnchecked(i).serialize());
-    }
-    
-    for (int i = 0; i < this->notesAfter.size(); ++i)
-    {
-        groupAfterChild.appendChild(this->notesAfter.getUnchecked(i).serialize());
-    }
+    serializeNotesState(groupBeforeChild, this->ids, this->stateBefore);
+    serializeNotesState(groupAfterChild, this->ids, this->stateAfter);
     
     tree.appendChild(groupBeforeChild);
     tree.appendChild(groupAfterChild);
@@ -492,24 +672,189 @@ void NotesGroupChangeAction::deserialize(const SerializedData &data)
     const auto groupBeforeChild = data.getChildWithName(Serialization::Undo::groupBefore);
     const auto groupAfterChild = data.getChildWithName(Serialization::Undo::groupAfter);
 
-    for (const auto &props : groupBeforeChild)
+    Array<Note::Id> idsAfter;
+    deserializeNotesState(groupBeforeChild, this->ids, this->stateBefore);
+    deserializeNotesState(groupAfterChild, idsAfter, this->stateAfter);
+    jassert(this->ids == idsAfter);
+
+    // the older versions only stored the tuplets other than 1
+    // which might be missing for the whole group before or after:
+    if (this->stateBefore.tuplets.isEmpty() != this->stateAfter.tuplets.isEmpty())
     {
-        Note n;
-        n.deserialize(props);
-        this->notesBefore.add(n);
+        auto &missingTuplets = this->stateBefore.tuplets.isEmpty() ?
+            this->stateBefore.tuplets : this->stateAfter.tuplets;
+        missingTuplets.insertMultiple(0, Note::Tuplet(1), this->ids.size());
+    }
+}
+
+void NotesGroupChangeAction::reset()
+{
+    this->ids.clear();
+    this->stateBefore.clear();
+    this->stateAfter.clear();
+    this->trackId.clear();
+}
+
+//===----------------------------------------------------------------------===//
+// Transform Group
+//===----------------------------------------------------------------------===//
+
+NotesGroupTransformAction::NotesGroupTransformAction(MidiTrackSource &source,
+    const String &trackId, const Note::Transform &transform,
+    Array<Note::Id> &ids, PianoSequence::NotesState &initialState) noexcept :
+    UndoAction(source),
+    trackId(trackId),
+    transform(transform)
+{
+    this->ids.swapWith(ids);
+    this->initialState.swapWith(initialState);
+}
+
+bool NotesGroupTransformAction::perform()
+{
+    if (PianoSequence *sequence =
+        this->source.findSequenceByTrackId<PianoSequence>(this->trackId))
+    {
+        return sequence->applyTransform(this->ids, this->initialState, this->transform, false);
     }
 
-    for (const auto &props : groupAfterChild)
+    return false;
+}
+
+bool NotesGroupTransformAction::undo()
+{
+    if (PianoSequence *sequence =
+        this->source.findSequenceByTrackId<PianoSequence>(this->trackId))
     {
-        Note n;
-        n.deserialize(props);
-        this->notesAfter.add(n);
+        return sequence->applyTransform(this->ids, this->initialState, this->transform, true);
     }
+
+    return false;
 }
 
-void NotesGroupChangeAction::reset()
+int NotesGroupTransformAction::getSizeInUnits()
+{
+    return int(sizeof(NotesGroupTransformAction)) +
+        int(this->trackId.getNumBytesAsUTF8()) +
+        this->ids.size() * int(sizeof(Note::Id)) +
+        this->initialState.getSizeInBytes();
+}
+
+static Note::Key transformKey(const Note::Transform &transform, Note::Key key) noexcept
+{
+    return transform.changesKeys() ? jlimit(0, 128, key + transform.deltaKey) : key;
+}
+
+bool NotesGroupTransformAction::mergeWith(UndoAction *nextAction)
+{
+    auto *nextTransformer = dynamic_cast<NotesGroupTransformAction *>(nextAction);
+    if (nextTransformer == nullptr ||
+        nextTransformer->trackId != this->trackId ||
+        nextTransformer->ids != this->ids)
+    {
+        return false;
+    }
+
+    // only the shifts can be combined, like holding a key to move the selection,
+    // and only if the combined shift gives exactly the same result as
+    // both shifts in a row, e.g. no note got clamped at the highest key:
+    const auto &t1 = this->transform;
+    const auto &t2 = nextTransformer->transform;
+    if (t1.changesLengths() || t1.changesVelocities() ||
+        t2.changesLengths() || t2.changesVelocities())
+    {
+        return false;
+    }
+
+    auto &s1 = this->initialState;
+    auto &s2 = nextTransformer->initialState;
+
+    Note::Transform combined;
+    combined.deltaBeat = t1.deltaBeat + t2.deltaBeat;
+    combined.deltaKey = t1.deltaKey + t2.deltaKey;
+
+    const auto &initialKeys = t1.changesKeys() ? s1.keys : s2.keys;
+    const bool checksKeys = t1.changesKeys() || t2.changesKeys();
+
+    for (int i = 0; i < this->ids.size(); ++i)
+    {
+        const float initialBeat = s1.beats.getUnchecked(i);
+        if (t1.transformBeat(initialBeat) != s2.beats.getUnchecked(i) ||
+            t2.transformBeat(s2.beats.getUnchecked(i)) != combined.transformBeat(initialBeat))
+        {
+            return false;
+        }
+
+        if (checksKeys)
+        {
+            const auto initialKey = initialKeys.getUnchecked(i);
+            if (transformKey(t2, transformKey(t1, initialKey)) != transformKey(combined, initialKey))
+            {
+                return false;
+            }
+        }
+    }
+
+    if (!combined.changesKeys())
+    {
+        s1.keys.clear();
+    }
+    else if (!t1.changesKeys())
+    {
+        s1.keys.swapWith(s2.keys);
+    }
+
+    this->transform = combined;
+    return true;
+}
+
+UndoAction *NotesGroupTransformAction::createCoalescedAction(UndoAction *nextAction)
+{
+    if (this->mergeWith(nextAction))
+    {
+        return new NotesGroupTransformAction(this->source,
+            this->trackId, this->transform, this->ids, this->initialState);
+    }
+
+    return nullptr;
+}
+
+//===----------------------------------------------------------------------===//
+// Serializable
+//===----------------------------------------------------------------------===//
+
+SerializedData NotesGroupTransformAction::serialize() const
+{
+    using namespace Serialization;
+
+    SerializedData tree(Undo::notesGroupTransformAction);
+    tree.setProperty(Undo::trackId, this->trackId);
+    tree.setProperty(Undo::deltaBeat, this->transform.deltaBeat);
+    tree.setProperty(Undo::deltaKey, this->transform.deltaKey);
+    tree.setProperty(Undo::velocityMultiplier, this->transform.velocityMultiplier);
+    tree.setProperty(Undo::snapsPerBeat, this->transform.snapsPerBeat);
+    serializeNotesState(tree, this->ids, this->initialState);
+    return tree;
+}
+
+void NotesGroupTransformAction::deserialize(const SerializedData &data)
+{
+    this->reset();
+
+    using namespace Serialization;
+
+    this->trackId = data.getProperty(Undo::trackId);
+    this->transform.deltaBeat = data.getProperty(Undo::deltaBeat, 0.f);
+    this->transform.deltaKey = data.getProperty(Undo::deltaKey, 0);
+    this->transform.velocityMultiplier = data.getProperty(Undo::velocityMultiplier, 1.f);
+    this->transform.snapsPerBeat = data.getProperty(Undo::snapsPerBeat, 0.f);
+    deserializeNotesState(data, this->ids, this->initialState);
+}
+
+void NotesGroupTransformAction::reset()
 {
-    this->notesBefore.clear();
-    this->notesAfter.clear();
+    this->transform = {};
+    this->ids.clear();
+    this->initialState.clear();
     this->trackId.clear();
 }
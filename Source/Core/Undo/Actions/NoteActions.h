@@ -17,10 +17,10 @@
 
 #pragma once
 
-class PianoSequence;
 class MidiTrackSource;
 
 #include "Note.h"
+#include "PianoSequence.h"
 #include "UndoAction.h"
 
 //===----------------------------------------------------------------------===//
@@ -190,10 +190,15 @@ public:
     NotesGroupChangeAction(MidiTrackSource &source, const String &trackId,
         Array<Note> &state1, Array<Note> &state2) noexcept;
 
+    NotesGroupChangeAction(MidiTrackSource &source, const String &trackId,
+        Array<Note::Id> &ids, PianoSequence::NotesState &stateBefore,
+        PianoSequence::NotesState &stateAfter) noexcept;
+
     bool perform() override;
     bool undo() override;
     int getSizeInUnits() override;
     UndoAction *createCoalescedAction(UndoAction *nextAction) override;
+    bool mergeWith(UndoAction *nextAction) override;
     
     SerializedData serialize() const override;
     void deserialize(const SerializedData &data) override;
@@ -203,8 +208,47 @@ private:
 
     String trackId;
 
-    Array<Note> notesBefore;
-    Array<Note> notesAfter;
+    // instead of the full copies of notes, only keeps the parameters
+    // which have changed, see PianoSequence::NotesState
+    Array<Note::Id> ids;
+    PianoSequence::NotesState stateBefore;
+    PianoSequence::NotesState stateAfter;
 
     JUCE_DECLARE_NON_COPYABLE(NotesGroupChangeAction)
 };
+
+//===----------------------------------------------------------------------===//
+// Transform Group
+//===----------------------------------------------------------------------===//
+
+class NotesGroupTransformAction final : public UndoAction
+{
+public:
+
+    explicit NotesGroupTransformAction(MidiTrackSource &source) noexcept :
+        UndoAction(source) {}
+
+    NotesGroupTransformAction(MidiTrackSource &source, const String &trackId,
+        const Note::Transform &transform, Array<Note::Id> &ids,
+        PianoSequence::NotesState &initialState) noexcept;
+
+    bool perform() override;
+    bool undo() override;
+    int getSizeInUnits() override;
+    UndoAction *createCoalescedAction(UndoAction *nextAction) override;
+    bool mergeWith(UndoAction *nextAction) override;
+
+    SerializedData serialize() const override;
+    void deserialize(const SerializedData &data) override;
+    void reset() override;
+
+private:
+
+    String trackId;
+
+    Note::Transform transform;
+    Array<Note::Id> ids;
+    PianoSequence::NotesState initialState;
+
+    JUCE_DECLARE_NON_COPYABLE(NotesGroupTransformAction)
+};
@@ -39,6 +39,16 @@ public:
         (void) nextAction;
         return nullptr;
     }
+
+    // merges the next action into this one in place, when they are
+    // the consecutive steps of one continuous edit, like dragging,
+    // keeping this action's initial state and the next one's final state;
+    // unlike createCoalescedAction, doesn't allocate anything
+    virtual bool mergeWith(UndoAction *nextAction)
+    {
+        (void) nextAction;
+        return false;
+    }
     
 protected:
     
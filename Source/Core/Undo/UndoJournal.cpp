@@ -0,0 +1,268 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Common.h"
+#include "UndoJournal.h"
+#include "UndoStack.h"
+#include "ProjectNode.h"
+#include "DocumentHelpers.h"
+#include "SerializationKeys.h"
+
+#define UNDO_JOURNAL_FILE_EXTENSION ".journal"
+
+// each record is prefixed with its size, so that the one
+// not written completely because of a crash is detected and skipped
+static void writeRecord(OutputStream &out, const SerializedData &record)
+{
+    MemoryOutputStream data;
+    record.writeToStream(data);
+    out.writeInt(int(data.getDataSize()));
+    out.write(data.getData(), data.getDataSize());
+}
+
+static SerializedData createCheckpointMarker(int64 checkpointId)
+{
+    SerializedData marker(Serialization::Undo::journalCheckpoint);
+    marker.setProperty(Serialization::Undo::journalCheckpointId, checkpointId);
+    return marker;
+}
+
+static bool isCheckpointMarker(const SerializedData &record, int64 checkpointId)
+{
+    return record.hasType(Serialization::Undo::journalCheckpoint) &&
+        int64(record.getProperty(Serialization::Undo::journalCheckpointId)) == checkpointId;
+}
+
+UndoJournal::UndoJournal(ProjectNode &project) :
+    project(project) {}
+
+UndoJournal::~UndoJournal()
+{
+    this->cancelPendingUpdate();
+}
+
+bool UndoJournal::isRecording() const noexcept
+{
+    return this->stream != nullptr && !this->isReplaying;
+}
+
+void UndoJournal::append(const SerializedData &record)
+{
+    if (this->isRecording())
+    {
+        this->write(record);
+        this->numRecordsSinceSavedCheckpoint++;
+    }
+}
+
+void UndoJournal::recover(int64 checkpointId)
+{
+    this->stream = nullptr;
+    this->file = DocumentHelpers::getConfigSlot(this->project.getId() + UNDO_JOURNAL_FILE_EXTENSION);
+
+    const auto records = this->readRecords();
+
+    Array<SerializedData> replayedRecords;
+    replayedRecords.add(createCheckpointMarker(checkpointId));
+
+    {
+        const ScopedValueSetter<bool> replaying(this->isReplaying, true);
+
+        // the markers of the later checkpoints mean that those saves
+        // have never been completed, so their records are replayed as well
+        bool foundCheckpoint = false;
+        for (const auto &record : records)
+        {
+            if (record.hasType(Serialization::Undo::journalCheckpoint))
+            {
+                foundCheckpoint = foundCheckpoint || isCheckpointMarker(record, checkpointId);
+                continue;
+            }
+
+            if (!foundCheckpoint)
+            {
+                continue;
+            }
+
+            if (!this->project.getUndoStack()->replay(record))
+            {
+                DBG("Failed to replay the undo journal record: " + record.getType().toString());
+                break;
+            }
+
+            replayedRecords.add(record);
+        }
+    }
+
+    this->lastCheckpointId = checkpointId;
+    this->lastSavedCheckpointId = checkpointId;
+    this->numRecordsSinceSavedCheckpoint = replayedRecords.size() - 1;
+
+    if (this->numRecordsSinceSavedCheckpoint > 0)
+    {
+        DBG("Recovered " + String(this->numRecordsSinceSavedCheckpoint) +
+            " unsaved changes of " + this->project.getName());
+    }
+
+    // only what has actually been replayed describes the current state
+    this->rewrite(replayedRecords);
+}
+
+int64 UndoJournal::beginCheckpoint()
+{
+    jassert(!this->isReplaying);
+
+    // the new projects start journaling with their first save
+    if (this->stream == nullptr)
+    {
+        this->file = DocumentHelpers::getConfigSlot(this->project.getId() + UNDO_JOURNAL_FILE_EXTENSION);
+        this->rewrite({});
+    }
+
+    this->lastCheckpointId++;
+    this->write(createCheckpointMarker(this->lastCheckpointId));
+    return this->lastCheckpointId;
+}
+
+void UndoJournal::onCheckpointSaved(int64 checkpointId)
+{
+    // a save that started earlier may complete later
+    if (this->stream == nullptr || checkpointId <= this->lastSavedCheckpointId)
+    {
+        return;
+    }
+
+    this->lastSavedCheckpointId = checkpointId;
+
+    Array<SerializedData> remainingRecords;
+    int numRemainingChanges = 0;
+
+    for (const auto &record : this->readRecords())
+    {
+        if (remainingRecords.isEmpty() && !isCheckpointMarker(record, checkpointId))
+        {
+            continue;
+        }
+
+        remainingRecords.add(record);
+        if (!record.hasType(Serialization::Undo::journalCheckpoint))
+        {
+            numRemainingChanges++;
+        }
+    }
+
+    if (!remainingRecords.isEmpty())
+    {
+        this->numRecordsSinceSavedCheckpoint = numRemainingChanges;
+        this->rewrite(remainingRecords);
+    }
+}
+
+void UndoJournal::onUnjournaledChange()
+{
+    if (this->isRecording())
+    {
+        this->triggerAsyncUpdate();
+    }
+}
+
+void UndoJournal::close()
+{
+    if (this->stream == nullptr)
+    {
+        return;
+    }
+
+    this->stream = nullptr;
+    this->cancelPendingUpdate();
+
+    if (this->lastSavedCheckpointId == this->lastCheckpointId &&
+        this->numRecordsSinceSavedCheckpoint == 0)
+    {
+        this->file.deleteFile();
+    }
+}
+
+void UndoJournal::handleAsyncUpdate()
+{
+    this->project.getDocument()->saveInBackground();
+}
+
+void UndoJournal::write(const SerializedData &record)
+{
+    if (this->stream != nullptr)
+    {
+        writeRecord(*this->stream, record);
+        this->stream->flush();
+    }
+}
+
+void UndoJournal::rewrite(const Array<SerializedData> &records)
+{
+    this->stream = nullptr;
+
+    MemoryOutputStream data;
+    for (const auto &record : records)
+    {
+        writeRecord(data, record);
+    }
+
+    if (!this->file.replaceWithData(data.getData(), data.getDataSize()))
+    {
+        DBG("Failed to write the undo journal: " + this->file.getFullPathName());
+        return;
+    }
+
+    auto out = makeUnique<FileOutputStream>(this->file);
+    if (out->openedOk())
+    {
+        this->stream = std::move(out);
+    }
+}
+
+Array<SerializedData> UndoJournal::readRecords() const
+{
+    Array<SerializedData> records;
+
+    MemoryBlock data;
+    if (!this->file.loadFileAsData(data))
+    {
+        return records;
+    }
+
+    MemoryInputStream in(data, false);
+    while (in.getNumBytesRemaining() >= int64(sizeof(int)))
+    {
+        const int size = in.readInt();
+        if (size <= 0 || size > in.getNumBytesRemaining())
+        {
+            break;
+        }
+
+        const auto *recordData = static_cast<const char *>(data.getData()) + in.getPosition();
+        const auto record = SerializedData::readFromData(recordData, size_t(size));
+        if (!record.isValid())
+        {
+            break;
+        }
+
+        records.add(record);
+        in.skipNextBytes(size);
+    }
+
+    return records;
+}
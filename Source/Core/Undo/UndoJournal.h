@@ -0,0 +1,82 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+class ProjectNode;
+
+/*
+    An append-only log of the project's undo stack changes made since
+    the last full save, which is written as the changes happen, so that
+    the full saves are only needed when idle or closing, and the changes
+    made after the last one can be recovered after a crash.
+
+    Each full save begins a checkpoint, which id is stored in the project file,
+    and which marker is appended to the journal; on load, the records following
+    the marker of the loaded checkpoint are replayed, see UndoStack::replay;
+    once the file is written, the journal before its marker is dropped.
+
+    The changes made not through the undo stack, e.g. the version control
+    operations, can't be replayed, so they just make the project save right away.
+*/
+
+class UndoJournal final : private AsyncUpdater
+{
+public:
+
+    explicit UndoJournal(ProjectNode &project);
+    ~UndoJournal() override;
+
+    bool isRecording() const noexcept;
+    void append(const SerializedData &record);
+
+    // replays the records made after the checkpoint
+    // the project was loaded from (if any), and starts recording
+    void recover(int64 checkpointId);
+
+    // a checkpoint begins when the snapshot for the full save is taken,
+    // and it is confirmed when the file is written
+    int64 beginCheckpoint();
+    void onCheckpointSaved(int64 checkpointId);
+
+    void onUnjournaledChange();
+
+    // deletes the journal, unless it has something to recover
+    void close();
+
+private:
+
+    void handleAsyncUpdate() override;
+
+    void write(const SerializedData &record);
+    void rewrite(const Array<SerializedData> &records);
+    Array<SerializedData> readRecords() const;
+
+    ProjectNode &project;
+
+    File file;
+    UniquePointer<FileOutputStream> stream;
+
+    bool isReplaying = false;
+
+    int64 lastCheckpointId = 0;
+    int64 lastSavedCheckpointId = 0;
+    int numRecordsSinceSavedCheckpoint = 0;
+
+    JUCE_DECLARE_WEAK_REFERENCEABLE(UndoJournal)
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(UndoJournal)
+};
@@ -20,6 +20,7 @@
 #include "UndoAction.h"
 #include "SerializationKeys.h"
 #include "ProjectNode.h"
+#include "UndoJournal.h"
 
 #include "MidiTrackActions.h"
 #include "PianoTrackActions.h"
@@ -39,9 +40,10 @@ UndoStack::Transaction::Transaction(ProjectNode &project, UndoActionId transacti
     
 bool UndoStack::Transaction::perform() const
 {
-    for (int i = 0; i < this->actions.size(); ++i)
+    const auto &actions = this->getActions();
+    for (int i = 0; i < actions.size(); ++i)
     {
-        if (!this->actions.getUnchecked(i)->perform())
+        if (!actions.getUnchecked(i)->perform())
         {
             return false;
         }
@@ -52,9 +54,10 @@ bool UndoStack::Transaction::perform() const
     
 bool UndoStack::Transaction::undo() const
 {
-    for (int i = this->actions.size(); --i >= 0;)
+    const auto &actions = this->getActions();
+    for (int i = actions.size(); --i >= 0;)
     {
-        if (!this->actions.getUnchecked(i)->undo())
+        if (!actions.getUnchecked(i)->undo())
         {
             return false;
         }
@@ -73,36 +76,107 @@ int UndoStack::Transaction::getTotalSize() const
         
     return total;
 }
-    
-SerializedData UndoStack::Transaction::serialize() const
+
+const OwnedArray<UndoAction> &UndoStack::Transaction::getActions() const
 {
-    SerializedData tree(Serialization::Undo::transaction);
+    if (this->hasUnloadedActions)
+    {
+        this->hasUnloadedActions = false;
 
-    for (int i = 0; i < this->actions.size(); ++i)
+        for (const auto &childAction : this->serializedData)
+        {
+            if (auto *action = this->createUndoActionByTag(childAction.getType()))
+            {
+                action->deserialize(childAction);
+                this->actions.add(action);
+            }
+        }
+    }
+
+    return this->actions;
+}
+
+void UndoStack::Transaction::addAction(UndoAction *action)
+{
+    this->getActions();
+    this->actions.add(action);
+    this->serializedData = {};
+}
+
+void UndoStack::Transaction::removeAction(int index)
+{
+    this->getActions();
+    this->actions.remove(index);
+    this->serializedData = {};
+}
+
+void UndoStack::Transaction::takeActionsFrom(Transaction &other)
+{
+    this->getActions();
+    other.getActions();
+
+    // hack warning: manually moving owned objects
+    // from one owned array to another to avoid copying:
+    this->actions.addArray(other.actions);
+    other.actions.clear(false);
+
+    this->serializedData = {};
+    other.serializedData = {};
+}
+
+bool UndoStack::Transaction::mergeIntoLastAction(UndoAction *action)
+{
+    const auto &actions = this->getActions();
+    if (actions.isEmpty() || !actions.getLast()->mergeWith(action))
     {
-        tree.appendChild(this->actions.getUnchecked(i)->serialize());
+        return false;
+    }
+
+    this->serializedData = {};
+    return true;
+}
+
+// the transactions which are not going to be saved don't need the cache,
+// but the ones not loaded yet have nothing but the serialized data
+void UndoStack::Transaction::releaseSerializedData() const
+{
+    if (!this->hasUnloadedActions)
+    {
+        this->serializedData = {};
     }
-        
-    return tree;
 }
     
-void UndoStack::Transaction::deserialize(const SerializedData &data)
+SerializedData UndoStack::Transaction::serialize() const
 {
-    this->reset();
-
-    for (const auto &childAction : data)
+    if (!this->serializedData.isValid())
     {
-        if (auto *action = createUndoActionByTag(childAction.getType()))
+        SerializedData tree(Serialization::Undo::transaction);
+
+        for (int i = 0; i < this->actions.size(); ++i)
         {
-            action->deserialize(childAction);
-            this->actions.add(action);
+            tree.appendChild(this->actions.getUnchecked(i)->serialize());
         }
+
+        this->serializedData = tree;
     }
+
+    // the previously saved tree might still be holding the cached data:
+    return this->serializedData.getParent().isValid() ?
+        this->serializedData.createCopy() : this->serializedData;
+}
+    
+void UndoStack::Transaction::deserialize(const SerializedData &data)
+{
+    this->reset();
+    this->serializedData = data;
+    this->hasUnloadedActions = true;
 }
     
 void UndoStack::Transaction::reset()
 {
     this->actions.clear();
+    this->serializedData = {};
+    this->hasUnloadedActions = false;
 }
 
 UndoAction *UndoStack::Transaction::createUndoActionByTag(const Identifier &tagName) const
@@ -128,6 +202,7 @@ UndoAction *UndoStack::Transaction::createUndoActionByTag(const Identifier &tagN
     else if (tagName == Undo::notesGroupInsertAction)                { return new NotesGroupInsertAction(this->project); }
     else if (tagName == Undo::notesGroupRemoveAction)                { return new NotesGroupRemoveAction(this->project); }
     else if (tagName == Undo::notesGroupChangeAction)                { return new NotesGroupChangeAction(this->project); }
+    else if (tagName == Undo::notesGroupTransformAction)             { return new NotesGroupTransformAction(this->project); }
     else if (tagName == Undo::annotationEventInsertAction)           { return new AnnotationEventInsertAction(this->project); }
     else if (tagName == Undo::annotationEventRemoveAction)           { return new AnnotationEventRemoveAction(this->project); }
     else if (tagName == Undo::annotationEventChangeAction)           { return new AnnotationEventChangeAction(this->project); }
@@ -167,14 +242,13 @@ UndoStack::UndoStack(ProjectNode &parentProject,
 void UndoStack::clearUndoHistory()
 {
     this->transactions.clear();
-    this->totalUnitsStored = 0;
     this->nextIndex = 0;
     this->sendChangeMessage();
 }
 
 bool UndoStack::perform(UndoAction *const newAction, UndoActionId transactionId)
 {
-    if (this->perform(newAction))
+    if (this->performAction(newAction, transactionId))
     {
         if (transactionId != 0)
         {
@@ -188,6 +262,11 @@ bool UndoStack::perform(UndoAction *const newAction, UndoActionId transactionId)
 }
 
 bool UndoStack::perform(UndoAction *const newAction)
+{
+    return this->performAction(newAction, UndoActionIDs::None);
+}
+
+bool UndoStack::performAction(UndoAction *const newAction, UndoActionId transactionId)
 {
     if (newAction != nullptr)
     {
@@ -202,19 +281,47 @@ bool UndoStack::perform(UndoAction *const newAction)
 
         if (action->perform())
         {
+            // the action is serialized before it gets merged into another one
+            // or coalesced with it, so that replaying it does exactly the same
+            if (this->isJournaling())
+            {
+                SerializedData record(Serialization::Undo::journalPerform);
+                if (this->hasNewEmptyTransaction)
+                {
+                    record.setProperty(Serialization::Undo::journalNewTransactionId, this->newUndoActionId);
+                }
+
+                if (transactionId != UndoActionIDs::None)
+                {
+                    record.setProperty(Serialization::Undo::journalTransactionId, transactionId);
+                }
+
+                record.appendChild(action->serialize());
+                this->journal->append(record);
+            }
+
             auto *actionSet = this->getCurrentSet();
             
             if (actionSet != nullptr && !this->hasNewEmptyTransaction)
             {
-                for (signed int i = (actionSet->actions.size() - 1); i >= 0; --i)
+                // the continuous edits, like dragging, are merged
+                // into the last action without any allocations
+                if (actionSet->mergeIntoLastAction(action.get()))
+                {
+                    this->clearFutureTransactions();
+                    this->sendChangeMessage();
+                    return true;
+                }
+
+                const auto &actions = actionSet->getActions();
+                for (signed int i = (actions.size() - 1); i >= 0; --i)
                 {
-                    if (auto *lastAction = actionSet->actions[i])
+                    if (auto *lastAction = actions[i])
                     {
                         if (auto *coalescedAction = lastAction->createCoalescedAction(action.get()))
                         {
                             action.reset(coalescedAction);
-                            this->totalUnitsStored -= lastAction->getSizeInUnits();
-                            actionSet->actions.remove(i);
+                            actionSet->removeAction(i);
                             break;
                         }
                     }
@@ -227,8 +334,7 @@ bool UndoStack::perform(UndoAction *const newAction)
                 ++this->nextIndex;
             }
             
-            this->totalUnitsStored += action->getSizeInUnits();
-            actionSet->actions.add(action.release());
+            actionSet->addAction(action.release());
             this->hasNewEmptyTransaction = false;
             
             this->clearFutureTransactions();
@@ -244,24 +350,43 @@ void UndoStack::clearFutureTransactions()
 {
     while (this->nextIndex < this->transactions.size())
     {
-        this->totalUnitsStored -= transactions.getLast()->getTotalSize();
         this->transactions.removeLast();
     }
     
+    // the sizes are summed up here instead of being tracked on the go,
+    // since the lazily loaded transactions grow when they are loaded
+    int totalUnitsStored = 0;
+    for (const auto *transaction : this->transactions)
+    {
+        totalUnitsStored += transaction->getTotalSize();
+    }
+    
     while (this->nextIndex > 0
-           && this->totalUnitsStored > this->maxNumUnitsToKeep
+           && totalUnitsStored > this->maxNumUnitsToKeep
            && this->transactions.size() > this->minimumTransactionsToKeep)
     {
-        this->totalUnitsStored -= this->transactions.getFirst()->getTotalSize();
+        totalUnitsStored -= this->transactions.getFirst()->getTotalSize();
         this->transactions.remove(0);
         --this->nextIndex;
-        
-        // if this fails, then some actions may not be returning
-        // consistent results from their getSizeInUnits() method
-        jassert(this->totalUnitsStored >= 0);
     }
 }
 
+int64 UndoStack::getTotalSize() const
+{
+    int64 total = 0;
+    for (const auto *transaction : this->transactions)
+    {
+        total += transaction->getTotalSize();
+    }
+
+    return total;
+}
+
+int UndoStack::getNumTransactions() const noexcept
+{
+    return this->transactions.size();
+}
+
 void UndoStack::beginNewTransaction() noexcept
 {
     this->beginNewTransaction(UndoActionIDs::None);
@@ -314,10 +439,22 @@ bool UndoStack::undo()
         if (s->undo())
         {
             --nextIndex;
+
+            if (this->isJournaling())
+            {
+                SerializedData record(Serialization::Undo::journalUndo);
+                record.appendChild(s->serialize());
+                this->journal->append(record);
+            }
         }
         else
         {
             this->clearUndoHistory();
+
+            if (this->journal != nullptr)
+            {
+                this->journal->onUnjournaledChange();
+            }
         }
         
         this->beginNewTransaction();
@@ -337,10 +474,22 @@ bool UndoStack::redo()
         if (s->perform())
         {
             ++nextIndex;
+
+            if (this->isJournaling())
+            {
+                SerializedData record(Serialization::Undo::journalRedo);
+                record.appendChild(s->serialize());
+                this->journal->append(record);
+            }
         }
         else
         {
             this->clearUndoHistory();
+
+            if (this->journal != nullptr)
+            {
+                this->journal->onUnjournaledChange();
+            }
         }
         
         this->beginNewTransaction();
@@ -382,9 +531,9 @@ void UndoStack::getActionsInCurrentTransaction(Array<const UndoAction *> &action
     {
         if (const auto *s = this->getCurrentSet())
         {
-            for (int i = 0; i < s->actions.size(); ++i)
+            for (const auto *action : s->getActions())
             {
-                actionsFound.add(s->actions.getUnchecked(i));
+                actionsFound.add(action);
             }
         }
     }
@@ -396,7 +545,7 @@ int UndoStack::getNumActionsInCurrentTransaction() const
     {
         if (const auto *s = this->getCurrentSet())
         {
-            return s->actions.size();
+            return s->getActions().size();
         }
     }
     
@@ -414,6 +563,8 @@ SerializedData UndoStack::serialize() const
     int currentIndex = (this->nextIndex - 1);
     int numStoredTransactions = 0;
     
+    // each transaction is only serialized once, unless it changes,
+    // so repeated autosaves don't re-serialize the whole history:
     while (currentIndex >= 0 &&
            numStoredTransactions < MAX_TRANSACTIONS_TO_STORE)
     {
@@ -426,6 +577,11 @@ SerializedData UndoStack::serialize() const
         ++numStoredTransactions;
     }
     
+    for (; currentIndex >= 0; --currentIndex)
+    {
+        this->transactions.getUnchecked(currentIndex)->releaseSerializedData();
+    }
+    
     return tree;
 }
 
@@ -453,6 +609,76 @@ void UndoStack::reset()
     this->clearUndoHistory();
 }
 
+//===----------------------------------------------------------------------===//
+// Journal
+//===----------------------------------------------------------------------===//
+
+void UndoStack::setJournal(UndoJournal *journal) noexcept
+{
+    this->journal = journal;
+}
+
+bool UndoStack::isJournaling() const noexcept
+{
+    return this->journal != nullptr && this->journal->isRecording();
+}
+
+// Only the last transactions are saved with the project, and the redo ones
+// are not saved at all, so the stack after loading may not have the undone
+// or redone transaction; in that case the transaction from the record is
+// applied directly, and the history, which no longer matches, is cleared
+bool UndoStack::replay(const SerializedData &record)
+{
+    using namespace Serialization::Undo;
+
+    if (record.getNumChildren() != 1)
+    {
+        return false;
+    }
+
+    const auto data = record.getChild(0);
+
+    if (record.hasType(journalPerform))
+    {
+        if (record.hasProperty(journalNewTransactionId))
+        {
+            this->beginNewTransaction(int64(record.getProperty(journalNewTransactionId)));
+        }
+
+        const Transaction factory(this->project);
+        auto *action = factory.createUndoActionByTag(data.getType());
+        if (action == nullptr)
+        {
+            return false;
+        }
+
+        action->deserialize(data);
+        return this->perform(action, int64(record.getProperty(journalTransactionId, 0)));
+    }
+
+    const bool isUndo = record.hasType(journalUndo);
+    if (!isUndo && !record.hasType(journalRedo))
+    {
+        return false;
+    }
+
+    const auto *expected = isUndo ? this->getCurrentSet() : this->getNextSet();
+    if (expected != nullptr && expected->serialize().isEquivalentTo(data))
+    {
+        return isUndo ? this->undo() : this->redo();
+    }
+
+    Transaction transaction(this->project);
+    transaction.deserialize(data);
+
+    const ScopedValueSetter<bool> setter(this->reentrancyCheck, true);
+    const bool appliedOk = isUndo ? transaction.undo() : transaction.perform();
+
+    this->clearUndoHistory();
+    this->beginNewTransaction();
+    return appliedOk;
+}
+
 bool UndoStack::mergeTransactionsUpTo(UndoActionId transactionId)
 {
     // make sure the transaction with that id exists
@@ -488,10 +714,7 @@ bool UndoStack::mergeTransactionsUpTo(UndoActionId transactionId)
     {
         if (auto *t = this->transactions[i])
         {
-            // hack warning: manually moving owned objects
-            // from one owned array to another to avoid copying:
-            targetTransaction->actions.addArray(t->actions);
-            t->actions.clear(false);
+            targetTransaction->takeActionsFrom(*t);
         }
 
         this->transactions.remove(i, true);
@@ -18,6 +18,7 @@
 #pragma once
 
 class ProjectNode;
+class UndoJournal;
 
 #include "UndoAction.h"
 #include "UndoActionIDs.h"
@@ -32,6 +33,10 @@ public:
     
     void clearUndoHistory();
 
+    // roughly in bytes, since the actions estimate their sizes with sizeof
+    int64 getTotalSize() const;
+    int getNumTransactions() const noexcept;
+
     bool perform(UndoAction *action);
     bool perform(UndoAction *action, UndoActionId transactionId);
     
@@ -67,12 +72,23 @@ public:
     // for multi-step interactive actions which might involve >1 checkpoints
     bool mergeTransactionsUpTo(UndoActionId transactionId);
 
+    // the journal gets a record of each performed, undone or redone
+    // transaction, and the records can be replayed later on top of
+    // the last saved state to recover the changes made after it
+    void setJournal(UndoJournal *journal) noexcept;
+    bool replay(const SerializedData &record);
+
 private:
+
+    bool performAction(UndoAction *action, UndoActionId transactionId);
     
     void getActionsInCurrentTransaction(Array<const UndoAction *> &actionsFound) const;
     int getNumActionsInCurrentTransaction() const;
 
     ProjectNode &project;
+
+    UndoJournal *journal = nullptr;
+    bool isJournaling() const noexcept;
     
     struct Transaction final : public Serializable
     {
@@ -81,25 +97,43 @@ private:
 
         bool perform() const;
         bool undo() const;
+
+        // the actions not loaded yet take no memory, so they're not counted
         int getTotalSize() const;
 
-        SerializedData serialize() const;
-        void deserialize(const SerializedData &data);
-        void reset();
+        // the deserialized transactions only create their actions when
+        // they are needed for the first time, e.g. when the user undoes
+        // past the changes made in this session; until then, and until
+        // the actions change, the serialized data is kept, so that saving
+        // doesn't serialize the same transactions over and over again
+        const OwnedArray<UndoAction> &getActions() const;
+        void addAction(UndoAction *action);
+        void removeAction(int index);
+        void takeActionsFrom(Transaction &other);
+        bool mergeIntoLastAction(UndoAction *action);
+        void releaseSerializedData() const;
+
+        SerializedData serialize() const override;
+        void deserialize(const SerializedData &data) override;
+        void reset() override;
 
         UndoAction *createUndoActionByTag(const Identifier &tagName) const;
 
-        OwnedArray<UndoAction> actions;
         UndoActionId id;
 
         ProjectNode &project;
+
+    private:
+
+        mutable OwnedArray<UndoAction> actions;
+        mutable SerializedData serializedData;
+        mutable bool hasUnloadedActions = false;
     };
     
     void setCurrentUndoActionId(UndoActionId transactionId) noexcept;
     OwnedArray<Transaction> transactions;
     UndoActionId newUndoActionId;
     
-    int totalUnitsStored = 0;
     int maxNumUnitsToKeep = 0;
     int minimumTransactionsToKeep = 0;
     int nextIndex = 0;
@@ -114,9 +148,9 @@ private:
     {
         if (s != nullptr) // might be an empty set
         {
-            for (int i = 0; i < s->actions.size(); ++i)
+            for (const auto *action : s->getActions())
             {
-                if (dynamic_cast<T *>(s->actions.getUnchecked(i)))
+                if (dynamic_cast<const T *>(action))
                 {
                     return true;
                 }
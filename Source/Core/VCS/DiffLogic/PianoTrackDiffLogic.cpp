@@ -40,12 +40,17 @@ static DeltaDiff createInstrumentDiff(const SerializedData &state, const Seriali
 
 static Array<DeltaDiff> createEventsDiffs(const SerializedData &state, const SerializedData &changes);
 
-static void deserializeLayerChanges(const SerializedData &state, const SerializedData &changes,
-    OwnedArray<Note> &stateNotes, OwnedArray<Note> &changesNotes);
+// the notes are merged and compared as their serialized nodes, by ids,
+// without being deserialized into the Note objects, in a single pass
+using NoteNodesById = FlatHashMap<String, SerializedData, StringHash>;
+static void indexNoteNodes(const SerializedData &notes, NoteNodesById &result);
+static bool noteNodesDiffer(const SerializedData &a, const SerializedData &b);
 
-static DeltaDiff serializePianoTrackChanges(Array<const MidiEvent *> changes,
+static DeltaDiff serializePianoTrackChanges(const Array<SerializedData> &changes,
     const String &description, int64 numChanges,  const Identifier &deltaType);
 
+static SerializedData serializeNoteNodes(const Array<SerializedData> &notes, const Identifier &tag);
+
 static SerializedData serializePianoSequence(Array<const MidiEvent *> changes, const Identifier &tag);
 static bool checkIfDeltaIsNotesType(const Delta *delta);
 
@@ -68,7 +73,7 @@ Diff *PianoTrackDiffLogic::createDiff(const TrackedItem &initialState) const
     {
         const Delta *myDelta = this->target.getDelta(i);
 
-        const auto myDeltaData(this->target.getDeltaData(i));
+        SerializedData myDeltaData;
         SerializedData stateDeltaData;
 
         bool deltaFoundInState = false;
@@ -81,12 +86,27 @@ Diff *PianoTrackDiffLogic::createDiff(const TrackedItem &initialState) const
             if (myDelta->hasType(stateDelta->getType()))
             {
                 deltaFoundInState = true;
+
+                // the matching hashes mean the same content,
+                // so the live delta isn't even serialized
+                const auto myDeltaHash = this->target.getDeltaHash(i);
+                if (myDeltaHash != 0 && myDeltaHash == initialState.getDeltaHash(j))
+                {
+                    break;
+                }
+
+                myDeltaData = this->target.getDeltaData(i);
                 stateDeltaData = initialState.getDeltaData(j);
                 dataHasChanged = (! myDeltaData.isEquivalentTo(stateDeltaData));
                 break;
             }
         }
 
+        if (!deltaFoundInState)
+        {
+            myDeltaData = this->target.getDeltaData(i);
+        }
+
         if (!deltaFoundInState || dataHasChanged)
         {
             if (myDelta->hasType(MidiTrackDeltas::trackPath))
@@ -319,104 +339,77 @@ SerializedData mergeInstrument(const SerializedData &state, const SerializedData
 
 SerializedData mergeNotesAdded(const SerializedData &state, const SerializedData &changes)
 {
-    using namespace Serialization::VCS;
-
-    OwnedArray<Note> stateNotes;
-    OwnedArray<Note> changesNotes;
-    deserializeLayerChanges(state, changes, stateNotes, changesNotes);
+    using namespace Serialization;
 
-    Array<const MidiEvent *> result;
-
-    result.addArray(stateNotes);
+    Array<SerializedData> result;
+    result.ensureStorageAllocated(state.getNumChildren() + changes.getNumChildren());
 
     // на всякий пожарный, ищем, нет ли в состоянии нот с теми же id, где нет - добавляем
-    FlatHashSet<MidiEvent::Id> stateIDs;
-    
-    for (int j = 0; j < stateNotes.size(); ++j)
+    FlatHashSet<String, StringHash> stateIDs;
+    stateIDs.reserve(state.getNumChildren());
+
+    forEachChildWithType(state, stateNote, Midi::note)
     {
-        const Note *stateNote = stateNotes.getUnchecked(j);
-        stateIDs.insert(stateNote->getId());
+        stateIDs.insert(stateNote.getProperty(Midi::id).toString());
+        result.add(stateNote);
     }
 
-    for (int i = 0; i < changesNotes.size(); ++i)
+    forEachChildWithType(changes, changesNote, Midi::note)
     {
-        const Note *changesNote = changesNotes.getUnchecked(i);
-        const bool foundNoteInState = stateIDs.contains(changesNote->getId());
-
-        if (! foundNoteInState)
+        if (!stateIDs.contains(changesNote.getProperty(Midi::id).toString()))
         {
             result.add(changesNote);
         }
     }
 
-    return serializePianoSequence(result, PianoSequenceDeltas::notesAdded);
+    return serializeNoteNodes(result, Serialization::VCS::PianoSequenceDeltas::notesAdded);
 }
 
 SerializedData mergeNotesRemoved(const SerializedData &state, const SerializedData &changes)
 {
-    using namespace Serialization::VCS;
-
-    OwnedArray<Note> stateNotes;
-    OwnedArray<Note> changesNotes;
-    deserializeLayerChanges(state, changes, stateNotes, changesNotes);
+    using namespace Serialization;
 
-    Array<const MidiEvent *> result;
+    Array<SerializedData> result;
+    result.ensureStorageAllocated(state.getNumChildren());
 
     // добавляем все ноты из состояния, которых нет в изменениях
-    FlatHashSet<MidiEvent::Id> changesIDs;
+    FlatHashSet<String, StringHash> changesIDs;
+    changesIDs.reserve(changes.getNumChildren());
 
-    for (int j = 0; j < changesNotes.size(); ++j)
+    forEachChildWithType(changes, changesNote, Midi::note)
     {
-        const Note *changesNote = changesNotes.getUnchecked(j);
-        changesIDs.insert(changesNote->getId());
+        changesIDs.insert(changesNote.getProperty(Midi::id).toString());
     }
-    
-    for (int i = 0; i < stateNotes.size(); ++i)
+
+    forEachChildWithType(state, stateNote, Midi::note)
     {
-        const Note *stateNote =stateNotes.getUnchecked(i);
-        const bool foundNoteInChanges = changesIDs.contains(stateNote->getId());
-        if (! foundNoteInChanges)
+        if (!changesIDs.contains(stateNote.getProperty(Midi::id).toString()))
         {
             result.add(stateNote);
         }
     }
 
-    return serializePianoSequence(result, PianoSequenceDeltas::notesAdded);
+    return serializeNoteNodes(result, Serialization::VCS::PianoSequenceDeltas::notesAdded);
 }
 
 SerializedData mergeNotesChanged(const SerializedData &state, const SerializedData &changes)
 {
-    using namespace Serialization::VCS;
-
-    OwnedArray<Note> stateNotes;
-    OwnedArray<Note> changesNotes;
-    deserializeLayerChanges(state, changes, stateNotes, changesNotes);
-
-    Array<const MidiEvent *> result;
+    using namespace Serialization;
 
-    result.addArray(stateNotes);
+    Array<SerializedData> result;
+    result.ensureStorageAllocated(state.getNumChildren());
 
-    // снова ищем по id и заменяем
-    FlatHashMap<MidiEvent::Id, const Note *> changesIDs;
-    
-    for (int j = 0; j < changesNotes.size(); ++j)
-    {
-        const Note *changesNote = changesNotes.getUnchecked(j);
-        changesIDs[changesNote->getId()] = changesNote;
-    }
+    // снова ищем по id и заменяем, на том же месте
+    NoteNodesById changesIDs;
+    indexNoteNodes(changes, changesIDs);
 
-    for (int i = 0; i < stateNotes.size(); ++i)
+    forEachChildWithType(state, stateNote, Midi::note)
     {
-        const auto *stateNote = stateNotes.getUnchecked(i);
-        if (changesIDs.contains(stateNote->getId()))
-        {
-            const auto *changesNote = changesIDs[stateNote->getId()];
-            result.removeAllInstancesOf(stateNote);
-            result.addIfNotAlreadyThere(changesNote);
-        }
+        const auto changesNote = changesIDs.find(stateNote.getProperty(Midi::id).toString());
+        result.add(changesNote != changesIDs.end() ? changesNote->second : stateNote);
     }
 
-    return serializePianoSequence(result, PianoSequenceDeltas::notesAdded);
+    return serializeNoteNodes(result, Serialization::VCS::PianoSequenceDeltas::notesAdded);
 }
 
 
@@ -457,80 +450,49 @@ DeltaDiff createInstrumentDiff(const SerializedData &state, const SerializedData
 
 Array<DeltaDiff> createEventsDiffs(const SerializedData &state, const SerializedData &changes)
 {
+    using namespace Serialization;
     using namespace Serialization::VCS;
 
-    OwnedArray<Note> stateNotes;
-    OwnedArray<Note> changesNotes;
-
-    // вот здесь по уму надо десериализовать слои
-    // а для этого надо, чтоб в слоях не было ничего, кроме нот
-    // поэтому пока есть, как есть, и это не критично
-    deserializeLayerChanges(state, changes, stateNotes, changesNotes);
-
     Array<DeltaDiff> res;
 
+    Array<SerializedData> addedNotes;
+    Array<SerializedData> removedNotes;
+    Array<SerializedData> changedNotes;
 
-    Array<const MidiEvent *> addedNotes;
-    Array<const MidiEvent *> removedNotes;
-    Array<const MidiEvent *> changedNotes;
+    NoteNodesById changesIDs;
+    indexNoteNodes(changes, changesIDs);
+
+    FlatHashSet<String, StringHash> stateIDs;
+    stateIDs.reserve(state.getNumChildren());
 
     // собственно, само сравнение
-    for (int i = 0; i < stateNotes.size(); ++i)
+    forEachChildWithType(state, stateNote, Midi::note)
     {
-        bool foundNoteInChanges = false;
-        const Note *stateNote(stateNotes.getUnchecked(i));
+        const auto stateNoteId = stateNote.getProperty(Midi::id).toString();
+        stateIDs.insert(stateNoteId);
 
-        for (int j = 0; j < changesNotes.size(); ++j)
-        {
-            const Note *changesNote = changesNotes.getUnchecked(j);
+        const auto changesNote = changesIDs.find(stateNoteId);
 
-            // нота из состояния - существует в изменениях. добавляем запись changed, если нужно.
-            if (stateNote->getId() == changesNote->getId())
+        // нота из состояния - существует в изменениях. добавляем запись changed, если нужно.
+        if (changesNote != changesIDs.end())
+        {
+            if (noteNodesDiffer(stateNote, changesNote->second))
             {
-                foundNoteInChanges = true;
-
-                const bool noteHasChanged =
-                    stateNote->getKey() != changesNote->getKey() ||
-                    stateNote->getBeat() != changesNote->getBeat() ||
-                    stateNote->getLength() != changesNote->getLength() ||
-                    stateNote->getVelocity() != changesNote->getVelocity() ||
-                    stateNote->getTuplet() != changesNote->getTuplet();
-
-                if (noteHasChanged)
-                {
-                    changedNotes.add(changesNote);
-                }
-
-                break;
+                changedNotes.add(changesNote->second);
             }
         }
-
         // нота из состояния - в изменениях не найдена. добавляем запись removed.
-        if (! foundNoteInChanges)
+        else
         {
             removedNotes.add(stateNote);
         }
     }
 
-    // теперь ищем в изменениях ноты, которые отсутствуют в состоянии
-    for (int i = 0; i < changesNotes.size(); ++i)
+    // теперь ищем в изменениях ноты, которые отсутствуют в состоянии,
+    // и пишем их в список добавленных
+    forEachChildWithType(changes, changesNote, Midi::note)
     {
-        bool foundNoteInState = false;
-        const Note *changesNote = changesNotes.getUnchecked(i);
-
-        for (int j = 0; j < stateNotes.size(); ++j)
-        {
-            const Note *stateNote(stateNotes.getUnchecked(j));
-
-            if (stateNote->getId() == changesNote->getId())
-            {
-                foundNoteInState = true;
-                break;
-            }
-        }
-
-        // и пишем ее в список добавленных
-        if (! foundNoteInState)
+        if (!stateIDs.contains(changesNote.getProperty(Midi::id).toString()))
         {
             addedNotes.add(changesNote);
         }
@@ -566,39 +528,49 @@ Array<DeltaDiff> createEventsDiffs(const SerializedData &state, const Serialized
 }
 
 
-void deserializeLayerChanges(const SerializedData &state, const SerializedData &changes,
-        OwnedArray<Note> &stateNotes, OwnedArray<Note> &changesNotes)
+void indexNoteNodes(const SerializedData &notes, NoteNodesById &result)
 {
-    if (state.isValid())
+    result.reserve(notes.getNumChildren());
+    forEachChildWithType(notes, e, Serialization::Midi::note)
     {
-        forEachChildWithType(state, e, Serialization::Midi::note)
-        {
-            auto *note = new Note();
-            note->deserialize(e);
-            stateNotes.addSorted(*note, note);
-        }
+        result[e.getProperty(Serialization::Midi::id).toString()] = e;
     }
+}
 
-    if (changes.isValid())
-    {
-        forEachChildWithType(changes, e, Serialization::Midi::note)
-        {
-            auto *note = new Note();
-            note->deserialize(e);
-            changesNotes.addSorted(*note, note);
-        }
-    }
+// compares the saved parameters, the same as the notes deserialized
+// from these nodes would be compared, see Note::serialize
+bool noteNodesDiffer(const SerializedData &a, const SerializedData &b)
+{
+    using namespace Serialization;
+    return a.getProperty(Midi::key) != b.getProperty(Midi::key) ||
+        a.getProperty(Midi::timestamp) != b.getProperty(Midi::timestamp) ||
+        a.getProperty(Midi::length) != b.getProperty(Midi::length) ||
+        a.getProperty(Midi::volume) != b.getProperty(Midi::volume) ||
+        a.getProperty(Midi::tuplet, 1) != b.getProperty(Midi::tuplet, 1);
 }
 
-DeltaDiff serializePianoTrackChanges(Array<const MidiEvent *> changes,
+DeltaDiff serializePianoTrackChanges(const Array<SerializedData> &changes,
     const String &description, int64 numChanges, const Identifier &deltaType)
 {
     DeltaDiff changesFullDelta;
     changesFullDelta.delta.reset(new Delta(DeltaDescription(description, numChanges), deltaType));
-    changesFullDelta.deltaData = serializePianoSequence(changes, deltaType);
+    changesFullDelta.deltaData = serializeNoteNodes(changes, deltaType);
     return changesFullDelta;
 }
 
+SerializedData serializeNoteNodes(const Array<SerializedData> &notes, const Identifier &tag)
+{
+    SerializedData tree(tag);
+
+    for (const auto &note : notes)
+    {
+        // the nodes still belong to the state or the changes
+        tree.appendChild(note.createCopy());
+    }
+
+    return tree;
+}
+
 SerializedData serializePianoSequence(Array<const MidiEvent *> changes, const Identifier &tag)
 {
     SerializedData tree(tag);
@@ -22,11 +22,20 @@
 #include "TrackedItem.h"
 #include "Diff.h"
 #include "DiffLogic.h"
+#include "MidiTrack.h"
+#include "MidiSequence.h"
+#include "MidiEvent.h"
+#include "Pattern.h"
+#include "Clip.h"
+#include "ProjectMetadata.h"
+#include "MessageThreadWatchdog.h"
+#include "TaskPool.h"
 
 namespace VCS
 {
 
 #define DIFF_BUILD_THREAD_STOP_TIMEOUT 5000
+#define HEAD_CHECKPOINT_INTERVAL 50
 
 Head::Head(const Head &other) :
     Thread("Diff Thread"),
@@ -46,6 +55,14 @@ Head::Head(TrackedItemsSource &targetProject) :
     headingAt(new Revision()),
     state(new Snapshot()) {}
 
+Head::~Head()
+{
+    if (this->pendingMove != nullptr)
+    {
+        this->pendingMove->token.cancel();
+    }
+}
+
 Revision::Ptr Head::getHeadingRevision() const
 {
     return this->headingAt;
@@ -102,6 +119,7 @@ void Head::setRebuildingDiffMode(bool isBuildingNow)
 void Head::mergeStateWith(Revision::Ptr changes)
 {
     DBG("Head::mergeStateWith " + changes->getUuid());
+    this->markAllItemsAsDirty();
 
     Revision::Ptr headRevision(this->getHeadingRevision());
     for (auto *changesItem : changes->getItems())
@@ -134,17 +152,36 @@ void Head::mergeStateWith(Revision::Ptr changes)
     }
 }
 
-bool Head::moveTo(const Revision::Ptr revision)
+static void applyRevisionItems(Snapshot &state, const Revision &revision)
 {
-    if (this->isThreadRunning())
+    for (auto *item : revision.getItems())
     {
-        this->stopThread(DIFF_BUILD_THREAD_STOP_TIMEOUT);
+        if (item->getType() == RevisionItem::Type::Added)
+        {
+            state.addItem(item);
+        }
+        else if (item->getType() == RevisionItem::Type::Removed)
+        {
+            state.removeItem(item);
+        }
+        else if (item->getType() == RevisionItem::Type::Changed)
+        {
+            state.mergeItem(item);
+        }
+        else
+        {
+            jassertfalse;
+        }
     }
+}
 
-    // first, reset the snapshot state
+bool Head::moveTo(const Revision::Ptr revision)
+{
+    this->finishPendingMove();
+
+    if (this->isThreadRunning())
     {
-        const ScopedWriteLock lock(this->stateLock);
-        this->state.reset(new Snapshot());
+        this->stopThread(DIFF_BUILD_THREAD_STOP_TIMEOUT);
     }
 
     // a path from the root to current revision
@@ -152,37 +189,63 @@ bool Head::moveTo(const Revision::Ptr revision)
     Revision::Ptr currentRevision(revision);
     while (currentRevision != nullptr)
     {
-        treePath.insert(0, currentRevision);
+        treePath.add(currentRevision);
         currentRevision = currentRevision->getParent();
     }
 
-    // then move from the root back to target revision
-    for (const auto *rev : treePath)
+    // the hashes of all the path's prefixes, starting from the root
+    Array<HashCode> pathHashes;
+    pathHashes.insertMultiple(0, 0, treePath.size());
+    uint64 pathHash = 0;
+    for (int i = treePath.size(); --i >= 0;)
+    {
+        const auto *rev = treePath.getUnchecked(i);
+        pathHash = (pathHash ^ uint64(rev->getUuid().hashCode64())) * 1099511628211ULL;
+        pathHash = (pathHash ^ rev->getDeltasVersion()) * 1099511628211ULL;
+        pathHashes.setUnchecked(i, HashCode(pathHash));
+    }
+
+    // then start from the nearest cached ancestor, if any
+    int numRevisionsToApply = treePath.size();
+    UniquePointer<Snapshot> newState(new Snapshot());
+    for (int i = 0; i < treePath.size(); ++i)
     {
+        const auto checkpoint = this->checkpoints.find(treePath.getUnchecked(i)->getUuid());
+        if (checkpoint != this->checkpoints.end() &&
+            checkpoint->second.pathHash == pathHashes.getUnchecked(i))
+        {
+            newState.reset(new Snapshot(*checkpoint->second.state));
+            numRevisionsToApply = i;
+            break;
+        }
+    }
+
+    // and move from there back to target revision
+    for (int i = numRevisionsToApply; --i >= 0;)
+    {
+        const auto *rev = treePath.getUnchecked(i);
         DBG("VCS head moved to " + rev->getUuid());
 
         // picking all deltas and applying them to current state
-        for (auto *item : rev->getItems())
+        applyRevisionItems(*newState, *rev);
+
+        const int depth = treePath.size() - 1 - i;
+        const bool isBranchingPoint = rev->getChildren().size() > 1;
+        if (isBranchingPoint || (depth > 0 && depth % HEAD_CHECKPOINT_INTERVAL == 0))
         {
-            if (item->getType() == RevisionItem::Type::Added)
-            {
-                this->state->addItem(item);
-            }
-            else if (item->getType() == RevisionItem::Type::Removed)
-            {
-                this->state->removeItem(item);
-            }
-            else if (item->getType() == RevisionItem::Type::Changed)
-            {
-                this->state->mergeItem(item);
-            }
-            else
-            {
-                jassertfalse;
-            }
+            auto &checkpoint = this->checkpoints[rev->getUuid()];
+            checkpoint.pathHash = pathHashes.getUnchecked(i);
+            checkpoint.state.reset(new Snapshot(*newState));
         }
     }
 
+    {
+        const ScopedWriteLock lock(this->stateLock);
+        this->state = std::move(newState);
+    }
+
+    this->markAllItemsAsDirty();
+
     this->headingAt = revision;
     this->setDiffOutdated(true);
     return true;
@@ -190,10 +253,100 @@ bool Head::moveTo(const Revision::Ptr revision)
 
 void Head::pointTo(const Revision::Ptr revision)
 {
+    this->finishPendingMove();
     this->headingAt = revision;
     this->setDiffOutdated(true);
 }
 
+void Head::moveToNewChild(const Revision::Ptr child, Function<void()> publish)
+{
+    jassert(child->getParent() == nullptr);
+    this->finishPendingMove();
+
+    // the revision items never change, so the worker only reads them
+    // and the copy of the state, which only holds the pointers to the items
+    struct MergedState final : ReferenceCountedObject
+    {
+        UniquePointer<Snapshot> state;
+    };
+
+    ReferenceCountedObjectPtr<MergedState> merged(new MergedState());
+
+    {
+        const ScopedReadLock lock(this->stateLock);
+        merged->state.reset(new Snapshot(*this->state));
+    }
+
+    this->pendingMove.reset(new PendingMove());
+    this->pendingMove->parent = this->headingAt;
+    this->pendingMove->child = child;
+    this->pendingMove->publish = publish;
+
+    App::Tasks().run([merged, child]()
+    {
+        applyRevisionItems(*merged->state, *child);
+    },
+    TaskPool::Priority::High, this->pendingMove->token, [this, merged]()
+    {
+        this->publishPendingMove(std::move(merged->state));
+    });
+
+    // for the stage view to show the progress
+    this->sendChangeMessage();
+}
+
+bool Head::hasPendingMove() const noexcept
+{
+    return this->pendingMove != nullptr;
+}
+
+void Head::finishPendingMove()
+{
+    if (this->pendingMove == nullptr)
+    {
+        return;
+    }
+
+    this->pendingMove->token.cancel();
+
+    UniquePointer<Snapshot> newState;
+
+    {
+        const ScopedReadLock lock(this->stateLock);
+        newState.reset(new Snapshot(*this->state));
+    }
+
+    applyRevisionItems(*newState, *this->pendingMove->child);
+    this->publishPendingMove(std::move(newState));
+}
+
+void Head::publishPendingMove(UniquePointer<Snapshot> newState)
+{
+    jassert(this->pendingMove != nullptr);
+    UniquePointer<PendingMove> move(this->pendingMove.release());
+
+    // nothing else can move the head without finishing this move first
+    jassert(this->headingAt == move->parent);
+
+    move->publish();
+
+    if (this->isThreadRunning())
+    {
+        this->stopThread(DIFF_BUILD_THREAD_STOP_TIMEOUT);
+    }
+
+    {
+        const ScopedWriteLock lock(this->stateLock);
+        this->state = std::move(newState);
+    }
+
+    this->markAllItemsAsDirty();
+
+    this->headingAt = move->child;
+    this->setDiffOutdated(true);
+    this->sendChangeMessage();
+}
+
 
 bool Head::resetChangedItemToState(const RevisionItem::Ptr diffItem)
 {
@@ -201,19 +354,9 @@ bool Head::resetChangedItemToState(const RevisionItem::Ptr diffItem)
     { return false; }
 
     // на входе - один из айтемов диффа
-    TrackedItem *sourceItem = nullptr;
-
     // ищем в собранном состоянии айтем с соответствующим уидом
-    for (int i = 0; i < this->state->getNumTrackedItems(); ++i)
-    {
-        auto *item = this->state->getTrackedItem(i);
-
-        if (item->getUuid() == diffItem->getUuid())
-        {
-            sourceItem = item;
-            break;
-        }
-    }
+    const RevisionItem::Ptr stateItem = this->state->getItemWithUuid(diffItem->getUuid());
+    TrackedItem *sourceItem = stateItem.get();
 
     // обработать тип - добавлено, удалено, изменено
     if (diffItem->getType() == RevisionItem::Type::Changed)
@@ -472,6 +615,8 @@ void Head::deserialize(const SerializedData &data)
 void Head::reset()
 {
     this->state.reset(new Snapshot());
+    this->checkpoints.clear();
+    this->markAllItemsAsDirty();
     this->setDiffOutdated(true);
 }
 
@@ -485,123 +630,157 @@ void Head::changeListenerCallback(ChangeBroadcaster *source)
     this->setDiffOutdated(true);
 }
 
-
 //===----------------------------------------------------------------------===//
-// Thread
+// ProjectListener
 //===----------------------------------------------------------------------===//
 
-void Head::run()
+void Head::onAddMidiEvent(const MidiEvent &event)
 {
-    if (this->state == nullptr)
-    { return; }
-    
-    this->setRebuildingDiffMode(true);
-    this->sendChangeMessage();
+    this->markItemAsDirty(event.getSequence()->getTrack());
+}
+
+void Head::onChangeMidiEvent(const MidiEvent &oldEvent, const MidiEvent &newEvent)
+{
+    this->markItemAsDirty(newEvent.getSequence()->getTrack());
+}
+
+void Head::onRemoveMidiEvent(const MidiEvent &event)
+{
+    this->markItemAsDirty(event.getSequence()->getTrack());
+}
 
+// all events of a group belong to the same sequence
+void Head::onAddMidiEvents(const Array<const MidiEvent *> &events)
+{
+    if (!events.isEmpty())
     {
-        const ScopedWriteLock lock(this->diffLock);
-        this->diff->reset();
+        this->onAddMidiEvent(*events.getFirst());
     }
+}
 
-    const ScopedReadLock threadStateLock(this->stateLock);
+void Head::onChangeMidiEvents(const Array<const MidiEvent *> &oldEvents,
+    const Array<const MidiEvent *> &newEvents)
+{
+    if (!newEvents.isEmpty())
+    {
+        this->onChangeMidiEvent(*oldEvents.getFirst(), *newEvents.getFirst());
+    }
+}
 
-    for (int i = 0; i < this->state->getNumTrackedItems(); ++i)
+void Head::onRemoveMidiEvents(const Array<const MidiEvent *> &events)
+{
+    if (!events.isEmpty())
     {
-        if (this->threadShouldExit())
-        {
-            this->setRebuildingDiffMode(false);
-            this->sendChangeMessage();
-            return;
-        }
+        this->onRemoveMidiEvent(*events.getFirst());
+    }
+}
 
-        bool foundItemInTarget = false;
-        const RevisionItem::Ptr stateItem = static_cast<RevisionItem *>(this->state->getTrackedItem(i));
+void Head::onAddClip(const Clip &clip)
+{
+    this->markItemAsDirty(clip.getPattern()->getTrack());
+}
 
-        // will check `removed` records later
-        if (stateItem->getType() == RevisionItem::Type::Removed) { continue; }
+void Head::onChangeClip(const Clip &oldClip, const Clip &newClip)
+{
+    this->markItemAsDirty(newClip.getPattern()->getTrack());
+}
 
-        for (int j = 0; j < this->targetVcsItemsSource.getNumTrackedItems(); ++j)
-        {
-            if (this->threadShouldExit())
-            {
-                this->setRebuildingDiffMode(false);
-                this->sendChangeMessage();
-                return;
-            }
+void Head::onRemoveClip(const Clip &clip)
+{
+    this->markItemAsDirty(clip.getPattern()->getTrack());
+}
 
-            TrackedItem *targetItem = this->targetVcsItemsSource.getTrackedItem(j); // i.e. LayerTreeItem
+void Head::onAddTrack(MidiTrack *const track)
+{
+    this->markItemAsDirty(track);
+}
 
-            // state item exists in project, adding `changed` record, if needed
-            if (stateItem->getUuid() == targetItem->getUuid())
-            {
-                foundItemInTarget = true;
+void Head::onRemoveTrack(MidiTrack *const track)
+{
+    this->markItemAsDirty(track);
+}
 
-                UniquePointer<Diff> itemDiff(targetItem->getDiffLogic()->createDiff(*stateItem));
+void Head::onChangeTrackProperties(MidiTrack *const track)
+{
+    this->markItemAsDirty(track);
+}
 
-                if (itemDiff->hasAnyChanges())
-                {
-                    RevisionItem::Ptr revisionRecord(new RevisionItem(RevisionItem::Type::Changed, itemDiff.get()));
-                    const ScopedWriteLock itemDiffLock(this->diffLock);
-                    this->diff->addItem(revisionRecord);
-                }
+void Head::onChangeProjectInfo(const ProjectMetadata *info)
+{
+    if (const auto *item = dynamic_cast<const TrackedItem *>(info))
+    {
+        this->markItemAsDirty(item->getUuid());
+    }
+    else
+    {
+        this->markAllItemsAsDirty();
+    }
+}
 
-                break;
-            }
-        }
+void Head::onReloadProjectContent(const Array<MidiTrack *> &tracks)
+{
+    this->markAllItemsAsDirty();
+}
 
-        // state item was not found in project, adding `removed` record
-        if (! foundItemInTarget)
-        {
-            UniquePointer<Diff> emptyDiff(new Diff(*stateItem));
-            RevisionItem::Ptr revisionRecord(new RevisionItem(RevisionItem::Type::Removed, emptyDiff.get()));
-            const ScopedWriteLock emptyDiffLock(this->diffLock);
-            this->diff->addItem(revisionRecord);
-        }
+void Head::markItemAsDirty(const MidiTrack *track)
+{
+    // the timeline sequences are not tracked items themselves,
+    // they all belong to the timeline, so just rebuild everything
+    if (const auto *item = dynamic_cast<const TrackedItem *>(track))
+    {
+        this->markItemAsDirty(item->getUuid());
     }
-
-    // search for project item that are missing (or deleted) in the state
-    for (int i = 0; i < this->targetVcsItemsSource.getNumTrackedItems(); ++i)
+    else
     {
-        if (this->threadShouldExit())
-        {
-            this->setRebuildingDiffMode(false);
-            this->sendChangeMessage();
-            return;
-        }
+        this->markAllItemsAsDirty();
+    }
+}
 
-        bool foundItemInState = false;
-        TrackedItem *targetItem = this->targetVcsItemsSource.getTrackedItem(i);
+void Head::markItemAsDirty(const Uuid &uuid)
+{
+    const SpinLock::ScopedLockType lock(this->dirtyItemsLock);
+    this->dirtyItems.insert(uuid);
+}
 
-        for (int j = 0; j < this->state->getNumTrackedItems(); ++j)
-        {
-            const RevisionItem::Ptr stateItem = static_cast<RevisionItem *>(this->state->getTrackedItem(j));
+void Head::markAllItemsAsDirty()
+{
+    const SpinLock::ScopedLockType lock(this->dirtyItemsLock);
+    this->allItemsAreDirty = true;
+}
 
-            if (stateItem->getType() == RevisionItem::Type::Removed) { continue; }
+bool Head::hasDirtyItems() const
+{
+    const SpinLock::ScopedLockType lock(this->dirtyItemsLock);
+    return this->allItemsAreDirty || !this->dirtyItems.empty();
+}
 
-            if (stateItem->getUuid() == targetItem->getUuid())
-            {
-                foundItemInState = true;
-                break;
-            }
-        }
 
-        // copy deltas from targetItem and add `added` record
-        if (! foundItemInState)
-        {
-            RevisionItem::Ptr revisionRecord(new RevisionItem(RevisionItem::Type::Added, targetItem));
-            const ScopedWriteLock lock(this->diffLock);
-            this->diff->addItem(revisionRecord);
-        }
+//===----------------------------------------------------------------------===//
+// Thread
+//===----------------------------------------------------------------------===//
+
+void Head::run()
+{
+    if (this->state == nullptr)
+    { return; }
+    
+    this->setRebuildingDiffMode(true);
+    this->sendChangeMessage();
+
+    if (this->rebuildDiff(true))
+    {
+        // something might have changed while rebuilding
+        this->setDiffOutdated(this->hasDirtyItems());
     }
 
-    this->setDiffOutdated(false);
     this->setRebuildingDiffMode(false);
     this->sendChangeMessage();
 }
 
-// FIXME: lots of duplicate code from Head::run
 void Head::rebuildDiffSynchronously()
 {
+    WATCHDOG_SCOPE("Head::rebuildDiffSynchronously");
+
     if (this->state == nullptr)
     { return; }
     
@@ -609,85 +788,191 @@ void Head::rebuildDiffSynchronously()
     { return; }
     
     this->setRebuildingDiffMode(true);
-    
+    this->rebuildDiff(false);
+    this->setDiffOutdated(false);
+    this->setRebuildingDiffMode(false);
+    this->sendChangeMessage();
+}
+
+// Both sides are matched by uuids via the hash map, so the matching takes
+// a single pass over the state and another one over the project items;
+// the items' diffs are independent, so they are then computed in parallel,
+// and the records are added in the same order as they were matched;
+// returns false if the thread was asked to exit before it's finished
+bool Head::rebuildDiff(bool canBeInterrupted)
+{
     {
         const ScopedWriteLock lock(this->diffLock);
         this->diff->reset();
     }
-    
+
+    FlatHashSet<Uuid, UuidHash> dirtyItems;
+    bool allItemsAreDirty = false;
+
+    {
+        const SpinLock::ScopedLockType lock(this->dirtyItemsLock);
+        dirtyItems.swap(this->dirtyItems);
+        allItemsAreDirty = this->allItemsAreDirty;
+        this->allItemsAreDirty = false;
+    }
+
+    // if cancelled, the next rebuild will need to diff them all the same
+    const auto restoreDirtyItems = [&]()
+    {
+        const SpinLock::ScopedLockType lock(this->dirtyItemsLock);
+        this->allItemsAreDirty = this->allItemsAreDirty || allItemsAreDirty;
+        for (const auto &uuid : dirtyItems)
+        {
+            this->dirtyItems.insert(uuid);
+        }
+    };
+
+    if (allItemsAreDirty)
+    {
+        this->cachedRecords.clear();
+    }
+
     const ScopedReadLock rebuildStateLock(this->stateLock);
-    
+
+    const int numTargetItems = this->targetVcsItemsSource.getNumTrackedItems();
+    FlatHashMap<Uuid, TrackedItem *, UuidHash> targetItems;
+    targetItems.reserve(numTargetItems);
+    for (int i = 0; i < numTargetItems; ++i)
+    {
+        auto *targetItem = this->targetVcsItemsSource.getTrackedItem(i); // i.e. LayerTreeItem
+        targetItems[targetItem->getUuid()] = targetItem;
+    }
+
+    struct PendingRecord final
+    {
+        RevisionItem::Type type;
+        RevisionItem *stateItem;
+        TrackedItem *targetItem;
+        RevisionItem::Ptr result;
+        bool isCached;
+
+        const Uuid &getUuid() const noexcept
+        {
+            return this->stateItem != nullptr ?
+                this->stateItem->getUuid() : this->targetItem->getUuid();
+        }
+    };
+
+    Array<PendingRecord> records;
+    records.ensureStorageAllocated(this->state->getNumTrackedItems() + numTargetItems);
+
+    FlatHashSet<Uuid, UuidHash> foundInState;
+    foundInState.reserve(numTargetItems);
+
     for (int i = 0; i < this->state->getNumTrackedItems(); ++i)
     {
-        bool foundItemInTarget = false;
-        const RevisionItem::Ptr stateItem = static_cast<RevisionItem *>(this->state->getTrackedItem(i));
-        
+        auto *stateItem = static_cast<RevisionItem *>(this->state->getTrackedItem(i));
+
         // will check `removed` records later
         if (stateItem->getType() == RevisionItem::Type::Removed) { continue; }
-        
-        for (int j = 0; j < this->targetVcsItemsSource.getNumTrackedItems(); ++j)
+
+        const auto targetItem = targetItems.find(stateItem->getUuid());
+
+        // state item exists in project, adding `changed` record, if needed
+        if (targetItem != targetItems.end())
         {
-            TrackedItem *targetItem = this->targetVcsItemsSource.getTrackedItem(j); // i.e. LayerTreeItem
-            
-            // state item exists in project, adding `changed` record, if needed
-            if (stateItem->getUuid() == targetItem->getUuid())
-            {
-                foundItemInTarget = true;
-                
-                UniquePointer<Diff> itemDiff(targetItem->getDiffLogic()->createDiff(*stateItem));
-                
-                if (itemDiff->hasAnyChanges())
-                {
-                    RevisionItem::Ptr revisionRecord(new RevisionItem(RevisionItem::Type::Changed, itemDiff.get()));
-                    const ScopedWriteLock lock(this->diffLock);
-                    this->diff->addItem(revisionRecord);
-                }
-                
-                break;
-            }
+            foundInState.insert(targetItem->first);
+            records.add({ RevisionItem::Type::Changed, stateItem, targetItem->second, nullptr, false });
         }
-        
         // state item was not found in project, adding `removed` record
-        if (! foundItemInTarget)
+        else
         {
-            UniquePointer<Diff> emptyDiff(new Diff(*stateItem));
-            RevisionItem::Ptr revisionRecord(new RevisionItem(RevisionItem::Type::Removed, emptyDiff.get()));
-            const ScopedWriteLock lock(this->diffLock);
-            this->diff->addItem(revisionRecord);
+            records.add({ RevisionItem::Type::Removed, stateItem, nullptr, nullptr, false });
         }
     }
-    
-    // search for project item that are missing (or deleted) in the state
-    for (int i = 0; i < this->targetVcsItemsSource.getNumTrackedItems(); ++i)
+
+    // search for project item that are missing (or deleted) in the state,
+    // keeping the order of the project items for the `added` records
+    for (int i = 0; i < numTargetItems; ++i)
     {
-        bool foundItemInState = false;
-        TrackedItem *targetItem = this->targetVcsItemsSource.getTrackedItem(i);
-        
-        for (int j = 0; j < this->state->getNumTrackedItems(); ++j)
+        auto *targetItem = this->targetVcsItemsSource.getTrackedItem(i);
+        if (!foundInState.contains(targetItem->getUuid()))
         {
-            const RevisionItem::Ptr stateItem = static_cast<RevisionItem *>(this->state->getTrackedItem(j));
-            
-            if (stateItem->getType() == RevisionItem::Type::Removed) { continue; }
-            
-            if (stateItem->getUuid() == targetItem->getUuid())
+            records.add({ RevisionItem::Type::Added, nullptr, targetItem, nullptr, false });
+        }
+    }
+
+    // the items not changed since the last rebuild get the same records
+    for (auto &record : records)
+    {
+        const auto &uuid = record.getUuid();
+        const auto cached = this->cachedRecords.find(uuid);
+        if (cached != this->cachedRecords.end() &&
+            cached->second.type == record.type &&
+            !dirtyItems.contains(uuid))
+        {
+            record.result = cached->second.result;
+            record.isCached = true;
+        }
+    }
+
+    const auto createRecord = [](PendingRecord &record)
+    {
+        if (record.isCached)
+        {
+            return;
+        }
+
+        if (record.type == RevisionItem::Type::Changed)
+        {
+            UniquePointer<Diff> itemDiff(record.targetItem->getDiffLogic()->createDiff(*record.stateItem));
+            if (itemDiff->hasAnyChanges())
             {
-                foundItemInState = true;
-                break;
+                record.result = new RevisionItem(RevisionItem::Type::Changed, itemDiff.get());
             }
         }
-        
-        // copy deltas from targetItem and add `added` record
-        if (! foundItemInState)
+        else if (record.type == RevisionItem::Type::Removed)
+        {
+            UniquePointer<Diff> emptyDiff(new Diff(*record.stateItem));
+            record.result = new RevisionItem(RevisionItem::Type::Removed, emptyDiff.get());
+        }
+        else if (record.type == RevisionItem::Type::Added)
+        {
+            // copy deltas from targetItem and add `added` record
+            record.result = new RevisionItem(RevisionItem::Type::Added, record.targetItem);
+        }
+    };
+
+    // the shared workers and this thread pick the pending records,
+    // until there are none left, or until the thread is asked to exit
+    TaskPool::CancellationToken cancellation;
+    App::Tasks().parallelFor(records.size(), [&](int i)
+    {
+        if (canBeInterrupted && this->threadShouldExit())
         {
-            RevisionItem::Ptr revisionRecord(new RevisionItem(RevisionItem::Type::Added, targetItem));
-            const ScopedWriteLock lock(this->diffLock);
-            this->diff->addItem(revisionRecord);
+            cancellation.cancel();
+            return;
         }
+
+        createRecord(records.getReference(i));
+    }, cancellation);
+
+    if (cancellation.isCancelled())
+    {
+        restoreDirtyItems();
+        return false;
     }
-    
-    this->setDiffOutdated(false);
-    this->setRebuildingDiffMode(false);
-    this->sendChangeMessage();
+
+    this->cachedRecords.clear();
+    this->cachedRecords.reserve(records.size());
+
+    const ScopedWriteLock lock(this->diffLock);
+    for (const auto &record : records)
+    {
+        this->cachedRecords[record.getUuid()] = { record.type, record.result };
+
+        if (record.result != nullptr)
+        {
+            this->diff->addItem(record.result);
+        }
+    }
+
+    return true;
 }
 
 }
@@ -19,6 +19,8 @@
 
 #include "Snapshot.h"
 #include "Revision.h"
+#include "ProjectListener.h"
+#include "TaskPool.h"
 
 namespace VCS
 {
@@ -29,12 +31,14 @@ namespace VCS
         private Thread,
         public ChangeListener, // listens to project changes to set diff outdated
         public ChangeBroadcaster, // broadcasts the diff rebuild has started/ended
+        public ProjectListener, // collects the items changed since the last diff rebuild
         public Serializable
     {
     public:
 
         Head(const Head &other);
         explicit Head(TrackedItemsSource &targetProject);
+        ~Head() override;
 
         Revision::Ptr getHeadingRevision() const;
         
@@ -52,6 +56,14 @@ namespace VCS
         bool moveTo(const Revision::Ptr revision); // rebuilds state index
         void pointTo(const Revision::Ptr revision); // does not rebuild index
 
+        // Moves to a new revision on top of the heading one, like moveTo does,
+        // but the new state is merged from a copy of the current one on a worker;
+        // when it's done, the publish callback adds the revision to the tree,
+        // and the new state replaces the current one, both on the message thread;
+        // moving the head meanwhile finishes the pending move synchronously first
+        void moveToNewChild(const Revision::Ptr child, Function<void()> publish);
+        bool hasPendingMove() const noexcept;
+
         void checkout();
         void cherryPick(const Array<Uuid> uuids);
         void cherryPickAll();
@@ -75,6 +87,32 @@ namespace VCS
 
         void changeListenerCallback(ChangeBroadcaster *source) override;
 
+        //===--------------------------------------------------------------===//
+        // ProjectListener
+        //===--------------------------------------------------------------===//
+
+        void onAddMidiEvent(const MidiEvent &event) override;
+        void onChangeMidiEvent(const MidiEvent &oldEvent, const MidiEvent &newEvent) override;
+        void onRemoveMidiEvent(const MidiEvent &event) override;
+
+        void onAddMidiEvents(const Array<const MidiEvent *> &events) override;
+        void onChangeMidiEvents(const Array<const MidiEvent *> &oldEvents,
+            const Array<const MidiEvent *> &newEvents) override;
+        void onRemoveMidiEvents(const Array<const MidiEvent *> &events) override;
+
+        void onAddClip(const Clip &clip) override;
+        void onChangeClip(const Clip &oldClip, const Clip &newClip) override;
+        void onRemoveClip(const Clip &clip) override;
+
+        void onAddTrack(MidiTrack *const track) override;
+        void onRemoveTrack(MidiTrack *const track) override;
+        void onChangeTrackProperties(MidiTrack *const track) override;
+
+        void onChangeProjectInfo(const ProjectMetadata *info) override;
+        void onChangeProjectBeatRange(float firstBeat, float lastBeat) override {}
+        void onChangeViewBeatRange(float firstBeat, float lastBeat) override {}
+        void onReloadProjectContent(const Array<MidiTrack *> &tracks) override;
+
     private:
 
         //===--------------------------------------------------------------===//
@@ -82,6 +120,7 @@ namespace VCS
         //===--------------------------------------------------------------===//
 
         void run() override;
+        bool rebuildDiff(bool canBeInterrupted);
         void checkoutItem(RevisionItem::Ptr stateItem);
         bool resetChangedItemToState(const RevisionItem::Ptr diffItem);
 
@@ -100,6 +139,57 @@ namespace VCS
         ReadWriteLock stateLock;
         UniquePointer<Snapshot> state;
 
+        // The states are cached at every few revisions on the way from the root,
+        // and at the branching points, so that moving the head replays only
+        // the revisions after the nearest cached ancestor; a checkpoint is only
+        // valid for the same path with the same deltas, see getDeltasVersion
+        struct Checkpoint final
+        {
+            HashCode pathHash = 0;
+            UniquePointer<Snapshot> state;
+        };
+
+        FlatHashMap<String, Checkpoint, StringHash> checkpoints;
+
+    private:
+
+        struct PendingMove final
+        {
+            Revision::Ptr parent;
+            Revision::Ptr child;
+            Function<void()> publish;
+            TaskPool::CancellationToken token;
+        };
+
+        UniquePointer<PendingMove> pendingMove;
+
+        void finishPendingMove();
+        void publishPendingMove(UniquePointer<Snapshot> newState);
+
+    private:
+
+        // The uuids of the items changed since the last diff rebuild, which
+        // are the only ones to be diffed again, and for the rest of the items
+        // the records of the last rebuild are reused; any change that can't be
+        // attributed to a single item, or any change of the state, resets all
+        void markItemAsDirty(const MidiTrack *track);
+        void markItemAsDirty(const Uuid &uuid);
+        void markAllItemsAsDirty();
+        bool hasDirtyItems() const;
+
+        mutable SpinLock dirtyItemsLock;
+        FlatHashSet<Uuid, UuidHash> dirtyItems;
+        bool allItemsAreDirty = true;
+
+        struct CachedRecord final
+        {
+            RevisionItem::Type type;
+            RevisionItem::Ptr result;
+        };
+
+        // only accessed by the diff rebuild
+        FlatHashMap<Uuid, CachedRecord, UuidHash> cachedRecords;
+
     private:
 
         TrackedItemsSource &targetVcsItemsSource;
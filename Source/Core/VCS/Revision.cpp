@@ -34,22 +34,90 @@ Revision::Revision(const RevisionDto &dto) :
 
 void Revision::copyDeltasFrom(Revision::Ptr other)
 {
+    this->loadPendingItems();
+    this->resetPackedItems();
     this->deltas.clearQuick();
-    for (auto *revItem : other->deltas)
+    for (auto *revItem : other->getItems())
     {
         this->deltas.add(revItem);
     }
+
+    this->deltasVersion++;
 }
 
 bool Revision::isEmpty() const noexcept
 {
-    return this->deltas.isEmpty() && this->children.isEmpty();
+    return this->deltas.isEmpty() && this->pendingItems.isEmpty() &&
+        this->packedItems.isEmpty() && this->children.isEmpty();
+}
+
+uint32 Revision::getDeltasVersion() const noexcept
+{
+    return this->deltasVersion;
 }
 
 bool Revision::isShallowCopy() const noexcept
 {
     // children might me not empty though:
-    return this->deltas.isEmpty();
+    return this->deltas.isEmpty() && this->pendingItems.isEmpty() && this->packedItems.isEmpty();
+}
+
+bool Revision::isPacked() const noexcept
+{
+    return !this->packedItems.isEmpty();
+}
+
+size_t Revision::getPackedSize() const noexcept
+{
+    return this->packedItems.getSize();
+}
+
+void Revision::pack() const
+{
+    const ScopedLock lock(this->pendingItemsLock);
+    if (!this->packedItems.isEmpty() ||
+        (this->deltas.isEmpty() && this->pendingItems.isEmpty()))
+    {
+        return;
+    }
+
+    SerializedData tree(Serialization::VCS::revision);
+    for (const auto *revItem : this->deltas)
+    {
+        tree.appendChild(revItem->serialize());
+    }
+
+    for (const auto &e : this->pendingItems)
+    {
+        tree.appendSharedChild(e);
+    }
+
+    MemoryOutputStream data;
+    tree.writeToStream(data);
+
+    MemoryOutputStream packed(data.getDataSize() / 4);
+    packed.writeCompressedInt(int(data.getDataSize()));
+
+    {
+        GZIPCompressorOutputStream compressor(packed);
+        compressor.write(data.getData(), data.getDataSize());
+        compressor.flush();
+    }
+
+    this->packedItems = packed.getMemoryBlock();
+
+    // the parsed items are still in use, so only the unparsed ones are dropped
+    this->packedItemsAreLoaded = !this->deltas.isEmpty();
+    if (!this->packedItemsAreLoaded)
+    {
+        this->pendingItems.clear();
+    }
+}
+
+void Revision::resetPackedItems()
+{
+    this->packedItems.reset();
+    this->packedItemsAreLoaded = false;
 }
 
 int64 Revision::getTimeStamp() const noexcept
@@ -67,11 +135,63 @@ String Revision::getMessage() const noexcept
     return this->message;
 }
 
-const ReferenceCountedArray<RevisionItem> &Revision::getItems() const noexcept
+const ReferenceCountedArray<RevisionItem> &Revision::getItems() const
 {
+    this->loadPendingItems();
     return this->deltas;
 }
 
+void Revision::loadPendingItems() const
+{
+    const ScopedLock lock(this->pendingItemsLock);
+    if (!this->packedItemsAreLoaded && !this->packedItems.isEmpty())
+    {
+        this->unpackItems();
+    }
+
+    if (this->pendingItems.isEmpty())
+    {
+        return;
+    }
+
+    this->deltas.ensureStorageAllocated(this->deltas.size() + this->pendingItems.size());
+    for (const auto &e : this->pendingItems)
+    {
+        RevisionItem::Ptr item(new RevisionItem(RevisionItem::Type::Undefined, nullptr));
+        item->deserialize(e);
+        this->deltas.add(item);
+    }
+
+    this->pendingItems.clear();
+}
+
+void Revision::unpackItems() const
+{
+    this->packedItemsAreLoaded = true;
+
+    MemoryInputStream packed(this->packedItems, false);
+    const auto unpackedSize = packed.readCompressedInt();
+    if (unpackedSize <= 0)
+    {
+        jassertfalse;
+        return;
+    }
+
+    MemoryBlock unpacked(size_t(unpackedSize));
+    GZIPDecompressorInputStream decompressor(packed);
+    if (decompressor.read(unpacked.getData(), unpackedSize) != unpackedSize)
+    {
+        jassertfalse;
+        return;
+    }
+
+    const auto tree = SerializedData::readFromData(unpacked.getData(), unpacked.getSize());
+    forEachChildWithType(tree, e, Serialization::VCS::revisionItem)
+    {
+        this->pendingItems.add(e);
+    }
+}
+
 const ReferenceCountedArray<Revision> &Revision::getChildren() const  noexcept
 {
     return this->children;
@@ -104,12 +224,18 @@ void Revision::removeChild(Revision::Ptr revision)
 
 void Revision::addItem(RevisionItem *item)
 {
+    this->loadPendingItems();
+    this->resetPackedItems();
     this->deltas.add(item);
+    this->deltasVersion++;
 }
 
 void Revision::addItem(RevisionItem::Ptr item)
 {
+    this->loadPendingItems();
+    this->resetPackedItems();
     this->deltas.add(item);
+    this->deltasVersion++;
 }
 
 WeakReference<Revision> Revision::getParent() const noexcept
@@ -121,15 +247,40 @@ WeakReference<Revision> Revision::getParent() const noexcept
 // Serializable
 //===----------------------------------------------------------------------===//
 
-SerializedData Revision::serializeDeltas() const
+void Revision::serializeItems(SerializedData &tree, bool allowPacked) const
 {
-    SerializedData tree(Serialization::VCS::revision);
+    const ScopedLock lock(this->pendingItemsLock);
+
+    if (allowPacked && !this->packedItems.isEmpty())
+    {
+        SerializedData packed(Serialization::VCS::packedRevisionItems);
+        packed.setProperty(Serialization::VCS::packedRevisionItemsData, var(this->packedItems));
+        tree.appendChild(packed);
+        return;
+    }
+
+    if (!this->packedItemsAreLoaded && !this->packedItems.isEmpty())
+    {
+        this->unpackItems();
+    }
 
     for (const auto *revItem : this->deltas)
     {
         tree.appendChild(revItem->serialize());
     }
 
+    // the nodes still belong to the loaded tree
+    for (const auto &e : this->pendingItems)
+    {
+        tree.appendSharedChild(e);
+    }
+}
+
+SerializedData Revision::serializeDeltas() const
+{
+    // the packed items are only understood locally, so the full ones are sent
+    SerializedData tree(Serialization::VCS::revision);
+    this->serializeItems(tree, false);
     return tree;
 }
 
@@ -144,6 +295,8 @@ void Revision::deserializeDeltas(SerializedData data)
     if (!root.isValid()) { return; }
 
     this->deltas.clearQuick();
+    this->resetPackedItems();
+    this->deltasVersion++;
 
     forEachChildWithType(root, e, Serialization::VCS::revisionItem)
     {
@@ -161,10 +314,7 @@ SerializedData Revision::serialize() const
     tree.setProperty(Serialization::VCS::commitMessage, this->message);
     tree.setProperty(Serialization::VCS::commitTimeStamp, this->timestamp);
 
-    for (const auto *revItem : this->deltas)
-    {
-        tree.appendChild(revItem->serialize());
-    }
+    this->serializeItems(tree, true);
 
     for (const auto *child : this->children)
     {
@@ -198,9 +348,19 @@ void Revision::deserialize(const SerializedData &data)
         }
         else if (e.hasType(Serialization::VCS::revisionItem))
         {
-            RevisionItem::Ptr item(new RevisionItem(RevisionItem::Type::Undefined, nullptr));
-            item->deserialize(e);
-            this->addItem(item);
+            this->pendingItems.add(e);
+        }
+        else if (e.hasType(Serialization::VCS::packedRevisionItems))
+        {
+            const auto data = e.getProperty(Serialization::VCS::packedRevisionItemsData);
+            if (const auto *block = data.getBinaryData())
+            {
+                this->packedItems = *block;
+            }
+            else if (data.isString())
+            {
+                this->packedItems.fromBase64Encoding(data.toString());
+            }
         }
     }
 }
@@ -211,6 +371,9 @@ void Revision::reset()
     this->message = {};
     this->timestamp = 0;
     this->deltas.clearQuick();
+    this->pendingItems.clearQuick();
+    this->resetPackedItems();
+    this->deltasVersion++;
     this->children.clearQuick();
 }
 
@@ -39,7 +39,7 @@ namespace VCS
         Revision(const String &name = {});
         Revision(const RevisionDto &remoteDescription); // creates shallow copy
 
-        const ReferenceCountedArray<RevisionItem> &getItems() const noexcept;
+        const ReferenceCountedArray<RevisionItem> &getItems() const;
         const ReferenceCountedArray<Revision> &getChildren() const noexcept;
 
         void addItem(RevisionItem *item);
@@ -55,12 +55,23 @@ namespace VCS
 
         bool isShallowCopy() const noexcept;
 
+        // Packs all items into a single compressed blob, which is saved as is,
+        // and only unpacked on the first access, see loadPendingItems;
+        // only makes sense for the old revisions, which are rarely looked at
+        void pack() const;
+        bool isPacked() const noexcept;
+        size_t getPackedSize() const noexcept;
+
         WeakReference<Revision> getParent() const noexcept;
         String getMessage() const noexcept;
         String getUuid() const noexcept;
         int64 getTimeStamp() const noexcept;
         bool isEmpty() const noexcept;
 
+        // changes whenever the deltas are added or replaced,
+        // which invalidates the head states cached for the descendants
+        uint32 getDeltasVersion() const noexcept;
+
         //===--------------------------------------------------------------===//
         // Serializable
         //===--------------------------------------------------------------===//
@@ -83,7 +94,24 @@ namespace VCS
         int64 timestamp;
 
         ReferenceCountedArray<Revision> children;
-        ReferenceCountedArray<RevisionItem> deltas;
+        mutable ReferenceCountedArray<RevisionItem> deltas;
+        uint32 deltasVersion = 0;
+
+        // The items of the loaded revisions are only parsed on the first
+        // access, since most of the history is never looked at, and
+        // they are saved as they were, if they were never accessed
+        mutable Array<SerializedData> pendingItems;
+        mutable CriticalSection pendingItemsLock;
+
+        // The packed items are kept even after they're unpacked, until
+        // the items change, so that saving doesn't need to re-pack them
+        mutable MemoryBlock packedItems;
+        mutable bool packedItemsAreLoaded = false;
+
+        void loadPendingItems() const;
+        void unpackItems() const;
+        void resetPackedItems();
+        void serializeItems(SerializedData &tree, bool allowPacked) const;
 
         JUCE_DECLARE_WEAK_REFERENCEABLE(Revision)
         JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Revision)
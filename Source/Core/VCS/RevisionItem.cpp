@@ -18,6 +18,7 @@
 #include "Common.h"
 #include "RevisionItem.h"
 #include "DiffLogic.h"
+#include "PianoSequence.h"
 
 namespace VCS
 {
@@ -39,6 +40,7 @@ RevisionItem::RevisionItem(Type type, TrackedItem *targetToCopy) :
             this->deltas.add(targetDelta->createCopy());
             SerializedData data(targetToCopy->getDeltaData(i));
             this->deltasData.add(data);
+            this->deltasHashes.add(targetToCopy->getDeltaHash(i));
             //jassert(!data.getParent().isValid());
         }
     }
@@ -86,6 +88,26 @@ SerializedData RevisionItem::getDeltaData(int deltaIndex) const noexcept
     return this->deltasData[deltaIndex];
 }
 
+HashCode RevisionItem::getDeltaHash(int deltaIndex) const
+{
+    const SpinLock::ScopedLockType lock(this->deltasHashesLock);
+
+    if (this->deltasHashes.size() != this->deltas.size())
+    {
+        this->deltasHashes.clearQuick();
+        for (int i = 0; i < this->deltas.size(); ++i)
+        {
+            const bool isNotesDelta = this->deltas.getUnchecked(i)->
+                hasType(Serialization::VCS::PianoSequenceDeltas::notesAdded);
+
+            this->deltasHashes.add(isNotesDelta ?
+                PianoSequence::getNotesHash(this->deltasData[i]) : 0);
+        }
+    }
+
+    return this->deltasHashes[deltaIndex];
+}
+
 String RevisionItem::getVCSName() const noexcept
 {
     return this->description;
@@ -116,11 +138,12 @@ SerializedData RevisionItem::serialize() const
         SerializedData deltaNode(delta->serialize());
         const SerializedData deltaData(this->getDeltaData(i));
 
-        // sometimes we need to create copy since serialized data cannot be shared between two parents
-        // but Snapshot seems to share revision items on checkout; need to fix this someday:
+        // the deltas data is never modified, so it is shared by reference
+        // between the revisions, the stashes and the snapshot, which all
+        // share the revision items, and the previously serialized trees
         if (deltaData.isValid())
         {
-            deltaNode.appendChild(deltaData.getParent().isValid() ? deltaData.createCopy() : deltaData);
+            deltaNode.appendSharedChild(deltaData);
             tree.appendChild(deltaNode);
         }
     }
@@ -168,6 +191,8 @@ void RevisionItem::deserialize(const SerializedData &data)
 void RevisionItem::reset()
 {
     this->deltas.clear();
+    this->deltasData.clear();
+    this->deltasHashes.clear();
     this->description.clear();
     this->vcsItemType = Type::Undefined;
 }
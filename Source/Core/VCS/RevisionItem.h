@@ -48,6 +48,7 @@ namespace VCS
         int getNumDeltas() const noexcept override;
         Delta *getDelta(int index) const noexcept override;
         SerializedData getDeltaData(int deltaIndex) const noexcept override;
+        HashCode getDeltaHash(int deltaIndex) const override;
 
         String getVCSName() const noexcept override;
         DiffLogic *getDiffLogic() const noexcept override;
@@ -67,6 +68,11 @@ namespace VCS
 
         OwnedArray<Delta> deltas;
         Array<SerializedData> deltasData;
+
+        // taken from the copied item or computed lazily after loading,
+        // since the revision items are never changed; zeros for no hash
+        mutable Array<HashCode> deltasHashes;
+        mutable SpinLock deltasHashesLock;
         UniquePointer<DiffLogic> logic;
 
         Type vcsItemType;
@@ -25,40 +25,23 @@ namespace VCS
 {
 
 Snapshot::Snapshot(const Snapshot &other) :
-    items(other.items) {}
+    items(other.items),
+    itemsIndex(other.itemsIndex) {}
 
 Snapshot::Snapshot(const Snapshot *other) :
-    items(other->items) {}
+    items(other->items),
+    itemsIndex(other->itemsIndex) {}
 
 void Snapshot::addItem(RevisionItem::Ptr item)
 {
-    RevisionItem::Ptr ownItem = this->getItemWithSameUuid(item);
-
-    if (ownItem == nullptr)
-    {
-        this->items.addIfNotAlreadyThere(item);
-    }
-    else
-    {
-        // ситуация, когда в состоянии есть removed запись, которую нужно заменить на added
-        this->items.removeAllInstancesOf(ownItem);
-        this->items.addIfNotAlreadyThere(item);
-    }
+    // also the case when the state has a `removed` record to be replaced with `added`
+    this->setItem(item);
 }
 
 void Snapshot::removeItem(RevisionItem::Ptr item)
 {
-    this->items.removeAllInstancesOf(item);
-
-    RevisionItem::Ptr ownItem = this->getItemWithSameUuid(item);
-
-    if (ownItem != nullptr)
-    {
-        this->items.removeAllInstancesOf(ownItem);
-    }
-
     // removed-запись
-    this->items.addIfNotAlreadyThere(item);
+    this->setItem(item);
 }
 
 void Snapshot::mergeItem(RevisionItem::Ptr newItem)
@@ -72,8 +55,7 @@ void Snapshot::mergeItem(RevisionItem::Ptr newItem)
         if (diff->hasAnyChanges())
         {
             RevisionItem::Ptr mergedItem(new RevisionItem(stateItem->getType(), diff.get()));
-            this->items.removeAllInstancesOf(stateItem);
-            this->items.add(mergedItem);
+            this->setItem(mergedItem);
         }
     }
     else
@@ -83,6 +65,20 @@ void Snapshot::mergeItem(RevisionItem::Ptr newItem)
     }
 }
 
+void Snapshot::setItem(RevisionItem::Ptr item)
+{
+    const auto found = this->itemsIndex.find(item->getUuid());
+    if (found != this->itemsIndex.end())
+    {
+        this->items.set(found->second, item);
+    }
+    else
+    {
+        this->itemsIndex[item->getUuid()] = this->items.size();
+        this->items.add(item);
+    }
+}
+
 //===----------------------------------------------------------------------===//
 // TrackedItemsSource
 //===----------------------------------------------------------------------===//
@@ -104,12 +100,10 @@ RevisionItem::Ptr Snapshot::getItemWithSameUuid(RevisionItem::Ptr item) const
 
 RevisionItem::Ptr Snapshot::getItemWithUuid(const Uuid &uuid) const
 {
-    for (auto &item : this->items)
+    const auto found = this->itemsIndex.find(uuid);
+    if (found != this->itemsIndex.end())
     {
-        if (item->getUuid() == uuid)
-        {
-            return item;
-        }
+        return this->items.getUnchecked(found->second);
     }
 
     return nullptr;
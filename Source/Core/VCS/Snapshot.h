@@ -54,8 +54,15 @@ namespace VCS
 
         RevisionItem::Ptr getItemWithSameUuid(RevisionItem::Ptr item) const;
 
+        // replaces the item with the same uuid in place, or appends it
+        void setItem(RevisionItem::Ptr item);
+
         Array<RevisionItem::Ptr> items;
 
+        // the items are never taken out, only replaced by their
+        // `removed` records, so the indices in the array stay valid
+        FlatHashMap<Uuid, int, UuidHash> itemsIndex;
+
         JUCE_LEAK_DETECTOR(Snapshot);
 
     };
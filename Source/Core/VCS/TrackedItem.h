@@ -40,6 +40,12 @@ namespace VCS
         virtual DiffLogic *getDiffLogic() const = 0;
         virtual void resetStateTo(const TrackedItem &newState) = 0;
 
+        // The hash of the delta's content, which is the same for the live item
+        // and its copy in a revision, if their data is equivalent, so that the
+        // diff logic can skip the unchanged deltas without serializing them;
+        // zero means there's no hash, and the data has to be compared as usual
+        virtual HashCode getDeltaHash(int deltaIndex) const { return 0; }
+
         void serializeVCSUuid(SerializedData &tree) const
         {
             tree.setProperty(Serialization::VCS::vcsItemId, this->getUuid().toString());
@@ -53,7 +53,8 @@ namespace VCS
             }
         }
 
-        // Called after checkout / reset to / etc
+        // Called before and after checkout / reset to / etc
+        virtual void onBeforeResetState() {}
         virtual void onResetState() = 0;
 
     private:
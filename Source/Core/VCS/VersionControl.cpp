@@ -25,6 +25,9 @@
 #include "Network.h"
 #include "ProjectSyncService.h"
 
+// Revisions this far from any branch tip are saved packed
+#define VCS_PACK_DISTANCE_TO_LEAF 20
+
 VersionControl::VersionControl(VCS::TrackedItemsSource &parent) :
     parent(parent),
     head(parent),
@@ -34,11 +37,37 @@ VersionControl::VersionControl(VCS::TrackedItemsSource &parent) :
     MessageManagerLock lock;
     this->addChangeListener(&this->head);
     this->head.moveTo(this->rootRevision);
+
+    this->pendingPushes.onRetry = [this](const SyncQueue::Operation &operation)
+    {
+        this->retrySyncOperation(operation);
+    };
+
+    // only the packed revisions are counted, the loaded deltas are a part
+    // of the project's data, and they are parsed lazily anyway
+    this->memoryAccount = makeUnique<MemoryBudget::Account>("Version control",
+        [this](int &numItems, int64 &numBytes)
+        {
+            Array<VCS::Revision *> revisions;
+            revisions.add(this->rootRevision.get());
+            while (!revisions.isEmpty())
+            {
+                const auto *revision = revisions.removeAndReturn(revisions.size() - 1);
+                numBytes += int64(revision->getPackedSize()) + int64(sizeof(VCS::Revision));
+                numItems++;
+
+                for (auto *child : revision->getChildren())
+                {
+                    revisions.add(child);
+                }
+            }
+        });
 }
 
 VersionControl::~VersionControl()
 {
     MessageManagerLock lock;
+    this->memoryAccount = nullptr;
     this->removeChangeListener(&this->head);
 }
 
@@ -64,6 +93,7 @@ void VersionControl::checkout(const VCS::Revision::Ptr revision)
 {
     if (! revision->isEmpty())
     {
+        this->parent.onBeforeResetState();
         this->head.moveTo(revision);
         this->head.checkout();
         this->sendChangeMessage();
@@ -74,6 +104,7 @@ void VersionControl::cherryPick(const VCS::Revision::Ptr revision, const Array<U
 {
     if (! revision->isEmpty())
     {
+        this->parent.onBeforeResetState();
         auto headRevision(this->head.getHeadingRevision());
         this->head.moveTo(revision);
         this->head.cherryPick(uuids);
@@ -133,6 +164,7 @@ void VersionControl::quickAmendItem(VCS::TrackedItem *targetItem)
 bool VersionControl::resetChanges(SparseSet<int> selectedItems)
 {
     if (selectedItems.size() == 0) { return false; }
+    if (this->isCommitting()) { return false; }
 
     VCS::Revision::Ptr allChanges(this->head.getDiff());
     Array<VCS::RevisionItem::Ptr> changesToReset;
@@ -147,12 +179,15 @@ bool VersionControl::resetChanges(SparseSet<int> selectedItems)
         }
     }
 
+    this->parent.onBeforeResetState();
     this->head.resetChanges(changesToReset);
     return true;
 }
 
 bool VersionControl::resetAllChanges()
 {
+    if (this->isCommitting()) { return false; }
+
     VCS::Revision::Ptr allChanges(this->head.getDiff());
     Array<VCS::RevisionItem::Ptr> changesToReset;
 
@@ -161,13 +196,18 @@ bool VersionControl::resetAllChanges()
         changesToReset.add(item);
     }
     
+    this->parent.onBeforeResetState();
     this->head.resetChanges(changesToReset);
     return true;
 }
 
+// The new revision is only added to the tree when the head has merged its state,
+// which is done on a worker thread, so that committing the large changes doesn't
+// freeze the ui; the stage view shows the progress until then
 bool VersionControl::commit(SparseSet<int> selectedItems, const String &message)
 {
     if (selectedItems.size() == 0) { return false; }
+    if (this->isCommitting()) { return false; }
 
     VCS::Revision::Ptr newRevision(new VCS::Revision(message));
     VCS::Revision::Ptr allChanges(this->head.getDiff());
@@ -185,13 +225,20 @@ bool VersionControl::commit(SparseSet<int> selectedItems, const String &message)
     VCS::Revision::Ptr headingRevision(this->head.getHeadingRevision());
     if (headingRevision == nullptr) { return false; }
 
-    headingRevision->addChild(newRevision);
-    this->head.moveTo(newRevision);
+    this->head.moveToNewChild(newRevision, [this, headingRevision, newRevision]()
+    {
+        headingRevision->addChild(newRevision);
+        this->sendChangeMessage();
+    });
 
-    this->sendChangeMessage();
     return true;
 }
 
+bool VersionControl::isCommitting() const noexcept
+{
+    return this->head.hasPendingMove();
+}
+
 
 //===----------------------------------------------------------------------===//
 // Stashes
@@ -256,7 +303,7 @@ bool VersionControl::hasQuickStash() const
 
 bool VersionControl::quickStashAll()
 {
-    if (this->hasQuickStash())
+    if (this->hasQuickStash() || this->isCommitting())
     { return false; }
 
     VCS::Revision::Ptr allChanges(this->head.getDiff());
@@ -272,6 +319,7 @@ bool VersionControl::applyQuickStash()
     if (! this->hasQuickStash())
     { return false; }
     
+    this->parent.onBeforeResetState();
     VCS::Head tempHead(this->head);
     tempHead.mergeStateWith(this->stashes->getQuickStash());
     tempHead.cherryPickAll();
@@ -297,8 +345,10 @@ void VersionControl::changeListenerCallback(ChangeBroadcaster* source)
 
 void VersionControl::syncAllRevisions()
 {
+    const auto operationId = this->pendingPushes.enqueue(Serialization::Sync::pushRevisions, {});
+
     App::Network().getProjectSyncService()->syncRevisions(this,
-        this->parent.getVCSId(), this->parent.getVCSName(), {}, {});
+        this->parent.getVCSId(), this->parent.getVCSName(), {}, {}, operationId);
 }
 
 void VersionControl::fetchRevisionsIfNeeded()
@@ -323,9 +373,11 @@ void VersionControl::pushBranch(const VCS::Revision::Ptr leaf)
         subtreeToPush.add(it->getUuid());
     }
 
+    const auto operationId = this->pendingPushes.enqueue(Serialization::Sync::pushRevisions, leaf->getUuid());
+
     App::Network().getProjectSyncService()->syncRevisions(this,
         this->parent.getVCSId(), this->parent.getVCSName(),
-        {}, subtreeToPush);
+        {}, subtreeToPush, operationId);
 }
 
 void VersionControl::pullBranch(const VCS::Revision::Ptr leaf)
@@ -348,6 +400,34 @@ void VersionControl::pullBranch(const VCS::Revision::Ptr leaf)
         subtreeToPull, {});
 }
 
+void VersionControl::onSyncOperationDone(const String &operationId)
+{
+    this->pendingPushes.acknowledge(operationId);
+}
+
+bool VersionControl::onSyncOperationFailed(const String &operationId, bool canRetry)
+{
+    return this->pendingPushes.reportFailure(operationId, canRetry);
+}
+
+void VersionControl::retrySyncOperation(const SyncQueue::Operation &operation)
+{
+    // the sync picks up from what the remote already has,
+    // so the revisions pushed before the failure are not re-sent
+    if (operation.target.isEmpty())
+    {
+        this->syncAllRevisions();
+    }
+    else if (auto leaf = this->getRevisionById(this->rootRevision, operation.target))
+    {
+        this->pushBranch(leaf);
+    }
+    else
+    {
+        this->pendingPushes.acknowledge(operation.id);
+    }
+}
+
 void VersionControl::updateLocalSyncCache(const VCS::Revision::Ptr revision)
 {
     this->remoteCache.updateForLocalRevision(revision);
@@ -378,16 +458,43 @@ VCS::Revision::SyncState VersionControl::getRevisionSyncState(const VCS::Revisio
 // Serializable
 //===----------------------------------------------------------------------===//
 
+// Returns the shortest distance from the revision to a leaf of its subtree
+static int packHistory(const VCS::Revision::Ptr revision)
+{
+    int distanceToLeaf = INT_MAX;
+    for (auto *child : revision->getChildren())
+    {
+        distanceToLeaf = jmin(distanceToLeaf, packHistory(child) + 1);
+    }
+
+    if (distanceToLeaf == INT_MAX)
+    {
+        return 0;
+    }
+
+    // the long chains are hardly ever checked out,
+    // so they will stay packed until the next load
+    if (distanceToLeaf > VCS_PACK_DISTANCE_TO_LEAF)
+    {
+        revision->pack();
+    }
+
+    return distanceToLeaf;
+}
+
 SerializedData VersionControl::serialize() const
 {
     SerializedData tree(Serialization::Core::versionControl);
 
+    packHistory(this->rootRevision);
+
     tree.setProperty(Serialization::VCS::headRevisionId, this->head.getHeadingRevision()->getUuid());
     
     tree.appendChild(this->rootRevision->serialize());
     tree.appendChild(this->stashes->serialize());
     tree.appendChild(this->head.serialize());
     tree.appendChild(this->remoteCache.serialize());
+    tree.appendChild(this->pendingPushes.serialize());
 
     return tree;
 }
@@ -407,6 +514,7 @@ void VersionControl::deserialize(const SerializedData &data)
     this->rootRevision->deserialize(root);
     this->stashes->deserialize(root);
     this->remoteCache.deserialize(root);
+    this->pendingPushes.deserialize(root);
 
     {
 #if DEBUG
@@ -427,6 +535,7 @@ void VersionControl::reset()
     this->rootRevision->reset();
     this->head.reset();
     this->remoteCache.reset();
+    this->pendingPushes.reset();
     this->stashes->reset();
 }
 
@@ -29,6 +29,8 @@ class VersionControlEditor;
 #include "Head.h"
 #include "RemoteCache.h"
 #include "StashesRepository.h"
+#include "MemoryBudget.h"
+#include "SyncQueue.h"
 
 class VersionControl final :
     public Serializable,
@@ -64,6 +66,7 @@ public:
     bool resetChanges(SparseSet<int> selectedItems);
     bool resetAllChanges();
     bool commit(SparseSet<int> selectedItems, const String &message);
+    bool isCommitting() const noexcept;
     void quickAmendItem(VCS::TrackedItem *targetItem); // for first commit
 
     //===------------------------------------------------------------------===//
@@ -91,6 +94,11 @@ public:
     void updateRemoteSyncCache(const Array<RevisionDto> &revisions);
     VCS::Revision::SyncState getRevisionSyncState(const VCS::Revision::Ptr revision) const;
 
+    // the pushes are kept in the queue until the server acknowledges
+    // them, see SyncQueue; returns true if it was the user's attempt
+    void onSyncOperationDone(const String &operationId);
+    bool onSyncOperationFailed(const String &operationId, bool canRetry);
+
     //===------------------------------------------------------------------===//
     // Serializable
     //===------------------------------------------------------------------===//
@@ -118,6 +126,11 @@ private:
 
     VCS::TrackedItemsSource &parent;
 
+    SyncQueue pendingPushes;
+    void retrySyncOperation(const SyncQueue::Operation &operation);
+
+    UniquePointer<MemoryBudget::Account> memoryAccount;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(VersionControl)
     JUCE_DECLARE_WEAK_REFERENCEABLE(VersionControl)
 };
@@ -73,6 +73,17 @@ void RecentProjectInfo::updateLocalTimestampAsNow()
     }
 }
 
+void RecentProjectInfo::updateLocalStats(int numTracks, int numEvents, int64 fileSize)
+{
+    jassert(this->local != nullptr);
+    if (this->local != nullptr)
+    {
+        this->local->numTracks = numTracks;
+        this->local->numEvents = numEvents;
+        this->local->fileSize = fileSize;
+    }
+}
+
 void RecentProjectInfo::resetLocalInfo()
 {
     this->local = nullptr;
@@ -102,6 +113,21 @@ File RecentProjectInfo::getLocalFile() const
     return {};
 }
 
+int RecentProjectInfo::getNumTracks() const noexcept
+{
+    return this->local != nullptr ? this->local->numTracks : 0;
+}
+
+int RecentProjectInfo::getNumEvents() const noexcept
+{
+    return this->local != nullptr ? this->local->numEvents : 0;
+}
+
+int64 RecentProjectInfo::getFileSize() const noexcept
+{
+    return this->local != nullptr ? this->local->fileSize : 0;
+}
+
 String RecentProjectInfo::getTitle() const
 {
     if (this->local != nullptr)
@@ -150,12 +176,10 @@ bool RecentProjectInfo::hasRemoteCopy() const noexcept
     return this->remote != nullptr;
 }
 
-bool RecentProjectInfo::isValid() const
+bool RecentProjectInfo::isValid() const noexcept
 {
-    const bool isFoundSomewhere = this->hasRemoteCopy() ||
-        (this->hasLocalCopy() && this->getLocalFile().existsAsFile());
-
-    return this->projectId.isNotEmpty() && isFoundSomewhere;
+    return this->projectId.isNotEmpty() &&
+        (this->hasRemoteCopy() || this->hasLocalCopy());
 }
 
 int RecentProjectInfo::compareElements(RecentProjectInfo *first, RecentProjectInfo *second)
@@ -184,6 +208,9 @@ SerializedData RecentProjectInfo::serialize() const
         localRoot.setProperty(RecentProjects::path, this->local->path.getFullPathName());
         localRoot.setProperty(RecentProjects::title, this->local->title);
         localRoot.setProperty(RecentProjects::updatedAt, this->local->lastModifiedMs);
+        localRoot.setProperty(RecentProjects::fileSize, this->local->fileSize);
+        localRoot.setProperty(RecentProjects::numTracks, this->local->numTracks);
+        localRoot.setProperty(RecentProjects::numEvents, this->local->numEvents);
         root.appendChild(localRoot);
     }
 
@@ -218,6 +245,9 @@ void RecentProjectInfo::deserialize(const SerializedData &data)
         this->local->path = localRoot.getProperty(RecentProjects::path);
         this->local->title = localRoot.getProperty(RecentProjects::title);
         this->local->lastModifiedMs = localRoot.getProperty(RecentProjects::updatedAt);
+        this->local->fileSize = localRoot.getProperty(RecentProjects::fileSize, 0);
+        this->local->numTracks = localRoot.getProperty(RecentProjects::numTracks, 0);
+        this->local->numEvents = localRoot.getProperty(RecentProjects::numEvents, 0);
     }
 
     const auto remoteRoot(root.getChildWithName(RecentProjects::remoteProjectInfo));
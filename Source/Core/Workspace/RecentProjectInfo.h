@@ -35,13 +35,24 @@ public:
     String getTitle() const;
     File getLocalFile() const;
 
+    // the stats are cached on saving, so that the dashboard
+    // doesn't have to open the project files to display them
+    int getNumTracks() const noexcept;
+    int getNumEvents() const noexcept;
+    int64 getFileSize() const noexcept;
+
     bool hasLocalCopy() const noexcept;
     bool hasRemoteCopy() const noexcept;
-    bool isValid() const;
+
+    // doesn't check if the local file exists, since the recent projects
+    // list is loaded at startup, and the home directory may be slow to access,
+    // e.g. a network drive; see Workspace::loadRecentProject
+    bool isValid() const noexcept;
 
     void updateRemoteInfo(const ProjectDto &remoteInfo);
     void updateLocalInfo(const String &localId, const String &localTitle, const String &localPath);
     void updateLocalTimestampAsNow();
+    void updateLocalStats(int numTracks, int numEvents, int64 fileSize);
 
     void resetLocalInfo();
     void resetRemoteInfo();
@@ -64,6 +75,9 @@ private:
         File path;
         String title;
         int64 lastModifiedMs;
+        int64 fileSize = 0;
+        int numTracks = 0;
+        int numEvents = 0;
     };
 
     struct RemoteInfo final
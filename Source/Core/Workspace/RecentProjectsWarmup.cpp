@@ -0,0 +1,267 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Common.h"
+#include "RecentProjectsWarmup.h"
+#include "DocumentHelpers.h"
+
+// the parsed trees take several times more memory than the binary files,
+// so this only limits the files sizes, which are known before parsing
+#define RECENT_PROJECTS_WARMUP_FILES_SIZE_BUDGET (16 * 1024 * 1024)
+
+// a rough estimate of how much more than the file a parsed tree takes,
+// as reported to the app-wide memory budget
+#define RECENT_PROJECTS_WARMUP_TREE_COST_FACTOR 4
+
+RecentProjectsWarmup::RecentProjectsWarmup() :
+    Thread("RecentProjectsWarmup")
+{
+    App::Memory().registerCache(this, MemoryBudget::Priority::Low);
+}
+
+RecentProjectsWarmup::~RecentProjectsWarmup()
+{
+    this->cancelPendingUpdate();
+    this->signalThreadShouldExit();
+    this->notify();
+
+    // a file being parsed can't be interrupted
+    this->stopThread(10000);
+
+    App::Memory().unregisterCache(this);
+}
+
+void RecentProjectsWarmup::warmUp(const Array<File> &files)
+{
+    {
+        const ScopedLock sl(this->lock);
+        for (const auto &file : files)
+        {
+            this->queue.addIfNotAlreadyThere(file);
+        }
+    }
+
+    if (!this->isThreadRunning())
+    {
+        // not to compete with the ui for the cpu
+        this->startThread(2);
+    }
+
+    this->notify();
+}
+
+SerializedData RecentProjectsWarmup::takeWarmedUpProject(const File &file)
+{
+    const ScopedLock sl(this->lock);
+
+    this->queue.removeAllInstancesOf(file);
+
+    if (this->fileBeingParsed == file)
+    {
+        this->fileBeingParsedWasTaken = true;
+    }
+
+    for (int i = 0; i < this->projects.size(); ++i)
+    {
+        if (this->projects.getReference(i).file == file)
+        {
+            const auto project = this->projects.removeAndReturn(i);
+            this->totalSize -= project.size;
+            App::Memory().removeEntry(this, project.id);
+
+            if (project.lastModified == file.getLastModificationTime() &&
+                project.size == file.getSize())
+            {
+                DBG("Using the warmed up project: " + file.getFullPathName());
+                return project.tree;
+            }
+
+            return {};
+        }
+    }
+
+    return {};
+}
+
+void RecentProjectsWarmup::prefetch(const File &file, Function<void()> onReady)
+{
+    {
+        const ScopedLock sl(this->lock);
+
+        // the missing files are skipped by the thread, so they "fail to open" here
+        const bool canTakeNow = this->hasParsed(file) || !file.existsAsFile();
+        this->requests.add({ file, onReady, canTakeNow });
+
+        if (canTakeNow)
+        {
+            this->triggerAsyncUpdate();
+            return;
+        }
+
+        if (this->fileBeingParsed == file)
+        {
+            // it's going to be kept anyway, see run()
+            this->fileBeingParsedWasTaken = false;
+        }
+        else
+        {
+            this->queue.removeAllInstancesOf(file);
+            this->queue.insert(0, file);
+        }
+    }
+
+    if (!this->isThreadRunning())
+    {
+        this->startThread(2);
+    }
+
+    this->notify();
+}
+
+void RecentProjectsWarmup::handleAsyncUpdate()
+{
+    Array<Function<void()>> callbacks;
+
+    {
+        const ScopedLock sl(this->lock);
+        for (int i = this->requests.size(); i --> 0;)
+        {
+            if (this->requests.getReference(i).isReady)
+            {
+                callbacks.insert(0, this->requests.removeAndReturn(i).onReady);
+            }
+        }
+    }
+
+    for (const auto &callback : callbacks)
+    {
+        callback();
+    }
+}
+
+bool RecentProjectsWarmup::isRequested(const File &file) const
+{
+    for (const auto &request : this->requests)
+    {
+        if (request.file == file)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool RecentProjectsWarmup::hasParsed(const File &file) const
+{
+    for (const auto &project : this->projects)
+    {
+        if (project.file == file)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void RecentProjectsWarmup::run()
+{
+    while (!this->threadShouldExit())
+    {
+        File file;
+        int64 size = 0;
+
+        {
+            const ScopedLock sl(this->lock);
+            while (!this->queue.isEmpty() && file == File())
+            {
+                const auto nextFile = this->queue.removeAndReturn(0);
+                size = nextFile.getSize();
+                if (nextFile.existsAsFile() && (this->isRequested(nextFile) ||
+                    this->totalSize + size <= RECENT_PROJECTS_WARMUP_FILES_SIZE_BUDGET))
+                {
+                    file = nextFile;
+                }
+            }
+
+            this->fileBeingParsed = file;
+            this->fileBeingParsedWasTaken = false;
+        }
+
+        if (file == File())
+        {
+            this->wait(-1);
+            continue;
+        }
+
+        const auto lastModified = file.getLastModificationTime();
+        const auto tree = DocumentHelpers::load(file);
+
+        const ScopedLock sl(this->lock);
+
+        const bool isRequested = this->isRequested(file);
+        if (tree.isValid() && !this->fileBeingParsedWasTaken && (isRequested ||
+            this->totalSize + size <= RECENT_PROJECTS_WARMUP_FILES_SIZE_BUDGET))
+        {
+            const auto id = ++this->lastProjectId;
+            this->projects.add({ id, file, lastModified, size, tree });
+            this->totalSize += size;
+
+            // the budget never calls back while holding its own lock,
+            // so it's safe to report to it from here
+            App::Memory().addEntry(this, id, size * RECENT_PROJECTS_WARMUP_TREE_COST_FACTOR);
+        }
+
+        this->fileBeingParsed = File();
+
+        // even if the file failed to parse, it will just fail to open
+        if (isRequested)
+        {
+            for (auto &request : this->requests)
+            {
+                request.isReady = request.isReady || request.file == file;
+            }
+
+            this->triggerAsyncUpdate();
+        }
+    }
+}
+
+//===----------------------------------------------------------------------===//
+// MemoryBudget::Cache
+//===----------------------------------------------------------------------===//
+
+String RecentProjectsWarmup::getCacheName() const
+{
+    return "Recent projects warmup";
+}
+
+void RecentProjectsWarmup::evictCacheEntry(int64 entryId)
+{
+    const ScopedLock sl(this->lock);
+
+    for (int i = 0; i < this->projects.size(); ++i)
+    {
+        if (this->projects.getReference(i).id == entryId)
+        {
+            this->totalSize -= this->projects.getReference(i).size;
+            this->projects.remove(i);
+            return;
+        }
+    }
+}
@@ -0,0 +1,99 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+/*
+    Reads and parses the files of a few recent projects in the background,
+    so that opening one of them from the dashboard only has to deserialize
+    the already parsed tree, which is used only if the file hasn't changed since.
+    Nothing but the document is touched here: the project nodes, the instruments
+    and plugins are still created on the main thread when the project is opened.
+
+    Opening any other project also reads and parses it here first, see prefetch,
+    so that the message thread only has to build the project from the parsed tree.
+*/
+
+#include "MemoryBudget.h"
+
+class RecentProjectsWarmup final :
+    private Thread,
+    private AsyncUpdater,
+    private MemoryBudget::Cache
+{
+public:
+
+    RecentProjectsWarmup();
+    ~RecentProjectsWarmup() override;
+
+    // the files are expected to be sorted by priority,
+    // the ones which don't fit the memory budget are skipped
+    void warmUp(const Array<File> &files);
+
+    // returns an invalid tree, if the file hasn't been warmed up (yet);
+    // the warmed up tree is forgotten anyway, since the project is opened
+    SerializedData takeWarmedUpProject(const File &file);
+
+    // parses the file ahead of the others, regardless of the budget,
+    // and calls back on the message thread, when it can be taken
+    void prefetch(const File &file, Function<void()> onReady);
+
+private:
+
+    void run() override;
+    void handleAsyncUpdate() override;
+
+    bool isRequested(const File &file) const;
+    bool hasParsed(const File &file) const;
+
+    //===------------------------------------------------------------------===//
+    // MemoryBudget::Cache
+    //===------------------------------------------------------------------===//
+
+    String getCacheName() const override;
+    void evictCacheEntry(int64 entryId) override;
+
+    struct WarmProject final
+    {
+        int64 id;
+        File file;
+        Time lastModified;
+        int64 size;
+        SerializedData tree;
+    };
+
+    CriticalSection lock;
+
+    Array<File> queue;
+    Array<WarmProject> projects;
+    int64 totalSize = 0;
+    int64 lastProjectId = 0;
+
+    File fileBeingParsed;
+    bool fileBeingParsedWasTaken = false;
+
+    struct Request final
+    {
+        File file;
+        Function<void()> onReady;
+        bool isReady = false;
+    };
+
+    Array<Request> requests;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(RecentProjectsWarmup)
+};
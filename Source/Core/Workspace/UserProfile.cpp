@@ -174,6 +174,19 @@ void UserProfile::onProjectLocalInfoUpdated(const String &id, const String &titl
     this->sendChangeMessage();
 }
 
+void UserProfile::onProjectLocalStatsUpdated(const String &id,
+    int numTracks, int numEvents, int64 fileSize)
+{
+    if (auto *project = this->findProject(id))
+    {
+        if (project->hasLocalCopy())
+        {
+            project->updateLocalStats(numTracks, numEvents, fileSize);
+            this->sendChangeMessage();
+        }
+    }
+}
+
 void UserProfile::onProjectRemoteInfoUpdated(const ProjectDto &info)
 {
     if (auto *project = this->findProject(info.getId()))
@@ -34,6 +34,7 @@ public:
     void updateProfile(const UserProfileDto &dto);
 
     void onProjectLocalInfoUpdated(const String &id, const String &title, const String &path);
+    void onProjectLocalStatsUpdated(const String &id, int numTracks, int numEvents, int64 fileSize);
     void onProjectLocalInfoReset(const String &id);
 
     void onProjectRemoteInfoUpdated(const ProjectDto &info);
@@ -33,6 +33,13 @@
 #include "RootNode.h"
 #include "Dashboard.h"
 #include "CommandPaletteProjectsList.h"
+#include "RecentProjectsWarmup.h"
+#include "StartupProfiler.h"
+#include "MessageThreadWatchdog.h"
+
+// the background projects are not suspended right away,
+// so that quickly switching back and forth stays cheap
+#define PROJECT_SUSPEND_DELAY_MS (30 * 1000)
 
 Workspace::Workspace() {}
 
@@ -43,6 +50,8 @@ Workspace::~Workspace()
 
 void Workspace::init()
 {
+    STARTUP_PROFILER_SCOPE("Workspace::init");
+
     if (! this->wasInitialized)
     {
         this->audioCore = makeUnique<AudioCore>();
@@ -60,6 +69,43 @@ void Workspace::init()
         {
             this->wasInitialized = true;
         }
+
+        this->warmUpRecentProjects();
+    }
+}
+
+void Workspace::initHeadless()
+{
+    if (! this->wasInitialized)
+    {
+        this->isHeadless = true;
+
+        this->audioCore = makeUnique<AudioCore>();
+        this->pluginManager = makeUnique<PluginScanner>();
+        this->treeRoot = makeUnique<RootNode>("Workspace");
+
+        App::Config().load(this, Serialization::Config::activeWorkspace);
+
+        if (this->audioCore->getInstruments().isEmpty())
+        {
+            this->audioCore->autodetectDeviceSetup();
+            this->audioCore->initDefaultInstrument();
+        }
+
+        this->wasInitialized = true;
+    }
+}
+
+void Workspace::initWithoutInstruments()
+{
+    if (! this->wasInitialized)
+    {
+        this->isHeadless = true;
+
+        this->audioCore = makeUnique<AudioCore>();
+        this->treeRoot = makeUnique<RootNode>("Workspace");
+
+        this->wasInitialized = true;
     }
 }
 
@@ -72,6 +118,8 @@ void Workspace::shutdown()
 {
     if (this->wasInitialized)
     {
+        this->stopTimer();
+        this->recentProjectsWarmup = nullptr;
         this->autosave();
 
         // To cleanup properly, remove all projects first (before instruments etc).
@@ -186,7 +234,8 @@ bool Workspace::loadRecentProject(RecentProjectInfo::Ptr info)
     const File file(info->getLocalFile());
     if (file.existsAsFile())
     {
-        return this->treeRoot->openProject(file) != nullptr;
+        this->openProjectInBackground(file);
+        return true;
     }
     else if (info->hasRemoteCopy()) // and not present locally
     {
@@ -208,10 +257,84 @@ bool Workspace::loadRecentProject(RecentProjectInfo::Ptr info)
             return true;
         }
     }
+    else if (info->hasLocalCopy())
+    {
+        // the file existence is only checked here, not at startup,
+        // so the projects deleted elsewhere fail to load only when picked
+        return false;
+    }
 
     return true;
 }
 
+// Only a few most recent projects are warmed up: the user will likely
+// open one of them from the dashboard, but hardly all of them
+#define WORKSPACE_NUM_PROJECTS_TO_WARM_UP (3)
+
+void Workspace::warmUpRecentProjects()
+{
+    Array<File> files;
+
+    for (const auto &info : this->userProfile.getProjects())
+    {
+        if (files.size() == WORKSPACE_NUM_PROJECTS_TO_WARM_UP)
+        {
+            break;
+        }
+
+        if (info->hasLocalCopy() && !this->hasLoadedProject(info))
+        {
+            files.add(info->getLocalFile());
+        }
+    }
+
+    if (files.isEmpty())
+    {
+        return;
+    }
+
+    if (this->recentProjectsWarmup == nullptr)
+    {
+        this->recentProjectsWarmup = makeUnique<RecentProjectsWarmup>();
+    }
+
+    this->recentProjectsWarmup->warmUp(files);
+}
+
+// the file is read and parsed on the warmup thread, while the dashboard
+// stays responsive, and only the project nodes are built on the message thread
+void Workspace::openProjectInBackground(const File &file)
+{
+    for (const auto *project : this->getLoadedProjects())
+    {
+        if (project->getDocument()->getFullPath() == file.getFullPathName())
+        {
+            this->treeRoot->openProject(file); // just selects it
+            return;
+        }
+    }
+
+    if (this->recentProjectsWarmup == nullptr)
+    {
+        this->recentProjectsWarmup = makeUnique<RecentProjectsWarmup>();
+    }
+
+    this->recentProjectsWarmup->prefetch(file, [this, file]()
+    {
+        this->treeRoot->openProject(file);
+    });
+}
+
+SerializedData Workspace::takeWarmedUpProject(const File &file)
+{
+    if (this->recentProjectsWarmup == nullptr)
+    {
+        return {};
+    }
+
+    return this->recentProjectsWarmup->takeWarmedUpProject(file);
+}
+
 void Workspace::unloadProject(const String &projectId, bool deleteLocally, bool deleteRemotely)
 {
     const auto projects = this->treeRoot->findChildrenOfType<ProjectNode>();
@@ -299,6 +422,37 @@ bool Workspace::hasLoadedProject(const RecentProjectInfo::Ptr file) const
     return false;
 }
 
+void Workspace::setActiveProject(ProjectNode &project)
+{
+    project.resume();
+
+    if (this->activeProjectId != project.getId())
+    {
+        this->activeProjectId = project.getId();
+        this->startTimer(PROJECT_SUSPEND_DELAY_MS);
+    }
+}
+
+void Workspace::timerCallback()
+{
+    bool hasBusyProjects = false;
+
+    for (auto *project : this->getLoadedProjects())
+    {
+        if (project->getId() != this->activeProjectId &&
+            !project->isSuspended())
+        {
+            // the ones still playing in the background will be retried later
+            hasBusyProjects = !project->suspend() || hasBusyProjects;
+        }
+    }
+
+    if (!hasBusyProjects)
+    {
+        this->stopTimer();
+    }
+}
+
 void Workspace::stopPlaybackForAllProjects()
 {
     for (auto *project : this->getLoadedProjects())
@@ -313,7 +467,9 @@ void Workspace::stopPlaybackForAllProjects()
 
 void Workspace::autosave()
 {
-    if (! this->wasInitialized)
+    WATCHDOG_SCOPE("Workspace::autosave");
+
+    if (! this->wasInitialized || this->isHeadless)
     {
         return;
     }
@@ -325,6 +481,7 @@ bool Workspace::autoload()
 {
     if (App::Config().containsProperty(Serialization::Config::activeWorkspace))
     {
+        STARTUP_PROFILER_SCOPE("Workspace::autoload");
         App::Config().load(this, Serialization::Config::activeWorkspace);
         return true;
     }
@@ -372,8 +529,8 @@ void Workspace::importProject(const String &filePattern)
         }
         else
         {
-            this->treeRoot->openProject(file);
-            this->autosave();
+            // saves the workspace by itself, when the project is opened
+            this->openProjectInBackground(file);
         }
     }
 #endif
@@ -477,13 +634,29 @@ void Workspace::deserialize(const SerializedData &data)
     }
 
     this->userProfile.deserialize(root);
-    this->audioCore->deserialize(root);
-    this->pluginManager->deserialize(root);
+
+    {
+        STARTUP_PROFILER_SCOPE("AudioCore::deserialize");
+        this->audioCore->deserialize(root);
+    }
+
+    {
+        STARTUP_PROFILER_SCOPE("PluginScanner::deserialize");
+        this->pluginManager->deserialize(root);
+    }
+
+    if (this->isHeadless)
+    {
+        return;
+    }
 
     const auto treeRootNode = root.getChildWithName(Core::treeRoot);
     jassert(treeRootNode.isValid());
 
-    this->treeRoot->deserialize(treeRootNode);
+    {
+        STARTUP_PROFILER_SCOPE("RootNode::deserialize");
+        this->treeRoot->deserialize(treeRootNode);
+    }
     
     bool foundActiveNode = false;
     const auto treeStateNode = root.getChildWithName(Core::treeState);
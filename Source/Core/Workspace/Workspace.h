@@ -22,6 +22,7 @@ class ProjectNode;
 class RootNode;
 class PluginScanner;
 class CommandPaletteProjectsList;
+class RecentProjectsWarmup;
 
 #include "DocumentOwner.h"
 #include "UserProfile.h"
@@ -30,7 +31,8 @@ class CommandPaletteProjectsList;
 
 class Workspace final :
     public CommandPaletteModel,
-    private Serializable
+    private Serializable,
+    private Timer
 {
 public:
     
@@ -39,6 +41,15 @@ public:
 
     void init();
     void shutdown();
+
+    // only loads the instruments and plugins, without any projects
+    // and never saves anything, see HeadlessRenderer
+    void initHeadless();
+
+    // only creates an empty audio core, which never opens any device,
+    // for the conversions which don't play anything, see HeadlessConverter
+    void initWithoutInstruments();
+
     bool isInitialized() const noexcept;
     void stopPlaybackForAllProjects(); // on app suspend / shutdown
 
@@ -63,6 +74,13 @@ public:
     bool hasLoadedProject(const RecentProjectInfo::Ptr file) const;
     void unloadProject(const String &id, bool deleteLocally, bool deleteRemotely);
 
+    // resumes the project, if it was suspended, and suspends
+    // all the other loaded projects after a while, see timerCallback
+    void setActiveProject(ProjectNode &project);
+
+    // the parsed document of a recent project, if it's been warmed up, see onDocumentLoad
+    SerializedData takeWarmedUpProject(const File &file);
+
     //===------------------------------------------------------------------===//
     // Save/Load
     //===------------------------------------------------------------------===//
@@ -88,6 +106,7 @@ public:
 private:
 
     bool wasInitialized = false;
+    bool isHeadless = false;
 
     UserProfile userProfile;
     
@@ -99,6 +118,13 @@ private:
 
     UniquePointer<CommandPaletteProjectsList> consoleProjectsList;
 
+    UniquePointer<RecentProjectsWarmup> recentProjectsWarmup;
+    void warmUpRecentProjects();
+    void openProjectInBackground(const File &file);
+
+    String activeProjectId;
+    void timerCallback() override;
+
     void failedDeserializationFallback();
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Workspace)
@@ -0,0 +1,103 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Common.h"
+#include "AnimationClock.h"
+
+// JUCE has no vblank callbacks, so this is the usual display refresh rate
+#define ANIMATION_CLOCK_FRAME_RATE 60
+
+AnimationClock::~AnimationClock()
+{
+    // all the animated components should be deleted by this time
+    jassert(this->listeners.isEmpty());
+    this->stopTimer();
+}
+
+void AnimationClock::setSuspended(bool shouldBeSuspended)
+{
+    this->suspended = shouldBeSuspended;
+    this->updateTimer();
+}
+
+int AnimationClock::getFrameRate() const noexcept
+{
+    return ANIMATION_CLOCK_FRAME_RATE;
+}
+
+void AnimationClock::subscribe(Listener *listener)
+{
+    this->listeners.add(listener);
+    this->updateTimer();
+}
+
+void AnimationClock::unsubscribe(Listener *listener)
+{
+    this->listeners.remove(listener);
+    this->updateTimer();
+}
+
+void AnimationClock::updateTimer()
+{
+    const bool shouldTick = !this->suspended && !this->listeners.isEmpty();
+    if (shouldTick && !this->isTimerRunning())
+    {
+        this->startTimerHz(ANIMATION_CLOCK_FRAME_RATE);
+    }
+    else if (!shouldTick && this->isTimerRunning())
+    {
+        this->stopTimer();
+    }
+}
+
+void AnimationClock::timerCallback()
+{
+    // the listeners may unsubscribe, or even delete themselves here
+    this->listeners.call(&Listener::onAnimationFrame);
+}
+
+//===----------------------------------------------------------------------===//
+// Listener
+//===----------------------------------------------------------------------===//
+
+AnimationClock::Listener::~Listener()
+{
+    this->stopAnimating();
+}
+
+void AnimationClock::Listener::startAnimating()
+{
+    if (!this->animating)
+    {
+        this->animating = true;
+        App::Animations().subscribe(this);
+    }
+}
+
+void AnimationClock::Listener::stopAnimating()
+{
+    if (this->animating)
+    {
+        this->animating = false;
+        App::Animations().unsubscribe(this);
+    }
+}
+
+bool AnimationClock::Listener::isAnimating() const noexcept
+{
+    return this->animating;
+}
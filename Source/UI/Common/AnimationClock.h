@@ -0,0 +1,78 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+/*
+    The app-wide frame clock for the UI animations (see App::Animations).
+
+    Instead of running their own timers, the animated components subscribe
+    only while something actually moves, and all of them get their frames
+    from a single timer, which is stopped as soon as nobody is animating,
+    e.g. when the transport is stopped and nothing is fading, and also
+    while the app is in background, so that the idle app doesn't wake up
+    at all; this matters mostly for phones and laptops on battery.
+*/
+
+class AnimationClock final : private Timer
+{
+public:
+
+    // Works like a Timer, which ticks once per frame
+    class Listener
+    {
+    public:
+
+        Listener() = default;
+        virtual ~Listener();
+
+        virtual void onAnimationFrame() = 0;
+
+    protected:
+
+        void startAnimating();
+        void stopAnimating();
+        bool isAnimating() const noexcept;
+
+    private:
+
+        bool animating = false;
+
+        JUCE_DECLARE_NON_COPYABLE(Listener)
+    };
+
+    AnimationClock() = default;
+    ~AnimationClock() override;
+
+    // no frames are sent while suspended, even if there are subscribers
+    void setSuspended(bool shouldBeSuspended);
+
+    int getFrameRate() const noexcept;
+
+private:
+
+    void subscribe(Listener *listener);
+    void unsubscribe(Listener *listener);
+    void updateTimer();
+
+    void timerCallback() override;
+
+    ListenerList<Listener> listeners;
+    bool suspended = false;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AnimationClock)
+};
@@ -85,10 +85,12 @@ void SpectrogramAudioMonitorComponent::run()
 
         if (this->isVisible())
         {
+            const auto levels = this->audioMonitor->getLevels();
+            this->lPeak = levels.truePeak[0];
+            this->rPeak = levels.truePeak[1];
+
             for (int i = 0; i < GENERIC_METER_NUM_BANDS; ++i)
             {
-                this->lPeak = this->audioMonitor->getPeak(0);
-                this->rPeak = this->audioMonitor->getPeak(1);
                 this->values[i] = this->audioMonitor->getInterpolatedSpectrumAtFrequency(kPeakSpectrumFrequencies[i]);
             }
 
@@ -102,7 +104,30 @@ void SpectrogramAudioMonitorComponent::run()
 
 void SpectrogramAudioMonitorComponent::handleAsyncUpdate()
 {
-    this->repaint();
+    if (this->hasVisibleLevels || this->hasSignal())
+    {
+        this->repaint();
+    }
+}
+
+bool SpectrogramAudioMonitorComponent::hasSignal() const noexcept
+{
+    static const float minGain = Decibels::decibelsToGain(GENERIC_METER_MINDB);
+
+    if (this->lPeak.get() > minGain || this->rPeak.get() > minGain)
+    {
+        return true;
+    }
+
+    for (int i = 0; i < GENERIC_METER_NUM_BANDS; ++i)
+    {
+        if (this->values[i].get() > minGain)
+        {
+            return true;
+        }
+    }
+
+    return false;
 }
 
 void SpectrogramAudioMonitorComponent::resized()
@@ -111,6 +136,8 @@ void SpectrogramAudioMonitorComponent::resized()
     {
         this->bands[i]->reset();
     }
+
+    this->hasVisibleLevels = true;
 }
 
 void SpectrogramAudioMonitorComponent::paint(Graphics &g)
@@ -181,6 +208,12 @@ void SpectrogramAudioMonitorComponent::paint(Graphics &g)
         g.fillRect(x, peakH, bw - 1.f, 1.f);
     }
 
+    this->hasVisibleLevels = this->lPeakBand->peak > 0.f || this->rPeakBand->peak > 0.f;
+    for (int i = 0; i < GENERIC_METER_NUM_BANDS && !this->hasVisibleLevels; ++i)
+    {
+        this->hasVisibleLevels = this->bands[i]->peak > 0.f;
+    }
+
     // Show levels?
     //if (this->altMode)
     //{
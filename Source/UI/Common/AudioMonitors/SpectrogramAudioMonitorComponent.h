@@ -60,6 +60,8 @@ private:
     
     void run() override;
     void handleAsyncUpdate() override;
+
+    bool hasSignal() const noexcept;
     
     const Colour colour;
 
@@ -74,6 +76,10 @@ private:
     Atomic<float> rPeak;
 
     int skewTime = 0;
+
+    // when all bands and peaks have decayed to zero,
+    // there's no need to repaint until some signal comes
+    bool hasVisibleLevels = true;
     
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SpectrogramAudioMonitorComponent);
 };
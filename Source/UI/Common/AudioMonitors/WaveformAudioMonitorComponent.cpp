@@ -28,7 +28,8 @@
 WaveformAudioMonitorComponent::WaveformAudioMonitorComponent(WeakReference<AudioMonitor> targetAnalyzer) :
     Thread("WaveformAudioMonitor"),
     colour(findDefaultColour(ColourIDs::AudioMonitor::foreground)),
-    audioMonitor(targetAnalyzer)
+    audioMonitor(targetAnalyzer),
+    loudness(LOUDNESS_METER_MIN_LOUDNESS)
 {
     this->setInterceptsMouseClicks(false, false);
     this->setPaintingIsUnclipped(true);
@@ -60,22 +61,16 @@ void WaveformAudioMonitorComponent::run()
         Thread::sleep(jlimit(10, 100, 35 - this->skewTime));
         const double b = Time::getMillisecondCounterHiRes();
 
-        // Shift buffers:
-        for (int i = 0; i < WAVEFORM_METER_BUFFER_SIZE - 1; ++i)
-        {
-            this->lPeakBuffer[i] = this->lPeakBuffer[i + 1].get();
-            this->rPeakBuffer[i] = this->rPeakBuffer[i + 1].get();
-            this->lRmsBuffer[i] = this->lRmsBuffer[i + 1].get();
-            this->rRmsBuffer[i] = this->rRmsBuffer[i + 1].get();
-        }
-
-        const int i = WAVEFORM_METER_BUFFER_SIZE - 1;
-
         // Push next values:
-        this->lPeakBuffer[i] = this->audioMonitor->getPeak(0);
-        this->rPeakBuffer[i] = this->audioMonitor->getPeak(1);
-        this->lRmsBuffer[i] = this->audioMonitor->getRootMeanSquare(0);
-        this->rRmsBuffer[i] = this->audioMonitor->getRootMeanSquare(1);
+        const int head = this->head.get();
+        const int i = head % WAVEFORM_METER_BUFFER_SIZE;
+        const auto levels = this->audioMonitor->getLevels();
+        this->lPeakBuffer[i] = levels.peak[0];
+        this->rPeakBuffer[i] = levels.peak[1];
+        this->lRmsBuffer[i] = levels.rms[0];
+        this->rRmsBuffer[i] = levels.rms[1];
+        this->loudness = levels.momentaryLoudness;
+        this->head = (head + 1) % (WAVEFORM_METER_BUFFER_SIZE * 1024);
 
         if (this->isVisible())
         {
@@ -89,6 +84,44 @@ void WaveformAudioMonitorComponent::run()
 
 void WaveformAudioMonitorComponent::handleAsyncUpdate()
 {
+    if (!this->waveformImage.isValid())
+    {
+        return;
+    }
+
+    constexpr int w = WAVEFORM_METER_BUFFER_SIZE;
+    constexpr int headCycle = WAVEFORM_METER_BUFFER_SIZE * 1024;
+    const int newHead = this->head.get();
+    const int numNewSlots = (newHead - this->drawnHead + headCycle) % headCycle;
+    if (numNewSlots == 0)
+    {
+        return;
+    }
+
+    this->drawnHead = newHead;
+
+    if (numNewSlots >= w - 3)
+    {
+        this->redrawHistory();
+        this->repaint();
+        return;
+    }
+
+    // scroll the old slots to the left, and draw the new ones,
+    // along with those which fade-in and fade-out depend on position
+    const int scrolledWidth = numNewSlots * 2;
+    this->waveformImage.moveImageSection(0, 0, scrolledWidth, 0,
+        this->waveformImage.getWidth() - scrolledWidth, this->waveformImage.getHeight());
+
+    Graphics g(this->waveformImage);
+    for (int slot = w - numNewSlots - 3; slot < w; ++slot)
+    {
+        this->drawSlot(g, slot, newHead);
+    }
+
+    this->drawSlot(g, 0, newHead);
+    this->drawSlot(g, 1, newHead);
+
     this->repaint();
 }
 
@@ -105,33 +138,82 @@ inline static float waveformIecLevel(float peak)
     return AudioCore::iecLevel(vauleInDb);
 }
 
-void WaveformAudioMonitorComponent::paint(Graphics &g)
+void WaveformAudioMonitorComponent::resized()
 {
-    if (this->audioMonitor == nullptr)
+    if (this->getWidth() <= 0 || this->getHeight() <= 0)
     {
+        this->waveformImage = {};
         return;
     }
-    
-    const float midH = float(this->getHeight()) / 2.f;
-    constexpr int w = WAVEFORM_METER_BUFFER_SIZE;
 
-    g.setColour(this->colour.withAlpha(0.2f));
+    this->waveformImage = Image(Image::ARGB,
+        WAVEFORM_METER_BUFFER_SIZE * 2, this->getHeight(), true);
 
-    for (int i = 0; i < w - 1; ++i)
+    this->drawnHead = this->head.get();
+    this->redrawHistory();
+}
+
+void WaveformAudioMonitorComponent::redrawHistory()
+{
+    this->waveformImage.clear(this->waveformImage.getBounds());
+
+    Graphics g(this->waveformImage);
+    for (int slot = 0; slot < WAVEFORM_METER_BUFFER_SIZE; ++slot)
     {
-        const float fancyFade = (i == 0 || i == (w - 2)) ? 0.75f : ((i == 1 || i == (w - 3)) ? 0.9f : 1.f);
-        const float peakL = waveformIecLevel(this->lPeakBuffer[i].get()) * midH * fancyFade;
-        const float peakR = waveformIecLevel(this->rPeakBuffer[i].get()) * midH * fancyFade;
-        g.fillRect(1.f + (i * 2.f), midH - peakL, 1.f, peakR + peakL);
+        this->drawSlot(g, slot, this->drawnHead);
     }
+}
 
+// Each slot is 2 pixels wide: the rms goes first, then the peak,
+// which is not shown for the newest slot, as it was before
+void WaveformAudioMonitorComponent::drawSlot(Graphics &g, int slot, int historyEnd)
+{
+    constexpr int w = WAVEFORM_METER_BUFFER_SIZE;
+    const int i = (historyEnd - w + slot + w * 1024) % w;
+    const float midH = float(this->waveformImage.getHeight()) / 2.f;
+
+    this->waveformImage.clear({ slot * 2, 0, 2, this->waveformImage.getHeight() });
+
+    const float rmsFade = (slot == 0 || slot == (w - 1)) ? 0.85f : ((slot == 1 || slot == (w - 2)) ? 0.95f : 1.f);
+    const float rmsL = waveformIecLevel(this->lRmsBuffer[i].get()) * midH * rmsFade;
+    const float rmsR = waveformIecLevel(this->rRmsBuffer[i].get()) * midH * rmsFade;
     g.setColour(this->colour.withAlpha(0.25f));
+    g.fillRect(slot * 2.f, midH - rmsL, 1.f, rmsR + rmsL);
+
+    if (slot < w - 1)
+    {
+        const float peakFade = (slot == 0 || slot == (w - 2)) ? 0.75f : ((slot == 1 || slot == (w - 3)) ? 0.9f : 1.f);
+        const float peakL = waveformIecLevel(this->lPeakBuffer[i].get()) * midH * peakFade;
+        const float peakR = waveformIecLevel(this->rPeakBuffer[i].get()) * midH * peakFade;
+        g.setColour(this->colour.withAlpha(0.2f));
+        g.fillRect(1.f + (slot * 2.f), midH - peakL, 1.f, peakR + peakL);
+    }
+}
 
-    for (int i = 0; i < w; ++i)
+void WaveformAudioMonitorComponent::paint(Graphics &g)
+{
+    if (this->audioMonitor == nullptr)
     {
-        const float fancyFade = (i == 0 || i == (w - 1)) ? 0.85f : ((i == 1 || i == (w - 2)) ? 0.95f : 1.f);
-        const float rmsL = waveformIecLevel(this->lRmsBuffer[i].get()) * midH * fancyFade;
-        const float rmsR = waveformIecLevel(this->rRmsBuffer[i].get()) * midH * fancyFade;
-        g.fillRect(i * 2.f, midH - rmsL, 1.f, rmsR + rmsL);
+        return;
+    }
+
+    const float midH = float(this->getHeight()) / 2.f;
+
+    if (this->waveformImage.isValid())
+    {
+        g.setOpacity(1.f);
+        g.drawImageAt(this->waveformImage, 0, 0);
+    }
+
+    // Momentary loudness, only shown when there's something to measure:
+    const float loudness = this->loudness.get();
+    if (loudness > LOUDNESS_METER_MIN_LOUDNESS)
+    {
+        const float loudnessY = AudioCore::iecLevel(jlimit(WAVEFORM_METER_MINDB,
+            WAVEFORM_METER_MAXDB, loudness)) * midH;
+
+        g.setColour(this->colour.withAlpha(0.35f));
+        g.fillRect(0.f, midH - loudnessY, float(this->getWidth()), 1.f);
+        g.fillRect(0.f, midH + loudnessY, float(this->getWidth()), 1.f);
     }
 }
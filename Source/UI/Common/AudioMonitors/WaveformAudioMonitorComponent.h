@@ -24,6 +24,13 @@ class AudioMonitor;
 // Set this depending on component width (or sidebar width):
 #define WAVEFORM_METER_BUFFER_SIZE (SEQUENCER_SIDEBAR_WIDTH / 2)
 
+/*
+    The history is a ring buffer, written by the monitor thread, and
+    the waveform is kept in an image, which is scrolled on each update,
+    so that only the newest columns (and the faded edges) are drawn,
+    not the whole history every frame.
+*/
+
 class WaveformAudioMonitorComponent final :
     public Component, private Thread, private AsyncUpdater
 {
@@ -39,11 +46,16 @@ public:
     //===------------------------------------------------------------------===//
 
     void paint(Graphics &g) override;
+    void resized() override;
 
 private:
 
     void run() override;
     void handleAsyncUpdate() override;
+
+    // the slot 0 is the oldest one, the last slot is the newest one
+    void drawSlot(Graphics &g, int slot, int historyEnd);
+    void redrawHistory();
     
     const Colour colour;
 
@@ -55,6 +67,15 @@ private:
     Atomic<float> lRmsBuffer[WAVEFORM_METER_BUFFER_SIZE];
     Atomic<float> rRmsBuffer[WAVEFORM_METER_BUFFER_SIZE];
 
+    // the write position, wrapped at a multiple of the buffer size,
+    // so that the next value always goes at (head % size)
+    Atomic<int> head = 0;
+
+    Image waveformImage;
+    int drawnHead = 0;
+
+    Atomic<float> loudness;
+
     int skewTime = 0;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(WaveformAudioMonitorComponent)
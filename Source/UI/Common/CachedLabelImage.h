@@ -17,63 +17,55 @@
 
 #pragma once
 
+#include "TextSprites.h"
+
 // A simple CachedComponentImage for labels.
-// This cache assumes that label's size is fixed,
-// so it doesn't have to re-cache it on every setBounds.
+// The rendered labels are shared via TextSprites by all the labels
+// with the same text, font, colour and size, so that, say, all the "4/4"
+// time signatures are rendered once; any change of these, or of the display
+// scale, just picks another sprite, so it doesn't have to re-cache anything
+// on every setBounds, but it doesn't get stale after resizing either.
 
 struct CachedLabelImage : public CachedComponentImage
 {
-    CachedLabelImage(Label &c) noexcept : owner(c), scale(1.0f) {}
+    CachedLabelImage(Label &c) noexcept : owner(c) {}
 
     void paint(Graphics &g) override
     {
-        this->scale = g.getInternalContext().getPhysicalPixelScaleFactor();
-        auto compBounds = this->owner.getLocalBounds();
-        auto imageBounds = compBounds * this->scale;
-
-        if (this->image.isNull())
-        {
-            this->image = Image(Image::ARGB,
-                jmax(1, imageBounds.getWidth()),
-                jmax(1, imageBounds.getHeight()),
-                true);
-
-            this->text.clear();
-        }
-
-        if (this->text != this->owner.getText())
-        {
-            Graphics imG(this->image);
-            auto &lg = imG.getInternalContext();
-            lg.addTransform(AffineTransform::scale(this->scale));
-
-            lg.setFill(Colours::transparentBlack);
-            lg.fillRect(compBounds, true);
-            lg.setFill(Colours::black);
-
-            this->owner.paintEntireComponent(imG, true);
-            this->text = this->owner.getText();
-        }
+        const float scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+        const auto compBounds = this->owner.getLocalBounds();
+
+        const auto colour = this->owner.findColour(Label::textColourId);
+        const auto extra = (uint64(colour.getARGB()) << 32) |
+            (uint64(compBounds.getWidth() & 0xffff) << 16) |
+            uint64(compBounds.getHeight() & 0xffff);
+        const auto key = TextSprites::makeKey(this->owner.getText(), this->owner.getFont(),
+            scale, extra * 31 + uint64(this->owner.getJustificationType().getFlags()));
+
+        const auto image = this->sprites->getSprite(key,
+            compBounds.getWidth(), compBounds.getHeight(), scale,
+            [this](Graphics &imG)
+            {
+                this->owner.paintEntireComponent(imG, true);
+            });
 
         g.setColour(Colours::black.withAlpha(this->owner.getAlpha()));
-        g.drawImageTransformed(this->image,
-            AffineTransform::scale(compBounds.getWidth() / (float)imageBounds.getWidth(),
-                compBounds.getHeight() / (float)imageBounds.getHeight()), false);
+        g.drawImageTransformed(image,
+            AffineTransform::scale(compBounds.getWidth() / (float)image.getWidth(),
+                compBounds.getHeight() / (float)image.getHeight()), false);
     }
 
     bool invalidateAll() override { return false; }
     bool invalidate(const Rectangle<int>& area) override { return false; }
 
     // Do nothing, this is called on every setVisible
-    // (image will be released anyway in a destructor)
+    // (the sprites are released along with the last label anyway)
     void releaseResources() override {}
 
 private:
 
-    Image image;
-    String text;
     Label &owner;
-    float scale;
+    SharedResourcePointer<TextSprites> sprites;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CachedLabelImage)
 };
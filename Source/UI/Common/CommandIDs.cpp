@@ -95,6 +95,8 @@ CommandIDs::Id CommandIDs::getIdForName(const String &command)
         CASE_FOR(ResetPreviewChanges)
         CASE_FOR(TransportStartPlayback)
         CASE_FOR(TransportPausePlayback)
+        CASE_FOR(TransportStartRecording)
+        CASE_FOR(TransportToggleMetronome)
         CASE_FOR(PopupMenuDismiss)
         CASE_FOR(RenderToFLAC)
         CASE_FOR(RenderToWAV)
@@ -122,6 +124,9 @@ CommandIDs::Id CommandIDs::getIdForName(const String &command)
         CASE_FOR(SelectSampleRate)
         CASE_FOR(SelectBufferSize)
         CASE_FOR(SelectFont)
+        CASE_FOR(SelectProcessingThreads)
+        CASE_FOR(SelectLatencyCompensation)
+        CASE_FOR(SelectBufferSizeMode)
         CASE_FOR(EditModeDefault)
         CASE_FOR(EditModeDraw)
         CASE_FOR(EditModePan)
@@ -239,6 +244,8 @@ Identifier CommandIDs::getTranslationKeyFor(CommandIDs::Id id)
         TRANS_NONE(ResetPreviewChanges)
         TRANS_NONE(TransportStartPlayback)
         TRANS_NONE(TransportPausePlayback)
+        TRANS_NONE(TransportStartRecording)
+        TRANS_NONE(TransportToggleMetronome)
         TRANS_NONE(PopupMenuDismiss)
         TRANS_KEY(RenderToFLAC, Menu::Project::renderFlac)
         TRANS_KEY(RenderToWAV, Menu::Project::renderWav)
@@ -266,6 +273,9 @@ Identifier CommandIDs::getTranslationKeyFor(CommandIDs::Id id)
         TRANS_NONE(SelectSampleRate)
         TRANS_NONE(SelectBufferSize)
         TRANS_NONE(SelectFont)
+        TRANS_NONE(SelectProcessingThreads)
+        TRANS_NONE(SelectLatencyCompensation)
+        TRANS_NONE(SelectBufferSizeMode)
         TRANS_NONE(EditModeDefault)
         TRANS_NONE(EditModeDraw)
         TRANS_NONE(EditModePan)
@@ -98,6 +98,8 @@ namespace CommandIDs
 
         TransportStartPlayback          = 0x2013,
         TransportPausePlayback          = 0x2014,
+        TransportStartRecording         = 0x2016,
+        TransportToggleMetronome        = 0x2017,
 
         PopupMenuDismiss                = 0x2015,
 
@@ -134,6 +136,10 @@ namespace CommandIDs
         SelectSampleRate                = 0x3600,
         SelectBufferSize                = 0x3700, // more ids reserved for sub-items
         SelectFont                      = 0x3800, // more ids reserved for sub-items
+        SelectProcessingThreads         = 0x3900, // more ids reserved for sub-items
+        SelectMemoryBudget              = 0x3A00, // more ids reserved for sub-items
+        SelectLatencyCompensation       = 0x3B00, // more ids reserved for sub-items
+        SelectBufferSizeMode            = 0x3C00, // more ids reserved for sub-items
 
         EditModeDefault                 = 0x4000,
         EditModeDraw                    = 0x4001,
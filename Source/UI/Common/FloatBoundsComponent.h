@@ -40,4 +40,11 @@ protected:
 
     Rectangle<float> floatLocalBounds;
 
+private:
+
+    // the rolls batch the bounds updates, and skip
+    // the components which are already scheduled
+    friend class HybridRoll;
+    bool hasPendingBatchRepaint = false;
+
 };
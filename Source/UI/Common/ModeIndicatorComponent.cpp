@@ -18,8 +18,9 @@
 #include "Common.h"
 #include "ModeIndicatorComponent.h"
 #include "ComponentIDs.h"
+#include "AnimationClock.h"
 
-class ModeIndicatorBar final : public Component, private Timer
+class ModeIndicatorBar final : public Component, private AnimationClock::Listener
 {
 public:
 
@@ -42,7 +43,7 @@ public:
         this->animationDirection = state ? 1.f : -1.f;
         this->animationSpeed = MODE_BAR_ANIMATION_SPEED;
         this->isHighlighted = state;
-        this->startTimerHz(60);
+        this->startAnimating();
     }
 
     void paint(Graphics &g) override
@@ -59,7 +60,7 @@ private:
     float animationDirection;
     float animationSpeed;
 
-    void timerCallback() override
+    void onAnimationFrame() override
     {
         this->brightness += this->animationDirection * this->animationSpeed;
         this->animationSpeed *= MODE_BAR_ANIMATION_ACCELERATION;
@@ -67,7 +68,7 @@ private:
         if (this->brightness < 0.001f || this->brightness > 0.999f)
         {
             this->brightness = jlimit(0.f, 1.f, this->brightness);
-            this->stopTimer();
+            this->stopAnimating();
         }
 
         this->repaint();
@@ -0,0 +1,89 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+// A pass-through CachedComponentImage, which doesn't cache anything,
+// but can swallow all repaints of the owner and its children for a while,
+// e.g. during some bulk update, and then invalidate their union at once.
+// Unlike hiding the component, it doesn't trigger any visibility callbacks,
+// focus changes or relayouts, and the suspensions can be nested.
+
+struct RepaintSuspender final : public CachedComponentImage
+{
+    RepaintSuspender(Component &c) noexcept : owner(c) {}
+
+    void paint(Graphics &g) override
+    {
+        this->owner.paintEntireComponent(g, false);
+    }
+
+    bool invalidateAll() override
+    {
+        return this->invalidate(this->owner.getLocalBounds());
+    }
+
+    bool invalidate(const Rectangle<int> &area) override
+    {
+        if (this->numSuspensions == 0)
+        {
+            return true;
+        }
+
+        this->dirtyArea = this->dirtyArea.isEmpty() ? area : this->dirtyArea.getUnion(area);
+        return false;
+    }
+
+    void releaseResources() override {}
+
+    inline bool isSuspended() const noexcept
+    {
+        return this->numSuspensions > 0;
+    }
+
+    void suspend() noexcept
+    {
+        this->numSuspensions++;
+    }
+
+    // returns true, if this was the outermost suspension
+    bool resume()
+    {
+        jassert(this->numSuspensions > 0);
+        if (--this->numSuspensions > 0)
+        {
+            return false;
+        }
+
+        if (!this->dirtyArea.isEmpty())
+        {
+            const auto area = this->dirtyArea;
+            this->dirtyArea = {};
+            this->owner.repaint(area);
+        }
+
+        return true;
+    }
+
+private:
+
+    Component &owner;
+    Rectangle<int> dirtyArea;
+    int numSuspensions = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(RepaintSuspender)
+};
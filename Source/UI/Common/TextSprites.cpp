@@ -0,0 +1,117 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Common.h"
+#include "TextSprites.h"
+
+TextSprites::TextSprites()
+{
+    App::Memory().registerCache(this, MemoryBudget::Priority::Normal);
+}
+
+TextSprites::~TextSprites()
+{
+    App::Memory().unregisterCache(this);
+}
+
+uint64 TextSprites::makeKey(const String &text, const Font &font,
+    float scale, uint64 extra /*= 0*/) noexcept
+{
+    // using unsigned ints to wrap values around, as in Scale::hashCode
+    constexpr uint64 prime = 31;
+    uint64 hash = uint64(text.hashCode64());
+    hash = hash * prime + uint64(font.getTypefaceName().hashCode64());
+    hash = hash * prime + uint64(font.getTypefaceStyle().hashCode64());
+    hash = hash * prime + uint64(roundToInt(font.getHeight() * 100.f));
+    hash = hash * prime + uint64(roundToInt(font.getHorizontalScale() * 100.f));
+    hash = hash * prime + uint64(roundToInt(scale * 100.f));
+    hash = hash * prime + extra;
+    return hash;
+}
+
+Image TextSprites::getSprite(uint64 key, int width, int height,
+    float scale, const Renderer &renderer)
+{
+    const auto found = this->sprites.find(key);
+    if (found != this->sprites.end())
+    {
+        App::Memory().touchEntry(this, int64(key));
+        return found->second;
+    }
+
+    Image sprite(Image::ARGB,
+        jmax(1, int(ceilf(float(width) * scale))),
+        jmax(1, int(ceilf(float(height) * scale))), true);
+
+    {
+        Graphics g(sprite);
+        g.addTransform(AffineTransform::scale(scale));
+        renderer(g);
+    }
+
+    this->sprites[key] = sprite;
+    App::Memory().addEntry(this, int64(key), MemoryBudget::getImageCost(sprite));
+    return sprite;
+}
+
+void TextSprites::drawText(Graphics &g, const String &text, const Font &font,
+    const Rectangle<float> &area, Justification justification)
+{
+    if (text.isEmpty())
+    {
+        return;
+    }
+
+    const float scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+    const float textWidth = font.getStringWidthFloat(text);
+    const int width = int(ceilf(textWidth)) + 2;
+    const int height = int(ceilf(font.getHeight())) + 1;
+
+    // the sprite is white, so that it can be filled with any colour
+    const auto sprite = this->getSprite(TextSprites::makeKey(text, font, scale), width, height, scale,
+        [&text, &font](Graphics &sg)
+        {
+            GlyphArrangement glyphs;
+            glyphs.addLineOfText(font, text, 0.f, font.getAscent());
+            sg.setColour(Colours::white);
+            glyphs.draw(sg);
+        });
+
+    const auto textBounds = justification.appliedToRectangle(
+        Rectangle<float>(textWidth, font.getHeight()), area);
+
+    // snapping to physical pixels keeps the blit sharp
+    const float x = roundf(textBounds.getX() * scale) / scale;
+    const float y = roundf(textBounds.getY() * scale) / scale;
+
+    g.drawImageTransformed(sprite,
+        AffineTransform::scale(1.f / scale).translated(x, y), true);
+}
+
+//===----------------------------------------------------------------------===//
+// MemoryBudget::Cache
+//===----------------------------------------------------------------------===//
+
+String TextSprites::getCacheName() const
+{
+    return "Text sprites";
+}
+
+void TextSprites::evictCacheEntry(int64 entryId)
+{
+    this->sprites.erase(uint64(entryId));
+}
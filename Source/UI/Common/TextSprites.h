@@ -0,0 +1,63 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "MemoryBudget.h"
+
+/*
+    The pre-rendered text images shared by all the components which show
+    the same strings over and over again, like the timeline markers: with
+    a rehearsal mark or a time signature on every bar, laying out and filling
+    the glyphs on each paint costs way more than a blit.
+
+    The sprites are keyed by everything affecting the rendering, including
+    the physical pixel scale, so that they stay crisp on HiDPI displays,
+    and they are evicted by the memory budget as any other cache.
+*/
+
+class TextSprites final : private MemoryBudget::Cache
+{
+public:
+
+    TextSprites();
+    ~TextSprites() override;
+
+    using Renderer = Function<void(Graphics &g)>;
+
+    static uint64 makeKey(const String &text, const Font &font,
+        float scale, uint64 extra = 0) noexcept;
+
+    // returns the cached image, or renders it with the given function,
+    // which draws in the logical coordinates of a width x height area
+    Image getSprite(uint64 key, int width, int height,
+        float scale, const Renderer &renderer);
+
+    // draws a single line of text using the current colour,
+    // in the same position as GlyphArrangement::addFittedText would
+    void drawText(Graphics &g, const String &text, const Font &font,
+        const Rectangle<float> &area, Justification justification);
+
+private:
+
+    String getCacheName() const override;
+    void evictCacheEntry(int64 entryId) override;
+
+    FlatHashMap<uint64, Image> sprites;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TextSprites)
+};
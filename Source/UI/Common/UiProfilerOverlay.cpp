@@ -0,0 +1,113 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "Common.h"
+#include "UiProfilerOverlay.h"
+
+#define UI_PROFILER_OVERLAY_WIDTH (360)
+#define UI_PROFILER_OVERLAY_HEIGHT (200)
+#define UI_PROFILER_OVERLAY_GRAPH_HEIGHT (80)
+#define UI_PROFILER_OVERLAY_ROW_HEIGHT (16)
+#define UI_PROFILER_OVERLAY_NUM_OFFENDERS (5)
+#define UI_PROFILER_OVERLAY_MAX_FRAME_TIME_MS (50.0)
+
+UiProfilerOverlay::UiProfilerOverlay()
+{
+    this->setInterceptsMouseClicks(false, false);
+    this->setPaintingIsUnclipped(true);
+    this->setAlwaysOnTop(true);
+    this->setOpaque(false);
+
+    this->setSize(UI_PROFILER_OVERLAY_WIDTH, UI_PROFILER_OVERLAY_HEIGHT);
+    this->startTimerHz(10);
+}
+
+UiProfilerOverlay::~UiProfilerOverlay()
+{
+    this->stopTimer();
+}
+
+void UiProfilerOverlay::timerCallback()
+{
+    this->frames = UiProfiler::getRecentFrames();
+    this->worstOffenders = UiProfiler::getWorstOffenders(UI_PROFILER_OVERLAY_NUM_OFFENDERS);
+    this->repaint();
+}
+
+void UiProfilerOverlay::parentSizeChanged()
+{
+    if (auto *parent = this->getParentComponent())
+    {
+        this->setTopRightPosition(parent->getWidth(), 0);
+    }
+}
+
+// not instrumented with UI_PROFILER_PAINT_SCOPE, so that it doesn't measure itself
+void UiProfilerOverlay::paint(Graphics &g)
+{
+    g.fillAll(Colours::black.withAlpha(0.75f));
+
+    const auto w = float(this->getWidth());
+    const auto graphHeight = float(UI_PROFILER_OVERLAY_GRAPH_HEIGHT);
+    const auto barWidth = w / float(jmax(1, this->frames.size()));
+    const auto getY = [graphHeight](double ms)
+    {
+        return graphHeight * (1.f - float(jmin(ms, UI_PROFILER_OVERLAY_MAX_FRAME_TIME_MS) /
+            UI_PROFILER_OVERLAY_MAX_FRAME_TIME_MS));
+    };
+
+    // the frame budgets at 60 and 30 fps
+    g.setColour(Colours::white.withAlpha(0.25f));
+    g.drawHorizontalLine(int(getY(1000.0 / 60.0)), 0.f, w);
+    g.drawHorizontalLine(int(getY(1000.0 / 30.0)), 0.f, w);
+
+    double worstFrameMs = 0.0;
+    int64 maxPaintedArea = 0;
+    for (int i = 0; i < this->frames.size(); ++i)
+    {
+        const auto &frame = this->frames.getReference(i);
+        worstFrameMs = jmax(worstFrameMs, frame.paintTimeMs);
+        maxPaintedArea = jmax(maxPaintedArea, frame.paintedArea);
+
+        const auto y = getY(frame.paintTimeMs);
+        g.setColour(frame.paintTimeMs > 1000.0 / 60.0 ? Colours::orangered : Colours::limegreen);
+        g.fillRect(float(i) * barWidth, y, jmax(1.f, barWidth - 1.f), graphHeight - y);
+    }
+
+    g.setFont(Font(Font::getDefaultMonospacedFontName(), 12.f, Font::plain));
+    g.setColour(Colours::white);
+
+    int y = UI_PROFILER_OVERLAY_GRAPH_HEIGHT + 4;
+    const auto drawRow = [&g, &y, this](const String &text)
+    {
+        g.drawText(text, 4, y, this->getWidth() - 8,
+            UI_PROFILER_OVERLAY_ROW_HEIGHT, Justification::centredLeft, true);
+        y += UI_PROFILER_OVERLAY_ROW_HEIGHT;
+    };
+
+    drawRow("worst frame " + String(worstFrameMs, 1) + " ms, max area " +
+        String(maxPaintedArea / 1000) + "k px, queue latency " +
+        String(UiProfiler::getMessageLatencyMs(), 1) + " (max " +
+        String(UiProfiler::getMaxMessageLatencyMs(), 1) + ") ms");
+
+    for (const auto &stats : this->worstOffenders)
+    {
+        drawRow(String(stats.name) + ": " + String(stats.numPaints) + "x, " +
+            String(stats.paintTimeMs, 1) + " ms, " + String(stats.paintedArea / 1000) + "k px");
+    }
+}
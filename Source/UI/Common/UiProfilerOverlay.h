@@ -15,31 +15,28 @@
     along with Helio. If not, see <http://www.gnu.org/licenses/>.
 */
 
+
 #pragma once
 
-class RevisionConnectorComponent :
-    public Component,
-    public SettableTooltipClient
+#include "UiProfiler.h"
+
+// Shows what UiProfiler has recorded, see the comments there
+class UiProfilerOverlay final : public Component, private Timer
 {
 public:
 
-    RevisionConnectorComponent(Component *c1, Component *c2);
-
-    void resizeToFit();
+    UiProfilerOverlay();
+    ~UiProfilerOverlay() override;
 
     void paint(Graphics &g) override;
-
-    void resized() override;
+    void parentSizeChanged() override;
 
 private:
 
-    void getPoints(float &x1, float &y1, float &x2, float &y2) const;
-
-    Path linePath;
-
-    SafePointer<Component> component1;
+    void timerCallback() override;
 
-    SafePointer<Component> component2;
+    Array<UiProfiler::FrameStats> frames;
+    Array<UiProfiler::ComponentStats> worstOffenders;
 
-    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(RevisionConnectorComponent)
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(UiProfilerOverlay)
 };
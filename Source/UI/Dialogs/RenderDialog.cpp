@@ -339,12 +339,22 @@ void RenderDialog::timerCallback()
     {
         const float percentsDone = transport.getRenderingPercentsComplete();
         this->slider->setValue(percentsDone, dontSendNotification);
+
+        const auto realtimeRatio = transport.getRenderingRealtimeRatio();
+        if (realtimeRatio > 0.0)
+        {
+            const auto timeLeft = RelativeTime::milliseconds(int64(transport.getRenderingTimeLeftMs()));
+            this->filenameLabel->setText(TRANS(I18n::Dialog::renderProgress)
+                .replace("{time}", timeLeft.getDescription())
+                .replace("{speed}", String(realtimeRatio, 1)), dontSendNotification);
+        }
     }
     else
     {
         this->stopTrackingProgress();
         transport.stopRender();
-        App::Layout().showTooltip({}, MainLayout::TooltipType::Success);
+        App::Layout().showTooltip({}, transport.hasRenderFailed() ?
+            MainLayout::TooltipType::Failure : MainLayout::TooltipType::Success);
     }
 }
 
@@ -363,6 +373,7 @@ void RenderDialog::stopTrackingProgress()
     Transport &transport = this->project.getTransport();
     const float percentsDone = transport.getRenderingPercentsComplete();
     this->slider->setValue(percentsDone, dontSendNotification);
+    this->filenameLabel->setText(TRANS(I18n::Dialog::renderCaption), dontSendNotification);
 
     this->animator.fadeOut(this->indicator.get(), 250);
     this->indicator->stopAnimating();
@@ -18,12 +18,13 @@
 #pragma once
 
 #include "SmoothPanListener.h"
+#include "AnimationClock.h"
 
 #define SMOOTH_PAN_STOP_FACTOR 5
 #define SMOOTH_PAN_SLOWDOWN_FACTOR 0.95f
 #define SMOOTH_PAN_DISABLED 1
 
-class SmoothPanController final : private Timer
+class SmoothPanController final : private AnimationClock::Listener
 {
 public:
 
@@ -32,7 +33,7 @@ public:
 
     void cancelPan()
     {
-        this->stopTimer();
+        this->stopAnimating();
     }
 
     void panByOffset(Point<int> offset)
@@ -46,9 +47,9 @@ public:
         this->origin = this->listener.getPanOffset().toFloat();
         this->target = offset.toFloat();
 
-        if (!this->isTimerRunning())
+        if (!this->isAnimating())
         {
-            this->startTimerHz(60);
+            this->startAnimating();
             this->process();
         }
         else
@@ -61,7 +62,7 @@ public:
 
 private:
 
-    void timerCallback() override
+    void onAnimationFrame() override
     {
         this->process();
     }
@@ -76,7 +77,7 @@ private:
 
         if (diff.getDistanceFromOrigin() < SMOOTH_PAN_STOP_FACTOR)
         {
-            this->stopTimer();
+            this->stopAnimating();
         }
     }
 
@@ -18,27 +18,17 @@
 #pragma once
 
 #include "SmoothZoomListener.h"
+#include "AnimationClock.h"
 
-class SmoothZoomController final :
-    private Thread,
-    private WaitableEvent,
-    private AsyncUpdater
+// The zoom is animated by the app's frame clock, one step per frame,
+// and the steps are scaled by the time elapsed since the previous frame,
+// so that the zoom feels the same no matter how often the frames come
+class SmoothZoomController final : private AnimationClock::Listener
 {
 public:
 
     explicit SmoothZoomController(SmoothZoomListener &parent) :
-        Thread("SmoothZoom"),
-        listener(parent)
-    {
-        this->startThread(8);
-    }
-
-    ~SmoothZoomController() override
-    {
-        this->signalThreadShouldExit();
-        this->signal();
-        this->stopThread(500);
-    }
+        listener(parent) {}
 
     inline float getInitialZoomSpeed() const noexcept
     {
@@ -47,78 +37,75 @@ public:
 
     inline bool isZooming() const noexcept
     {
-        return this->factorX.get() != 0.f;
+        return this->factorX != 0.f;
     }
 
     void cancelZoom() noexcept
     {
         this->factorX = 0.f;
         this->factorY = 0.f;
+        this->stopAnimating();
     }
 
     void zoomRelative(const Point<float> &from, const Point<float> &zoom) noexcept
     {
-        this->factorX = (this->factorX.get() + zoom.getX()) * this->zoomSmoothFactor;
-        this->factorY = (this->factorY.get() + zoom.getY()) * this->zoomSmoothFactor;
-        this->originX = from.getX();
-        this->originY = from.getY();
+        this->factorX = (this->factorX + zoom.getX()) * this->zoomSmoothFactor;
+        this->factorY = (this->factorY + zoom.getY()) * this->zoomSmoothFactor;
+        this->origin = from;
 
-        WaitableEvent::signal();
+        if (!this->isAnimating())
+        {
+            this->lastFrameTimeMs = Time::getMillisecondCounterHiRes() - this->stepDelay;
+            this->startAnimating();
+        }
     }
 
 private:
 
     inline bool stillNeedsZoom() const noexcept
     {
-        return juce_hypot(this->factorX.get(), this->factorY.get()) >= this->zoomStopFactor;
+        return juce_hypot(this->factorX, this->factorY) >= this->zoomStopFactor;
     }
 
-    void run() override
+    void onAnimationFrame() override
     {
-        while (! this->threadShouldExit())
+        if (!this->stillNeedsZoom())
         {
-            while (this->stillNeedsZoom())
-            {
-                if (this->threadShouldExit())
-                {
-                    return;
-                }
-
-                this->factorX = this->factorX.get() * this->zoomDecayFactor;
-                this->factorY = this->factorY.get() * this->zoomDecayFactor;
-
-                this->triggerAsyncUpdate();
-                Thread::sleep(this->timerDelay);
-            }
-
             this->cancelZoom();
+            return;
+        }
 
-            if (this->threadShouldExit())
-            {
-                return;
-            }
+        // the number of the fixed-rate decay steps since the last frame, which
+        // is fractional and may be several, if the message thread was busy
+        const auto timeNow = Time::getMillisecondCounterHiRes();
+        const auto numSteps = float(jlimit(0.0, double(this->maxStepsPerFrame),
+            (timeNow - this->lastFrameTimeMs) / double(this->stepDelay)));
+        this->lastFrameTimeMs = timeNow;
 
-            WaitableEvent::wait();
-        }
-    }
+        // all those steps are applied at once, as a sum of the geometric series
+        const auto decay = std::pow(this->zoomDecayFactor, numSteps);
+        const auto stepsSum = this->zoomDecayFactor * (1.f - decay) / (1.f - this->zoomDecayFactor);
+        const Point<float> zoom(this->factorX * stepsSum, this->factorY * stepsSum);
 
-    void handleAsyncUpdate() noexcept override
-    {
-        this->listener.zoomRelative(
-            { this->originX.get(), this->originY.get() },
-            { this->factorX.get(), this->factorY.get() });
+        this->factorX *= decay;
+        this->factorY *= decay;
+
+        this->listener.zoomRelative(this->origin, zoom);
     }
 
     SmoothZoomListener &listener;
 
-    Atomic<float> factorX = 0.f;
-    Atomic<float> factorY = 0.f;
-    Atomic<float> originX = 0.f;
-    Atomic<float> originY = 0.f;
+    float factorX = 0.f;
+    float factorY = 0.f;
+    Point<float> origin;
+
+    double lastFrameTimeMs = 0.0;
 
 private:
 
-    const int timerDelay = 8;
+    // the decay rate is defined per step, which is shorter than a frame
+    const int stepDelay = 8;
+    const float maxStepsPerFrame = 8.f;
     const float zoomStopFactor = 0.001f;
     const float zoomDecayFactor = 0.825f;
     const float zoomSmoothFactor = 0.9f;
@@ -43,6 +43,7 @@
 #include "Config.h"
 #include "ColourSchemesManager.h"
 #include "CommandPaletteCommonActions.h"
+#include "UiProfilerOverlay.h"
 
 MainLayout::MainLayout() :
     currentContent(nullptr)
@@ -76,6 +77,12 @@ MainLayout::MainLayout() :
 
     this->consoleCommonActions = makeUnique<CommandPaletteCommonActions>();
 
+    if (UiProfiler::isEnabled())
+    {
+        this->profilerOverlay = makeUnique<UiProfilerOverlay>();
+        this->addAndMakeVisible(this->profilerOverlay.get());
+    }
+
     if (const bool quickStartMode = App::Workspace().isInitialized())
     {
         this->show();
@@ -92,6 +99,7 @@ MainLayout::MainLayout() :
 MainLayout::~MainLayout()
 {
     this->removeAllChildren();
+    this->profilerOverlay = nullptr;
     this->consoleCommonActions = nullptr;
     this->hotkeyScheme = nullptr;
     this->headline = nullptr;
@@ -104,5 +104,8 @@ private:
 
     UniquePointer<CommandPaletteCommonActions> consoleCommonActions;
 
+    // only created with --profile-ui, see UiProfiler
+    UniquePointer<class UiProfilerOverlay> profilerOverlay;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MainLayout)
 };
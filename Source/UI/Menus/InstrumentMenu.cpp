@@ -21,6 +21,9 @@
 #include "Instrument.h"
 #include "ModalDialogInput.h"
 #include "PluginScanner.h"
+#include "HardwareMidiOutput.h"
+#include "AudioCore.h"
+#include "Workspace.h"
 #include "CommandIDs.h"
 #include "Icons.h"
 
@@ -29,11 +32,18 @@ InstrumentMenu::InstrumentMenu(InstrumentNode &instrumentNode, PluginScanner &sc
     pluginScanner(scanner)
 {
     this->updateContent(this->createDefaultMenu(), MenuPanel::SlideRight);
+    App::Workspace().getAudioCore().getPluginPrograms().addChangeListener(this);
+}
+
+InstrumentMenu::~InstrumentMenu()
+{
+    App::Workspace().getAudioCore().getPluginPrograms().removeChangeListener(this);
 }
 
 MenuPanel::Menu InstrumentMenu::createDefaultMenu()
 {
     MenuPanel::Menu menu;
+    this->shownProgramsNodeId = {};
 
     if (!instrumentNode.isSelected())
     {
@@ -77,6 +87,60 @@ MenuPanel::Menu InstrumentMenu::createDefaultMenu()
             this->updateContent(this->createEffectsMenu(), MenuPanel::SlideLeft);
         }));
 
+    menu.add(MenuItem::item(Icons::remote,
+        TRANS(I18n::Menu::instrumentMidiOutput))->
+        withSubmenu()->
+        withAction([this]()
+        {
+            this->updateContent(this->createMidiOutputsMenu(), MenuPanel::SlideLeft);
+        }));
+
+    const auto nodesWithPrograms = this->getNodesWithPrograms();
+
+    menu.add(MenuItem::item(Icons::audioPlugin,
+        TRANS(I18n::Menu::instrumentPrograms))->
+        withSubmenu()->
+        disabledIf(nodesWithPrograms.isEmpty())->
+        withAction([this, nodesWithPrograms]()
+        {
+            if (nodesWithPrograms.size() == 1)
+            {
+                this->updateContent(this->createProgramsMenu(nodesWithPrograms.getFirst()->nodeID), MenuPanel::SlideLeft);
+            }
+            else
+            {
+                this->updateContent(this->createProgramNodesMenu(), MenuPanel::SlideLeft);
+            }
+        }));
+
+    const auto instrument = this->instrumentNode.getInstrument();
+    const bool isEffectBus = instrument != nullptr && instrument->isEffectBus();
+
+    menu.add(MenuItem::item(isEffectBus ? Icons::toggleOn : Icons::toggleOff,
+        TRANS(I18n::Menu::instrumentEffectBus))->
+        disabledIf(instrument == nullptr)->
+        withAction([this, instrument, isEffectBus]()
+        {
+            if (instrument != nullptr)
+            {
+                instrument->setEffectBus(!isEffectBus);
+            }
+
+            this->updateContent(this->createDefaultMenu(), MenuPanel::SlideRight);
+        }));
+
+    if (!isEffectBus)
+    {
+        menu.add(MenuItem::item(Icons::volume,
+            TRANS(I18n::Menu::instrumentSends))->
+            withSubmenu()->
+            disabledIf(this->getEffectBuses().isEmpty())->
+            withAction([this]()
+            {
+                this->updateContent(this->createSendsMenu(), MenuPanel::SlideLeft);
+            }));
+    }
+
     menu.add(MenuItem::item(Icons::remove,
         TRANS(I18n::Menu::instrumentDelete))->
         closesMenu()->
@@ -147,3 +211,253 @@ MenuPanel::Menu InstrumentMenu::createInstrumentsMenu()
 
     return menu;
 }
+
+// Whatever reaches the midi output node of the instrument's graph
+// will be sent to the selected device, e.g. to play an external synth
+MenuPanel::Menu InstrumentMenu::createMidiOutputsMenu()
+{
+    MenuPanel::Menu menu;
+
+    menu.add(MenuItem::item(Icons::back, TRANS(I18n::Menu::back))->withTimer()->withAction([this]()
+    {
+        this->updateContent(this->createDefaultMenu(), MenuPanel::SlideRight);
+    }));
+
+    const auto instrument = this->instrumentNode.getInstrument();
+    if (instrument == nullptr)
+    {
+        return menu;
+    }
+
+    const auto currentDevice = instrument->getMidiOutputDevice();
+
+    menu.add(MenuItem::item(currentDevice.isEmpty() ? Icons::apply : Icons::close,
+        TRANS(I18n::Menu::instrumentMidiOutputNone))->
+        closesMenu()->
+        withAction([instrument]()
+        {
+            if (instrument != nullptr)
+            {
+                instrument->setMidiOutputDevice({});
+            }
+        }));
+
+    for (const auto &deviceName : HardwareMidiOutput::getAvailableDevices())
+    {
+        menu.add(MenuItem::item(deviceName == currentDevice ? Icons::apply : Icons::remote,
+            deviceName)->
+            closesMenu()->
+            withAction([instrument, deviceName]()
+            {
+                if (instrument != nullptr)
+                {
+                    instrument->setMidiOutputDevice(deviceName);
+                }
+            }));
+    }
+
+    return menu;
+}
+
+// The effect buses are the instruments which are fed by the other
+// instruments' sends instead of the notes, e.g. a shared reverb
+Array<Instrument *> InstrumentMenu::getEffectBuses() const
+{
+    Array<Instrument *> buses;
+    for (auto *instrument : App::Workspace().getAudioCore().getInstruments())
+    {
+        if (instrument->isEffectBus() &&
+            instrument != this->instrumentNode.getInstrument().get())
+        {
+            buses.add(instrument);
+        }
+    }
+
+    return buses;
+}
+
+MenuPanel::Menu InstrumentMenu::createSendsMenu()
+{
+    MenuPanel::Menu menu;
+
+    menu.add(MenuItem::item(Icons::back, TRANS(I18n::Menu::back))->withTimer()->withAction([this]()
+    {
+        this->updateContent(this->createDefaultMenu(), MenuPanel::SlideRight);
+    }));
+
+    const auto instrument = this->instrumentNode.getInstrument();
+    if (instrument == nullptr)
+    {
+        return menu;
+    }
+
+    for (auto *bus : this->getEffectBuses())
+    {
+        const auto busId = bus->getIdAndHash();
+        const bool hasSend = instrument->getSendLevel(busId) > 0.f;
+        menu.add(MenuItem::item(hasSend ? Icons::apply : Icons::instrument,
+            bus->getName())->
+            withSubmenu()->
+            withAction([this, busId]()
+            {
+                this->updateContent(this->createSendLevelsMenu(busId), MenuPanel::SlideLeft);
+            }));
+    }
+
+    return menu;
+}
+
+MenuPanel::Menu InstrumentMenu::createSendLevelsMenu(const String &busId)
+{
+    MenuPanel::Menu menu;
+
+    menu.add(MenuItem::item(Icons::back, TRANS(I18n::Menu::back))->withTimer()->withAction([this]()
+    {
+        this->updateContent(this->createSendsMenu(), MenuPanel::SlideRight);
+    }));
+
+    const auto instrument = this->instrumentNode.getInstrument();
+    if (instrument == nullptr)
+    {
+        return menu;
+    }
+
+    const auto currentLevel = instrument->getSendLevel(busId);
+
+    menu.add(MenuItem::item(currentLevel == 0.f ? Icons::apply : Icons::close,
+        TRANS(I18n::Menu::instrumentSendOff))->
+        closesMenu()->
+        withAction([instrument, busId]()
+        {
+            if (instrument != nullptr)
+            {
+                instrument->setSendLevel(busId, 0.f);
+            }
+        }));
+
+    for (const auto decibels : { -18.f, -12.f, -6.f, 0.f })
+    {
+        const auto level = Decibels::decibelsToGain(decibels);
+        menu.add(MenuItem::item(fabsf(currentLevel - level) < 0.001f ? Icons::apply : Icons::volume,
+            String(int(decibels)) + " dB")->
+            closesMenu()->
+            withAction([instrument, busId, level]()
+            {
+                if (instrument != nullptr)
+                {
+                    instrument->setSendLevel(busId, level);
+                }
+            }));
+    }
+
+    return menu;
+}
+
+Array<AudioProcessorGraph::Node::Ptr> InstrumentMenu::getNodesWithPrograms() const
+{
+    Array<AudioProcessorGraph::Node::Ptr> nodes;
+
+    const auto instrument = this->instrumentNode.getInstrument();
+    if (instrument == nullptr)
+    {
+        return nodes;
+    }
+
+    for (int i = 0; i < instrument->getNumNodes(); ++i)
+    {
+        const auto node = instrument->getNode(i);
+        if (!instrument->isNodeStandardIOProcessor(node) &&
+            node->getProcessor()->getNumPrograms() > 1)
+        {
+            nodes.add(node);
+        }
+    }
+
+    return nodes;
+}
+
+MenuPanel::Menu InstrumentMenu::createProgramNodesMenu()
+{
+    MenuPanel::Menu menu;
+    this->shownProgramsNodeId = {};
+
+    menu.add(MenuItem::item(Icons::back, TRANS(I18n::Menu::back))->withTimer()->withAction([this]()
+    {
+        this->updateContent(this->createDefaultMenu(), MenuPanel::SlideRight);
+    }));
+
+    for (const auto &node : this->getNodesWithPrograms())
+    {
+        const auto nodeId = node->nodeID;
+        menu.add(MenuItem::item(Icons::audioPlugin,
+            node->getProcessor()->getName())->
+            withSubmenu()->
+            withAction([this, nodeId]()
+            {
+                this->updateContent(this->createProgramsMenu(nodeId), MenuPanel::SlideLeft);
+            }));
+    }
+
+    return menu;
+}
+
+// The names come from the cache, which is filled in the background
+// after the plugin is loaded; if they aren't there yet, the menu
+// only shows the back button and gets refreshed when they are
+MenuPanel::Menu InstrumentMenu::createProgramsMenu(AudioProcessorGraph::NodeID nodeId)
+{
+    MenuPanel::Menu menu;
+    this->shownProgramsNodeId = nodeId;
+
+    const bool hasManyNodes = this->getNodesWithPrograms().size() > 1;
+    menu.add(MenuItem::item(Icons::back, TRANS(I18n::Menu::back))->withTimer()->withAction([this, hasManyNodes]()
+    {
+        this->updateContent(hasManyNodes ?
+            this->createProgramNodesMenu() : this->createDefaultMenu(), MenuPanel::SlideRight);
+    }));
+
+    const auto instrument = this->instrumentNode.getInstrument();
+    if (instrument == nullptr)
+    {
+        return menu;
+    }
+
+    const auto node = instrument->getNodeForId(nodeId);
+    if (node == nullptr)
+    {
+        return menu;
+    }
+
+    StringArray names;
+    App::Workspace().getAudioCore().getPluginPrograms().getProgramNames(node, names);
+
+    const auto currentProgram = node->getProcessor()->getCurrentProgram();
+    for (int i = 0; i < names.size(); ++i)
+    {
+        const auto name = names[i].isNotEmpty() ? names[i] : String(i + 1);
+        menu.add(MenuItem::item(i == currentProgram ? Icons::apply : Icons::audioPlugin, name)->
+            closesMenu()->
+            withAction([instrument, nodeId, i]()
+            {
+                if (instrument == nullptr)
+                {
+                    return;
+                }
+
+                if (const auto node = instrument->getNodeForId(nodeId))
+                {
+                    node->getProcessor()->setCurrentProgram(i);
+                }
+            }));
+    }
+
+    return menu;
+}
+
+void InstrumentMenu::changeListenerCallback(ChangeBroadcaster *)
+{
+    if (this->shownProgramsNodeId.uid != 0)
+    {
+        this->updateContent(this->createProgramsMenu(this->shownProgramsNodeId), MenuPanel::None);
+    }
+}
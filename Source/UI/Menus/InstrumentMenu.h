@@ -19,14 +19,16 @@
 
 class PluginScanner;
 class InstrumentNode;
+class Instrument;
 
 #include "MenuPanel.h"
 
-class InstrumentMenu final : public MenuPanel
+class InstrumentMenu final : public MenuPanel, private ChangeListener
 {
 public:
     
     InstrumentMenu(InstrumentNode &parentInstrument, PluginScanner &scanner);
+    ~InstrumentMenu() override;
     
 private:
     
@@ -36,5 +38,18 @@ private:
     MenuPanel::Menu createDefaultMenu();
     MenuPanel::Menu createEffectsMenu();
     MenuPanel::Menu createInstrumentsMenu();
+    MenuPanel::Menu createMidiOutputsMenu();
+    MenuPanel::Menu createSendsMenu();
+    MenuPanel::Menu createSendLevelsMenu(const String &busId);
+    MenuPanel::Menu createProgramNodesMenu();
+    MenuPanel::Menu createProgramsMenu(AudioProcessorGraph::NodeID nodeId);
+
+    Array<AudioProcessorGraph::Node::Ptr> getNodesWithPrograms() const;
+
+    // refreshes the programs list, when the names are enumerated
+    void changeListenerCallback(ChangeBroadcaster *source) override;
+    AudioProcessorGraph::NodeID shownProgramsNodeId;
+
+    Array<Instrument *> getEffectBuses() const;
 
 };
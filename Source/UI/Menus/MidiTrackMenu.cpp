@@ -33,11 +33,13 @@
 #include "MidiSequence.h"
 #include "PianoTrackNode.h"
 #include "AutomationTrackNode.h"
+#include "AutomationSequence.h"
 #include "MidiTrackActions.h"
 #include "PianoTrackActions.h"
 #include "AutomationTrackActions.h"
 #include "UndoStack.h"
 #include "Workspace.h"
+#include "Transport.h"
 
 MidiTrackMenu::MidiTrackMenu(MidiTrackNode &node) :
     trackNode(node)
@@ -70,6 +72,49 @@ void MidiTrackMenu::initDefaultMenu()
     menu.add(MenuItem::item(Icons::copy, CommandIDs::DuplicateTrack,
         TRANS(I18n::Menu::trackDuplicate))->closesMenu());
 
+    auto *instrument = App::Workspace().getAudioCore().findInstrumentById(this->trackNode.getTrackInstrumentId());
+    if (instrument != nullptr && this->trackNode.getProject() != nullptr)
+    {
+        auto &transport = this->trackNode.getProject()->getTransport();
+        const bool isFrozen = transport.isInstrumentFrozen(instrument);
+        const WeakReference<Instrument> instrumentRef(instrument);
+        menu.add(MenuItem::item(Icons::render,
+            TRANS(isFrozen ? I18n::Menu::trackUnfreeze : I18n::Menu::trackFreeze))->
+            disabledIf(transport.isRendering())->
+            closesMenu()->
+            withAction([&transport, instrumentRef, isFrozen]()
+            {
+                if (auto *instrument = instrumentRef.get())
+                {
+                    if (isFrozen)
+                    {
+                        transport.unfreezeInstrument(instrument);
+                    }
+                    else
+                    {
+                        transport.freezeInstrument(instrument);
+                    }
+                }
+            }));
+    }
+
+    if (auto *autoSequence = dynamic_cast<AutomationSequence *>(this->trackNode.getSequence()))
+    {
+        const WeakReference<MidiSequence> sequenceRef(autoSequence);
+        menu.add(MenuItem::item(Icons::refactor,
+            TRANS(I18n::Menu::trackSimplify))->
+            disabledIf(autoSequence->size() < 3)->
+            closesMenu()->
+            withAction([sequenceRef]()
+            {
+                if (auto *sequence = dynamic_cast<AutomationSequence *>(sequenceRef.get()))
+                {
+                    sequence->checkpoint();
+                    sequence->simplify(AUTOMATION_SIMPLIFICATION_TOLERANCE, true);
+                }
+            }));
+    }
+
     menu.add(MenuItem::item(Icons::remove, CommandIDs::DeleteTrack, TRANS(I18n::Menu::trackDelete)));
     this->updateContent(menu, MenuPanel::SlideRight);
 }
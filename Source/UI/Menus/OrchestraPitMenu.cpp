@@ -23,6 +23,30 @@
 #include "MainLayout.h"
 #include "PluginScanner.h"
 #include "Workspace.h"
+#include "AudioCore.h"
+#include "DocumentHelpers.h"
+
+// the playback timing stats of all instruments, see SchedulingTelemetry
+static File exportSchedulingTelemetry()
+{
+    Array<var> instruments;
+    for (const auto *instrument : App::Workspace().getAudioCore().getInstruments())
+    {
+        DynamicObject::Ptr json(new DynamicObject());
+        json->setProperty("name", instrument->getName());
+        json->setProperty("timing", instrument->getProcessorPlayer().getSchedulingTelemetry().toVar());
+        instruments.add(var(json.get()));
+    }
+
+    DynamicObject::Ptr root(new DynamicObject());
+    root->setProperty("version", App::getAppReadableVersion());
+    root->setProperty("date", Time::getCurrentTime().toISO8601(true));
+    root->setProperty("instruments", instruments);
+
+    const auto file = DocumentHelpers::getDocumentSlot("timing-report.json");
+    file.replaceWithText(JSON::toString(var(root.get())));
+    return file;
+}
 
 OrchestraPitMenu::OrchestraPitMenu(OrchestraPitNode &parentOrchestra) :
     instrumentsRoot(parentOrchestra)
@@ -41,6 +65,13 @@ OrchestraPitMenu::OrchestraPitMenu(OrchestraPitNode &parentOrchestra) :
     menu.add(MenuItem::item(Icons::browse,
         CommandIDs::ScanPluginsFolder,
         TRANS(I18n::Menu::instrumentsScanFolder))->closesMenu());
+
+    menu.add(MenuItem::item(Icons::list,
+        TRANS(I18n::Menu::instrumentsExportTimings))->closesMenu()->withAction([]()
+    {
+        const auto file = exportSchedulingTelemetry();
+        App::Layout().showTooltip(file.getFullPathName(), MainLayout::TooltipType::Success);
+    }));
         
     this->updateContent(menu, MenuPanel::SlideRight);
 }
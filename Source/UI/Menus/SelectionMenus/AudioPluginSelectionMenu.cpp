@@ -23,6 +23,7 @@
 #include "Workspace.h"
 #include "AudioCore.h"
 #include "Instrument.h"
+#include "SandboxedPluginFormat.h"
 #include "CommandIDs.h"
 #include "Icons.h"
 
@@ -51,6 +52,23 @@ MenuPanel::Menu AudioPluginSelectionMenu::createDefaultMenu()
         });
     }));
 
+    // for the plugins which are known to crash or hang sometimes
+    if (SandboxedPluginFormat::canBeSandboxed(this->pluginDescription))
+    {
+        menu.add(MenuItem::item(Icons::create, TRANS(I18n::Menu::Selection::pluginInitSandboxed))->
+            closesMenu()->
+            withAction([this]()
+        {
+            App::Workspace().getAudioCore().addInstrument(
+                SandboxedPluginFormat::wrap(this->pluginDescription),
+                this->pluginDescription.descriptiveName,
+                [this](Instrument *instrument)
+            {
+                this->orchestraNode.addInstrumentNode(instrument);
+            });
+        }));
+    }
+
     const auto instruments = this->orchestraNode.findChildrenOfType<InstrumentNode>();
     menu.add(MenuItem::item(Icons::audioPlugin, TRANS(I18n::Menu::Selection::pluginPlug))->
         withSubmenu()->
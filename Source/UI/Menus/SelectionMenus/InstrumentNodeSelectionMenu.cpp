@@ -114,6 +114,7 @@ MenuPanel::Menu InstrumentNodeSelectionMenu::createAudioSourcesMenu()
             closesMenu()->
             withAction([this, n]()
         {
+            const Instrument::GraphEdit edit(this->instrument);
             this->instrument.addConnection(n->nodeID, 0, this->node->nodeID, 0);
             this->instrument.addConnection(n->nodeID, 1, this->node->nodeID, 1);
         }));
@@ -140,6 +141,7 @@ MenuPanel::Menu InstrumentNodeSelectionMenu::createAudioDestinationsMenu()
             closesMenu()->
             withAction([this, n]()
         {
+            const Instrument::GraphEdit edit(this->instrument);
             this->instrument.addConnection(this->node->nodeID, 0, n->nodeID, 0);
             this->instrument.addConnection(this->node->nodeID, 1, n->nodeID, 1);
         }));
@@ -33,21 +33,22 @@ VersionControlMenu::VersionControlMenu(VersionControl &vcs)
     MenuPanel::Menu menu;
 
     const bool noStashNoChanges = !vcs.hasQuickStash() && !vcs.getHead().hasAnythingOnTheStage();
+    const bool isCommitting = vcs.isCommitting();
     const Icons::Id stashIcon = vcs.hasQuickStash() ? Icons::toggleOff : Icons::toggleOn;
     const String stashMessage = vcs.hasQuickStash() ?
         TRANS(I18n::Menu::vcsChangesShow) : TRANS(I18n::Menu::vcsChangesHide);
 
     menu.add(MenuItem::item(stashIcon,
         CommandIDs::VersionControlToggleQuickStash,
-        stashMessage)->disabledIf(noStashNoChanges)->closesMenu());
+        stashMessage)->disabledIf(noStashNoChanges || isCommitting)->closesMenu());
 
     menu.add(MenuItem::item(Icons::commit,
         CommandIDs::VersionControlCommitAll,
-        TRANS(I18n::Menu::vcsCommitAll))->closesMenu());
+        TRANS(I18n::Menu::vcsCommitAll))->disabledIf(isCommitting)->closesMenu());
 
     menu.add(MenuItem::item(Icons::reset,
         CommandIDs::VersionControlResetAll,
-        TRANS(I18n::Menu::vcsResetAll))->closesMenu());
+        TRANS(I18n::Menu::vcsResetAll))->disabledIf(isCommitting)->closesMenu());
 
     const bool loggedIn = App::Workspace().getUserProfile().isLoggedIn();
 
@@ -28,6 +28,7 @@
 #include "Workspace.h"
 #include "CommandIDs.h"
 #include "ColourIDs.h"
+#include "StartupProfiler.h"
 //[/MiscUserDefs]
 
 InitScreen::InitScreen()
@@ -44,6 +45,9 @@ InitScreen::InitScreen()
     this->setFocusContainer(false);
     this->setOpaque(true);
 
+    this->backgroundTile = HelioTheme::renderBackgroundTile(HelioTheme::getCurrentTheme(),
+        findDefaultColour(ColourIDs::BackgroundA::fill), 1.5f);
+
     if (!App::isUsingNativeTitleBar())
     {
         this->headLine->setVisible(false);
@@ -91,7 +95,8 @@ void InitScreen::paint (Graphics& g)
     }
 
     //[UserPaint] Add your own custom painting code here..
-    HelioTheme::drawNoiseWithin(this->getLocalBounds().toFloat(), g, 1.5f);
+    g.setTiledImageFill(this->backgroundTile, 0, 0, 1.f);
+    g.fillRect(this->getLocalBounds());
     //[/UserPaint]
 }
 
@@ -126,6 +131,7 @@ void InitScreen::handleCommandMessage (int commandId)
     {
         App::Workspace().init();
         App::Layout().show();
+        StartupProfiler::runOpenProjectAndQuit();
     }
     //[/UserCode_handleCommandMessage]
 }
@@ -47,6 +47,8 @@ private:
 
     void timerCallback() override;
 
+    Image backgroundTile;
+
     //[/UserVariables]
 
     UniquePointer<SeparatorHorizontalReversed> headLine;
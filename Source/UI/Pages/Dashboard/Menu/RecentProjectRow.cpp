@@ -149,7 +149,13 @@ void RecentProjectRow::updateDescription(const RecentProjectInfo::Ptr file, bool
     this->isFileLoaded = isLoaded;
 
     this->titleLabel->setText(this->targetFile->getTitle(), dontSendNotification);
-    this->dateLabel->setText(App::getHumanReadableDate(this->targetFile->getUpdatedAt()), dontSendNotification);
+    String description = App::getHumanReadableDate(this->targetFile->getUpdatedAt());
+    if (this->targetFile->getNumTracks() > 0)
+    {
+        description << ", " << TRANS_PLURAL("{x} layers", this->targetFile->getNumTracks());
+    }
+
+    this->dateLabel->setText(description, dontSendNotification);
     this->remoteIndicatorImage->setAlpha(this->targetFile->hasRemoteCopy() ? 1.f : 0.3f);
     this->localIndicatorImage->setAlpha(this->targetFile->hasLocalCopy() ? 1.f : 0.3f);
 
@@ -76,8 +76,8 @@ void InstrumentComponent::mouseDrag(const MouseEvent &e)
         (pos.getX() + getWidth() / 2) / static_cast<double>(this->getParentWidth()),
         (pos.getY() + getHeight() / 2) / static_cast<double>(this->getParentHeight()));
 
-    this->getParentEditor()->updateComponents();
     this->setMouseCursor(MouseCursor::DraggingHandCursor);
+    this->getParentEditor()->updateNodeComponent(this);
 }
 
 void InstrumentComponent::mouseUp(const MouseEvent &e)
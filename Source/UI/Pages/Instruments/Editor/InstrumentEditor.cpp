@@ -83,16 +83,21 @@ void InstrumentEditor::changeListenerCallback(ChangeBroadcaster *)
 
 InstrumentComponent *InstrumentEditor::getComponentForNode(AudioProcessorGraph::NodeID id) const
 {
+    const auto found = this->nodeComponents.find(id.uid);
+    return found != this->nodeComponents.end() ? found->second.getComponent() : nullptr;
+}
+
+void InstrumentEditor::rebuildNodeComponentsIndex()
+{
+    this->nodeComponents.clear();
     for (int i = this->getNumChildComponents(); --i >= 0;)
     {
-        if (auto fc = dynamic_cast<InstrumentComponent *>(this->getChildComponent(i))) {
-            if (fc->nodeId == id)
-            { return fc; }
+        if (auto *fc = dynamic_cast<InstrumentComponent *>(this->getChildComponent(i)))
+        {
+            this->nodeComponents[fc->nodeId.uid] = fc;
         }
     }
-    
-    return nullptr;
-} 
+}
 
 InstrumentEditorConnector *InstrumentEditor::getComponentForConnection(AudioProcessorGraph::Connection conn) const
 {
@@ -154,10 +159,32 @@ void InstrumentEditor::updateComponents()
     {
         if (auto *fc = dynamic_cast<InstrumentComponent *>(getChildComponent(i)))
         {
-            fc->update();
+            fc->update(); // may delete itself
         }
     }
-    
+
+    this->rebuildNodeComponentsIndex();
+
+    for (int i = instrument->getNumNodes(); --i >= 0;)
+    {
+        const AudioProcessorGraph::Node::Ptr f(instrument->getNode(i));
+        if (this->getComponentForNode(f->nodeID) == nullptr)
+        {
+            auto *comp = new InstrumentComponent(instrument, f->nodeID);
+            this->addAndMakeVisible(comp);
+            this->nodeComponents[f->nodeID.uid] = comp;
+            comp->update();
+        }
+    }
+
+    // the nodes are all in place now, so the connectors are updated once
+    FlatHashSet<String, StringHash> existingConnections;
+    const auto getConnectionKey = [](const AudioProcessorGraph::Connection &c)
+    {
+        return String(c.source.nodeID.uid) + ":" + String(c.source.channelIndex) + "-" +
+            String(c.destination.nodeID.uid) + ":" + String(c.destination.channelIndex);
+    };
+
     for (int i = this->getNumChildComponents(); --i >= 0;)
     {
         auto cc = dynamic_cast<InstrumentEditorConnector *>(getChildComponent(i));
@@ -169,33 +196,37 @@ void InstrumentEditor::updateComponents()
             }
             else
             {
+                existingConnections.insert(getConnectionKey(cc->connection));
                 cc->update();
             }
         }
     }
-    
-    for (int i = instrument->getNumNodes(); --i >= 0;)
+
+    for (const auto &c : instrument->getConnections())
     {
-        const AudioProcessorGraph::Node::Ptr f(instrument->getNode(i));
-        if (this->getComponentForNode(f->nodeID) == nullptr)
+        if (!existingConnections.contains(getConnectionKey(c)))
         {
-            auto *comp = new InstrumentComponent(instrument, f->nodeID);
+            auto *comp = new InstrumentEditorConnector(instrument);
             this->addAndMakeVisible(comp);
-            comp->update();
+            comp->setInput(c.source);
+            comp->setOutput(c.destination);
         }
     }
-    
-    const auto &connections = instrument->getConnections();
-    const int numConnections = int(connections.size());
-    for (int i = numConnections; --i >= 0;)
+}
+
+void InstrumentEditor::updateNodeComponent(InstrumentComponent *nodeComponent)
+{
+    const auto nodeId = nodeComponent->nodeId;
+    nodeComponent->update(); // may delete itself
+
+    for (int i = this->getNumChildComponents(); --i >= 0;)
     {
-        AudioProcessorGraph::Connection c = connections.at(i);
-        if (this->getComponentForConnection(c) == nullptr)
+        auto *cc = dynamic_cast<InstrumentEditorConnector *>(getChildComponent(i));
+        if (cc != nullptr && cc != this->draggingConnector.get() &&
+            (cc->connection.source.nodeID == nodeId ||
+             cc->connection.destination.nodeID == nodeId))
         {
-            auto *comp = new InstrumentEditorConnector(instrument);
-            this->addAndMakeVisible(comp);
-            comp->setInput(c.source);
-            comp->setOutput(c.destination);
+            cc->update();
         }
     }
 }
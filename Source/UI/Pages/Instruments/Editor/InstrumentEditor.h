@@ -39,6 +39,10 @@ public:
     void selectNode(AudioProcessorGraph::NodeID id);
     void updateComponents();
 
+    // only updates the node and the connectors attached to it,
+    // e.g. while dragging it, instead of the whole graph
+    void updateNodeComponent(InstrumentComponent *nodeComponent);
+
     InstrumentComponent *getComponentForNode(AudioProcessorGraph::NodeID id) const;
     InstrumentEditorConnector *getComponentForConnection(AudioProcessorGraph::Connection conn) const;
     InstrumentEditorPin *findPinAt(const int x, const int y) const;
@@ -82,5 +86,10 @@ private:
 
     AudioProcessorGraph::NodeID selectedNode;
 
+    // the connectors look up their nodes on every update,
+    // so these are indexed instead of scanning all children
+    FlatHashMap<uint32, Component::SafePointer<InstrumentComponent>> nodeComponents;
+    void rebuildNodeComponentsIndex();
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(InstrumentEditor)
 };
@@ -134,6 +134,13 @@ void InstrumentEditorConnector::paint(Graphics &g)
 
 bool InstrumentEditorConnector::hitTest(int x, int y)
 {
+    if (this->hitPathIsOutdated)
+    {
+        PathStrokeType wideStroke(8.0f);
+        wideStroke.createStrokedPath(this->hitPath, this->curvePath);
+        this->hitPathIsOutdated = false;
+    }
+
     if (hitPath.contains(static_cast<float>( x), static_cast<float>( y)))
     {
         double distanceFromStart, distanceFromEnd;
@@ -199,11 +206,24 @@ void InstrumentEditorConnector::resized()
     x2 -= this->getX();
     y2 -= this->getY();
 
+    const Line<float> pathEnds(x1, y1, x2, y2);
+    const auto parentBounds = this->getParentComponent() != nullptr ?
+        this->getParentComponent()->getLocalBounds() : Rectangle<int>();
+
+    if (pathEnds == this->lastPathEnds &&
+        parentBounds == this->lastPathParentBounds && !linePath.isEmpty())
+    {
+        return;
+    }
+
+    this->lastPathEnds = pathEnds;
+    this->lastPathParentBounds = parentBounds;
+
     const float dy = (y2 - y1);
     const float dx = (x2 - x1);
 
-    linePath.clear();
-    linePath.startNewSubPath(x1, y1);
+    curvePath.clear();
+    curvePath.startNewSubPath(x1, y1);
 
     const float curvinessX = (this->getParentWidth() == 0) ? 0.f : (1.f - (fabs(dx) / float(this->getParentWidth()))) * 1.5f;
     const float curvinessY = (this->getParentHeight() == 0) ? 0.f : (fabs(dy) / float(this->getParentHeight())) * 1.5f;
@@ -214,15 +234,14 @@ void InstrumentEditorConnector::resized()
     gravity = jmin(1.f, gravity);
     gravity = (gravity / 3.f) + 0.45f;
 
-    linePath.cubicTo(x1 + dx * (curviness * (1.f - gravity)), y1,
-                     x1 + dx * (1.f - (curviness * gravity)), y2,
-                     x2, y2);
+    curvePath.cubicTo(x1 + dx * (curviness * (1.f - gravity)), y1,
+                      x1 + dx * (1.f - (curviness * gravity)), y2,
+                      x2, y2);
 
-    PathStrokeType wideStroke(8.0f);
-    wideStroke.createStrokedPath(hitPath, linePath);
+    this->hitPathIsOutdated = true;
 
     PathStrokeType stroke(6.5f, PathStrokeType::beveled, PathStrokeType::rounded);
-    stroke.createStrokedPath(linePath, linePath);
+    stroke.createStrokedPath(linePath, curvePath);
 
     linePath.setUsingNonZeroWinding(false);
 }
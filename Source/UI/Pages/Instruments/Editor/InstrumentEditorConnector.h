@@ -57,7 +57,13 @@ private:
     float lastOutputX = 0.f;
     float lastOutputY = 0.f;
 
-    Path linePath, hitPath;
+    // the paths are only rebuilt when either end moves or the editor is resized,
+    // and the hit-test one is only stroked when something is hit-tested at all
+    Path linePath, hitPath, curvePath;
+    Line<float> lastPathEnds;
+    Rectangle<int> lastPathParentBounds;
+    bool hitPathIsOutdated = true;
+
     bool dragging = false;
 
     InstrumentEditor *getGraphPanel() const noexcept;
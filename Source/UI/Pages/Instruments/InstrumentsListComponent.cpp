@@ -26,8 +26,14 @@
 #include "OrchestraPitPage.h"
 #include "InstrumentMenu.h"
 #include "Instrument.h"
+#include "SandboxedPlugin.h"
+#include "AudioCore.h"
+#include "Workspace.h"
 #include "MainLayout.h"
 #include "Icons.h"
+
+// the load meters don't need to be any smoother than that
+#define INSTRUMENTSLIST_LOAD_UPDATE_HZ 4
 //[/MiscUserDefs]
 
 InstrumentsListComponent::InstrumentsListComponent(PluginScanner &pluginScanner, OrchestraPitNode &instrumentsRoot)
@@ -77,6 +83,17 @@ void InstrumentsListComponent::paint (Graphics& g)
     //[/UserPrePaint]
 
     //[UserPaint] Add your own custom painting code here..
+    // the sum of the instruments' loads, and the headroom left
+    // until a dropout, which is measured for the whole callback,
+    // so it takes the parallel processing into account
+    const auto totalLoad = this->instrumentsRoot.getTotalProcessingLoad();
+    const auto engineLoad = App::Workspace().getAudioCore().getProcessingLoad();
+    const auto headroom = jmax(0.f, 100.f - engineLoad.peakPercent);
+    g.setFont(13.f);
+    g.setColour(findDefaultColour(ListBox::textColourId).withMultipliedAlpha(0.5f));
+    g.drawText(String(totalLoad, 1) + "%, " + TRANS(I18n::Page::orchestraHeadroom) +
+        ": " + String(roundToInt(headroom)) + "%", 0, 0,
+        this->getWidth() - 8, 26, Justification::centredRight, false);
     //[/UserPaint]
 }
 
@@ -98,6 +115,11 @@ void InstrumentsListComponent::parentHierarchyChanged()
     if (this->getParentComponent() != nullptr)
     {
         this->updateListContent();
+        this->startTimerHz(INSTRUMENTSLIST_LOAD_UPDATE_HZ);
+    }
+    else
+    {
+        this->stopTimer();
     }
     //[/UserCode_parentHierarchyChanged]
 }
@@ -153,6 +175,51 @@ void InstrumentsListComponent::paintListBoxItem(int rowNumber, Graphics &g, int
 
     const auto placement = RectanglePlacement::yMid | RectanglePlacement::xLeft | RectanglePlacement::doNotResize;
     g.drawImageWithin(this->instrumentIcon, margin, 0, w, h, placement);
+
+    const auto load = instrument->getProcessorPlayer().getProcessingLoad();
+    String loadText = String(roundToInt(load.averageMicroseconds)) + " / " +
+        String(roundToInt(load.maxMicroseconds)) + " us, " + String(load.bufferPercent, 1) + "%";
+
+    // the events' timing of the current or the last playback
+    const auto timing = instrument->getProcessorPlayer().getSchedulingTelemetry().getSummary();
+    if (timing.numEvents > 0 || timing.numMissedEvents > 0)
+    {
+        loadText << ", " << String(timing.medianMs, 1) << " / " <<
+            String(timing.percentile99Ms, 1) << " ms late";
+
+        if (timing.numMissedEvents > 0)
+        {
+            loadText << ", " << String(timing.numMissedEvents) << " missed";
+        }
+    }
+
+    // the sandboxing cost is the round trip time minus the plugin's own time
+    for (int i = 0; i < instrument->getNumNodes(); ++i)
+    {
+        const auto node = instrument->getNode(i);
+        if (const auto *sandboxed = dynamic_cast<SandboxedPlugin *>(node->getProcessor()))
+        {
+            const auto sandbox = sandboxed->getSandboxLoad();
+            if (sandbox.hasCrashed)
+            {
+                loadText << ", " << sandboxed->getName() << " crashed";
+                continue;
+            }
+
+            const auto overhead = jmax(0.f,
+                sandbox.averageRoundTripMicroseconds - sandbox.averagePluginMicroseconds);
+            loadText << ", sandbox +" << String(roundToInt(overhead)) << " us";
+
+            if (sandbox.numDropouts > 0)
+            {
+                loadText << ", " << String(sandbox.numDropouts) << " late";
+            }
+        }
+    }
+
+    g.setFont(h * 0.25f);
+    g.setColour(findDefaultColour(ListBox::textColourId).withMultipliedAlpha(0.5f));
+    g.drawText(loadText, margin, margin, w - (margin * 4), h - (margin * 2), Justification::centredRight, false);
 }
 
 // Desktop:
@@ -225,6 +292,15 @@ String InstrumentsListComponent::getName() const
     return instrument->getName();
 }
 
+//===----------------------------------------------------------------------===//
+// Timer
+//===----------------------------------------------------------------------===//
+
+void InstrumentsListComponent::timerCallback()
+{
+    this->repaint();
+}
+
 //[/MiscUserCode]
 
 #if 0
@@ -232,7 +308,7 @@ String InstrumentsListComponent::getName() const
 BEGIN_JUCER_METADATA
 
 <JUCER_COMPONENT documentType="Component" className="InstrumentsListComponent"
-                 template="../../../Template" componentName="" parentClasses="public Component, public ListBoxModel, public HeadlineItemDataSource"
+                 template="../../../Template" componentName="" parentClasses="public Component, public ListBoxModel, public HeadlineItemDataSource, private Timer"
                  constructorParams="PluginScanner &amp;pluginScanner, OrchestraPitNode &amp;instrumentsRoot"
                  variableInitialisers="pluginScanner(pluginScanner),&#10;instrumentsRoot(instrumentsRoot)"
                  snapPixels="8" snapActive="1" snapShown="1" overlayOpacity="0.330"
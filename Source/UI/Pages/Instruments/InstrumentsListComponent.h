@@ -35,7 +35,8 @@ class OrchestraPitNode;
 
 class InstrumentsListComponent final : public Component,
                                        public ListBoxModel,
-                                       public HeadlineItemDataSource
+                                       public HeadlineItemDataSource,
+                                       private Timer
 {
 public:
 
@@ -66,6 +67,12 @@ public:
     String getName() const override;
     bool canBeSelectedAsMenuItem() const override;
 
+    //===------------------------------------------------------------------===//
+    // Timer
+    //===------------------------------------------------------------------===//
+
+    void timerCallback() override;
+
     //[/UserMethods]
 
     void paint (Graphics& g) override;
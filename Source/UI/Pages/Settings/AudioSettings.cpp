@@ -40,6 +40,15 @@ AudioSettings::AudioSettings(AudioCore &core)
     this->deviceComboPrimer.reset(new MobileComboBox::Primer());
     this->addAndMakeVisible(deviceComboPrimer.get());
 
+    this->threadsComboPrimer.reset(new MobileComboBox::Primer());
+    this->addAndMakeVisible(threadsComboPrimer.get());
+
+    this->latencyComboPrimer.reset(new MobileComboBox::Primer());
+    this->addAndMakeVisible(latencyComboPrimer.get());
+
+    this->bufferModeComboPrimer.reset(new MobileComboBox::Primer());
+    this->addAndMakeVisible(bufferModeComboPrimer.get());
+
     this->deviceTypeEditor.reset(new TextEditor(String()));
     this->addAndMakeVisible(deviceTypeEditor.get());
     deviceTypeEditor->setMultiLine (false);
@@ -80,28 +89,67 @@ AudioSettings::AudioSettings(AudioCore &core)
     bufferSizeEditor->setPopupMenuEnabled (false);
     bufferSizeEditor->setText (String());
 
+    this->threadsEditor.reset(new TextEditor(String()));
+    this->addAndMakeVisible(threadsEditor.get());
+    threadsEditor->setMultiLine (false);
+    threadsEditor->setReturnKeyStartsNewLine (false);
+    threadsEditor->setReadOnly (true);
+    threadsEditor->setScrollbarsShown (false);
+    threadsEditor->setCaretVisible (false);
+    threadsEditor->setPopupMenuEnabled (false);
+    threadsEditor->setText (String());
+
+    this->latencyEditor.reset(new TextEditor(String()));
+    this->addAndMakeVisible(latencyEditor.get());
+    latencyEditor->setMultiLine (false);
+    latencyEditor->setReturnKeyStartsNewLine (false);
+    latencyEditor->setReadOnly (true);
+    latencyEditor->setScrollbarsShown (false);
+    latencyEditor->setCaretVisible (false);
+    latencyEditor->setPopupMenuEnabled (false);
+    latencyEditor->setText (String());
+
+    this->bufferModeEditor.reset(new TextEditor(String()));
+    this->addAndMakeVisible(bufferModeEditor.get());
+    bufferModeEditor->setMultiLine (false);
+    bufferModeEditor->setReturnKeyStartsNewLine (false);
+    bufferModeEditor->setReadOnly (true);
+    bufferModeEditor->setScrollbarsShown (false);
+    bufferModeEditor->setCaretVisible (false);
+    bufferModeEditor->setPopupMenuEnabled (false);
+    bufferModeEditor->setText (String());
+
 
     //[UserPreSize]
     //[/UserPreSize]
 
-    this->setSize(550, 200);
+    this->setSize(550, 344);
 
     //[Constructor]
     this->deviceTypeEditor->setFont(18.f);
     this->deviceEditor->setFont(18.f);
     this->sampleRateEditor->setFont(18.f);
     this->bufferSizeEditor->setFont(18.f);
+    this->threadsEditor->setFont(18.f);
+    this->latencyEditor->setFont(18.f);
+    this->bufferModeEditor->setFont(18.f);
 
     this->deviceTypeEditor->setInterceptsMouseClicks(false, true);
     this->deviceEditor->setInterceptsMouseClicks(false, true);
     this->sampleRateEditor->setInterceptsMouseClicks(false, true);
     this->bufferSizeEditor->setInterceptsMouseClicks(false, true);
+    this->threadsEditor->setInterceptsMouseClicks(false, true);
+    this->latencyEditor->setInterceptsMouseClicks(false, true);
+    this->bufferModeEditor->setInterceptsMouseClicks(false, true);
 
     MenuPanel::Menu emptyMenu;
     this->deviceTypeComboPrimer->initWith(this->deviceTypeEditor.get(), emptyMenu);
     this->deviceComboPrimer->initWith(this->deviceEditor.get(), emptyMenu);
     this->sampleRateComboPrimer->initWith(this->sampleRateEditor.get(), emptyMenu);
     this->bufferSizeComboPrimer->initWith(this->bufferSizeEditor.get(), emptyMenu);
+    this->threadsComboPrimer->initWith(this->threadsEditor.get(), emptyMenu);
+    this->latencyComboPrimer->initWith(this->latencyEditor.get(), emptyMenu);
+    this->bufferModeComboPrimer->initWith(this->bufferModeEditor.get(), emptyMenu);
     //[/Constructor]
 }
 
@@ -114,10 +162,16 @@ AudioSettings::~AudioSettings()
     bufferSizeComboPrimer = nullptr;
     deviceTypeComboPrimer = nullptr;
     deviceComboPrimer = nullptr;
+    threadsComboPrimer = nullptr;
+    latencyComboPrimer = nullptr;
+    bufferModeComboPrimer = nullptr;
     deviceTypeEditor = nullptr;
     deviceEditor = nullptr;
     sampleRateEditor = nullptr;
     bufferSizeEditor = nullptr;
+    threadsEditor = nullptr;
+    latencyEditor = nullptr;
+    bufferModeEditor = nullptr;
 
     //[Destructor]
     //[/Destructor]
@@ -145,10 +199,16 @@ void AudioSettings::resized()
     bufferSizeComboPrimer->setBounds(4, 4, getWidth() - 8, getHeight() - 8);
     deviceTypeComboPrimer->setBounds(4, 4, getWidth() - 8, getHeight() - 8);
     deviceComboPrimer->setBounds(4, 4, getWidth() - 8, getHeight() - 8);
+    threadsComboPrimer->setBounds(4, 4, getWidth() - 8, getHeight() - 8);
+    latencyComboPrimer->setBounds(4, 4, getWidth() - 8, getHeight() - 8);
+    bufferModeComboPrimer->setBounds(4, 4, getWidth() - 8, getHeight() - 8);
     deviceTypeEditor->setBounds(16, 12, getWidth() - 32, 32);
     deviceEditor->setBounds(16, 60, getWidth() - 32, 32);
     sampleRateEditor->setBounds(16, 108, getWidth() - 32, 32);
     bufferSizeEditor->setBounds(16, 156, getWidth() - 32, 32);
+    threadsEditor->setBounds(16, 204, getWidth() - 32, 32);
+    latencyEditor->setBounds(16, 252, getWidth() - 32, 32);
+    bufferModeEditor->setBounds(16, 300, getWidth() - 32, 32);
     //[UserResized] Add your own custom resize handling here..
     //[/UserResized]
 }
@@ -164,6 +224,9 @@ void AudioSettings::visibilityChanged()
         this->syncDevicesList(deviceManager);
         this->syncSampleRatesList(deviceManager);
         this->syncBufferSizesList(deviceManager);
+        this->syncProcessingThreadsList();
+        this->syncLatencyCompensationList();
+        this->syncBufferSizeModesList();
     }
     //[/UserCode_visibilityChanged]
 }
@@ -171,6 +234,30 @@ void AudioSettings::visibilityChanged()
 void AudioSettings::handleCommandMessage (int commandId)
 {
     //[UserCode_handleCommandMessage] -- Add your code here...
+    const int numThreads = commandId - CommandIDs::SelectProcessingThreads;
+    if (numThreads >= 1 && numThreads <= SystemStats::getNumCpus())
+    {
+        this->audioCore.setNumProcessingThreads(numThreads);
+        this->syncProcessingThreadsList();
+        return;
+    }
+
+    const int latencyOption = commandId - CommandIDs::SelectLatencyCompensation;
+    if (latencyOption == 0 || latencyOption == 1)
+    {
+        this->audioCore.setLatencyAlignment(latencyOption == 1);
+        this->syncLatencyCompensationList();
+        return;
+    }
+
+    const int bufferSizeMode = commandId - CommandIDs::SelectBufferSizeMode;
+    if (bufferSizeMode >= 0 && bufferSizeMode <= 2)
+    {
+        this->audioCore.getBufferSizeAdvisor().setMode(BufferSizeAdvisor::Mode(bufferSizeMode));
+        this->syncBufferSizeModesList();
+        return;
+    }
+
     AudioDeviceManager &deviceManager = this->audioCore.getDevice();
     const OwnedArray<AudioIODeviceType> &deviceTypes = deviceManager.getAvailableDeviceTypes();
 
@@ -265,6 +352,7 @@ void AudioSettings::applyBufferSize(AudioDeviceManager &deviceManager, int buffe
 
     deviceSetup.bufferSize = bufferSize;
     deviceManager.setAudioDeviceSetup(deviceSetup, true);
+    this->audioCore.getBufferSizeAdvisor().setPreferredBufferSize(bufferSize);
     this->syncBufferSizesList(deviceManager);
 }
 
@@ -353,24 +441,95 @@ void AudioSettings::syncBufferSizesList(AudioDeviceManager &deviceManager)
     MenuPanel::Menu menu;
     const Array<int> bufferSizes(currentDevice->getAvailableBufferSizes());
     const int currentBufferSize = currentDevice->getCurrentBufferSizeSamples();
+    const int suggestedBufferSize = this->audioCore.getBufferSizeAdvisor().getSuggestedBufferSize();
 
     for (int i = 0; i < bufferSizes.size(); ++i)
     {
         const int &bufferSize = bufferSizes[i];
         const bool isSelected = bufferSize == currentBufferSize;
-        menu.add(MenuItem::item(isSelected ? Icons::apply : Icons::empty,
+        const bool isSuggested = bufferSize == suggestedBufferSize;
+        menu.add(MenuItem::item(isSelected ? Icons::apply : (isSuggested ? Icons::forward : Icons::empty),
             CommandIDs::SelectBufferSize + i, String(bufferSize)));
 
         if (isSelected)
         {
+            const String suggestion = (suggestedBufferSize > 0) ?
+                " (" + String(suggestedBufferSize) + " " + TRANS(I18n::Settings::audioBufferSizeSuggested) + ")" : "";
+
             this->bufferSizeEditor->setText(TRANS(I18n::Settings::audioBufferSize) +
-                ": " + String(bufferSize), dontSendNotification);
+                ": " + String(bufferSize) + suggestion, dontSendNotification);
         }
     }
 
     this->bufferSizeComboPrimer->updateMenu(menu);
 }
 
+void AudioSettings::syncProcessingThreadsList()
+{
+    MenuPanel::Menu menu;
+    const int currentNumThreads = this->audioCore.getNumProcessingThreads();
+
+    for (int numThreads = 1; numThreads <= SystemStats::getNumCpus(); ++numThreads)
+    {
+        const bool isSelected = numThreads == currentNumThreads;
+        menu.add(MenuItem::item(isSelected ? Icons::apply : Icons::empty,
+            CommandIDs::SelectProcessingThreads + numThreads, String(numThreads)));
+
+        if (isSelected)
+        {
+            this->threadsEditor->setText(TRANS(I18n::Settings::audioThreads) +
+                ": " + String(numThreads), dontSendNotification);
+        }
+    }
+
+    this->threadsComboPrimer->updateMenu(menu);
+}
+
+void AudioSettings::syncLatencyCompensationList()
+{
+    MenuPanel::Menu menu;
+    const bool isAligned = this->audioCore.isLatencyAligned();
+
+    menu.add(MenuItem::item(isAligned ? Icons::empty : Icons::apply,
+        CommandIDs::SelectLatencyCompensation, TRANS(I18n::Settings::audioLatencyPlayback)));
+
+    menu.add(MenuItem::item(isAligned ? Icons::apply : Icons::empty,
+        CommandIDs::SelectLatencyCompensation + 1, TRANS(I18n::Settings::audioLatencyAligned)));
+
+    this->latencyEditor->setText(TRANS(I18n::Settings::audioLatency) + ": " +
+        TRANS(isAligned ? I18n::Settings::audioLatencyAligned : I18n::Settings::audioLatencyPlayback),
+        dontSendNotification);
+
+    this->latencyComboPrimer->updateMenu(menu);
+}
+
+void AudioSettings::syncBufferSizeModesList()
+{
+    MenuPanel::Menu menu;
+    const auto currentMode = this->audioCore.getBufferSizeAdvisor().getMode();
+
+    const Identifier modeNames[] = {
+        I18n::Settings::audioBufferSizeFixed,
+        I18n::Settings::audioBufferSizeSuggest,
+        I18n::Settings::audioBufferSizeAutomatic
+    };
+
+    for (int i = 0; i < 3; ++i)
+    {
+        const bool isSelected = int(currentMode) == i;
+        menu.add(MenuItem::item(isSelected ? Icons::apply : Icons::empty,
+            CommandIDs::SelectBufferSizeMode + i, TRANS(modeNames[i])));
+
+        if (isSelected)
+        {
+            this->bufferModeEditor->setText(TRANS(I18n::Settings::audioBufferSizeAdaptive) +
+                ": " + TRANS(modeNames[i]), dontSendNotification);
+        }
+    }
+
+    this->bufferModeComboPrimer->updateMenu(menu);
+}
+
 //[/MiscUserCode]
 
 #if 0
@@ -381,7 +540,7 @@ BEGIN_JUCER_METADATA
                  componentName="" parentClasses="public Component" constructorParams="AudioCore &amp;core"
                  variableInitialisers="audioCore(core)" snapPixels="8" snapActive="1"
                  snapShown="1" overlayOpacity="0.330" fixedSize="1" initialWidth="550"
-                 initialHeight="200">
+                 initialHeight="344">
   <METHODS>
     <METHOD name="visibilityChanged()"/>
     <METHOD name="handleCommandMessage (int commandId)"/>
@@ -399,6 +558,15 @@ BEGIN_JUCER_METADATA
   <GENERICCOMPONENT name="" id="1b5648cb76a38566" memberName="deviceComboPrimer"
                     virtualName="" explicitFocusOrder="0" pos="4 4 8M 8M" class="MobileComboBox::Primer"
                     params=""/>
+  <GENERICCOMPONENT name="" id="6d4f8a2b1c93e705" memberName="threadsComboPrimer"
+                    virtualName="" explicitFocusOrder="0" pos="4 4 8M 8M" class="MobileComboBox::Primer"
+                    params=""/>
+  <GENERICCOMPONENT name="" id="93c0e5d7a4b18f26" memberName="latencyComboPrimer"
+                    virtualName="" explicitFocusOrder="0" pos="4 4 8M 8M" class="MobileComboBox::Primer"
+                    params=""/>
+  <GENERICCOMPONENT name="" id="0c7b2e9f4d6a1385" memberName="bufferModeComboPrimer"
+                    virtualName="" explicitFocusOrder="0" pos="4 4 8M 8M" class="MobileComboBox::Primer"
+                    params=""/>
   <TEXTEDITOR name="" id="4fd07309a20b15b6" memberName="deviceTypeEditor" virtualName=""
               explicitFocusOrder="0" pos="16 12 32M 32" initialText="" multiline="0"
               retKeyStartsLine="0" readonly="1" scrollbars="0" caret="0" popupmenu="0"/>
@@ -411,6 +579,15 @@ BEGIN_JUCER_METADATA
   <TEXTEDITOR name="" id="42608864c0766e06" memberName="bufferSizeEditor" virtualName=""
               explicitFocusOrder="0" pos="16 156 32M 32" initialText="" multiline="0"
               retKeyStartsLine="0" readonly="1" scrollbars="0" caret="0" popupmenu="0"/>
+  <TEXTEDITOR name="" id="b2e97c1d05a4f318" memberName="threadsEditor" virtualName=""
+              explicitFocusOrder="0" pos="16 204 32M 32" initialText="" multiline="0"
+              retKeyStartsLine="0" readonly="1" scrollbars="0" caret="0" popupmenu="0"/>
+  <TEXTEDITOR name="" id="5e1a7c2f90d84b63" memberName="latencyEditor" virtualName=""
+              explicitFocusOrder="0" pos="16 252 32M 32" initialText="" multiline="0"
+              retKeyStartsLine="0" readonly="1" scrollbars="0" caret="0" popupmenu="0"/>
+  <TEXTEDITOR name="" id="a48d1f63e07b29c5" memberName="bufferModeEditor" virtualName=""
+              explicitFocusOrder="0" pos="16 300 32M 32" initialText="" multiline="0"
+              retKeyStartsLine="0" readonly="1" scrollbars="0" caret="0" popupmenu="0"/>
 </JUCER_COMPONENT>
 
 END_JUCER_METADATA
@@ -51,6 +51,9 @@ private:
     void syncDevicesList(AudioDeviceManager &deviceManager);
     void syncSampleRatesList(AudioDeviceManager &deviceManager);
     void syncBufferSizesList(AudioDeviceManager &deviceManager);
+    void syncProcessingThreadsList();
+    void syncLatencyCompensationList();
+    void syncBufferSizeModesList();
 
     AudioCore &audioCore;
     //[/UserVariables]
@@ -59,10 +62,16 @@ private:
     UniquePointer<MobileComboBox::Primer> bufferSizeComboPrimer;
     UniquePointer<MobileComboBox::Primer> deviceTypeComboPrimer;
     UniquePointer<MobileComboBox::Primer> deviceComboPrimer;
+    UniquePointer<MobileComboBox::Primer> threadsComboPrimer;
+    UniquePointer<MobileComboBox::Primer> latencyComboPrimer;
+    UniquePointer<MobileComboBox::Primer> bufferModeComboPrimer;
     UniquePointer<TextEditor> deviceTypeEditor;
     UniquePointer<TextEditor> deviceEditor;
     UniquePointer<TextEditor> sampleRateEditor;
     UniquePointer<TextEditor> bufferSizeEditor;
+    UniquePointer<TextEditor> threadsEditor;
+    UniquePointer<TextEditor> latencyEditor;
+    UniquePointer<TextEditor> bufferModeEditor;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AudioSettings)
 };
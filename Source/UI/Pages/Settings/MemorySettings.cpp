@@ -0,0 +1,231 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+//[Headers]
+#include "Common.h"
+//[/Headers]
+
+#include "MemorySettings.h"
+
+//[MiscUserDefs]
+#include "MemoryBudget.h"
+#include "SerializationKeys.h"
+#include "Config.h"
+
+static const int memoryBudgetsMb[] = { 64, 128, 256, 512, 1024, 2048 };
+//[/MiscUserDefs]
+
+MemorySettings::MemorySettings()
+{
+    this->budgetComboPrimer.reset(new MobileComboBox::Primer());
+    this->addAndMakeVisible(budgetComboPrimer.get());
+
+    this->budgetEditor.reset(new TextEditor(String()));
+    this->addAndMakeVisible(budgetEditor.get());
+    budgetEditor->setMultiLine (false);
+    budgetEditor->setReturnKeyStartsNewLine (false);
+    budgetEditor->setReadOnly (true);
+    budgetEditor->setScrollbarsShown (false);
+    budgetEditor->setCaretVisible (false);
+    budgetEditor->setPopupMenuEnabled (false);
+    budgetEditor->setText (String());
+
+    this->usageLabel.reset(new Label(String(),
+                                      String()));
+    this->addAndMakeVisible(usageLabel.get());
+    this->usageLabel->setFont(Font (16.00f, Font::plain));
+    usageLabel->setJustificationType(Justification::topLeft);
+    usageLabel->setEditable(false, false, false);
+
+
+    //[UserPreSize]
+    //[/UserPreSize]
+
+    this->setSize(550, 320);
+
+    //[Constructor]
+    this->budgetEditor->setFont(18.f);
+    this->budgetEditor->setInterceptsMouseClicks(false, true);
+    this->usageLabel->setInterceptsMouseClicks(false, false);
+
+    MenuPanel::Menu emptyMenu;
+    this->budgetComboPrimer->initWith(this->budgetEditor.get(), emptyMenu);
+    //[/Constructor]
+}
+
+MemorySettings::~MemorySettings()
+{
+    //[Destructor_pre]
+    this->stopTimer();
+    //[/Destructor_pre]
+
+    budgetComboPrimer = nullptr;
+    budgetEditor = nullptr;
+    usageLabel = nullptr;
+
+    //[Destructor]
+    //[/Destructor]
+}
+
+void MemorySettings::paint (Graphics& g)
+{
+    //[UserPrePaint] Add your own custom painting code here..
+#if 0
+    //[/UserPrePaint]
+
+    g.fillAll (Colours::black);
+
+    //[UserPaint] Add your own custom painting code here..
+#endif
+    //[/UserPaint]
+}
+
+void MemorySettings::resized()
+{
+    //[UserPreResize] Add your own custom resize code here..
+    //[/UserPreResize]
+
+    budgetComboPrimer->setBounds(4, 4, getWidth() - 8, getHeight() - 8);
+    budgetEditor->setBounds(16, 12, getWidth() - 32, 32);
+    usageLabel->setBounds(16, 56, getWidth() - 32, getHeight() - 68);
+    //[UserResized] Add your own custom resize handling here..
+    //[/UserResized]
+}
+
+void MemorySettings::visibilityChanged()
+{
+    //[UserCode_visibilityChanged] -- Add your code here...
+    if (this->isVisible())
+    {
+        this->syncBudgetsList();
+        this->syncUsage();
+        this->startTimer(1000);
+    }
+    else
+    {
+        this->stopTimer();
+    }
+    //[/UserCode_visibilityChanged]
+}
+
+void MemorySettings::handleCommandMessage (int commandId)
+{
+    //[UserCode_handleCommandMessage] -- Add your code here...
+    const int budgetIndex = commandId - CommandIDs::SelectMemoryBudget;
+    if (budgetIndex >= 0 && budgetIndex < numElementsInArray(memoryBudgetsMb))
+    {
+        const int64 budget = int64(memoryBudgetsMb[budgetIndex]) * 1024 * 1024;
+        App::Memory().setBudget(budget);
+        App::Config().setProperty(Serialization::Config::memoryBudget, String(budget));
+        this->syncBudgetsList();
+        this->syncUsage();
+    }
+    //[/UserCode_handleCommandMessage]
+}
+
+
+//[MiscUserCode]
+
+void MemorySettings::timerCallback()
+{
+    this->syncUsage();
+}
+
+void MemorySettings::syncBudgetsList()
+{
+    MenuPanel::Menu menu;
+    const auto currentBudget = App::Memory().getBudget();
+
+    for (int i = 0; i < numElementsInArray(memoryBudgetsMb); ++i)
+    {
+        const int64 budget = int64(memoryBudgetsMb[i]) * 1024 * 1024;
+        const bool isSelected = budget == currentBudget;
+        const auto budgetText = File::descriptionOfSizeInBytes(budget);
+        menu.add(MenuItem::item(isSelected ? Icons::apply : Icons::empty,
+            CommandIDs::SelectMemoryBudget + i, budgetText));
+
+        if (isSelected)
+        {
+            this->budgetEditor->setText(TRANS(I18n::Settings::memoryBudget) +
+                ": " + budgetText, dontSendNotification);
+        }
+    }
+
+    this->budgetComboPrimer->updateMenu(menu);
+}
+
+void MemorySettings::syncUsage()
+{
+    StringArray lines;
+    const auto &budget = App::Memory();
+
+    for (const auto &usage : budget.getUsage())
+    {
+        lines.add(usage.name + ": " + File::descriptionOfSizeInBytes(usage.numBytes) +
+            " (" + String(usage.numEntries) + " entries, " + String(usage.numEvictions) + " evicted)");
+    }
+
+    lines.sort(true);
+    lines.add(File::descriptionOfSizeInBytes(budget.getTotalCost()) +
+        " / " + File::descriptionOfSizeInBytes(budget.getBudget()));
+
+    // the things which are never evicted, only estimated
+    StringArray accountLines;
+    for (const auto &usage : budget.getAccountsUsage())
+    {
+        accountLines.add(usage.name + ": ~" + File::descriptionOfSizeInBytes(usage.numBytes) +
+            " (" + String(usage.numItems) + " items)");
+    }
+
+    accountLines.sort(true);
+    lines.add({});
+    lines.addArray(accountLines);
+
+    this->usageLabel->setText(lines.joinIntoString("\n"), dontSendNotification);
+}
+
+//[/MiscUserCode]
+
+#if 0
+/*
+BEGIN_JUCER_METADATA
+
+<JUCER_COMPONENT documentType="Component" className="MemorySettings" template="../../../Template"
+                 componentName="" parentClasses="public Component, private Timer"
+                 constructorParams="" variableInitialisers="" snapPixels="8" snapActive="1"
+                 snapShown="1" overlayOpacity="0.330" fixedSize="1" initialWidth="550"
+                 initialHeight="320">
+  <METHODS>
+    <METHOD name="visibilityChanged()"/>
+    <METHOD name="handleCommandMessage (int commandId)"/>
+  </METHODS>
+  <BACKGROUND backgroundColour="ff000000"/>
+  <GENERICCOMPONENT name="" id="3c8e1f20a7d94b56" memberName="budgetComboPrimer"
+                    virtualName="" explicitFocusOrder="0" pos="4 4 8M 8M" class="MobileComboBox::Primer"
+                    params=""/>
+  <TEXTEDITOR name="" id="9a41d7e3c05b2f68" memberName="budgetEditor" virtualName=""
+              explicitFocusOrder="0" pos="16 12 32M 32" initialText="" multiline="0"
+              retKeyStartsLine="0" readonly="1" scrollbars="0" caret="0" popupmenu="0"/>
+  <LABEL name="" id="e5b20c9f7a13d846" memberName="usageLabel" virtualName=""
+         explicitFocusOrder="0" pos="16 56 32M 68M" labelText="" editableSingleClick="0"
+         editableDoubleClick="0" focusDiscardsChanges="0" fontname="Default font"
+         fontsize="16.0" kerning="0.0" bold="0" italic="0" justification="9"/>
+</JUCER_COMPONENT>
+
+END_JUCER_METADATA
+*/
+#endif
@@ -28,21 +28,11 @@
 #include "ColourIDs.h"
 //[/MiscUserDefs]
 
-RevisionComponent::RevisionComponent(VersionControl &owner, const VCS::Revision::Ptr revision, VCS::Revision::SyncState viewState, bool isHead)
+RevisionComponent::RevisionComponent(VersionControl &owner)
     : vcs(owner),
-      revision(revision),
       isSelected(false),
-      isHeadRevision(isHead),
-      viewState(viewState),
-      x(0.f),
-      y(0.f),
-      mod(0.f),
-      shift(0.f),
-      change(0.f),
-      number(0),
-      parent(nullptr),
-      wired(nullptr),
-      leftmostSibling(nullptr)
+      isHeadRevision(false),
+      viewState(VCS::Revision::NoSync)
 {
     this->revisionDescription.reset(new Label(String(),
                                                String()));
@@ -70,29 +60,10 @@ RevisionComponent::RevisionComponent(VersionControl &owner, const VCS::Revision:
 
 
     //[UserPreSize]
-    const auto &message = this->revision->getMessage();
-    const auto timestamp = this->revision->getTimeStamp();
-
-    this->revisionDescription->setText(message, dontSendNotification);
-    this->revisionDate->setText(App::getHumanReadableDate(Time(timestamp)), dontSendNotification);
-
     this->setInterceptsMouseClicks(true, false);
     this->setMouseClickGrabsKeyboardFocus(false);
     this->revisionDate->setInterceptsMouseClicks(false, false);
     this->revisionDescription->setInterceptsMouseClicks(false, false);
-
-    switch (this->viewState)
-    {
-    case VCS::Revision::NoSync:
-        this->remoteIndicatorImage->setAlpha(0.15f);
-        break;
-    case VCS::Revision::ShallowCopy:
-        this->localIndicatorImage->setAlpha(0.15f);
-        break;
-    case VCS::Revision::FullSync:
-    default:
-        break;
-    }
     //[/UserPreSize]
 
     this->setSize(150, 50);
@@ -172,51 +143,47 @@ void RevisionComponent::mouseDown (const MouseEvent& e)
 
 //[MiscUserCode]
 
-void RevisionComponent::setSelected(bool selected)
+void RevisionComponent::setRevision(const VCS::Revision::Ptr revision,
+    VCS::Revision::SyncState viewState, bool isHead)
 {
-    this->isSelected = selected;
-    this->repaint();
-}
+    this->revision = revision;
+    this->viewState = viewState;
+    this->isHeadRevision = isHead;
 
-RevisionComponent *RevisionComponent::getLeftmostSibling() const
-{
-    if (!this->leftmostSibling && this->parent)
-    {
-        if (this != this->parent->children.getFirst())
-        {
-            this->leftmostSibling = this->parent->children.getFirst();
-        }
-    }
+    const auto &message = this->revision->getMessage();
+    const auto timestamp = this->revision->getTimeStamp();
 
-    return this->leftmostSibling;
-}
+    this->revisionDescription->setText(message, dontSendNotification);
+    this->revisionDate->setText(App::getHumanReadableDate(Time(timestamp)), dontSendNotification);
 
-RevisionComponent *RevisionComponent::getLeftBrother() const
-{
-    RevisionComponent *n = nullptr;
+    this->remoteIndicatorImage->setAlpha(1.f);
+    this->localIndicatorImage->setAlpha(1.f);
 
-    if (this->parent)
+    switch (this->viewState)
     {
-        for (auto i : this->parent->children)
-        {
-            if (i == this) { return n; }
-            n = i;
-        }
+    case VCS::Revision::NoSync:
+        this->remoteIndicatorImage->setAlpha(0.15f);
+        break;
+    case VCS::Revision::ShallowCopy:
+        this->localIndicatorImage->setAlpha(0.15f);
+        break;
+    case VCS::Revision::FullSync:
+    default:
+        break;
     }
 
-    return n;
+    this->repaint();
 }
 
-RevisionComponent *RevisionComponent::right() const
+VCS::Revision::Ptr RevisionComponent::getRevision() const noexcept
 {
-    if (this->children.size() > 0) { return this->children.getLast(); }
-    return this->wired;
+    return this->revision;
 }
 
-RevisionComponent *RevisionComponent::left() const
+void RevisionComponent::setSelected(bool selected)
 {
-    if (this->children.size() > 0) { return this->children.getFirst(); }
-    return this->wired;
+    this->isSelected = selected;
+    this->repaint();
 }
 
 //[/MiscUserCode]
@@ -226,8 +193,8 @@ RevisionComponent *RevisionComponent::left() const
 BEGIN_JUCER_METADATA
 
 <JUCER_COMPONENT documentType="Component" className="RevisionComponent" template="../../../Template"
-                 componentName="" parentClasses="public Component" constructorParams="VersionControl &amp;owner, const VCS::Revision::Ptr revision, VCS::Revision::SyncState viewState, bool isHead"
-                 variableInitialisers="vcs(owner)&#10;revision(revision),&#10;isSelected(false),&#10;isHeadRevision(isHead),&#10;viewState(viewState),&#10;x(0.f),&#10;y(0.f),&#10;mod(0.f),&#10;shift(0.f),&#10;change(0.f),&#10;number(0),&#10;parent(nullptr),&#10;wired(nullptr),&#10;leftmostSibling(nullptr)"
+                 componentName="" parentClasses="public Component" constructorParams="VersionControl &amp;owner"
+                 variableInitialisers="vcs(owner),&#10;isSelected(false),&#10;isHeadRevision(false),&#10;viewState(VCS::Revision::NoSync)"
                  snapPixels="8" snapActive="1" snapShown="1" overlayOpacity="0.330"
                  fixedSize="1" initialWidth="150" initialHeight="50">
   <METHODS>
@@ -30,36 +30,17 @@ class RevisionComponent final : public Component
 {
 public:
 
-    RevisionComponent(VersionControl &owner, const VCS::Revision::Ptr revision, VCS::Revision::SyncState viewState, bool isHead);
+    explicit RevisionComponent(VersionControl &owner);
     ~RevisionComponent();
 
     //[UserMethods]
 
-    // Helpers for tree traverse:
+    // The revision tree re-uses the components while scrolling,
+    // so the revision is set after the component is created:
+    void setRevision(const VCS::Revision::Ptr revision,
+        VCS::Revision::SyncState viewState, bool isHead);
 
-    float x;
-    float y;
-    float mod;
-    float shift;
-    float change;
-    int number;
-
-    const VCS::Revision::Ptr revision;
-
-    RevisionComponent *parent;
-    RevisionComponent *ancestor;
-    RevisionComponent *wired;
-
-    Array<RevisionComponent *> children;
-
-    RevisionComponent *getLeftmostSibling() const;
-    RevisionComponent *getLeftBrother() const;
-    RevisionComponent *right() const;
-    RevisionComponent *left() const;
-
-    mutable RevisionComponent *leftmostSibling;
-
-    // View details
+    VCS::Revision::Ptr getRevision() const noexcept;
 
     void setSelected(bool selected);
 
@@ -77,6 +58,8 @@ private:
 
     VersionControl &vcs;
 
+    VCS::Revision::Ptr revision;
+
     bool isSelected;
     bool isHeadRevision;
     VCS::Revision::SyncState viewState;
@@ -162,11 +162,28 @@ void RevisionItemComponent::updateItemInfo(VCS::RevisionItem::Ptr revisionItemIn
     int rowNumber, bool isLastRow, bool isSelectable)
 {
     this->row = rowNumber;
-    this->revisionItem = revisionItemInfo;
     this->setEnabled(isSelectable);
-
     this->separator->setVisible(! isLastRow);
 
+    // the list refreshes its visible rows on every scroll step,
+    // and the texts only need to be rebuilt when the item changes
+    if (this->revisionItem != revisionItemInfo)
+    {
+        this->revisionItem = revisionItemInfo;
+        this->updateItemTexts();
+    }
+
+    if (!this->selectionAnimator.isAnimating())
+    {
+        this->selectionComponent->setVisible(this->isSelected());
+        this->selectionComponent->setAlpha(this->isSelected() ? 1.f : 0.f);
+    }
+
+    this->resized();
+}
+
+void RevisionItemComponent::updateItemTexts()
+{
     const auto itemType = this->revisionItem->getType();
     const String itemTypeStr = this->revisionItem->getTypeAsString();
     const String itemDescription = TRANS(this->revisionItem->getVCSName());
@@ -198,14 +215,6 @@ void RevisionItemComponent::updateItemInfo(VCS::RevisionItem::Ptr revisionItemIn
     }
 
     this->deltasLabel->setText(itemDeltas, dontSendNotification);
-
-    if (!this->selectionAnimator.isAnimating())
-    {
-        this->selectionComponent->setVisible(this->isSelected());
-        this->selectionComponent->setAlpha(this->isSelected() ? 1.f : 0.f);
-    }
-
-    this->resized();
 }
 
 void RevisionItemComponent::select() const
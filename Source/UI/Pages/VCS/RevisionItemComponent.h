@@ -57,6 +57,7 @@ private:
 
     void invertSelection() const;
     bool isSelected() const;
+    void updateItemTexts();
 
     ListBox &list;
     int row;
@@ -18,12 +18,15 @@
 #include "Common.h"
 #include "RevisionTreeComponent.h"
 #include "CommandIDs.h"
+#include "ColourIDs.h"
 #include "VersionControl.h"
 #include "HistoryComponent.h"
 #include "RevisionComponent.h"
-#include "RevisionConnectorComponent.h"
 #include "RevisionTooltipComponent.h"
 
+#define REVISION_WIDTH 150
+#define REVISION_HEIGHT 50
+#define REVISION_SPACING 10
 #define CONNECTOR_HEIGHT 20
 
 RevisionTreeComponent::RevisionTreeComponent(VersionControl &owner) :
@@ -33,8 +36,8 @@ RevisionTreeComponent::RevisionTreeComponent(VersionControl &owner) :
     this->setInterceptsMouseClicks(false, true);
     this->setSize(1, 1);
 
-    RevisionComponent *root = this->initComponents(1, this->vcs.getRoot(), nullptr);
-    RevisionComponent *dt = this->firstWalk(root);
+    Node *root = this->initNodes(1, this->vcs.getRoot(), nullptr);
+    Node *dt = this->firstWalk(root);
     
     float min = -1;
     min = this->secondWalk(dt, min);
@@ -46,19 +49,14 @@ RevisionTreeComponent::RevisionTreeComponent(VersionControl &owner) :
 
 RevisionTreeComponent::~RevisionTreeComponent()
 {
-    this->deleteAllChildren();
+    this->detachFromViewport();
 }
 
 void RevisionTreeComponent::deselectAll(bool sendNotification)
 {
-    for (int i = 0; i < this->getNumChildComponents(); ++i)
+    for (auto *revisionComponent : this->revisionComponents)
     {
-        Component *child = this->getChildComponent(i);
-
-        if (RevisionComponent *revChild = dynamic_cast<RevisionComponent *>(child))
-        {
-            revChild->setSelected(false);
-        }
+        revisionComponent->setSelected(false);
     }
 
     this->selectedRevision = nullptr;
@@ -73,7 +71,7 @@ void RevisionTreeComponent::deselectAll(bool sendNotification)
 void RevisionTreeComponent::selectComponent(RevisionComponent *revComponent, bool deselectOthers, bool sendNotification)
 {
     // If already selected, deselect (may remove that later):
-    if (this->selectedRevision == revComponent->revision)
+    if (this->selectedRevision == revComponent->getRevision())
     {
         this->deselectAll(true);
         return;
@@ -85,7 +83,7 @@ void RevisionTreeComponent::selectComponent(RevisionComponent *revComponent, boo
     }
 
     revComponent->setSelected(true);
-    this->selectedRevision = revComponent->revision;
+    this->selectedRevision = revComponent->getRevision();
 
     auto *editor = this->findParentEditor();
     if (editor != nullptr && sendNotification)
@@ -94,15 +92,6 @@ void RevisionTreeComponent::selectComponent(RevisionComponent *revComponent, boo
     }
 }
 
-void RevisionTreeComponent::handleCommandMessage(int commandId)
-{
-    if (commandId == CommandIDs::StartDragViewport ||
-        commandId == CommandIDs::EndDragViewport)
-    {
-        this->deselectAll(true);
-    }
-}
-
 //void RevisionTreeComponent::showTooltipFor(RevisionComponent *revComponent, Point<int> clickPoint, const ValueTree revision)
 //{
 //    if (Component *editor = this->findParentEditor())
@@ -120,35 +109,212 @@ VCS::Revision::Ptr RevisionTreeComponent::getSelectedRevision() const noexcept
     return this->selectedRevision;
 }
 
+//===----------------------------------------------------------------------===//
+// Component
+//===----------------------------------------------------------------------===//
+
+void RevisionTreeComponent::paint(Graphics &g)
+{
+    const auto clip = g.getClipBounds();
+    g.setColour(findDefaultColour(ColourIDs::VersionControl::connector));
+
+    for (const auto *w : this->nodes)
+    {
+        if (const auto *v = w->parent)
+        {
+            // the connector goes from the parent's top to the child's bottom
+            const auto connectorBounds = Rectangle<int>::leftTopRightBottom(
+                jmin(v->bounds.getCentreX(), w->bounds.getCentreX()) - 4, w->bounds.getBottom() - 4,
+                jmax(v->bounds.getCentreX(), w->bounds.getCentreX()) + 4, v->bounds.getY() + 4);
+
+            if (connectorBounds.intersects(clip))
+            {
+                g.fillPath(this->getConnectorPath(v, w));
+            }
+        }
+    }
+}
+
+void RevisionTreeComponent::parentHierarchyChanged()
+{
+    auto *newViewport = this->findParentComponentOfClass<Viewport>();
+    auto *newViewedComponent = (newViewport != nullptr) ? newViewport->getViewedComponent() : nullptr;
+
+    if (newViewport != this->viewport.getComponent() ||
+        newViewedComponent != this->viewedComponent.getComponent())
+    {
+        this->detachFromViewport();
+
+        this->viewport = newViewport;
+        this->viewedComponent = newViewedComponent;
+
+        if (this->viewport != nullptr)
+        {
+            this->viewport->addComponentListener(this);
+        }
+
+        if (this->viewedComponent != nullptr)
+        {
+            this->viewedComponent->addComponentListener(this);
+        }
+    }
+
+    // wait until the tree gets into the viewport,
+    // otherwise all the components would be created at once
+    if (this->viewport != nullptr)
+    {
+        this->updateVisibleComponents();
+    }
+}
+
+void RevisionTreeComponent::handleCommandMessage(int commandId)
+{
+    if (commandId == CommandIDs::StartDragViewport ||
+        commandId == CommandIDs::EndDragViewport)
+    {
+        this->deselectAll(true);
+    }
+}
 
 //===----------------------------------------------------------------------===//
-// Buchheim tree layout functions
+// ComponentListener
+//===----------------------------------------------------------------------===//
+
+void RevisionTreeComponent::componentMovedOrResized(Component &component,
+    bool wasMoved, bool wasResized)
+{
+    // the viewed component is moved when scrolling, the viewport is resized
+    this->updateVisibleComponents();
+}
+
+void RevisionTreeComponent::componentBeingDeleted(Component &component)
+{
+    component.removeComponentListener(this);
+}
+
+void RevisionTreeComponent::detachFromViewport()
+{
+    if (this->viewport != nullptr)
+    {
+        this->viewport->removeComponentListener(this);
+    }
+
+    if (this->viewedComponent != nullptr)
+    {
+        this->viewedComponent->removeComponentListener(this);
+    }
+
+    this->viewport = nullptr;
+    this->viewedComponent = nullptr;
+}
+
+//===----------------------------------------------------------------------===//
+// Virtualization
 //===----------------------------------------------------------------------===//
 
-RevisionComponent *RevisionTreeComponent::initComponents(int depth,
-    const VCS::Revision::Ptr revision, RevisionComponent *parentRevisionComponent)
+Rectangle<int> RevisionTreeComponent::getVisibleBounds() const
 {
-    const auto state = this->vcs.getRevisionSyncState(revision);
-    const bool isHead = (this->vcs.getHead().getHeadingRevision() == revision);
+    if (this->viewport == nullptr)
+    {
+        return this->getLocalBounds();
+    }
 
-    auto *revisionComponent = new RevisionComponent(this->vcs, revision, state, isHead);
-    revisionComponent->parent = parentRevisionComponent;
-    revisionComponent->y = float(depth);
-    revisionComponent->number = depth;
-    revisionComponent->ancestor = revisionComponent;
+    // also keep a margin of one revision around,
+    // so that the scrolling doesn't show the empty spots
+    return this->getLocalArea(this->viewport, this->viewport->getLocalBounds())
+        .expanded(REVISION_WIDTH, REVISION_HEIGHT)
+        .getIntersection(this->getLocalBounds());
+}
 
-    this->addAndMakeVisible(revisionComponent);
+void RevisionTreeComponent::updateVisibleComponents()
+{
+    const auto visibleBounds = this->getVisibleBounds();
+
+    // first release the components scrolled out of sight,
+    // so that they can be re-used for the newly visible nodes
+    for (auto *node : this->nodes)
+    {
+        if (node->component != nullptr && !node->bounds.intersects(visibleBounds))
+        {
+            node->component->setVisible(false);
+            this->spareComponents.add(node->component);
+            node->component = nullptr;
+        }
+    }
+
+    for (auto *node : this->nodes)
+    {
+        if (node->component == nullptr && node->bounds.intersects(visibleBounds))
+        {
+            auto *revisionComponent = this->spareComponents.removeAndReturn(this->spareComponents.size() - 1);
+            if (revisionComponent == nullptr)
+            {
+                revisionComponent = this->revisionComponents.add(new RevisionComponent(this->vcs));
+                this->addChildComponent(revisionComponent);
+            }
+
+            revisionComponent->setRevision(node->revision, node->syncState, node->isHead);
+            revisionComponent->setSelected(node->revision == this->selectedRevision);
+            revisionComponent->setBounds(node->bounds);
+            revisionComponent->setVisible(true);
+            node->component = revisionComponent;
+        }
+    }
+}
+
+Path RevisionTreeComponent::getConnectorPath(const Node *v, const Node *w) const
+{
+    const float x1 = float(v->bounds.getCentreX());
+    const float y1 = float(v->bounds.getY());
+    const float x2 = float(w->bounds.getCentreX());
+    const float y2 = float(w->bounds.getBottom());
+
+    const float dy = (y2 - y1);
+    const float dx = (x2 - x1);
+
+    const float curvinessX = (1.f - (fabs(dx) / float(this->getWidth()))) * 1.5f;
+    const float curvinessY = (fabs(dy) / float(this->getHeight())) * 1.5f;
+    const float curviness = (curvinessX + curvinessY) / 2.f;
+
+    Path linePath;
+    linePath.startNewSubPath(x1, y1);
+    linePath.cubicTo(x1, y1 + dy * (curviness),
+        x2, y1 + dy * (1.f - curviness),
+        x2, y2);
+
+    PathStrokeType stroke(1.0f, PathStrokeType::beveled, PathStrokeType::butt);
+    stroke.createStrokedPath(linePath, linePath);
+
+    linePath.setUsingNonZeroWinding(false);
+    return linePath;
+}
+
+//===----------------------------------------------------------------------===//
+// Buchheim tree layout functions
+//===----------------------------------------------------------------------===//
+
+RevisionTreeComponent::Node *RevisionTreeComponent::initNodes(int depth,
+    const VCS::Revision::Ptr revision, Node *parentNode)
+{
+    auto *node = this->nodes.add(new Node());
+    node->revision = revision;
+    node->syncState = this->vcs.getRevisionSyncState(revision);
+    node->isHead = (this->vcs.getHead().getHeadingRevision() == revision);
+    node->parent = parentNode;
+    node->y = float(depth);
+    node->number = depth;
+    node->ancestor = node;
 
     for (const auto childRevision : revision->getChildren())
     {
-        auto *childComponent = this->initComponents(depth + 1, childRevision, revisionComponent);
-        revisionComponent->children.add(childComponent);
+        auto *childNode = this->initNodes(depth + 1, childRevision, node);
+        node->children.add(childNode);
     }
 
-    return revisionComponent;
+    return node;
 }
 
-RevisionComponent *RevisionTreeComponent::firstWalk(RevisionComponent *v, float distance)
+RevisionTreeComponent::Node *RevisionTreeComponent::firstWalk(Node *v, float distance)
 {
     if (v->children.size() == 0)
     {
@@ -163,11 +329,11 @@ RevisionComponent *RevisionTreeComponent::firstWalk(RevisionComponent *v, float
     }
     else
     {
-        RevisionComponent *default_ancestor = v->children[0];
+        Node *default_ancestor = v->children[0];
 
         for (int i = 0; i < v->children.size(); ++i)
         {
-            RevisionComponent *child = v->children[i];
+            Node *child = v->children[i];
             firstWalk(child);
             default_ancestor = apportion(child, default_ancestor, distance);
         }
@@ -176,7 +342,7 @@ RevisionComponent *RevisionTreeComponent::firstWalk(RevisionComponent *v, float
 
         float midpoint = (v->children.getFirst()->x + v->children.getLast()->x) / 2.f;
 
-        RevisionComponent *w = v->getLeftBrother();
+        Node *w = v->getLeftBrother();
 
         if (w)
         {
@@ -192,19 +358,19 @@ RevisionComponent *RevisionTreeComponent::firstWalk(RevisionComponent *v, float
     return v;
 }
 
-RevisionComponent *RevisionTreeComponent::apportion(RevisionComponent *v, RevisionComponent *default_ancestor, float distance)
+RevisionTreeComponent::Node *RevisionTreeComponent::apportion(Node *v, Node *default_ancestor, float distance)
 {
-    RevisionComponent *w = v->getLeftBrother();
+    Node *w = v->getLeftBrother();
 
     if (w != nullptr)
     {
         //in buchheim notation:
         //i == inner; o == outer; r == right; l == left;
-        RevisionComponent *vir = v;
-        RevisionComponent *vor = v;
-        RevisionComponent *vil = w;
+        Node *vir = v;
+        Node *vor = v;
+        Node *vil = w;
 
-        RevisionComponent *vol = v->getLeftmostSibling();
+        Node *vol = v->getLeftmostSibling();
 
         float sir = v->mod;
         float sor = v->mod;
@@ -224,7 +390,7 @@ RevisionComponent *RevisionTreeComponent::apportion(RevisionComponent *v, Revisi
 
             if (shift > 0)
             {
-                RevisionComponent *a = ancestor(vil, v, default_ancestor);
+                Node *a = ancestor(vil, v, default_ancestor);
                 moveSubtree(a, v, shift);
                 sir = sir + shift;
                 sor = sor + shift;
@@ -256,7 +422,7 @@ RevisionComponent *RevisionTreeComponent::apportion(RevisionComponent *v, Revisi
     return default_ancestor;
 }
 
-void RevisionTreeComponent::moveSubtree(RevisionComponent *wl, RevisionComponent *wr, float shift)
+void RevisionTreeComponent::moveSubtree(Node *wl, Node *wr, float shift)
 {
     int subtrees = wr->number - wl->number;
     if (subtrees != 0) { wr->change -= shift / subtrees; }
@@ -266,14 +432,14 @@ void RevisionTreeComponent::moveSubtree(RevisionComponent *wl, RevisionComponent
     wr->mod += shift;
 }
 
-void RevisionTreeComponent::executeShifts(RevisionComponent *v)
+void RevisionTreeComponent::executeShifts(Node *v)
 {
     float shift = 0;
     float change = 0;
 
     for (int i = 0; i < v->children.size(); ++i) // v.children[::-1] ???
     {
-        RevisionComponent *w = v->children[i];
+        Node *w = v->children[i];
         w->x += shift;
         w->mod += shift;
         change += w->change;
@@ -281,11 +447,11 @@ void RevisionTreeComponent::executeShifts(RevisionComponent *v)
     }
 }
 
-RevisionComponent *RevisionTreeComponent::ancestor(RevisionComponent *vil, RevisionComponent *v, RevisionComponent *default_ancestor)
+RevisionTreeComponent::Node *RevisionTreeComponent::ancestor(Node *vil, Node *v, Node *default_ancestor)
 {
     for (int i = 0; i < v->children.size(); ++i)
     {
-        RevisionComponent *child = v->children[i];
+        Node *child = v->children[i];
 
         if (child == vil->ancestor) { return vil->ancestor; }
     }
@@ -293,7 +459,7 @@ RevisionComponent *RevisionTreeComponent::ancestor(RevisionComponent *vil, Revis
     return default_ancestor;
 }
 
-float RevisionTreeComponent::secondWalk(RevisionComponent *v, float &min, float m, float depth)
+float RevisionTreeComponent::secondWalk(Node *v, float &min, float m, float depth)
 {
     v->x += m;
     v->y = depth;
@@ -306,45 +472,38 @@ float RevisionTreeComponent::secondWalk(RevisionComponent *v, float &min, float
 
     for (int i = 0; i < v->children.size(); ++i)
     {
-        RevisionComponent *child = v->children[i];
+        Node *child = v->children[i];
         min = this->secondWalk(child, min, m + v->mod, depth + 1);
     }
 
     return min;
 }
 
-void RevisionTreeComponent::thirdWalk(RevisionComponent *v, float n)
+void RevisionTreeComponent::thirdWalk(Node *v, float n)
 {
     v->x += n;
 
     for (int i = 0; i < v->children.size(); ++i)
     {
-        RevisionComponent *w = v->children[i];
+        Node *w = v->children[i];
         this->thirdWalk(w, n);
     }
 }
 
-void RevisionTreeComponent::postWalk(RevisionComponent *v)
+void RevisionTreeComponent::postWalk(Node *v)
 {
-    const int vx = int(v->x * (v->getWidth() + 10));
-    const int vy = int((this->treeDepth - v->y) * (v->getHeight() + CONNECTOR_HEIGHT));
+    const int vx = int(v->x * (REVISION_WIDTH + REVISION_SPACING));
+    const int vy = int((this->treeDepth - v->y) * (REVISION_HEIGHT + CONNECTOR_HEIGHT));
 
-    const int newWidth = jmax(this->getWidth(), vx + v->getWidth());
-    const int newHeight = jmax(this->getHeight(), vy + v->getHeight());
+    const int newWidth = jmax(this->getWidth(), vx + REVISION_WIDTH);
+    const int newHeight = jmax(this->getHeight(), vy + REVISION_HEIGHT);
 
     this->setSize(newWidth, newHeight);
-    v->setTopLeftPosition(vx, vy);
+    v->bounds = { vx, vy, REVISION_WIDTH, REVISION_HEIGHT };
 
-    for (int i = 0; i < v->children.size(); ++i)
+    for (auto *w : v->children)
     {
-        RevisionComponent *w = v->children[i];
         this->postWalk(w);
-
-        RevisionConnectorComponent *revisionConnector =
-            new RevisionConnectorComponent(v, w);
-
-        revisionConnector->resizeToFit();
-        this->addAndMakeVisible(revisionConnector);
     }
 }
 
@@ -364,3 +523,48 @@ HistoryComponent *RevisionTreeComponent::findParentEditor() const
 
     return nullptr;
 }
+
+//===----------------------------------------------------------------------===//
+// Tree layout node helpers
+//===----------------------------------------------------------------------===//
+
+RevisionTreeComponent::Node *RevisionTreeComponent::Node::getLeftmostSibling() const
+{
+    if (!this->leftmostSibling && this->parent)
+    {
+        if (this != this->parent->children.getFirst())
+        {
+            this->leftmostSibling = this->parent->children.getFirst();
+        }
+    }
+
+    return this->leftmostSibling;
+}
+
+RevisionTreeComponent::Node *RevisionTreeComponent::Node::getLeftBrother() const
+{
+    Node *n = nullptr;
+
+    if (this->parent)
+    {
+        for (auto i : this->parent->children)
+        {
+            if (i == this) { return n; }
+            n = i;
+        }
+    }
+
+    return n;
+}
+
+RevisionTreeComponent::Node *RevisionTreeComponent::Node::right() const
+{
+    if (this->children.size() > 0) { return this->children.getLast(); }
+    return this->wired;
+}
+
+RevisionTreeComponent::Node *RevisionTreeComponent::Node::left() const
+{
+    if (this->children.size() > 0) { return this->children.getFirst(); }
+    return this->wired;
+}
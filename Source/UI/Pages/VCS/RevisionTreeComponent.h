@@ -23,7 +23,9 @@ class HistoryComponent;
 
 #include "Revision.h"
 
-class RevisionTreeComponent final : public Component
+class RevisionTreeComponent final :
+    public Component,
+    private ComponentListener
 {
 public:
 
@@ -35,32 +37,100 @@ public:
 
     VCS::Revision::Ptr getSelectedRevision() const noexcept;
 
+    //===------------------------------------------------------------------===//
+    // Component
+    //===------------------------------------------------------------------===//
+
+    void paint(Graphics &g) override;
+    void parentHierarchyChanged() override;
     void handleCommandMessage(int commandId) override;
 
 private:
 
-    // Tree layout methods:
+    //===------------------------------------------------------------------===//
+    // ComponentListener
+    //===------------------------------------------------------------------===//
+
+    void componentMovedOrResized(Component &component,
+        bool wasMoved, bool wasResized) override;
+
+    void componentBeingDeleted(Component &component) override;
+
+private:
+
+    // The tree is laid out once into these lightweight nodes,
+    // and the revision components are only created for the nodes
+    // within the visible area, and are re-used as the viewport scrolls
 
-    RevisionComponent *initComponents(int depth,
-        const VCS::Revision::Ptr revision, RevisionComponent *parentRevisionComponent);
+    struct Node final
+    {
+        VCS::Revision::Ptr revision;
+        VCS::Revision::SyncState syncState = VCS::Revision::NoSync;
+        bool isHead = false;
 
-    RevisionComponent *firstWalk(RevisionComponent *v, float distance = 1.f);
+        // Helpers for tree traverse:
 
-    RevisionComponent *apportion(RevisionComponent *v,
-        RevisionComponent *default_ancestor, float distance);
+        float x = 0.f;
+        float y = 0.f;
+        float mod = 0.f;
+        float shift = 0.f;
+        float change = 0.f;
+        int number = 0;
 
-    void moveSubtree(RevisionComponent *wl, RevisionComponent *wr, float shift);
-    void executeShifts(RevisionComponent *v);
+        Node *parent = nullptr;
+        Node *ancestor = nullptr;
+        Node *wired = nullptr;
 
-    RevisionComponent *ancestor(RevisionComponent *vil,
-        RevisionComponent *v, RevisionComponent *default_ancestor);
+        Array<Node *> children;
 
-    float secondWalk(RevisionComponent *v, float &min, float m = 0.f, float depth = 0.f);
-    void thirdWalk(RevisionComponent *v, float n);
-    void postWalk(RevisionComponent *v);
+        Node *getLeftmostSibling() const;
+        Node *getLeftBrother() const;
+        Node *right() const;
+        Node *left() const;
+
+        mutable Node *leftmostSibling = nullptr;
+
+        // Layout results:
+
+        Rectangle<int> bounds;
+        RevisionComponent *component = nullptr;
+    };
+
+    OwnedArray<Node> nodes;
+
+    // Tree layout methods:
+
+    Node *initNodes(int depth, const VCS::Revision::Ptr revision, Node *parentNode);
+
+    Node *firstWalk(Node *v, float distance = 1.f);
+    Node *apportion(Node *v, Node *default_ancestor, float distance);
+
+    void moveSubtree(Node *wl, Node *wr, float shift);
+    void executeShifts(Node *v);
+
+    Node *ancestor(Node *vil, Node *v, Node *default_ancestor);
+
+    float secondWalk(Node *v, float &min, float m = 0.f, float depth = 0.f);
+    void thirdWalk(Node *v, float n);
+    void postWalk(Node *v);
 
     float treeDepth;
 
+private:
+
+    void updateVisibleComponents();
+    Rectangle<int> getVisibleBounds() const;
+
+    Path getConnectorPath(const Node *v, const Node *w) const;
+
+    OwnedArray<RevisionComponent> revisionComponents;
+    Array<RevisionComponent *> spareComponents;
+
+    Component::SafePointer<Viewport> viewport;
+    Component::SafePointer<Component> viewedComponent;
+
+    void detachFromViewport();
+
 private:
 
     HistoryComponent *findParentEditor() const;
@@ -33,6 +33,7 @@
 #include "Head.h"
 #include "ComponentIDs.h"
 #include "CommandIDs.h"
+#include "MessageThreadWatchdog.h"
 
 #if HELIO_DESKTOP
 #    define VCS_STAGE_ROW_HEIGHT (65)
@@ -181,9 +182,11 @@ void StageComponent::clearSelection()
 
 void StageComponent::changeListenerCallback(ChangeBroadcaster *source)
 {
+    WATCHDOG_SCOPE("StageComponent::changeListenerCallback");
+
     if (auto *head = dynamic_cast<VCS::Head *>(source))
     {
-        if (head->isRebuildingDiff())
+        if (head->isRebuildingDiff() || head->hasPendingMove())
         {
             this->startProgressAnimation();
             this->clearList();
@@ -24,6 +24,7 @@
 //[MiscUserDefs]
 #include "VersionControl.h"
 #include "MainLayout.h"
+#include "MessageThreadWatchdog.h"
 //[/MiscUserDefs]
 
 VersionControlEditor::VersionControlEditor(VersionControl &versionControl)
@@ -127,6 +128,8 @@ void VersionControlEditor::onHistorySelectionChanged()
 
 void VersionControlEditor::changeListenerCallback(ChangeBroadcaster *source)
 {
+    WATCHDOG_SCOPE("VersionControlEditor::changeListenerCallback");
+
     // VCS or project has changed
     if (this->isShowing())
     {
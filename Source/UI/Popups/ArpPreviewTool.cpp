@@ -26,6 +26,7 @@
 #include "NoteComponent.h"
 #include "CommandIDs.h"
 #include "Config.h"
+#include "MidiExportBuffer.h"
 
 ArpPreviewTool *ArpPreviewTool::createWithinContext(PianoRoll &roll,
     WeakReference<MidiTrack> keySignatures)
@@ -60,11 +61,11 @@ ArpPreviewTool::ArpPreviewTool(PianoRoll &roll, Note::Key keyContext,
     advancedMode(advancedMode)
 {
     // this code pretty much duplicates menu from PianoRollSelectionMenu,
-    // but adds undos and starts/stops playback of the selected fragment
+    // but previews the result and starts/stops its playback
 
     this->mainMenu.add(MenuItem::item(Icons::close, TRANS(I18n::Menu::cancel))->withAction([this]()
     {
-        this->undoIfNeeded();
+        this->cancelPreview();
         this->dismissAsync();
     }));
 
@@ -95,6 +96,11 @@ ArpPreviewTool::ArpPreviewTool(PianoRoll &roll, Note::Key keyContext,
     this->updateContent(this->mainMenu, MenuPanel::SlideUp);
 }
 
+ArpPreviewTool::~ArpPreviewTool()
+{
+    this->applyPreviewIfNeeded();
+}
+
 MenuPanel::Menu ArpPreviewTool::createOptionsMenu(Arpeggiator::Ptr arp)
 {
     MenuPanel::Menu menu;
@@ -194,38 +200,60 @@ void ArpPreviewTool::previewArp(Arpeggiator::Ptr arp, const Options options, boo
     if (forceRecreate || arp != this->lastChosenArp)
     {
         transport.stopPlayback();
-        const bool needsCheckpoint = !this->hasMadeChanges;
-        this->undoIfNeeded();
 
-        SequencerOperations::arpeggiate(this->roll.getLassoSelection(),
+        SequencerOperations::makeArpeggiation(this->roll.getLassoSelection(),
             this->scaleContext, this->keyContext, arp,
             options.durationMultiplier, options.randomness,
             options.reversed, options.limitToChord,
-            needsCheckpoint);
+            this->previewRemovals, this->previewInsertions);
+
+        const auto &clip = this->roll.getLassoSelection().getFirstAs<NoteComponent>()->getClip();
+        this->roll.showPreviewNotes(this->previewInsertions, clip);
 
         this->lastChosenArp = arp;
-        this->hasMadeChanges = true;
     }
 
-    if (transport.isPlaying())
+    this->togglePreviewPlayback();
+}
+
+void ArpPreviewTool::togglePreviewPlayback()
+{
+    auto &transport = this->roll.getTransport();
+    if (transport.isPlaying() || transport.isProbingSequence())
     {
         transport.stopPlayback();
+        return;
     }
-    else
+
+    if (this->previewInsertions.isEmpty())
     {
-        const auto firstBeat = this->roll.getLassoStartBeat();
-        const auto lastBeat = this->roll.getLassoEndBeat();
-        const auto fragmentStart = this->roll.getTransportPositionByBeat(firstBeat);
-        const auto fragmentEnd = this->roll.getTransportPositionByBeat(lastBeat);
-        transport.startPlaybackFragment(fragmentStart - 0.001, fragmentEnd);
+        return;
     }
+
+    // the selection is still there, so only the arpeggiated notes
+    // are played, starting from the beginning of the selection
+    const auto &clip = this->roll.getLassoSelection().getFirstAs<NoteComponent>()->getClip();
+    const auto firstBeat = this->roll.getLassoStartBeat();
+
+    MidiExportBuffer buffer;
+    buffer.ensureStorageAllocated(this->previewInsertions.size() * 2);
+    for (const auto &note : this->previewInsertions)
+    {
+        note.exportMessages(buffer, clip, -double(firstBeat), 1.0);
+    }
+
+    MidiMessageSequence sequence;
+    buffer.flush(sequence);
+
+    transport.seekToPosition(this->roll.getTransportPositionByBeat(firstBeat));
+    transport.probeSequence(sequence, this->roll.getActiveTrack());
 }
 
 void ArpPreviewTool::handleCommandMessage(int commandId)
 {
     if (commandId == CommandIDs::Cancel)
     {
-        this->undoIfNeeded();
+        this->cancelPreview();
     }
 }
 
@@ -237,10 +265,26 @@ void ArpPreviewTool::dismissAsync()
     }
 }
 
-void ArpPreviewTool::undoIfNeeded()
+void ArpPreviewTool::cancelPreview()
+{
+    this->roll.getTransport().stopPlayback();
+    this->roll.hidePreviewNotes();
+    this->previewRemovals.clearQuick();
+    this->previewInsertions.clearQuick();
+}
+
+void ArpPreviewTool::applyPreviewIfNeeded()
 {
-    if (this->hasMadeChanges)
+    if (this->previewInsertions.isEmpty())
     {
-        this->roll.getActiveTrack()->getSequence()->undo();
+        return;
     }
+
+    this->roll.getTransport().stopPlayback();
+    this->roll.hidePreviewNotes();
+
+    SequencerOperations::applyArpeggiation(this->previewRemovals, this->previewInsertions);
+
+    this->previewRemovals.clearQuick();
+    this->previewInsertions.clearQuick();
 }
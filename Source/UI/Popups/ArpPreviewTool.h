@@ -33,6 +33,8 @@ public:
     ArpPreviewTool(PianoRoll &roll, Note::Key keyContext,
         Scale::Ptr scaleContext, bool advancedMode);
 
+    ~ArpPreviewTool() override;
+
     static ArpPreviewTool *createWithinContext(PianoRoll &roll,
         WeakReference<MidiTrack> keySignatures);
 
@@ -41,7 +43,8 @@ public:
 private:
 
     void dismissAsync();
-    void undoIfNeeded();
+    void cancelPreview();
+    void applyPreviewIfNeeded();
 
     MenuPanel::Menu mainMenu;
     MenuPanel::Menu createOptionsMenu(Arpeggiator::Ptr arp);
@@ -55,6 +58,7 @@ private:
     };
 
     void previewArp(Arpeggiator::Ptr arp, const Options options, bool forceRecreate);
+    void togglePreviewPlayback();
 
     PianoRoll &roll;
 
@@ -63,7 +67,11 @@ private:
 
     bool advancedMode = false;
 
-    bool hasMadeChanges = false;
+    // the arpeggiation is only shown and played until the tool is closed,
+    // and then the same result is applied in one go, or not at all, if cancelled
+    Array<Note> previewRemovals;
+    Array<Note> previewInsertions;
+
     Arpeggiator::Ptr lastChosenArp = nullptr;
     Options lastOptions;
 
@@ -233,7 +233,7 @@ void CommandPalette::inputAttemptWhenModal()
 
 int CommandPalette::getNumRows()
 {
-    return this->currentActionsProvider->getFilteredActions().size();
+    return this->currentActionsProvider->getNumFilteredActions();
 }
 
 void CommandPalette::paintListBoxItem(int rowNumber, Graphics &g, int w, int h, bool rowIsSelected)
@@ -249,12 +249,12 @@ void CommandPalette::paintListBoxItem(int rowNumber, Graphics &g, int w, int h,
         g.fillAll(Colours::black.withAlpha(0.05f));
     }
 
-    if (rowNumber >= this->currentActionsProvider->getFilteredActions().size())
+    if (rowNumber >= this->currentActionsProvider->getNumFilteredActions())
     {
         return;
     }
 
-    const auto action = this->currentActionsProvider->getFilteredActions().getUnchecked(rowNumber);
+    const auto action = this->currentActionsProvider->getFilteredAction(rowNumber);
 
     g.setFont(21);
     const float margin = float(h / 12.f);
@@ -409,12 +409,12 @@ bool CommandPaletteTextEditor::keyPressed(const KeyPress &key)
 void CommandPalette::applySelectedCommand()
 {
     const auto rowNumber = this->actionsList->getSelectedRow(0);
-    if (rowNumber < 0 || rowNumber >= this->currentActionsProvider->getFilteredActions().size())
+    if (rowNumber < 0 || rowNumber >= this->currentActionsProvider->getNumFilteredActions())
     {
         return;
     }
 
-    const auto action = this->currentActionsProvider->getFilteredActions().getUnchecked(rowNumber);
+    const auto action = this->currentActionsProvider->getFilteredAction(rowNumber);
     const auto callback = action->getCallback();
     if (callback != nullptr)
     {
@@ -436,7 +436,7 @@ void CommandPalette::applySelectedCommand()
 
 int CommandPalette::getHeightToFitActions() const
 {
-    const auto numRows = this->currentActionsProvider->getFilteredActions().size();
+    const auto numRows = this->currentActionsProvider->getNumFilteredActions();
     const auto margin = this->getHeight() - this->actionsList->getHeight();
     const auto maxRows = (App::Layout().getHeight() / 3) / COMMAND_PALETTE_ROW_HEIGHT;
     return jlimit(4, maxRows, numRows) * COMMAND_PALETTE_ROW_HEIGHT + margin;
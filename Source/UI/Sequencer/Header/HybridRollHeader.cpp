@@ -271,6 +271,16 @@ void HybridRollHeader::mouseDrag(const MouseEvent &e)
                         this->updateTimeDistanceIndicator();
                     }
                 }
+
+#if HYBRID_ROLL_HEADER_ALIGNS_TO_BEATS
+                const float roundBeat = this->roll.getRoundBeatSnapByXPosition(e.x);
+                const double transportPosition = this->roll.getTransportPositionByBeat(roundBeat);
+#else
+                const double transportPosition = this->roll.getTransportPositionByXPosition(e.x, float(this->getWidth()));
+#endif
+
+                // scrubbing: only the notes which start or stop sounding are sent
+                this->transport.probeSoundAt(transportPosition, nullptr);
             }
         }
     }
@@ -326,7 +336,7 @@ void HybridRollHeader::mouseUp(const MouseEvent &e)
     
     if (this->soundProbeMode)
     {
-        this->transport.allNotesControllersAndSoundOff();
+        this->transport.stopSoundProbe();
         return;
     }
     
@@ -21,12 +21,10 @@
 #include "HybridRoll.h"
 #include "ColourIDs.h"
 #include "PlayerThread.h"
+#include "UiProfiler.h"
 
 #define FREE_SPACE 2
 
-//#define PLAYHEAD_UPDATE_TIME_MS (1000 / 50)
-#define PLAYHEAD_UPDATE_TIME_MS 7
-
 Playhead::Playhead(HybridRoll &parentRoll,
     Transport &owner,
     Playhead::Listener *movementListener /*= nullptr*/,
@@ -35,9 +33,6 @@ Playhead::Playhead(HybridRoll &parentRoll,
     transport(owner),
     playheadWidth(width + FREE_SPACE),
     lastCorrectPosition(0.0),
-    timerStartTime(0.0),
-    msPerQuarterNote(1.0),
-    timerStartPosition(0.0),
     listener(movementListener)
 {
     this->mainColour = findDefaultColour(ColourIDs::Roll::playhead);
@@ -49,8 +44,6 @@ Playhead::Playhead(HybridRoll &parentRoll,
     this->setSize(this->playheadWidth, 1);
 
     this->lastCorrectPosition = this->transport.getSeekPosition();
-    this->timerStartTime = Time::getMillisecondCounterHiRes();
-    this->timerStartPosition = this->lastCorrectPosition;
 
     this->transport.addTransportListener(this);
 }
@@ -74,26 +67,10 @@ void Playhead::onSeek(double absolutePosition,
     }
 
     this->triggerAsyncUpdate();
-
-    if (this->isTimerRunning())
-    {
-        SpinLock::ScopedLockType lock(this->anchorsLock);
-        this->timerStartTime = Time::getMillisecondCounterHiRes();
-        this->timerStartPosition = this->lastCorrectPosition;
-        //this->startTimer(PLAYHEAD_UPDATE_TIME_MS);
-    }
 }
 
 void Playhead::onTempoChanged(double msPerQuarter)
 {
-    SpinLock::ScopedLockType lock(this->anchorsLock);
-    this->msPerQuarterNote = jmax(msPerQuarter, 0.01);
-        
-    if (this->isTimerRunning())
-    {
-        this->timerStartTime = Time::getMillisecondCounterHiRes();
-        this->timerStartPosition = this->lastCorrectPosition;
-    }
 }
 
 void Playhead::onTotalTimeChanged(double timeMs)
@@ -102,34 +79,22 @@ void Playhead::onTotalTimeChanged(double timeMs)
 
 void Playhead::onPlay()
 {
-    {
-        SpinLock::ScopedLockType lock(this->anchorsLock);
-        this->timerStartTime = Time::getMillisecondCounterHiRes();
-        this->timerStartPosition = this->lastCorrectPosition;
-    }
-
-    this->startTimer(PLAYHEAD_UPDATE_TIME_MS);
+    this->startAnimating();
 }
 
 void Playhead::onStop()
 {
-    this->stopTimer();
-
-    {
-        SpinLock::ScopedLockType lock(this->anchorsLock);
-        this->timerStartTime = 0.0;
-        this->timerStartPosition = 0.0;
-    }
+    this->stopAnimating();
 }
 
 
 //===----------------------------------------------------------------------===//
-// Timer
+// AnimationClock::Listener
 //===----------------------------------------------------------------------===//
 
-void Playhead::timerCallback()
+void Playhead::onAnimationFrame()
 {
-    this->triggerAsyncUpdate();
+    this->tick();
 }
 
 
@@ -139,7 +104,7 @@ void Playhead::timerCallback()
 
 void Playhead::handleAsyncUpdate()
 {
-    if (this->isTimerRunning())
+    if (this->isAnimating())
     {
         this->tick();
     }
@@ -163,6 +128,8 @@ void Playhead::handleAsyncUpdate()
 
 void Playhead::paint(Graphics &g)
 {
+    UI_PROFILER_PAINT_SCOPE("Playhead", g);
+
     g.setColour(this->mainColour);
     g.fillRect(0, 0, 1, this->getHeight());
 
@@ -186,7 +153,7 @@ void Playhead::parentChanged()
     {
         this->setSize(this->playheadWidth, this->getParentHeight());
         
-        if (this->isTimerRunning())
+        if (this->isAnimating())
         {
             this->tick();
         }
@@ -218,15 +185,6 @@ void Playhead::updatePosition(double position)
 
 void Playhead::tick()
 {
-    double estimatedPosition;
-    
-    {
-        SpinLock::ScopedLockType lock(this->anchorsLock);
-        const double timeOffsetMs = Time::getMillisecondCounterHiRes() - this->timerStartTime;
-        const double positionOffset = (timeOffsetMs / this->transport.getTotalTime()) / this->msPerQuarterNote;
-        estimatedPosition = this->timerStartPosition + positionOffset;
-    }
-    
-    this->updatePosition(estimatedPosition);
+    this->updatePosition(this->transport.getPlaybackPosition());
 }
 
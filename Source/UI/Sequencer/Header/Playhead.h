@@ -22,12 +22,13 @@ class HybridRoll;
 class MovementListener;
 
 #include "TransportListener.h"
+#include "AnimationClock.h"
 
 class Playhead :
     public Component,
     public TransportListener,
     private AsyncUpdater,
-    private Timer
+    private AnimationClock::Listener
 {
 public:
 
@@ -74,19 +75,16 @@ protected:
 private:
 
     //===------------------------------------------------------------------===//
-    // Timer
+    // AnimationClock::Listener
     //===------------------------------------------------------------------===//
 
-    void timerCallback() override;
+    // while playing, the position is read from the transport once per frame,
+    // instead of being extrapolated from the seek events here
+    void onAnimationFrame() override;
     void tick();
 
     void parentChanged();
 
-    SpinLock anchorsLock;
-    double timerStartTime;
-    double timerStartPosition;
-    double msPerQuarterNote;
-
 private:
 
     //===------------------------------------------------------------------===//
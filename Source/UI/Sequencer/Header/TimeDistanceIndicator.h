@@ -19,11 +19,13 @@
 
 //[Headers]
 class IconComponent;
+
+#include "AnimationClock.h"
 //[/Headers]
 
 
 class TimeDistanceIndicator final : public Component,
-                                    private Timer
+                                    private AnimationClock::Listener
 {
 public:
 
@@ -56,13 +58,13 @@ private:
 
     //[UserVariables]
 
-    void timerCallback() override
+    void onAnimationFrame() override
     {
         this->setAlpha(this->getAlpha() + 0.1f);
 
         if (this->getAlpha() >= 1.f)
         {
-            this->stopTimer();
+            this->stopAnimating();
         }
     }
 
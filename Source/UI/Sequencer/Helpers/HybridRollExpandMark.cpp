@@ -43,7 +43,7 @@ HybridRollExpandMark::HybridRollExpandMark(HybridRoll &parentRoll, float targetB
     this->setSize(256, 48);
 
     //[Constructor]
-    this->startTimerHz(60);
+    this->startAnimating();
     //[/Constructor]
 }
 
@@ -103,7 +103,7 @@ void HybridRollExpandMark::updatePosition()
     this->setBounds(xOffset, 0, newWidth, this->getParentHeight());
 }
 
-void HybridRollExpandMark::timerCallback()
+void HybridRollExpandMark::onAnimationFrame()
 {
     this->alpha *= 0.945f;
 
@@ -123,7 +123,7 @@ void HybridRollExpandMark::timerCallback()
 BEGIN_JUCER_METADATA
 
 <JUCER_COMPONENT documentType="Component" className="HybridRollExpandMark" template="../../../Template"
-                 componentName="" parentClasses="public Component, private Timer"
+                 componentName="" parentClasses="public Component, private AnimationClock::Listener"
                  constructorParams="HybridRoll &amp;parentRoll, float targetBeat, int numBeatsToTake"
                  variableInitialisers="roll(parentRoll),&#10;beat(targetBeat),&#10;numBeats(numBeatsToTake),&#10;alpha(1.f)"
                  snapPixels="8" snapActive="1" snapShown="1" overlayOpacity="0.330"
@@ -20,11 +20,12 @@
 //[Headers]
 class HybridRoll;
 #include "IconComponent.h"
+#include "AnimationClock.h"
 //[/Headers]
 
 
 class HybridRollExpandMark final : public Component,
-                                   private Timer
+                                   private AnimationClock::Listener
 {
 public:
 
@@ -44,7 +45,7 @@ private:
 
     //[UserVariables]
 
-    void timerCallback() override;
+    void onAnimationFrame() override;
     void updatePosition();
 
     HybridRoll &roll;
@@ -0,0 +1,163 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Common.h"
+#include "NotesOverviewCache.h"
+#include "PianoSequence.h"
+
+// the narrowest bucket is an 1/8 of a beat,
+// so the exact notes are drawn from 8 pixels per beat on
+#define NOTES_OVERVIEW_BASE_BUCKET_BEATS (1.f / 8.f)
+#define NOTES_OVERVIEW_MAX_LEVEL 16
+
+static inline float getBeatsPerBucket(int level) noexcept
+{
+    return NOTES_OVERVIEW_BASE_BUCKET_BEATS * float(1 << level);
+}
+
+// the buckets range covered by a note, inclusive
+static inline Range<int> getBuckets(float beat, float length, float beatsPerBucket) noexcept
+{
+    const int start = int(floorf(beat / beatsPerBucket));
+    const int end = jmax(start, int(ceilf((beat + length) / beatsPerBucket)) - 1);
+    return { start, end + 1 };
+}
+
+int NotesOverviewCache::getLevelFor(float pixelsPerBeat) noexcept
+{
+    const float bucketWidth = pixelsPerBeat * NOTES_OVERVIEW_BASE_BUCKET_BEATS;
+    if (bucketWidth >= 1.f)
+    {
+        return -1;
+    }
+
+    if (bucketWidth <= 0.f)
+    {
+        return NOTES_OVERVIEW_MAX_LEVEL;
+    }
+
+    const auto level = int(ceilf(log2f(1.f / bucketWidth)));
+    return jlimit(0, NOTES_OVERVIEW_MAX_LEVEL, level);
+}
+
+const NotesOverviewCache::KeysRaster &NotesOverviewCache::getKeysRaster(
+    const PianoSequence &sequence, int level, int height)
+{
+    jassert(level >= 0);
+    auto &raster = this->overviews[&sequence].keys;
+    if (raster.level == level && raster.height == height)
+    {
+        return raster;
+    }
+
+    const auto &notes = sequence.getPackedNotes();
+
+    raster.level = level;
+    raster.height = height;
+    raster.beatsPerBucket = getBeatsPerBucket(level);
+    raster.image = {};
+
+    if (notes.size() == 0 || height <= 0)
+    {
+        return raster;
+    }
+
+    const int firstBucket = int(floorf(notes.beats.getFirst() / raster.beatsPerBucket));
+    const int lastBucket = int(ceilf(notes.maxEndBeats.getLast() / raster.beatsPerBucket));
+    raster.startBeat = float(firstBucket) * raster.beatsPerBucket;
+    raster.image = Image(Image::SingleChannel, jmax(1, lastBucket - firstBucket + 1), height, true);
+
+    // the same rows as PianoProjectMap uses for the exact notes
+    const float rowHeight = float(height) / 128.f;
+
+    RectangleList<int> rectangles;
+    rectangles.ensureStorageAllocated(notes.size());
+
+    for (int i = 0; i < notes.size(); ++i)
+    {
+        const auto key = jlimit(0, 128, int(notes.keys.getUnchecked(i)));
+        const int y = height - int(key * rowHeight);
+        if (y < 0 || y >= height)
+        {
+            continue;
+        }
+
+        const auto buckets = getBuckets(notes.beats.getUnchecked(i),
+            notes.lengths.getUnchecked(i), raster.beatsPerBucket);
+
+        rectangles.addWithoutMerging({ buckets.getStart() - firstBucket, y, buckets.getLength(), 1 });
+    }
+
+    Graphics g(raster.image);
+    g.setColour(Colours::white);
+    g.fillRectList(rectangles);
+
+    return raster;
+}
+
+const NotesOverviewCache::VelocityProfile &NotesOverviewCache::getVelocityProfile(
+    const PianoSequence &sequence, int level)
+{
+    jassert(level >= 0);
+    auto &profile = this->overviews[&sequence].velocities;
+    if (profile.level == level)
+    {
+        return profile;
+    }
+
+    const auto &notes = sequence.getPackedNotes();
+
+    profile.level = level;
+    profile.beatsPerBucket = getBeatsPerBucket(level);
+    profile.velocities.clearQuick();
+
+    if (notes.size() == 0)
+    {
+        return profile;
+    }
+
+    const int firstBucket = int(floorf(notes.beats.getFirst() / profile.beatsPerBucket));
+    const int lastBucket = int(ceilf(notes.maxEndBeats.getLast() / profile.beatsPerBucket));
+    profile.startBeat = float(firstBucket) * profile.beatsPerBucket;
+    profile.velocities.insertMultiple(0, -1.f, lastBucket - firstBucket + 1);
+
+    auto *velocities = profile.velocities.getRawDataPointer();
+    for (int i = 0; i < notes.size(); ++i)
+    {
+        const auto velocity = notes.velocities.getUnchecked(i);
+        const auto buckets = getBuckets(notes.beats.getUnchecked(i),
+            notes.lengths.getUnchecked(i), profile.beatsPerBucket);
+
+        for (int b = buckets.getStart(); b < buckets.getEnd(); ++b)
+        {
+            auto &bucket = velocities[b - firstBucket];
+            bucket = jmax(bucket, velocity);
+        }
+    }
+
+    return profile;
+}
+
+void NotesOverviewCache::invalidate(const MidiSequence *sequence)
+{
+    this->overviews.erase(sequence);
+}
+
+void NotesOverviewCache::clear()
+{
+    this->overviews.clear();
+}
@@ -0,0 +1,81 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+class MidiSequence;
+class PianoSequence;
+
+/*
+    The level-of-detail overviews of the piano sequences for the project maps:
+    when zoomed out so far that a note is narrower than a pixel, the maps
+    draw these instead of the individual notes. An overview splits the sequence
+    into buckets of beats, which are twice as wide at each next level,
+    and the maps pick the level which makes a bucket at least a pixel wide.
+
+    The overviews don't depend on clips, so all clips of a sequence share them,
+    and they are only rebuilt at the next paint after the sequence has changed.
+*/
+
+class NotesOverviewCache final
+{
+public:
+
+    NotesOverviewCache() = default;
+
+    // returns -1 when zoomed in enough to draw the exact notes
+    static int getLevelFor(float pixelsPerBeat) noexcept;
+
+    // a single-channel image of the notes coverage,
+    // one pixel per bucket horizontally, and the rows are
+    // placed like the project map places keys of the given height
+    struct KeysRaster final
+    {
+        Image image;
+        float startBeat = 0.f;
+        float beatsPerBucket = 1.f;
+        int level = -1;
+        int height = 0;
+    };
+
+    // the maximum velocity of the notes in each bucket, or -1 for empty buckets
+    struct VelocityProfile final
+    {
+        Array<float> velocities;
+        float startBeat = 0.f;
+        float beatsPerBucket = 1.f;
+        int level = -1;
+    };
+
+    const KeysRaster &getKeysRaster(const PianoSequence &sequence, int level, int height);
+    const VelocityProfile &getVelocityProfile(const PianoSequence &sequence, int level);
+
+    void invalidate(const MidiSequence *sequence);
+    void clear();
+
+private:
+
+    struct Overview final
+    {
+        KeysRaster keys;
+        VelocityProfile velocities;
+    };
+
+    FlatHashMap<const MidiSequence *, Overview> overviews;
+
+    JUCE_DECLARE_NON_COPYABLE(NotesOverviewCache)
+};
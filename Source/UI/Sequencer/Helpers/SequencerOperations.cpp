@@ -22,6 +22,7 @@
 #include "AnnotationEvent.h"
 #include "AutomationEvent.h"
 #include "KeySignatureEvent.h"
+#include "TimeSignatureEvent.h"
 #include "NoteComponent.h"
 #include "ClipComponent.h"
 #include "PianoTrackNode.h"
@@ -36,6 +37,7 @@
 #include "Arpeggiator.h"
 #include "Transport.h"
 #include "UndoActionIDs.h"
+#include "SelectionTransformExecutor.h"
 
 // a big FIXME:
 // most of this code assumes every track has its own undo stack;
@@ -262,6 +264,53 @@ bool applyAnnotationInsertions(const AnnotationChangeGroup &group, bool &didChec
 bool applyAutoInsertions(const AutoChangeGroup &group, bool &didCheckpoint)
 { return applyInsertions<AutomationEvent, AutomationSequence, AutoChangeGroup, AutoChangeGroupsPerLayer>(group, didCheckpoint); }
 
+//===----------------------------------------------------------------------===//
+// Multi-track helpers
+//===----------------------------------------------------------------------===//
+
+// The changes of each track only depend on its own sequence, so for the project-wide
+// operations they are collected for all tracks in parallel, and then merged in the tracks
+// order, to be applied on the calling thread as usual, i.e. in one checkpoint;
+// the collectors should only read, e.g. the new ids are not thread-safe to generate.
+// For the removals, the "before" groups are the events to remove,
+// and the "after" groups are the events to insert.
+struct TrackChanges final
+{
+    PianoChangeGroup pianoBefore;
+    PianoChangeGroup pianoAfter;
+
+    AnnotationChangeGroup annotationsBefore;
+    AnnotationChangeGroup annotationsAfter;
+
+    AutoChangeGroup autoBefore;
+    AutoChangeGroup autoAfter;
+};
+
+using TrackChangesCollector = Function<void(MidiSequence *sequence, TrackChanges &changes)>;
+
+static TrackChanges collectTrackChanges(const Array<MidiTrack *> &tracks,
+    const TrackChangesCollector &collector)
+{
+    std::vector<TrackChanges> changesPerTrack(size_t(tracks.size()));
+    App::Tasks().parallelFor(tracks.size(), [&](int i)
+    {
+        collector(tracks.getUnchecked(i)->getSequence(), changesPerTrack[size_t(i)]);
+    });
+
+    TrackChanges result;
+    for (const auto &changes : changesPerTrack)
+    {
+        result.pianoBefore.addArray(changes.pianoBefore);
+        result.pianoAfter.addArray(changes.pianoAfter);
+        result.annotationsBefore.addArray(changes.annotationsBefore);
+        result.annotationsAfter.addArray(changes.annotationsAfter);
+        result.autoBefore.addArray(changes.autoBefore);
+        result.autoAfter.addArray(changes.autoAfter);
+    }
+
+    return result;
+}
+
 //===----------------------------------------------------------------------===//
 // More helpers
 //===----------------------------------------------------------------------===//
@@ -378,22 +427,16 @@ void SequencerOperations::wipeSpace(Array<MidiTrack *> tracks,
     // и добавить все из массива 2
 
     bool didCheckpoint = !shouldCheckpoint;
-    
-    PianoChangeGroup pianoRemoveGroup;
-    PianoChangeGroup pianoInsertGroup;
 
-    AnnotationChangeGroup annotationsRemoveGroup;
-    AutoChangeGroup autoRemoveGroup;
-   
-    for (int i = 0; i < tracks.size(); ++i)
+    auto changes = collectTrackChanges(tracks, [=](MidiSequence *sequence, TrackChanges &result)
     {
-        const auto sequence = tracks.getUnchecked(i)->getSequence();
-
         if (auto *pianoSequence = dynamic_cast<PianoSequence *>(sequence))
         {
-            for (int j = 0; j < pianoSequence->size(); ++j)
+            Array<const Note *> notesInRange;
+            pianoSequence->findNotesInRange(startBeat, endBeat, notesInRange);
+
+            for (const auto *note : notesInRange)
             {
-                Note *note = static_cast<Note *>(pianoSequence->getUnchecked(j));
                 const float noteStartBeat = note->getBeat();
                 const float noteEndBeat = note->getBeat() + note->getLength();
                 
@@ -403,23 +446,24 @@ void SequencerOperations::wipeSpace(Array<MidiTrack *> tracks,
                 
                 if (shouldBeDeleted)
                 {
-                    pianoRemoveGroup.add(*note);
+                    result.pianoBefore.add(*note);
                 }
                 
                 if (shouldKeepCroppedNotes)
                 {
+                    // the new ids are assigned later, see below
                     const bool hasLeftPartToKeep = (noteStartBeat < startBeat && noteEndBeat > startBeat);
                     
                     if (hasLeftPartToKeep)
                     {
-                        pianoInsertGroup.add(note->withLength(startBeat - noteStartBeat).copyWithNewId());
+                        result.pianoAfter.add(note->withLength(startBeat - noteStartBeat));
                     }
                     
                     const bool hasRightPartToKeep = (noteStartBeat < endBeat && noteEndBeat > endBeat);
                     
                     if (hasRightPartToKeep)
                     {
-                        pianoInsertGroup.add(note->withBeat(endBeat).withLength(noteEndBeat - endBeat).copyWithNewId());
+                        result.pianoAfter.add(note->withBeat(endBeat).withLength(noteEndBeat - endBeat));
                     }
                 }
             }
@@ -433,7 +477,7 @@ void SequencerOperations::wipeSpace(Array<MidiTrack *> tracks,
                 
                 if (shouldBeDeleted)
                 {
-                    annotationsRemoveGroup.add(*annotation);
+                    result.annotationsBefore.add(*annotation);
                 }
             }
         }
@@ -446,49 +490,49 @@ void SequencerOperations::wipeSpace(Array<MidiTrack *> tracks,
                 
                 if (shouldBeDeleted)
                 {
-                    autoRemoveGroup.add(*event);
+                    result.autoBefore.add(*event);
                 }
             }
         }
+    });
+
+    for (auto &note : changes.pianoAfter)
+    {
+        note = note.copyWithNewId();
     }
-    
-    applyPianoRemovals(pianoRemoveGroup, didCheckpoint);
-    applyAnnotationRemovals(annotationsRemoveGroup, didCheckpoint);
-    applyAutoRemovals(autoRemoveGroup, didCheckpoint);
+
+    applyPianoRemovals(changes.pianoBefore, didCheckpoint);
+    applyAnnotationRemovals(changes.annotationsBefore, didCheckpoint);
+    applyAutoRemovals(changes.autoBefore, didCheckpoint);
 
     if (shouldKeepCroppedNotes)
     {
-        applyPianoInsertions(pianoInsertGroup, didCheckpoint);
+        applyPianoInsertions(changes.pianoAfter, didCheckpoint);
     }
 }
 
-void SequencerOperations::shiftEventsToTheLeft(Array<MidiTrack *> tracks, float targetBeat, float beatOffset, bool shouldCheckpoint /*= true*/)
+// collects the events either before the target beat, or after it (inclusive)
+static TrackChanges collectShiftedEvents(const Array<MidiTrack *> &tracks,
+    float targetBeat, float beatOffset, bool eventsAfterTarget)
 {
-    bool didCheckpoint = !shouldCheckpoint;
-    
-    PianoChangeGroup pianoGroupBefore;
-    PianoChangeGroup pianoGroupAfter;
-    
-    AnnotationChangeGroup annotationsGroupBefore;
-    AnnotationChangeGroup annotationsGroupAfter;
-    
-    AutoChangeGroup autoGroupBefore;
-    AutoChangeGroup autoGroupAfter;
-    
-    for (int i = 0; i < tracks.size(); ++i)
+    return collectTrackChanges(tracks, [=](MidiSequence *sequence, TrackChanges &result)
     {
-        auto *sequence = tracks.getUnchecked(i)->getSequence();
+        const auto shouldShift = [=](const MidiEvent *event)
+        {
+            return eventsAfterTarget ?
+                event->getBeat() >= targetBeat :
+                event->getBeat() < targetBeat;
+        };
 
         if (auto *pianoSequence = dynamic_cast<PianoSequence *>(sequence))
         {
             for (int j = 0; j < pianoSequence->size(); ++j)
             {
                 auto *note = static_cast<Note *>(pianoSequence->getUnchecked(j));
-
-                if (note->getBeat() < targetBeat)
+                if (shouldShift(note))
                 {
-                    pianoGroupBefore.add(*note);
-                    pianoGroupAfter.add(note->withDeltaBeat(beatOffset));
+                    result.pianoBefore.add(*note);
+                    result.pianoAfter.add(note->withDeltaBeat(beatOffset));
                 }
             }
         }
@@ -497,11 +541,10 @@ void SequencerOperations::shiftEventsToTheLeft(Array<MidiTrack *> tracks, float
             for (int j = 0; j < textSequence->size(); ++j)
             {
                 auto *annotation = static_cast<AnnotationEvent *>(textSequence->getUnchecked(j));
-
-                if (annotation->getBeat() < targetBeat)
+                if (shouldShift(annotation))
                 {
-                    annotationsGroupBefore.add(*annotation);
-                    annotationsGroupAfter.add(annotation->withDeltaBeat(beatOffset));
+                    result.annotationsBefore.add(*annotation);
+                    result.annotationsAfter.add(annotation->withDeltaBeat(beatOffset));
                 }
             }
         }
@@ -510,82 +553,36 @@ void SequencerOperations::shiftEventsToTheLeft(Array<MidiTrack *> tracks, float
             for (int j = 0; j < autoSequence->size(); ++j)
             {
                 auto *event = static_cast<AutomationEvent *>(autoSequence->getUnchecked(j));
-                
-                if (event->getBeat() < targetBeat)
+                if (shouldShift(event))
                 {
-                    autoGroupBefore.add(*event);
-                    autoGroupAfter.add(event->withDeltaBeat(beatOffset));
+                    result.autoBefore.add(*event);
+                    result.autoAfter.add(event->withDeltaBeat(beatOffset));
                 }
             }
         }
-    }
-    
-    applyPianoChanges(pianoGroupBefore, pianoGroupAfter, didCheckpoint);
-    applyAnnotationChanges(annotationsGroupBefore, annotationsGroupAfter, didCheckpoint);
-    applyAutoChanges(autoGroupBefore, autoGroupAfter, didCheckpoint);
+    });
+}
+
+void SequencerOperations::shiftEventsToTheLeft(Array<MidiTrack *> tracks, float targetBeat, float beatOffset, bool shouldCheckpoint /*= true*/)
+{
+    bool didCheckpoint = !shouldCheckpoint;
+
+    const auto changes = collectShiftedEvents(tracks, targetBeat, beatOffset, false);
+
+    applyPianoChanges(changes.pianoBefore, changes.pianoAfter, didCheckpoint);
+    applyAnnotationChanges(changes.annotationsBefore, changes.annotationsAfter, didCheckpoint);
+    applyAutoChanges(changes.autoBefore, changes.autoAfter, didCheckpoint);
 }
 
 void SequencerOperations::shiftEventsToTheRight(Array<MidiTrack *> tracks, float targetBeat, float beatOffset, bool shouldCheckpoint /*= true*/)
 {
     bool didCheckpoint = !shouldCheckpoint;
-    
-    PianoChangeGroup groupBefore;
-    PianoChangeGroup groupAfter;
-    
-    AnnotationChangeGroup annotationsGroupBefore;
-    AnnotationChangeGroup annotationsGroupAfter;
-    
-    AutoChangeGroup autoGroupBefore;
-    AutoChangeGroup autoGroupAfter;
-    
-    for (int i = 0; i < tracks.size(); ++i)
-    {
-        auto *sequence = tracks.getUnchecked(i)->getSequence();
 
-        if (auto *pianoSequence = dynamic_cast<PianoSequence *>(sequence))
-        {
-            for (int j = 0; j < pianoSequence->size(); ++j)
-            {
-                auto *note = static_cast<Note *>(pianoSequence->getUnchecked(j));
-                
-                if (note->getBeat() >= targetBeat)
-                {
-                    groupBefore.add(*note);
-                    groupAfter.add(note->withDeltaBeat(beatOffset));
-                }
-            }
-        }
-        else if (auto *textSequence = dynamic_cast<AnnotationsSequence *>(sequence))
-        {
-            for (int j = 0; j < textSequence->size(); ++j)
-            {
-                auto *annotation = static_cast<AnnotationEvent *>(textSequence->getUnchecked(j));
-                
-                if (annotation->getBeat() >= targetBeat)
-                {
-                    annotationsGroupBefore.add(*annotation);
-                    annotationsGroupAfter.add(annotation->withDeltaBeat(beatOffset));
-                }
-            }
-        }
-        else if (auto *autoSequence = dynamic_cast<AutomationSequence *>(sequence))
-        {
-            for (int j = 0; j < autoSequence->size(); ++j)
-            {
-                auto *event = static_cast<AutomationEvent *>(autoSequence->getUnchecked(j));
-                
-                if (event->getBeat() >= targetBeat)
-                {
-                    autoGroupBefore.add(*event);
-                    autoGroupAfter.add(event->withDeltaBeat(beatOffset));
-                }
-            }
-        }
-    }
-    
-    applyPianoChanges(groupBefore, groupAfter, didCheckpoint);
-    applyAnnotationChanges(annotationsGroupBefore, annotationsGroupAfter, didCheckpoint);
-    applyAutoChanges(autoGroupBefore, autoGroupAfter, didCheckpoint);
+    const auto changes = collectShiftedEvents(tracks, targetBeat, beatOffset, true);
+
+    applyPianoChanges(changes.pianoBefore, changes.pianoAfter, didCheckpoint);
+    applyAnnotationChanges(changes.annotationsBefore, changes.annotationsAfter, didCheckpoint);
+    applyAutoChanges(changes.autoBefore, changes.autoAfter, didCheckpoint);
 }
 
 
@@ -598,250 +595,161 @@ void SequencerOperations::snapSelection(Lasso &selection, float snapsPerBeat, bo
     
     bool didCheckpoint = !shouldCheckpoint;
     
-    PianoChangeGroup groupBefore, groupAfter;
+    Note::Transform snap;
+    snap.snapsPerBeat = snapsPerBeat;
     
-    for (int i = 0; i < selection.getNumSelected(); ++i)
+    for (const auto &s : selection.getGroupedSelections())
     {
-        auto *nc = static_cast<NoteComponent *>(selection.getSelectedItem(i));
+        const auto trackSelection(s.second);
+        auto *pianoSequence = getPianoSequence(trackSelection);
+        jassert(pianoSequence);
         
-        const float startBeat = nc->getBeat();
-        const float startBeatSnap = snappedBeat(startBeat, snapsPerBeat);
+        Array<const Note *> notes;
         
-        const float endBeat = nc->getBeat() + nc->getLength();
-        const float endBeatSnap = snappedBeat(endBeat, snapsPerBeat);
-        const float lengthSnap = endBeatSnap - startBeatSnap;
+        for (int i = 0; i < trackSelection->size(); ++i)
+        {
+            auto *nc = static_cast<NoteComponent *>(trackSelection->getUnchecked(i));
+            
+            const float startBeat = nc->getBeat();
+            const float startBeatSnap = snappedBeat(startBeat, snapsPerBeat);
+            
+            const float endBeat = nc->getBeat() + nc->getLength();
+            const float endBeatSnap = snappedBeat(endBeat, snapsPerBeat);
+            
+            if (startBeat != startBeatSnap ||
+                endBeat != endBeatSnap)
+            {
+                notes.add(&nc->getNote());
+            }
+        }
         
-        if (startBeat != startBeatSnap ||
-            endBeat != endBeatSnap)
+        if (notes.size() > 0)
         {
-            groupBefore.add(nc->getNote());
-            groupAfter.add(nc->getNote().withBeat(startBeatSnap).withLength(lengthSnap));
+            if (! didCheckpoint)
+            {
+                pianoSequence->checkpoint();
+                didCheckpoint = true;
+            }
+            
+            pianoSequence->transformGroup(notes, snap, true);
         }
     }
-    
-    applyPianoChanges(groupBefore, groupAfter, didCheckpoint);
 }
 
 
-void SequencerOperations::cleanupOverlaps(Lasso &selection, bool shouldCheckpoint)
+// both cleanupOverlaps and removeDuplicates only compare notes of the same key,
+// so they sort the selected notes by key first, and then sweep each key's run
+struct NotesByKeyAndBeatSort final
 {
-    if (selection.getNumSelected() < 2)
+    static int compareElements(const Note &first, const Note &second) noexcept
     {
-        return;
-    }
+        const int keyDiff = first.getKey() - second.getKey();
+        if (keyDiff != 0) { return keyDiff; }
 
-    bool didCheckpoint = !shouldCheckpoint;
+        const float beatDiff = first.getBeat() - second.getBeat();
+        if (beatDiff != 0.f) { return (beatDiff > 0.f) - (beatDiff < 0.f); }
 
-    // 1 convert this
-    //    ----
-    // ------------
-    // into this
-    //    ---------
-    // ------------
-    
-    // todo repeat while does any changes
-    
-    bool step1HasChanges = false;
-    
-    do
+        const float lengthDiff = first.getLength() - second.getLength();
+        return (lengthDiff > 0.f) - (lengthDiff < 0.f);
+    }
+};
+
+struct NotesByKeyAndEndBeatSort final
+{
+    static int compareElements(const Note &first, const Note &second) noexcept
     {
-        PianoChangeGroup group1Before, group1After;
+        const int keyDiff = first.getKey() - second.getKey();
+        if (keyDiff != 0) { return keyDiff; }
 
-        for (int i = 0; i < selection.getNumSelected(); ++i)
-        {
-            const auto *nc = static_cast<NoteComponent *>(selection.getSelectedItem(i));
-            
-            // для каждой ноты найти ноту, которая полностью перекрывает ее на максимальную длину
-            
-            float deltaBeats = -FLT_MAX;
-            const Note *overlappingNote = nullptr;
-            
-            for (int j = 0; j < selection.getNumSelected(); ++j)
-            {
-                auto *nc2 = static_cast<NoteComponent *>(selection.getSelectedItem(j));
-                
-                if (nc->getKey() == nc2->getKey() &&
-                    nc->getBeat() > nc2->getBeat() &&
-                    (nc->getBeat() + nc->getLength()) < (nc2->getBeat() + nc2->getLength()))
-                {
-                    const float currentDelta = (nc2->getBeat() + nc2->getLength()) - (nc->getBeat() + nc->getLength());
-                    
-                    if (deltaBeats < currentDelta)
-                    {
-                        deltaBeats = currentDelta;
-                        overlappingNote = &nc2->getNote();
-                    }
-                }
-            }
-            
-            if (overlappingNote != nullptr)
-            {
-                const float newLength = nc->getLength() + deltaBeats;
-                group1Before.add(nc->getNote());
-                group1After.add(nc->getNote().withLength(newLength));
-            }
-        }
-        
-        step1HasChanges = applyPianoChanges(group1Before, group1After, didCheckpoint);
+        const float endDiff = (first.getBeat() + first.getLength()) -
+            (second.getBeat() + second.getLength());
+        if (endDiff != 0.f) { return (endDiff > 0.f) - (endDiff < 0.f); }
+
+        // the inner notes go first
+        const float beatDiff = second.getBeat() - first.getBeat();
+        return (beatDiff > 0.f) - (beatDiff < 0.f);
     }
-    while (step1HasChanges);
-    
-    
-    // 1 convert this
-    //    -------------
-    // ------------
-    // into this
-    //    -------------
-    // ----------------
-    
-    bool step2HasChanges = false;
+};
 
-    do
+template <typename Sort>
+static Array<Note> getSortedSelectedNotes(const Lasso &selection)
+{
+    Array<Note> notes;
+    notes.ensureStorageAllocated(selection.getNumSelected());
+    for (int i = 0; i < selection.getNumSelected(); ++i)
     {
-        PianoChangeGroup group2Before, group2After;
-        
-        for (int i = 0; i < selection.getNumSelected(); ++i)
-        {
-            const auto *nc = static_cast<NoteComponent *>(selection.getSelectedItem(i));
-            
-            // для каждой ноты найти ноту, которая полностью перекрывает ее на максимальную длину
-            
-            float deltaBeats = -FLT_MAX;
-            const NoteComponent *overlappingNote = nullptr;
-            
-            for (int j = 0; j < selection.getNumSelected(); ++j)
-            {
-                auto *nc2 = static_cast<NoteComponent *>(selection.getSelectedItem(j));
-                
-                if (nc->getKey() == nc2->getKey() &&
-                    nc->getBeat() > nc2->getBeat() &&
-                    nc->getBeat() < (nc2->getBeat() + nc2->getLength()) &&
-                    (nc->getBeat() + nc->getLength()) > (nc2->getBeat() + nc2->getLength()))
-                {
-                    const float currentDelta = (nc->getBeat() + nc->getLength()) - (nc2->getBeat() + nc2->getLength());
-                    
-                    if (deltaBeats < currentDelta)
-                    {
-                        deltaBeats = currentDelta;
-                        overlappingNote = nc2;
-                    }
-                }
-            }
-            
-            if (overlappingNote != nullptr)
-            {
-                group2Before.add(overlappingNote->getNote());
-                group2After.add(overlappingNote->getNote().withDeltaLength(deltaBeats));
-            }
-        }
-        
-        step2HasChanges = applyPianoChanges(group2Before, group2After, didCheckpoint);
+        notes.add(selection.getItemAs<NoteComponent>(i)->getNote());
     }
-    while (step2HasChanges);
-    
-    
-    // 3 convert this
+
+    Sort sort;
+    notes.sort(sort, true);
+    return notes;
+}
+
+void SequencerOperations::cleanupOverlaps(Lasso &selection, bool shouldCheckpoint)
+{
+    if (selection.getNumSelected() < 2)
+    {
+        return;
+    }
+
+    bool didCheckpoint = !shouldCheckpoint;
+    const auto notes = getSortedSelectedNotes<NotesByKeyAndBeatSort>(selection);
+
+    // the overlapping notes of the same key form a cluster,
+    // which is cleaned up by making each note end where the next one starts,
+    // and stretching the last one to the end of the cluster, e.g. convert this
     // ------------       ---------
-    //    ---------    ------------
+    //    ------       ------------
     // into this
     // ---                ---------
-    //    ---------    ---         
-    
-    bool step3HasChanges = false;
+    //    ---------    ---
 
-    do
+    PianoChangeGroup groupBefore, groupAfter, removalGroup;
+
+    int clusterStart = 0;
+    while (clusterStart < notes.size())
     {
-        PianoChangeGroup group3Before, group3After;
-        
-        for (int i = 0; i < selection.getNumSelected(); ++i)
+        const auto &firstNote = notes.getReference(clusterStart);
+        float clusterEndBeat = firstNote.getBeat() + firstNote.getLength();
+
+        int clusterEnd = clusterStart + 1;
+        while (clusterEnd < notes.size() &&
+            notes.getReference(clusterEnd).getKey() == firstNote.getKey() &&
+            notes.getReference(clusterEnd).getBeat() < clusterEndBeat)
         {
-            const auto *nc = static_cast<NoteComponent *>(selection.getSelectedItem(i));
-            
-            // для каждой ноты найти ноту, которая перекрывает ее максимально
-            
-            float overlappingBeats = -FLT_MAX;
-            const NoteComponent *overlappingNote = nullptr;
-            
-            for (int j = 0; j < selection.getNumSelected(); ++j)
-            {
-                auto *nc2 = static_cast<NoteComponent *>(selection.getSelectedItem(j));
-                
-                if (nc->getKey() == nc2->getKey() &&
-                    nc->getBeat() < nc2->getBeat() &&
-                    (nc->getBeat() + nc->getLength()) >= (nc2->getBeat() + nc2->getLength()))
-                {
-                    // >0 : has overlap
-                    const float overlapsWith = (nc->getBeat() + nc->getLength()) - nc2->getBeat();
-                    
-                    if (overlapsWith > overlappingBeats)
-                    {
-                        overlappingBeats = overlapsWith;
-                        overlappingNote = nc2;
-                    }
-                }
-            }
-            
-            if (overlappingNote != nullptr)
-            {
-                const float newLength = nc->getLength() - overlappingBeats;
-                group3Before.add(nc->getNote());
-                group3After.add(nc->getNote().withLength(newLength));
-            }
+            const auto &note = notes.getReference(clusterEnd);
+            clusterEndBeat = jmax(clusterEndBeat, note.getBeat() + note.getLength());
+            clusterEnd++;
         }
-        
-        step3HasChanges = applyPianoChanges(group3Before, group3After, didCheckpoint);
-    }
-    while (step3HasChanges);
-    
-    
-    // remove duplicates
-    
-    FlatHashMap<MidiEvent::Id, Note> deferredRemoval;
-    FlatHashMap<MidiEvent::Id, Note> unremovableNotes;
-    
-    for (int i = 0; i < selection.getNumSelected(); ++i)
-    {
-        const auto *nc = static_cast<NoteComponent *>(selection.getSelectedItem(i));
-        
-        for (int j = 0; j < selection.getNumSelected(); ++j)
+
+        for (int i = clusterStart; i < clusterEnd; ++i)
         {
-            if (i == j)
+            const auto &note = notes.getReference(i);
+            const bool isLastNote = (i == clusterEnd - 1);
+
+            // the notes starting from the same beat are duplicates,
+            // only the longest one of them (the last after sorting) stays
+            if (! isLastNote && notes.getReference(i + 1).getBeat() == note.getBeat())
             {
+                removalGroup.add(note);
                 continue;
             }
-            
-            const auto *nc2 = static_cast<NoteComponent *>(selection.getSelectedItem(j));
-            
-            // full overlap
-            //const bool isOverlappingNote = (nc->getKey() == nc2->getKey() &&
-            //                                nc->getBeat() >= nc2->getBeat() &&
-            //                                (nc->getBeat() + nc->getLength()) <= (nc2->getBeat() + nc2->getLength()));
-
-            // partial overlaps also
-            const bool isOverlappingNote = (nc->getKey() == nc2->getKey() &&
-                                            nc->getBeat() >= nc2->getBeat() &&
-                                            nc->getBeat() < (nc2->getBeat() + nc2->getLength()));
-            
-            const bool startsFromTheSameBeat = (nc->getKey() == nc2->getKey() &&
-                                                nc->getBeat() == nc2->getBeat());
-            
-            const bool isOriginalNote = unremovableNotes.contains(nc2->getNote().getId());
-            
-            if (! isOriginalNote &&
-                (isOverlappingNote || startsFromTheSameBeat))
+
+            const float newEndBeat = isLastNote ?
+                clusterEndBeat : notes.getReference(i + 1).getBeat();
+
+            if (newEndBeat != note.getBeat() + note.getLength())
             {
-                unremovableNotes[nc->getNote().getId()] = nc->getNote();
-                deferredRemoval[nc2->getNote().getId()] = nc2->getNote();
+                groupBefore.add(note);
+                groupAfter.add(note.withLength(newEndBeat - note.getBeat()));
             }
         }
-    }
-    
-    PianoChangeGroup removalGroup;
-    for (const auto &deferredRemovalIterator : deferredRemoval)
-    {
-        removalGroup.add(deferredRemovalIterator.second);
+
+        clusterStart = clusterEnd;
     }
 
+    applyPianoChanges(groupBefore, groupAfter, didCheckpoint);
     applyPianoRemovals(removalGroup, didCheckpoint);
 }
 
@@ -933,50 +841,33 @@ void SequencerOperations::removeDuplicates(Lasso &selection, bool shouldCheckpoi
 {
     if (selection.getNumSelected() == 0)
     { return; }
-    
-    FlatHashMap<MidiEvent::Id, Note> deferredRemoval;
-    FlatHashMap<MidiEvent::Id, Note> unremovableNotes;
-    
-    bool didCheckpoint = !shouldCheckpoint;
 
-    for (int i = 0; i < selection.getNumSelected(); ++i)
-    {
-        NoteComponent *nc = static_cast<NoteComponent *>(selection.getSelectedItem(i));
-        
-        for (int j = 0; j < selection.getNumSelected(); ++j)
-        {
-            if (i == j)
-            {
-                continue;
-            }
-            
-            NoteComponent *nc2 = static_cast<NoteComponent *>(selection.getSelectedItem(j));
-            
-            // full overlap
-            const bool isOverlappingNote = (nc->getKey() == nc2->getKey() &&
-                                            nc->getBeat() >= nc2->getBeat() &&
-                                            (nc->getBeat() + nc->getLength()) <= (nc2->getBeat() + nc2->getLength()));
+    bool didCheckpoint = !shouldCheckpoint;
 
-            const bool startsFromTheSameBeat = (nc->getKey() == nc2->getKey() &&
-                                                nc->getBeat() == nc2->getBeat());
-            
-            const bool isOriginalNote = unremovableNotes.contains(nc2->getNote().getId());
+    // a note is a duplicate, if it fully overlaps some other note of the same key,
+    // or starts from the same beat and is not shorter; with the notes sorted
+    // by their end beats, the inner ones come first, so that a note overlaps
+    // one of the kept notes, if any of them starts after it, or at the same beat
+    const auto notes = getSortedSelectedNotes<NotesByKeyAndEndBeatSort>(selection);
 
-            if (! isOriginalNote &&
-                (isOverlappingNote || startsFromTheSameBeat))
-            {
-                unremovableNotes[nc->getNote().getId()] = nc->getNote();
-                deferredRemoval[nc2->getNote().getId()] = nc2->getNote();
-            }
-        }
-    }
-    
     PianoChangeGroup removalGroup;
-    for (const auto &deferredRemovalIterator : deferredRemoval)
+    float latestKeptBeat = 0.f;
+
+    for (int i = 0; i < notes.size(); ++i)
     {
-        removalGroup.add(deferredRemovalIterator.second);
+        const auto &note = notes.getReference(i);
+        const bool isNewKey = (i == 0 || notes.getReference(i - 1).getKey() != note.getKey());
+
+        if (! isNewKey && note.getBeat() <= latestKeptBeat)
+        {
+            removalGroup.add(note);
+        }
+        else
+        {
+            latestKeptBeat = isNewKey ? note.getBeat() : jmax(latestKeptBeat, note.getBeat());
+        }
     }
-    
+
     applyPianoRemovals(removalGroup, didCheckpoint);
 }
 
@@ -1065,6 +956,25 @@ bool SequencerOperations::arpeggiate(Lasso &selection,
     float durationMultiplier, float randomness,
     bool isReversed, bool isLimitedToChord,
     bool shouldCheckpoint)
+{
+    Array<Note> sortedRemovals;
+    Array<Note> insertions;
+
+    if (!SequencerOperations::makeArpeggiation(selection,
+        chordScale, chordRoot, arp, durationMultiplier, randomness,
+        isReversed, isLimitedToChord, sortedRemovals, insertions))
+    {
+        return false;
+    }
+
+    SequencerOperations::applyArpeggiation(sortedRemovals, insertions, shouldCheckpoint);
+    return true;
+}
+
+bool SequencerOperations::makeArpeggiation(const Lasso &selection,
+    const Scale::Ptr chordScale, Note::Key chordRoot, const Arpeggiator::Ptr arp,
+    float durationMultiplier, float randomness, bool isReversed, bool isLimitedToChord,
+    Array<Note> &sortedRemovals, Array<Note> &insertions)
 {
     if (selection.getNumSelected() == 0)
     {
@@ -1075,10 +985,9 @@ bool SequencerOperations::arpeggiate(Lasso &selection,
     {
         return false;
     }
-    
-    bool didCheckpoint = !shouldCheckpoint;
-    Array<Note> sortedRemovals;
-    Array<Note> insertions;
+
+    sortedRemovals.clearQuick();
+    insertions.clearQuick();
 
     // 1. sort selection
     for (int i = 0; i < selection.getNumSelected(); ++i)
@@ -1183,20 +1092,89 @@ bool SequencerOperations::arpeggiate(Lasso &selection,
         }
     }
 
+    return insertions.size() > 0;
+}
+
+void SequencerOperations::applyArpeggiation(const Array<Note> &removals,
+    const Array<Note> &insertions, bool shouldCheckpoint)
+{
+    if (removals.isEmpty())
+    {
+        return;
+    }
+
     // 4. remove selection and add result
-    auto *pianoSequence = getPianoSequence(selection);
+    auto *pianoSequence = static_cast<PianoSequence *>(removals.getFirst().getSequence());
     jassert(pianoSequence);
 
-    if (! didCheckpoint)
+    if (shouldCheckpoint)
     {
         pianoSequence->checkpoint();
-        didCheckpoint = true;
     }
 
-    pianoSequence->removeGroup(sortedRemovals, true);
-    pianoSequence->insertGroup(insertions, true);
- 
-    return true;
+    Array<Note> groupToRemove(removals);
+    Array<Note> groupToInsert(insertions);
+    pianoSequence->removeGroup(groupToRemove, true);
+    pianoSequence->insertGroup(groupToInsert, true);
+}
+
+bool SequencerOperations::makeTransform(const Lasso &selection, const Script &script,
+    TimeSignatureEvent &timeContext, KeySignatureEvent &keyContext,
+    Array<Note> &outGroupBefore, Array<Note> &outGroupAfter)
+{
+    outGroupBefore.clearQuick();
+    outGroupAfter.clearQuick();
+
+    Scripting::SelectionTransformExecutor executor;
+    return executor.execute(script, selection, timeContext, keyContext,
+        outGroupBefore, outGroupAfter);
+}
+
+void SequencerOperations::applyTransform(const Array<Note> &groupBefore,
+    const Array<Note> &groupAfter, bool shouldCheckpoint)
+{
+    jassert(groupBefore.size() == groupAfter.size());
+    if (groupBefore.isEmpty())
+    {
+        return;
+    }
+
+    struct SequenceChanges final
+    {
+        Array<Note::Id> ids;
+        PianoSequence::NotesState stateBefore;
+        PianoSequence::NotesState stateAfter;
+    };
+
+    // the undo stack keeps the parameters' arrays, not the notes' copies
+    FlatHashMap<PianoSequence *, SequenceChanges> changes;
+    for (int i = 0; i < groupBefore.size(); ++i)
+    {
+        const auto &before = groupBefore.getReference(i);
+        const auto &after = groupAfter.getReference(i);
+        auto &sequenceChanges = changes[static_cast<PianoSequence *>(before.getSequence())];
+
+        sequenceChanges.ids.add(before.getId());
+        sequenceChanges.stateBefore.beats.add(before.getBeat());
+        sequenceChanges.stateBefore.keys.add(before.getKey());
+        sequenceChanges.stateBefore.lengths.add(before.getLength());
+        sequenceChanges.stateBefore.velocities.add(before.getVelocity());
+        sequenceChanges.stateAfter.beats.add(after.getBeat());
+        sequenceChanges.stateAfter.keys.add(after.getKey());
+        sequenceChanges.stateAfter.lengths.add(after.getLength());
+        sequenceChanges.stateAfter.velocities.add(after.getVelocity());
+    }
+
+    if (shouldCheckpoint)
+    {
+        changes.begin()->first->checkpoint();
+    }
+
+    for (auto &it : changes)
+    {
+        it.first->changeGroup(it.second.ids,
+            it.second.stateBefore, it.second.stateAfter, true);
+    }
 }
 
 void SequencerOperations::randomizeVolume(Lasso &selection, float factor, bool shouldCheckpoint)
@@ -1407,13 +1385,17 @@ void SequencerOperations::copyToClipboard(Clipboard &clipboard, const Lasso &sel
         //trackRoot.setProperty(Serialization::Clipboard::trackType, todo, nullptr);
         //trackRoot.setProperty(Serialization::Clipboard::trackMetaInfo, todo, nullptr);
 
+        // the notes are packed into columns, like in the saved projects,
+        // so that copying large selections doesn't create a node per note
+        Array<const Note *> notes;
+
         // Just copy all events, no matter what type they are
         for (int i = 0; i < trackSelection->size(); ++i)
         {
             if (const NoteComponent *noteComponent =
                 dynamic_cast<NoteComponent *>(trackSelection->getUnchecked(i)))
             {
-                trackRoot.appendChild(noteComponent->getNote().serialize());
+                notes.add(&noteComponent->getNote());
                 firstBeat = jmin(firstBeat, noteComponent->getBeat());
             }
             else if (const ClipComponent *clipComponent =
@@ -1424,6 +1406,11 @@ void SequencerOperations::copyToClipboard(Clipboard &clipboard, const Lasso &sel
             }
         }
 
+        if (!notes.isEmpty())
+        {
+            trackRoot.appendChild(PianoSequence::packNotes(notes));
+        }
+
         tree.appendChild(trackRoot);
     }
 
@@ -1502,10 +1489,15 @@ void SequencerOperations::pasteFromClipboard(Clipboard &clipboard, ProjectNode &
         }
         else if (auto *pianoSequence = dynamic_cast<PianoSequence *>(selectedTrack->getSequence()))
         {
+            // reads both the packed columns and the per-note nodes
+            PianoSequence::ParsedNotes parsedNotes;
+            PianoSequence::parseNotes(layerElement, parsedNotes);
+
             Array<Note> pastedNotes;
-            forEachChildWithType(layerElement, noteElement, Serialization::Midi::note)
+            pastedNotes.ensureStorageAllocated(parsedNotes.notes.size());
+            for (const auto *event : parsedNotes.notes)
             {
-                const auto &n = Note(pianoSequence).withParameters(noteElement).copyWithNewId();
+                const auto &n = Note(pianoSequence, *static_cast<const Note *>(event)).copyWithNewId();
                 pastedNotes.add(n.withDeltaBeat(deltaBeat));
             }
 
@@ -1619,25 +1611,24 @@ void SequencerOperations::shiftKeyRelative(Lasso &selection,
         jassert(pianoSequence);
 
         const int numSelected = trackSelection->size();
-        PianoChangeGroup groupBefore, groupAfter;
+        Array<const Note *> notes;
+        notes.ensureStorageAllocated(numSelected);
         
         for (int i = 0; i < numSelected; ++i)
         {
             auto *nc = static_cast<NoteComponent *>(trackSelection->getUnchecked(i));
-            groupBefore.add(nc->getNote());
-            
-            Note newNote(nc->getNote().withDeltaKey(deltaKey));
-            groupAfter.add(newNote);
+            notes.add(&nc->getNote());
             
             if (transport != nullptr && numSelected < 8)
             {
+                const Note newNote(nc->getNote().withDeltaKey(deltaKey));
                 transport->previewMidiMessage(pianoSequence->getTrackId(),
                     MidiMessage::noteOn(newNote.getTrackChannel(),
                         newNote.getKey() + nc->getClip().getKey(), newNote.getVelocity()));
             }
         }
         
-        if (groupBefore.size() > 0)
+        if (notes.size() > 0)
         {
             if (! didCheckpoint)
             {
@@ -1646,7 +1637,9 @@ void SequencerOperations::shiftKeyRelative(Lasso &selection,
             }
         }
         
-        pianoSequence->changeGroup(groupBefore, groupAfter, true);
+        Note::Transform keyShift;
+        keyShift.deltaKey = deltaKey;
+        pianoSequence->transformGroup(notes, keyShift, true);
     }
 }
 
@@ -1668,24 +1661,24 @@ void SequencerOperations::shiftBeatRelative(Lasso &selection, float deltaBeat, b
         jassert(pianoLayer);
 
         const int numSelected = trackSelection->size();
-        PianoChangeGroup groupBefore, groupAfter;
+        Array<const Note *> notes;
+        notes.ensureStorageAllocated(numSelected);
         
         for (int i = 0; i < numSelected; ++i)
         {
             auto *nc = static_cast<NoteComponent *>(trackSelection->getUnchecked(i));
-            groupBefore.add(nc->getNote());
-            
-            Note newNote(nc->getNote().withDeltaBeat(deltaBeat));
-            groupAfter.add(newNote);
+            notes.add(&nc->getNote());
         }
         
-        if (groupBefore.size() > 0 && !didCheckpoint)
+        if (notes.size() > 0 && !didCheckpoint)
         {
             pianoLayer->checkpoint(transactionId);
             didCheckpoint = true;
         }
         
-        pianoLayer->changeGroup(groupBefore, groupAfter, true);
+        Note::Transform beatShift;
+        beatShift.deltaBeat = deltaBeat;
+        pianoLayer->transformGroup(notes, beatShift, true);
     }
 }
 
@@ -1869,12 +1862,27 @@ int SequencerOperations::findAbsoluteRootKey(const Scale::Ptr scale,
     return absRootKey;
 }
 
+// the in-scale index of each chromatic key of the period, or -1,
+// looked up once per rescale instead of searching the scale per note
+static Array<int> getScaleKeysTable(const Scale::Ptr scale)
+{
+    Array<int> table;
+    for (int i = 0; i < scale->getBasePeriod(); ++i)
+    {
+        table.add(scale->getScaleKey(i));
+    }
+
+    return table;
+}
+
 static inline void doRescaleLogic(PianoChangeGroup &groupBefore, PianoChangeGroup &groupAfter,
-    const Note &note, Note::Key keyOffset, Scale::Ptr scaleA, Scale::Ptr scaleB)
+    const Note &note, Note::Key keyOffset, const Array<int> &scaleKeysA,
+    Scale::Ptr scaleA, Scale::Ptr scaleB)
 {
     const auto noteKey = note.getKey() - keyOffset;
-    const auto periodNumber = noteKey / scaleA->getBasePeriod();
-    const auto inScaleKey = scaleA->getScaleKey(noteKey);
+    const auto period = scaleA->getBasePeriod();
+    const auto periodNumber = noteKey / period;
+    const auto inScaleKey = scaleKeysA.getUnchecked(((noteKey % period) + period) % period);
     if (inScaleKey >= 0)
     {
         const auto newChromaticKey = scaleB->getBasePeriod() * periodNumber
@@ -1896,12 +1904,14 @@ void SequencerOperations::rescale(Lasso &selection, Note::Key rootKey,
     auto *sequence = getPianoSequence(selection);
     jassert(sequence);
 
+    const auto scaleKeysA = getScaleKeysTable(scaleA);
+
     PianoChangeGroup groupBefore, groupAfter;
     for (int i = 0; i < selection.getNumSelected(); ++i)
     {
         const auto *nc = selection.getItemAs<NoteComponent>(i);
         // todo clip key offset?
-        doRescaleLogic(groupBefore, groupAfter, nc->getNote(), rootKey, scaleA, scaleB);
+        doRescaleLogic(groupBefore, groupAfter, nc->getNote(), rootKey, scaleKeysA, scaleA, scaleB);
     }
 
     if (groupBefore.size() == 0)
@@ -1924,16 +1934,21 @@ bool SequencerOperations::rescale(const ProjectNode &project, float startBeat, f
     bool didCheckpoint = !shouldCheckpoint;
 
     const auto pianoTracks = project.findChildrenOfType<PianoTrackNode>();
-    for (const auto *track : pianoTracks)
-    {
-        auto *sequence = static_cast<PianoSequence *>(track->getSequence());
+    const auto scaleKeysA = getScaleKeysTable(scaleA);
 
-        PianoChangeGroup groupBefore, groupAfter;
+    // the tracks are independent, so collect their changes in parallel,
+    // and then apply them here, in the tracks order
+    std::vector<TrackChanges> changesPerTrack(size_t(pianoTracks.size()));
+    App::Tasks().parallelFor(pianoTracks.size(), [&](int t)
+    {
+        const auto *track = pianoTracks.getUnchecked(t);
+        const auto *sequence = track->getSequence();
+        auto &changes = changesPerTrack[size_t(t)];
 
         // find events in between (only consider events of one clip!),
         // skipping clips of the same track if already processed any other:
 
-        FlatHashSet<MidiEvent::Id, StringHash> usedClips;
+        FlatHashSet<Clip::Id, StringHash> usedClips;
 
         for (int i = 0; i < sequence->size(); ++i)
         {
@@ -1946,18 +1961,25 @@ bool SequencerOperations::rescale(const ProjectNode &project, float startBeat, f
                         (note->getBeat() + clip->getBeat()) < endBeat)
                     {
                         const auto keyOffset = rootKey - clip->getKey();
-                        doRescaleLogic(groupBefore, groupAfter, *note, keyOffset, scaleA, scaleB);
+                        doRescaleLogic(changes.pianoBefore, changes.pianoAfter,
+                            *note, keyOffset, scaleKeysA, scaleA, scaleB);
                         usedClips.insert(clip->getId());
                     }
                 }
             }
         }
+    });
 
-        if (groupBefore.size() == 0)
+    for (int t = 0; t < pianoTracks.size(); ++t)
+    {
+        const auto &changes = changesPerTrack[size_t(t)];
+        if (changes.pianoBefore.size() == 0)
         {
             continue;
         }
 
+        auto *sequence = static_cast<PianoSequence *>(pianoTracks.getUnchecked(t)->getSequence());
+
         if (!didCheckpoint)
         {
             sequence->checkpoint();
@@ -1965,7 +1987,7 @@ bool SequencerOperations::rescale(const ProjectNode &project, float startBeat, f
         }
 
         hasMadeChanges = true;
-        sequence->changeGroup(groupBefore, groupAfter, true);
+        sequence->changeGroup(changes.pianoBefore, changes.pianoAfter, true);
     }
 
     return hasMadeChanges;
@@ -1981,39 +2003,12 @@ bool SequencerOperations::findHarmonicContext(const Lasso &selection, const Clip
 
     if (const auto *keySignatures = dynamic_cast<KeySignaturesSequence *>(keysTrack->getSequence()))
     {
-        if (keySignatures->size() == 0)
-        {
-            return false;
-        }
-
-        const KeySignatureEvent *context = nullptr;
-
-        for (int i = 0; i < keySignatures->size(); ++i)
-        {
-            const auto event = keySignatures->getUnchecked(i);
-            if (context == nullptr || event->getBeat() <= startBeat)
-            {
-                // Take the first one no matter where it resides;
-                // If event is still before the sequence start, update the context anyway:
-                context = static_cast<KeySignatureEvent *>(event);
-            }
-            else if (event->getBeat() > startBeat && event->getBeat() < endBeat)
-            {
-                // Harmonic context is already here and changes within a sequence:
-                return false;
-            }
-            else if (event->getBeat() >= endBeat)
-            {
-                // No need to look further
-                break;
-            }
-        }
-
-        if (context != nullptr)
+        // the first key signature applies before it as well, and if the context
+        // changes within a selection, there's no single harmonic context:
+        if (const auto *context = keySignatures->findHarmonicContext(startBeat, endBeat))
         {
-            // We've found the only context that doesn't change within a sequence:
-            outScale = context->getScale();
-            outRootKey = context->getRootKey();
+            outScale = context->scale;
+            outRootKey = context->rootKey;
             return true;
         }
     }
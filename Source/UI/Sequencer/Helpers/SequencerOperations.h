@@ -25,6 +25,9 @@ class MidiTrack;
 class Pattern;
 class Clipboard;
 class PianoSequence;
+class Script;
+class TimeSignatureEvent;
+class KeySignatureEvent;
 
 #include "Note.h"
 #include "Lasso.h"
@@ -64,6 +67,26 @@ struct SequencerOperations final
         bool reversed = false, bool limitToChord = false,
         bool shouldCheckpoint = true);
 
+    // the same as above, split into the two steps, so that the result can be
+    // previewed before applying it; the removals are the sorted selected notes
+    static bool makeArpeggiation(const Lasso &selection,
+        const Scale::Ptr chordScale, Note::Key chordRoot, const Arpeggiator::Ptr arp,
+        float durationMultiplier, float randomness, bool reversed, bool limitToChord,
+        Array<Note> &outRemovals, Array<Note> &outInsertions);
+
+    static void applyArpeggiation(const Array<Note> &removals,
+        const Array<Note> &insertions, bool shouldCheckpoint = true);
+
+    // runs the transform script over the whole selection at once, see
+    // SelectionTransformExecutor; split the same way, for the previews
+    static bool makeTransform(const Lasso &selection, const Script &script,
+        TimeSignatureEvent &timeContext, KeySignatureEvent &keyContext,
+        Array<Note> &outGroupBefore, Array<Note> &outGroupAfter);
+
+    // applies the changes as one compact group change per sequence
+    static void applyTransform(const Array<Note> &groupBefore,
+        const Array<Note> &groupAfter, bool shouldCheckpoint = true);
+
     static void randomizeVolume(Lasso &selection, float factor = 0.5f, bool shouldCheckpoint = true);
     static void fadeOutVolume(Lasso &selection, float factor = 0.5f, bool shouldCheckpoint = true);
 
@@ -0,0 +1,185 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+/*
+    A bucketed grid over beats and rows (keys in the piano roll,
+    tracks in the pattern roll), which helps the rolls to find
+    events in some area without iterating through all of them,
+    e.g. on every lasso drag update.
+
+    It stores the event keys rather than the components, so that
+    a stale entry can never point to a deleted component: the callers
+    look up the components by the found keys and check the exact bounds.
+    Beats and rows don't depend on zoom level, so nothing is re-indexed
+    on zooming, only when the events themselves change.
+*/
+
+template <typename Key, typename HashFn>
+class SpatialIndex final
+{
+public:
+
+    SpatialIndex(float beatsPerCell, int rowsPerCell) noexcept :
+        beatsPerCell(beatsPerCell),
+        rowsPerCell(rowsPerCell)
+    {
+        jassert(beatsPerCell > 0.f && rowsPerCell > 0);
+    }
+
+    void clear()
+    {
+        this->cells.clear();
+        this->items.clear();
+    }
+
+    // adds the item, or moves it, if it's already indexed
+    void set(const Key &key, float startBeat, float endBeat, int startRow, int endRow)
+    {
+        this->remove(key);
+
+        const auto range = this->getCellsRange(startBeat, endBeat, startRow, endRow);
+        for (int column = range.startColumn; column <= range.endColumn; ++column)
+        {
+            for (int row = range.startRow; row <= range.endRow; ++row)
+            {
+                this->cells[getCellKey(column, row)].add(key);
+            }
+        }
+
+        this->items[key] = range;
+    }
+
+    void remove(const Key &key)
+    {
+        const auto found = this->items.find(key);
+        if (found == this->items.end())
+        {
+            return;
+        }
+
+        const auto range = found->second;
+        this->items.erase(found);
+
+        for (int column = range.startColumn; column <= range.endColumn; ++column)
+        {
+            for (int row = range.startRow; row <= range.endRow; ++row)
+            {
+                const auto cell = this->cells.find(getCellKey(column, row));
+                if (cell != this->cells.end())
+                {
+                    cell.value().removeFirstMatchingValue(key);
+                    if (cell->second.isEmpty())
+                    {
+                        this->cells.erase(cell);
+                    }
+                }
+            }
+        }
+    }
+
+    // calls back once for each item which cells intersect the given area;
+    // the items may still be outside of it, so the caller checks the bounds
+    template <typename Callback>
+    void findItemsNear(float startBeat, float endBeat,
+        int startRow, int endRow, const Callback &callback) const
+    {
+        const auto area = this->getCellsRange(startBeat, endBeat, startRow, endRow);
+        const auto numAreaCells = int64(area.endColumn - area.startColumn + 1) *
+            int64(area.endRow - area.startRow + 1);
+
+        // when zoomed out, the area may be way larger than the indexed content
+        if (numAreaCells > int64(this->cells.size()))
+        {
+            for (const auto &cell : this->cells)
+            {
+                const int column = int(cell.first >> 32);
+                const int row = int(int32(cell.first & 0xffffffff));
+                if (column >= area.startColumn && column <= area.endColumn &&
+                    row >= area.startRow && row <= area.endRow)
+                {
+                    this->reportCell(cell.second, column, row, area, callback);
+                }
+            }
+
+            return;
+        }
+
+        for (int column = area.startColumn; column <= area.endColumn; ++column)
+        {
+            for (int row = area.startRow; row <= area.endRow; ++row)
+            {
+                const auto cell = this->cells.find(getCellKey(column, row));
+                if (cell != this->cells.end())
+                {
+                    this->reportCell(cell->second, column, row, area, callback);
+                }
+            }
+        }
+    }
+
+private:
+
+    struct CellsRange final
+    {
+        int startColumn;
+        int endColumn;
+        int startRow;
+        int endRow;
+    };
+
+    CellsRange getCellsRange(float startBeat, float endBeat, int startRow, int endRow) const noexcept
+    {
+        return {
+            int(floorf(jmin(startBeat, endBeat) / this->beatsPerCell)),
+            int(floorf(jmax(startBeat, endBeat) / this->beatsPerCell)),
+            int(floorf(float(jmin(startRow, endRow)) / float(this->rowsPerCell))),
+            int(floorf(float(jmax(startRow, endRow)) / float(this->rowsPerCell)))
+        };
+    }
+
+    static inline int64 getCellKey(int column, int row) noexcept
+    {
+        return (int64(column) << 32) | int64(uint32(row));
+    }
+
+    // an item spanning several cells is only reported
+    // from the first of them which lies within the area
+    template <typename Callback>
+    void reportCell(const Array<Key> &keys, int column, int row,
+        const CellsRange &area, const Callback &callback) const
+    {
+        for (const auto &key : keys)
+        {
+            const auto &range = this->items.at(key);
+            if (column == jmax(range.startColumn, area.startColumn) &&
+                row == jmax(range.startRow, area.startRow))
+            {
+                callback(key);
+            }
+        }
+    }
+
+    const float beatsPerCell;
+    const int rowsPerCell;
+
+    FlatHashMap<int64, Array<Key>> cells;
+    FlatHashMap<Key, CellsRange, HashFn> items;
+
+    JUCE_DECLARE_NON_COPYABLE(SpatialIndex)
+};
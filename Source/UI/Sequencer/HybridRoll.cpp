@@ -47,6 +47,7 @@
 #include "Transport.h"
 #include "IconComponent.h"
 #include "PlayerThread.h"
+#include "RepaintSuspender.h"
 
 #include "ProjectTimeline.h"
 #include "AnnotationsSequence.h"
@@ -71,6 +72,7 @@
 
 #include "SerializationKeys.h"
 #include "ColourIDs.h"
+#include "UiProfiler.h"
 
 #include <limits.h>
 
@@ -80,6 +82,11 @@
 #   define ROLL_VIEW_FOLLOWS_PLAYHEAD 0
 #endif
 
+// the batch updates are flushed at most once per frame
+#define HYBRID_ROLL_BATCH_REPAINT_INTERVAL_MS (1000 / 60)
+#define HYBRID_ROLL_BULK_REPAINT_THRESHOLD 256
+#define HYBRID_ROLL_MAX_DIRTY_RECTANGLES 8
+
 HybridRoll::HybridRoll(ProjectNode &parentProject, Viewport &viewportRef,
     WeakReference<AudioMonitor> audioMonitor,
     bool hasAnnotationsTrack,
@@ -96,6 +103,9 @@ HybridRoll::HybridRoll(ProjectNode &parentProject, Viewport &viewportRef,
     this->setOpaque(true);
     this->setPaintingIsUnclipped(true);
 
+    this->repaintSuspender = new RepaintSuspender(*this);
+    this->setCachedComponentImage(this->repaintSuspender);
+
     this->setSize(this->viewport.getWidth(), this->viewport.getHeight());
 
     this->setMouseClickGrabsKeyboardFocus(false);
@@ -332,14 +342,51 @@ void HybridRoll::removeAllRollListeners()
 
 void HybridRoll::broadcastRollMoved()
 {
+    if (this->repaintSuspender->isSuspended())
+    {
+        this->hasSuspendedMovedNotification = true;
+        return;
+    }
+
     this->listeners.call(&HybridRollListener::onMidiRollMoved, this);
 }
 
 void HybridRoll::broadcastRollResized()
 {
+    if (this->repaintSuspender->isSuspended())
+    {
+        this->hasSuspendedResizedNotification = true;
+        return;
+    }
+
     this->listeners.call(&HybridRollListener::onMidiRollResized, this);
 }
 
+void HybridRoll::suspendRepaints()
+{
+    this->repaintSuspender->suspend();
+}
+
+void HybridRoll::resumeRepaints()
+{
+    if (!this->repaintSuspender->resume())
+    {
+        return;
+    }
+
+    if (this->hasSuspendedMovedNotification)
+    {
+        this->hasSuspendedMovedNotification = false;
+        this->broadcastRollMoved();
+    }
+
+    if (this->hasSuspendedResizedNotification)
+    {
+        this->hasSuspendedResizedNotification = false;
+        this->broadcastRollResized();
+    }
+}
+
 //===----------------------------------------------------------------------===//
 // Input Listeners
 //===----------------------------------------------------------------------===//
@@ -689,8 +736,44 @@ float HybridRoll::getMinVisibleBeatForCurrentZoomLevel() const
 #define MIN_BAR_WIDTH 14
 #define MIN_BEAT_WIDTH 8
 
+// how many screens of beat lines to compute ahead of and behind the scroll direction
+#define BEAT_LINES_LOOKAHEAD 2.f
+#define BEAT_LINES_LOOKBEHIND 0.5f
+
+void HybridRoll::resetVisibleBeatLines() noexcept
+{
+    this->beatLinesAreValid = false;
+}
+
 void HybridRoll::computeVisibleBeatLines()
 {
+    const float viewStartX = float(this->viewport.getViewPositionX());
+    const float viewWidth = float(this->viewport.getViewWidth());
+    const float viewEndX = viewStartX + viewWidth;
+
+    // most repaints, like scrolling or following the playhead,
+    // don't leave the range computed last time, so reuse it:
+    if (this->beatLinesAreValid &&
+        this->beatLinesBeatWidth == this->beatWidth &&
+        this->beatLinesFirstBeat == this->firstBeat &&
+        viewStartX >= this->beatLinesStartX &&
+        viewEndX <= this->beatLinesEndX)
+    {
+        return;
+    }
+
+    const bool scrollsLeft = this->beatLinesAreValid && viewStartX < this->beatLinesStartX;
+    const float rangeStartX = viewStartX -
+        viewWidth * (scrollsLeft ? BEAT_LINES_LOOKAHEAD : BEAT_LINES_LOOKBEHIND);
+    const float rangeEndX = viewEndX +
+        viewWidth * (scrollsLeft ? BEAT_LINES_LOOKBEHIND : BEAT_LINES_LOOKAHEAD);
+
+    this->beatLinesAreValid = true;
+    this->beatLinesBeatWidth = this->beatWidth;
+    this->beatLinesFirstBeat = this->firstBeat;
+    this->beatLinesStartX = rangeStartX;
+    this->beatLinesEndX = rangeEndX;
+
     this->visibleBars.clearQuick();
     this->visibleBeats.clearQuick();
     this->visibleSnaps.clearQuick();
@@ -700,9 +783,9 @@ void HybridRoll::computeVisibleBeatLines()
         this->project.getTimeline()->getTimeSignatures()->getSequence();
     
     const float zeroCanvasOffset = this->firstBeat * this->beatWidth; // usually a negative value
-    const float viewPosX = float(this->viewport.getViewPositionX());
+    const float viewPosX = rangeStartX;
     const float paintStartX = viewPosX + zeroCanvasOffset;
-    const float paintEndX = float(viewPosX + this->viewport.getViewWidth()) + zeroCanvasOffset;
+    const float paintEndX = rangeEndX + zeroCanvasOffset;
     
     const float barWidth = float(this->beatWidth * BEATS_PER_BAR);
     const float firstBar = this->firstBeat / float(BEATS_PER_BAR);
@@ -720,34 +803,28 @@ void HybridRoll::computeVisibleBeatLines()
     int denominator = TIME_SIGNATURE_DEFAULT_DENOMINATOR;
     float barIterator = firstBar;
     int nextTsIdx = 0;
-    bool firstEvent = true;
 
     // Find a time signature to start from (or use default values):
     // find a first time signature after a paint start and take a previous one, if any
-    for (; nextTsIdx < tsSequence->size(); ++nextTsIdx)
+    if (tsSequence->size() > 0)
     {
-        const auto *signature = static_cast<TimeSignatureEvent *>(tsSequence->getUnchecked(nextTsIdx));
-        const float signatureBar = (signature->getBeat() / BEATS_PER_BAR);
-
         // The very first event defines what's before it (both time signature and offset)
-        if (firstEvent)
+        const auto *firstSignature = static_cast<TimeSignatureEvent *>(tsSequence->getUnchecked(0));
+        const float firstSignatureBar = (firstSignature->getBeat() / BEATS_PER_BAR);
+        numerator = firstSignature->getNumerator();
+        denominator = firstSignature->getDenominator();
+        const float beatStep = 1.f / float(denominator);
+        const float barStep = beatStep * float(numerator);
+        barIterator += (fmodf(firstSignatureBar - firstBar, barStep) - barStep);
+
+        nextTsIdx = tsSequence->indexOfFirstEventAtOrAfter(paintStartBar * BEATS_PER_BAR);
+        if (nextTsIdx > 0)
         {
+            const auto *signature = static_cast<TimeSignatureEvent *>(tsSequence->getUnchecked(nextTsIdx - 1));
             numerator = signature->getNumerator();
             denominator = signature->getDenominator();
-            const float beatStep = 1.f / float(denominator);
-            const float barStep = beatStep * float(numerator);
-            barIterator += (fmodf(signatureBar - firstBar, barStep) - barStep);
-            firstEvent = false;
-        }
-
-        if (signatureBar >= paintStartBar)
-        {
-            break;
+            barIterator = (signature->getBeat() / BEATS_PER_BAR);
         }
-
-        numerator = signature->getNumerator();
-        denominator = signature->getDenominator();
-        barIterator = signatureBar;
     }
 
     // At this point we have barIterator pointing at the anchor,
@@ -941,6 +1018,7 @@ void HybridRoll::onChangeMidiEvent(const MidiEvent &event, const MidiEvent &newE
     // Time signatures have changed, need to repaint
     if (event.isTypeOf(MidiEvent::Type::TimeSignature))
     {
+        this->resetVisibleBeatLines();
         this->updateChildrenBounds();
         this->repaint();
     }
@@ -950,6 +1028,7 @@ void HybridRoll::onAddMidiEvent(const MidiEvent &event)
 {
     if (event.isTypeOf(MidiEvent::Type::TimeSignature))
     {
+        this->resetVisibleBeatLines();
         this->updateChildrenBounds();
         this->repaint();
     }
@@ -959,6 +1038,7 @@ void HybridRoll::onRemoveMidiEvent(const MidiEvent &event)
 {
     if (event.isTypeOf(MidiEvent::Type::TimeSignature))
     {
+        this->resetVisibleBeatLines();
         this->updateChildrenBounds();
         this->repaint();
     }
@@ -1215,6 +1295,12 @@ void HybridRoll::handleCommandMessage(int commandId)
 
         this->getTransport().stopSound();
         break;
+    case CommandIDs::TransportToggleMetronome:
+    {
+        auto &metronome = App::Workspace().getAudioCore().getMetronome();
+        metronome.setEnabled(!metronome.isEnabled());
+        break;
+    }
     case CommandIDs::VersionControlToggleQuickStash:
         if (auto *vcs = this->project.findChildOfType<VersionControlNode>())
         {
@@ -1260,33 +1346,52 @@ void HybridRoll::resized()
 
 void HybridRoll::paint(Graphics &g)
 {
+    UI_PROFILER_PAINT_SCOPE("HybridRoll", g);
+
     this->computeVisibleBeatLines();
 
-    const float y = float(this->viewport.getViewPositionY());
-    const float h = float(this->viewport.getViewHeight());
+    // the lines are computed for a wider range than the viewport,
+    // and the repainted area is often much smaller, e.g. a single note
+    const auto paintArea = g.getClipBounds().toFloat();
+    const float y = paintArea.getY();
+    const float h = paintArea.getHeight();
+    const float paintStartX = paintArea.getX() - 1.f;
+    const float paintEndX = paintArea.getRight();
 
     g.setColour(this->barLineColour);
     for (const auto &f : this->visibleBars)
     {
-        g.fillRect(floorf(f), y, 1.f, h);
+        if (f >= paintStartX && f < paintEndX)
+        {
+            g.fillRect(floorf(f), y, 1.f, h);
+        }
     }
 
     g.setColour(this->barLineBevelColour);
     for (const auto &f : this->visibleBars)
     {
-        g.fillRect(floorf(f + 1.f), y, 1.f, h);
+        if (f >= paintStartX - 1.f && f < paintEndX)
+        {
+            g.fillRect(floorf(f + 1.f), y, 1.f, h);
+        }
     }
 
     g.setColour(this->beatLineColour);
     for (const auto &f : this->visibleBeats)
     {
-        g.fillRect(floorf(f), y, 1.f, h);
+        if (f >= paintStartX && f < paintEndX)
+        {
+            g.fillRect(floorf(f), y, 1.f, h);
+        }
     }
     
     g.setColour(this->snapLineColour);
     for (const auto &f : this->visibleSnaps)
     {
-        g.fillRect(floorf(f), y, 1.f, h);
+        if (f >= paintStartX && f < paintEndX)
+        {
+            g.fillRect(floorf(f), y, 1.f, h);
+        }
     }
 }
 
@@ -1425,7 +1530,7 @@ void HybridRoll::stopFollowingPlayhead()
     }
 
 #if ROLL_VIEW_FOLLOWS_PLAYHEAD
-    this->stopTimer();
+    this->stopAnimating();
     this->shouldFollowPlayhead = false;
 #endif
 }
@@ -1434,7 +1539,7 @@ void HybridRoll::scrollToSeekPosition()
 {
 #if ROLL_VIEW_FOLLOWS_PLAYHEAD
     this->startFollowingPlayhead();
-    this->startTimer(7);
+    this->startAnimating();
 #else
     const int playheadX = this->getXPositionByTransportPosition(this->lastTransportPosition.get(), float(this->getWidth()));
     this->viewport.setViewPosition(playheadX - (this->viewport.getViewWidth() / 3), this->viewport.getViewPositionY());
@@ -1451,28 +1556,14 @@ void HybridRoll::handleAsyncUpdate()
     // batch repaint & resize stuff
     if (this->batchRepaintList.size() > 0)
     {
-        HYBRID_ROLL_BULK_REPAINT_START
-
-        for (int i = 0; i < this->batchRepaintList.size(); ++i)
-        {
-            // There are still many cases when a scheduled component is deleted at this time:
-            if (FloatBoundsComponent *component = this->batchRepaintList.getUnchecked(i))
-            {
-                const Rectangle<float> nb(this->getEventBounds(component));
-                component->setFloatBounds(nb);
-                component->repaint();
-            }
-        }
-
-        HYBRID_ROLL_BULK_REPAINT_END
-
-        this->batchRepaintList.clearQuick();
+        this->flushBatchRepaints();
     }
 
 #if ROLL_VIEW_FOLLOWS_PLAYHEAD
     if (this->shouldFollowPlayhead && !this->smoothZoomController->isZooming())
     {
-        const int playheadX = this->getXPositionByTransportPosition(this->lastTransportPosition.get(), float(this->getWidth()));
+        const int playheadX = this->getXPositionByTransportPosition(
+            this->getTransport().getPlaybackPosition(), float(this->getWidth()));
 
         if (fabs(this->playheadOffset) > 1.0)
         {
@@ -1493,30 +1584,126 @@ void HybridRoll::handleAsyncUpdate()
 
 double HybridRoll::findPlayheadOffsetFromViewCentre() const
 {
-    const int playheadX = this->getXPositionByTransportPosition(this->lastTransportPosition.get(), float(this->getWidth()));
+    const int playheadX = this->getXPositionByTransportPosition(
+        this->getTransport().getPlaybackPosition(), float(this->getWidth()));
     const int viewportCentreX = this->viewport.getViewPositionX() + this->viewport.getViewWidth() / 2;
     return double(playheadX) - double(viewportCentreX);
 }
 
 void HybridRoll::triggerBatchRepaintFor(FloatBoundsComponent *target)
 {
+    if (target == nullptr || target->hasPendingBatchRepaint)
+    {
+        return;
+    }
+
+    target->hasPendingBatchRepaint = true;
     this->batchRepaintList.add(target);
-    this->triggerAsyncUpdate();
+    this->scheduleBatchRepaint();
+}
+
+void HybridRoll::scheduleBatchRepaint()
+{
+    if (this->batchRepaintIsScheduled)
+    {
+        return;
+    }
+
+    this->batchRepaintIsScheduled = true;
+
+    const auto msSinceLastFlush = Time::getMillisecondCounter() - this->lastBatchRepaintTime;
+    if (msSinceLastFlush >= uint32(HYBRID_ROLL_BATCH_REPAINT_INTERVAL_MS))
+    {
+        this->triggerAsyncUpdate();
+        return;
+    }
+
+    // too early, e.g. mouse drag events may come way more often than frames
+    Component::SafePointer<HybridRoll> roll(this);
+    Timer::callAfterDelay(int(HYBRID_ROLL_BATCH_REPAINT_INTERVAL_MS - msSinceLastFlush), [roll]()
+    {
+        if (roll != nullptr)
+        {
+            roll->triggerAsyncUpdate();
+        }
+    });
+}
+
+void HybridRoll::flushBatchRepaints()
+{
+    this->batchRepaintIsScheduled = false;
+    this->lastBatchRepaintTime = Time::getMillisecondCounter();
+
+    // when too many components have changed at once, it's cheaper
+    // to let them all move silently and invalidate their union once
+    const bool isBulkUpdate = this->batchRepaintList.size() > HYBRID_ROLL_BULK_REPAINT_THRESHOLD;
+
+    if (isBulkUpdate)
+    {
+        HYBRID_ROLL_BULK_REPAINT_START
+    }
+
+    RectangleList<int> dirtyArea;
+
+    for (int i = 0; i < this->batchRepaintList.size(); ++i)
+    {
+        // There are still many cases when a scheduled component is deleted at this time:
+        if (FloatBoundsComponent *component = this->batchRepaintList.getUnchecked(i))
+        {
+            component->hasPendingBatchRepaint = false;
+
+            const auto oldBounds = component->getBounds();
+            component->setFloatBounds(this->getEventBounds(component));
+
+            // the moved components have just repainted their areas themselves,
+            // and the rest only need their content redrawn
+            if (isBulkUpdate || !component->isVisible() || component->getBounds() != oldBounds)
+            {
+                continue;
+            }
+
+            if (component->getParentComponent() == this)
+            {
+                dirtyArea.addWithoutMerging(oldBounds);
+            }
+            else
+            {
+                component->repaint();
+            }
+        }
+    }
+
+    this->batchRepaintList.clearQuick();
+
+    if (isBulkUpdate)
+    {
+        HYBRID_ROLL_BULK_REPAINT_END
+        return;
+    }
+
+    dirtyArea.consolidate();
+    if (dirtyArea.getNumRectangles() > HYBRID_ROLL_MAX_DIRTY_RECTANGLES)
+    {
+        this->repaint(dirtyArea.getBounds());
+        return;
+    }
+
+    for (const auto &area : dirtyArea)
+    {
+        this->repaint(area);
+    }
 }
 
 //===----------------------------------------------------------------------===//
-// Timer
+// AnimationClock::Listener
 //===----------------------------------------------------------------------===//
 
-void HybridRoll::hiResTimerCallback()
+// the scrolling to the playhead is ticked in the same frames as the playhead itself
+void HybridRoll::onAnimationFrame()
 {
     if (fabs(this->playheadOffset) < 0.1)
     {
-        MessageManagerLock lock(Thread::getCurrentThread());
-        if (lock.lockWasGained())
-        {
-            this->stopFollowingPlayhead();
-        }
+        this->stopFollowingPlayhead();
     }
 
     this->triggerAsyncUpdate();
@@ -31,12 +31,14 @@ class AutomationStepsSequenceMap;
 class Transport;
 class HybridRollListener;
 class TimelineWarningMarker;
+struct RepaintSuspender;
 
 #include "ComponentFader.h"
 #include "AnnotationsProjectMap.h"
 #include "TimeSignaturesProjectMap.h"
 #include "KeySignaturesProjectMap.h"
 #include "Playhead.h"
+#include "AnimationClock.h"
 #include "TransportListener.h"
 #include "MidiEventComponent.h"
 #include "LongTapListener.h"
@@ -59,10 +61,10 @@ class TimelineWarningMarker;
 #define HYBRID_ROLL_HEADER_SHADOW_SIZE (16)
 
 #define HYBRID_ROLL_BULK_REPAINT_START \
-    if (this->isEnabled()) { this->setVisible(false); }
+    this->suspendRepaints();
 
 #define HYBRID_ROLL_BULK_REPAINT_END \
-    if (this->isEnabled()) { this->setVisible(true); }
+    this->resumeRepaints();
 
 class HybridRoll :
     public Component,
@@ -77,7 +79,7 @@ class HybridRoll :
     protected ChangeListener, // listens to HybridRollEditMode,
     protected TransportListener, // for positioning the playhead component and auto-scrolling
     protected AsyncUpdater, // coalesce multiple transport events ^^ into a single async view change
-    protected HighResolutionTimer, // for smooth scrolling to seek position
+    protected AnimationClock::Listener, // for smooth scrolling to seek position
     protected Playhead::Listener, // for smooth scrolling to seek position
     protected AudioMonitor::ClippingListener // for displaying clipping indicator components
 {
@@ -259,6 +261,16 @@ protected:
     
     void broadcastRollMoved();
     void broadcastRollResized();
+
+    // Bulk updates suspend all repaints of the roll and its children,
+    // and the roll's moved/resized notifications, until the outermost
+    // of them ends, which invalidates the dirty area once
+    void suspendRepaints();
+    void resumeRepaints();
+
+    RepaintSuspender *repaintSuspender = nullptr; // owned by the component
+    bool hasSuspendedMovedNotification = false;
+    bool hasSuspendedResizedNotification = false;
     
 protected:
     
@@ -305,10 +317,10 @@ protected:
     friend class HybridRollHeader;
     
     //===------------------------------------------------------------------===//
-    // Timer
+    // AnimationClock::Listener
     //===------------------------------------------------------------------===//
 
-    void hiResTimerCallback() override;
+    void onAnimationFrame() override;
     
 protected:
     
@@ -402,6 +414,15 @@ protected:
 
     void computeVisibleBeatLines();
 
+    // the lines above are kept for a range around the viewport,
+    // until it's scrolled out of it, or zoom or time signatures change
+    void resetVisibleBeatLines() noexcept;
+    bool beatLinesAreValid = false;
+    float beatLinesBeatWidth = 0.f;
+    float beatLinesFirstBeat = 0.f;
+    float beatLinesStartX = 0.f;
+    float beatLinesEndX = 0.f;
+
 protected:
 
     UniquePointer<LongTapController> longTapController;
@@ -409,7 +430,13 @@ protected:
     UniquePointer<SmoothPanController> smoothPanController;
     UniquePointer<SmoothZoomController> smoothZoomController;
 
+    // the components are updated at most once per frame, and
+    // their repaints are merged into a few dirty rectangles
     Array<SafePointer<FloatBoundsComponent>> batchRepaintList;
+    bool batchRepaintIsScheduled = false;
+    uint32 lastBatchRepaintTime = 0;
+    void scheduleBatchRepaint();
+    void flushBatchRepaints();
 
 protected:
     
@@ -22,32 +22,36 @@ Lasso::Lasso() :
     SelectedItemSet(),
     random(Time::currentTimeMillis())
 {
-    this->invalidateCacheAndResetId();
+    this->resetId();
 }
 
 Lasso::Lasso(const ItemArray &items) :
     SelectedItemSet(items),
     random(Time::currentTimeMillis())
 {
-    this->invalidateCacheAndResetId();
+    this->resetId();
+    this->rebuildGroupedSelections();
 }
 
 Lasso::Lasso(const SelectedItemSet &other) :
     SelectedItemSet(other),
     random(Time::currentTimeMillis())
 {
-    this->invalidateCacheAndResetId();
+    this->resetId();
+    this->rebuildGroupedSelections();
 }
 
 void Lasso::itemSelected(SelectableComponent *item)
 {
-    this->invalidateCacheAndResetId();
+    this->resetId();
+    this->addToGroupedSelections(item);
     item->setSelected(true);
 }
 
 void Lasso::itemDeselected(SelectableComponent *item)
 {
-    this->invalidateCacheAndResetId();
+    this->resetId();
+    this->removeFromGroupedSelections(item);
     item->setSelected(false);
 }
 
@@ -66,20 +70,14 @@ Rectangle<int> Lasso::getSelectionBounds() const noexcept
     return this->bounds;
 }
 
-void Lasso::invalidateCacheAndResetId()
+void Lasso::resetId()
 {
     this->id = this->random.nextInt64();
-    this->selectionsCache.clear();
 }
 
 const Lasso::GroupedSelections &Lasso::getGroupedSelections() const
 {
-    if (this->selectionsCache.size() == 0)
-    {
-        this->rebuildCache();
-    }
-
-    return this->selectionsCache;
+    return this->groupedSelections;
 }
 
 bool Lasso::shouldDisplayGhostNotes() const noexcept
@@ -92,25 +90,64 @@ int64 Lasso::getId() const noexcept
     return this->id;
 }
 
-void Lasso::rebuildCache() const
+// someone may still hold a group while iterating it,
+// and then the selection changes, e.g. when the events are deleted:
+// in this case, the group is copied and the holder keeps the old one
+static void detachIfShared(SelectionProxyArray::Ptr &group)
 {
-    for (int i = 0; i < this->getNumSelected(); ++i)
+    if (group == nullptr)
     {
-        SelectableComponent *item = this->getSelectedItem(i);
-        const String &groupId(item->getSelectionGroupId());
+        group = new SelectionProxyArray();
+    }
+    else if (group->getReferenceCount() > 1)
+    {
+        SelectionProxyArray::Ptr copy(new SelectionProxyArray());
+        copy->addArray(*group);
+        group = copy;
+    }
+}
 
-        SelectionProxyArray::Ptr targetArray;
+void Lasso::addToGroupedSelections(SelectableComponent *item)
+{
+    auto &group = this->groupedSelections[item->getSelectionGroupId()];
+    detachIfShared(group);
+    group->add(item);
+}
 
-        if (this->selectionsCache.contains(groupId))
-        {
-            targetArray = this->selectionsCache[groupId];
-        }
-        else
+void Lasso::removeFromGroupedSelections(SelectableComponent *item)
+{
+    const auto found = this->groupedSelections.find(item->getSelectionGroupId());
+    if (found == this->groupedSelections.end())
+    {
+        jassertfalse;
+        return;
+    }
+
+    // deselectAll() goes from the last item to the first one,
+    // so searching backwards usually finds the item immediately
+    auto &group = found.value();
+    detachIfShared(group);
+    for (int i = group->size(); --i >= 0;)
+    {
+        if (group->getUnchecked(i) == item)
         {
-            targetArray = new SelectionProxyArray();
+            group->remove(i);
+            break;
         }
+    }
 
-        targetArray->add(item);
-        this->selectionsCache[groupId] = targetArray;
+    if (group->isEmpty())
+    {
+        this->groupedSelections.erase(found);
+    }
+}
+
+void Lasso::rebuildGroupedSelections()
+{
+    this->groupedSelections.clear();
+
+    for (int i = 0; i < this->getNumSelected(); ++i)
+    {
+        this->addToGroupedSelections(this->getSelectedItem(i));
     }
 }
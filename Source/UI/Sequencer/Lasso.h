@@ -102,9 +102,15 @@ private:
     mutable int64 id;
     mutable Random random;
 
-    mutable GroupedSelections selectionsCache;
-    void invalidateCacheAndResetId();
-    void rebuildCache() const;
+    // the grouped selections are kept up to date on every change,
+    // instead of being rebuilt on the first access after each change,
+    // e.g. lasso dragging selects and deselects the items one by one
+    GroupedSelections groupedSelections;
+    void addToGroupedSelections(SelectableComponent *item);
+    void removeFromGroupedSelections(SelectableComponent *item);
+    void rebuildGroupedSelections();
+
+    void resetId();
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Lasso)
     JUCE_DECLARE_WEAK_REFERENCEABLE(Lasso)
@@ -37,7 +37,9 @@ public:
     void setGhostMode();
 
     virtual float getBeat() const noexcept = 0;
-    virtual const String &getId() const noexcept = 0;
+    // the tie-breaker for the events at the same beat,
+    // always called for the components of the same kind
+    virtual int compareIds(const MidiEventComponent &other) const noexcept = 0;
     virtual void updateColours() = 0;
 
     //===------------------------------------------------------------------===//
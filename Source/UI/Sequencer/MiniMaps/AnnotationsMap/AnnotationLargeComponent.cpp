@@ -98,6 +98,17 @@ void AnnotationLargeComponent::paint (Graphics& g)
         const Font labelFont(16.00f, Font::plain);
         g.setColour(this->event.getTrackColour().interpolatedWith(baseColour, 0.55f).withAlpha(0.9f));
 
+        const Rectangle<float> textArea(2.f + this->boundsOffset.getX(), 1.f,
+            float(this->getWidth()) - 16.f, float(this->getHeight()) - 8.f);
+
+        // the most common case, a short mark which fits in one line, is just a blit
+        if (this->textWidth <= textArea.getWidth())
+        {
+            this->textSprites->drawText(g, this->event.getDescription(),
+                labelFont, textArea, Justification::centredLeft);
+            return;
+        }
+
         GlyphArrangement arr;
         arr.addFittedText(labelFont,
                           this->event.getDescription(),
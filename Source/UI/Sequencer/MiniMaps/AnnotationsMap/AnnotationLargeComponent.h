@@ -19,6 +19,7 @@
 
 //[Headers]
 #include "AnnotationComponent.h"
+#include "TextSprites.h"
 //[/Headers]
 
 
@@ -60,6 +61,8 @@ private:
     String text;
     float textWidth;
 
+    SharedResourcePointer<TextSprites> textSprites;
+
     // workaround странного поведения juce
     // возможна ситуация, когда mousedown'а не было, а mouseup срабатывает
     bool mouseDownWasTriggered;
@@ -33,155 +33,23 @@
 
 #define VELOCITY_MAP_LINE_EXTENT (1000)
 
-#define VELOCITY_MAP_BULK_REPAINT_START \
-    if (this->isEnabled()) { this->setVisible(false); }
+// the header line, by which a single note can be dragged
+#define VELOCITY_MAP_HEADER_HEIGHT (4.f)
 
-#define VELOCITY_MAP_BULK_REPAINT_END \
-    if (this->isEnabled()) { this->setVisible(true); }
-
-//===----------------------------------------------------------------------===//
-// Child level component
-//===----------------------------------------------------------------------===//
-
-class VelocityMapNoteComponent final : public Component
+static Colour getNoteColour(const Colour &trackColour, bool editable)
 {
-public:
-
-    VelocityMapNoteComponent(const Note &note, const Clip &clip) :
-        note(note),
-        clip(clip)
-    {
-        this->updateColour();
-        this->setInterceptsMouseClicks(true, false);
-        this->setMouseClickGrabsKeyboardFocus(false);
-        this->setPaintingIsUnclipped(true);
-        this->setMouseCursor(MouseCursor::UpDownResizeCursor);
-    }
-
-    inline float getBeat() const noexcept
-    {
-        return this->note.getBeat() + this->clip.getBeat();
-    }
-
-    inline float getLength() const noexcept
-    {
-        return this->note.getLength();
-    }
-
-    inline float getVelocity() const noexcept
-    {
-        return this->note.getVelocity() * this->clip.getVelocity();
-    }
-
-    Line<float> getStartLine() const noexcept
-    {
-        const float x = this->getX() + this->dx;
-        return { x, 0.f, x, VELOCITY_MAP_HEIGHT };
-    }
-
-    Line<float> getEndLine() const noexcept
-    {
-        const float x = this->getX() + this->dx + this->getWidth() + this->dw;
-        return{ x, 0.f, x, VELOCITY_MAP_HEIGHT };
-    }
-
-    inline void updateColour()
-    {
-        const Colour baseColour(findDefaultColour(ColourIDs::Roll::noteFill));
-        this->colour = this->note.getTrackColour().
-            interpolatedWith(baseColour, this->editable ? .4f : .55f).
-            withAlpha(this->editable ? 0.7f : .1f);
-    }
-
-    void setRealBounds(float x, int y, float w, int h) noexcept
-    {
-        this->dx = x - floorf(x);
-        this->dw = w - ceilf(w);
-        this->setBounds(int(floorf(x)), y, int(ceilf(w)), h);
-    }
-
-    bool isEditable() const noexcept
-    {
-        return this->editable;
-    }
-
-    void setEditable(bool editable)
-    {
-        if (this->editable == editable)
-        {
-            return;
-        }
-
-        this->editable = editable;
-
-        this->setEnabled(editable);
-        this->updateColour();
-
-        if (this->editable)
-        {
-            // toBack() and toFront() use indexOf(this) so calling them sucks
-            this->toFront(false);
-        }
-    }
-
-    //===------------------------------------------------------------------===//
-    // Component
-    //===------------------------------------------------------------------===//
-
-    void paint(Graphics &g) noexcept override
-    {
-        g.setColour(this->colour);
-        g.fillRect(this->dx, 0.f, float(this->getWidth()) + this->dw, float(this->getHeight()));
-        g.fillRect(this->dx, 0.f, float(this->getWidth()) + this->dw, 2.f);
-    }
-
-    bool hitTest(int, int y) noexcept override
-    {
-        // can be dragged individually by header line
-        return this->editable && y <= 4;
-    }
-
-    void mouseDown(const MouseEvent &e) override
-    {
-        if (e.mods.isLeftButtonDown())
-        {
-            this->note.getSequence()->checkpoint();
-            this->velocityAnchor = this->getVelocity();
-        }
-    }
-
-    void mouseDrag(const MouseEvent &e) override
-    {
-        const auto newVelocity = jlimit(0.f, 1.f,
-            this->velocityAnchor - float(e.getDistanceFromDragStartY()) / VELOCITY_MAP_HEIGHT);
-
-        static_cast<PianoSequence *>(this->note.getSequence())->
-            change(this->note, this->note.withVelocity(newVelocity), true);
-    }
-
-private:
-
-    friend class VelocityProjectMap;
-
-    VelocityProjectMap *getParentMap() const
-    {
-        jassert(this->getParentComponent());
-        return static_cast<VelocityProjectMap *>(this->getParentComponent());
-    }
-
-    const Note &note;
-    const Clip &clip;
-
-    Colour colour;
-
-    float dx = 0.f;
-    float dw = 0.f;
-
-    float velocityAnchor = 0.f;
-    bool editable = true;
+    const Colour baseColour(findDefaultColour(ColourIDs::Roll::noteFill));
+    return trackColour.
+        interpolatedWith(baseColour, editable ? .4f : .55f).
+        withAlpha(editable ? 0.7f : .1f);
+}
 
-    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(VelocityMapNoteComponent)
-};
+// at least 4 pixels are visible for 0 volume events
+static inline Rectangle<float> getNoteBar(float x, float w, float velocity, int height) noexcept
+{
+    const int h = jmax(4, int(height * velocity));
+    return { x, float(height - h), jmax(1.f, w), float(h) };
+}
 
 //===----------------------------------------------------------------------===//
 // Dragging helper
@@ -304,6 +172,7 @@ private:
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(VelocityLevelDraggingHelper);
 };
 
+
 //===----------------------------------------------------------------------===//
 // The map itself
 //===----------------------------------------------------------------------===//
@@ -312,7 +181,7 @@ VelocityProjectMap::VelocityProjectMap(ProjectNode &parentProject, HybridRoll &p
     project(parentProject),
     roll(parentRoll)
 {
-    this->setInterceptsMouseClicks(true, true);
+    this->setInterceptsMouseClicks(true, false);
     this->setPaintingIsUnclipped(true);
 
     this->volumeBlendingIndicator = makeUnique<FineTuningValueIndicator>(this->volumeBlendingAmount, "");
@@ -338,30 +207,234 @@ VelocityProjectMap::~VelocityProjectMap()
 
 void VelocityProjectMap::resized()
 {
-    VELOCITY_MAP_BULK_REPAINT_START
+    if (this->dragHelper != nullptr)
+    {
+        this->dragHelper->updateBounds();
+    }
+}
+
+void VelocityProjectMap::paint(Graphics &g)
+{
+    const float beatsPerPixel = this->getBeatsPerPixel();
+    if (beatsPerPixel <= 0.f)
+    {
+        return;
+    }
+
+    // only the notes within the repainted area are collected,
+    // filling all bars of a clip at once:
+    const auto paintArea = g.getClipBounds().toFloat();
+    const float paintStartBeat = this->rollFirstBeat + paintArea.getX() * beatsPerPixel;
+    const float paintEndBeat = this->rollFirstBeat + paintArea.getRight() * beatsPerPixel;
+
+    const int overviewLevel = NotesOverviewCache::getLevelFor(1.f / beatsPerPixel);
+    if (overviewLevel >= 0)
+    {
+        this->paintOverviews(g, overviewLevel, beatsPerPixel, paintStartBeat, paintEndBeat);
+        this->paintActiveClip(g, beatsPerPixel, paintStartBeat, paintEndBeat);
+        return;
+    }
+
+    RectangleList<float> bars;
+    RectangleList<float> tops;
 
     for (const auto &c : this->patternMap)
     {
-        const auto sequenceMap = c.second.get();
-        for (const auto &e : *sequenceMap)
+        const auto &clip = c.first;
+        if (clip == this->activeClip)
+        {
+            continue;
+        }
+
+        const auto *sequence = dynamic_cast<const PianoSequence *>(c.second.get());
+        if (sequence == nullptr)
+        {
+            continue;
+        }
+
+        const auto &notes = sequence->getPackedNotes();
+        const auto candidates = notes.getCandidatesInRange(paintStartBeat - clip.getBeat(),
+            paintEndBeat - clip.getBeat());
+
+        if (candidates.isEmpty())
+        {
+            continue;
+        }
+
+        bars.clear();
+        tops.clear();
+
+        const float beatOffset = clip.getBeat() - this->rollFirstBeat;
+        for (int i = candidates.getStart(); i < candidates.getEnd(); ++i)
+        {
+            const auto bar = getNoteBar((notes.beats.getUnchecked(i) + beatOffset) / beatsPerPixel,
+                notes.lengths.getUnchecked(i) / beatsPerPixel,
+                notes.velocities.getUnchecked(i) * clip.getVelocity(), this->getHeight());
+
+            bars.addWithoutMerging(bar);
+            tops.addWithoutMerging(bar.withHeight(2.f));
+        }
+
+        g.setColour(getNoteColour(clip.getTrackColour(), false));
+        g.fillRectList(bars);
+        g.fillRectList(tops);
+    }
+
+    this->paintActiveClip(g, beatsPerPixel, paintStartBeat, paintEndBeat);
+}
+
+void VelocityProjectMap::paintActiveClip(Graphics &g,
+    float beatsPerPixel, float paintStartBeat, float paintEndBeat)
+{
+    const auto *sequence = this->getActiveSequence();
+    if (sequence == nullptr)
+    {
+        return;
+    }
+
+    const auto &clip = this->activeClip;
+    const auto &notes = sequence->getPackedNotes();
+    const auto candidates = notes.getCandidatesInRange(paintStartBeat - clip.getBeat(),
+        paintEndBeat - clip.getBeat());
+
+    if (candidates.isEmpty())
+    {
+        return;
+    }
+
+    // the editable notes go in front of the rest
+    RectangleList<float> editableBars, editableTops;
+    RectangleList<float> otherBars, otherTops;
+
+    const float beatOffset = clip.getBeat() - this->rollFirstBeat;
+    for (int i = candidates.getStart(); i < candidates.getEnd(); ++i)
+    {
+        const auto bar = getNoteBar((notes.beats.getUnchecked(i) + beatOffset) / beatsPerPixel,
+            notes.lengths.getUnchecked(i) / beatsPerPixel,
+            notes.velocities.getUnchecked(i) * clip.getVelocity(), this->getHeight());
+
+        if (this->isNoteEditable(*notes.handles.getUnchecked(i)))
+        {
+            editableBars.addWithoutMerging(bar);
+            editableTops.addWithoutMerging(bar.withHeight(2.f));
+        }
+        else
         {
-            jassert(e.second.get());
-            this->applyNoteBounds(e.second.get());
+            otherBars.addWithoutMerging(bar);
+            otherTops.addWithoutMerging(bar.withHeight(2.f));
         }
     }
 
-    if (this->dragHelper != nullptr)
+    g.setColour(getNoteColour(clip.getTrackColour(), false));
+    g.fillRectList(otherBars);
+    g.fillRectList(otherTops);
+
+    g.setColour(getNoteColour(clip.getTrackColour(), true));
+    g.fillRectList(editableBars);
+    g.fillRectList(editableTops);
+}
+
+void VelocityProjectMap::paintOverviews(Graphics &g, int level,
+    float beatsPerPixel, float paintStartBeat, float paintEndBeat)
+{
+    RectangleList<float> bars;
+    RectangleList<float> tops;
+
+    for (const auto &c : this->patternMap)
     {
-        this->dragHelper->updateBounds();
+        const auto &clip = c.first;
+        if (clip == this->activeClip)
+        {
+            continue;
+        }
+
+        const auto *sequence = dynamic_cast<const PianoSequence *>(c.second.get());
+        if (sequence == nullptr)
+        {
+            continue;
+        }
+
+        const auto &profile = this->notesOverview.getVelocityProfile(*sequence, level);
+        const float startBeat = clip.getBeat() + profile.startBeat;
+        const int firstBucket = jmax(0,
+            int(floorf((paintStartBeat - startBeat) / profile.beatsPerBucket)));
+        const int lastBucket = jmin(profile.velocities.size() - 1,
+            int(ceilf((paintEndBeat - startBeat) / profile.beatsPerBucket)));
+
+        if (firstBucket > lastBucket)
+        {
+            continue;
+        }
+
+        bars.clear();
+        tops.clear();
+
+        const float bucketWidth = profile.beatsPerBucket / beatsPerPixel;
+        const float x = (startBeat - this->rollFirstBeat) / beatsPerPixel;
+
+        // the adjacent buckets of the same height are joined into one bar
+        Rectangle<float> bar;
+        for (int i = firstBucket; i <= lastBucket; ++i)
+        {
+            const float velocity = profile.velocities.getUnchecked(i);
+            if (velocity < 0.f)
+            {
+                continue;
+            }
+
+            const int h = jmax(4, int(this->getHeight() * velocity * clip.getVelocity()));
+            const Rectangle<float> next(x + i * bucketWidth,
+                float(this->getHeight() - h), bucketWidth, float(h));
+
+            if (!bar.isEmpty() && bar.getY() == next.getY() && bar.getRight() >= next.getX())
+            {
+                bar.setRight(next.getRight());
+                continue;
+            }
+
+            if (!bar.isEmpty())
+            {
+                bars.addWithoutMerging(bar);
+                tops.addWithoutMerging(bar.withHeight(2.f));
+            }
+
+            bar = next;
+        }
+
+        if (!bar.isEmpty())
+        {
+            bars.addWithoutMerging(bar);
+            tops.addWithoutMerging(bar.withHeight(2.f));
+        }
+
+        g.setColour(getNoteColour(clip.getTrackColour(), false));
+        g.fillRectList(bars);
+        g.fillRectList(tops);
     }
+}
 
-    VELOCITY_MAP_BULK_REPAINT_END
+void VelocityProjectMap::mouseMove(const MouseEvent &e)
+{
+    this->setMouseCursor(this->findEditableNoteHeaderAt(e.position) >= 0 ?
+        MouseCursor::UpDownResizeCursor : MouseCursor::NormalCursor);
 }
 
 void VelocityProjectMap::mouseDown(const MouseEvent &e)
 {
     if (e.mods.isLeftButtonDown())
     {
+        this->resetDragState();
+
+        const int headerIndex = this->findEditableNoteHeaderAt(e.position);
+        if (headerIndex >= 0)
+        {
+            const auto &notes = this->getActiveSequence()->getPackedNotes();
+            this->dragState.add(*notes.handles.getUnchecked(headerIndex));
+            this->noteHeaderDragAnchor = notes.velocities.getUnchecked(headerIndex) * this->activeClip.getVelocity();
+            this->isDraggingNoteHeader = true;
+            return;
+        }
+
         this->volumeBlendingIndicator->toFront(false);
         this->updateVolumeBlendingIndicator(e.getPosition());
 
@@ -372,14 +445,16 @@ void VelocityProjectMap::mouseDown(const MouseEvent &e)
     }
 }
 
-constexpr float getVelocityByIntersection(const Point<float> &intersection)
-{
-    return 1.f - (intersection.y / VELOCITY_MAP_HEIGHT);
-}
-
 void VelocityProjectMap::mouseDrag(const MouseEvent &e)
 {
-    if (this->dragHelper != nullptr)
+    if (this->isDraggingNoteHeader)
+    {
+        jassert(this->dragState.ids.size() == 1);
+        this->dragState.velocities.setUnchecked(0, jlimit(0.f, 1.f,
+            this->noteHeaderDragAnchor - float(e.getDistanceFromDragStartY()) / VELOCITY_MAP_HEIGHT));
+        this->applyDragChanges(false);
+    }
+    else if (this->dragHelper != nullptr)
     {
         this->updateVolumeBlendingIndicator(e.getPosition());
         this->dragHelper->setEndPosition(e.position);
@@ -394,11 +469,9 @@ void VelocityProjectMap::mouseUp(const MouseEvent &e)
     {
         this->volumeBlendingIndicator->setVisible(false);
         this->dragHelper = nullptr;
-        this->dragIntersections.clear();
-        this->dragChangedNotes.clear();
-        this->dragChanges.clear();
-        this->dragHasChanges = false;
     }
+
+    this->resetDragState();
 }
 
 #define VOLUME_BLENDING_WHEEL_SENSIVITY 5.f
@@ -423,28 +496,15 @@ void VelocityProjectMap::mouseWheelMove(const MouseEvent &e, const MouseWheelDet
 // ProjectListener
 //===----------------------------------------------------------------------===//
 
-#define forEachSequenceMapOfGivenTrack(map, child, track) \
-    for (const auto &child : map) \
-        if (child.first.getPattern()->getTrack() == track)
+// the notes are painted right from the sequences,
+// so any change just needs a repaint and a fresh overview:
 
 void VelocityProjectMap::onChangeMidiEvent(const MidiEvent &e1, const MidiEvent &e2)
 {
     if (e1.isTypeOf(MidiEvent::Type::Note))
     {
-        const Note &note = static_cast<const Note &>(e1);
-        const Note &newNote = static_cast<const Note &>(e2);
-        const auto *track = newNote.getSequence()->getTrack();
-
-        forEachSequenceMapOfGivenTrack(this->patternMap, c, track)
-        {
-            auto &sequenceMap = *c.second.get();
-            if (auto *component = sequenceMap[note].release())
-            {
-                sequenceMap.erase(note);
-                sequenceMap[newNote] = UniquePointer<VelocityMapNoteComponent>(component);
-                this->triggerBatchRepaintFor(component);
-            }
-        }
+        this->notesOverview.invalidate(e2.getSequence());
+        this->triggerAsyncUpdate();
     }
 }
 
@@ -452,25 +512,8 @@ void VelocityProjectMap::onAddMidiEvent(const MidiEvent &event)
 {
     if (event.isTypeOf(MidiEvent::Type::Note))
     {
-        const Note &note = static_cast<const Note &>(event);
-        const auto *track = note.getSequence()->getTrack();
-
-        VELOCITY_MAP_BULK_REPAINT_START
-
-        forEachSequenceMapOfGivenTrack(this->patternMap, c, track)
-        {
-            auto &componentsMap = *c.second.get();
-            const int i = track->getPattern()->indexOfSorted(&c.first);
-            jassert(i >= 0);
-
-            const Clip *clip = track->getPattern()->getUnchecked(i);
-            auto *component = new VelocityMapNoteComponent(note, *clip);
-            componentsMap[note] = UniquePointer<VelocityMapNoteComponent>(component);
-            this->addAndMakeVisible(component);
-            this->triggerBatchRepaintFor(component);
-        }
-
-        VELOCITY_MAP_BULK_REPAINT_END
+        this->notesOverview.invalidate(event.getSequence());
+        this->triggerAsyncUpdate();
     }
 }
 
@@ -478,74 +521,52 @@ void VelocityProjectMap::onRemoveMidiEvent(const MidiEvent &event)
 {
     if (event.isTypeOf(MidiEvent::Type::Note))
     {
-        const Note &note = static_cast<const Note &>(event);
-        const auto *track = note.getSequence()->getTrack();
+        this->notesOverview.invalidate(event.getSequence());
+        this->triggerAsyncUpdate();
+    }
+}
 
-        VELOCITY_MAP_BULK_REPAINT_START
+void VelocityProjectMap::onAddMidiEvents(const Array<const MidiEvent *> &events)
+{
+    if (events.isEmpty()) { return; }
+    this->onAddMidiEvent(*events.getFirst());
+}
 
-        forEachSequenceMapOfGivenTrack(this->patternMap, c, track)
-        {
-            auto &sequenceMap = *c.second.get();
-            if (sequenceMap.contains(note))
-            {
-                sequenceMap.erase(note);
-            }
-        }
+void VelocityProjectMap::onChangeMidiEvents(const Array<const MidiEvent *> &oldEvents,
+    const Array<const MidiEvent *> &newEvents)
+{
+    if (newEvents.isEmpty()) { return; }
+    this->onChangeMidiEvent(*oldEvents.getFirst(), *newEvents.getFirst());
+}
 
-        VELOCITY_MAP_BULK_REPAINT_END
-    }
+void VelocityProjectMap::onRemoveMidiEvents(const Array<const MidiEvent *> &events)
+{
+    if (events.isEmpty()) { return; }
+    this->onRemoveMidiEvent(*events.getFirst());
 }
 
 void VelocityProjectMap::onAddClip(const Clip &clip)
 {
-    const SequenceMap *referenceMap = nullptr;
     const auto *track = clip.getPattern()->getTrack();
     if (!dynamic_cast<const PianoSequence *>(track->getSequence())) { return; }
 
-    forEachSequenceMapOfGivenTrack(this->patternMap, c, track)
-    {
-        // Found a sequence map for the same track
-        referenceMap = c.second.get();
-        break;
-    }
-
-    if (referenceMap == nullptr)
-    {
-        jassertfalse;
-        return;
-    }
-
-    auto *sequenceMap = new SequenceMap();
-    this->patternMap[clip] = UniquePointer<SequenceMap>(sequenceMap);
-
-    VELOCITY_MAP_BULK_REPAINT_START
-
-    for (const auto &e : *referenceMap)
-    {
-        // reference the same note as neighbor components:
-        const auto &note = e.second.get()->note;
-        auto *noteComponent = new VelocityMapNoteComponent(note, clip);
-        (*sequenceMap)[note] = UniquePointer<VelocityMapNoteComponent>(noteComponent);
-        this->addAndMakeVisible(noteComponent);
-        this->applyNoteBounds(noteComponent);
-    }
-
-    VELOCITY_MAP_BULK_REPAINT_END
+    this->patternMap[clip] = track->getSequence();
+    this->triggerAsyncUpdate();
 }
 
 void VelocityProjectMap::onChangeClip(const Clip &clip, const Clip &newClip)
 {
     if (this->patternMap.contains(clip))
     {
-        // Set new key for existing sequence map
-        auto *sequenceMap = this->patternMap[clip].release();
+        // Set new key for existing sequence
+        const auto sequence = this->patternMap[clip];
         this->patternMap.erase(clip);
-        this->patternMap[newClip] = UniquePointer<SequenceMap>(sequenceMap);
+        this->patternMap[newClip] = sequence;
 
-        // And update all components within it, as their beats should change
-        for (const auto &e : *sequenceMap)
+        // the active clip's beat and velocity are used for painting and dragging
+        if (this->activeClip == clip)
         {
-            this->batchRepaintList.add(e.second.get());
+            this->activeClip = newClip;
         }
 
         this->triggerAsyncUpdate();
@@ -554,34 +575,17 @@ void VelocityProjectMap::onChangeClip(const Clip &clip, const Clip &newClip)
 
 void VelocityProjectMap::onRemoveClip(const Clip &clip)
 {
-    VELOCITY_MAP_BULK_REPAINT_START
-
     if (this->patternMap.contains(clip))
     {
         this->patternMap.erase(clip);
+        this->triggerAsyncUpdate();
     }
-
-    VELOCITY_MAP_BULK_REPAINT_END
 }
 
 void VelocityProjectMap::onChangeTrackProperties(MidiTrack *const track)
 {
     if (!dynamic_cast<const PianoSequence *>(track->getSequence())) { return; }
-
-    VELOCITY_MAP_BULK_REPAINT_START
-
-    for (const auto &c : this->patternMap)
-    {
-        const auto &componentsMap = *c.second.get();
-        for (const auto &e : componentsMap)
-        {
-            e.second->updateColour();
-        }
-    }
-
-    VELOCITY_MAP_BULK_REPAINT_END
-
-    this->repaint();
+    this->triggerAsyncUpdate();
 }
 
 void VelocityProjectMap::onReloadProjectContent(const Array<MidiTrack *> &tracks)
@@ -592,10 +596,8 @@ void VelocityProjectMap::onReloadProjectContent(const Array<MidiTrack *> &tracks
 void VelocityProjectMap::onAddTrack(MidiTrack *const track)
 {
     if (!dynamic_cast<const PianoSequence *>(track->getSequence())) { return; }
-
-    VELOCITY_MAP_BULK_REPAINT_START
     this->loadTrack(track);
-    VELOCITY_MAP_BULK_REPAINT_END
+    this->triggerAsyncUpdate();
 }
 
 void VelocityProjectMap::onRemoveTrack(MidiTrack *const track)
@@ -610,6 +612,9 @@ void VelocityProjectMap::onRemoveTrack(MidiTrack *const track)
             this->patternMap.erase(clip);
         }
     }
+
+    this->notesOverview.invalidate(track->getSequence());
+    this->triggerAsyncUpdate();
 }
 
 void VelocityProjectMap::onChangeProjectBeatRange(float firstBeat, float lastBeat)
@@ -641,20 +646,7 @@ void VelocityProjectMap::onChangeViewEditableScope(MidiTrack *const, const Clip
     }
 
     this->activeClip = clip;
-
-    VELOCITY_MAP_BULK_REPAINT_START
-
-    for (const auto &c : this->patternMap)
-    {
-        const bool editable = this->activeClip == c.first;
-        const auto &componentsMap = *c.second.get();
-        for (const auto &e : componentsMap)
-        {
-            e.second->setEditable(editable);
-        }
-    }
-
-    VELOCITY_MAP_BULK_REPAINT_END
+    this->repaint();
 }
 
 void VelocityProjectMap::changeListenerCallback(ChangeBroadcaster *source)
@@ -664,46 +656,79 @@ void VelocityProjectMap::changeListenerCallback(ChangeBroadcaster *source)
     jassert(dynamic_cast<Lasso *>(source));
     const auto *selection = static_cast<Lasso *>(source);
 
-    const auto activeMapIt = this->patternMap.find(this->activeClip);
-    if (activeMapIt == this->patternMap.end())
+    this->selectedNotes.clear();
+    this->editsSelectionOnly = selection->getNumSelected() > 0;
+
+    for (const auto *e : *selection)
     {
-        jassertfalse;
-        return;
+        // assuming we've subscribed only on a piano roll's lasso changes
+        const auto *nc = static_cast<const NoteComponent *>(e);
+        this->selectedNotes.insert(nc->getNote().getId());
     }
 
-    const auto *activeMap = activeMapIt->second.get();
+    this->repaint();
+}
 
-    VELOCITY_MAP_BULK_REPAINT_START
+//===----------------------------------------------------------------------===//
+// Private
+//===----------------------------------------------------------------------===//
 
-    if (selection->getNumSelected() == 0)
+PianoSequence *VelocityProjectMap::getActiveSequence() const
+{
+    if (this->activeClip.getPattern() == nullptr)
     {
-        for (const auto &e : *activeMap)
-        {
-            e.second->setEditable(true);
-        }
+        return nullptr;
     }
-    else
+
+    return dynamic_cast<PianoSequence *>(this->activeClip.getPattern()->getTrack()->getSequence());
+}
+
+float VelocityProjectMap::getBeatsPerPixel() const noexcept
+{
+    const float rollLengthInBeats = (this->rollLastBeat - this->rollFirstBeat);
+    const float projectLengthInBeats = (this->projectLastBeat - this->projectFirstBeat);
+    const float mapWidth = float(this->getWidth()) * (projectLengthInBeats / rollLengthInBeats);
+    return mapWidth > 0.f ? projectLengthInBeats / mapWidth : 0.f;
+}
+
+bool VelocityProjectMap::isNoteEditable(const Note &note) const
+{
+    return !this->editsSelectionOnly || this->selectedNotes.contains(note.getId());
+}
+
+int VelocityProjectMap::findEditableNoteHeaderAt(const Point<float> &position) const
+{
+    const auto *sequence = this->getActiveSequence();
+    const float beatsPerPixel = this->getBeatsPerPixel();
+    if (sequence == nullptr || beatsPerPixel <= 0.f)
     {
-        for (const auto &e : *activeMap)
-        {
-            e.second->setEditable(false);
-        }
+        return -1;
+    }
+
+    const auto &notes = sequence->getPackedNotes();
+    const float beatOffset = this->activeClip.getBeat() - this->rollFirstBeat;
+    const float beat = position.x * beatsPerPixel - beatOffset;
+
+    // the bars are at least a pixel wide, hence the margin,
+    // and the later notes are painted on top, hence the reverse order
+    const auto candidates = notes.getCandidatesInRange(beat - beatsPerPixel, beat);
+    for (int i = candidates.getEnd() - 1; i >= candidates.getStart(); --i)
+    {
+        const auto bar = getNoteBar((notes.beats.getUnchecked(i) + beatOffset) / beatsPerPixel,
+            notes.lengths.getUnchecked(i) / beatsPerPixel,
+            notes.velocities.getUnchecked(i) * this->activeClip.getVelocity(), this->getHeight());
 
-        for (const auto *e : *selection)
+        if (position.x >= bar.getX() && position.x <= bar.getRight() &&
+            position.y >= bar.getY() && position.y <= bar.getY() + VELOCITY_MAP_HEADER_HEIGHT &&
+            this->isNoteEditable(*notes.handles.getUnchecked(i)))
         {
-            // assuming we've subscribed only on a piano roll's lasso changes
-            const auto *nc = static_cast<const NoteComponent *>(e);
-            activeMap->at(nc->getNote())->setEditable(true);
+            return i;
         }
     }
 
-    VELOCITY_MAP_BULK_REPAINT_END
+    return -1;
 }
 
-//===----------------------------------------------------------------------===//
-// Private
-//===----------------------------------------------------------------------===//
-
 void VelocityProjectMap::updateVolumeBlendingIndicator(const Point<int> &pos)
 {
     if (this->volumeBlendingAmount == 1.f && this->volumeBlendingIndicator->isVisible())
@@ -720,124 +745,172 @@ void VelocityProjectMap::updateVolumeBlendingIndicator(const Point<int> &pos)
     this->volumeBlendingIndicator->setCentrePosition(pos);
 }
 
-void VelocityProjectMap::applyVolumeChanges()
+// the y of the drag line, extended if needed, at the given x
+static inline float getDragLineY(const Line<float> &line, float x) noexcept
 {
-    const auto *activeMap = this->patternMap.at(this->activeClip).get();
-    jassert(activeMap);
+    const float dx = line.getEndX() - line.getStartX();
+    if (dx == 0.f)
+    {
+        return line.getEndY();
+    }
+
+    return line.getStartY() + (line.getEndY() - line.getStartY()) * (x - line.getStartX()) / dx;
+}
+
+// whether the drag line crosses the vertical line at the given x
+static inline bool crossesDragLine(const Line<float> &line, float x) noexcept
+{
+    if (x < jmin(line.getStartX(), line.getEndX()) ||
+        x > jmax(line.getStartX(), line.getEndX()))
+    {
+        return false;
+    }
 
-    // this is where things start looking a bit dirty:
-    // to update notes velocities on the fly, we use undo/redo actions (as always),
-    // but we don't want to have lots of those actions in undo transaction in the end,
-    // there should only be one action, which holds original notes and final new parameters;
-    // undo action and undo stack are smart enough to turn a -> b, b -> c into a -> c,
-    // but it only works within exactly the same group of notes,
-    // which may - and will - change as the user drags the helper around,
-    // so we are to track moments when a group changes and undo current transaction
+    const float y = getDragLineY(line, x);
+    return y >= 0.f && y <= VELOCITY_MAP_HEIGHT;
+}
 
-    bool shouldUndo = false;
-    Point<float> intersectionA;
-    Point<float> intersectionB;
+void VelocityProjectMap::applyVolumeChanges()
+{
+    auto *sequence = this->getActiveSequence();
+    const float beatsPerPixel = this->getBeatsPerPixel();
+    if (sequence == nullptr || beatsPerPixel <= 0.f)
+    {
+        return;
+    }
 
     jassert(this->dragHelper);
     const auto &dragLine = this->dragHelper->getLine();
-    const auto &dragLineExt = this->dragHelper->getExtendedLine();
     const bool ascending = (dragLine.getStartX() <= dragLine.getEndX() && dragLine.getStartY() >= dragLine.getEndY())
         || (dragLine.getStartX() > dragLine.getEndX() && dragLine.getStartY() < dragLine.getEndY());
 
-    for (const auto &i : *activeMap)
+    // the notes that the line no longer crosses return to their initial velocities
+    auto &drag = this->dragState;
+    for (int i = 0; i < drag.velocities.size(); ++i)
     {
-        if (!i.second->isEditable())
-        {
-            continue;
-        }
+        drag.velocities.setUnchecked(i, drag.initialVelocities.getUnchecked(i));
+    }
 
-        const bool ia = dragLine.intersects(i.second->getStartLine(), intersectionA);
-        const bool ib = dragLine.intersects(i.second->getEndLine(), intersectionB);
-        const bool hasIntersection = ia || ib; // (ascending && ia) || (!ascending && ib);
+    // only the notes under the line are checked, the bars being at least a pixel wide
+    const auto &notes = sequence->getPackedNotes();
+    const float beatOffset = this->activeClip.getBeat() - this->rollFirstBeat;
+    const float startX = jmin(dragLine.getStartX(), dragLine.getEndX());
+    const float endX = jmax(dragLine.getStartX(), dragLine.getEndX());
+    const auto candidates = notes.getCandidatesInRange(
+        (startX - 1.f) * beatsPerPixel - beatOffset, endX * beatsPerPixel - beatOffset);
 
-        float intersectionVelocity = 0.f;
-        if (ascending)
-        {
-            if (ia)
-            {
-                intersectionVelocity = getVelocityByIntersection(intersectionA);
-            }
-            else
-            {
-                dragLineExt.intersects(i.second->getStartLine(), intersectionA);
-                intersectionVelocity = getVelocityByIntersection(intersectionA);
-            }
-        }
-        else
+    bool groupHasGrown = false;
+    for (int i = candidates.getStart(); i < candidates.getEnd(); ++i)
+    {
+        const auto *note = notes.handles.getUnchecked(i);
+        if (!this->isNoteEditable(*note))
         {
-            if (ib)
-            {
-                intersectionVelocity = getVelocityByIntersection(intersectionB);
-            }
-            else
-            {
-                dragLineExt.intersects(i.second->getEndLine(), intersectionB);
-                intersectionVelocity = getVelocityByIntersection(intersectionB);
-            }
+            continue;
         }
 
-        auto existingIntersection = this->dragIntersections.find(i.first);
-        if (hasIntersection && existingIntersection == this->dragIntersections.end())
-        {
-            // found new intersection
-            shouldUndo = true;
-            this->dragIntersections.emplace(i.first, intersectionVelocity);
-        }
-        else if (!hasIntersection && existingIntersection != this->dragIntersections.end())
+        const float noteStartX = (notes.beats.getUnchecked(i) + beatOffset) / beatsPerPixel;
+        const float noteEndX = noteStartX + jmax(1.f, notes.lengths.getUnchecked(i) / beatsPerPixel);
+        if (!crossesDragLine(dragLine, noteStartX) && !crossesDragLine(dragLine, noteEndX))
         {
-            // lost existing intersection
-            shouldUndo = true;
-            this->dragIntersections.erase(existingIntersection);
-        }
-        else if (hasIntersection)
-        {
-            this->dragIntersections[i.first] = intersectionVelocity;
+            continue;
         }
-    }
 
-    // filling up arrays all the time on mouse drag - kinda sucks, nah?
-    // todo test performance
-    this->dragChangedNotes.clearQuick();
-    this->dragChanges.clearQuick();
+        const float y = getDragLineY(dragLine, ascending ? noteStartX : noteEndX);
+        const float intersectionVelocity = jlimit(0.f, 1.f, 1.f - (y / VELOCITY_MAP_HEIGHT));
 
-    for (const auto &i : this->dragIntersections)
-    {
-        const auto newVelocity = (i.second * this->volumeBlendingAmount) +
-            (i.first.getVelocity() * (1.f - this->volumeBlendingAmount));
+        const auto found = drag.indices.find(note->getId());
+        const bool isNewNote = (found == drag.indices.end());
+        const int index = isNewNote ? drag.add(*note) : found->second;
+        groupHasGrown = groupHasGrown || isNewNote;
+
+        const auto newVelocity = (intersectionVelocity * this->volumeBlendingAmount) +
+            (drag.initialVelocities.getUnchecked(index) * (1.f - this->volumeBlendingAmount));
 
-        this->dragChangedNotes.add(i.first);
-        this->dragChanges.add(i.first.withVelocity(newVelocity));
+        drag.velocities.setUnchecked(index, newVelocity);
     }
 
-    auto *sequence = static_cast<PianoSequence *>(this->activeClip.getPattern()->getTrack()->getSequence());
+    this->applyDragChanges(groupHasGrown);
+}
 
-    if (shouldUndo && this->dragHasChanges)
+void VelocityProjectMap::applyDragChanges(bool groupHasGrown)
+{
+    auto *sequence = this->getActiveSequence();
+    auto &drag = this->dragState;
+    if (sequence == nullptr || drag.ids.isEmpty())
     {
-        sequence->undoCurrentTransactionOnly();
+        return;
     }
 
-    if (!this->dragChangedNotes.isEmpty())
+    // the undo stack merges a -> b, b -> c into a -> c only for exactly the same
+    // group of notes, so when a new note is touched, the current transaction
+    // is undone, and the whole group is changed from its initial state again
+    if (groupHasGrown && this->dragHasChanges)
     {
-        if (!this->dragHasChanges)
+        sequence->undoCurrentTransactionOnly();
+        this->dragHasChanges = false;
+
+        for (int i = 0; i < drag.appliedVelocities.size(); ++i)
         {
-            this->dragHasChanges = true;
-            sequence->checkpoint();
+            drag.appliedVelocities.setUnchecked(i, drag.initialVelocities.getUnchecked(i));
         }
+    }
 
-        sequence->changeGroup(this->dragChangedNotes, this->dragChanges, true);
+    if (drag.velocities == drag.appliedVelocities)
+    {
+        return;
+    }
+
+    if (!this->dragHasChanges)
+    {
+        this->dragHasChanges = true;
+        sequence->checkpoint();
     }
+
+    // the action takes these arrays' contents
+    Array<Note::Id> ids(drag.ids);
+    PianoSequence::NotesState stateBefore;
+    PianoSequence::NotesState stateAfter;
+    stateBefore.beats = drag.beats;
+    stateBefore.velocities = drag.appliedVelocities;
+    stateAfter.velocities = drag.velocities;
+
+    sequence->changeGroup(ids, stateBefore, stateAfter, true);
+    drag.appliedVelocities = drag.velocities;
+}
+
+void VelocityProjectMap::resetDragState()
+{
+    this->dragState.clear();
+    this->dragHasChanges = false;
+    this->isDraggingNoteHeader = false;
+}
+
+int VelocityProjectMap::DragState::add(const Note &note)
+{
+    const int index = this->ids.size();
+    this->ids.add(note.getId());
+    this->beats.add(note.getBeat());
+    this->initialVelocities.add(note.getVelocity());
+    this->appliedVelocities.add(note.getVelocity());
+    this->velocities.add(note.getVelocity());
+    this->indices[note.getId()] = index;
+    return index;
+}
+
+void VelocityProjectMap::DragState::clear() noexcept
+{
+    this->ids.clearQuick();
+    this->beats.clearQuick();
+    this->initialVelocities.clearQuick();
+    this->appliedVelocities.clearQuick();
+    this->velocities.clearQuick();
+    this->indices.clear();
 }
 
 void VelocityProjectMap::reloadTrackMap()
 {
     this->patternMap.clear();
-
-    VELOCITY_MAP_BULK_REPAINT_START
+    this->notesOverview.clear();
 
     const auto &tracks = this->project.getTracks();
     for (const auto *track : tracks)
@@ -848,7 +921,7 @@ void VelocityProjectMap::reloadTrackMap()
         }
     }
 
-    VELOCITY_MAP_BULK_REPAINT_END
+    this->triggerAsyncUpdate();
 }
 
 void VelocityProjectMap::loadTrack(const MidiTrack *const track)
@@ -861,67 +934,11 @@ void VelocityProjectMap::loadTrack(const MidiTrack *const track)
     for (int i = 0; i < track->getPattern()->size(); ++i)
     {
         const Clip *clip = track->getPattern()->getUnchecked(i);
-        const bool editable = this->activeClip == *clip;
-
-        auto *sequenceMap = new SequenceMap();
-        this->patternMap[*clip] = UniquePointer<SequenceMap>(sequenceMap);
-
-        for (int j = 0; j < track->getSequence()->size(); ++j)
-        {
-            const MidiEvent *event = track->getSequence()->getUnchecked(j);
-            if (event->isTypeOf(MidiEvent::Type::Note))
-            {
-                const Note *note = static_cast<const Note *>(event);
-                auto *noteComponent = new VelocityMapNoteComponent(*note, *clip);
-                (*sequenceMap)[*note] = UniquePointer<VelocityMapNoteComponent>(noteComponent);
-                this->addAndMakeVisible(noteComponent);
-                this->applyNoteBounds(noteComponent);
-                noteComponent->setEditable(editable);
-            }
-        }
+        this->patternMap[*clip] = track->getSequence();
     }
 }
 
-void VelocityProjectMap::applyNoteBounds(VelocityMapNoteComponent *nc)
-{
-    const float rollLengthInBeats = (this->rollLastBeat - this->rollFirstBeat);
-    const float projectLengthInBeats = (this->projectLastBeat - this->projectFirstBeat);
-
-    const float beat = (nc->getBeat() - this->rollFirstBeat);
-    const float mapWidth = float(this->getWidth()) * (projectLengthInBeats / rollLengthInBeats);
-
-    const float x = (mapWidth * (beat / projectLengthInBeats));
-    const float w = (mapWidth * (nc->getLength() / projectLengthInBeats));
-
-    // at least 4 pixels are visible for 0 volume events:
-    const int h = jmax(4, int(this->getHeight() * nc->getVelocity()));
-    nc->setRealBounds(x, this->getHeight() - h, jmax(1.f, w), h);
-}
-
-void VelocityProjectMap::triggerBatchRepaintFor(VelocityMapNoteComponent *target)
-{
-    this->batchRepaintList.add(target);
-    this->triggerAsyncUpdate();
-}
-
 void VelocityProjectMap::handleAsyncUpdate()
 {
-    // batch repaint & resize stuff
-    if (this->batchRepaintList.size() > 0)
-    {
-        VELOCITY_MAP_BULK_REPAINT_START
-
-        for (int i = 0; i < this->batchRepaintList.size(); ++i)
-        {
-            // There are still many cases when a scheduled component is deleted at this time:
-            if (Component *component = this->batchRepaintList.getUnchecked(i))
-            {
-                this->applyNoteBounds(static_cast<VelocityMapNoteComponent *>(component));
-            }
-        }
-
-        VELOCITY_MAP_BULK_REPAINT_END
-
-        this->batchRepaintList.clearQuick();
-    }
+    this->repaint();
 }
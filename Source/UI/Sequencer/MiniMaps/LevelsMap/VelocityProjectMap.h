@@ -21,19 +21,20 @@
 #include "Note.h"
 #include "ProjectListener.h"
 #include "ComponentFader.h"
+#include "NotesOverviewCache.h"
 
 #define VELOCITY_MAP_HEIGHT (128.f)
 
 class HybridRoll;
 class ProjectNode;
-class VelocityMapNoteComponent;
+class PianoSequence;
 class VelocityLevelDraggingHelper;
 class FineTuningValueIndicator;
 
 class VelocityProjectMap final :
     public Component,
     public ProjectListener,
-    public AsyncUpdater, // triggers batch repaints for children
+    public AsyncUpdater, // triggers batch repaints
     public ChangeListener // subscribes on parent roll's lasso changes
 {
 public:
@@ -46,6 +47,8 @@ public:
     //===------------------------------------------------------------------===//
 
     void resized() override;
+    void paint(Graphics &g) override;
+    void mouseMove(const MouseEvent &e) override;
     void mouseDown(const MouseEvent &e) override;
     void mouseDrag(const MouseEvent &e) override;
     void mouseUp(const MouseEvent &e) override;
@@ -59,6 +62,12 @@ public:
     void onChangeMidiEvent(const MidiEvent &e1, const MidiEvent &e2) override;
     void onRemoveMidiEvent(const MidiEvent &event) override;
 
+    // repainting is all that these do, so once per group is enough
+    void onAddMidiEvents(const Array<const MidiEvent *> &events) override;
+    void onChangeMidiEvents(const Array<const MidiEvent *> &oldEvents,
+        const Array<const MidiEvent *> &newEvents) override;
+    void onRemoveMidiEvents(const Array<const MidiEvent *> &events) override;
+
     void onAddClip(const Clip &clip) override;
     void onChangeClip(const Clip &oldClip, const Clip &newClip) override;
     void onRemoveClip(const Clip &clip) override;
@@ -76,10 +85,25 @@ private:
 
     void changeListenerCallback(ChangeBroadcaster *source) override;
 
-    void applyNoteBounds(VelocityMapNoteComponent *nc);
     void reloadTrackMap();
     void loadTrack(const MidiTrack *const track);
 
+    // all notes, including the active clip's ones, are painted right
+    // from the packed arrays, and the active clip's notes are hit-tested
+    // with the same interval index, so there are no components per note
+    PianoSequence *getActiveSequence() const;
+    float getBeatsPerPixel() const noexcept;
+    int findEditableNoteHeaderAt(const Point<float> &position) const;
+    bool isNoteEditable(const Note &note) const;
+
+    void paintActiveClip(Graphics &g,
+        float beatsPerPixel, float paintStartBeat, float paintEndBeat);
+
+    // when zoomed out too far, the other clips show the velocity profiles
+    NotesOverviewCache notesOverview;
+    void paintOverviews(Graphics &g, int level,
+        float beatsPerPixel, float paintStartBeat, float paintEndBeat);
+
     float projectFirstBeat = 0.f;
     float projectLastBeat = PROJECT_DEFAULT_NUM_BEATS;
 
@@ -91,25 +115,49 @@ private:
 
     Clip activeClip;
 
-    using SequenceMap = FlatHashMap<Note, UniquePointer<VelocityMapNoteComponent>, MidiEventHash>;
-    using PatternMap = FlatHashMap<Clip, UniquePointer<SequenceMap>, ClipHash>;
+    using PatternMap = FlatHashMap<Clip, WeakReference<MidiSequence>, ClipHash>;
     PatternMap patternMap;
 
-    UniquePointer<VelocityLevelDraggingHelper> dragHelper;
-    FlatHashMap<Note, float, MidiEventHash> dragIntersections;
-    Array<Note> dragChangedNotes, dragChanges;
+    // when something is selected in the roll, only the selected notes are editable
+    FlatHashSet<Note::Id, MidiEventIdHash> selectedNotes;
+    bool editsSelectionOnly = false;
+
+    // the notes touched by the current gesture, in the order they were first
+    // touched, with their initial parameters; the whole gesture is applied
+    // as one group change of the velocities, which the undo stack coalesces
+    // while the group stays the same, so the group here only ever grows
+    struct DragState final
+    {
+        Array<Note::Id> ids;
+        Array<float> beats;
+        Array<float> initialVelocities;
+        Array<float> appliedVelocities;
+        Array<float> velocities;
+        FlatHashMap<Note::Id, int, MidiEventIdHash> indices;
+
+        int add(const Note &note);
+        void clear() noexcept;
+    };
+
+    DragState dragState;
     bool dragHasChanges = false;
 
+    UniquePointer<VelocityLevelDraggingHelper> dragHelper;
+
+    // one note can also be dragged by its header line
+    bool isDraggingNoteHeader = false;
+    float noteHeaderDragAnchor = 0.f;
+
     float volumeBlendingAmount = 1.f;
     UniquePointer<FineTuningValueIndicator> volumeBlendingIndicator;
     void updateVolumeBlendingIndicator(const Point<int> &pos);
     ComponentFader fader;
 
     void applyVolumeChanges();
+    void applyDragChanges(bool groupHasGrown);
+    void resetDragState();
 
-    void triggerBatchRepaintFor(VelocityMapNoteComponent *target);
     void handleAsyncUpdate() override;
-    Array<WeakReference<Component>> batchRepaintList;
 
     JUCE_LEAK_DETECTOR(VelocityProjectMap)
 };
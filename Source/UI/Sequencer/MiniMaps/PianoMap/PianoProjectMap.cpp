@@ -60,21 +60,55 @@ void PianoProjectMap::paint(Graphics &g)
     const float rollLengthInBeats = this->rollLastBeat - this->rollFirstBeat;
     const float projectLengthInBeats = this->projectLastBeat - this->projectFirstBeat;
     const float mapWidth = float(this->getWidth()) * (projectLengthInBeats / rollLengthInBeats);
+    if (mapWidth <= 0.f)
+    {
+        return;
+    }
+
+    // only the notes within the repainted area are collected,
+    // and each clip's notes are filled at once
+    const auto paintArea = g.getClipBounds().toFloat();
+    const float beatsPerPixel = projectLengthInBeats / mapWidth;
+    const float paintStartBeat = this->rollFirstBeat + paintArea.getX() * beatsPerPixel;
+    const float paintEndBeat = this->rollFirstBeat + paintArea.getRight() * beatsPerPixel;
+
+    // when the notes get narrower than a pixel, blit the overviews instead
+    const int overviewLevel = NotesOverviewCache::getLevelFor(1.f / beatsPerPixel);
+    if (overviewLevel >= 0)
+    {
+        this->paintOverviews(g, overviewLevel, beatsPerPixel, paintStartBeat, paintEndBeat);
+        return;
+    }
+
+    RectangleList<float> rectangles;
 
     for (const auto &c : this->patternMap)
     {
-        const auto sequenceMap = c.second.get();
-        const bool isActiveClip = this->activeClip == c.first;
+        const auto *sequence = dynamic_cast<const PianoSequence *>(c.second.get());
+        if (sequence == nullptr)
+        {
+            continue;
+        }
 
-        g.setColour(c.first.getTrackColour().
-            interpolatedWith(this->baseColour, .4f).
-            withAlpha(isActiveClip ? .9f : .6f));
+        const auto &notes = sequence->getPackedNotes();
+        const auto clipKey = c.first.getKey();
+        const auto beatOffset = c.first.getBeat() - this->rollFirstBeat;
+        const auto candidates = notes.getCandidatesInRange(paintStartBeat - c.first.getBeat(),
+            paintEndBeat - c.first.getBeat());
 
-        for (const auto &n : *sequenceMap)
+        if (candidates.isEmpty())
         {
-            const auto key = jlimit(0, 128, n.getKey() + c.first.getKey());
-            const auto beat = n.getBeat() + c.first.getBeat() - this->rollFirstBeat;
-            const auto length = n.getLength();
+            continue;
+        }
+
+        rectangles.clear();
+        rectangles.ensureStorageAllocated(candidates.getLength());
+
+        for (int i = candidates.getStart(); i < candidates.getEnd(); ++i)
+        {
+            const auto key = jlimit(0, 128, notes.keys.getUnchecked(i) + clipKey);
+            const auto beat = notes.beats.getUnchecked(i) + beatOffset;
+            const auto length = notes.lengths.getUnchecked(i);
 
             const float x = (mapWidth * (beat / projectLengthInBeats));
             const float w = (mapWidth * (length / projectLengthInBeats));
@@ -82,37 +116,73 @@ void PianoProjectMap::paint(Graphics &g)
             // with rounding, it just looks better:
             const int y = this->getHeight() - static_cast<int>(key * this->componentHeight);
 
-            g.fillRect(x, static_cast<float>(y), jmax(0.25f, w), 1.0f);
+            rectangles.addWithoutMerging({ x, static_cast<float>(y), jmax(0.25f, w), 1.0f });
+        }
+
+        g.setColour(this->getClipColour(c.first));
+        g.fillRectList(rectangles);
+    }
+}
+
+void PianoProjectMap::paintOverviews(Graphics &g, int level,
+    float beatsPerPixel, float paintStartBeat, float paintEndBeat)
+{
+    // the overviews are shifted by the clip keys, and the painting is unclipped
+    g.reduceClipRegion(this->getLocalBounds());
+    g.setImageResamplingQuality(Graphics::lowResamplingQuality);
+
+    for (const auto &c : this->patternMap)
+    {
+        const auto *sequence = dynamic_cast<const PianoSequence *>(c.second.get());
+        if (sequence == nullptr)
+        {
+            continue;
+        }
+
+        const auto &raster = this->notesOverview.getKeysRaster(*sequence, level, this->getHeight());
+        if (!raster.image.isValid())
+        {
+            continue;
         }
+
+        const float startBeat = c.first.getBeat() + raster.startBeat;
+        const float endBeat = startBeat + raster.image.getWidth() * raster.beatsPerBucket;
+        if (endBeat < paintStartBeat || startBeat > paintEndBeat)
+        {
+            continue;
+        }
+
+        // a bucket is always at least a pixel wide, so nothing is lost when scaling
+        const float x = (startBeat - this->rollFirstBeat) / beatsPerPixel;
+        const int keyOffset = roundToInt(c.first.getKey() * this->componentHeight);
+
+        g.setColour(this->getClipColour(c.first));
+        g.drawImageTransformed(raster.image,
+            AffineTransform::scale(raster.beatsPerBucket / beatsPerPixel, 1.f)
+                .translated(x, float(-keyOffset)), true);
     }
 }
 
+Colour PianoProjectMap::getClipColour(const Clip &clip) const
+{
+    const bool isActiveClip = this->activeClip == clip;
+    return clip.getTrackColour().
+        interpolatedWith(this->baseColour, .4f).
+        withAlpha(isActiveClip ? .9f : .6f);
+}
+
 //===----------------------------------------------------------------------===//
 // ProjectListener
 //===----------------------------------------------------------------------===//
 
-#define forEachSequenceMapOfGivenTrack(map, child, track) \
-    for (const auto &child : map) \
-        if (child.first.getPattern()->getTrack() == track)
+// the notes are painted right from the sequences,
+// so any change just needs a repaint and a fresh overview:
 
 void PianoProjectMap::onChangeMidiEvent(const MidiEvent &e1, const MidiEvent &e2)
 {
     if (e1.isTypeOf(MidiEvent::Type::Note))
     {
-        const Note &note = static_cast<const Note &>(e1);
-        const Note &newNote = static_cast<const Note &>(e2);
-        const auto *track = newNote.getSequence()->getTrack();
-
-        forEachSequenceMapOfGivenTrack(this->patternMap, c, track)
-        {
-            auto &sequenceMap = *c.second.get();
-            if (sequenceMap.contains(note))
-            {
-                sequenceMap.erase(note);
-                sequenceMap.insert(newNote);
-            }
-        }
-
+        this->notesOverview.invalidate(e2.getSequence());
         this->triggerAsyncUpdate();
     }
 }
@@ -121,15 +191,7 @@ void PianoProjectMap::onAddMidiEvent(const MidiEvent &event)
 {
     if (event.isTypeOf(MidiEvent::Type::Note))
     {
-        const Note &note = static_cast<const Note &>(event);
-        const auto *track = note.getSequence()->getTrack();
-
-        forEachSequenceMapOfGivenTrack(this->patternMap, c, track)
-        {
-            auto &sequenceMap = *c.second.get();
-            sequenceMap.insert(note);
-        }
-
+        this->notesOverview.invalidate(event.getSequence());
         this->triggerAsyncUpdate();
     }
 }
@@ -138,49 +200,36 @@ void PianoProjectMap::onRemoveMidiEvent(const MidiEvent &event)
 {
     if (event.isTypeOf(MidiEvent::Type::Note))
     {
-        const Note &note = static_cast<const Note &>(event);
-        const auto *track = note.getSequence()->getTrack();
-
-        forEachSequenceMapOfGivenTrack(this->patternMap, c, track)
-        {
-            auto &sequenceMap = *c.second.get();
-            if (sequenceMap.contains(note))
-            {
-                sequenceMap.erase(note);
-            }
-        }
-
+        this->notesOverview.invalidate(event.getSequence());
         this->triggerAsyncUpdate();
     }
 }
 
-void PianoProjectMap::onAddClip(const Clip &clip)
+void PianoProjectMap::onAddMidiEvents(const Array<const MidiEvent *> &events)
 {
-    const SequenceSet *referenceMap = nullptr;
-    const auto *track = clip.getPattern()->getTrack();
-    if (!dynamic_cast<const PianoSequence *>(track->getSequence())) { return; }
+    if (events.isEmpty()) { return; }
+    this->onAddMidiEvent(*events.getFirst());
+}
 
-    forEachSequenceMapOfGivenTrack(this->patternMap, c, track)
-    {
-        // Found a sequence map for the same track
-        referenceMap = c.second.get();
-        break;
-    }
+void PianoProjectMap::onChangeMidiEvents(const Array<const MidiEvent *> &oldEvents,
+    const Array<const MidiEvent *> &newEvents)
+{
+    if (newEvents.isEmpty()) { return; }
+    this->onChangeMidiEvent(*oldEvents.getFirst(), *newEvents.getFirst());
+}
 
-    if (referenceMap == nullptr)
-    {
-        jassertfalse;
-        return;
-    }
+void PianoProjectMap::onRemoveMidiEvents(const Array<const MidiEvent *> &events)
+{
+    if (events.isEmpty()) { return; }
+    this->onRemoveMidiEvent(*events.getFirst());
+}
 
-    auto *sequenceMap = new SequenceSet();
-    this->patternMap[clip] = UniquePointer<SequenceSet>(sequenceMap);
-        
-    for (const auto &note : *referenceMap)
-    {
-        sequenceMap->insert(note);
-    }
+void PianoProjectMap::onAddClip(const Clip &clip)
+{
+    const auto *track = clip.getPattern()->getTrack();
+    if (!dynamic_cast<const PianoSequence *>(track->getSequence())) { return; }
 
+    this->patternMap[clip] = track->getSequence();
     this->triggerAsyncUpdate();
 }
 
@@ -188,10 +237,10 @@ void PianoProjectMap::onChangeClip(const Clip &clip, const Clip &newClip)
 {
     if (this->patternMap.contains(clip))
     {
-        // Set new key for existing sequence map
-        auto *sequenceMap = this->patternMap[clip].release();
+        // Set new key for existing sequence
+        const auto sequence = this->patternMap[clip];
         this->patternMap.erase(clip);
-        this->patternMap[newClip] = UniquePointer<SequenceSet>(sequenceMap);
+        this->patternMap[newClip] = sequence;
         this->triggerAsyncUpdate();
     }
 }
@@ -236,6 +285,7 @@ void PianoProjectMap::onRemoveTrack(MidiTrack *const track)
         }
     }
 
+    this->notesOverview.invalidate(track->getSequence());
     this->triggerAsyncUpdate();
 }
 
@@ -278,6 +328,7 @@ void PianoProjectMap::onChangeViewEditableScope(MidiTrack *const, const Clip &cl
 void PianoProjectMap::reloadTrackMap()
 {
     this->patternMap.clear();
+    this->notesOverview.clear();
 
     const auto &tracks = this->project.getTracks();
     for (const auto *track : tracks)
@@ -301,19 +352,7 @@ void PianoProjectMap::loadTrack(const MidiTrack *const track)
     for (int i = 0; i < track->getPattern()->size(); ++i)
     {
         const Clip *clip = track->getPattern()->getUnchecked(i);
-
-        auto *sequenceMap = new SequenceSet();
-        this->patternMap[*clip] = UniquePointer<SequenceSet>(sequenceMap);
-
-        for (int j = 0; j < track->getSequence()->size(); ++j)
-        {
-            const MidiEvent *event = track->getSequence()->getUnchecked(j);
-            if (event->isTypeOf(MidiEvent::Type::Note))
-            {
-                const Note *note = static_cast<const Note *>(event);
-                sequenceMap->insert(*note);
-            }
-        }
+        this->patternMap[*clip] = track->getSequence();
     }
 }
 
@@ -20,6 +20,7 @@
 #include "Clip.h"
 #include "Note.h"
 #include "ProjectListener.h"
+#include "NotesOverviewCache.h"
 
 class HybridRoll;
 class ProjectNode;
@@ -50,6 +51,12 @@ public:
     void onChangeMidiEvent(const MidiEvent &e1, const MidiEvent &e2) override;
     void onRemoveMidiEvent(const MidiEvent &event) override;
 
+    // repainting is all that these do, so once per group is enough
+    void onAddMidiEvents(const Array<const MidiEvent *> &events) override;
+    void onChangeMidiEvents(const Array<const MidiEvent *> &oldEvents,
+        const Array<const MidiEvent *> &newEvents) override;
+    void onRemoveMidiEvents(const Array<const MidiEvent *> &events) override;
+
     void onAddClip(const Clip &clip) override;
     void onChangeClip(const Clip &oldClip, const Clip &newClip) override;
     void onRemoveClip(const Clip &clip) override;
@@ -68,6 +75,10 @@ private:
     void reloadTrackMap();
     void loadTrack(const MidiTrack *const track);
 
+    void paintOverviews(Graphics &g, int level,
+        float beatsPerPixel, float paintStartBeat, float paintEndBeat);
+    Colour getClipColour(const Clip &clip) const;
+
     float projectFirstBeat = 0.f;
     float projectLastBeat = PROJECT_DEFAULT_NUM_BEATS;
 
@@ -82,10 +93,11 @@ private:
     Clip activeClip;
     Colour baseColour;
 
-    using SequenceSet = FlatHashSet<Note, MidiEventHash>;
-    using PatternMap = FlatHashMap<Clip, UniquePointer<SequenceSet>, ClipHash>;
+    using PatternMap = FlatHashMap<Clip, WeakReference<MidiSequence>, ClipHash>;
     PatternMap patternMap;
 
+    NotesOverviewCache notesOverview;
+
     void handleAsyncUpdate() override;
 
     JUCE_LEAK_DETECTOR(PianoProjectMap)
@@ -26,6 +26,7 @@
 #include "ColourIDs.h"
 #include "HelioTheme.h"
 #include "PianoProjectMap.h"
+#include "UiProfiler.h"
 
 ProjectMapScroller::ProjectMapScroller(Transport &transportRef, SafePointer<HybridRoll> roll) :
     transport(transportRef),
@@ -211,6 +212,8 @@ void ProjectMapScroller::resized()
 
 void ProjectMapScroller::paint(Graphics &g)
 {
+    UI_PROFILER_PAINT_SCOPE("ProjectMapScroller", g);
+
     const auto &theme = HelioTheme::getCurrentTheme();
     g.setFillType({ theme.getBgCacheC(), {} });
     g.fillRect(this->getLocalBounds());
@@ -254,7 +257,7 @@ void ProjectMapScroller::mouseWheelMove(const MouseEvent &event, const MouseWhee
 
 void ProjectMapScroller::onMidiRollMoved(HybridRoll *targetRoll)
 {
-    if (this->isVisible() && this->roll == targetRoll && !this->isTimerRunning())
+    if (this->isVisible() && this->roll == targetRoll && !this->isAnimating())
     {
         this->triggerAsyncUpdate();
     }
@@ -262,7 +265,7 @@ void ProjectMapScroller::onMidiRollMoved(HybridRoll *targetRoll)
 
 void ProjectMapScroller::onMidiRollResized(HybridRoll *targetRoll)
 {
-    if (this->isVisible() && this->roll == targetRoll && !this->isTimerRunning())
+    if (this->isVisible() && this->roll == targetRoll && !this->isAnimating())
     {
         this->triggerAsyncUpdate();
     }
@@ -274,11 +277,11 @@ void ProjectMapScroller::switchToRoll(SafePointer<HybridRoll> roll)
     this->oldAreaBounds = this->getIndicatorBounds();
     this->oldMapBounds = this->getMapBounds().toFloat();
     this->roll = roll;
-    this->startTimerHz(60);
+    this->startAnimating();
 }
 
 //===----------------------------------------------------------------------===//
-// Timer
+// AnimationClock::Listener
 //===----------------------------------------------------------------------===//
 
 static Rectangle<float> lerpRectangle(const Rectangle<float> &r1,
@@ -311,7 +314,7 @@ static float getRectangleDistance(const Rectangle<float> &r1,
         fabs(r1.getHeight() - r2.getHeight());
 }
 
-void ProjectMapScroller::timerCallback()
+void ProjectMapScroller::onAnimationFrame()
 {
     const auto mb = this->getMapBounds().toFloat();
     const auto mbLerp = lerpRectangle(this->oldMapBounds, mb, 0.2f);
@@ -335,7 +338,7 @@ void ProjectMapScroller::timerCallback()
 
     if (shouldStop)
     {
-        this->stopTimer();
+        this->stopAnimating();
     }
 }
 
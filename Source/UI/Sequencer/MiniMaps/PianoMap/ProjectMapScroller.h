@@ -26,12 +26,13 @@ class Transport;
 #include "HelperRectangle.h"
 #include "HybridRollListener.h"
 #include "ComponentFader.h"
+#include "AnimationClock.h"
 
 class ProjectMapScroller final :
     public Component,
     public HybridRollListener,
     private AsyncUpdater,
-    private Timer
+    private AnimationClock::Listener
 {
 public:
 
@@ -112,7 +113,7 @@ protected:
 private:
     
     void handleAsyncUpdate() override;
-    void timerCallback() override;
+    void onAnimationFrame() override;
     
     Transport &transport;
     SafePointer<HybridRoll> roll;
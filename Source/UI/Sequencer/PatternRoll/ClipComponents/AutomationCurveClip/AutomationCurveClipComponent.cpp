@@ -18,7 +18,6 @@
 #include "Common.h"
 #include "AutomationCurveClipComponent.h"
 #include "AutomationCurveEventComponent.h"
-#include "AutomationCurveEventsConnector.h"
 #include "AutomationCurveHelper.h"
 #include "ProjectNode.h"
 #include "MidiSequence.h"
@@ -60,6 +59,18 @@ AutomationCurveClipComponent::~AutomationCurveClipComponent()
 // Component
 //===----------------------------------------------------------------------===//
 
+void AutomationCurveClipComponent::paint(Graphics &g)
+{
+    ClipComponent::paint(g);
+
+    // keeps the colour left by the base class, as the child components do
+    this->updateCurvePointsIfNeeded();
+    for (const auto &p : this->curvePoints)
+    {
+        g.fillRect(p.getX() - 1.f, p.getY() - 0.75f, 2.f, 1.5f);
+    }
+}
+
 void AutomationCurveClipComponent::mouseDown(const MouseEvent &e)
 {
     if (!this->project.getEditMode().forcesAddingEvents())
@@ -126,10 +137,10 @@ void AutomationCurveClipComponent::resized()
     // затем - зависимые элементы
     for (int i = 0; i < this->eventComponents.size(); ++i)
     {
-        auto *c = this->eventComponents.getUnchecked(i);
-        c->updateConnector();
-        c->updateHelper();
+        this->eventComponents.getUnchecked(i)->updateHelper();
     }
+
+    this->invalidateCurvePoints();
     
     this->setVisible(true);
 }
@@ -268,6 +279,7 @@ void AutomationCurveClipComponent::onChangeMidiEvent(const MidiEvent &oldEvent,
             this->eventsHash.erase(autoEvent);
             this->eventsHash[newAutoEvent] = component;
             
+            this->invalidateCurvePoints();
             this->roll.triggerBatchRepaintFor(this);
         }
     }
@@ -305,6 +317,7 @@ void AutomationCurveClipComponent::onAddMidiEvent(const MidiEvent &event)
             this->addNewEventMode = false;
         }
 
+        this->invalidateCurvePoints();
         this->roll.triggerBatchRepaintFor(this);
     }
 }
@@ -333,6 +346,7 @@ void AutomationCurveClipComponent::onRemoveMidiEvent(const MidiEvent &event)
             
             this->eventComponents.removeObject(component, true);
             
+            this->invalidateCurvePoints();
             this->roll.triggerBatchRepaintFor(this);
         }
     }
@@ -378,10 +392,53 @@ void AutomationCurveClipComponent::onRemoveTrack(MidiTrack *const track)
 void AutomationCurveClipComponent::updateCurveComponent(AutomationCurveEventComponent *component)
 {
     component->setBounds(this->getEventBounds(component));
-    component->updateConnector();
     component->updateHelper();
 }
 
+void AutomationCurveClipComponent::invalidateCurvePoints()
+{
+    this->curvePointsOutdated = true;
+}
+
+void AutomationCurveClipComponent::updateCurvePointsIfNeeded()
+{
+    if (!this->curvePointsOutdated)
+    {
+        return;
+    }
+
+    this->curvePoints.clearQuick();
+    this->curvePointsOutdated = false;
+
+    const auto *autoSequence = dynamic_cast<const AutomationSequence *>(this->sequence.get());
+    const float sequenceLength = autoSequence != nullptr ? autoSequence->getLengthInBeats() : 0.f;
+    if (sequenceLength <= 0.f || this->getWidth() == 0)
+    {
+        return;
+    }
+
+    const float firstBeat = autoSequence->getFirstBeat();
+    const float w = float(this->getWidth());
+    const float h = float(this->getAvailableHeight());
+
+    for (const auto &curvePoint : autoSequence->getInterpolatedCurve())
+    {
+        const Point<float> p(w * ((curvePoint.beat - firstBeat) / sequenceLength),
+            h * (1.f - curvePoint.controllerValue)); // upside down flip
+
+        if (!this->curvePoints.isEmpty())
+        {
+            const auto &last = this->curvePoints.getReference(this->curvePoints.size() - 1);
+            if (fabsf(p.getX() - last.getX()) < 1.f && fabsf(p.getY() - last.getY()) < 1.f)
+            {
+                continue;
+            }
+        }
+
+        this->curvePoints.add(p);
+    }
+}
+
 void AutomationCurveClipComponent::reloadTrack()
 {
     for (int i = 0; i < this->eventComponents.size(); ++i)
@@ -421,7 +478,7 @@ void AutomationCurveClipComponent::reloadTrack()
         }
     }
 
-    this->resized(); // Re-calculates children bounds
+    this->resized(); // Re-calculates children bounds and the curve
     this->roll.triggerBatchRepaintFor(this);
     this->setVisible(true);
 }
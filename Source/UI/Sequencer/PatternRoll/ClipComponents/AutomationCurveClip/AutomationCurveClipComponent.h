@@ -41,6 +41,7 @@ public:
     // Component
     //===------------------------------------------------------------------===//
 
+    void paint(Graphics &g) override;
     void mouseDown(const MouseEvent &e) override;
     void mouseDrag(const MouseEvent &e) override;
     void mouseUp(const MouseEvent &e) override;
@@ -94,6 +95,15 @@ private:
     ProjectNode &project;
     WeakReference<MidiSequence> sequence;
 
+    // the curve between the events is drawn here as a bunch of dots,
+    // instead of having a connector component for each pair of events;
+    // the points are taken from the sequence's cached interpolated curve,
+    // and reduced to at most one per pixel, rebuilt after any changes
+    Array<Point<float>> curvePoints;
+    bool curvePointsOutdated = true;
+    void updateCurvePointsIfNeeded();
+    void invalidateCurvePoints();
+
     OwnedArray<AutomationCurveEventComponent> eventComponents;
     FlatHashMap<AutomationEvent, AutomationCurveEventComponent *, MidiEventHash> eventsHash;
 
@@ -19,7 +19,6 @@
 #include "AutomationCurveEventComponent.h"
 #include "AutomationCurveClipComponent.h"
 #include "AutomationCurveHelper.h"
-#include "AutomationCurveEventsConnector.h"
 #include "AutomationSequence.h"
 #include "MidiTrack.h"
 
@@ -38,7 +37,6 @@ AutomationCurveEventComponent::AutomationCurveEventComponent(AutomationCurveClip
     this->setInterceptsMouseClicks(true, false);
     this->setMouseClickGrabsKeyboardFocus(false);
     this->setPaintingIsUnclipped(true);
-    this->recreateConnector();
 }
 
 bool AutomationCurveEventComponent::isTempoCurve() const noexcept
@@ -158,13 +156,6 @@ void AutomationCurveEventComponent::mouseUp(const MouseEvent &e)
     }
 }
 
-void AutomationCurveEventComponent::recreateConnector()
-{
-    this->connector.reset(new AutomationCurveEventsConnector(this, this->nextEventHolder));
-    this->editor.addAndMakeVisible(this->connector.get());
-    this->updateConnector();
-}
-
 void AutomationCurveEventComponent::recreateHelper()
 {
     this->helper.reset(new AutomationCurveHelper(this->event, this->editor, this, this->nextEventHolder));
@@ -172,21 +163,19 @@ void AutomationCurveEventComponent::recreateHelper()
     this->updateHelper();
 }
 
-void AutomationCurveEventComponent::updateConnector()
-{
-    this->connector->resizeToFit(this->event.getCurvature());
-}
-
 void AutomationCurveEventComponent::updateHelper()
 {
     if (this->helper && this->nextEventHolder)
     {
+        // the helper sits in the middle of the curve between this event and the next one
         const float d = this->editor.getHelperDiameter();
-        const Point<int> linePos(this->connector->getPosition());
-        const Point<float> lineCentre(this->connector->getCentrePoint());
-        Rectangle<int> bounds(linePos.getX() + int(lineCentre.getX()) - int(d / 2),
-            linePos.getY() + int(lineCentre.getY() + 0.5f - (d / 2.f)), int(d), int(d));
-        this->helper->setBounds(bounds);
+        const auto c1 = this->getBounds().getCentre().toFloat();
+        const auto c2 = this->nextEventHolder->getBounds().getCentre().toFloat();
+        const float y1 = jmin(c1.getY(), c2.getY());
+        const float y2 = jmax(c1.getY(), c2.getY());
+        const float x = jmin(c1.getX(), c2.getX()) + fabsf(c2.getX() - c1.getX()) / 2.f;
+        const float y = y1 + (y2 - y1) * (1.f - this->event.getCurvature());
+        this->helper->setBounds(int(x - d / 2.f), int(y + 0.5f - d / 2.f), int(d), int(d));
     }
 }
 
@@ -194,13 +183,11 @@ void AutomationCurveEventComponent::setNextNeighbour(AutomationCurveEventCompone
 {
     if (next == this->nextEventHolder)
     {
-        this->updateConnector();
         this->updateHelper();
         return;
     }
 
     this->nextEventHolder = next;
-    this->recreateConnector();
 
     if (this->nextEventHolder == nullptr)
     {
@@ -22,7 +22,6 @@
 #include "FineTuningValueIndicator.h"
 #include "ComponentFader.h"
 
-class AutomationCurveEventsConnector;
 class AutomationCurveHelper;
 class AutomationCurveClipComponent;
 
@@ -36,7 +35,6 @@ public:
     inline float getControllerValue() const noexcept { return this->event.getControllerValue(); }
     inline const AutomationEvent &getEvent() const noexcept { return this->event; };
 
-    void updateConnector();
     void updateHelper();
     void setNextNeighbour(AutomationCurveEventComponent *next);
 
@@ -76,10 +74,8 @@ private:
     const int controllerNumber;
     bool isTempoCurve() const noexcept;
 
-    void recreateConnector();
     void recreateHelper();
 
-    UniquePointer<AutomationCurveEventsConnector> connector;
     UniquePointer<AutomationCurveHelper> helper;
     SafePointer<AutomationCurveEventComponent> nextEventHolder;
 
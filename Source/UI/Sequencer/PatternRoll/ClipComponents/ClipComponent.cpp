@@ -90,9 +90,9 @@ const String &ClipComponent::getSelectionGroupId() const noexcept
     return this->clip.getPattern()->getTrackId();
 }
 
-const String &ClipComponent::getId() const noexcept
+int ClipComponent::compareIds(const MidiEventComponent &other) const noexcept
 {
-    return this->clip.getId();
+    return this->clip.getId().compare(static_cast<const ClipComponent &>(other).clip.getId());
 }
 
 //===----------------------------------------------------------------------===//
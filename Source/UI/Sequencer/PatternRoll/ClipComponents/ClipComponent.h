@@ -55,7 +55,7 @@ public:
     void setSelected(bool selected) override;
     const String &getSelectionGroupId() const noexcept override;
     float getBeat() const noexcept override;
-    const String &getId() const noexcept override;
+    int compareIds(const MidiEventComponent &other) const noexcept override;
 
     //===------------------------------------------------------------------===//
     // Component
@@ -21,9 +21,10 @@
 #include "MidiSequence.h"
 #include "PianoSequence.h"
 #include "PlayerThread.h"
-#include "HybridRoll.h"
+#include "PatternRoll.h"
 #include "AnnotationEvent.h"
 #include "MidiTrack.h"
+#include "UiProfiler.h"
 
 PianoClipComponent::PianoClipComponent(ProjectNode &project, MidiSequence *sequence,
     HybridRoll &roll, const Clip &clip) :
@@ -32,7 +33,6 @@ PianoClipComponent::PianoClipComponent(ProjectNode &project, MidiSequence *seque
     sequence(sequence)
 {
     this->setPaintingIsUnclipped(true);
-    this->reloadTrackMap();
     this->project.addListener(this);
 }
 
@@ -47,21 +47,57 @@ PianoClipComponent::~PianoClipComponent()
 
 void PianoClipComponent::paint(Graphics &g)
 {
+    UI_PROFILER_PAINT_SCOPE("PianoClipComponent", g);
+
     // Draw the frame, set the colour, etc:
     ClipComponent::paint(g);
 
-    for (const auto &note : this->displayedNotes)
+    const auto *pianoSequence = dynamic_cast<const PianoSequence *>(this->sequence.get());
+    if (pianoSequence == nullptr)
+    {
+        return;
+    }
+
+    const auto &notes = pianoSequence->getPackedNotes();
+    const float sequenceLength = pianoSequence->getLengthInBeats();
+    const float firstBeat = pianoSequence->getFirstBeat();
+    const float width = static_cast<float>(this->getWidth());
+    const float h = static_cast<float>(this->getHeight());
+    const auto clipKey = this->clip.getKey();
+
+    if (notes.size() == 0 || width <= 0.f)
     {
-        const auto *ns = note.getSequence();
-        const float sequenceLength = ns->getLengthInBeats();
-        const float beat = note.getBeat() - ns->getFirstBeat();
-        const auto key = jlimit(0, 128, note.getKey() + this->clip.getKey());
-        const float x = static_cast<float>(this->getWidth()) * (beat / sequenceLength);
-        const float w = static_cast<float>(this->getWidth()) * (note.getLength() / sequenceLength);
-        const float h = static_cast<float>(this->getHeight());
+        return;
+    }
+
+    // all instances of the sequence share the same cached strip
+    const int keyOffset = roundToInt(clipKey * h / 128.f);
+    if (this->getRoll().drawPianoClipThumbnail(g, *pianoSequence,
+        this->getWidth(), this->getHeight(), keyOffset))
+    {
+        return;
+    }
+
+    // the clip may be way wider than the screen, so only collect the visible notes
+    const auto paintArea = g.getClipBounds().toFloat();
+    const auto candidates = notes.getCandidatesInRange(
+        firstBeat + sequenceLength * paintArea.getX() / width,
+        firstBeat + sequenceLength * paintArea.getRight() / width);
+
+    RectangleList<float> rectangles;
+    rectangles.ensureStorageAllocated(candidates.getLength());
+
+    for (int i = candidates.getStart(); i < candidates.getEnd(); ++i)
+    {
+        const float beat = notes.beats.getUnchecked(i) - firstBeat;
+        const auto key = jlimit(0, 128, notes.keys.getUnchecked(i) + clipKey);
+        const float x = width * (beat / sequenceLength);
+        const float w = width * (notes.lengths.getUnchecked(i) / sequenceLength);
         const int y = static_cast<int>(h - key * h / 128.f);
-        g.fillRect(x, static_cast<float>(y), jmax(0.25f, w), 1.f);
+        rectangles.addWithoutMerging({ x, static_cast<float>(y), jmax(0.25f, w), 1.f });
     }
+
+    g.fillRectList(rectangles);
 }
 
 //===----------------------------------------------------------------------===//
@@ -72,16 +108,8 @@ void PianoClipComponent::onChangeMidiEvent(const MidiEvent &oldEvent, const Midi
 {
     if (oldEvent.isTypeOf(MidiEvent::Type::Note))
     {
-        const Note &note = static_cast<const Note &>(oldEvent);
         const Note &newNote = static_cast<const Note &>(newEvent);
         if (newNote.getSequence() != this->sequence) { return; }
-
-        if (this->displayedNotes.contains(note))
-        {
-            this->displayedNotes.erase(note);
-            this->displayedNotes.insert(newNote);
-        }
-
         this->roll.triggerBatchRepaintFor(this);
     }
 }
@@ -92,8 +120,6 @@ void PianoClipComponent::onAddMidiEvent(const MidiEvent &event)
     {
         const Note &note = static_cast<const Note &>(event);
         if (note.getSequence() != this->sequence) { return; }
-
-        this->displayedNotes.insert(note);
         this->roll.triggerBatchRepaintFor(this);
     }
 }
@@ -104,16 +130,29 @@ void PianoClipComponent::onRemoveMidiEvent(const MidiEvent &event)
     {
         const Note &note = static_cast<const Note &>(event);
         if (note.getSequence() != this->sequence) { return; }
-
-        if (this->displayedNotes.contains(note))
-        {
-            this->displayedNotes.erase(note);
-        }
-
         this->roll.triggerBatchRepaintFor(this);
     }
 }
 
+void PianoClipComponent::onAddMidiEvents(const Array<const MidiEvent *> &events)
+{
+    if (events.isEmpty()) { return; }
+    this->onAddMidiEvent(*events.getFirst());
+}
+
+void PianoClipComponent::onChangeMidiEvents(const Array<const MidiEvent *> &oldEvents,
+    const Array<const MidiEvent *> &newEvents)
+{
+    if (newEvents.isEmpty()) { return; }
+    this->onChangeMidiEvent(*oldEvents.getFirst(), *newEvents.getFirst());
+}
+
+void PianoClipComponent::onRemoveMidiEvents(const Array<const MidiEvent *> &events)
+{
+    if (events.isEmpty()) { return; }
+    this->onRemoveMidiEvent(*events.getFirst());
+}
+
 void PianoClipComponent::onChangeClip(const Clip &oldClip, const Clip &newClip)
 {
     if (this->clip == oldClip)
@@ -133,7 +172,6 @@ void PianoClipComponent::onReloadProjectContent(const Array<MidiTrack *> &tracks
 {
     if (this->sequence != nullptr)
     {
-        this->reloadTrackMap();
         this->roll.triggerBatchRepaintFor(this);
     }
 }
@@ -143,7 +181,6 @@ void PianoClipComponent::onAddTrack(MidiTrack *const track)
     if (track->getSequence() == this->sequence &&
         track->getSequence()->size() > 0)
     {
-        this->reloadTrackMap();
         this->roll.triggerBatchRepaintFor(this);
     }
 }
@@ -151,37 +188,5 @@ void PianoClipComponent::onAddTrack(MidiTrack *const track)
 void PianoClipComponent::onRemoveTrack(MidiTrack *const track)
 {
     if (track->getSequence() != this->sequence) { return; }
-
-    for (int i = 0; i < track->getSequence()->size(); ++i)
-    {
-        const Note &note = static_cast<const Note &>(*track->getSequence()->getUnchecked(i));
-        if (this->displayedNotes.contains(note))
-        {
-            this->displayedNotes.erase(note);
-        }
-    }
-}
-
-//===----------------------------------------------------------------------===//
-// Private
-//===----------------------------------------------------------------------===//
-
-void PianoClipComponent::reloadTrackMap()
-{
-    this->displayedNotes.clear();
-
-    for (auto *track : this->project.getTracks())
-    {
-        if (track->getSequence() != this->sequence) { continue; }
-
-        for (int j = 0; j < track->getSequence()->size(); ++j)
-        {
-            auto *event = track->getSequence()->getUnchecked(j);
-            if (event != nullptr && event->isTypeOf(MidiEvent::Type::Note))
-            {
-                auto *note = static_cast<Note *>(event);
-                this->displayedNotes.insert(*note);
-            }
-        }
-    }
+    this->roll.triggerBatchRepaintFor(this);
 }
@@ -58,8 +58,15 @@
 #include "ColourIDs.h"
 #include "Config.h"
 #include "Icons.h"
+#include "MessageThreadWatchdog.h"
+#include "MemoryBudget.h"
+#include "UiProfiler.h"
 
 #define DEFAULT_CLIP_LENGTH 1.0f
+#define PATTERN_ROLL_INDEX_CELL_BEATS (float(BEATS_PER_BAR * 4))
+#define PATTERN_ROLL_INDEX_CELL_ROWS 1
+#define PATTERN_ROLL_THUMBNAIL_TILE_WIDTH 512
+#define PATTERN_ROLL_MAX_THUMBNAIL_HEIGHT 1024
 
 inline static constexpr int rowHeight()
 {
@@ -116,17 +123,34 @@ static void updateTrackRowPosition(Array<String> &rows,
 PatternRoll::PatternRoll(ProjectNode &parentProject,
     Viewport &viewportRef,
     WeakReference<AudioMonitor> clippingDetector) :
-    HybridRoll(parentProject, viewportRef, clippingDetector, false, false, true)
+    HybridRoll(parentProject, viewportRef, clippingDetector, false, false, true),
+    clipsIndex(PATTERN_ROLL_INDEX_CELL_BEATS, PATTERN_ROLL_INDEX_CELL_ROWS)
 {
     this->selectedClipsMenuManager.reset(new PatternRollSelectionMenuManager(&this->selection));
 
     this->setComponentID(ComponentIDs::patternRollId);
 
+    App::Memory().registerCache(this, MemoryBudget::Priority::Normal);
+
+    // roughly, since the clip components of different kinds differ in size
+    this->memoryAccount = makeUnique<MemoryBudget::Account>("Roll components",
+        [this](int &numItems, int64 &numBytes)
+        {
+            numItems += int(this->clipComponents.size());
+            numBytes += int64(this->clipComponents.size()) * sizeof(ClipComponent);
+        });
+
     this->repaintBackgroundsCache();
     this->reloadRollContent();
     this->setBeatRange(0, PROJECT_DEFAULT_NUM_BEATS);
 }
 
+PatternRoll::~PatternRoll()
+{
+    this->memoryAccount = nullptr;
+    App::Memory().unregisterCache(this);
+}
+
 void PatternRoll::selectAll()
 {
     for (const auto &e : this->clipComponents)
@@ -162,13 +186,16 @@ static ClipComponent *createClipComponentFor(MidiTrack *track,
 
 void PatternRoll::reloadRollContent()
 {
+    HYBRID_ROLL_BULK_REPAINT_START
+
     this->selection.deselectAll();
     this->clipComponents.clear();
+    this->clipsIndexIsDirty = true;
+    this->forgetAllPianoClipThumbnails();
+    this->resetVisibleBeatLines();
     this->tracks.clearQuick();
     this->rows.clearQuick();
 
-    HYBRID_ROLL_BULK_REPAINT_START
-
     for (auto *track : this->project.getTracks())
     {
         // Only show tracks with patterns (i.e. ignore timeline tracks)
@@ -244,8 +271,7 @@ void PatternRoll::showGhostClipFor(ClipComponent *targetClipComponent)
     this->addAndMakeVisible(component);
     this->ghostClips.add(component);
 
-    this->batchRepaintList.add(component);
-    this->triggerAsyncUpdate();
+    this->triggerBatchRepaintFor(component);
 }
 
 void PatternRoll::hideAllGhostClips()
@@ -318,6 +344,38 @@ float PatternRoll::getBeatByMousePosition(const Pattern *pattern, int x) const
 // ProjectListener
 //===----------------------------------------------------------------------===//
 
+// apart from the thumbnails, only time signatures matter here, see HybridRoll
+
+void PatternRoll::onAddMidiEvent(const MidiEvent &event)
+{
+    if (event.isTypeOf(MidiEvent::Type::Note))
+    {
+        this->forgetPianoClipThumbnail(event.getSequence());
+    }
+
+    HybridRoll::onAddMidiEvent(event);
+}
+
+void PatternRoll::onChangeMidiEvent(const MidiEvent &e1, const MidiEvent &e2)
+{
+    if (e1.isTypeOf(MidiEvent::Type::Note))
+    {
+        this->forgetPianoClipThumbnail(e2.getSequence());
+    }
+
+    HybridRoll::onChangeMidiEvent(e1, e2);
+}
+
+void PatternRoll::onRemoveMidiEvent(const MidiEvent &event)
+{
+    if (event.isTypeOf(MidiEvent::Type::Note))
+    {
+        this->forgetPianoClipThumbnail(event.getSequence());
+    }
+
+    HybridRoll::onRemoveMidiEvent(event);
+}
+
 void PatternRoll::onAddTrack(MidiTrack *const track)
 {
     if (Pattern *pattern = track->getPattern())
@@ -336,6 +394,8 @@ void PatternRoll::onAddTrack(MidiTrack *const track)
         }
     }
 
+    this->clipsIndexIsDirty = true;
+
     // Roll size might need to be changed
     this->updateRollSize();
 
@@ -371,6 +431,7 @@ void PatternRoll::onChangeTrackProperties(MidiTrack *const track)
         }
     }
 
+    this->clipsIndexIsDirty = true;
     this->updateRollSize();
     this->resized();
 }
@@ -381,6 +442,7 @@ void PatternRoll::onRemoveTrack(MidiTrack *const track)
     this->hideAllGhostClips();
 
     this->tracks.removeAllInstancesOf(track);
+    this->forgetPianoClipThumbnail(track->getSequence());
     this->reloadRowsGrouping();
 
     if (Pattern *pattern = track->getPattern())
@@ -395,6 +457,7 @@ void PatternRoll::onRemoveTrack(MidiTrack *const track)
         }
     }
 
+    this->clipsIndexIsDirty = true;
     this->updateRollSize();
     this->resized();
 }
@@ -405,13 +468,13 @@ void PatternRoll::onAddClip(const Clip &clip)
     if (auto *clipComponent = createClipComponentFor(track, clip, this->project, *this))
     {
         this->clipComponents[clip] = UniquePointer<ClipComponent>(clipComponent);
+        this->clipsIndexIsDirty = true;
         this->addAndMakeVisible(clipComponent);
         clipComponent->toFront(false);
 
         this->fader.fadeIn(clipComponent, 150);
 
-        this->batchRepaintList.add(clipComponent);
-        this->triggerAsyncUpdate();
+        this->triggerBatchRepaintFor(clipComponent);
 
         if (this->addNewClipMode)
         {
@@ -428,9 +491,9 @@ void PatternRoll::onChangeClip(const Clip &clip, const Clip &newClip)
     {
         this->clipComponents.erase(clip);
         this->clipComponents[newClip] = UniquePointer<ClipComponent>(component);
+        this->clipsIndexIsDirty = true;
 
-        this->batchRepaintList.add(component);
-        this->triggerAsyncUpdate();
+        this->triggerBatchRepaintFor(component);
     }
 }
 
@@ -443,6 +506,7 @@ void PatternRoll::onRemoveClip(const Clip &clip)
         this->fader.fadeOut(deletedComponent, 150);
         this->selection.deselect(deletedComponent);
         this->clipComponents.erase(clip);
+        this->clipsIndexIsDirty = true;
     }
 }
 
@@ -450,6 +514,7 @@ void PatternRoll::onPostRemoveClip(Pattern *const pattern) {}
 
 void PatternRoll::onReloadProjectContent(const Array<MidiTrack *> &tracks)
 {
+    WATCHDOG_SCOPE("PatternRoll::onReloadProjectContent");
     this->reloadRollContent();
 }
 
@@ -478,15 +543,21 @@ void PatternRoll::selectEventsInRange(float startBeat, float endBeat, bool shoul
 
 void PatternRoll::findLassoItemsInArea(Array<SelectableComponent *> &itemsFound, const Rectangle<int> &rectangle)
 {
-    for (const auto &e : this->clipComponents)
+    // only the clips highlighted by the previous lasso update need to be reset
+    Array<ClipComponent *> candidates;
+    this->findClipsNear(this->lastLassoArea, candidates);
+    this->lastLassoArea = rectangle;
+
+    for (auto *component : candidates)
     {
-        const auto component = e.second.get();
         component->setSelected(this->selection.isSelected(component));
     }
 
-    for (const auto &e : this->clipComponents)
+    candidates.clearQuick();
+    this->findClipsNear(rectangle, candidates);
+
+    for (auto *component : candidates)
     {
-        const auto component = e.second.get();
         if (rectangle.intersects(component->getBounds()) && component->isActive())
         {
             jassert(!itemsFound.contains(component));
@@ -495,6 +566,52 @@ void PatternRoll::findLassoItemsInArea(Array<SelectableComponent *> &itemsFound,
     }
 }
 
+void PatternRoll::rebuildClipsIndexIfNeeded()
+{
+    if (!this->clipsIndexIsDirty)
+    {
+        return;
+    }
+
+    this->clipsIndex.clear();
+
+    for (const auto &e : this->clipComponents)
+    {
+        const auto bounds = e.second->getBounds();
+        const int row = (bounds.getY() - HYBRID_ROLL_HEADER_HEIGHT) / rowHeight();
+        this->clipsIndex.set(e.first,
+            this->getBeatByXPosition(float(bounds.getX())),
+            this->getBeatByXPosition(float(bounds.getRight())), row, row);
+    }
+
+    this->clipsIndexIsDirty = false;
+}
+
+void PatternRoll::findClipsNear(const Rectangle<int> &area, Array<ClipComponent *> &result)
+{
+    if (area.isEmpty())
+    {
+        return;
+    }
+
+    this->rebuildClipsIndexIfNeeded();
+
+    const float startBeat = this->getBeatByXPosition(float(area.getX()));
+    const float endBeat = this->getBeatByXPosition(float(area.getRight()));
+    const int startRow = (area.getY() - HYBRID_ROLL_HEADER_HEIGHT) / rowHeight() - 1;
+    const int endRow = (area.getBottom() - HYBRID_ROLL_HEADER_HEIGHT) / rowHeight() + 1;
+
+    this->clipsIndex.findItemsNear(startBeat, endBeat, startRow, endRow,
+        [this, &result](const Clip &clip)
+    {
+        const auto component = this->clipComponents.find(clip);
+        if (component != this->clipComponents.end())
+        {
+            result.add(component->second.get());
+        }
+    });
+}
+
 //===----------------------------------------------------------------------===//
 // SmoothZoomListener
 //===----------------------------------------------------------------------===//
@@ -727,6 +844,8 @@ void PatternRoll::resized()
         c->setFloatBounds(this->getEventBounds(c));
     }
 
+    this->clipsIndexIsDirty = true;
+
     if (this->knifeToolHelper != nullptr)
     {
         this->knifeToolHelper->updateBounds(true);
@@ -739,8 +858,10 @@ void PatternRoll::resized()
 
 void PatternRoll::paint(Graphics &g)
 {
+    UI_PROFILER_PAINT_SCOPE("PatternRoll", g);
+
     g.setTiledImageFill(this->rowPattern, 0, HYBRID_ROLL_HEADER_HEIGHT, 1.f);
-    g.fillRect(this->viewport.getViewArea());
+    g.fillRect(this->viewport.getViewArea().getIntersection(g.getClipBounds()));
     HybridRoll::paint(g);
 }
 
@@ -953,6 +1074,138 @@ void PatternRoll::reset() {}
 // Background image cache
 //===----------------------------------------------------------------------===//
 
+bool PatternRoll::drawPianoClipThumbnail(Graphics &g,
+    const PianoSequence &sequence, int width, int height, int keyOffset)
+{
+    if (width <= 0 || height <= 0 || height > PATTERN_ROLL_MAX_THUMBNAIL_HEIGHT)
+    {
+        return false;
+    }
+
+    const auto entryId = int64(pointer_sized_int(&sequence));
+    auto &strip = this->pianoClipThumbnails[&sequence];
+    if (strip.version != sequence.getVersion() ||
+        strip.width != width || strip.height != height)
+    {
+        // zoomed or edited: the tiles are re-rendered as they get painted
+        strip.tiles.clear();
+        strip.version = sequence.getVersion();
+        strip.width = width;
+        strip.height = height;
+        strip.cost = 0;
+        App::Memory().removeEntry(this, entryId);
+    }
+
+    // the painting is unclipped, so don't let the shifted tiles out
+    const auto paintArea = g.getClipBounds().getIntersection({ 0, 0, width, height });
+    if (paintArea.isEmpty())
+    {
+        return true;
+    }
+
+    Graphics::ScopedSaveState s(g);
+    g.reduceClipRegion(paintArea);
+
+    bool hasNewTiles = false;
+    const int firstTile = paintArea.getX() / PATTERN_ROLL_THUMBNAIL_TILE_WIDTH;
+    const int lastTile = (paintArea.getRight() - 1) / PATTERN_ROLL_THUMBNAIL_TILE_WIDTH;
+    for (int i = firstTile; i <= lastTile; ++i)
+    {
+        auto &tile = strip.tiles[i];
+        if (!tile.isValid())
+        {
+            tile = renderPianoClipTile(sequence, width, height, i);
+            strip.cost += MemoryBudget::getImageCost(tile);
+            hasNewTiles = true;
+        }
+
+        // the tiles are rendered without the clip's key offset
+        g.drawImageAt(tile, i * PATTERN_ROLL_THUMBNAIL_TILE_WIDTH, -keyOffset, true);
+    }
+
+    if (hasNewTiles)
+    {
+        App::Memory().addEntry(this, entryId, strip.cost);
+    }
+    else
+    {
+        App::Memory().touchEntry(this, entryId);
+    }
+
+    return true;
+}
+
+Image PatternRoll::renderPianoClipTile(const PianoSequence &sequence,
+    int width, int height, int tileIndex)
+{
+    const int tileX = tileIndex * PATTERN_ROLL_THUMBNAIL_TILE_WIDTH;
+    const int tileWidth = jmin(PATTERN_ROLL_THUMBNAIL_TILE_WIDTH, width - tileX);
+    Image tile(Image::SingleChannel, tileWidth, height, true);
+
+    const auto &notes = sequence.getPackedNotes();
+    const float sequenceLength = sequence.getLengthInBeats();
+    const float firstBeat = sequence.getFirstBeat();
+    const float w = float(width);
+    const float h = float(height);
+
+    const auto candidates = notes.getCandidatesInRange(
+        firstBeat + sequenceLength * float(tileX) / w,
+        firstBeat + sequenceLength * float(tileX + tileWidth) / w);
+
+    RectangleList<float> rectangles;
+    rectangles.ensureStorageAllocated(candidates.getLength());
+
+    for (int i = candidates.getStart(); i < candidates.getEnd(); ++i)
+    {
+        const float beat = notes.beats.getUnchecked(i) - firstBeat;
+        const auto key = jlimit(0, 128, int(notes.keys.getUnchecked(i)));
+        const float x = w * (beat / sequenceLength) - float(tileX);
+        const float noteWidth = w * (notes.lengths.getUnchecked(i) / sequenceLength);
+        const int y = int(h - key * h / 128.f);
+        rectangles.addWithoutMerging({ x, float(y), jmax(0.25f, noteWidth), 1.f });
+    }
+
+    Graphics g(tile);
+    g.setColour(Colours::white);
+    g.fillRectList(rectangles);
+    return tile;
+}
+
+void PatternRoll::forgetPianoClipThumbnail(const MidiSequence *sequence)
+{
+    if (this->pianoClipThumbnails.erase(sequence) > 0)
+    {
+        App::Memory().removeEntry(this, int64(pointer_sized_int(sequence)));
+    }
+}
+
+void PatternRoll::forgetAllPianoClipThumbnails()
+{
+    this->pianoClipThumbnails.clear();
+    App::Memory().removeAllEntries(this);
+}
+
+//===----------------------------------------------------------------------===//
+// MemoryBudget::Cache
+//===----------------------------------------------------------------------===//
+
+String PatternRoll::getCacheName() const
+{
+    return "Pattern roll thumbnails";
+}
+
+void PatternRoll::evictCacheEntry(int64 entryId)
+{
+    for (auto it = this->pianoClipThumbnails.begin(); it != this->pianoClipThumbnails.end(); ++it)
+    {
+        if (int64(pointer_sized_int(it->first)) == entryId)
+        {
+            this->pianoClipThumbnails.erase(it);
+            return;
+        }
+    }
+}
+
 Image PatternRoll::renderRowsPattern(const HelioTheme &theme, int height)
 {
     static const int width = 8;
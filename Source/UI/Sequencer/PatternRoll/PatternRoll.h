@@ -22,6 +22,7 @@
 
 class CutPointMark;
 class ClipComponent;
+class PianoSequence;
 class PatternRollSelectionMenuManager;
 
 #include "HelioTheme.h"
@@ -29,8 +30,12 @@ class PatternRollSelectionMenuManager;
 #include "MidiTrack.h"
 #include "Pattern.h"
 #include "Clip.h"
+#include "SpatialIndex.h"
+#include "MemoryBudget.h"
 
-class PatternRoll final : public HybridRoll
+class PatternRoll final :
+    public HybridRoll,
+    private MemoryBudget::Cache
 {
 public:
 
@@ -38,6 +43,8 @@ public:
         Viewport &viewportRef,
         WeakReference<AudioMonitor> clippingDetector);
 
+    ~PatternRoll() override;
+
     void selectAll() override;
     int getNumRows() const noexcept;
 
@@ -62,9 +69,9 @@ public:
     // ProjectListener
     //===------------------------------------------------------------------===//
 
-    void onAddMidiEvent(const MidiEvent &event) override {}
-    void onChangeMidiEvent(const MidiEvent &e1, const MidiEvent &e2) override {}
-    void onRemoveMidiEvent(const MidiEvent &event) override {}
+    void onAddMidiEvent(const MidiEvent &event) override;
+    void onChangeMidiEvent(const MidiEvent &e1, const MidiEvent &e2) override;
+    void onRemoveMidiEvent(const MidiEvent &event) override;
     void onPostRemoveMidiEvent(MidiSequence *const layer) override {}
 
     void onAddClip(const Clip &clip) override;
@@ -140,6 +147,14 @@ public:
     static Image renderRowsPattern(const HelioTheme &theme, int height);
     void repaintBackgroundsCache();
 
+    // all clips of a sequence look the same (except for the key offset),
+    // so they share a single-channel strip of its notes, rendered in tiles
+    // on demand at the current zoom level, and re-rendered after any change
+    // of the sequence version; each clip just blits the tiles it needs,
+    // and returns false for the sizes which can't be cached
+    bool drawPianoClipThumbnail(Graphics &g, const PianoSequence &sequence,
+        int width, int height, int keyOffset);
+
     void reloadRollContent();
     void insertNewClipAt(const MouseEvent &e);
 
@@ -169,6 +184,37 @@ private:
 
     using ClipComponentsMap = FlatHashMap<Clip, UniquePointer<ClipComponent>, ClipHash>;
     ClipComponentsMap clipComponents;
+    UniquePointer<MemoryBudget::Account> memoryAccount;
+
+    struct PianoClipStrip final
+    {
+        uint32 version = 0;
+        int width = 0;
+        int height = 0;
+        int64 cost = 0;
+        FlatHashMap<int, Image> tiles;
+    };
+
+    FlatHashMap<const MidiSequence *, PianoClipStrip> pianoClipThumbnails;
+    static Image renderPianoClipTile(const PianoSequence &sequence,
+        int width, int height, int tileIndex);
+    void forgetPianoClipThumbnail(const MidiSequence *sequence);
+    void forgetAllPianoClipThumbnails();
+
+    //===------------------------------------------------------------------===//
+    // MemoryBudget::Cache
+    //===------------------------------------------------------------------===//
+
+    String getCacheName() const override;
+    void evictCacheEntry(int64 entryId) override;
+
+    // clips' displayed beats and rows, rebuilt from their bounds when needed,
+    // since those also depend on the sequences' content and the grouping:
+    SpatialIndex<Clip, ClipHash> clipsIndex;
+    bool clipsIndexIsDirty = true;
+    void rebuildClipsIndexIfNeeded();
+    void findClipsNear(const Rectangle<int> &area, Array<ClipComponent *> &result);
+    Rectangle<int> lastLassoArea;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PatternRoll)
 };
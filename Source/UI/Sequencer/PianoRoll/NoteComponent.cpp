@@ -27,6 +27,7 @@
 #include "SequencerOperations.h"
 #include "Transport.h"
 #include "ColourIDs.h"
+#include "UiProfiler.h"
 
 #define RESIZE_CORNER 10
 #define MAX_DRAG_POLYPHONY 8
@@ -78,6 +79,48 @@ void NoteComponent::updateColours()
     this->colourVolume = this->colour.darker(0.8f).withAlpha(ghost ? 0.f : 0.5f);
 }
 
+Colour NoteComponent::getInactiveColour(const Colour &trackColour) noexcept
+{
+    // same as updateColours() for the inactive, non-selected notes
+    const auto base = findDefaultColour(ColourIDs::Roll::noteFill);
+    const auto colour = trackColour.interpolatedWith(base, 0.35f).withAlpha(0.3f);
+
+    return HelioTheme::getCurrentTheme().isDark() ?
+        colour.brighter(0.55f) : colour.darker(0.45f);
+}
+
+void NoteComponent::addInactiveShapes(const Rectangle<float> &bounds, Note::Tuplet tuplet,
+    RectangleList<float> &fill, RectangleList<float> &lighter, RectangleList<float> &darker)
+{
+    // same shapes as in paint(), except the volume bar, which is transparent
+    const float w = bounds.getWidth() - .5f;
+    const float h = bounds.getHeight();
+    const float x = bounds.getX();
+    const float y = bounds.getY();
+
+    fill.addWithoutMerging({ x + 0.5f, y + h / 6.f, 0.5f, h / 1.5f });
+
+    if (w >= 1.25f)
+    {
+        fill.addWithoutMerging({ x + w - 0.75f, y + h / 6.f, 0.5f, h / 1.5f });
+        fill.addWithoutMerging({ x + 0.75f, y + 1.f, w - 1.25f, h - 2.f });
+    }
+
+    if (w >= 2.25f)
+    {
+        lighter.addWithoutMerging({ x + 1.25f, roundf(y), w - 2.25f, 1.f });
+        darker.addWithoutMerging({ x + 1.25f, roundf(y + h - 1), w - 2.25f, 1.f });
+    }
+
+    if (tuplet > 1 && bounds.getWidth() > 25)
+    {
+        for (int i = 1; i < tuplet; ++i)
+        {
+            lighter.addWithoutMerging({ x + i * (w / tuplet) - 1.f, y, 1.f, h });
+        }
+    }
+}
+
 bool NoteComponent::canResize() const noexcept
 {
      return (this->getWidth() >= (RESIZE_CORNER * 2));
@@ -608,6 +651,8 @@ void NoteComponent::mouseDoubleClick(const MouseEvent &e) {}
 // or fillRect - these are the ones with minimal overhead:
 void NoteComponent::paint(Graphics &g) noexcept
 {
+    UI_PROFILER_PAINT_SCOPE("NoteComponent", g);
+
     const float w = this->floatLocalBounds.getWidth() - .5f; // a small gap between notes
     const float h = this->floatLocalBounds.getHeight();
     const float x = this->floatLocalBounds.getX();
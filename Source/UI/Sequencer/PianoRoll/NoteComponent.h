@@ -58,13 +58,20 @@ public:
 
     void updateColours() override;
 
+    // Notes outside of the editable scope have no components,
+    // the roll paints them in batches, grouping the shapes by colour:
+    static Colour getInactiveColour(const Colour &trackColour) noexcept;
+    static void addInactiveShapes(const Rectangle<float> &bounds, Note::Tuplet tuplet,
+        RectangleList<float> &fill, RectangleList<float> &lighter, RectangleList<float> &darker);
+
     //===------------------------------------------------------------------===//
     // MidiEventComponent
     //===------------------------------------------------------------------===//
 
     void setSelected(bool selected) override;
     const String &getSelectionGroupId() const noexcept override;
-    const String &getId() const noexcept override { return this->note.getId(); }
+    int compareIds(const MidiEventComponent &other) const noexcept override
+    { return this->note.getId().compare(static_cast<const NoteComponent &>(other).note.getId()); }
     float getBeat() const noexcept override { return this->note.getBeat(); }
 
     //===------------------------------------------------------------------===//
@@ -54,6 +54,7 @@
 #include "CommandPaletteChordConstructor.h"
 #include "LassoListeners.h"
 #include "UndoStack.h"
+#include "MidiRecorder.h"
 #include "Workspace.h"
 #include "MainLayout.h"
 #include "HelioTheme.h"
@@ -61,6 +62,9 @@
 #include "ColourIDs.h"
 #include "Config.h"
 #include "Icons.h"
+#include "MessageThreadWatchdog.h"
+#include "MemoryBudget.h"
+#include "UiProfiler.h"
 
 #define forEachEventOfGivenTrack(map, child, track) \
     for (const auto &_c : map) \
@@ -75,14 +79,19 @@
     for (const auto &_c : this->patternMap) \
         for (const auto &child : (*_c.second.get()))
 
+#define PIANOROLL_INDEX_CELL_BEATS (float(BEATS_PER_BAR))
+#define PIANOROLL_INDEX_CELL_KEYS 12
 
 PianoRoll::PianoRoll(ProjectNode &project, Viewport &viewport, WeakReference<AudioMonitor> clippingDetector) :
-    HybridRoll(project, viewport, clippingDetector)
+    HybridRoll(project, viewport, clippingDetector),
+    activeNotesIndex(PIANOROLL_INDEX_CELL_BEATS, PIANOROLL_INDEX_CELL_KEYS)
 {
     this->setComponentID(ComponentIDs::pianoRollId);
 
-    this->defaultHighlighting = makeUnique<HighlightingScheme>(0, Scale::getNaturalMajorScale());
-    this->defaultHighlighting->setRows(this->renderBackgroundCacheFor(this->defaultHighlighting.get()));
+    this->defaultHighlighting = makeUnique<HighlightingScheme>(0,
+        Scale::getNaturalMajorScale());
+
+    this->backgroundTiles->addClient(this);
 
     this->selectedNotesMenuManager = makeUnique<PianoRollSelectionMenuManager>(&this->selection, this->project);
 
@@ -103,17 +112,34 @@ PianoRoll::PianoRoll(ProjectNode &project, Viewport &viewport, WeakReference<Aud
     this->noteNameGuides->setVisible(noteNameGuidesEnabled);
 
     this->setBeatRange(0, PROJECT_DEFAULT_NUM_BEATS);
+
+    this->memoryAccount = makeUnique<MemoryBudget::Account>("Roll components",
+        [this](int &numItems, int64 &numBytes)
+        {
+            for (const auto &sequenceMap : this->patternMap)
+            {
+                const auto numComponents = int(sequenceMap.second->size());
+                numItems += numComponents;
+                numBytes += int64(numComponents) * sizeof(NoteComponent);
+            }
+        });
 }
 
-PianoRoll::~PianoRoll() {}
+PianoRoll::~PianoRoll()
+{
+    this->backgroundTiles->removeClient(this);
+}
 
 void PianoRoll::reloadRollContent()
 {
+    HYBRID_ROLL_BULK_REPAINT_START
+
     this->selection.deselectAll();
     this->backgroundsCache.clear();
     this->patternMap.clear();
-
-    HYBRID_ROLL_BULK_REPAINT_START
+    this->activeNotesIndex.clear();
+    this->notesWithOutdatedBounds.clear();
+    this->resetVisibleBeatLines();
 
     const auto &tracks = this->project.getTracks();
     for (const auto *track : tracks)
@@ -147,25 +173,244 @@ void PianoRoll::loadTrack(const MidiTrack *const track)
     for (int i = 0; i < track->getPattern()->size(); ++i)
     {
         const Clip *clip = track->getPattern()->getUnchecked(i);
+        this->patternMap[*clip] = makeUnique<SequenceMap>();
 
-        auto *sequenceMap = new SequenceMap();
-        this->patternMap[*clip] = UniquePointer<SequenceMap>(sequenceMap);
+        if (this->isActiveClip(*clip))
+        {
+            this->loadNoteComponents(*clip);
+        }
+    }
+}
 
-        for (int j = 0; j < track->getSequence()->size(); ++j)
+bool PianoRoll::isActiveClip(const Clip &clip) const noexcept
+{
+    return clip == this->activeClip && clip.getPattern() != nullptr &&
+        clip.getPattern()->getTrack() == this->activeTrack;
+}
+
+// Only the notes of the active clip are components, since they need
+// interaction; all other notes are painted by the roll, see paintInactiveNotes
+void PianoRoll::loadNoteComponents(const Clip &clip)
+{
+    if (clip.getPattern() == nullptr)
+    {
+        return;
+    }
+
+    const auto *track = clip.getPattern()->getTrack();
+    const int clipIndex = track->getPattern()->indexOfSorted(&clip);
+    if (clipIndex < 0 || !this->patternMap.contains(clip))
+    {
+        return;
+    }
+
+    // components need the clip owned by the pattern
+    const Clip *realClip = track->getPattern()->getUnchecked(clipIndex);
+    auto &sequenceMap = *this->patternMap[clip].get();
+    this->activeNotesIndex.clear();
+
+    HYBRID_ROLL_BULK_REPAINT_START
+
+    // switching to a large track shouldn't lay out all of its notes at once:
+    // the ones far from the viewport get their bounds as soon as they are
+    // scrolled towards, like after zooming, see updateOutdatedNoteBounds
+    const auto eagerArea = this->getEagerBoundsArea().toFloat();
+
+    for (int j = 0; j < track->getSequence()->size(); ++j)
+    {
+        const MidiEvent *event = track->getSequence()->getUnchecked(j);
+        if (event->isTypeOf(MidiEvent::Type::Note))
         {
-            const MidiEvent *event = track->getSequence()->getUnchecked(j);
-            if (event->isTypeOf(MidiEvent::Type::Note))
+            const Note *note = static_cast<const Note *>(event);
+            auto *nc = new NoteComponent(*this, *note, *realClip);
+            sequenceMap[*note] = UniquePointer<NoteComponent>(nc);
+            nc->setActive(true, true);
+            nc->setInterceptsMouseClicks(!this->isInDenseMode, !this->isInDenseMode);
+            this->addAndMakeVisible(nc);
+            this->indexActiveNote(*note);
+
+            const auto bounds = this->getEventBounds(nc);
+            if (bounds.intersects(eagerArea))
             {
-                const Note *note = static_cast<const Note *>(event);
-                auto *nc = new NoteComponent(*this, *note, *clip);
-                (*sequenceMap)[*note] = UniquePointer<NoteComponent>(nc);
-                const bool isActive = nc->belongsTo(this->activeTrack, this->activeClip);
-                nc->setActive(isActive, true);
-                this->addAndMakeVisible(nc);
-                nc->setFloatBounds(this->getEventBounds(nc));
+                nc->setFloatBounds(bounds);
+            }
+            else
+            {
+                this->notesWithOutdatedBounds.insert(*note);
             }
         }
     }
+
+    HYBRID_ROLL_BULK_REPAINT_END
+}
+
+void PianoRoll::unloadNoteComponents(const Clip &clip)
+{
+    if (this->patternMap.contains(clip))
+    {
+        this->patternMap[clip]->clear();
+    }
+
+    this->activeNotesIndex.clear();
+    this->notesWithOutdatedBounds.clear();
+}
+
+void PianoRoll::indexActiveNote(const Note &note)
+{
+    this->activeNotesIndex.set(note, note.getBeat(),
+        note.getBeat() + note.getLength(), note.getKey(), note.getKey());
+}
+
+void PianoRoll::findActiveNotesNear(const Rectangle<int> &area, Array<NoteComponent *> &result) const
+{
+    const auto found = this->patternMap.find(this->activeClip);
+    if (found == this->patternMap.end() || area.isEmpty())
+    {
+        return;
+    }
+
+    const auto &sequenceMap = *found->second.get();
+    const float startBeat = this->getBeatByXPosition(float(area.getX())) - this->activeClip.getBeat();
+    const float endBeat = this->getBeatByXPosition(float(area.getRight())) - this->activeClip.getBeat();
+    // one extra row on both sides, not to bother with rounding
+    const int startKey = (this->getHeight() - area.getBottom()) / this->rowHeight - this->activeClip.getKey() - 1;
+    const int endKey = (this->getHeight() - area.getY()) / this->rowHeight - this->activeClip.getKey() + 1;
+
+    this->activeNotesIndex.findItemsNear(startBeat, endBeat, startKey, endKey,
+        [&sequenceMap, &result](const Note &note)
+    {
+        const auto component = sequenceMap.find(note);
+        if (component != sequenceMap.end())
+        {
+            result.add(component->second.get());
+        }
+    });
+}
+
+void PianoRoll::findActiveNotesNear(float startBeat, float endBeat, Array<NoteComponent *> &result) const
+{
+    const auto found = this->patternMap.find(this->activeClip);
+    if (found == this->patternMap.end())
+    {
+        return;
+    }
+
+    const auto &sequenceMap = *found->second.get();
+    this->activeNotesIndex.findItemsNear(startBeat - this->activeClip.getBeat(),
+        endBeat - this->activeClip.getBeat(), 0, this->numRows,
+        [&sequenceMap, &result](const Note &note)
+    {
+        const auto component = sequenceMap.find(note);
+        if (component != sequenceMap.end())
+        {
+            result.add(component->second.get());
+        }
+    });
+}
+
+void PianoRoll::repaintInactiveNote(const Note &note, const Clip &clip)
+{
+    const auto bounds = this->getEventBounds(note.getKey() + clip.getKey(),
+        note.getBeat() + clip.getBeat(), note.getLength());
+
+    this->repaint(bounds.getSmallestIntegerContainer()
+        .expanded(1).getIntersection(this->viewport.getViewArea()));
+}
+
+void PianoRoll::paintInactiveNotes(Graphics &g) const
+{
+    const auto paintArea = g.getClipBounds().toFloat();
+    const float paintStartBeat = this->getBeatByXPosition(paintArea.getX());
+    const float paintEndBeat = this->getBeatByXPosition(paintArea.getRight());
+
+    for (const auto *track : this->project.getTracks())
+    {
+        const auto *sequence = dynamic_cast<const PianoSequence *>(track->getSequence());
+        if (sequence == nullptr || track->getPattern() == nullptr || sequence->isEmpty())
+        {
+            continue;
+        }
+
+        // all shapes of the same colour are filled at once
+        RectangleList<float> fill, lighter, darker;
+
+        for (int i = 0; i < track->getPattern()->size(); ++i)
+        {
+            const auto *clip = track->getPattern()->getUnchecked(i);
+            if (this->isActiveClip(*clip))
+            {
+                continue;
+            }
+
+            const auto &notes = sequence->getPackedNotes();
+            const auto candidates = notes.getCandidatesInRange(paintStartBeat - clip->getBeat(),
+                paintEndBeat - clip->getBeat());
+
+            for (int j = candidates.getStart(); j < candidates.getEnd(); ++j)
+            {
+                const auto bounds = this->getEventBounds(notes.keys.getUnchecked(j) + clip->getKey(),
+                    notes.beats.getUnchecked(j) + clip->getBeat(), notes.lengths.getUnchecked(j));
+
+                if (bounds.intersects(paintArea))
+                {
+                    NoteComponent::addInactiveShapes(bounds, notes.tuplets.getUnchecked(j), fill, lighter, darker);
+                }
+            }
+        }
+
+        if (!fill.isEmpty())
+        {
+            const auto colour = NoteComponent::getInactiveColour(track->getTrackColour());
+            g.setColour(colour);
+            g.fillRectList(fill);
+            g.setColour(colour.brighter(0.125f).withMultipliedAlpha(1.45f));
+            g.fillRectList(lighter);
+            g.setColour(colour.darker(0.175f).withMultipliedAlpha(1.45f));
+            g.fillRectList(darker);
+        }
+    }
+}
+
+const Clip *PianoRoll::findInactiveClipAt(const Point<float> &position) const
+{
+    const float beat = this->getBeatByXPosition(position.getX());
+
+    for (const auto *track : this->project.getTracks())
+    {
+        const auto *sequence = dynamic_cast<const PianoSequence *>(track->getSequence());
+        if (sequence == nullptr || track->getPattern() == nullptr)
+        {
+            continue;
+        }
+
+        for (int i = 0; i < track->getPattern()->size(); ++i)
+        {
+            const auto *clip = track->getPattern()->getUnchecked(i);
+            if (this->isActiveClip(*clip))
+            {
+                continue;
+            }
+
+            for (int j = 0; j < sequence->size(); ++j)
+            {
+                const auto *note = static_cast<const Note *>(sequence->getUnchecked(j));
+                if (note->getBeat() + clip->getBeat() > beat)
+                {
+                    break;
+                }
+
+                const auto bounds = this->getEventBounds(note->getKey() + clip->getKey(),
+                    note->getBeat() + clip->getBeat(), note->getLength());
+
+                if (bounds.contains(position))
+                {
+                    return clip;
+                }
+            }
+        }
+    }
+
+    return nullptr;
 }
 
 void PianoRoll::updateActiveRangeIndicator() const
@@ -220,14 +465,67 @@ void PianoRoll::selectAll()
 
 void PianoRoll::setChildrenInteraction(bool interceptsMouse, MouseCursor cursor)
 {
+    this->childrenInterceptMouse = interceptsMouse;
+    this->childrenCursor = cursor;
+
+    const bool componentsInterceptMouse = interceptsMouse && !this->isInDenseMode;
+
     forEachEventComponent(this->patternMap, e)
     {
         auto *childComponent = e.second.get();
-        childComponent->setInterceptsMouseClicks(interceptsMouse, interceptsMouse);
+        childComponent->setInterceptsMouseClicks(componentsInterceptMouse, componentsInterceptMouse);
         childComponent->setMouseCursor(cursor);
     }
 }
 
+//===----------------------------------------------------------------------===//
+// Dense mode
+//===----------------------------------------------------------------------===//
+
+// the 1/16 notes are narrower than a couple of pixels at this zoom level
+#define PIANOROLL_DENSE_MODE_MAX_BEAT_WIDTH (8.f)
+#define PIANOROLL_DENSE_MODE_HIT_RADIUS (4)
+
+void PianoRoll::updateDenseMode()
+{
+    const bool denseMode = this->beatWidth < PIANOROLL_DENSE_MODE_MAX_BEAT_WIDTH;
+    if (denseMode != this->isInDenseMode)
+    {
+        this->isInDenseMode = denseMode;
+        this->setChildrenInteraction(this->childrenInterceptMouse, this->childrenCursor);
+    }
+}
+
+// only a few notes are checked here, whatever the size of the track is,
+// since the index is only queried within the hit radius around the position
+NoteComponent *PianoRoll::findActiveNoteAt(const Point<float> &position) const
+{
+    Array<NoteComponent *> candidates;
+    const auto point = position.toInt();
+    this->findActiveNotesNear(Rectangle<int>(point, point)
+        .expanded(PIANOROLL_DENSE_MODE_HIT_RADIUS), candidates);
+
+    NoteComponent *nearest = nullptr;
+    float nearestDistance = float(PIANOROLL_DENSE_MODE_HIT_RADIUS);
+
+    for (auto *nc : candidates)
+    {
+        const auto bounds = this->getEventBounds(nc);
+        const auto distance = bounds.contains(position) ? 0.f :
+            bounds.getConstrainedPoint(position).getDistanceFrom(position);
+
+        // the overlapping selected notes win, since they are the ones being edited
+        if (distance < nearestDistance || (distance == nearestDistance &&
+            nc->isSelected() && (nearest == nullptr || !nearest->isSelected())))
+        {
+            nearest = nc;
+            nearestDistance = distance;
+        }
+    }
+
+    return nearest;
+}
+
 //===----------------------------------------------------------------------===//
 // Ghost notes
 //===----------------------------------------------------------------------===//
@@ -256,6 +554,36 @@ void PianoRoll::hideAllGhostNotes()
     this->ghostNotes.clear();
 }
 
+void PianoRoll::showPreviewNotes(const Array<Note> &notes, const Clip &clip)
+{
+    this->hidePreviewNotes();
+
+    this->previewNotes = notes;
+    this->previewNoteComponents.ensureStorageAllocated(this->previewNotes.size());
+
+    for (const auto &note : this->previewNotes)
+    {
+        auto *component = new NoteComponent(*this, note, clip, true);
+        component->setEnabled(false);
+        component->setFloatBounds(this->getEventBounds(component));
+
+        this->addAndMakeVisible(component);
+        this->previewNoteComponents.add(component);
+        this->triggerBatchRepaintFor(component);
+    }
+}
+
+void PianoRoll::hidePreviewNotes()
+{
+    for (auto *component : this->previewNoteComponents)
+    {
+        this->fader.fadeOut(component, 100);
+    }
+
+    this->previewNoteComponents.clear();
+    this->previewNotes.clearQuick();
+}
+
 //===----------------------------------------------------------------------===//
 // Input Listeners
 //===----------------------------------------------------------------------===//
@@ -274,6 +602,16 @@ void PianoRoll::longTapEvent(const Point<float> &position,
             this->project.setEditableScope(track, nc->getClip(), false);
             return;
         }
+
+        // inactive notes are just painted, so hit-test them here
+        if (nc == nullptr)
+        {
+            if (const auto *clip = this->findInactiveClipAt(position))
+            {
+                this->project.setEditableScope(clip->getPattern()->getTrack(), *clip, false);
+                return;
+            }
+        }
     }
 
     // else - start dragging lasso, if needed:
@@ -453,6 +791,13 @@ void PianoRoll::onChangeMidiEvent(const MidiEvent &oldEvent, const MidiEvent &ne
 
         forEachSequenceMapOfGivenTrack(this->patternMap, c, track)
         {
+            if (!this->isActiveClip(c.first))
+            {
+                this->repaintInactiveNote(note, c.first);
+                this->repaintInactiveNote(newNote, c.first);
+                continue;
+            }
+
             auto &sequenceMap = *c.second.get();
             if (auto *component = sequenceMap[note].release())
             {
@@ -463,6 +808,7 @@ void PianoRoll::onChangeMidiEvent(const MidiEvent &oldEvent, const MidiEvent &ne
                 jassert(!sequenceMap.contains(newNote));
                 // Always erase before updating, as it may happen both events have the same hash code:
                 sequenceMap[newNote] = UniquePointer<NoteComponent>(component);
+                this->indexActiveNote(newNote);
                 // Schedule to be repainted later:
                 this->triggerBatchRepaintFor(component);
             }
@@ -500,6 +846,12 @@ void PianoRoll::onAddMidiEvent(const MidiEvent &event)
 
         forEachSequenceMapOfGivenTrack(this->patternMap, c, track)
         {
+            if (!this->isActiveClip(c.first))
+            {
+                this->repaintInactiveNote(note, c.first);
+                continue;
+            }
+
             auto &sequenceMap = *c.second.get();
             const auto *targetParams = &c.first;
             const int i = track->getPattern()->indexOfSorted(targetParams);
@@ -508,6 +860,8 @@ void PianoRoll::onAddMidiEvent(const MidiEvent &event)
             const Clip *realClip = track->getPattern()->getUnchecked(i);
             auto *component = new NoteComponent(*this, note, *realClip);
             sequenceMap[note] = UniquePointer<NoteComponent>(component);
+            this->indexActiveNote(note);
+            component->setInterceptsMouseClicks(!this->isInDenseMode, !this->isInDenseMode);
             this->addAndMakeVisible(component);
 
             this->fader.fadeIn(component, 150);
@@ -516,18 +870,17 @@ void PianoRoll::onAddMidiEvent(const MidiEvent &event)
             // (needed not to break shift+drag note copying)
             const bool isCurrentlyDraggingNote = this->draggingHelper->isVisible();
 
-            const bool isActive = component->belongsTo(this->activeTrack, this->activeClip);
-            component->setActive(isActive, true);
+            component->setActive(true, true);
 
             this->triggerBatchRepaintFor(component);
 
-            // arpeggiators preview cannot work without that:
-            if (isActive && !isCurrentlyDraggingNote)
+            // keeps the results of the bulk edits, like arpeggiation, selected:
+            if (!isCurrentlyDraggingNote)
             {
                 this->selectEvent(component, false);
             }
 
-            if (this->addNewNoteMode && isActive)
+            if (this->addNewNoteMode)
             {
                 this->newNoteDragging = component;
                 this->addNewNoteMode = false;
@@ -558,12 +911,19 @@ void PianoRoll::onRemoveMidiEvent(const MidiEvent &event)
 
         forEachSequenceMapOfGivenTrack(this->patternMap, c, track)
         {
+            if (!this->isActiveClip(c.first))
+            {
+                this->repaintInactiveNote(note, c.first);
+                continue;
+            }
+
             auto &sequenceMap = *c.second.get();
             if (sequenceMap.contains(note))
             {
                 NoteComponent *deletedComponent = sequenceMap[note].get();
                 this->fader.fadeOut(deletedComponent, 150);
                 this->selection.deselect(deletedComponent);
+                this->activeNotesIndex.remove(note);
                 sequenceMap.erase(note);
             }
         }
@@ -578,42 +938,111 @@ void PianoRoll::onRemoveMidiEvent(const MidiEvent &event)
     HybridRoll::onRemoveMidiEvent(event);
 }
 
-void PianoRoll::onAddClip(const Clip &clip)
+void PianoRoll::onChangeMidiEvents(const Array<const MidiEvent *> &oldEvents,
+    const Array<const MidiEvent *> &newEvents)
 {
-    const SequenceMap *referenceMap = nullptr;
-    const auto *track = clip.getPattern()->getTrack();
+    jassert(oldEvents.size() == newEvents.size());
+    if (oldEvents.isEmpty() || !oldEvents.getFirst()->isTypeOf(MidiEvent::Type::Note))
+    {
+        HybridRoll::onChangeMidiEvents(oldEvents, newEvents);
+        return;
+    }
+
+    // all events in a group belong to the same sequence
+    const auto *track = newEvents.getFirst()->getSequence()->getTrack();
+    bool hasInactiveChanges = false;
 
     forEachSequenceMapOfGivenTrack(this->patternMap, c, track)
     {
-        // Found a sequence map for the same track
-        referenceMap = c.second.get();
-        break;
+        if (!this->isActiveClip(c.first))
+        {
+            hasInactiveChanges = true;
+            continue;
+        }
+
+        auto &sequenceMap = *c.second.get();
+
+        // release all components first, so that the new keys
+        // never collide with the old keys of the same group
+        Array<NoteComponent *> components;
+        components.ensureStorageAllocated(oldEvents.size());
+        for (const auto *oldEvent : oldEvents)
+        {
+            const auto &note = static_cast<const Note &>(*oldEvent);
+            auto *component = sequenceMap[note].release();
+            sequenceMap.erase(note);
+            components.add(component);
+        }
+
+        for (int i = 0; i < newEvents.size(); ++i)
+        {
+            if (auto *component = components.getUnchecked(i))
+            {
+                const auto &newNote = static_cast<const Note &>(*newEvents.getUnchecked(i));
+                jassert(!sequenceMap.contains(newNote));
+                sequenceMap[newNote] = UniquePointer<NoteComponent>(component);
+                this->indexActiveNote(newNote);
+                this->triggerBatchRepaintFor(component);
+            }
+        }
     }
 
-    if (referenceMap == nullptr)
+    if (hasInactiveChanges)
     {
-        jassertfalse;
+        this->repaint(this->viewport.getViewArea());
+    }
+
+    // see the comment in onChangeMidiEvent
+    this->noteNameGuides->syncWithSelection(&this->selection);
+}
+
+void PianoRoll::onRemoveMidiEvents(const Array<const MidiEvent *> &events)
+{
+    if (events.isEmpty() || !events.getFirst()->isTypeOf(MidiEvent::Type::Note))
+    {
+        HybridRoll::onRemoveMidiEvents(events);
         return;
     }
 
-    auto *sequenceMap = new SequenceMap();
-    this->patternMap[clip] = UniquePointer<SequenceMap>(sequenceMap);
+    this->hideDragHelpers();
+    this->hideAllGhostNotes(); // Avoids crash
+
+    const auto *track = events.getFirst()->getSequence()->getTrack();
 
-    for (const auto &e : *referenceMap)
+    forEachSequenceMapOfGivenTrack(this->patternMap, c, track)
     {
-        // reference the same note as neighbor components:
-        const auto &note = e.second.get()->getNote();
-        auto *component = new NoteComponent(*this, note, clip);
-        (*sequenceMap)[note] = UniquePointer<NoteComponent>(component);
-        this->addAndMakeVisible(component);
+        if (!this->isActiveClip(c.first))
+        {
+            this->repaint(this->viewport.getViewArea());
+            continue;
+        }
+
+        auto &sequenceMap = *c.second.get();
+        for (const auto *event : events)
+        {
+            const auto &note = static_cast<const Note &>(*event);
+            if (sequenceMap.contains(note))
+            {
+                NoteComponent *deletedComponent = sequenceMap[note].get();
+                this->fader.fadeOut(deletedComponent, 150);
+                this->selection.deselect(deletedComponent);
+                this->activeNotesIndex.remove(note);
+                sequenceMap.erase(note);
+            }
+        }
+    }
+}
 
-        const bool isActive = component->belongsTo(this->activeTrack, this->activeClip);
-        component->setActive(isActive);
+void PianoRoll::onAddClip(const Clip &clip)
+{
+    this->patternMap[clip] = makeUnique<SequenceMap>();
 
-        this->batchRepaintList.add(component);
+    if (this->isActiveClip(clip))
+    {
+        this->loadNoteComponents(clip);
     }
 
-    this->triggerAsyncUpdate();
+    this->repaint(this->viewport.getViewArea());
 }
 
 void PianoRoll::onChangeClip(const Clip &clip, const Clip &newClip)
@@ -632,16 +1061,17 @@ void PianoRoll::onChangeClip(const Clip &clip, const Clip &newClip)
         // And update all components within it, as their beats should change
         for (const auto &e : *sequenceMap)
         {
-            this->batchRepaintList.add(e.second.get());
+            this->triggerBatchRepaintFor(e.second.get());
         }
 
         if (newClip == this->activeClip)
         {
             this->updateActiveRangeIndicator();
         }
-
-        // Schedule batch repaint
-        this->triggerAsyncUpdate();
+        else
+        {
+            this->repaint(this->viewport.getViewArea());
+        }
     }
 }
 
@@ -654,6 +1084,13 @@ void PianoRoll::onRemoveClip(const Clip &clip)
         this->patternMap.erase(clip);
     }
 
+    if (this->isActiveClip(clip))
+    {
+        this->activeNotesIndex.clear();
+    }
+
+    this->repaint(this->viewport.getViewArea());
+
     HYBRID_ROLL_BULK_REPAINT_END
 }
 
@@ -720,11 +1157,17 @@ void PianoRoll::onRemoveTrack(MidiTrack *const track)
         }
     }
 
+    if (track == this->activeTrack)
+    {
+        this->activeNotesIndex.clear();
+    }
+
     this->repaint();
 }
 
 void PianoRoll::onReloadProjectContent(const Array<MidiTrack *> &tracks)
 {
+    WATCHDOG_SCOPE("PianoRoll::onReloadProjectContent");
     this->reloadRollContent();
 }
 
@@ -751,29 +1194,45 @@ void PianoRoll::onChangeViewEditableScope(MidiTrack *const newActiveTrack,
 
     this->selection.deselectAll();
 
+    const bool clipChanged = !this->isActiveClip(newActiveClip) ||
+        this->activeTrack != newActiveTrack;
+
+    if (clipChanged)
+    {
+        this->hideAllGhostNotes();
+        this->newNoteDragging = nullptr;
+        this->unloadNoteComponents(this->activeClip);
+    }
+
     this->activeTrack = newActiveTrack;
     this->activeClip = newActiveClip;
 
+    if (clipChanged)
+    {
+        this->loadNoteComponents(this->activeClip);
+    }
+
     int focusMinKey = INT_MAX;
     int focusMaxKey = 0;
     float focusMinBeat = FLT_MAX;
     float focusMaxBeat = -FLT_MAX;
     bool hasComponentsToFocusOn = false;
 
-    forEachEventComponent(this->patternMap, e)
-    {
-        auto *nc = e.second.get();
-        const bool isActive = nc->belongsTo(this->activeTrack, this->activeClip);
-        const auto key = nc->getKey() + this->activeClip.getKey();
-        nc->setActive(isActive, true);
+    // the focus area comes from the packed notes, which are sorted by beat,
+    // instead of visiting all the components just created for the clip
+    const auto *sequence = this->activeTrack != nullptr ?
+        dynamic_cast<const PianoSequence *>(this->activeTrack->getSequence()) : nullptr;
 
-        if (shouldFocus && isActive)
+    if (shouldFocus && sequence != nullptr && !sequence->isEmpty())
+    {
+        const auto &notes = sequence->getPackedNotes();
+        hasComponentsToFocusOn = true;
+        focusMinBeat = notes.beats.getFirst();
+        focusMaxBeat = notes.maxEndBeats.getLast();
+        for (const auto key : notes.keys)
         {
-            hasComponentsToFocusOn = true;
-            focusMinKey = jmin(focusMinKey, key);
-            focusMaxKey = jmax(focusMaxKey, key);
-            focusMinBeat = jmin(focusMinBeat, nc->getBeat());
-            focusMaxBeat = jmax(focusMaxBeat, nc->getBeat() + nc->getLength());
+            focusMinKey = jmin(focusMinKey, key + this->activeClip.getKey());
+            focusMaxKey = jmax(focusMaxKey, key + this->activeClip.getKey());
         }
     }
 
@@ -813,9 +1272,11 @@ void PianoRoll::selectEventsInRange(float startBeat, float endBeat, bool shouldC
         this->selection.deselectAll();
     }
 
-    forEachEventComponent(this->patternMap, e)
+    Array<NoteComponent *> candidates;
+    this->findActiveNotesNear(startBeat, endBeat, candidates);
+
+    for (auto *component : candidates)
     {
-        auto *component = e.second.get();
         if (component->isActive() &&
             (component->getNote().getBeat() + component->getClip().getBeat()) >= startBeat &&
             (component->getNote().getBeat() + component->getClip().getBeat()) < endBeat)
@@ -827,9 +1288,13 @@ void PianoRoll::selectEventsInRange(float startBeat, float endBeat, bool shouldC
 
 void PianoRoll::findLassoItemsInArea(Array<SelectableComponent *> &itemsFound, const Rectangle<int> &rectangle)
 {
-    forEachEventComponent(this->patternMap, e)
+    // only the notes highlighted by the previous lasso update need to be reset
+    Array<NoteComponent *> candidates;
+    this->findActiveNotesNear(this->lastLassoArea, candidates);
+    this->lastLassoArea = rectangle;
+
+    for (auto *component : candidates)
     {
-        auto *component = e.second.get();
         component->setSelected(false);
     }
 
@@ -837,10 +1302,12 @@ void PianoRoll::findLassoItemsInArea(Array<SelectableComponent *> &itemsFound, c
     {
         component->setSelected(true);
     }
-    
-    forEachEventComponent(this->patternMap, e)
+
+    candidates.clearQuick();
+    this->findActiveNotesNear(rectangle, candidates);
+
+    for (auto *component : candidates)
     {
-        auto *component = e.second.get();
         if (rectangle.intersects(component->getBounds()) && component->isActive())
         {
             component->setSelected(true);
@@ -864,17 +1331,54 @@ float PianoRoll::getLassoEndBeat() const
 // Component
 //===----------------------------------------------------------------------===//
 
+void PianoRoll::mouseMove(const MouseEvent &e)
+{
+    if (this->isInDenseMode && this->childrenInterceptMouse)
+    {
+        const bool isOverNote = this->findActiveNoteAt(e.position) != nullptr;
+        this->setMouseCursor(isOverNote ? this->childrenCursor :
+            this->project.getEditMode().getCursor());
+    }
+
+    HybridRoll::mouseMove(e);
+}
+
 void PianoRoll::mouseDown(const MouseEvent &e)
 {
     if (this->multiTouchController->hasMultitouch() || (e.source.getIndex() > 0))
     {
         return;
     }
+
+    // the same as the note component would have got this event
+    if (this->isInDenseMode && this->childrenInterceptMouse)
+    {
+        this->denseModeTarget = this->findActiveNoteAt(e.position);
+        if (this->denseModeTarget != nullptr)
+        {
+            this->denseModeTarget->mouseDown(e.getEventRelativeTo(this->denseModeTarget));
+            return;
+        }
+    }
     
     if (! this->isUsingSpaceDraggingMode())
     {
         this->setInterceptsMouseClicks(true, false);
 
+        if (e.mods.isAltDown() || e.mods.isRightButtonDown())
+        {
+            // same as clicking an inactive note component used to do
+            if (const auto *clip = this->findInactiveClipAt(e.position))
+            {
+                const bool zoomToScope = e.mods.isAnyModifierKeyDown();
+                this->project.setEditableScope(clip->getPattern()->getTrack(), *clip, zoomToScope);
+                if (zoomToScope)
+                {
+                    this->zoomOutImpulse(0.5f);
+                }
+            }
+        }
+
         if (this->isAddEvent(e))
         {
             this->insertNewNoteAt(e);
@@ -890,6 +1394,12 @@ void PianoRoll::mouseDown(const MouseEvent &e)
 
 void PianoRoll::mouseDoubleClick(const MouseEvent &e)
 {
+    if (this->denseModeTarget != nullptr)
+    {
+        this->denseModeTarget->mouseDoubleClick(e.getEventRelativeTo(this->denseModeTarget));
+        return;
+    }
+
     if (! this->project.getEditMode().forbidsAddingEvents())
     {
         const MouseEvent &e2(e.getEventRelativeTo(&App::Layout()));
@@ -905,6 +1415,12 @@ void PianoRoll::mouseDrag(const MouseEvent &e)
         return;
     }
 
+    if (this->denseModeTarget != nullptr)
+    {
+        this->denseModeTarget->mouseDrag(e.getEventRelativeTo(this->denseModeTarget));
+        return;
+    }
+
     if (this->newNoteDragging != nullptr)
     {
         if (this->newNoteDragging->isInEditMode())
@@ -932,6 +1448,13 @@ void PianoRoll::mouseUp(const MouseEvent &e)
     {
         return;
     }
+
+    if (this->denseModeTarget != nullptr)
+    {
+        this->denseModeTarget->mouseUp(e.getEventRelativeTo(this->denseModeTarget));
+        this->denseModeTarget = nullptr;
+        return;
+    }
     
     // Dismiss newNoteDragging, if needed
     if (this->newNoteDragging != nullptr)
@@ -968,6 +1491,23 @@ void PianoRoll::handleCommandMessage(int commandId)
         this->project.setEditableScope(this->activeTrack, this->activeClip, true);
         this->zoomOutImpulse(0.25f); // A bit of fancy animation
         break;
+    case CommandIDs::TransportStartRecording:
+        if (this->project.getMidiRecorder().isRecording())
+        {
+            this->project.getMidiRecorder().stopRecording();
+            this->project.getTransport().stopPlayback();
+        }
+        else if (this->activeTrack != nullptr)
+        {
+            this->project.getMidiRecorder().startRecording(this->activeTrack->getSequence(), this->activeClip);
+            if (!this->project.getTransport().isPlaying())
+            {
+                this->stopFollowingPlayhead();
+                this->project.getTransport().startPlayback(true);
+            }
+            this->startFollowingPlayhead();
+        }
+        break;
     case CommandIDs::RenameTrack:
         if (auto *trackNode = dynamic_cast<MidiTrackNode *>(this->project.findActiveNode()))
         {
@@ -1173,6 +1713,8 @@ void PianoRoll::handleCommandMessage(int commandId)
 
 void PianoRoll::resized()
 {
+    this->updateDenseMode();
+
     if (!this->isShowing())
     {
         return;
@@ -1180,10 +1722,30 @@ void PianoRoll::resized()
 
     HYBRID_ROLL_BULK_REPAINT_START
 
+    const auto eagerArea = this->getEagerBoundsArea();
+    const auto eagerAreaFloat = eagerArea.toFloat();
+
     forEachEventComponent(this->patternMap, e)
     {
         const auto component = e.second.get();
-        component->setFloatBounds(this->getEventBounds(component));
+        const auto bounds = this->getEventBounds(component);
+
+        // the selected notes may be dragged or measured right away,
+        // and the others are only moved if they are or will be seen:
+        if (component->isSelected() ||
+            bounds.intersects(eagerAreaFloat) ||
+            component->getBounds().intersects(eagerArea))
+        {
+            component->setFloatBounds(bounds);
+            if (!this->notesWithOutdatedBounds.empty())
+            {
+                this->notesWithOutdatedBounds.erase(component->getNote());
+            }
+        }
+        else
+        {
+            this->notesWithOutdatedBounds.insert(component->getNote());
+        }
     }
 
     for (const auto component : this->ghostNotes)
@@ -1191,6 +1753,11 @@ void PianoRoll::resized()
         component->setFloatBounds(this->getEventBounds(component));
     }
 
+    for (const auto component : this->previewNoteComponents)
+    {
+        component->setFloatBounds(this->getEventBounds(component));
+    }
+
     if (this->knifeToolHelper != nullptr)
     {
         this->knifeToolHelper->updateBounds();
@@ -1202,20 +1769,83 @@ void PianoRoll::resized()
     HYBRID_ROLL_BULK_REPAINT_END
 }
 
+void PianoRoll::moved()
+{
+    // the viewport scrolls by moving the roll
+    this->updateOutdatedNoteBounds();
+}
+
+Rectangle<int> PianoRoll::getEagerBoundsArea() const
+{
+    const auto viewArea = this->viewport.getViewArea();
+    return viewArea.expanded(viewArea.getWidth() / 2, viewArea.getHeight() / 2);
+}
+
+void PianoRoll::updateOutdatedNoteBounds()
+{
+    if (this->notesWithOutdatedBounds.empty())
+    {
+        return;
+    }
+
+    const auto found = this->patternMap.find(this->activeClip);
+    if (found == this->patternMap.end())
+    {
+        this->notesWithOutdatedBounds.clear();
+        return;
+    }
+
+    const auto &sequenceMap = *found->second.get();
+    const auto eagerArea = this->getEagerBoundsArea();
+    const auto eagerAreaFloat = eagerArea.toFloat();
+
+    for (auto it = this->notesWithOutdatedBounds.begin(); it != this->notesWithOutdatedBounds.end();)
+    {
+        const auto component = sequenceMap.find(*it);
+        if (component == sequenceMap.end())
+        {
+            it = this->notesWithOutdatedBounds.erase(it);
+            continue;
+        }
+
+        auto *nc = component->second.get();
+        const auto bounds = this->getEventBounds(nc);
+        if (bounds.intersects(eagerAreaFloat) || nc->getBounds().intersects(eagerArea))
+        {
+            nc->setFloatBounds(bounds);
+            it = this->notesWithOutdatedBounds.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
 void PianoRoll::paint(Graphics &g)
 {
+    UI_PROFILER_PAINT_SCOPE("PianoRoll", g);
+
     const auto *keysSequence = this->project.getTimeline()->getKeySignatures()->getSequence();
-    const int paintStartX = this->viewport.getViewPositionX();
-    const int paintEndX = paintStartX + this->viewport.getViewWidth();
+
+    // only fill the area being repainted, which is often way smaller than the viewport
+    const auto paintArea = this->viewport.getViewArea().getIntersection(g.getClipBounds());
+    const int paintStartX = paintArea.getX();
+    const int paintEndX = paintArea.getRight();
 
     static const float paintOffsetY = float(HYBRID_ROLL_HEADER_HEIGHT);
 
     int prevBeatX = paintStartX;
-    const HighlightingScheme *prevScheme = nullptr;
-    const int y = this->viewport.getViewPositionY();
-    const int h = this->viewport.getViewHeight();
+    HighlightingScheme *prevScheme = nullptr;
+    const int y = paintArea.getY();
+    const int h = paintArea.getHeight();
+
+    // skip the keys out of sight, except the last one before the visible area,
+    // which defines the highlighting of its left part
+    const float paintStartBeat = this->firstBeat + float(paintStartX) / this->beatWidth;
+    const int firstKeyIdx = jmax(0, keysSequence->indexOfFirstEventAtOrAfter(paintStartBeat) - 1);
 
-    for (int nextKeyIdx = 0; this->scalesHighlightingEnabled && nextKeyIdx < keysSequence->size(); ++nextKeyIdx)
+    for (int nextKeyIdx = firstKeyIdx; this->scalesHighlightingEnabled && nextKeyIdx < keysSequence->size(); ++nextKeyIdx)
     {
         const auto *key = static_cast<KeySignatureEvent *>(keysSequence->getUnchecked(nextKeyIdx));
         const int beatX = int((key->getBeat() - this->firstBeat)  * this->beatWidth);
@@ -1228,14 +1858,14 @@ void PianoRoll::paint(Graphics &g)
         }
 #endif
 
-        const auto *s = (prevScheme == nullptr) ? this->backgroundsCache.getUnchecked(index) : prevScheme;
-        const FillType fillType(s->getUnchecked(this->rowHeight), AffineTransform::translation(0.f, paintOffsetY));
-        g.setFillType(fillType);
+        auto *s = (prevScheme == nullptr) ? this->backgroundsCache.getUnchecked(index) : prevScheme;
+        g.setFillType(this->getBackgroundFill(*s, paintOffsetY));
 
         if (beatX >= paintEndX)
         {
             g.fillRect(prevBeatX, y, beatX - prevBeatX, h);
             HybridRoll::paint(g);
+            this->paintInactiveNotes(g);
             return;
         }
         else if (beatX >= paintStartX)
@@ -1249,11 +1879,11 @@ void PianoRoll::paint(Graphics &g)
 
     if (prevBeatX < paintEndX)
     {
-        const auto *s = (prevScheme == nullptr) ? this->defaultHighlighting.get() : prevScheme;
-        const FillType fillType(s->getUnchecked(this->rowHeight), AffineTransform::translation(0.f, paintOffsetY));
-        g.setFillType(fillType);
+        auto *s = (prevScheme == nullptr) ? this->defaultHighlighting.get() : prevScheme;
+        g.setFillType(this->getBackgroundFill(*s, paintOffsetY));
         g.fillRect(prevBeatX, y, paintEndX - prevBeatX, h);
         HybridRoll::paint(g);
+        this->paintInactiveNotes(g);
     }
 }
 
@@ -1339,14 +1969,16 @@ void PianoRoll::endCuttingEventsIfNeeded()
         this->knifeToolHelper->getCutPoints(notes, beats);
         Array<Note> cutEventsToTheRight = SequencerOperations::cutEvents(notes, beats);
         // Now select all the new notes:
-        forEachSequenceMapOfGivenTrack(this->patternMap, c, this->activeTrack)
+        const auto found = this->patternMap.find(this->activeClip);
+        if (found != this->patternMap.end())
         {
-            auto &sequenceMap = *c.second.get();
+            const auto &sequenceMap = *found->second.get();
             for (const auto &note : cutEventsToTheRight)
             {
-                if (auto *component = sequenceMap[note].get())
+                const auto component = sequenceMap.find(note);
+                if (component != sequenceMap.end())
                 {
-                    this->selectEvent(component, false);
+                    this->selectEvent(component->second.get(), false);
                 }
             }
         }
@@ -1452,6 +2084,8 @@ void PianoRoll::updateChildrenPositions()
         this->noteNameGuides->updatePosition();
     }
 
+    this->updateOutdatedNoteBounds();
+
     HybridRoll::updateChildrenPositions();
 }
 
@@ -1528,7 +2162,6 @@ void PianoRoll::updateBackgroundCacheFor(const KeySignatureEvent &key)
     if (duplicateSchemeIndex < 0)
     {
         UniquePointer<HighlightingScheme> scheme(new HighlightingScheme(key.getRootKey(), key.getScale()));
-        scheme->setRows(this->renderBackgroundCacheFor(scheme.get()));
         this->backgroundsCache.addSorted(*this->defaultHighlighting, scheme.release());
     }
 
@@ -1576,19 +2209,279 @@ void PianoRoll::removeBackgroundCacheFor(const KeySignatureEvent &key)
 #endif
 }
 
-Array<Image> PianoRoll::renderBackgroundCacheFor(const HighlightingScheme *const scheme) const
+/*
+    The tiles are only rendered on demand, for the schemes and the row height
+    which are actually painted, and any of them may be evicted by the memory budget;
+    they are keyed by the scheme contents, not by the key signature events,
+    so that any piano roll with the same scale and root key can reuse them.
+
+    Only the very first tile of each scheme is rendered right away; when the row
+    height changes, the nearest available tile of that scheme is stretched
+    for a few frames, while the exact one is being rendered in the background.
+*/
+
+struct PianoRoll::RowsPatternColours final
+{
+    explicit RowsPatternColours(const HelioTheme &theme) :
+        blackKey(theme.findColour(ColourIDs::Roll::blackKey)),
+        blackKeyAlt(theme.findColour(ColourIDs::Roll::blackKeyAlt)),
+        whiteKey(theme.findColour(ColourIDs::Roll::whiteKey)),
+        whiteKeyAlt(theme.findColour(ColourIDs::Roll::whiteKeyAlt)),
+        rowLine(theme.findColour(ColourIDs::Roll::rowLine)),
+        noise(theme.getBackgroundNoise()) {}
+
+    uint32 getHash() const noexcept
+    {
+        uint32 hash = 0;
+        for (const auto &c : { this->blackKey, this->blackKeyAlt,
+            this->whiteKey, this->whiteKeyAlt, this->rowLine })
+        {
+            hash = hash * 31 + c.getARGB();
+        }
+
+        return hash;
+    }
+
+    const Colour blackKey;
+    const Colour blackKeyAlt;
+    const Colour whiteKey;
+    const Colour whiteKeyAlt;
+    const Colour rowLine;
+    const Image noise;
+};
+
+class PianoRoll::BackgroundTiles final :
+    private MemoryBudget::Cache,
+    private Thread,
+    private AsyncUpdater
 {
-    Array<Image> result;
-    const auto &theme = HelioTheme::getCurrentTheme();
-    for (int j = 0; j < PIANOROLL_MIN_ROW_HEIGHT; ++j)
+public:
+
+    BackgroundTiles() : Thread("Piano roll backgrounds")
+    {
+        App::Memory().registerCache(this, MemoryBudget::Priority::High);
+        this->startThread(3);
+    }
+
+    ~BackgroundTiles() override
+    {
+        this->cancelPendingUpdate();
+        this->stopThread(1000);
+        App::Memory().unregisterCache(this);
+    }
+
+    // the rolls to repaint when the exact tiles are ready
+    void addClient(Component *roll) { this->clients.addIfNotAlreadyThere(roll); }
+    void removeClient(Component *roll) { this->clients.removeFirstMatchingValue(roll); }
+
+    // the tiles are rendered with the theme colours,
+    // so they are all dropped as soon as those change
+    void syncWithTheme(const HelioTheme &theme)
+    {
+        auto colours = makeUnique<RowsPatternColours>(theme);
+        if (this->colours == nullptr || colours->getHash() != this->colours->getHash())
+        {
+            this->tiles.clear();
+            this->requestedTiles.clear();
+            App::Memory().removeAllEntries(this);
+
+            const ScopedLock lock(this->jobsLock);
+            this->colours = std::move(colours);
+            this->pendingJobs.clear();
+            this->renderedJobs.clear();
+        }
+    }
+
+    // returns the tile and the row height it was rendered for,
+    // which may differ from the requested one until the exact tile is ready
+    Image getTile(const HighlightingScheme &scheme, int height, int &outTileRowHeight)
+    {
+        const auto key = getTileKey(scheme, height);
+        const auto found = this->tiles.find(key);
+        if (found != this->tiles.end())
+        {
+            App::Memory().touchEntry(this, key);
+            outTileRowHeight = height;
+            return found->second;
+        }
+
+        const auto schemeKey = getSchemeKey(key);
+        int64 nearestKey = 0;
+        int nearestDistance = std::numeric_limits<int>::max();
+        for (const auto &tile : this->tiles)
+        {
+            const auto distance = std::abs(getTileRowHeight(tile.first) - height);
+            if (getSchemeKey(tile.first) == schemeKey && distance < nearestDistance)
+            {
+                nearestKey = tile.first;
+                nearestDistance = distance;
+            }
+        }
+
+        if (nearestDistance == std::numeric_limits<int>::max())
+        {
+            // nothing to stretch yet, so this one can't wait
+            const auto tile = PianoRoll::renderRowsPattern(*this->colours,
+                scheme.getScale(), scheme.getRootKey(), height);
+
+            this->addTile(key, tile);
+            outTileRowHeight = height;
+            return tile;
+        }
+
+        // while zooming, only the latest row height of each scheme
+        // is queued, so the intermediate ones are never rendered
+        const auto requested = this->requestedTiles.find(schemeKey);
+        if (requested == this->requestedTiles.end() || requested->second != key)
+        {
+            this->requestedTiles[schemeKey] = key;
+
+            const ScopedLock lock(this->jobsLock);
+            this->pendingJobs[schemeKey] = { key, scheme.getScale(),
+                scheme.getRootKey(), height, this->colours->getHash() };
+            this->notify();
+        }
+
+        App::Memory().touchEntry(this, nearestKey);
+        outTileRowHeight = getTileRowHeight(nearestKey);
+        return this->tiles[nearestKey];
+    }
+
+private:
+
+    struct Job final
+    {
+        int64 key;
+        Scale::Ptr scale;
+        int root;
+        int height;
+        uint32 coloursHash;
+        Image tile;
+    };
+
+    void run() override
+    {
+        while (!this->threadShouldExit())
+        {
+            Job job;
+            UniquePointer<RowsPatternColours> colours;
+
+            {
+                const ScopedLock lock(this->jobsLock);
+                if (!this->pendingJobs.empty())
+                {
+                    job = this->pendingJobs.begin()->second;
+                    colours = makeUnique<RowsPatternColours>(*this->colours);
+                }
+            }
+
+            if (colours == nullptr)
+            {
+                this->wait(-1);
+                continue;
+            }
+
+            job.tile = PianoRoll::renderRowsPattern(*colours, job.scale, job.root, job.height);
+
+            {
+                const ScopedLock lock(this->jobsLock);
+                const auto pending = this->pendingJobs.find(getSchemeKey(job.key));
+                if (pending != this->pendingJobs.end() && pending->second.key == job.key)
+                {
+                    this->pendingJobs.erase(pending);
+                }
+
+                this->renderedJobs.add(job);
+            }
+
+            this->triggerAsyncUpdate();
+        }
+    }
+
+    void handleAsyncUpdate() override
+    {
+        Array<Job> jobs;
+
+        {
+            const ScopedLock lock(this->jobsLock);
+            jobs.swapWith(this->renderedJobs);
+        }
+
+        for (const auto &job : jobs)
+        {
+            if (job.coloursHash == this->colours->getHash())
+            {
+                this->addTile(job.key, job.tile);
+            }
+        }
+
+        for (auto *roll : this->clients)
+        {
+            roll->repaint();
+        }
+    }
+
+    void addTile(int64 key, const Image &tile)
+    {
+        this->tiles[key] = tile;
+        App::Memory().addEntry(this, key, MemoryBudget::getImageCost(tile));
+    }
+
+    String getCacheName() const override
     {
-        result.add({});
+        return "Piano roll backgrounds";
     }
-    for (int j = PIANOROLL_MIN_ROW_HEIGHT; j <= PIANOROLL_MAX_ROW_HEIGHT; ++j)
+
+    void evictCacheEntry(int64 entryId) override
+    {
+        this->tiles.erase(entryId);
+
+        // so that it is rendered again when needed
+        const auto requested = this->requestedTiles.find(getSchemeKey(entryId));
+        if (requested != this->requestedTiles.end() && requested->second == entryId)
+        {
+            this->requestedTiles.erase(requested);
+        }
+    }
+
+    // equivalent scales have the same hash code, see HighlightingScheme::compareElements
+    static int64 getTileKey(const HighlightingScheme &scheme, int height) noexcept
     {
-        result.add(PianoRoll::renderRowsPattern(theme, scheme->getScale(), scheme->getRootKey(), j));
+        return (int64(uint32(scheme.getScale()->hashCode())) << 32) |
+            (int64(scheme.getScale()->getBasePeriod() & 0xff) << 24) |
+            (int64(scheme.getRootKey() & 0xff) << 16) |
+            int64(height & 0xffff);
     }
-    return result;
+
+    static int64 getSchemeKey(int64 tileKey) noexcept { return tileKey >> 16; }
+    static int getTileRowHeight(int64 tileKey) noexcept { return int(tileKey & 0xffff); }
+
+    FlatHashMap<int64, Image> tiles;
+
+    // only replaced under the jobs lock, since the render thread copies it
+    UniquePointer<RowsPatternColours> colours;
+
+    // the last tile key queued for each scheme key
+    FlatHashMap<int64, int64> requestedTiles;
+
+    // the jobs are keyed by the scheme, so a newer row height replaces the older one
+    FlatHashMap<int64, Job> pendingJobs;
+    Array<Job> renderedJobs;
+    CriticalSection jobsLock;
+
+    Array<Component *> clients;
+
+    JUCE_DECLARE_NON_COPYABLE(BackgroundTiles)
+};
+
+FillType PianoRoll::getBackgroundFill(const HighlightingScheme &scheme, float offsetY)
+{
+    this->backgroundTiles->syncWithTheme(HelioTheme::getCurrentTheme());
+
+    int tileRowHeight = this->rowHeight;
+    const auto tile = this->backgroundTiles->getTile(scheme, this->rowHeight, tileRowHeight);
+    const auto stretch = float(this->rowHeight) / float(tileRowHeight);
+    return FillType(tile, AffineTransform::scale(1.f, stretch).translated(0.f, offsetY));
 }
 
 // pre-rendered tiles are used in paint() method to fill the background,
@@ -1599,22 +2492,29 @@ Array<Image> PianoRoll::renderBackgroundCacheFor(const HighlightingScheme *const
 
 Image PianoRoll::renderRowsPattern(const HelioTheme &theme,
     const Scale::Ptr scale, int root, int height)
+{
+    return PianoRoll::renderRowsPattern(RowsPatternColours(theme), scale, root, height);
+}
+
+// may be called from the background tiles thread, hence the software image type
+Image PianoRoll::renderRowsPattern(const RowsPatternColours &colours,
+    const Scale::Ptr scale, int root, int height)
 {
     if (height < PIANOROLL_MIN_ROW_HEIGHT)
     {
-        return Image(Image::RGB, 1, 1, true);
+        return Image(Image::RGB, 1, 1, true, SoftwareImageType());
     }
 
-    Image patternImage(Image::RGB, 4, height * NUM_ROWS_TO_RENDER, false);
+    Image patternImage(Image::RGB, 4, height * NUM_ROWS_TO_RENDER, false, SoftwareImageType());
     Graphics g(patternImage);
 
-    const Colour blackKey = theme.findColour(ColourIDs::Roll::blackKey);
-    const Colour blackKeyOdd = theme.findColour(ColourIDs::Roll::blackKeyAlt);
-    const Colour whiteKey = theme.findColour(ColourIDs::Roll::whiteKey);
-    const Colour whiteKeyOdd = theme.findColour(ColourIDs::Roll::whiteKeyAlt);
+    const Colour blackKey = colours.blackKey;
+    const Colour blackKeyOdd = colours.blackKeyAlt;
+    const Colour whiteKey = colours.whiteKey;
+    const Colour whiteKeyOdd = colours.whiteKeyAlt;
     const Colour rootKey = whiteKey.brighter(0.1f);
     const Colour rootKeyOdd = whiteKeyOdd.brighter(0.1f);
-    const Colour rowLine = theme.findColour(ColourIDs::Roll::rowLine);
+    const Colour rowLine = colours.rowLine;
 
     float currentHeight = float(height);
     float previousHeight = 0;
@@ -1667,7 +2567,7 @@ Image PianoRoll::renderRowsPattern(const HelioTheme &theme,
         posY -= currentHeight;
     }
 
-    HelioTheme::drawNoise(theme, g, 2.f);
+    HelioTheme::drawNoise(colours.noise, g, 2.f);
 
     return patternImage;
 }
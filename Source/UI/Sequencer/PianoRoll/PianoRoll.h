@@ -47,6 +47,8 @@ class Scale;
 #include "NoteResizerRight.h"
 #include "Note.h"
 #include "Clip.h"
+#include "SpatialIndex.h"
+#include "MemoryBudget.h"
 
 class PianoRoll final :
     public HybridRoll,
@@ -78,6 +80,11 @@ public:
     
     void showGhostNoteFor(NoteComponent *targetNoteComponent);
     void hideAllGhostNotes();
+
+    // the notes which don't exist in the sequence yet, e.g. the arpeggiation result,
+    // shown as ghosts over the clip, so that previewing them doesn't touch the undo stack
+    void showPreviewNotes(const Array<Note> &notes, const Clip &clip);
+    void hidePreviewNotes();
     
     //===------------------------------------------------------------------===//
     // Input Listeners
@@ -120,6 +127,12 @@ public:
     void onAddMidiEvent(const MidiEvent &event) override;
     void onRemoveMidiEvent(const MidiEvent &event) override;
 
+    // group edits re-key the components in one pass per sequence map
+    // and only sync the note guides and drag helpers once per group
+    void onChangeMidiEvents(const Array<const MidiEvent *> &oldEvents,
+        const Array<const MidiEvent *> &newEvents) override;
+    void onRemoveMidiEvents(const Array<const MidiEvent *> &events) override;
+
     void onAddClip(const Clip &clip) override;
     void onChangeClip(const Clip &oldClip, const Clip &newClip) override;
     void onRemoveClip(const Clip &clip) override;
@@ -157,12 +170,14 @@ public:
     // Component
     //===------------------------------------------------------------------===//
 
+    void mouseMove(const MouseEvent &e) override;
     void mouseDown(const MouseEvent &e) override;
     void mouseDoubleClick(const MouseEvent &e) override;
     void mouseUp(const MouseEvent &e) override;
     void mouseDrag(const MouseEvent &e) override;
     void handleCommandMessage(int commandId) override;
     void resized() override;
+    void moved() override;
     void paint(Graphics &g) override;
     
     //===------------------------------------------------------------------===//
@@ -198,10 +213,44 @@ private:
     void reloadRollContent();
     void loadTrack(const MidiTrack *const track);
 
+    // only the active clip's notes get components,
+    // the rest are painted by the roll itself:
+    bool isActiveClip(const Clip &clip) const noexcept;
+    void loadNoteComponents(const Clip &clip);
+    void unloadNoteComponents(const Clip &clip);
+    void repaintInactiveNote(const Note &note, const Clip &clip);
+    void paintInactiveNotes(Graphics &g) const;
+    const Clip *findInactiveClipAt(const Point<float> &position) const;
+
+    // the active clip's components in the given area, looked up in activeNotesIndex:
+    void findActiveNotesNear(const Rectangle<int> &area, Array<NoteComponent *> &result) const;
+    void findActiveNotesNear(float startBeat, float endBeat, Array<NoteComponent *> &result) const;
+    void indexActiveNote(const Note &note);
+
+    Rectangle<int> lastLassoArea;
+
+    // on zooming, only the components near the viewport get their bounds updated,
+    // and the rest are updated lazily, as soon as they are scrolled close enough:
+    FlatHashSet<Note, MidiEventHash> notesWithOutdatedBounds;
+    Rectangle<int> getEagerBoundsArea() const;
+    void updateOutdatedNoteBounds();
+
     void updateChildrenBounds() override;
     void updateChildrenPositions() override;
     void setChildrenInteraction(bool interceptsMouse, MouseCursor c) override;
 
+    // At the extreme zoom-out, the notes are too small and too many to be
+    // hit-tested as components, so they stop intercepting the mouse, and the roll
+    // picks the nearest one from activeNotesIndex and forwards the events to it
+    bool isInDenseMode = false;
+    void updateDenseMode();
+    NoteComponent *findActiveNoteAt(const Point<float> &position) const;
+    Component::SafePointer<NoteComponent> denseModeTarget;
+
+    // the edit mode's settings, which are restored when leaving the dense mode
+    bool childrenInterceptMouse = true;
+    MouseCursor childrenCursor;
+
     void insertNewNoteAt(const MouseEvent &e);
     int getYPositionByKey(int targetKey) const;
 
@@ -256,23 +305,30 @@ private:
 
         const Scale::Ptr getScale() const noexcept { return this->scale; }
         const int getRootKey() const noexcept { return this->rootKey; }
-        const Image getUnchecked(int i) const noexcept { return this->rows.getUnchecked(i); }
-        void setRows(Array<Image> val) noexcept { this->rows = val; }
 
     private:
         Scale::Ptr scale;
         int rootKey;
-        Array<Image> rows;
         JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(HighlightingScheme);
     };
 
     void updateBackgroundCacheFor(const KeySignatureEvent &key);
     void removeBackgroundCacheFor(const KeySignatureEvent &key);
-    Array<Image> renderBackgroundCacheFor(const HighlightingScheme *const scheme) const;
+    FillType getBackgroundFill(const HighlightingScheme &scheme, float offsetY);
     static Image renderRowsPattern(const HelioTheme &, const Scale::Ptr, int root, int height);
+
+    // a snapshot of the theme colours, so that the tiles can be rendered off the message thread
+    struct RowsPatternColours;
+    static Image renderRowsPattern(const RowsPatternColours &, const Scale::Ptr, int root, int height);
     OwnedArray<HighlightingScheme> backgroundsCache;
     UniquePointer<HighlightingScheme> defaultHighlighting;
     int binarySearchForHighlightingScheme(const KeySignatureEvent *const e) const noexcept;
+
+    // the rendered tiles are shared by the piano rolls of all open projects,
+    // since most of them use the same few scales and row heights anyway
+    class BackgroundTiles;
+    SharedResourcePointer<BackgroundTiles> backgroundTiles;
+
     friend class ThemeSettingsItem; // to be able to call renderRowsPattern
     
     bool scalesHighlightingEnabled = true;
@@ -285,6 +341,10 @@ private:
 private:
     
     OwnedArray<NoteComponent> ghostNotes;
+
+    // the components keep the references to these
+    Array<Note> previewNotes;
+    OwnedArray<NoteComponent> previewNoteComponents;
     UniquePointer<HelperRectangle> draggingHelper;
 
     UniquePointer<NoteResizerLeft> noteResizerLeft;
@@ -298,5 +358,10 @@ private:
     using PatternMap = FlatHashMap<Clip, UniquePointer<SequenceMap>, ClipHash>;
     PatternMap patternMap;
 
+    // the notes of the active clip, in the clip's local beats and keys
+    SpatialIndex<Note, MidiEventHash> activeNotesIndex;
+
+    UniquePointer<MemoryBudget::Account> memoryAccount;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PianoRoll);
 };
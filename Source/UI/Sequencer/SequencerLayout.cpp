@@ -45,6 +45,7 @@
 #include "ComponentIDs.h"
 #include "CommandIDs.h"
 #include "ColourIDs.h"
+#include "AnimationClock.h"
 
 #define MINIMUM_ROLLS_HEIGHT 250
 #define VERTICAL_ROLLS_LAYOUT 1
@@ -56,11 +57,11 @@
 // Rolls container responsible for switching between piano and pattern roll
 //===----------------------------------------------------------------------===//
 
-class RollsSwitchingProxy final : public Component, private MultiTimer
+class RollsSwitchingProxy final : public Component, private AnimationClock::Listener
 {
 public:
     
-    enum Timers
+    enum Animations
     {
         rolls = 0,
         maps = 1
@@ -93,9 +94,9 @@ public:
         this->patternRoll->setEnabled(false);
     }
 
-    inline bool canAnimate(Timers timer) const noexcept
+    inline bool canAnimate(Animations animation) const noexcept
     {
-        switch (timer)
+        switch (animation)
         {
         case RollsSwitchingProxy::rolls:
             return this->rollsAnimation.canRestart();
@@ -128,7 +129,8 @@ public:
         this->patternViewport->setVisible(true);
         this->pianoViewport->setVisible(true);
         this->resized();
-        this->startTimer(Timers::rolls, 1000 / 60);
+        this->isSwitchingRolls = true;
+        this->startAnimating();
     }
 
     void startMapSwitchAnimation()
@@ -141,7 +143,8 @@ public:
         this->levelsScroller->setVisible(true);
         this->pianoScroller->setVisible(true);
         this->resized();
-        this->startTimer(Timers::maps, 1000 / 60);
+        this->isSwitchingMaps = true;
+        this->startAnimating();
     }
 
     void resized() override
@@ -238,60 +241,77 @@ private:
         this->scrollerShadow->setTopLeftPosition(0, pianoMapY - levelsMapPos - SCROLLER_SHADOW_SIZE);
     }
 
-    void timerCallback(int timerId) override
+    // both switches can run at the same time, and share the frames
+    void onAnimationFrame() override
     {
-        switch (timerId)
+        if (this->isSwitchingRolls)
         {
-        case Timers::rolls:
-            if (this->rollsAnimation.tickAndCheckIfDone())
+            this->tickRollsAnimation();
+        }
+
+        if (this->isSwitchingMaps)
+        {
+            this->tickMapsAnimation();
+        }
+
+        if (!this->isSwitchingRolls && !this->isSwitchingMaps)
+        {
+            this->stopAnimating();
+        }
+    }
+
+    void tickRollsAnimation()
+    {
+        if (this->rollsAnimation.tickAndCheckIfDone())
+        {
+            this->isSwitchingRolls = false;
+
+            if (this->isPatternMode())
             {
-                this->stopTimer(Timers::rolls);
-
-                if (this->isPatternMode())
-                {
-                    this->pianoRoll->setVisible(false);
-                    this->pianoViewport->setVisible(false);
-                }
-                else
-                {
-                    this->patternRoll->setVisible(false);
-                    this->patternViewport->setVisible(false);
-                }
-
-                this->rollsAnimation.finish();
-                this->resized();
+                this->pianoRoll->setVisible(false);
+                this->pianoViewport->setVisible(false);
             }
             else
             {
-                this->updateAnimatedRollsPositions();
+                this->patternRoll->setVisible(false);
+                this->patternViewport->setVisible(false);
             }
-            break;
-        case Timers::maps:
-            if (this->mapsAnimation.tickAndCheckIfDone())
+
+            this->rollsAnimation.finish();
+            this->resized();
+        }
+        else
+        {
+            this->updateAnimatedRollsPositions();
+        }
+    }
+
+    void tickMapsAnimation()
+    {
+        if (this->mapsAnimation.tickAndCheckIfDone())
+        {
+            this->isSwitchingMaps = false;
+
+            if (this->isLevelsMapMode())
             {
-                this->stopTimer(Timers::maps);
-
-                if (this->isLevelsMapMode())
-                {
-                    this->pianoScroller->setVisible(false);
-                }
-                else
-                {
-                    this->levelsScroller->setVisible(false);
-                }
-
-                this->mapsAnimation.finish();
+                this->pianoScroller->setVisible(false);
             }
             else
             {
-                this->updateAnimatedMapsPositions();
+                this->levelsScroller->setVisible(false);
             }
-            break;
-        default:
-            break;
+
+            this->mapsAnimation.finish();
+        }
+        else
+        {
+            this->updateAnimatedMapsPositions();
         }
     }
 
+    bool isSwitchingRolls = false;
+    bool isSwitchingMaps = false;
+
     SafePointer<HybridRoll> pianoRoll;
     SafePointer<Viewport> pianoViewport;
 
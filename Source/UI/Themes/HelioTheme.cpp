@@ -39,6 +39,7 @@
 
 #include "BinaryData.h"
 #include "ColourScheme.h"
+#include "StartupProfiler.h"
 
 #if HELIO_DESKTOP
 #   define SCROLLBAR_WIDTH (17)
@@ -67,7 +68,12 @@ void HelioTheme::drawNoise(Component *target, Graphics &g, float alphaMultiply /
 
 void HelioTheme::drawNoise(const HelioTheme &theme, Graphics &g, float alphaMultiply /*= 1.f*/)
 {
-    g.setTiledImageFill(theme.getBackgroundNoise(), 0, 0, kNoiseAlpha * alphaMultiply);
+    HelioTheme::drawNoise(theme.getBackgroundNoise(), g, alphaMultiply);
+}
+
+void HelioTheme::drawNoise(const Image &noise, Graphics &g, float alphaMultiply /*= 1.f*/)
+{
+    g.setTiledImageFill(noise, 0, 0, kNoiseAlpha * alphaMultiply);
     g.fillRect(0, 0, g.getClipBounds().getWidth(), g.getClipBounds().getHeight());
 }
 
@@ -77,6 +83,21 @@ void HelioTheme::drawNoiseWithin(Rectangle<float> bounds, Graphics &g, float alp
     g.fillRect(bounds);
 }
 
+#define BACKGROUND_TILE_SIZE 64
+
+Image HelioTheme::renderBackgroundTile(const HelioTheme &theme,
+    const Colour &fill, float noiseAlphaMultiply /*= 1.f*/)
+{
+    Image tile(fill.isOpaque() ? Image::RGB : Image::ARGB,
+        BACKGROUND_TILE_SIZE, BACKGROUND_TILE_SIZE, true);
+
+    Graphics g(tile);
+    g.setColour(fill);
+    g.fillAll();
+    HelioTheme::drawNoise(theme, g, noiseAlphaMultiply);
+    return tile;
+}
+
 void HelioTheme::drawDashedRectangle(Graphics &g, const Rectangle<float> &r, const Colour &colour,
     float dashLength, float spaceLength, float dashThickness, float cornerRadius)
 {
@@ -691,7 +712,10 @@ void HelioTheme::positionDocumentWindowButtons(DocumentWindow &,
 
 void HelioTheme::initResources()
 {
-    Icons::initBuiltInImages();
+    {
+        STARTUP_PROFILER_SCOPE("Icons::initBuiltInImages");
+        Icons::initBuiltInImages();
+    }
 
 #if HELIO_DESKTOP
 
@@ -708,7 +732,11 @@ void HelioTheme::initResources()
 #endif
 
     Array<Font> systemFonts;
-    Font::findFonts(systemFonts);
+
+    {
+        STARTUP_PROFILER_SCOPE("Font::findFonts");
+        Font::findFonts(systemFonts);
+    }
 
     DBG("Fonts search done in " + String(Time::getMillisecondCounter() - startTime) + " ms");
 
@@ -39,7 +39,14 @@ public:
 
     static void drawNoise(Component *target, Graphics &g, float alphaMultiply = 1.f);
     static void drawNoise(const HelioTheme &theme, Graphics &g, float alphaMultiply = 1.f);
+    static void drawNoise(const Image &noise, Graphics &g, float alphaMultiply = 1.f);
     static void drawNoiseWithin(Rectangle<float> bounds, Graphics &g, float alphaMultiply = 1.f);
+
+    // the noise pre-blended with a fill colour, so that the panels
+    // can fill themselves with a plain tiled blit instead of blending
+    // the noise on every repaint; the opaque fills give the opaque tiles
+    static Image renderBackgroundTile(const HelioTheme &theme,
+        const Colour &fill, float noiseAlphaMultiply = 1.f);
     static void drawDashedRectangle(Graphics &g,
         const Rectangle<float> &rectangle, const Colour &colour,
         float dashLength = 5.f, float spaceLength = 7.5,
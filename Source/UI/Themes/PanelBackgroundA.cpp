@@ -103,14 +103,8 @@ void PanelBackgroundA::updateRender(HelioTheme &theme)
         return;
     }
 
-    const int w = 64;
-    const int h = 64;
-    Image render(Image::ARGB, w, h, true);
-    Graphics g(render);
-    g.setColour(theme.findColour(ColourIDs::BackgroundA::fill));
-    g.fillAll();
-    HelioTheme::drawNoise(theme, g, 0.5f);
-    theme.getBgCacheA() = render;
+    theme.getBgCacheA() = HelioTheme::renderBackgroundTile(theme,
+        theme.findColour(ColourIDs::BackgroundA::fill), 0.5f);
 }
 //[/MiscUserCode]
 
@@ -104,14 +104,8 @@ void PanelBackgroundB::updateRender(HelioTheme &theme)
         return;
     }
 
-    const int w = 64;
-    const int h = 64;
-    Image render(Image::ARGB, w, h, true);
-    Graphics g(render);
-    g.setColour(theme.findColour(ColourIDs::BackgroundB::fill));
-    g.fillAll();
-    HelioTheme::drawNoise(theme, g, 0.5f);
-    theme.getBgCacheB() = render;
+    theme.getBgCacheB() = HelioTheme::renderBackgroundTile(theme,
+        theme.findColour(ColourIDs::BackgroundB::fill), 0.5f);
 }
 
 //[/MiscUserCode]
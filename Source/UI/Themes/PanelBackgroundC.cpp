@@ -25,8 +25,6 @@
 #include "HelioTheme.h"
 #include "ColourIDs.h"
 #include "Icons.h"
-
-static void drawPanel(Graphics &g, HelioTheme &theme);
 //[/MiscUserDefs]
 
 PanelBackgroundC::PanelBackgroundC()
@@ -129,13 +127,6 @@ void PanelBackgroundC::resized()
 
 //[MiscUserCode]
 
-static void drawPanel(Graphics& g, HelioTheme &theme)
-{
-    g.setColour(theme.findColour(ColourIDs::BackgroundC::fill));
-    g.fillAll();
-    HelioTheme::drawNoise(theme, g);
-}
-
 void PanelBackgroundC::updateRender(HelioTheme &theme)
 {
     if (theme.getBgCacheC().isValid())
@@ -143,12 +134,8 @@ void PanelBackgroundC::updateRender(HelioTheme &theme)
         return;
     }
 
-    const int w = 64;
-    const int h = 64;
-    Image render(Image::ARGB, w, h, true);
-    Graphics g(render);
-    drawPanel(g, theme);
-    theme.getBgCacheC() = render;
+    theme.getBgCacheC() = HelioTheme::renderBackgroundTile(theme,
+        theme.findColour(ColourIDs::BackgroundC::fill));
 }
 
 //[/MiscUserCode]